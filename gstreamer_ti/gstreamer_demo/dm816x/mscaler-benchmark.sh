@@ -0,0 +1,50 @@
+#!/bin/sh
+#
+# Compare N omx_scaler instances against one N channel omx_mscaler.
+#
+# Each channel scales NUM_FRAMES 720p NV12 frames down to D1 YUY2. For both
+# pipelines the script prints the wall clock time, the throughput per channel
+# and the number of VFPC handles that were opened (OMX_GetHandle calls in the
+# omx debug log).
+#
+# usage: mscaler-benchmark.sh [channels] [frames]
+
+CHANNELS=${1:-8}
+NUM_FRAMES=${2:-300}
+
+SRC_CAPS="video/x-raw-yuv,format=(fourcc)NV12,width=1280,height=720,framerate=60/1"
+SINK_CAPS="video/x-raw-yuv,width=720,height=480"
+
+LOG=/tmp/mscaler-benchmark.log
+
+run()
+{
+    name=$1
+    shift
+
+    start=$(date +%s.%N)
+    GST_DEBUG=omx:5 gst-launch -q "$@" > /dev/null 2> $LOG
+    end=$(date +%s.%N)
+
+    handles=$(grep -c "OMX_GetHandle" $LOG)
+    echo "$name" | awk -v s=$start -v e=$end -v n=$NUM_FRAMES -v h=$handles \
+        '{ t = e - s; printf "%-10s time: %.2fs\tfps per channel: %.2f\thandles: %d\n", $1, t, n / t, h }'
+}
+
+###### N omx_scaler instances #############
+pipeline=""
+i=0
+while [ $i -lt $CHANNELS ]; do
+    pipeline="$pipeline videotestsrc num-buffers=$NUM_FRAMES ! $SRC_CAPS ! omx_scaler ! $SINK_CAPS ! queue ! fakesink sync=false"
+    i=$((i + 1))
+done
+run omx_scaler $pipeline
+
+###### one omx_mscaler with N channels #############
+pipeline="omx_mscaler name=s"
+i=0
+while [ $i -lt $CHANNELS ]; do
+    pipeline="$pipeline videotestsrc num-buffers=$NUM_FRAMES ! $SRC_CAPS ! s.sink_$i s.src_$i ! $SINK_CAPS ! queue ! fakesink sync=false"
+    i=$((i + 1))
+done
+run omx_mscaler $pipeline
@@ -21,3 +21,21 @@ gst-launch -v videomixer2 name=mix ! queue2 ! omx_ctrl ! queue2 ! omx_videosink
  ${src2} ! video/x-raw-yuv,width=320,height=240 ! queue2 ! videobox top=240 left=240 ! mix.
 
 
+
+###### Example 4 ############
+# Same as example 2, but both channels are scaled by a single VFPC handle
+src1="filesrc location=sample1_720p.264 ! typefind ! h264parse access-unit=true "
+src2="filesrc location=sample2_720p.264 ! typefind ! h264parse access-unit=true "
+gst-launch -v omx_mscaler name=s \
+ ${src1} ! queue2 ! omx_h264dec ! queue2 ! s.sink_0 s.src_0 ! fakesink silent=true \
+ ${src2} ! queue2 ! omx_h264dec ! queue2 ! s.sink_1 s.src_1 ! fakesink silent=true
+
+###### Example 5 ############
+# Same as example 3, but the scaling is done by one omx_mscaler and the
+# compositing by the display itself: each stream is a window of omx_mosaicsink,
+# placed on a grid unless the window pad's left/top properties are set
+src1="filesrc location=sample1_720p.264 ! typefind ! h264parse access-unit=true ! queue2 ! omx_h264dec ! queue2 "
+src2="filesrc location=sample2_720p.264 ! typefind ! h264parse access-unit=true ! queue2 ! omx_h264dec ! queue2 "
+gst-launch -v omx_mscaler name=s omx_mosaicsink name=mosaic \
+ ${src1} ! s.sink_0 s.src_0 ! video/x-raw-yuv,width=640,height=360 ! omx_ctrl display-mode=OMX_DC_MODE_1080P_60 ! queue2 ! mosaic.sink_0 \
+ ${src2} ! s.sink_1 s.src_1 ! video/x-raw-yuv,width=640,height=360 ! queue2 ! mosaic.sink_1
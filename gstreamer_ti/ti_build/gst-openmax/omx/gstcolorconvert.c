@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gstcolorconvert.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_color_convert_debug);
+#define GST_CAT_DEFAULT gst_color_convert_debug
+
+#define DEFAULT_SIMD TRUE
+
+#define FORMATS "{ NV12, I420, YUY2, UYVY }"
+
+enum
+{
+    PROP_0,
+    PROP_SIMD
+};
+
+static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV (FORMATS) ";"
+                     GST_VIDEO_CAPS_YUV_STRIDED (FORMATS, "[ 0, max ]"))
+    );
+
+static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV (FORMATS) ";"
+                     GST_VIDEO_CAPS_YUV_STRIDED (FORMATS, "[ 0, max ]"))
+    );
+
+static const guint32 fourccs[] = {
+    GST_MAKE_FOURCC ('N', 'V', '1', '2'),
+    GST_MAKE_FOURCC ('I', '4', '2', '0'),
+    GST_MAKE_FOURCC ('Y', 'U', 'Y', '2'),
+    GST_MAKE_FOURCC ('U', 'Y', 'V', 'Y'),
+};
+
+static GstBaseTransformClass *parent_class = NULL;
+
+static void gst_color_convert_base_init (gpointer g_class);
+static void gst_color_convert_class_init (GstColorConvertClass *klass);
+static void gst_color_convert_init (GstColorConvert *self, GstColorConvertClass *klass);
+
+GType
+gst_color_convert_get_type (void)
+{
+    static GType object_type = 0;
+
+    if (G_UNLIKELY (object_type == 0))
+    {
+        static const GTypeInfo object_info = {
+            sizeof (GstColorConvertClass),
+            gst_color_convert_base_init,
+            NULL,
+            (GClassInitFunc) gst_color_convert_class_init,
+            NULL,
+            NULL,
+            sizeof (GstColorConvert),
+            0,
+            (GInstanceInitFunc) gst_color_convert_init
+        };
+
+        object_type = g_type_register_static (GST_TYPE_BASE_TRANSFORM,
+            "GstColorConvert", &object_info, (GTypeFlags) 0);
+
+        GST_DEBUG_CATEGORY_INIT (gst_color_convert_debug, "colorconvert", 0,
+            "NV12/I420/YUY2/UYVY conversion");
+    }
+
+    return object_type;
+}
+
+static void
+gst_color_convert_base_init (gpointer gclass)
+{
+    static GstElementDetails element_details = {
+        "Colorspace converter",
+        "Filter/Converter/Video",
+        "Converts between NV12, I420, YUY2 and UYVY, with NEON where available",
+        "Texas Instruments"
+    };
+
+    GstElementClass *element_class = GST_ELEMENT_CLASS (gclass);
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&src_factory));
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&sink_factory));
+    gst_element_class_set_details (element_class, &element_details);
+}
+
+static const GstColorConvertKernels *
+select_kernels (gboolean simd)
+{
+    const GstColorConvertKernels *kernels = NULL;
+
+    if (simd)
+        kernels = gst_color_convert_kernels_neon ();
+
+    return kernels ? kernels : &gst_color_convert_kernels_c;
+}
+
+static void
+gst_color_convert_init (GstColorConvert *self,
+                        GstColorConvertClass *klass)
+{
+    self->simd = DEFAULT_SIMD;
+    self->kernels = select_kernels (self->simd);
+}
+
+/* Any of the formats, in either layout, the layout of the caps first so
+ * that unchanged caps are preferred.
+ */
+static GstCaps *
+gst_color_convert_transform_caps (GstBaseTransform *trans,
+                                  GstPadDirection direction,
+                                  GstCaps *caps)
+{
+    static const gchar *names[] = {
+        "video/x-raw-yuv", "video/x-raw-yuv-strided"
+    };
+    GstCaps *result;
+    GValue formats = { 0 };
+    guint i, j;
+
+    g_value_init (&formats, GST_TYPE_LIST);
+    for (i = 0; i < G_N_ELEMENTS (fourccs); i++)
+    {
+        GValue fourcc = { 0 };
+
+        g_value_init (&fourcc, GST_TYPE_FOURCC);
+        gst_value_set_fourcc (&fourcc, fourccs[i]);
+        gst_value_list_append_value (&formats, &fourcc);
+        g_value_unset (&fourcc);
+    }
+
+    result = gst_caps_new_empty ();
+
+    for (i = 0; i < gst_caps_get_size (caps); i++)
+    {
+        GstStructure *structure = gst_caps_get_structure (caps, i);
+
+        gst_caps_merge_structure (result, gst_structure_copy (structure));
+
+        for (j = 0; j < G_N_ELEMENTS (names); j++)
+        {
+            GstStructure *other = gst_structure_copy (structure);
+
+            gst_structure_set_name (other, names[j]);
+            gst_structure_set_value (other, "format", &formats);
+            gst_structure_remove_field (other, "rowstride");
+            gst_caps_merge_structure (result, other);
+        }
+    }
+
+    g_value_unset (&formats);
+
+    GST_LOG_OBJECT (trans, "%" GST_PTR_FORMAT " -> %" GST_PTR_FORMAT,
+                    caps, result);
+
+    return result;
+}
+
+static gboolean
+parse_caps (GstCaps *caps,
+            GstColorConvertFrame *frame)
+{
+    GstVideoFormat format;
+    gint width, height, rowstride = 0;
+
+    if (!gst_video_format_parse_caps_strided (caps, &format, &width, &height,
+                                              &rowstride))
+        return FALSE;
+
+    return gst_color_convert_frame_init (frame, format, width, height,
+                                         rowstride);
+}
+
+static gboolean
+gst_color_convert_get_unit_size (GstBaseTransform *trans,
+                                 GstCaps *caps,
+                                 guint *size)
+{
+    GstColorConvertFrame frame;
+
+    if (!parse_caps (caps, &frame))
+    {
+        GST_WARNING_OBJECT (trans, "unsupported caps %" GST_PTR_FORMAT, caps);
+        return FALSE;
+    }
+
+    *size = frame.size;
+
+    return TRUE;
+}
+
+static gboolean
+gst_color_convert_set_caps (GstBaseTransform *trans,
+                            GstCaps *incaps,
+                            GstCaps *outcaps)
+{
+    GstColorConvert *self = GST_COLOR_CONVERT (trans);
+    GstColorConvertFrame *in = &self->in_frame;
+    GstColorConvertFrame *out = &self->out_frame;
+
+    if (!parse_caps (incaps, in) || !parse_caps (outcaps, out))
+    {
+        GST_WARNING_OBJECT (self, "unsupported caps %" GST_PTR_FORMAT
+                            " -> %" GST_PTR_FORMAT, incaps, outcaps);
+        return FALSE;
+    }
+
+    if (in->width != out->width || in->height != out->height)
+    {
+        GST_WARNING_OBJECT (self, "cannot scale");
+        return FALSE;
+    }
+
+    /* the same bytes either way */
+    gst_base_transform_set_passthrough (trans, in->format == out->format &&
+            in->size == out->size &&
+            memcmp (in->stride, out->stride, sizeof (in->stride)) == 0);
+
+    GST_OBJECT_LOCK (self);
+    GST_INFO_OBJECT (self, "%dx%d %" GST_FOURCC_FORMAT " (stride %d) -> %"
+                     GST_FOURCC_FORMAT " (stride %d) with the %s kernels",
+                     in->width, in->height,
+                     GST_FOURCC_ARGS (gst_video_format_to_fourcc (in->format)),
+                     in->stride[0],
+                     GST_FOURCC_ARGS (gst_video_format_to_fourcc (out->format)),
+                     out->stride[0], self->kernels->name);
+    GST_OBJECT_UNLOCK (self);
+
+    return TRUE;
+}
+
+static GstFlowReturn
+gst_color_convert_transform (GstBaseTransform *trans,
+                             GstBuffer *inbuf,
+                             GstBuffer *outbuf)
+{
+    GstColorConvert *self = GST_COLOR_CONVERT (trans);
+    GstColorConvertFrame in = self->in_frame;
+    GstColorConvertFrame out = self->out_frame;
+    const GstColorConvertKernels *kernels;
+
+    if (G_UNLIKELY (GST_BUFFER_SIZE (inbuf) < in.size ||
+                    GST_BUFFER_SIZE (outbuf) < out.size))
+    {
+        GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+                           ("buffers of %u and %u bytes, expected %u and %u",
+                            GST_BUFFER_SIZE (inbuf), GST_BUFFER_SIZE (outbuf),
+                            in.size, out.size));
+        return GST_FLOW_ERROR;
+    }
+
+    gst_color_convert_frame_set_data (&in, GST_BUFFER_DATA (inbuf));
+    gst_color_convert_frame_set_data (&out, GST_BUFFER_DATA (outbuf));
+
+    /* "simd" may switch them meanwhile */
+    GST_OBJECT_LOCK (self);
+    kernels = self->kernels;
+    GST_OBJECT_UNLOCK (self);
+
+    gst_color_convert_frame (kernels, &out, &in);
+
+    return GST_FLOW_OK;
+}
+
+static void
+gst_color_convert_set_property (GObject *object,
+                                guint prop_id,
+                                const GValue *value,
+                                GParamSpec *pspec)
+{
+    GstColorConvert *self = GST_COLOR_CONVERT (object);
+
+    switch (prop_id)
+    {
+        case PROP_SIMD:
+            GST_OBJECT_LOCK (self);
+            self->simd = g_value_get_boolean (value);
+            self->kernels = select_kernels (self->simd);
+            GST_OBJECT_UNLOCK (self);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+gst_color_convert_get_property (GObject *object,
+                                guint prop_id,
+                                GValue *value,
+                                GParamSpec *pspec)
+{
+    GstColorConvert *self = GST_COLOR_CONVERT (object);
+
+    switch (prop_id)
+    {
+        case PROP_SIMD:
+            GST_OBJECT_LOCK (self);
+            g_value_set_boolean (value, self->simd);
+            GST_OBJECT_UNLOCK (self);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+gst_color_convert_class_init (GstColorConvertClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    GstBaseTransformClass *trans_class = GST_BASE_TRANSFORM_CLASS (klass);
+
+    parent_class = g_type_class_peek_parent (klass);
+
+    gobject_class->set_property = gst_color_convert_set_property;
+    gobject_class->get_property = gst_color_convert_get_property;
+
+    trans_class->transform_caps = GST_DEBUG_FUNCPTR (gst_color_convert_transform_caps);
+    trans_class->get_unit_size = GST_DEBUG_FUNCPTR (gst_color_convert_get_unit_size);
+    trans_class->set_caps = GST_DEBUG_FUNCPTR (gst_color_convert_set_caps);
+    trans_class->transform = GST_DEBUG_FUNCPTR (gst_color_convert_transform);
+
+    trans_class->passthrough_on_same_caps = TRUE;
+
+    g_object_class_install_property (gobject_class, PROP_SIMD,
+        g_param_spec_boolean ("simd", "SIMD",
+            "Convert with the NEON kernels when built for a CPU with NEON, "
+            "with the scalar ones otherwise", DEFAULT_SIMD, G_PARAM_READWRITE));
+}
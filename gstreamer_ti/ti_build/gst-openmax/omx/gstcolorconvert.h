@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GST_COLOR_CONVERT_H__
+#define __GST_COLOR_CONVERT_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "gstcolorconvert_kernels.h"
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_COLOR_CONVERT \
+  (gst_color_convert_get_type())
+#define GST_COLOR_CONVERT(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_COLOR_CONVERT,GstColorConvert))
+#define GST_COLOR_CONVERT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_COLOR_CONVERT,GstColorConvertClass))
+#define GST_IS_COLOR_CONVERT(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_COLOR_CONVERT))
+#define GST_IS_COLOR_CONVERT_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_COLOR_CONVERT))
+
+typedef struct _GstColorConvert      GstColorConvert;
+typedef struct _GstColorConvertClass GstColorConvertClass;
+
+/* Converts between NV12, I420, YUY2 and UYVY on the ARM, for the formats
+ * no VFPC path provides.
+ */
+struct _GstColorConvert
+{
+    GstBaseTransform element;
+
+    /* under the object lock, "simd" switches them while streaming */
+    gboolean simd;
+    const GstColorConvertKernels *kernels;
+
+    /* layouts from the caps, without data */
+    GstColorConvertFrame in_frame;
+    GstColorConvertFrame out_frame;
+};
+
+struct _GstColorConvertClass
+{
+    GstBaseTransformClass parent_class;
+};
+
+GType gst_color_convert_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_COLOR_CONVERT_H__ */
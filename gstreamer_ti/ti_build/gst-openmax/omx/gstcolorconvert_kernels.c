@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <string.h>
+
+#include "gstcolorconvert_kernels.h"
+
+/*
+ * Scalar kernels, the reference for the SIMD ones.
+ */
+
+static void
+interleave_uv_c (guint8 *uv,
+                 const guint8 *u,
+                 const guint8 *v,
+                 gint n)
+{
+    gint i;
+
+    for (i = 0; i < n; i++)
+    {
+        uv[2 * i] = u[i];
+        uv[2 * i + 1] = v[i];
+    }
+}
+
+static void
+deinterleave_uv_c (guint8 *u,
+                   guint8 *v,
+                   const guint8 *uv,
+                   gint n)
+{
+    gint i;
+
+    for (i = 0; i < n; i++)
+    {
+        u[i] = uv[2 * i];
+        v[i] = uv[2 * i + 1];
+    }
+}
+
+static void
+pack_422_c (guint8 *dst,
+            const guint8 *y,
+            const guint8 *u,
+            const guint8 *v,
+            gint n,
+            gboolean uyvy)
+{
+    gint i;
+
+    if (uyvy)
+    {
+        for (i = 0; i < n; i++)
+        {
+            dst[4 * i] = u[i];
+            dst[4 * i + 1] = y[2 * i];
+            dst[4 * i + 2] = v[i];
+            dst[4 * i + 3] = y[2 * i + 1];
+        }
+    }
+    else
+    {
+        for (i = 0; i < n; i++)
+        {
+            dst[4 * i] = y[2 * i];
+            dst[4 * i + 1] = u[i];
+            dst[4 * i + 2] = y[2 * i + 1];
+            dst[4 * i + 3] = v[i];
+        }
+    }
+}
+
+static void
+pack_422_nv_c (guint8 *dst,
+               const guint8 *y,
+               const guint8 *uv,
+               gint n,
+               gboolean uyvy)
+{
+    gint i;
+
+    if (uyvy)
+    {
+        for (i = 0; i < n; i++)
+        {
+            dst[4 * i] = uv[2 * i];
+            dst[4 * i + 1] = y[2 * i];
+            dst[4 * i + 2] = uv[2 * i + 1];
+            dst[4 * i + 3] = y[2 * i + 1];
+        }
+    }
+    else
+    {
+        for (i = 0; i < n; i++)
+        {
+            dst[4 * i] = y[2 * i];
+            dst[4 * i + 1] = uv[2 * i];
+            dst[4 * i + 2] = y[2 * i + 1];
+            dst[4 * i + 3] = uv[2 * i + 1];
+        }
+    }
+}
+
+/* byte offsets of Y0, U, Y1 and V in a pair of pixels */
+#define Y0(uyvy) ((uyvy) ? 1 : 0)
+#define U(uyvy)  ((uyvy) ? 0 : 1)
+#define Y1(uyvy) ((uyvy) ? 3 : 2)
+#define V(uyvy)  ((uyvy) ? 2 : 3)
+
+/* rounds like vrhadd of NEON */
+#define AVG(a, b) (((a) + (b) + 1) >> 1)
+
+static void
+unpack_422_c (guint8 *y0,
+              guint8 *y1,
+              guint8 *u,
+              guint8 *v,
+              const guint8 *src0,
+              const guint8 *src1,
+              gint n,
+              gboolean uyvy)
+{
+    gint i;
+
+    for (i = 0; i < n; i++)
+    {
+        const guint8 *p0 = src0 + 4 * i;
+        const guint8 *p1 = src1 + 4 * i;
+
+        y0[2 * i] = p0[Y0 (uyvy)];
+        y0[2 * i + 1] = p0[Y1 (uyvy)];
+        if (y1)
+        {
+            y1[2 * i] = p1[Y0 (uyvy)];
+            y1[2 * i + 1] = p1[Y1 (uyvy)];
+        }
+        u[i] = AVG (p0[U (uyvy)], p1[U (uyvy)]);
+        v[i] = AVG (p0[V (uyvy)], p1[V (uyvy)]);
+    }
+}
+
+static void
+unpack_422_nv_c (guint8 *y0,
+                 guint8 *y1,
+                 guint8 *uv,
+                 const guint8 *src0,
+                 const guint8 *src1,
+                 gint n,
+                 gboolean uyvy)
+{
+    gint i;
+
+    for (i = 0; i < n; i++)
+    {
+        const guint8 *p0 = src0 + 4 * i;
+        const guint8 *p1 = src1 + 4 * i;
+
+        y0[2 * i] = p0[Y0 (uyvy)];
+        y0[2 * i + 1] = p0[Y1 (uyvy)];
+        if (y1)
+        {
+            y1[2 * i] = p1[Y0 (uyvy)];
+            y1[2 * i + 1] = p1[Y1 (uyvy)];
+        }
+        uv[2 * i] = AVG (p0[U (uyvy)], p1[U (uyvy)]);
+        uv[2 * i + 1] = AVG (p0[V (uyvy)], p1[V (uyvy)]);
+    }
+}
+
+static void
+swap_422_c (guint8 *dst,
+            const guint8 *src,
+            gint n)
+{
+    gint i;
+
+    for (i = 0; i < 2 * n; i++)
+    {
+        guint8 tmp = src[2 * i];
+
+        dst[2 * i] = src[2 * i + 1];
+        dst[2 * i + 1] = tmp;
+    }
+}
+
+const GstColorConvertKernels gst_color_convert_kernels_c =
+{
+    "c",
+    interleave_uv_c,
+    deinterleave_uv_c,
+    pack_422_c,
+    pack_422_nv_c,
+    unpack_422_c,
+    unpack_422_nv_c,
+    swap_422_c,
+};
+
+/*
+ * Frames.
+ */
+
+/**
+ * Lays out a frame of the given format and size, as gst_video_format_get_*
+ * do, or for the strided caps of the OMX elements with rows of rowstride
+ * bytes (the chroma rows of I420 taking half of it) if rowstride is not 0.
+ * The pairs of pixels of 4:2:2 and 4:2:0 have to be complete, hence an
+ * even width.
+ */
+gboolean
+gst_color_convert_frame_init (GstColorConvertFrame *frame,
+                              GstVideoFormat format,
+                              gint width,
+                              gint height,
+                              gint rowstride)
+{
+    gint height2 = GST_ROUND_UP_2 (height);
+
+    if (width <= 0 || height <= 0 || width % 2)
+        return FALSE;
+
+    memset (frame, 0, sizeof (*frame));
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+
+    switch (format)
+    {
+        case GST_VIDEO_FORMAT_I420:
+            if (rowstride && rowstride < width)
+                return FALSE;
+            frame->stride[0] = rowstride ? rowstride : GST_ROUND_UP_4 (width);
+            frame->stride[1] = rowstride ? rowstride / 2 : GST_ROUND_UP_4 (width / 2);
+            frame->stride[2] = frame->stride[1];
+            frame->offset[1] = frame->stride[0] * height2;
+            frame->offset[2] = frame->offset[1] + frame->stride[1] * height2 / 2;
+            frame->size = frame->offset[2] + frame->stride[2] * height2 / 2;
+            break;
+        case GST_VIDEO_FORMAT_NV12:
+            if (rowstride && rowstride < width)
+                return FALSE;
+            frame->stride[0] = rowstride ? rowstride : GST_ROUND_UP_4 (width);
+            frame->stride[1] = frame->stride[0];
+            frame->offset[1] = frame->stride[0] * height2;
+            frame->size = frame->offset[1] + frame->stride[1] * height2 / 2;
+            break;
+        case GST_VIDEO_FORMAT_YUY2:
+        case GST_VIDEO_FORMAT_UYVY:
+            if (rowstride && rowstride < width * 2)
+                return FALSE;
+            frame->stride[0] = rowstride ? rowstride : GST_ROUND_UP_4 (width * 2);
+            frame->size = frame->stride[0] * height;
+            break;
+        default:
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Points the planes of the frame into data, of frame->size bytes */
+void
+gst_color_convert_frame_set_data (GstColorConvertFrame *frame,
+                                  guint8 *data)
+{
+    frame->data[0] = data + frame->offset[0];
+    frame->data[1] = frame->stride[1] ? data + frame->offset[1] : NULL;
+    frame->data[2] = frame->stride[2] ? data + frame->offset[2] : NULL;
+}
+
+#define ROW(frame, plane, row) \
+    ((frame)->data[plane] + (gsize) (row) * (frame)->stride[plane])
+
+static inline gboolean
+is_420 (GstVideoFormat format)
+{
+    return format == GST_VIDEO_FORMAT_I420 || format == GST_VIDEO_FORMAT_NV12;
+}
+
+static void
+copy_plane (GstColorConvertFrame *dst,
+            const GstColorConvertFrame *src,
+            gint plane,
+            gint bytes,
+            gint rows)
+{
+    gint i;
+
+    if (dst->stride[plane] == bytes && src->stride[plane] == bytes)
+    {
+        memcpy (dst->data[plane], src->data[plane], (gsize) bytes * rows);
+        return;
+    }
+
+    for (i = 0; i < rows; i++)
+        memcpy (ROW (dst, plane, i), ROW (src, plane, i), bytes);
+}
+
+/**
+ * Converts src into dst, of the same size.  4:2:0 chroma is repeated over
+ * both rows of 4:2:2, and 4:2:2 chroma is averaged over both rows for
+ * 4:2:0.
+ */
+void
+gst_color_convert_frame (const GstColorConvertKernels *k,
+                         GstColorConvertFrame *dst,
+                         const GstColorConvertFrame *src)
+{
+    gint width = src->width;
+    gint height = src->height;
+    gint n = width / 2;
+    gint i;
+
+    g_return_if_fail (dst->width == width && dst->height == height);
+
+    if (is_420 (src->format) && is_420 (dst->format))
+    {
+        gint rows = (height + 1) / 2;
+
+        copy_plane (dst, src, 0, width, height);
+
+        if (src->format == dst->format)
+        {
+            if (src->format == GST_VIDEO_FORMAT_NV12)
+            {
+                copy_plane (dst, src, 1, width, rows);
+            }
+            else
+            {
+                copy_plane (dst, src, 1, n, rows);
+                copy_plane (dst, src, 2, n, rows);
+            }
+        }
+        else if (dst->format == GST_VIDEO_FORMAT_NV12)
+        {
+            for (i = 0; i < rows; i++)
+                k->interleave_uv (ROW (dst, 1, i), ROW (src, 1, i),
+                                  ROW (src, 2, i), n);
+        }
+        else
+        {
+            for (i = 0; i < rows; i++)
+                k->deinterleave_uv (ROW (dst, 1, i), ROW (dst, 2, i),
+                                    ROW (src, 1, i), n);
+        }
+    }
+    else if (is_420 (src->format))
+    {
+        gboolean uyvy = dst->format == GST_VIDEO_FORMAT_UYVY;
+
+        for (i = 0; i < height; i++)
+        {
+            if (src->format == GST_VIDEO_FORMAT_NV12)
+                k->pack_422_nv (ROW (dst, 0, i), ROW (src, 0, i),
+                                ROW (src, 1, i / 2), n, uyvy);
+            else
+                k->pack_422 (ROW (dst, 0, i), ROW (src, 0, i),
+                             ROW (src, 1, i / 2), ROW (src, 2, i / 2), n, uyvy);
+        }
+    }
+    else if (is_420 (dst->format))
+    {
+        gboolean uyvy = src->format == GST_VIDEO_FORMAT_UYVY;
+
+        for (i = 0; i < height; i += 2)
+        {
+            gboolean last = i + 1 == height;
+            const guint8 *src1 = ROW (src, 0, last ? i : i + 1);
+            guint8 *y1 = last ? NULL : ROW (dst, 0, i + 1);
+
+            if (dst->format == GST_VIDEO_FORMAT_NV12)
+                k->unpack_422_nv (ROW (dst, 0, i), y1, ROW (dst, 1, i / 2),
+                                  ROW (src, 0, i), src1, n, uyvy);
+            else
+                k->unpack_422 (ROW (dst, 0, i), y1, ROW (dst, 1, i / 2),
+                               ROW (dst, 2, i / 2), ROW (src, 0, i), src1, n,
+                               uyvy);
+        }
+    }
+    else if (src->format == dst->format)
+    {
+        copy_plane (dst, src, 0, width * 2, height);
+    }
+    else
+    {
+        for (i = 0; i < height; i++)
+            k->swap_422 (ROW (dst, 0, i), ROW (src, 0, i), n);
+    }
+}
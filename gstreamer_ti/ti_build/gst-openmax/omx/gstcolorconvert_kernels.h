@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef __GST_COLOR_CONVERT_KERNELS_H__
+#define __GST_COLOR_CONVERT_KERNELS_H__
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstColorConvertKernels GstColorConvertKernels;
+typedef struct _GstColorConvertFrame GstColorConvertFrame;
+
+/* Row kernels between NV12, I420, YUY2 and UYVY.  n counts chroma samples,
+ * ie. pairs of pixels, and the 4:2:2 layout is UYVY when uyvy is set and
+ * YUY2 otherwise.  4:2:2 to 4:2:0 takes two rows at a time and averages
+ * their chroma, y1 is NULL for the last row of an odd height.
+ */
+struct _GstColorConvertKernels
+{
+    const gchar *name;
+
+    void (*interleave_uv) (guint8 *uv, const guint8 *u, const guint8 *v, gint n);
+    void (*deinterleave_uv) (guint8 *u, guint8 *v, const guint8 *uv, gint n);
+
+    void (*pack_422) (guint8 *dst, const guint8 *y, const guint8 *u,
+                      const guint8 *v, gint n, gboolean uyvy);
+    void (*pack_422_nv) (guint8 *dst, const guint8 *y, const guint8 *uv,
+                         gint n, gboolean uyvy);
+
+    void (*unpack_422) (guint8 *y0, guint8 *y1, guint8 *u, guint8 *v,
+                        const guint8 *src0, const guint8 *src1, gint n,
+                        gboolean uyvy);
+    void (*unpack_422_nv) (guint8 *y0, guint8 *y1, guint8 *uv,
+                           const guint8 *src0, const guint8 *src1, gint n,
+                           gboolean uyvy);
+
+    void (*swap_422) (guint8 *dst, const guint8 *src, gint n);
+};
+
+/* A picture in one of the formats above: planes of the Y, U and V (or
+ * interleaved UV) components for the planar formats, one plane otherwise.
+ */
+struct _GstColorConvertFrame
+{
+    GstVideoFormat format;
+    gint width;
+    gint height;
+    gint stride[3];
+    gint offset[3];
+    guint size;
+    guint8 *data[3];
+};
+
+extern const GstColorConvertKernels gst_color_convert_kernels_c;
+
+/* NULL unless built for a CPU with NEON */
+const GstColorConvertKernels *gst_color_convert_kernels_neon (void);
+
+gboolean gst_color_convert_frame_init (GstColorConvertFrame *frame,
+                                       GstVideoFormat format,
+                                       gint width,
+                                       gint height,
+                                       gint rowstride);
+void gst_color_convert_frame_set_data (GstColorConvertFrame *frame,
+                                       guint8 *data);
+void gst_color_convert_frame (const GstColorConvertKernels *kernels,
+                              GstColorConvertFrame *dst,
+                              const GstColorConvertFrame *src);
+
+G_END_DECLS
+
+#endif /* __GST_COLOR_CONVERT_KERNELS_H__ */
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "gstcolorconvert_kernels.h"
+
+#if defined (__ARM_NEON__) || defined (__ARM_NEON)
+
+#include <arm_neon.h>
+
+/*
+ * NEON kernels: 16 chroma samples at a time through the structure
+ * loads and stores (vld2/vst2 and vld4/vst4 interleave for free), the
+ * remainder of the row by the scalar kernels.
+ */
+
+#define C (&gst_color_convert_kernels_c)
+
+static void
+interleave_uv_neon (guint8 *uv,
+                    const guint8 *u,
+                    const guint8 *v,
+                    gint n)
+{
+    gint i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        uint8x16x2_t t;
+
+        t.val[0] = vld1q_u8 (u + i);
+        t.val[1] = vld1q_u8 (v + i);
+        vst2q_u8 (uv + 2 * i, t);
+    }
+
+    C->interleave_uv (uv + 2 * i, u + i, v + i, n - i);
+}
+
+static void
+deinterleave_uv_neon (guint8 *u,
+                      guint8 *v,
+                      const guint8 *uv,
+                      gint n)
+{
+    gint i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        uint8x16x2_t t = vld2q_u8 (uv + 2 * i);
+
+        vst1q_u8 (u + i, t.val[0]);
+        vst1q_u8 (v + i, t.val[1]);
+    }
+
+    C->deinterleave_uv (u + i, v + i, uv + 2 * i, n - i);
+}
+
+static inline void
+store_422 (guint8 *dst,
+           uint8x16x2_t y,
+           uint8x16_t u,
+           uint8x16_t v,
+           gboolean uyvy)
+{
+    uint8x16x4_t t;
+
+    if (uyvy)
+    {
+        t.val[0] = u;
+        t.val[1] = y.val[0];
+        t.val[2] = v;
+        t.val[3] = y.val[1];
+    }
+    else
+    {
+        t.val[0] = y.val[0];
+        t.val[1] = u;
+        t.val[2] = y.val[1];
+        t.val[3] = v;
+    }
+
+    vst4q_u8 (dst, t);
+}
+
+static void
+pack_422_neon (guint8 *dst,
+               const guint8 *y,
+               const guint8 *u,
+               const guint8 *v,
+               gint n,
+               gboolean uyvy)
+{
+    gint i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+        store_422 (dst + 4 * i, vld2q_u8 (y + 2 * i), vld1q_u8 (u + i),
+                   vld1q_u8 (v + i), uyvy);
+
+    C->pack_422 (dst + 4 * i, y + 2 * i, u + i, v + i, n - i, uyvy);
+}
+
+static void
+pack_422_nv_neon (guint8 *dst,
+                  const guint8 *y,
+                  const guint8 *uv,
+                  gint n,
+                  gboolean uyvy)
+{
+    gint i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        uint8x16x2_t c = vld2q_u8 (uv + 2 * i);
+
+        store_422 (dst + 4 * i, vld2q_u8 (y + 2 * i), c.val[0], c.val[1], uyvy);
+    }
+
+    C->pack_422_nv (dst + 4 * i, y + 2 * i, uv + 2 * i, n - i, uyvy);
+}
+
+/* Y0, U, Y1 and V of 16 pairs of pixels */
+static inline uint8x16x4_t
+load_422 (const guint8 *src,
+          gboolean uyvy)
+{
+    uint8x16x4_t t = vld4q_u8 (src);
+
+    if (uyvy)
+    {
+        uint8x16_t u = t.val[0], v = t.val[2];
+
+        t.val[0] = t.val[1];
+        t.val[1] = u;
+        t.val[2] = t.val[3];
+        t.val[3] = v;
+    }
+
+    return t;
+}
+
+static inline void
+store_y (guint8 *dst,
+         uint8x16x4_t p)
+{
+    uint8x16x2_t y;
+
+    y.val[0] = p.val[0];
+    y.val[1] = p.val[2];
+    vst2q_u8 (dst, y);
+}
+
+static void
+unpack_422_neon (guint8 *y0,
+                 guint8 *y1,
+                 guint8 *u,
+                 guint8 *v,
+                 const guint8 *src0,
+                 const guint8 *src1,
+                 gint n,
+                 gboolean uyvy)
+{
+    gint i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        uint8x16x4_t p0 = load_422 (src0 + 4 * i, uyvy);
+        uint8x16x4_t p1 = load_422 (src1 + 4 * i, uyvy);
+
+        store_y (y0 + 2 * i, p0);
+        if (y1)
+            store_y (y1 + 2 * i, p1);
+        vst1q_u8 (u + i, vrhaddq_u8 (p0.val[1], p1.val[1]));
+        vst1q_u8 (v + i, vrhaddq_u8 (p0.val[3], p1.val[3]));
+    }
+
+    C->unpack_422 (y0 + 2 * i, y1 ? y1 + 2 * i : NULL, u + i, v + i,
+                   src0 + 4 * i, src1 + 4 * i, n - i, uyvy);
+}
+
+static void
+unpack_422_nv_neon (guint8 *y0,
+                    guint8 *y1,
+                    guint8 *uv,
+                    const guint8 *src0,
+                    const guint8 *src1,
+                    gint n,
+                    gboolean uyvy)
+{
+    gint i;
+
+    for (i = 0; i + 16 <= n; i += 16)
+    {
+        uint8x16x4_t p0 = load_422 (src0 + 4 * i, uyvy);
+        uint8x16x4_t p1 = load_422 (src1 + 4 * i, uyvy);
+        uint8x16x2_t c;
+
+        store_y (y0 + 2 * i, p0);
+        if (y1)
+            store_y (y1 + 2 * i, p1);
+        c.val[0] = vrhaddq_u8 (p0.val[1], p1.val[1]);
+        c.val[1] = vrhaddq_u8 (p0.val[3], p1.val[3]);
+        vst2q_u8 (uv + 2 * i, c);
+    }
+
+    C->unpack_422_nv (y0 + 2 * i, y1 ? y1 + 2 * i : NULL, uv + 2 * i,
+                      src0 + 4 * i, src1 + 4 * i, n - i, uyvy);
+}
+
+static void
+swap_422_neon (guint8 *dst,
+               const guint8 *src,
+               gint n)
+{
+    gint i;
+
+    for (i = 0; i + 8 <= n; i += 8)
+    {
+        vst1q_u8 (dst + 4 * i, vrev16q_u8 (vld1q_u8 (src + 4 * i)));
+        vst1q_u8 (dst + 4 * i + 16, vrev16q_u8 (vld1q_u8 (src + 4 * i + 16)));
+    }
+
+    C->swap_422 (dst + 4 * i, src + 4 * i, n - i);
+}
+
+static const GstColorConvertKernels kernels_neon =
+{
+    "neon",
+    interleave_uv_neon,
+    deinterleave_uv_neon,
+    pack_422_neon,
+    pack_422_nv_neon,
+    unpack_422_neon,
+    unpack_422_nv_neon,
+    swap_422_neon,
+};
+
+const GstColorConvertKernels *
+gst_color_convert_kernels_neon (void)
+{
+    return &kernels_neon;
+}
+
+#else
+
+const GstColorConvertKernels *
+gst_color_convert_kernels_neon (void)
+{
+    return NULL;
+}
+
+#endif
@@ -50,11 +50,14 @@
 #include "gstomx_jpegdec.h"
 #include "gstomx_audiosink.h"
 #include "gstomx_videosink.h"
+#include "gstomx_mosaicsink.h"
 #include "gstomx_filereadersrc.h"
 #include "gstomx_volume.h"
 #include "gstomx_camera.h"
 #include "gstperf.h"
+#include "gstcolorconvert.h"
 #include "gstomx_scaler.h"
+#include "gstomx_mscaler.h"
 #include "gstomx_noisefilter.h"
 #include "gstomx_base_ctrl.h"
 #include "gstomx_tvp.h"
@@ -107,10 +110,13 @@ static TableItem element_table[] =
 //    { "omx_jpegdec",        "libOMX_Core.so",           "OMX.TI.DUCATI1.IMAGE.JPEGD",   NULL,                   GST_RANK_NONE,   gst_omx_jpegdec_get_type },
 //    { "omx_audiosink",      "libomxil-bellagio.so.0",   "OMX.st.alsa.alsasink",         NULL,                   GST_RANK_NONE,      gst_omx_audiosink_get_type },
     { "omx_videosink",      "libOMX_Core.so",   "OMX.TI.VPSSM3.VFDC",             NULL,              GST_RANK_PRIMARY,      gst_omx_videosink_get_type },
+    { "omx_mosaicsink",     "libOMX_Core.so",   "OMX.TI.VPSSM3.VFDC",             NULL,              GST_RANK_NONE,      gst_omx_mosaicsink_get_type },
 //    { "omx_filereadersrc",  "libomxil-bellagio.so.0",   "OMX.st.audio_filereader",      NULL,                   GST_RANK_NONE,      gst_omx_filereadersrc_get_type },
 //    { "omx_volume",         "libomxil-bellagio.so.0",   "OMX.st.volume.component",      NULL,                   GST_RANK_NONE,      gst_omx_volume_get_type },
     { "gstperf",         "libOMX_Core.so",   NULL,      NULL,                   GST_RANK_PRIMARY,      gst_perf_get_type },
+    { "gstcolorconvert", "libOMX_Core.so",   NULL,      NULL,                   GST_RANK_NONE,         gst_color_convert_get_type },
     { "omx_scaler",         "libOMX_Core.so",   "OMX.TI.VPSSM3.VFPC.INDTXSCWB",     "",                   GST_RANK_PRIMARY,      gst_omx_scaler_get_type },
+    { "omx_mscaler",         "libOMX_Core.so",   "OMX.TI.VPSSM3.VFPC.INDTXSCWB",     "",                   GST_RANK_NONE,      gst_omx_mscaler_get_type },
     { "omx_noisefilter",         "libOMX_Core.so",   "OMX.TI.VPSSM3.VFPC.NF",     "",                   GST_RANK_PRIMARY,      gst_omx_noisefilter_get_type },
     { "omx_ctrl",         "libOMX_Core.so",   "OMX.TI.VPSSM3.CTRL.DC",     "",                   GST_RANK_PRIMARY,      gst_omx_base_ctrl_get_type },
     { "omx_tvp",          "libOMX_Core.so",   "OMX.TI.VPSSM3.CTRL.TVP",     "",                  GST_RANK_PRIMARY,      gst_omx_tvp_get_type },
@@ -36,8 +36,18 @@ enum
     ARG_USE_TIMESTAMPS,
     ARG_NUM_INPUT_BUFFERS,
     ARG_NUM_OUTPUT_BUFFERS,
+    ARG_EOS_TIMEOUT,
+    ARG_STATE_TIMEOUT,
+    ARG_ASYNC_STATE_CHANGE,
+    ARG_HANDLE_POOL,
+    ARG_HANDLE_POOL_TIMEOUT,
+    ARG_HANDLE_POOL_PREWARM,
+    ARG_INPUT_MEMORY,
+    ARG_OUTPUT_MEMORY,
 };
 
+#define DEFAULT_EOS_TIMEOUT 1000
+
 static void init_interfaces (GType type);
 GSTOMX_BOILERPLATE_FULL (GstOmxBaseFilter, gst_omx_base_filter, GstElement, GST_TYPE_ELEMENT, init_interfaces);
 
@@ -131,6 +141,50 @@ setup_input_buffer (GstOmxBaseFilter *self, GstBuffer *buf)
     }
 }
 
+/* Called from the thread pool once an asynchronous g_omx_core_init() is
+ * done, to complete READY to PAUSED.  Only the component is loaded in the
+ * background: going to Idle needs the port settings, which are only known
+ * once caps are negotiated, so Idle and Executing still happen on the first
+ * buffer.
+ *
+ * The state lock keeps this from running before change_state() has posted
+ * ASYNC_START and returned ASYNC, and tells whether the element still waits
+ * for it, rather than having gone back to READY meanwhile.
+ */
+static void
+init_done (GOmxCore *core)
+{
+    GstElement *element = GST_ELEMENT (core->object);
+
+    GST_STATE_LOCK (element);
+
+    if (GST_STATE_RETURN (element) != GST_STATE_CHANGE_ASYNC ||
+        GST_STATE_NEXT (element) != GST_STATE_PAUSED)
+    {
+        GST_DEBUG_OBJECT (element, "not waiting for the component anymore");
+        GST_STATE_UNLOCK (element);
+        return;
+    }
+
+    if (core->omx_state != OMX_StateLoaded)
+    {
+        GST_ELEMENT_ERROR (element, LIBRARY, INIT, (NULL),
+                           ("could not load the OpenMAX component: %s",
+                            g_omx_error_to_str (core->omx_error)));
+        gst_element_abort_state (element);
+        GST_STATE_UNLOCK (element);
+        return;
+    }
+
+    GST_INFO_OBJECT (element, "component loaded");
+
+    gst_element_continue_state (element, GST_STATE_CHANGE_SUCCESS);
+    gst_element_post_message (element,
+            gst_message_new_async_done (GST_OBJECT_CAST (element)));
+
+    GST_STATE_UNLOCK (element);
+}
+
 static GstStateChangeReturn
 change_state (GstElement *element,
               GstStateChange transition)
@@ -146,9 +200,18 @@ change_state (GstElement *element,
                      gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (transition)),
                      gst_element_state_get_name (GST_STATE_TRANSITION_NEXT (transition)));
 
+    /* an asynchronous READY to PAUSED is not to complete anymore */
+    if (GST_STATE_TRANSITION_NEXT (transition) <= GST_STATE_READY)
+        g_omx_core_init_pending (core, NULL);
+
     switch (transition)
     {
         case GST_STATE_CHANGE_NULL_TO_READY:
+            if (self->async_state_change)
+            {
+                g_omx_core_init_async (core);
+                break;
+            }
             g_omx_core_init (core);
             if (core->omx_state != OMX_StateLoaded)
             {
@@ -168,6 +231,21 @@ change_state (GstElement *element,
 
     switch (transition)
     {
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            if (g_omx_core_init_pending (core, init_done))
+            {
+                GST_INFO_OBJECT (self, "component still loading");
+                gst_element_post_message (element,
+                        gst_message_new_async_start (GST_OBJECT_CAST (element), FALSE));
+                ret = GST_STATE_CHANGE_ASYNC;
+            }
+            else if (self->async_state_change &&
+                     core->omx_state != OMX_StateLoaded)
+            {
+                ret = GST_STATE_CHANGE_FAILURE;
+            }
+            break;
+
         case GST_STATE_CHANGE_PAUSED_TO_READY:
             g_mutex_lock (self->ready_lock);
             if (self->ready)
@@ -223,6 +301,8 @@ finalize (GObject *obj)
     g_free (self->omx_library);
 
     g_mutex_free (self->ready_lock);
+    g_mutex_free (self->eos_lock);
+    g_cond_free (self->eos_cond);
 
     G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -257,19 +337,32 @@ set_property (GObject *obj,
         case ARG_NUM_INPUT_BUFFERS:
         case ARG_NUM_OUTPUT_BUFFERS:
             {
-                OMX_PARAM_PORTDEFINITIONTYPE param;
-                OMX_U32 nBufferCountActual = g_value_get_uint (value);
                 GOmxPort *port = (prop_id == ARG_NUM_INPUT_BUFFERS) ?
                         self->in_port : self->out_port;
 
-                G_OMX_PORT_GET_DEFINITION (port, &param);
-
-                g_return_if_fail (nBufferCountActual >= param.nBufferCountMin);
-                param.nBufferCountActual = nBufferCountActual;
-
-                G_OMX_PORT_SET_DEFINITION (port, &param);
+                /* applied by g_omx_port_prepare(), over what the subclass
+                 * sets up */
+                G_OMX_PORT_SET_BUFFER_COUNT (port, g_value_get_int (value));
             }
             break;
+        case ARG_EOS_TIMEOUT:
+            self->eos_timeout = g_value_get_int (value);
+            break;
+        case ARG_STATE_TIMEOUT:
+            self->gomx->state_timeout = g_value_get_int (value);
+            break;
+        case ARG_ASYNC_STATE_CHANGE:
+            self->async_state_change = g_value_get_boolean (value);
+            break;
+        case ARG_HANDLE_POOL:
+            self->gomx->pool_size = g_value_get_uint (value);
+            break;
+        case ARG_HANDLE_POOL_TIMEOUT:
+            self->gomx->pool_timeout = g_value_get_int (value);
+            break;
+        case ARG_HANDLE_POOL_PREWARM:
+            self->gomx->pool_prewarm = g_value_get_uint (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -307,11 +400,41 @@ get_property (GObject *obj,
                 GOmxPort *port = (prop_id == ARG_NUM_INPUT_BUFFERS) ?
                         self->in_port : self->out_port;
 
+                if (port->buffers)
+                {
+                    g_value_set_int (value, port->num_buffers);
+                    break;
+                }
+
                 G_OMX_PORT_GET_DEFINITION (port, &param);
 
-                g_value_set_uint (value, param.nBufferCountActual);
+                g_value_set_int (value, param.nBufferCountActual);
             }
             break;
+        case ARG_INPUT_MEMORY:
+            g_value_set_uint64 (value, self->in_port->memory);
+            break;
+        case ARG_OUTPUT_MEMORY:
+            g_value_set_uint64 (value, self->out_port->memory);
+            break;
+        case ARG_EOS_TIMEOUT:
+            g_value_set_int (value, self->eos_timeout);
+            break;
+        case ARG_STATE_TIMEOUT:
+            g_value_set_int (value, self->gomx->state_timeout);
+            break;
+        case ARG_ASYNC_STATE_CHANGE:
+            g_value_set_boolean (value, self->async_state_change);
+            break;
+        case ARG_HANDLE_POOL:
+            g_value_set_uint (value, self->gomx->pool_size);
+            break;
+        case ARG_HANDLE_POOL_TIMEOUT:
+            g_value_set_int (value, self->gomx->pool_timeout);
+            break;
+        case ARG_HANDLE_POOL_PREWARM:
+            g_value_set_uint (value, self->gomx->pool_prewarm);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -366,18 +489,69 @@ type_class_init (gpointer g_class,
                                                                "Whether or not to use timestamps",
                                                                TRUE, G_PARAM_READWRITE));
 
-        /* note: the default values for these are just a guess.. since we wouldn't know
-         * until the OMX component is constructed.  But that is ok, these properties are
-         * only for debugging
+        /* note: what 0 amounts to is only known once the OMX component is
+         * constructed, the subclass and the component decide; reading the
+         * properties gives the count in use.
          */
         g_object_class_install_property (gobject_class, ARG_NUM_INPUT_BUFFERS,
-                                         g_param_spec_uint ("input-buffers", "Input buffers",
-                                                            "The number of OMX input buffers",
-                                                            1, 10, 4, G_PARAM_READWRITE));
+                                         g_param_spec_int ("input-buffers", "Input buffers",
+                                                           "The number of OMX input buffers "
+                                                           "(0 = element default, -1 = as few as the stream needs)",
+                                                           GOMX_PORT_AUTO_BUFFERS, GOMX_PORT_MAX_BUFFERS, 0, G_PARAM_READWRITE));
         g_object_class_install_property (gobject_class, ARG_NUM_OUTPUT_BUFFERS,
-                                         g_param_spec_uint ("output-buffers", "Output buffers",
-                                                            "The number of OMX output buffers",
-                                                            1, 10, 4, G_PARAM_READWRITE));
+                                         g_param_spec_int ("output-buffers", "Output buffers",
+                                                           "The number of OMX output buffers "
+                                                           "(0 = element default, -1 = as few as the stream needs)",
+                                                           GOMX_PORT_AUTO_BUFFERS, GOMX_PORT_MAX_BUFFERS, 0, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_INPUT_MEMORY,
+                                         g_param_spec_uint64 ("input-memory", "Input memory",
+                                                              "Bytes allocated for the OMX input buffers",
+                                                              0, G_MAXUINT64, 0, G_PARAM_READABLE));
+        g_object_class_install_property (gobject_class, ARG_OUTPUT_MEMORY,
+                                         g_param_spec_uint64 ("output-memory", "Output memory",
+                                                              "Bytes allocated for the OMX output buffers",
+                                                              0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_EOS_TIMEOUT,
+                                         g_param_spec_int ("eos-timeout", "EOS timeout",
+                                                           "Milliseconds to wait for the component to drain "
+                                                           "on EOS (-1 = forever)",
+                                                           -1, G_MAXINT, DEFAULT_EOS_TIMEOUT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_STATE_TIMEOUT,
+                                         g_param_spec_int ("state-timeout", "State timeout",
+                                                           "Milliseconds to wait for each state transition "
+                                                           "of the component (-1 = forever)",
+                                                           -1, G_MAXINT, GOMX_STATE_TIMEOUT_DEFAULT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_ASYNC_STATE_CHANGE,
+                                         g_param_spec_boolean ("async-state-change", "Asynchronous state change",
+                                                               "Load the component in the background, "
+                                                               "completing READY to PAUSED asynchronously",
+                                                               FALSE, G_PARAM_READWRITE));
+
+        /* the defaults come from OMX_HANDLE_POOL, OMX_HANDLE_POOL_TIMEOUT and
+         * OMX_HANDLE_POOL_PREWARM, see g_omx_handle_pool_defaults()
+         */
+        g_object_class_install_property (gobject_class, ARG_HANDLE_POOL,
+                                         g_param_spec_uint ("handle-pool", "Handle pool",
+                                                            "Keep the component loaded on NULL for the next element "
+                                                            "using it, up to this many of its kind (0 = free it)",
+                                                            0, G_MAXUINT, 0, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_HANDLE_POOL_TIMEOUT,
+                                         g_param_spec_int ("handle-pool-timeout", "Handle pool timeout",
+                                                           "Milliseconds to keep the component in the handle pool "
+                                                           "(-1 = forever)",
+                                                           -1, G_MAXINT, GOMX_HANDLE_POOL_TIMEOUT_DEFAULT, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_HANDLE_POOL_PREWARM,
+                                         g_param_spec_uint ("handle-pool-prewarm", "Handle pool prewarm",
+                                                            "Once the component is loaded, load this many more of its "
+                                                            "kind into the handle pool for the next elements, up to "
+                                                            "handle-pool (0 = none)",
+                                                            0, G_MAXUINT, 0, G_PARAM_READWRITE));
     }
 }
 
@@ -402,6 +576,45 @@ push_buffer (GstOmxBaseFilter *self,
     return ret;
 }
 
+/* The component changed the output port definition, typically on a new
+ * picture size in the stream: the port gets its buffers back, is disabled,
+ * set up by the subclass for the new format, and enabled with buffers of
+ * the new size, while the rest of the component keeps running.  Buffers
+ * still held downstream get a copy of their data and give their headers
+ * back, see g_omx_port_disable().
+ */
+static GstFlowReturn
+reconfigure_out_port (GstOmxBaseFilter *self)
+{
+    GstOmxBaseFilterClass *bclass = GST_OMX_BASE_FILTER_GET_CLASS (self);
+    GOmxPort *out_port = self->out_port;
+    GTimer *timer;
+    gboolean ok = TRUE;
+
+    out_port->settings_changed = FALSE;
+    timer = g_timer_new ();
+
+    g_omx_port_disable (out_port);
+
+    if (bclass->out_port_changed)
+        ok = bclass->out_port_changed (self);
+
+    g_omx_port_enable (out_port);
+
+    GST_INFO_OBJECT (self, "output port reconfigured in %.3f ms",
+                     g_timer_elapsed (timer, NULL) * 1000.0);
+    g_timer_destroy (timer);
+
+    if (!ok)
+    {
+        GST_ELEMENT_ERROR (self, CORE, NEGOTIATION, (NULL),
+                           ("downstream refused the new output format"));
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    return GST_FLOW_OK;
+}
+
 static void
 output_loop (gpointer data)
 {
@@ -432,6 +645,12 @@ output_loop (gpointer data)
     {
         gpointer obj = g_omx_port_recv (out_port);
 
+        if (G_UNLIKELY (!obj && out_port->settings_changed))
+        {
+            ret = reconfigure_out_port (self);
+            goto leave;
+        }
+
         if (G_UNLIKELY (!obj))
         {
             GST_WARNING_OBJECT (self, "null buffer: leaving");
@@ -462,14 +681,44 @@ output_loop (gpointer data)
             else
             {
                 GstBuffer *buf = GST_BUFFER (obj);
-                ret = bclass->push_buffer (self, buf);
-                GST_DEBUG_OBJECT (self, "ret=%s", gst_flow_get_name (ret));
+
+                /* pushed under eos_lock, so that pad_event can not send EOS
+                 * between the check and the push
+                 */
+                g_mutex_lock (self->eos_lock);
+                if (G_UNLIKELY (self->eos_pushed))
+                {
+                    /* pad_event gave up waiting for the drain and EOS
+                     * already went downstream, nothing may follow it
+                     */
+                    GST_WARNING_OBJECT (self, "dropping buffer after EOS");
+                    gst_buffer_unref (buf);
+                    ret = GST_FLOW_UNEXPECTED;
+                }
+                else
+                {
+                    ret = bclass->push_buffer (self, buf);
+                    GST_DEBUG_OBJECT (self, "ret=%s", gst_flow_get_name (ret));
+                }
+                g_mutex_unlock (self->eos_lock);
             }
         }
         else if (GST_IS_EVENT (obj))
         {
+            gboolean push;
+
             GST_DEBUG_OBJECT (self, "got eos");
-            gst_pad_push_event (self->srcpad, obj);
+
+            g_mutex_lock (self->eos_lock);
+            push = !self->eos_pushed;
+            self->eos_pushed = TRUE;
+            g_mutex_unlock (self->eos_lock);
+
+            if (push)
+                gst_pad_push_event (self->srcpad, obj);
+            else
+                gst_event_unref (obj);
+
             ret = GST_FLOW_UNEXPECTED;
             goto leave;
         }
@@ -478,6 +727,7 @@ output_loop (gpointer data)
 
 leave:
 
+    g_mutex_lock (self->eos_lock);
     self->last_pad_push_return = ret;
 
     if (gomx->omx_error != OMX_ErrorNone)
@@ -486,6 +736,11 @@ leave:
         ret = GST_FLOW_ERROR;
     }
 
+    /* a pending EOS drain will not complete anymore */
+    if (ret != GST_FLOW_OK)
+        g_cond_broadcast (self->eos_cond);
+    g_mutex_unlock (self->eos_lock);
+
     if (ret != GST_FLOW_OK)
     {
         GST_INFO_OBJECT (self, "pause task, reason:  %s",
@@ -514,6 +769,9 @@ pad_chain (GstPad *pad,
 
     gomx = self->gomx;
 
+    /* data may flow before an asynchronous READY to PAUSED completes */
+    g_omx_core_init_wait (gomx);
+
     GST_LOG_OBJECT (self, "begin: size=%u, state=%d", GST_BUFFER_SIZE (buf), gomx->omx_state);
 
     if (G_UNLIKELY (gomx->omx_state == OMX_StateLoaded))
@@ -622,7 +880,11 @@ out_flushing:
     {
         const gchar *error_msg = NULL;
 
-        if (gomx->omx_error)
+        if (gomx->omx_error == OMX_ErrorTimeout)
+        {
+            error_msg = "Timed out waiting for the OpenMAX component";
+        }
+        else if (gomx->omx_error)
         {
             error_msg = "Error from OpenMAX component";
         }
@@ -644,6 +906,47 @@ out_flushing:
     }
 }
 
+/**
+ * Wait until output_loop has pushed the EOS flagged buffer which follows the
+ * frames still held by the component.  Returns FALSE if that did not happen
+ * within eos-timeout, or if the output loop stopped first; EOS is then up to
+ * the caller, and output_loop drops whatever the component returns later.
+ */
+static gboolean
+wait_for_eos (GstOmxBaseFilter *self)
+{
+    GTimeVal deadline;
+    gboolean pushed;
+
+    g_get_current_time (&deadline);
+    g_time_val_add (&deadline, (glong) self->eos_timeout * 1000);
+
+    g_mutex_lock (self->eos_lock);
+
+    while (!self->eos_pushed &&
+           self->last_pad_push_return == GST_FLOW_OK &&
+           self->gomx->omx_error == OMX_ErrorNone)
+    {
+        if (self->eos_timeout < 0)
+        {
+            g_cond_wait (self->eos_cond, self->eos_lock);
+        }
+        else if (!g_cond_timed_wait (self->eos_cond, self->eos_lock, &deadline))
+        {
+            GST_WARNING_OBJECT (self, "component did not return EOS within %d ms",
+                                self->eos_timeout);
+            break;
+        }
+    }
+
+    pushed = self->eos_pushed;
+    self->eos_pushed = TRUE;
+
+    g_mutex_unlock (self->eos_lock);
+
+    return pushed;
+}
+
 static gboolean
 pad_event (GstPad *pad,
            GstEvent *event)
@@ -655,37 +958,45 @@ pad_event (GstPad *pad,
     self = GST_OMX_BASE_FILTER (GST_OBJECT_PARENT (pad));
     gomx = self->gomx;
 
+    g_omx_core_init_wait (gomx);
+
     GST_INFO_OBJECT (self, "begin: event=%s", GST_EVENT_TYPE_NAME (event));
 
     switch (GST_EVENT_TYPE (event))
     {
         case GST_EVENT_EOS:
-            printf ("Recieved EOS event, press <CTRL+C> to terminate pipeline.\n");
             /* if we are init'ed, and there is a running loop; then
              * if we get a buffer to inform it of EOS, let it handle the rest
              * in any other case, we send EOS */
             if (self->ready && self->last_pad_push_return == GST_FLOW_OK)
             {
-                /***** FIXME: EZSDK OMX componet does not execute FBD callback for an 
-                 ETB call when nFlags is set to OMX_BUFFERFLAG_EOS. Because of this 
-                 we are not able to trigger EOS on srcpad task. For now disable sending this event
-                 until we get OMX component fixed. */
-                #if 0
-                if (g_omx_port_send (self->in_port, event) >= 0)
+                /* The EOS flagged buffer comes back on the output port
+                 * after the frames the component still holds.  Some EZSDK
+                 * components never return it, hence the timeout.
+                 */
+                if (g_omx_port_send (self->in_port, event) >= 0 &&
+                    wait_for_eos (self))
                 {
                     gst_event_unref (event);
                     break;
                 }
-                #endif
             }
 
             /* we tried, but it's up to us here */
+            g_mutex_lock (self->eos_lock);
+            self->eos_pushed = TRUE;
+            g_mutex_unlock (self->eos_lock);
+
             ret = gst_pad_push_event (self->srcpad, event);
             break;
 
         case GST_EVENT_FLUSH_START:
             gst_pad_push_event (self->srcpad, event);
+
+            g_mutex_lock (self->eos_lock);
             self->last_pad_push_return = GST_FLOW_WRONG_STATE;
+            g_cond_broadcast (self->eos_cond);
+            g_mutex_unlock (self->eos_lock);
 
             g_omx_core_flush_start (gomx);
 
@@ -696,7 +1007,11 @@ pad_event (GstPad *pad,
 
         case GST_EVENT_FLUSH_STOP:
             gst_pad_push_event (self->srcpad, event);
+
+            g_mutex_lock (self->eos_lock);
             self->last_pad_push_return = GST_FLOW_OK;
+            self->eos_pushed = FALSE;
+            g_mutex_unlock (self->eos_lock);
 
             g_omx_core_flush_stop (gomx);
 
@@ -732,7 +1047,11 @@ activate_push (GstPad *pad,
     if (active)
     {
         GST_DEBUG_OBJECT (self, "activate");
+
+        g_mutex_lock (self->eos_lock);
         self->last_pad_push_return = GST_FLOW_OK;
+        self->eos_pushed = FALSE;
+        g_mutex_unlock (self->eos_lock);
 
         /* we do not start the task yet if the pad is not connected */
         if (gst_pad_is_linked (pad))
@@ -751,6 +1070,12 @@ activate_push (GstPad *pad,
     {
         GST_DEBUG_OBJECT (self, "deactivate");
 
+        /* wake up an EOS drain, the output loop is about to stop */
+        g_mutex_lock (self->eos_lock);
+        self->last_pad_push_return = GST_FLOW_WRONG_STATE;
+        g_cond_broadcast (self->eos_cond);
+        g_mutex_unlock (self->eos_lock);
+
         if (self->ready)
         {
             /** @todo disable this until we properly reinitialize the buffers. */
@@ -845,6 +1170,9 @@ type_instance_init (GTypeInstance *instance,
     self->out_port->share_buffer = FALSE;
 
     self->ready_lock = g_mutex_new ();
+    self->eos_lock = g_mutex_new ();
+    self->eos_cond = g_cond_new ();
+    self->eos_timeout = DEFAULT_EOS_TIMEOUT;
 
     self->sinkpad =
         gst_pad_new_from_template (gst_element_class_get_pad_template (element_class, "sink"), "sink");
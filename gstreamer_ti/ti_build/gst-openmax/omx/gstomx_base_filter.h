@@ -60,6 +60,21 @@ struct GstOmxBaseFilter
     GstFlowReturn last_pad_push_return;
     GstBuffer *codec_data;
     GstClockTime duration;
+
+    /* EOS drain: the sink pad waits on eos_cond, for at most eos_timeout
+     * milliseconds (-1 waits forever), until the output port returns the
+     * EOS flagged buffer.  eos_lock protects eos_pushed, which makes sure
+     * EOS goes downstream once and last, and last_pad_push_return; the
+     * output loop holds it while pushing a buffer.
+     */
+    GMutex *eos_lock;
+    GCond *eos_cond;
+    gboolean eos_pushed;
+    gint eos_timeout;
+
+    /* the component is loaded in the background from NULL to READY, and
+     * READY to PAUSED completes asynchronously if it is not loaded yet */
+    gboolean async_state_change;
 };
 
 struct GstOmxBaseFilterClass
@@ -69,6 +84,10 @@ struct GstOmxBaseFilterClass
     GstFlowReturn (*push_buffer) (GstOmxBaseFilter *self, GstBuffer *buf);
     GstFlowReturn (*pad_chain) (GstPad *pad, GstBuffer *buf);
     gboolean (*pad_event) (GstPad *pad, GstEvent *event);
+
+    /** called from the output task while the output port is disabled after
+     * a settings change, to adapt to the new port definition */
+    gboolean (*out_port_changed) (GstOmxBaseFilter *self);
 };
 
 GType gst_omx_base_filter_get_type (void);
@@ -37,6 +37,8 @@ enum
     ARG_COMPONENT_ROLE,
     ARG_COMPONENT_NAME,
     ARG_LIBRARY_NAME,
+    ARG_NUM_INPUT_BUFFERS,
+    ARG_INPUT_MEMORY,
 };
 
 static void init_interfaces (GType type);
@@ -77,8 +79,14 @@ setup_input_buffer (GstOmxBaseSink *self, GstBuffer *buf)
          * OmxBufferInfo structure.
          */
         in_port =  self->in_port;
-        in_port->share_buffer_info = malloc (sizeof(OmxBufferInfo));
-        in_port->share_buffer_info->pBuffer = malloc (sizeof(int) * port->num_buffers);
+        if (in_port->share_buffer_info)
+        {
+            g_free (in_port->share_buffer_info->pBuffer);
+            g_free (in_port->share_buffer_info);
+        }
+        in_port->share_buffer_info = g_new0 (OmxBufferInfo, 1);
+        in_port->share_buffer_info->num_buffers = port->num_buffers;
+        in_port->share_buffer_info->pBuffer = g_new (OMX_U8 *, port->num_buffers);
         for (i=0; i < port->num_buffers; i++) {
             in_port->share_buffer_info->pBuffer[i] = port->buffers[i]->pBuffer;
         }
@@ -293,44 +301,74 @@ handle_event (GstBaseSink *gst_base,
     return TRUE;
 }
 
-#if 0
+/**
+ * Hand out the input port's own buffers to upstream, so that it renders
+ * straight into display memory.  This is only done once the component runs
+ * on buffers of its own (ie. upstream is not an OMX element whose buffers
+ * we share), which render() decides on the first buffer.  Until then, and
+ * for anything which would not fit in our buffers, we return no buffer and
+ * the pad falls back to a normal allocation.
+ */
 static GstFlowReturn
-buffer_alloc(GstBaseSink *base, guint64 offset, guint size, GstCaps *caps, 
-    GstBuffer **buf)
+buffer_alloc (GstBaseSink *gst_base,
+              guint64 offset,
+              guint size,
+              GstCaps *caps,
+              GstBuffer **buf)
 {
-
     GstOmxBaseSink *self;
+    GOmxPort *in_port;
     OMX_BUFFERHEADERTYPE *omx_buffer;
-    int i;
-    static int count = 0;
+    GstCaps *pad_caps;
+
+    self = GST_OMX_BASE_SINK (gst_base);
+    in_port = self->in_port;
 
-    self = GST_OMX_BASE_SINK (base);
+    *buf = NULL;
 
-    if (!self->port_initialized) 
+    if (self->gomx->omx_state != OMX_StateExecuting ||
+        !in_port->enabled || !in_port->omx_allocate || !in_port->always_copy)
+        return GST_FLOW_OK;
+
+    /* renegotiation, the new caps only apply once they reach the sink */
+    pad_caps = GST_PAD_CAPS (self->sinkpad);
+    if (!pad_caps || !caps || !gst_caps_is_equal (caps, pad_caps))
+        return GST_FLOW_OK;
+
+    omx_buffer = async_queue_pop (in_port->queue);
+
+    if (G_UNLIKELY (!omx_buffer))
     {
-        self->omx_setup (base, caps);
+        GST_DEBUG_OBJECT (self, "flushing");
+        return GST_FLOW_WRONG_STATE;
     }
 
-    if (G_UNLIKELY (self->gomx->omx_state == OMX_StateLoaded))
+    if (G_UNLIKELY (size > omx_buffer->nAllocLen))
     {
-        self->in_port->omx_allocate = TRUE;
-        self->in_port->always_copy = FALSE;
-        self->in_port->share_buffer = FALSE;
-        g_omx_core_prepare (self->gomx);
-        g_omx_core_start (self->gomx);
-        
-        /* queue all the buffers */
-        for (i=0; i < self->in_port->num_buffers; i++)
-            g_omx_port_push_buffer (self->in_port, self->in_port->buffers[i]);
+        g_omx_port_push_buffer (in_port, omx_buffer);
+        return GST_FLOW_OK;
     }
 
-    omx_buffer = async_queue_pop (self->in_port->queue);
+    omx_buffer->nOffset = 0;
     omx_buffer->nFilledLen = size;
-    *buf = gst_omxbuffertransport_new (self->in_port, omx_buffer);
+    omx_buffer->nFlags = 0;
+
+    *buf = gst_omxbuffertransport_new (in_port, omx_buffer);
+
+    if (G_UNLIKELY (!*buf))
+    {
+        g_omx_port_push_buffer (in_port, omx_buffer);
+        return GST_FLOW_OK;
+    }
+
+    GST_BUFFER_OFFSET (*buf) = offset;
+    gst_buffer_set_caps (*buf, caps);
+
+    GST_LOG_OBJECT (self, "omx_buffer=%p, pBuffer=%p, size=%u",
+                    omx_buffer, omx_buffer->pBuffer, size);
 
     return GST_FLOW_OK;
 }
-#endif
 
 static void
 set_property (GObject *obj,
@@ -356,6 +394,16 @@ set_property (GObject *obj,
             g_free (self->omx_library);
             self->omx_library = g_value_dup_string (value);
             break;
+        case ARG_NUM_INPUT_BUFFERS:
+            {
+                /* the port is set up later, see setup_ports() */
+                GOmxPort *port = g_omx_core_get_port (self->gomx, "in", 0);
+
+                /* applied by g_omx_port_prepare(), over what the subclass
+                 * sets up */
+                G_OMX_PORT_SET_BUFFER_COUNT (port, g_value_get_int (value));
+            }
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -383,6 +431,17 @@ get_property (GObject *obj,
         case ARG_LIBRARY_NAME:
             g_value_set_string (value, self->omx_library);
             break;
+        case ARG_NUM_INPUT_BUFFERS:
+            {
+                GOmxPort *port = g_omx_core_get_port (self->gomx, "in", 0);
+
+                g_value_set_int (value, port->buffers || !port->buffer_count ?
+                                 port->num_buffers : port->buffer_count);
+            }
+            break;
+        case ARG_INPUT_MEMORY:
+            g_value_set_uint64 (value, g_omx_core_get_port (self->gomx, "in", 0)->memory);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -413,7 +472,7 @@ type_class_init (gpointer g_class,
     gst_base_sink_class->event = handle_event;
     gst_base_sink_class->preroll = NULL;
     gst_base_sink_class->render = render;
-//    gst_base_sink_class->buffer_alloc = buffer_alloc;
+    gst_base_sink_class->buffer_alloc = buffer_alloc;
 
     /* Properties stuff */
     {
@@ -434,6 +493,17 @@ type_class_init (gpointer g_class,
                                          g_param_spec_string ("library-name", "Library name",
                                                               "Name of the OpenMAX IL implementation library to use",
                                                               NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_NUM_INPUT_BUFFERS,
+                                         g_param_spec_int ("input-buffers", "Input buffers",
+                                                           "The number of OMX input buffers "
+                                                           "(0 = element default, -1 = as few as the stream needs)",
+                                                           GOMX_PORT_AUTO_BUFFERS, GOMX_PORT_MAX_BUFFERS, 0, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_INPUT_MEMORY,
+                                         g_param_spec_uint64 ("input-memory", "Input memory",
+                                                              "Bytes allocated for the OMX input buffers",
+                                                              0, G_MAXUINT64, 0, G_PARAM_READABLE));
     }
 }
 
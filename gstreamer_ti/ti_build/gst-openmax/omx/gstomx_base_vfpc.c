@@ -25,17 +25,40 @@
 
 #include <OMX_TI_Index.h>
 
+#include <stdio.h> /* for sscanf */
 #include <string.h> /* for memset */
 
 enum
 {
     ARG_0,
     ARG_PORT_INDEX,
+    ARG_CROP_AREA,
 };
 
 GSTOMX_BOILERPLATE (GstOmxBaseVfpc, gst_omx_base_vfpc, GstOmxBaseFilter, GST_OMX_BASE_FILTER_TYPE);
 
 static GstFlowReturn push_buffer (GstOmxBaseFilter *self, GstBuffer *buf);
+static gboolean out_port_changed (GstOmxBaseFilter *omx_base);
+
+static void
+set_crop (GstOmxBaseVfpc *self, gint left, gint top, gint width, gint height)
+{
+    /* negative width/height: up to the edge of the frame */
+    width = MAX (width, 0);
+    height = MAX (height, 0);
+
+    if (left == self->left && top == self->top &&
+        width == self->crop_width && height == self->crop_height)
+        return;
+
+    GST_DEBUG_OBJECT (self, "crop %d,%d %dx%d", left, top, width, height);
+
+    self->left = left;
+    self->top = top;
+    self->crop_width = width;
+    self->crop_height = height;
+    self->crop_changed = TRUE;
+}
 
 static gboolean
 pad_event (GstPad *pad, GstEvent *event)
@@ -52,7 +75,16 @@ pad_event (GstPad *pad, GstEvent *event)
     {
         case GST_EVENT_CROP:
         {
-            gst_event_parse_crop (event, &self->top, &self->left, NULL, NULL);
+            gint top, left, width, height;
+
+            gst_event_parse_crop (event, &top, &left, &width, &height);
+
+            GST_OBJECT_LOCK (self);
+            if (!self->crop_area_set)
+                set_crop (self, left, top, width, height);
+            GST_OBJECT_UNLOCK (self);
+
+            gst_event_unref (event);
             return TRUE;
         }
         default:
@@ -62,6 +94,208 @@ pad_event (GstPad *pad, GstEvent *event)
     }
 }
 
+/* Whether the output caps for the current crop have another size */
+static gboolean
+src_size_changed (GstOmxBaseVfpc *self)
+{
+    GstStructure *structure;
+    GstCaps *caps;
+    gint width = 0, height = 0;
+
+    if (!self->create_src_caps)
+        return FALSE;
+
+    caps = self->create_src_caps (GST_OMX_BASE_FILTER (self));
+    structure = gst_caps_get_structure (caps, 0);
+    gst_structure_get_int (structure, "width", &width);
+    gst_structure_get_int (structure, "height", &height);
+    gst_caps_unref (caps);
+
+    return width != self->out_width || height != self->out_height;
+}
+
+/*
+ * The crop is part of the input channel resolution, which is a config and
+ * can be changed between two frames without touching the ports.  When the
+ * output size follows the crop, the output port is set up again by the
+ * output task instead, once it got the frames already out of the
+ * component, see out_port_changed().
+ */
+static GstFlowReturn
+pad_chain (GstPad *pad, GstBuffer *buf)
+{
+    GstOmxBaseVfpc *self;
+    gboolean crop_changed;
+
+    self = GST_OMX_BASE_VFPC (GST_OBJECT_PARENT (pad));
+
+    GST_OBJECT_LOCK (self);
+    crop_changed = self->crop_changed;
+    GST_OBJECT_UNLOCK (self);
+
+    if (G_UNLIKELY (crop_changed) && self->port_configured)
+    {
+        OMX_ERRORTYPE err;
+
+        if (src_size_changed (self))
+        {
+            GST_INFO_OBJECT (self, "crop changes the output size");
+
+            GST_OBJECT_LOCK (self);
+            self->crop_changed = FALSE;
+            GST_OBJECT_UNLOCK (self);
+
+            g_omx_port_settings_changed (GST_OMX_BASE_FILTER (self)->out_port);
+        }
+        else
+        {
+            err = gstomx_vfpc_set_input_resolution (self);
+
+            if (err != OMX_ErrorNone)
+                GST_WARNING_OBJECT (self, "failed to apply crop: %s",
+                        g_omx_error_to_str (err));
+        }
+    }
+
+    return parent_class->pad_chain (pad, buf);
+}
+
+/* Called by the output task with the output port disabled, after a crop
+ * changed the output size: the port, the output channel and the src caps
+ * get the new size, and the crop is applied along with them.  Frames which
+ * were still in the component with the old crop are lost.
+ */
+static gboolean
+out_port_changed (GstOmxBaseFilter *omx_base)
+{
+    GstOmxBaseVfpc *self;
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    OMX_ERRORTYPE err;
+    GstCaps *caps;
+    gboolean ret;
+
+    self = GST_OMX_BASE_VFPC (omx_base);
+
+    if (!self->create_src_caps)
+        return TRUE;
+
+    caps = self->create_src_caps (omx_base);
+
+    GST_INFO_OBJECT (self, "new output: %" GST_PTR_FORMAT, caps);
+
+    /* src_setcaps() takes the new size */
+    ret = gst_pad_peer_accept_caps (omx_base->srcpad, caps) &&
+          gst_pad_set_caps (omx_base->srcpad, caps);
+
+    gst_caps_unref (caps);
+
+    if (!ret)
+        return FALSE;
+
+    G_OMX_PORT_GET_DEFINITION (omx_base->out_port, &param);
+    param.format.video.nFrameWidth = self->out_width;
+    param.format.video.nFrameHeight = self->out_height;
+    param.format.video.nStride = self->out_stride;
+    param.nBufferSize = self->out_stride * self->out_height;
+    if (self->out_format == GST_VIDEO_FORMAT_NV12)
+        param.nBufferSize += param.nBufferSize / 2;
+    G_OMX_PORT_SET_DEFINITION (omx_base->out_port, &param);
+    g_omx_port_setup (omx_base->out_port, &param);
+
+    err = gstomx_vfpc_set_output_resolution (self);
+
+    if (err == OMX_ErrorNone)
+        err = gstomx_vfpc_set_input_resolution (self);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_WARNING_OBJECT (self, "failed to apply crop: %s",
+                g_omx_error_to_str (err));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* the crop rectangle, clipped to the input frame */
+void
+gstomx_vfpc_get_crop (GstOmxBaseVfpc *self, gint *left, gint *top, gint *width, gint *height)
+{
+    GST_OBJECT_LOCK (self);
+    *left = CLAMP (self->left, 0, self->in_width) & ~1;
+    *top = CLAMP (self->top, 0, self->in_height) & ~1;
+    *width = self->crop_width ? self->crop_width : self->in_width - *left;
+    *height = self->crop_height ? self->crop_height : self->in_height - *top;
+    GST_OBJECT_UNLOCK (self);
+
+    *width = MIN (*width, self->in_width - *left) & ~1;
+    *height = MIN (*height, self->in_height - *top) & ~1;
+}
+
+OMX_ERRORTYPE
+gstomx_vfpc_set_input_resolution (GstOmxBaseVfpc *self)
+{
+    GstOmxBaseFilter *omx_base;
+    OMX_CONFIG_VIDCHANNEL_RESOLUTION chResolution;
+    gint left, top, width, height;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    GST_OBJECT_LOCK (self);
+    self->crop_changed = FALSE;
+    GST_OBJECT_UNLOCK (self);
+
+    gstomx_vfpc_get_crop (self, &left, &top, &width, &height);
+
+    GST_LOG_OBJECT (self, "Setting channel resolution (input), crop %d,%d %dx%d",
+            left, top, width, height);
+
+    _G_OMX_INIT_PARAM (&chResolution);
+    chResolution.Frm0Width = self->in_width;
+    chResolution.Frm0Height = self->in_height;
+    chResolution.Frm0Pitch = self->in_stride;
+    chResolution.Frm1Width = 0;
+    chResolution.Frm1Height = 0;
+    chResolution.Frm1Pitch = 0;
+    chResolution.FrmStartX = left;
+    chResolution.FrmStartY = top;
+    chResolution.FrmCropWidth = width;
+    chResolution.FrmCropHeight = height;
+    chResolution.eDir = OMX_DirInput;
+    chResolution.nChId = 0;
+
+    return OMX_SetConfig (omx_base->gomx->omx_handle,
+            OMX_TI_IndexConfigVidChResolution, &chResolution);
+}
+
+OMX_ERRORTYPE
+gstomx_vfpc_set_output_resolution (GstOmxBaseVfpc *self)
+{
+    GstOmxBaseFilter *omx_base;
+    OMX_CONFIG_VIDCHANNEL_RESOLUTION chResolution;
+
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    GST_LOG_OBJECT (self, "Setting channel resolution (output)");
+
+    _G_OMX_INIT_PARAM (&chResolution);
+    chResolution.Frm0Width = self->out_width;
+    chResolution.Frm0Height = self->out_height;
+    chResolution.Frm0Pitch = self->out_stride;
+    chResolution.Frm1Width = 0;
+    chResolution.Frm1Height = 0;
+    chResolution.Frm1Pitch = 0;
+    chResolution.FrmStartX = 0;
+    chResolution.FrmStartY = 0;
+    chResolution.FrmCropWidth = 0;
+    chResolution.FrmCropHeight = 0;
+    chResolution.eDir = OMX_DirOutput;
+    chResolution.nChId = 0;
+
+    return OMX_SetConfig (omx_base->gomx->omx_handle,
+            OMX_TI_IndexConfigVidChResolution, &chResolution);
+}
+
 static void
 gstomx_vfpc_set_port_index (GObject *obj, int index)
 {
@@ -74,10 +308,8 @@ gstomx_vfpc_set_port_index (GObject *obj, int index)
     self->input_port_index = OMX_VFPC_INPUT_PORT_START_INDEX + index;
     self->output_port_index = OMX_VFPC_OUTPUT_PORT_START_INDEX + index;
  
-    /* free the existing core and ports */
+    /* free the existing core and its ports */
     g_omx_core_free (omx_base->gomx);
-    g_omx_port_free (omx_base->in_port);
-    g_omx_port_free (omx_base->out_port);
 
     /* create new core and ports */
     omx_base->gomx = g_omx_core_new (omx_base, self->g_class);
@@ -105,6 +337,7 @@ type_base_init (gpointer g_class)
     element_class = GST_ELEMENT_CLASS (g_class);
 
     bfilter_class->pad_event = pad_event;
+    bfilter_class->pad_chain = pad_chain;
 }
 
 static GstFlowReturn
@@ -214,6 +447,8 @@ src_setcaps (GstPad *pad, GstCaps *caps)
         self->out_stride = gstomx_calculate_stride (self->out_width, format);
     }
 
+    self->out_format = format;
+
     /* save the src caps later needed by omx transport buffer */
     if (omx_base->out_port->caps)
         gst_caps_unref (omx_base->out_port->caps);
@@ -242,6 +477,27 @@ set_property (GObject *obj,
             if (!self->port_configured) 
                 gstomx_vfpc_set_port_index (obj, self->port_index);
             break;
+        case ARG_CROP_AREA:
+            {
+                const gchar *str = g_value_get_string (value);
+                gint left, top, width, height;
+
+                GST_OBJECT_LOCK (self);
+                if (str && sscanf (str, "%d,%d@%dx%d", &left, &top, &width, &height) == 4)
+                {
+                    self->crop_area_set = TRUE;
+                    set_crop (self, left, top, width, height);
+                }
+                else
+                {
+                    if (str && *str)
+                        GST_WARNING_OBJECT (self, "invalid crop-area %s", str);
+                    self->crop_area_set = FALSE;
+                    set_crop (self, 0, 0, 0, 0);
+                }
+                GST_OBJECT_UNLOCK (self);
+            }
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -263,6 +519,20 @@ get_property (GObject *obj,
         case ARG_PORT_INDEX:
             g_value_set_uint (value, self->port_index);
             break;
+        case ARG_CROP_AREA:
+            GST_OBJECT_LOCK (self);
+            if (self->crop_area_set)
+            {
+                gchar *str = g_strdup_printf ("%d,%d@%dx%d", self->left, self->top,
+                        self->crop_width, self->crop_height);
+                g_value_take_string (value, str);
+            }
+            else
+            {
+                g_value_set_string (value, NULL);
+            }
+            GST_OBJECT_UNLOCK (self);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -312,6 +582,7 @@ type_class_init (gpointer g_class,
 
     gobject_class = G_OBJECT_CLASS (g_class);
     GST_OMX_BASE_FILTER_CLASS (g_class)->push_buffer = push_buffer;
+    GST_OMX_BASE_FILTER_CLASS (g_class)->out_port_changed = out_port_changed;
 
     /* Properties stuff */
     {
@@ -322,6 +593,13 @@ type_class_init (gpointer g_class,
                                          g_param_spec_uint ("port-index", "port index",
                                                             "input/output start port index",
                                                             0, 8, 0, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_CROP_AREA,
+                                         g_param_spec_string ("crop-area", "Crop area",
+                                                              "Input area to process, as <left>,<top>@<width>x<height>; "
+                                                              "a width or height of 0 extends to the edge of the frame. "
+                                                              "Overrides crop events from upstream, unset to use them again",
+                                                              NULL, G_PARAM_READWRITE));
     }
 }
 
@@ -49,9 +49,14 @@ struct GstOmxBaseVfpc
     GstPadSetCapsFunction sink_setcaps;
     gint in_width, in_height, in_stride;
     gint out_width, out_height, out_stride;
+    GstVideoFormat out_format;
     gint left, top;
+    gint crop_width, crop_height; /**< 0: up to the edge of the frame */
+    gboolean crop_changed;        /**< crop to be applied before the next frame, under the object lock */
+    gboolean crop_area_set;       /**< crop set by property, crop events are ignored */
     gint port_index, input_port_index, output_port_index;
     GstOmxBaseFilterCb omx_setup;
+    GstCaps *(*create_src_caps) (GstOmxBaseFilter *omx_base); /**< output caps for the current input and crop */
     gpointer g_class;
 };
 
@@ -62,6 +67,10 @@ struct GstOmxBaseVfpcClass
 
 GType gst_omx_base_vfpc_get_type (void);
 
+void gstomx_vfpc_get_crop (GstOmxBaseVfpc *self, gint *left, gint *top, gint *width, gint *height);
+OMX_ERRORTYPE gstomx_vfpc_set_input_resolution (GstOmxBaseVfpc *self);
+OMX_ERRORTYPE gstomx_vfpc_set_output_resolution (GstOmxBaseVfpc *self);
+
 G_END_DECLS
 
 #endif /* GSTOMX_BASE_VFPC_H */
@@ -32,6 +32,14 @@
 
 GSTOMX_BOILERPLATE (GstOmxBaseVideoDec, gst_omx_base_videodec, GstOmxBaseFilter, GST_OMX_BASE_FILTER_TYPE);
 
+enum
+{
+    ARG_0,
+    ARG_QOS,
+};
+
+#define DEFAULT_QOS TRUE
+
 /* OMX component not handling other color formats properly.. use this workaround
  * until component is fixed or we rebase to get config file support..
  */
@@ -50,6 +58,10 @@ static GstStaticPadTemplate src_template =
         );
 
 static GstFlowReturn push_buffer (GstOmxBaseFilter *self, GstBuffer *buf);
+static gboolean out_port_changed (GstOmxBaseFilter *self);
+static GstFlowReturn pad_chain (GstPad *pad, GstBuffer *buf);
+static gboolean pad_event (GstPad *pad, GstEvent *event);
+static GstStateChangeReturn change_state (GstElement *element, GstStateChange transition);
 
 static void
 type_base_init (gpointer g_class)
@@ -62,11 +74,314 @@ type_base_init (gpointer g_class)
         gst_static_pad_template_get (&src_template));
 }
 
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (obj);
+
+    switch (prop_id)
+    {
+        case ARG_QOS:
+            self->qos = g_value_get_boolean (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (obj);
+
+    switch (prop_id)
+    {
+        case ARG_QOS:
+            g_value_set_boolean (value, self->qos);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
 static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
 {
-    GST_OMX_BASE_FILTER_CLASS (g_class)->push_buffer = push_buffer;
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+    GstOmxBaseFilterClass *bfilter_class;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+    gstelement_class = GST_ELEMENT_CLASS (g_class);
+    bfilter_class = GST_OMX_BASE_FILTER_CLASS (g_class);
+
+    gstelement_class->change_state = change_state;
+
+    bfilter_class->push_buffer = push_buffer;
+    bfilter_class->out_port_changed = out_port_changed;
+    bfilter_class->pad_chain = pad_chain;
+    bfilter_class->pad_event = pad_event;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_QOS,
+                                         g_param_spec_boolean ("qos", "QoS",
+                                                               "Drop late pictures nothing is predicted from when "
+                                                               "downstream reports that we are behind",
+                                                               DEFAULT_QOS, G_PARAM_READWRITE));
+    }
+}
+
+static void
+reset_qos (GstOmxBaseVideoDec *self)
+{
+    GST_OBJECT_LOCK (self);
+    self->proportion = 1.0;
+    self->earliest_time = GST_CLOCK_TIME_NONE;
+    self->n_droppable = 0;
+    GST_OBJECT_UNLOCK (self);
+}
+
+/* whether a picture with this timestamp would reach the sink too late,
+ * going by the last QoS event */
+static gboolean
+is_late (GstOmxBaseVideoDec *self,
+         GstClockTime timestamp)
+{
+    GstClockTime running_time;
+    gboolean late = FALSE;
+
+    if (!self->qos || !GST_CLOCK_TIME_IS_VALID (timestamp))
+        return FALSE;
+
+    GST_OBJECT_LOCK (self);
+    if (GST_CLOCK_TIME_IS_VALID (self->earliest_time))
+    {
+        running_time = gst_segment_to_running_time (&self->segment,
+                GST_FORMAT_TIME, timestamp);
+        late = GST_CLOCK_TIME_IS_VALID (running_time) &&
+               running_time <= self->earliest_time;
+    }
+    GST_OBJECT_UNLOCK (self);
+
+    return late;
+}
+
+/* Count a dropped picture and post a QoS message about it. */
+static void
+post_qos (GstOmxBaseVideoDec *self,
+          GstClockTime timestamp,
+          GstClockTime duration)
+{
+    GstClockTime running_time, stream_time;
+    GstClockTimeDiff jitter = 0;
+    GstMessage *message;
+
+    GST_OBJECT_LOCK (self);
+    self->dropped++;
+
+    running_time = gst_segment_to_running_time (&self->segment,
+            GST_FORMAT_TIME, timestamp);
+    stream_time = gst_segment_to_stream_time (&self->segment,
+            GST_FORMAT_TIME, timestamp);
+    if (GST_CLOCK_TIME_IS_VALID (self->earliest_time) &&
+        GST_CLOCK_TIME_IS_VALID (running_time))
+        jitter = GST_CLOCK_DIFF (running_time, self->earliest_time);
+
+    message = gst_message_new_qos (GST_OBJECT (self), FALSE,
+            running_time, stream_time, timestamp, duration);
+    gst_message_set_qos_values (message, jitter, self->proportion, 1000000);
+    gst_message_set_qos_stats (message, GST_FORMAT_BUFFERS,
+            self->processed, self->dropped);
+    GST_OBJECT_UNLOCK (self);
+
+    GST_DEBUG_OBJECT (self, "dropped late picture %" GST_TIME_FORMAT
+            ", jitter %" G_GINT64_FORMAT, GST_TIME_ARGS (timestamp), jitter);
+
+    gst_element_post_message (GST_ELEMENT (self), message);
+}
+
+/* Remember a droppable picture sent to the component, by the timestamp it
+ * will come back with.  OMX only keeps microseconds.
+ */
+static void
+add_droppable (GstOmxBaseVideoDec *self,
+               GstClockTime timestamp)
+{
+    GST_OBJECT_LOCK (self);
+    if (self->n_droppable == GSTOMX_VIDEODEC_MAX_DROPPABLE)
+    {
+        /* the component dropped the oldest one itself */
+        memmove (self->droppable, self->droppable + 1,
+                 --self->n_droppable * sizeof (self->droppable[0]));
+    }
+    self->droppable[self->n_droppable++] = GST_TIME_AS_USECONDS (timestamp);
+    GST_OBJECT_UNLOCK (self);
+}
+
+static gboolean
+take_droppable (GstOmxBaseVideoDec *self,
+                GstClockTime timestamp)
+{
+    guint64 usecs = GST_TIME_AS_USECONDS (timestamp);
+    gboolean found = FALSE;
+    guint i;
+
+    GST_OBJECT_LOCK (self);
+    for (i = 0; i < self->n_droppable; i++)
+    {
+        if (self->droppable[i] == usecs)
+        {
+            memmove (self->droppable + i, self->droppable + i + 1,
+                     (--self->n_droppable - i) * sizeof (self->droppable[0]));
+            found = TRUE;
+            break;
+        }
+    }
+    GST_OBJECT_UNLOCK (self);
+
+    return found;
+}
+
+/* A late droppable picture is not decoded at all, others are noted to be
+ * dropped on the way out if they are late by then.
+ */
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxBaseVideoDec *self;
+    GstClockTime timestamp;
+
+    self = GST_OMX_BASE_VIDEODEC (GST_OBJECT_PARENT (pad));
+    timestamp = GST_BUFFER_TIMESTAMP (buf);
+
+    if (self->qos && self->is_droppable &&
+        GST_CLOCK_TIME_IS_VALID (timestamp) &&
+        self->is_droppable (self, buf))
+    {
+        if (is_late (self, timestamp))
+        {
+            post_qos (self, timestamp, GST_OMX_BASE_FILTER (self)->duration);
+            gst_buffer_unref (buf);
+            return GST_FLOW_OK;
+        }
+
+        add_droppable (self, timestamp);
+    }
+
+    return parent_class->pad_chain (pad, buf);
+}
+
+static gboolean
+pad_event (GstPad *pad,
+           GstEvent *event)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (GST_OBJECT_PARENT (pad));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_NEWSEGMENT:
+        {
+            gboolean update;
+            gdouble rate, applied_rate;
+            GstFormat format;
+            gint64 start, stop, position;
+
+            gst_event_parse_new_segment_full (event, &update, &rate,
+                    &applied_rate, &format, &start, &stop, &position);
+
+            if (format == GST_FORMAT_TIME)
+            {
+                GST_OBJECT_LOCK (self);
+                gst_segment_set_newsegment_full (&self->segment, update,
+                        rate, applied_rate, format, start, stop, position);
+                GST_OBJECT_UNLOCK (self);
+            }
+            break;
+        }
+        case GST_EVENT_FLUSH_STOP:
+            /* the lateness reported before the seek no longer applies */
+            reset_qos (self);
+            GST_OBJECT_LOCK (self);
+            gst_segment_init (&self->segment, GST_FORMAT_TIME);
+            GST_OBJECT_UNLOCK (self);
+            break;
+        default:
+            break;
+    }
+
+    return parent_class->pad_event (pad, event);
+}
+
+static gboolean
+src_event (GstPad *pad,
+           GstEvent *event)
+{
+    GstOmxBaseVideoDec *self;
+
+    self = GST_OMX_BASE_VIDEODEC (GST_OBJECT_PARENT (pad));
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_QOS)
+    {
+        gdouble proportion;
+        GstClockTimeDiff diff;
+        GstClockTime timestamp;
+
+        gst_event_parse_qos (event, &proportion, &diff, &timestamp);
+
+        /* while late, the sink falls further behind until the pictures we
+         * drop let it catch up: skip up to twice as far ahead */
+        GST_OBJECT_LOCK (self);
+        self->proportion = proportion;
+        if (GST_CLOCK_TIME_IS_VALID (timestamp) && diff > 0)
+            self->earliest_time = timestamp + 2 * diff;
+        else
+            self->earliest_time = GST_CLOCK_TIME_NONE;
+        GST_OBJECT_UNLOCK (self);
+
+        GST_LOG_OBJECT (self, "QoS: proportion %g, jitter %" G_GINT64_FORMAT
+                " at %" GST_TIME_FORMAT, proportion, diff, GST_TIME_ARGS (timestamp));
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+static GstStateChangeReturn
+change_state (GstElement *element,
+              GstStateChange transition)
+{
+    GstOmxBaseVideoDec *self = GST_OMX_BASE_VIDEODEC (element);
+
+    if (transition == GST_STATE_CHANGE_READY_TO_PAUSED)
+    {
+        reset_qos (self);
+        GST_OBJECT_LOCK (self);
+        gst_segment_init (&self->segment, GST_FORMAT_TIME);
+        self->processed = 0;
+        self->dropped = 0;
+        GST_OBJECT_UNLOCK (self);
+    }
+
+    return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
 }
 
 static GstFlowReturn
@@ -74,14 +389,40 @@ push_buffer (GstOmxBaseFilter *omx_base, GstBuffer *buf)
 {
     GstOmxBaseVideoDec *self = GST_OMX_BASE_VIDEODEC (omx_base);
     guint n_offset = omx_base->out_port->n_offset;
+    GstFlowReturn ret;
+
+    /* a droppable picture that is late by now goes no further */
+    if (GST_BUFFER_TIMESTAMP_IS_VALID (buf) &&
+        take_droppable (self, GST_BUFFER_TIMESTAMP (buf)) &&
+        is_late (self, GST_BUFFER_TIMESTAMP (buf)))
+    {
+        post_qos (self, GST_BUFFER_TIMESTAMP (buf), omx_base->duration);
+        gst_buffer_unref (buf);
+        return GST_FLOW_OK;
+    }
+
     if (n_offset)
     {
+        /* the coded size, when known, is the picture without the padding */
+        gint width = self->extendedParams.width ? self->extendedParams.width : -1;
+        gint height = self->extendedParams.height ? self->extendedParams.height : -1;
+
         gst_pad_push_event (omx_base->srcpad,
                 gst_event_new_crop (n_offset / self->rowstride, /* top */
                         n_offset % self->rowstride, /* left */
-                        -1, -1)); /* width/height: can be invalid for now */
+                        width, height));
+    }
+
+    ret = parent_class->push_buffer (omx_base, buf);
+
+    if (ret == GST_FLOW_OK)
+    {
+        GST_OBJECT_LOCK (self);
+        self->processed++;
+        GST_OBJECT_UNLOCK (self);
     }
-    return parent_class->push_buffer (omx_base, buf);
+
+    return ret;
 }
 
 static void
@@ -96,6 +437,16 @@ settings_changed_cb (GOmxCore *core)
 
     GST_DEBUG_OBJECT (omx_base, "settings changed");
 
+    /* once running, the output port is reconfigured from the output task
+     * when it gets to the first buffer of the new format
+     */
+    if (core->omx_state == OMX_StateExecuting ||
+        core->omx_state == OMX_StatePause)
+    {
+        g_omx_port_settings_changed (omx_base->out_port);
+        return;
+    }
+
     new_caps = gst_caps_intersect (gst_pad_get_caps (omx_base->srcpad),
            gst_pad_peer_get_caps (omx_base->srcpad));
 
@@ -112,6 +463,54 @@ settings_changed_cb (GOmxCore *core)
     gst_pad_set_caps (omx_base->srcpad, new_caps);
 }
 
+/* Called with the output port disabled after a mid-stream settings change:
+ * carry the new picture size over to the negotiated caps.
+ */
+static gboolean
+out_port_changed (GstOmxBaseFilter *omx_base)
+{
+    GstOmxBaseVideoDec *self = GST_OMX_BASE_VIDEODEC (omx_base);
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    GstStructure *structure;
+    GstCaps *caps;
+    gboolean ret;
+
+    G_OMX_PORT_GET_DEFINITION (omx_base->out_port, &param);
+
+    GST_INFO_OBJECT (self, "new output: %ldx%ld, stride %ld",
+                     param.format.video.nFrameWidth,
+                     param.format.video.nFrameHeight,
+                     param.format.video.nStride);
+
+    self->extendedParams.width = param.format.video.nFrameWidth;
+    self->extendedParams.height = param.format.video.nFrameHeight;
+
+    caps = gst_pad_get_negotiated_caps (omx_base->srcpad);
+    if (!caps)
+    {
+        /* nothing went downstream yet */
+        return TRUE;
+    }
+
+    caps = gst_caps_make_writable (caps);
+    structure = gst_caps_get_structure (caps, 0);
+    gst_structure_set (structure,
+                       "width", G_TYPE_INT, (gint) param.format.video.nFrameWidth,
+                       "height", G_TYPE_INT, (gint) param.format.video.nFrameHeight,
+                       NULL);
+    if (gst_structure_has_field (structure, "rowstride"))
+        gst_structure_set (structure,
+                           "rowstride", G_TYPE_INT, (gint) param.format.video.nStride,
+                           NULL);
+
+    ret = gst_pad_peer_accept_caps (omx_base->srcpad, caps) &&
+          gst_pad_set_caps (omx_base->srcpad, caps);
+
+    gst_caps_unref (caps);
+
+    return ret;
+}
+
 static gboolean
 sink_setcaps (GstPad *pad,
               GstCaps *caps)
@@ -129,6 +528,9 @@ sink_setcaps (GstPad *pad,
 
     gomx = (GOmxCore *) omx_base->gomx;
 
+    /* the component may still be loading, see "async-state-change" */
+    g_omx_core_init_wait (gomx);
+
     GST_INFO_OBJECT (self, "setcaps (sink): %" GST_PTR_FORMAT, caps);
 
     g_return_val_if_fail (caps, FALSE);
@@ -177,11 +579,24 @@ sink_setcaps (GstPad *pad,
         if (codec_data)
         {
             buffer = gst_value_get_buffer (codec_data);
+            if (omx_base->codec_data)
+                gst_buffer_unref (omx_base->codec_data);
             omx_base->codec_data = buffer;
             gst_buffer_ref (buffer);
         }
     }
 
+    /* the ports are set up once, a new picture size in a running stream is
+     * found by the component itself (see out_port_changed)
+     */
+    if (gomx->omx_state != OMX_StateLoaded)
+    {
+        if (self->sink_setcaps)
+            self->sink_setcaps (pad, caps);
+
+        return gst_pad_set_caps (pad, caps);
+    }
+
     /* REVISIT: to use OMX package from EZSDK you need to configure ports  */
     #ifdef USE_OMXTICORE
     {
@@ -448,8 +863,10 @@ type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
 {
     GstOmxBaseFilter *omx_base;
+    GstOmxBaseVideoDec *self;
 
     omx_base = GST_OMX_BASE_FILTER (instance);
+    self = GST_OMX_BASE_VIDEODEC (instance);
 
     omx_base->omx_setup = omx_setup;
 
@@ -469,6 +886,12 @@ type_instance_init (GTypeInstance *instance,
             GST_DEBUG_FUNCPTR (src_getcaps));
     gst_pad_set_setcaps_function (omx_base->srcpad,
             GST_DEBUG_FUNCPTR (src_setcaps));
+    gst_pad_set_event_function (omx_base->srcpad,
+            GST_DEBUG_FUNCPTR (src_event));
+
+    self->qos = DEFAULT_QOS;
+    gst_segment_init (&self->segment, GST_FORMAT_TIME);
+    reset_qos (self);
 //    gst_pad_set_query_function (omx_base->srcpad,
 //            GST_DEBUG_FUNCPTR (src_query));
 }
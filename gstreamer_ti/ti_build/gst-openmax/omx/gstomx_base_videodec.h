@@ -30,6 +30,9 @@ G_BEGIN_DECLS
 #define GST_OMX_BASE_VIDEODEC_TYPE (gst_omx_base_videodec_get_type ())
 #define GST_OMX_BASE_VIDEODEC_CLASS(c) (G_TYPE_CHECK_CLASS_CAST ((c), GST_OMX_BASE_VIDEODEC_TYPE, GstOmxBaseVideoDecClass))
 
+/* droppable frames the component can hold at once */
+#define GSTOMX_VIDEODEC_MAX_DROPPABLE 32
+
 typedef struct GstOmxBaseVideoDec GstOmxBaseVideoDec;
 typedef struct GstOmxBaseVideoDecClass GstOmxBaseVideoDecClass;
 
@@ -56,6 +59,23 @@ struct GstOmxBaseVideoDec
     struct _extendedParams extendedParams;
 
     gint rowstride;     /**< rowstride of output buffer */
+
+    /* QoS: while downstream reports that we are late, pictures no other
+     * picture is predicted from are dropped, before decoding when they can
+     * be recognized from the bitstream.  is_droppable is set by subclasses
+     * that can tell.  The object lock protects segment, proportion,
+     * earliest_time, the timestamps of droppable frames still in the
+     * component and the counters.
+     */
+    gboolean qos;
+    gboolean (*is_droppable) (GstOmxBaseVideoDec *self, GstBuffer *buf);
+    GstSegment segment;
+    gdouble proportion;
+    GstClockTime earliest_time;
+    guint64 droppable[GSTOMX_VIDEODEC_MAX_DROPPABLE];   /* in microseconds */
+    guint n_droppable;
+    guint64 processed;
+    guint64 dropped;
 };
 
 struct GstOmxBaseVideoDecClass
@@ -46,6 +46,7 @@ static GstStaticPadTemplate sink_template =
         );
 
 static gboolean pad_event (GstPad *pad, GstEvent *event);
+static GstFlowReturn push_buffer (GstOmxBaseFilter *omx_base, GstBuffer *buf);
 
 static void
 type_base_init (gpointer g_class)
@@ -57,6 +58,7 @@ type_base_init (gpointer g_class)
         gst_static_pad_template_get (&sink_template));
 
     bfilter_class->pad_event = pad_event;
+    bfilter_class->push_buffer = push_buffer;
 }
 
 static void
@@ -167,6 +169,8 @@ sink_setcaps (GstPad *pad,
         if (!rowstride)
             rowstride = (width + 15) & 0xFFFFFFF0;
         param.format.video.nStride      = self->rowstride = rowstride;
+        self->width = width;
+        self->height = height;
 
         if (framerate)
         {
@@ -302,6 +306,18 @@ pad_event (GstPad *pad, GstEvent *event)
     }
 }
 
+static GstFlowReturn
+push_buffer (GstOmxBaseFilter *omx_base, GstBuffer *buf)
+{
+    /* only key frames can be decoded on their own */
+    if (omx_base->out_port->n_flags & OMX_BUFFERFLAG_SYNCFRAME)
+        GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+    else
+        GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+    return parent_class->push_buffer (omx_base, buf);
+}
+
 static void
 type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
@@ -44,6 +44,8 @@ struct GstOmxBaseVideoEnc
     gint framerate_denom;
     GstOmxBaseFilterCb omx_setup;
 
+    gint width;         /**< width of input frames */
+    gint height;        /**< height of input frames */
     gint rowstride;     /**< rowstride of input buffer */
 };
 
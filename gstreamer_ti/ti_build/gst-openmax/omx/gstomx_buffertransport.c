@@ -13,6 +13,11 @@
  * OMX it can access the OMX buffer directly via the GST_GET_OMXBUFFER() and similar 
  * access the upstream OMX port via the GST_GET_OMXPORT.
  *
+ * Each port with buffers allocated keeps a pool of transports, one per OMX
+ * buffer header.  When the transport of a header is unref'd, finalize hands
+ * the header back and keeps the object for the next time the same header is
+ * received, so that a running port does not allocate per frame.
+ *
  * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
  *
  * Author: Brijesh Singh <bksingh@ti.com>
@@ -59,6 +64,10 @@ static void gst_omxbuffertransport_init(GstOmxBufferTransport *self)
 
     self->omxbuffer = NULL;
     self->port = NULL;
+    self->numAdditionalHeaders = 0;
+    self->addHeader = NULL;
+    self->pool = NULL;
+    self->idle = FALSE;
 
     GST_LOG("end\n");
 }
@@ -85,11 +94,25 @@ release_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer)
     switch (port->type)
     {
         case GOMX_PORT_INPUT:
-            GST_LOG ("ETB: omx_buffer=%p, pAppPrivate=%p, pBuffer=%p",
-                    omx_buffer, omx_buffer ? omx_buffer->pAppPrivate : 0, omx_buffer ? omx_buffer->pBuffer : 0);
-            OMX_EmptyThisBuffer (port->core->omx_handle, omx_buffer);
+            /* input buffers are handed out by a sink's buffer_alloc, one
+             * which never got sent goes back to the port's free queue:
+             */
+            GST_LOG ("unused: omx_buffer=%p, pBuffer=%p",
+                    omx_buffer, omx_buffer ? omx_buffer->pBuffer : 0);
+            g_omx_port_push_buffer (port, omx_buffer);
             break;
         case GOMX_PORT_OUTPUT:
+            g_atomic_int_add (&port->held, -1);
+
+            /* a disabled port is freeing its buffers, the component takes
+             * none back until it is enabled again:
+             */
+            if (!port->enabled)
+            {
+                GST_LOG ("disabled: omx_buffer=%p", omx_buffer);
+                g_omx_port_push_buffer (port, omx_buffer);
+                break;
+            }
             GST_LOG ("FTB: omx_buffer=%p, pAppPrivate=%p, pBuffer=%p",
                     omx_buffer, omx_buffer ? omx_buffer->pAppPrivate : 0, omx_buffer ? omx_buffer->pBuffer : 0);
             OMX_FillThisBuffer (port->core->omx_handle, omx_buffer);
@@ -99,20 +122,88 @@ release_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer)
     }
 }
 
+/* Keep an unref'd transport in the pool of its port, rather than letting it
+ * be freed.  Returns FALSE if it is not pooled, or the pool is gone.
+ */
+static gboolean
+recycle (GstOmxBufferTransport *self)
+{
+    GOmxPort *port = self->pool;
+    gboolean recycled = FALSE;
+
+    if (!port)
+        return FALSE;
+
+    g_mutex_lock (port->mutex);
+
+    if (self->pool)
+    {
+        /* don't keep the caps alive while nobody uses the buffer */
+        gst_caps_replace (&GST_BUFFER_CAPS (self), NULL);
+
+        /* resurrect: the mini-object is not freed if finalize leaves it
+         * with a reference
+         */
+        gst_buffer_ref (GST_BUFFER (self));
+        self->idle = TRUE;
+        recycled = TRUE;
+    }
+
+    g_mutex_unlock (port->mutex);
+
+    return recycled;
+}
+
 static void gst_omxbuffertransport_finalize(GstBuffer *gstbuffer)
 {
     GstOmxBufferTransport *self = GST_OMXBUFFERTRANSPORT(gstbuffer);
-    int ii;
+    OMX_BUFFERHEADERTYPE *omxbuffer;
+    OMX_BUFFERHEADERTYPE **addHeader;
+    guint numAdditionalHeaders;
+    GOmxPort *port = self->port;
+    guint ii;
+
     GST_LOG("begin\n");
 
-    release_buffer (self->port, self->omxbuffer);
+    /* the headers are taken under the port lock, against
+     * gst_omxbuffertransport_pool_detach() taking them first
+     */
+    if (port)
+        g_mutex_lock (port->mutex);
+
+    omxbuffer = self->omxbuffer;
+    addHeader = self->addHeader;
+    numAdditionalHeaders = self->numAdditionalHeaders;
+    self->addHeader = NULL;
+    self->numAdditionalHeaders = 0;
+    self->omxbuffer = NULL;
+
+    if (port)
+        g_mutex_unlock (port->mutex);
 
-	for(ii = 0; ii < self->numAdditionalHeaders; ii++) {
-		//printf("finalize buffer:%p\n",self->addHeader[ii]);
-		release_buffer(self->port,self->addHeader[ii]);
+	for(ii = 0; ii < numAdditionalHeaders; ii++) {
+		release_buffer(port,addHeader[ii]);
 	}
 
-    self->omxbuffer = NULL;
+    g_free (addHeader);
+
+    /* Recycle before handing the header back: once it is released, the
+     * component may return it and the next gst_omxbuffertransport_new()
+     * picks this object up again straight away.
+     */
+    if (recycle (self))
+    {
+        /* g_omx_port_send() takes the header over when zero-copying */
+        if (omxbuffer)
+            release_buffer (port, omxbuffer);
+
+        GST_LOG("end recycle\n");
+        return;
+    }
+
+    if (omxbuffer)
+        release_buffer (port, omxbuffer);
+
     self->port = NULL;
 
     /* Call GstBuffer's finalize routine, so our base class can do it's cleanup
@@ -125,12 +216,68 @@ static void gst_omxbuffertransport_finalize(GstBuffer *gstbuffer)
     GST_LOG("end finalize\n");
 }
 
+/* Take the pooled transport of @buffer, or add a new one to the pool if the
+ * header has none yet.  Returns NULL if @buffer is not one of the headers of
+ * the pool, or its transport is still in use.
+ */
+static GstOmxBufferTransport *
+pool_get (GOmxPort *port, OMX_BUFFERHEADERTYPE *buffer)
+{
+    GstOmxBufferTransport *tdt_buf = NULL;
+    gpointer pooled;
+
+    g_mutex_lock (port->mutex);
+
+    if (port->transport_pool &&
+        g_hash_table_lookup_extended (port->transport_pool, buffer, NULL, &pooled))
+    {
+        tdt_buf = pooled;
+
+        if (!tdt_buf)
+        {
+            tdt_buf = (GstOmxBufferTransport*)
+                      gst_mini_object_new(GST_TYPE_OMXBUFFERTRANSPORT);
+            tdt_buf->pool = port;
+            g_hash_table_insert (port->transport_pool, buffer, tdt_buf);
+            port->transports_allocated++;
+        }
+        else if (tdt_buf->idle)
+        {
+            GstBuffer *buf = GST_BUFFER (tdt_buf);
+
+            GST_MINI_OBJECT_FLAGS (buf) = 0;
+            GST_BUFFER_TIMESTAMP (buf) = GST_CLOCK_TIME_NONE;
+            GST_BUFFER_DURATION (buf) = GST_CLOCK_TIME_NONE;
+            GST_BUFFER_OFFSET (buf) = GST_BUFFER_OFFSET_NONE;
+            GST_BUFFER_OFFSET_END (buf) = GST_BUFFER_OFFSET_NONE;
+        }
+        else
+        {
+            /* the header came back before its buffer was unref'd */
+            tdt_buf = NULL;
+        }
+
+        if (tdt_buf)
+            tdt_buf->idle = FALSE;
+    }
+
+    g_mutex_unlock (port->mutex);
+
+    return tdt_buf;
+}
+
 GstBuffer* gst_omxbuffertransport_new (GOmxPort *port, OMX_BUFFERHEADERTYPE *buffer)
 {
     GstOmxBufferTransport *tdt_buf;
 
-    tdt_buf = (GstOmxBufferTransport*)
-              gst_mini_object_new(GST_TYPE_OMXBUFFERTRANSPORT);
+    if (buffer->pBuffer == NULL)
+        return NULL;
+
+    tdt_buf = pool_get (port, buffer);
+
+    if (!tdt_buf)
+        tdt_buf = (GstOmxBufferTransport*)
+                  gst_mini_object_new(GST_TYPE_OMXBUFFERTRANSPORT);
 
     g_return_val_if_fail(tdt_buf != NULL, NULL);
 
@@ -138,17 +285,9 @@ GstBuffer* gst_omxbuffertransport_new (GOmxPort *port, OMX_BUFFERHEADERTYPE *buf
     GST_BUFFER_DATA(tdt_buf) = buffer->pBuffer;
     gst_buffer_set_caps(GST_BUFFER (tdt_buf), port->caps);
 
-    if (GST_BUFFER_DATA(tdt_buf) == NULL) {
-        gst_mini_object_unref(GST_MINI_OBJECT(tdt_buf));
-        return NULL;
-    }
-
     tdt_buf->omxbuffer  = buffer;
     tdt_buf->port       = port;
 
-	tdt_buf->numAdditionalHeaders = 0;
-	tdt_buf->addHeader = NULL;
-
     GST_LOG("end new\n");
 
     return GST_BUFFER(tdt_buf);
@@ -161,7 +300,8 @@ void gst_omxbuffertransport_set_additional_headers (GstOmxBufferTransport *self
 	if(numHeaders == 0)
 		return;
 	
-    self->addHeader = malloc(numHeaders*sizeof(OMX_BUFFERHEADERTYPE *));
+    g_free (self->addHeader);
+    self->addHeader = g_new (OMX_BUFFERHEADERTYPE *, numHeaders);
 
 	for(ii = 0; ii < numHeaders; ii++) {
 		//printf("additional header:%p\n", buffer[ii]);
@@ -169,7 +309,143 @@ void gst_omxbuffertransport_set_additional_headers (GstOmxBufferTransport *self
 	}
 	self->numAdditionalHeaders = numHeaders;
 
+    /* released along with the buffer, see g_omx_port_recv() */
+    if (self->port->type == GOMX_PORT_OUTPUT)
+        g_atomic_int_add (&self->port->held, numHeaders);
+
     return ;
 }
 
+/**
+ * Set up an empty transport pool with a slot for every buffer header of
+ * @port, called once the buffers are allocated.
+ */
+void
+gst_omxbuffertransport_pool_new (GOmxPort *port)
+{
+    guint i;
+
+    gst_omxbuffertransport_pool_free (port);
+
+    g_mutex_lock (port->mutex);
 
+    port->transport_pool = g_hash_table_new (g_direct_hash, g_direct_equal);
+    port->transports_allocated = 0;
+
+    for (i = 0; i < port->num_buffers; i++)
+        g_hash_table_insert (port->transport_pool, port->buffers[i], NULL);
+
+    g_mutex_unlock (port->mutex);
+}
+
+/**
+ * Free the transports in the pool of @port.  Those still in use downstream
+ * are left to be freed when they are unref'd.
+ */
+void
+gst_omxbuffertransport_pool_free (GOmxPort *port)
+{
+    GHashTableIter iter;
+    gpointer value;
+    GSList *idle = NULL;
+
+    g_mutex_lock (port->mutex);
+
+    if (!port->transport_pool)
+    {
+        g_mutex_unlock (port->mutex);
+        return;
+    }
+
+    g_hash_table_iter_init (&iter, port->transport_pool);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        GstOmxBufferTransport *tdt_buf = value;
+
+        if (!tdt_buf)
+            continue;
+
+        tdt_buf->pool = NULL;
+        if (tdt_buf->idle)
+            idle = g_slist_prepend (idle, tdt_buf);
+    }
+
+    GST_DEBUG ("<%s> %u transports allocated for %u buffers", port->name,
+            port->transports_allocated, port->num_buffers);
+
+    g_hash_table_destroy (port->transport_pool);
+    port->transport_pool = NULL;
+
+    g_mutex_unlock (port->mutex);
+
+    /* out of the pool, these are freed for good */
+    g_slist_foreach (idle, (GFunc) gst_mini_object_unref, NULL);
+    g_slist_free (idle);
+}
+
+/**
+ * Give the headers of the transports still held downstream back to @port,
+ * which has to be disabled already, so that its buffers can be freed: the
+ * data of each of them is copied into memory of its own first, and the
+ * transport is freed like any other buffer when it is unref'd.
+ */
+void
+gst_omxbuffertransport_pool_detach (GOmxPort *port)
+{
+    GHashTableIter iter;
+    gpointer value;
+    GSList *headers = NULL;
+    GSList *l;
+    guint detached = 0;
+
+    g_return_if_fail (!port->enabled);
+
+    g_mutex_lock (port->mutex);
+
+    if (!port->transport_pool)
+    {
+        g_mutex_unlock (port->mutex);
+        return;
+    }
+
+    g_hash_table_iter_init (&iter, port->transport_pool);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+        GstOmxBufferTransport *tdt_buf = value;
+        GstBuffer *buf;
+        guint ii;
+
+        /* unused, or being finalized */
+        if (!tdt_buf || tdt_buf->idle || !tdt_buf->omxbuffer)
+            continue;
+
+        buf = GST_BUFFER (tdt_buf);
+        GST_BUFFER_MALLOCDATA (buf) = g_memdup (GST_BUFFER_DATA (buf),
+                                                GST_BUFFER_SIZE (buf));
+        GST_BUFFER_DATA (buf) = GST_BUFFER_MALLOCDATA (buf);
+
+        headers = g_slist_prepend (headers, tdt_buf->omxbuffer);
+        for (ii = 0; ii < tdt_buf->numAdditionalHeaders; ii++)
+            headers = g_slist_prepend (headers, tdt_buf->addHeader[ii]);
+
+        g_free (tdt_buf->addHeader);
+        tdt_buf->addHeader = NULL;
+        tdt_buf->numAdditionalHeaders = 0;
+        tdt_buf->omxbuffer = NULL;
+
+        /* not to be recycled with the copy */
+        tdt_buf->pool = NULL;
+        detached++;
+    }
+
+    g_mutex_unlock (port->mutex);
+
+    if (detached)
+        GST_DEBUG ("<%s> copied %u buffers held downstream", port->name,
+                detached);
+
+    /* the port is disabled, so these go to its queue */
+    for (l = headers; l; l = l->next)
+        release_buffer (port, l->data);
+    g_slist_free (headers);
+}
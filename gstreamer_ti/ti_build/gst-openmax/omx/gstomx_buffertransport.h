@@ -61,6 +61,11 @@ struct _GstOmxBufferTransport {
     GOmxPort *port;
 	guint numAdditionalHeaders;
 	OMX_BUFFERHEADERTYPE **addHeader;
+
+    /* port whose transport pool recycles this object, NULL once it is
+     * freed for good, and whether it is sitting in the pool unused */
+    GOmxPort *pool;
+    gboolean idle;
 };
 
 struct _GstOmxBufferTransportClass {
@@ -71,6 +76,9 @@ struct _GstOmxBufferTransportClass {
 GType      gst_omxbuffertransport_get_type(void);
 GstBuffer* gst_omxbuffertransport_new(GOmxPort *port, OMX_BUFFERHEADERTYPE *buffer);
 void gst_omxbuffertransport_set_additional_headers (GstOmxBufferTransport *self ,guint numHeaders,OMX_BUFFERHEADERTYPE **buffer);
+void gst_omxbuffertransport_pool_new (GOmxPort *port);
+void gst_omxbuffertransport_pool_free (GOmxPort *port);
+void gst_omxbuffertransport_pool_detach (GOmxPort *port);
 
 
 G_END_DECLS 
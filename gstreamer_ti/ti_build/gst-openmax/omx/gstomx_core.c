@@ -44,7 +44,7 @@ static inline void
 change_state (GOmxCore *core,
               OMX_STATETYPE state);
 
-static inline void
+static inline gboolean
 wait_for_state (GOmxCore *core,
                 OMX_STATETYPE state);
 
@@ -76,6 +76,8 @@ FillBufferDone (OMX_HANDLETYPE omx_handle,
 
 static inline GOmxPort *get_port (GOmxCore *core, guint index);
 
+static void release_handle (GOmxCore *core);
+
 
 static OMX_CALLBACKTYPE callbacks = { EventHandler, EmptyBufferDone, FillBufferDone };
 
@@ -84,14 +86,6 @@ static OMX_CALLBACKTYPE callbacks = { EventHandler, EmptyBufferDone, FillBufferD
  * Util
  */
 
-static void
-g_ptr_array_clear (GPtrArray *array)
-{
-    guint index;
-    for (index = 0; index < array->len; index++)
-        array->pdata[index] = NULL;
-}
-
 static void
 g_ptr_array_insert (GPtrArray *array,
                     guint index,
@@ -157,6 +151,9 @@ g_omx_core_new (gpointer object, gpointer klass)
     core->omx_state = OMX_StateInvalid;
 
     core->use_timestamps = TRUE;
+    core->state_timeout = GOMX_STATE_TIMEOUT_DEFAULT;
+    g_omx_handle_pool_defaults (&core->pool_size, &core->pool_timeout,
+                                &core->pool_prewarm);
 
     {
         gchar *library_name, *component_name, *component_role;
@@ -185,6 +182,8 @@ g_omx_core_free (GOmxCore *core)
 {
     g_omx_core_deinit (core);     /* just in case we didn't have a READY->NULL.. mainly for gst-inspect */
 
+    core_for_each_port (core, g_omx_port_free);
+
     g_sem_free (core->port_sem);
     g_sem_free (core->flush_sem);
     g_sem_free (core->done_sem);
@@ -222,13 +221,34 @@ g_omx_core_init (GOmxCore *core)
     if (!core->imp)
         return;
 
+    core->omx_handle = g_omx_acquire_handle (core->imp, component_name,
+                                             component_role);
+    if (core->omx_handle)
+    {
+        OMX_COMPONENTTYPE *comp = core->omx_handle;
+        OMX_STATETYPE state = OMX_StateInvalid;
+
+        OMX_GetState (core->omx_handle, &state);
+        core->omx_error = comp->SetCallbacks (core->omx_handle, &callbacks, core);
+
+        GST_DEBUG_OBJECT (core->object, "pooled handle %p, state=%d -> %s",
+            core->omx_handle, state, g_omx_error_to_str (core->omx_error));
+
+        if (!core->omx_error && state == OMX_StateLoaded)
+            goto leave;
+
+        /* not usable after all */
+        core->omx_state = OMX_StateInvalid;
+        release_handle (core);
+    }
+
     #ifdef USE_STATIC
-    core->omx_error = core->imp->sym_table.get_handle (&core->omx_handle,
-                                                       (char *) component_name,
+    core->omx_error = OMX_GetHandle (&core->omx_handle, (char *) component_name,
                                                        core,
                                                        &callbacks);
     #else
-    core->omx_error = OMX_GetHandle (&core->omx_handle, (char *) component_name,
+    core->omx_error = core->imp->sym_table.get_handle (&core->omx_handle,
+                                                       (char *) component_name,
                                                        core,
                                                        &callbacks);
     #endif
@@ -252,10 +272,16 @@ g_omx_core_init (GOmxCore *core)
 
         G_OMX_CORE_SET_PARAM (core,
                 OMX_IndexParamStandardComponentRole, &param);
-
-        g_free (component_role);
     }
 
+leave:
+    /* spares for the next elements of this kind */
+    if (!core->omx_error && core->pool_prewarm)
+        g_omx_prewarm_handles (core->imp, component_name, component_role,
+                               core->pool_prewarm, core->pool_size,
+                               core->pool_timeout);
+
+    g_free (component_role);
     g_free (component_name);
     g_free (library_name);
 
@@ -263,6 +289,79 @@ g_omx_core_init (GOmxCore *core)
         core->omx_state = OMX_StateLoaded;
 }
 
+/* shared by all cores, so that components are loaded concurrently */
+static GThreadPool *init_pool;
+G_LOCK_DEFINE_STATIC (init_pool);
+
+static void
+init_thread (gpointer data,
+             gpointer user_data)
+{
+    GOmxCore *core = data;
+    GOmxCb done_cb;
+
+    g_omx_core_init (core);
+
+    g_mutex_lock (core->omx_state_mutex);
+    core->init_pending = FALSE;
+    done_cb = core->init_done_cb;
+    core->init_done_cb = NULL;
+    g_cond_broadcast (core->omx_state_condition);
+    g_mutex_unlock (core->omx_state_mutex);
+
+    if (done_cb)
+        done_cb (core);
+}
+
+/**
+ * Like g_omx_core_init(), but the component is loaded from a thread pool
+ * and the call returns straight away.  Whatever needs the handle waits for
+ * it, see g_omx_core_init_pending() to be told when it is done instead.
+ */
+void
+g_omx_core_init_async (GOmxCore *core)
+{
+    if (core->omx_handle || core->init_pending)
+        return;
+
+    G_LOCK (init_pool);
+    if (!init_pool)
+        init_pool = g_thread_pool_new (init_thread, NULL, -1, FALSE, NULL);
+    G_UNLOCK (init_pool);
+
+    core->init_pending = TRUE;
+    g_thread_pool_push (init_pool, core, NULL);
+}
+
+/**
+ * Returns TRUE if g_omx_core_init_async() has not finished yet, in which
+ * case done_cb is called from the pool thread once it has (NULL cancels an
+ * earlier done_cb).
+ */
+gboolean
+g_omx_core_init_pending (GOmxCore *core,
+                         GOmxCb done_cb)
+{
+    gboolean pending;
+
+    g_mutex_lock (core->omx_state_mutex);
+    pending = core->init_pending;
+    if (pending)
+        core->init_done_cb = done_cb;
+    g_mutex_unlock (core->omx_state_mutex);
+
+    return pending;
+}
+
+void
+g_omx_core_init_wait (GOmxCore *core)
+{
+    g_mutex_lock (core->omx_state_mutex);
+    while (core->init_pending)
+        g_cond_wait (core->omx_state_condition, core->omx_state_mutex);
+    g_mutex_unlock (core->omx_state_mutex);
+}
+
 void 
 g_omx_core_change_state (GOmxCore *core, OMX_STATETYPE state)
 {
@@ -270,29 +369,66 @@ g_omx_core_change_state (GOmxCore *core, OMX_STATETYPE state)
     wait_for_state (core, state);
 }
 
+/* Hands a component left in OMX_StateLoaded over to the handle pool, or
+ * frees it.
+ */
+static void
+release_handle (GOmxCore *core)
+{
+    if (core->omx_state == OMX_StateLoaded && !core->omx_error)
+    {
+        OMX_COMPONENTTYPE *comp = core->omx_handle;
+        gchar *component_name = NULL, *component_role = NULL;
+        gboolean pooled = FALSE;
+
+        g_object_get (core->object,
+            "component-role", &component_role,
+            "component-name", &component_name,
+            NULL);
+
+        /* no callbacks for us from here on */
+        if (comp->SetCallbacks (core->omx_handle, &callbacks, NULL) == OMX_ErrorNone)
+            pooled = g_omx_release_handle (core->imp, core->omx_handle,
+                                           component_name, component_role,
+                                           core->pool_size, core->pool_timeout);
+
+        g_free (component_role);
+        g_free (component_name);
+
+        if (pooled)
+        {
+            core->omx_handle = NULL;
+            return;
+        }
+    }
+
+    #ifdef USE_STATIC
+    core->omx_error = OMX_FreeHandle (core->omx_handle);
+    #else
+    core->omx_error = core->imp->sym_table.free_handle (core->omx_handle);
+    #endif
+    GST_DEBUG_OBJECT (core->object, "OMX_FreeHandle(%p) -> %s",
+        core->omx_handle, g_omx_error_to_str (core->omx_error));
+    core->omx_handle = NULL;
+}
+
 void
 g_omx_core_deinit (GOmxCore *core)
 {
+    g_omx_core_init_pending (core, NULL);
+    g_omx_core_init_wait (core);
+
     if (!core->imp)
         return;
 
-    core_for_each_port (core, g_omx_port_free);
-    g_ptr_array_clear (core->ports);
+    /* the element keeps its ports for the next component */
+    core_for_each_port (core, g_omx_port_reset);
 
     if (core->omx_state == OMX_StateLoaded ||
         core->omx_state == OMX_StateInvalid)
     {
         if (core->omx_handle)
-        {
-            #ifdef USE_STATIC
-            core->omx_error = OMX_FreeHandle (core->omx_handle);
-            #else
-            core->omx_error = core->imp->sym_table.free_handle (core->omx_handle);
-            #endif
-            GST_DEBUG_OBJECT (core->object, "OMX_FreeHandle(%p) -> %s",
-                core->omx_handle, g_omx_error_to_str (core->omx_error));
-            core->omx_handle = NULL;
-        }
+            release_handle (core);
     }
 
     g_omx_release_imp (core->imp);
@@ -452,6 +588,7 @@ g_omx_core_flush_stop (GOmxCore *core)
 OMX_HANDLETYPE
 g_omx_core_get_handle (GOmxCore *core)
 {
+  if (!core->omx_handle) g_omx_core_init_wait (core);
   if (!core->omx_handle) g_omx_core_init (core);
   g_return_val_if_fail (core->omx_handle, NULL);
   return core->omx_handle;
@@ -477,49 +614,73 @@ complete_change_state (GOmxCore *core,
     g_mutex_lock (core->omx_state_mutex);
 
     core->omx_state = state;
-    g_cond_signal (core->omx_state_condition);
+    g_cond_broadcast (core->omx_state_condition);
     GST_DEBUG_OBJECT (core->object, "state=%d", state);
 
     g_mutex_unlock (core->omx_state_mutex);
 }
 
-static inline void
+/* A timed out transition does not keep the following ones, ie. back to
+ * OMX_StateLoaded on the way down, from being waited for.
+ */
+static inline gboolean
+component_failed (GOmxCore *core)
+{
+    return core->omx_error != OMX_ErrorNone &&
+           core->omx_error != OMX_ErrorTimeout;
+}
+
+/* Returns FALSE if the component did not get to state, after an error or
+ * after core->state_timeout.  A timeout is reported as OMX_ErrorTimeout.
+ */
+static inline gboolean
 wait_for_state (GOmxCore *core,
                 OMX_STATETYPE state)
 {
     GTimeVal tv;
-    gboolean signaled;
+    gboolean ret = FALSE;
 
     g_mutex_lock (core->omx_state_mutex);
 
-    if (core->omx_error != OMX_ErrorNone)
+    if (component_failed (core))
         goto leave;
 
     g_get_current_time (&tv);
-    g_time_val_add (&tv, 100000000);
+    g_time_val_add (&tv, (glong) core->state_timeout * 1000);
 
-    /* try once */
-    if (core->omx_state != state)
+    while (core->omx_state != state && core->omx_state != OMX_StateInvalid &&
+           !component_failed (core))
     {
-        signaled = g_cond_timed_wait (core->omx_state_condition, core->omx_state_mutex, &tv);
-
-        if (!signaled)
+        if (core->state_timeout < 0)
         {
-            GST_ERROR_OBJECT (core->object, "timed out");
+            g_cond_wait (core->omx_state_condition, core->omx_state_mutex);
+        }
+        else if (!g_cond_timed_wait (core->omx_state_condition,
+                                     core->omx_state_mutex, &tv))
+        {
+            GST_ERROR_OBJECT (core->object, "timed out after %d ms: state=%d, expected=%d",
+                              core->state_timeout, core->omx_state, state);
+            core->omx_error = OMX_ErrorTimeout;
+            goto leave;
         }
     }
 
-    if (core->omx_error != OMX_ErrorNone)
+    if (component_failed (core))
         goto leave;
 
     if (core->omx_state != state)
     {
         GST_ERROR_OBJECT (core->object, "wrong state received: state=%d, expected=%d",
                           core->omx_state, state);
+        goto leave;
     }
 
+    ret = TRUE;
+
 leave:
     g_mutex_unlock (core->omx_state_mutex);
+
+    return ret;
 }
 
 /*
@@ -598,6 +759,10 @@ EventHandler (OMX_HANDLETYPE omx_handle,
 
     core = (GOmxCore *) app_data;
 
+    /* a pooled component, see release_handle() */
+    if (G_UNLIKELY (!core))
+        return OMX_ErrorNone;
+
     switch (event)
     {
         case OMX_EventCmdComplete:
@@ -702,6 +867,11 @@ EmptyBufferDone (OMX_HANDLETYPE omx_handle,
     g_return_val_if_fail (omx_buffer, OMX_ErrorBadParameter);
 
     core = (GOmxCore*) app_data;
+
+    /* a pooled component, see release_handle() */
+    if (G_UNLIKELY (!core))
+        return OMX_ErrorNone;
+
     port = get_port (core, omx_buffer->nInputPortIndex);
 
     GST_DEBUG_OBJECT (core->object, "EBD: omx_buffer=%p, pAppPrivate=%p, pBuffer=%p",
@@ -723,6 +893,11 @@ FillBufferDone (OMX_HANDLETYPE omx_handle,
     g_return_val_if_fail (omx_buffer, OMX_ErrorBadParameter);
 
     core = (GOmxCore *) app_data;
+
+    /* a pooled component, see release_handle() */
+    if (G_UNLIKELY (!core))
+        return OMX_ErrorNone;
+
     port = get_port (core, omx_buffer->nOutputPortIndex);
 
     GST_DEBUG_OBJECT (core->object, "FBD: omx_buffer=%p, pAppPrivate=%p, pBuffer=%p",
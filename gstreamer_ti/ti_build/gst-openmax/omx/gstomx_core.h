@@ -32,6 +32,9 @@ G_BEGIN_DECLS
 typedef void (*GOmxCb) (GOmxCore *core);
 typedef void (*GOmxCbargs2) (GOmxCore *core, gint data1, gint data2);
 
+/** default time to wait for a state transition, in ms */
+#define GOMX_STATE_TIMEOUT_DEFAULT 10000
+
 /* Structures. */
 
 struct GOmxCore
@@ -59,6 +62,15 @@ struct GOmxCore
     gboolean done;
 
     gboolean use_timestamps; /** @todo remove; timestamps should always be used */
+
+    gint state_timeout;      /**< ms to wait for a state transition, -1 waits for ever */
+
+    guint pool_size;         /**< components of this kind kept loaded in the handle pool, 0 frees it */
+    gint pool_timeout;       /**< ms the component is kept in the handle pool, -1 for ever */
+    guint pool_prewarm;      /**< components of this kind loaded ahead into the handle pool */
+
+    gboolean init_pending;   /**< g_omx_core_init_async() has not finished */
+    GOmxCb init_done_cb;
 };
 
 /* Utility Macros */
@@ -94,6 +106,9 @@ struct GOmxCore
 GOmxCore *g_omx_core_new (gpointer object, gpointer klass);
 void g_omx_core_free (GOmxCore *core);
 void g_omx_core_init (GOmxCore *core);
+void g_omx_core_init_async (GOmxCore *core);
+gboolean g_omx_core_init_pending (GOmxCore *core, GOmxCb done_cb);
+void g_omx_core_init_wait (GOmxCore *core);
 void g_omx_core_deinit (GOmxCore *core);
 void g_omx_core_prepare (GOmxCore *core);
 void g_omx_core_start (GOmxCore *core);
@@ -135,6 +135,71 @@ initialize_port (GstOmxBaseFilter *omx_base)
     GST_INFO_OBJECT (omx_base, "end");
 }
 
+/* A picture nothing is predicted from has slices with nal_ref_idc 0 only.
+ * The NAL units come with start codes, or prefixed by their length when
+ * the caps have avcC codec_data.
+ */
+static gboolean
+is_droppable (GstOmxBaseVideoDec *self,
+              GstBuffer *buf)
+{
+    GstBuffer *codec_data = GST_OMX_BASE_FILTER (self)->codec_data;
+    const guint8 *data = GST_BUFFER_DATA (buf);
+    guint size = GST_BUFFER_SIZE (buf);
+    guint nal_length_size = 0;
+    gboolean has_slice = FALSE;
+    guint i = 0;
+
+    if (codec_data && GST_BUFFER_SIZE (codec_data) > 4 &&
+        GST_BUFFER_DATA (codec_data)[0] == 1)
+        nal_length_size = (GST_BUFFER_DATA (codec_data)[4] & 0x03) + 1;
+
+    while (i < size)
+    {
+        guint8 header;
+        guint8 type;
+
+        if (nal_length_size)
+        {
+            guint nal_size = 0;
+            guint j;
+
+            if (i + nal_length_size >= size)
+                break;
+
+            for (j = 0; j < nal_length_size; j++)
+                nal_size = (nal_size << 8) | data[i++];
+
+            header = data[i];
+            i += nal_size;
+        }
+        else
+        {
+            if (i + 3 >= size)
+                break;
+
+            if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1)
+            {
+                i++;
+                continue;
+            }
+
+            i += 3;
+            header = data[i];
+        }
+
+        type = header & 0x1f;
+        if (type >= 1 && type <= 5)
+        {
+            if (header & 0x60)
+                return FALSE;
+            has_slice = TRUE;
+        }
+    }
+
+    return has_slice;
+}
+
 static void
 type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
@@ -145,4 +210,5 @@ type_instance_init (GTypeInstance *instance,
 
     omx_base->compression_format = OMX_VIDEO_CodingAVC;
     omx_base->initialize_port = initialize_port;
+    omx_base->is_droppable = is_droppable;
 }
@@ -38,11 +38,31 @@ enum
     ARG_I_PERIOD,
     ARG_IDR_PERIOD,
     ARG_FORCE_IDR,
+    ARG_IDR_INTERVAL,
+    ARG_SCENE_CUT_THRESHOLD,
 };
 
 #define DEFAULT_BYTESTREAM FALSE
 #define DEFAULT_PROFILE OMX_VIDEO_AVCProfileHigh
 #define DEFAULT_LEVEL OMX_VIDEO_AVCLevel4
+#define DEFAULT_IDR_INTERVAL 0
+#define DEFAULT_SCENE_CUT_THRESHOLD 0
+
+/* distance between the luma samples compared for scene cut detection */
+#define SCENE_CUT_STEP 8
+
+/* A GstForceKeyUnit event received on either pad */
+typedef struct
+{
+    GstClockTime running_time;  /**< first frame it applies to, or NONE */
+    GstClockTime timestamp;     /**< timestamp of the frame made IDR */
+    gboolean all_headers;
+    guint count;
+} KeyUnitRequest;
+
+static GstFlowReturn pad_chain (GstPad *pad, GstBuffer *buf);
+static gboolean pad_event (GstPad *pad, GstEvent *event);
+static GstFlowReturn push_buffer (GstOmxBaseFilter *omx_base, GstBuffer *buf);
 
 #define GST_TYPE_OMX_VIDEO_AVCPROFILETYPE (gst_omx_video_avcprofiletype_get_type ())
 static GType
@@ -123,9 +143,14 @@ static void
 type_base_init (gpointer g_class)
 {
     GstElementClass *element_class;
+    GstOmxBaseFilterClass *bfilter_class = GST_OMX_BASE_FILTER_CLASS (g_class);
 
     element_class = GST_ELEMENT_CLASS (g_class);
 
+    bfilter_class->pad_chain = pad_chain;
+    bfilter_class->pad_event = pad_event;
+    bfilter_class->push_buffer = push_buffer;
+
     {
         GstElementDetails details;
 
@@ -244,9 +269,17 @@ set_property (GObject *obj,
         }
        case ARG_FORCE_IDR:
         {
+            g_mutex_lock (self->idr_lock);
             self->force_idr = g_value_get_boolean (value);
+            g_mutex_unlock (self->idr_lock);
             break;
         }
+        case ARG_IDR_INTERVAL:
+            self->idr_interval = g_value_get_uint (value);
+            break;
+        case ARG_SCENE_CUT_THRESHOLD:
+            self->scene_cut_threshold = g_value_get_uint (value);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
@@ -337,12 +370,35 @@ get_property (GObject *obj,
             
             break;
         }
+        case ARG_IDR_INTERVAL:
+            g_value_set_uint (value, self->idr_interval);
+            break;
+        case ARG_SCENE_CUT_THRESHOLD:
+            g_value_set_uint (value, self->scene_cut_threshold);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
             break;
     }
 }
 
+static void
+finalize (GObject *obj)
+{
+    GstOmxH264Enc *self;
+
+    self = GST_OMX_H264ENC (obj);
+
+    g_queue_foreach (self->pending_requests, (GFunc) g_free, NULL);
+    g_queue_free (self->pending_requests);
+    g_queue_foreach (self->applied_requests, (GFunc) g_free, NULL);
+    g_queue_free (self->applied_requests);
+    g_mutex_free (self->idr_lock);
+    g_free (self->luma);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
 static void
 type_class_init (gpointer g_class,
                  gpointer class_data)
@@ -351,6 +407,8 @@ type_class_init (gpointer g_class,
 
     gobject_class = G_OBJECT_CLASS (g_class);
 
+    gobject_class->finalize = finalize;
+
     /* Properties stuff */
     {
         gobject_class->set_property = set_property;
@@ -382,52 +440,340 @@ type_class_init (gpointer g_class,
     g_object_class_install_property (gobject_class, ARG_FORCE_IDR,
             g_param_spec_boolean ("force-idr", "force-idr", "force next frame to be IDR",
                     FALSE, G_PARAM_WRITABLE));
+    g_object_class_install_property (gobject_class, ARG_IDR_INTERVAL,
+            g_param_spec_uint ("idr-interval", "Maximum time between IDR frames",
+                    "Maximum time between IDR frames in milliseconds (0:Disable)",
+                    0, G_MAXUINT, DEFAULT_IDR_INTERVAL, G_PARAM_READWRITE));
+    g_object_class_install_property (gobject_class, ARG_SCENE_CUT_THRESHOLD,
+            g_param_spec_uint ("scene-cut-threshold", "Scene cut threshold",
+                    "Mean luma difference with the previous frame which starts "
+                    "a new GOP with an IDR frame (0:Disable)",
+                    0, 255, DEFAULT_SCENE_CUT_THRESHOLD, G_PARAM_READWRITE));
+
+
+    }
+}
+
+/* Ask the component to encode the next frame it gets as an IDR frame */
+static void
+request_idr (GstOmxBaseFilter *omx_base)
+{
+    OMX_CONFIG_INTRAREFRESHVOPTYPE confIntraRefreshVOP;
+    OMX_ERRORTYPE error_val;
+
+    _G_OMX_INIT_PARAM (&confIntraRefreshVOP);
+    confIntraRefreshVOP.nPortIndex = omx_base->out_port->port_index;
+
+    OMX_GetConfig (g_omx_core_get_handle (omx_base->gomx),
+                   OMX_IndexConfigVideoIntraVOPRefresh,
+                   &confIntraRefreshVOP);
+    confIntraRefreshVOP.IntraRefreshVOP = TRUE;
+
+    error_val = OMX_SetConfig (g_omx_core_get_handle (omx_base->gomx),
+                               OMX_IndexConfigVideoIntraVOPRefresh,
+                               &confIntraRefreshVOP);
+
+    if (error_val != OMX_ErrorNone)
+        GST_WARNING_OBJECT (omx_base, "failed to request an IDR frame: %s",
+                            g_omx_error_to_str (error_val));
+}
+
+/* Compare a grid of luma samples of @buf against the ones of the previous
+ * frame, and keep them for the next one.
+ */
+static gboolean
+is_scene_cut (GstOmxH264Enc *self,
+              GstBuffer *buf)
+{
+    GstOmxBaseVideoEnc *videoenc;
+    const guint8 *data;
+    gsize size;
+    guint64 sum = 0;
+    gboolean first = FALSE;
+    gint x, y;
+    guint i = 0;
+
+    videoenc = GST_OMX_BASE_VIDEOENC (self);
+
+    size = (videoenc->width / SCENE_CUT_STEP) * (videoenc->height / SCENE_CUT_STEP);
+    if (size == 0 ||
+        GST_BUFFER_SIZE (buf) < (guint) (videoenc->rowstride * videoenc->height))
+        return FALSE;
+
+    if (size != self->luma_size)
+    {
+        g_free (self->luma);
+        self->luma = g_malloc (size);
+        self->luma_size = size;
+        first = TRUE;
+    }
 
+    for (y = 0; y + SCENE_CUT_STEP <= videoenc->height; y += SCENE_CUT_STEP)
+    {
+        data = GST_BUFFER_DATA (buf) + y * videoenc->rowstride;
 
+        for (x = 0; x + SCENE_CUT_STEP <= videoenc->width; x += SCENE_CUT_STEP)
+        {
+            sum += ABS ((gint) data[x] - (gint) self->luma[i]);
+            self->luma[i++] = data[x];
+        }
     }
+
+    return !first && sum >= (guint64) self->scene_cut_threshold * size;
+}
+
+static KeyUnitRequest *
+parse_force_key_unit (GstEvent *event)
+{
+    const GstStructure *structure;
+    KeyUnitRequest *request;
+
+    structure = gst_event_get_structure (event);
+    if (!structure || !gst_structure_has_name (structure, "GstForceKeyUnit"))
+        return NULL;
+
+    request = g_new0 (KeyUnitRequest, 1);
+    request->running_time = GST_CLOCK_TIME_NONE;
+    request->timestamp = GST_CLOCK_TIME_NONE;
+
+    gst_structure_get_clock_time (structure, "running-time", &request->running_time);
+    gst_structure_get_boolean (structure, "all-headers", &request->all_headers);
+    gst_structure_get_uint (structure, "count", &request->count);
+
+    return request;
 }
 
 static void
-omx_h264_push_cb (GstOmxBaseFilter *omx_base)
+clear_requests (GstOmxH264Enc *self)
+{
+    g_mutex_lock (self->idr_lock);
+    g_queue_foreach (self->pending_requests, (GFunc) g_free, NULL);
+    g_queue_clear (self->pending_requests);
+    g_queue_foreach (self->applied_requests, (GFunc) g_free, NULL);
+    g_queue_clear (self->applied_requests);
+    g_mutex_unlock (self->idr_lock);
+}
+
+/*
+ * Decide whether the frame is to be an IDR frame before it goes to the
+ * component.  The first frame after the component is set up is always one.
+ */
+static GstFlowReturn
+pad_chain (GstPad *pad, GstBuffer *buf)
 {
-    static guint cont;
     GstOmxH264Enc *self;
-    self = GST_OMX_H264ENC (omx_base);
+    GstOmxBaseFilter *omx_base;
+    KeyUnitRequest *request;
+    GstClockTime running_time = GST_CLOCK_TIME_NONE;
+    gboolean first, idr;
+
+    self = GST_OMX_H264ENC (GST_OBJECT_PARENT (pad));
+    omx_base = GST_OMX_BASE_FILTER (self);
+
+    if (GST_BUFFER_TIMESTAMP_IS_VALID (buf))
+        running_time = gst_segment_to_running_time (&self->segment,
+                GST_FORMAT_TIME, GST_BUFFER_TIMESTAMP (buf));
+
+    first = (omx_base->gomx->omx_state == OMX_StateLoaded);
+    idr = first;
+
+    if (!first)
+        self->frames_since_idr++;
+
+    if (self->idr_period > 0 && self->frames_since_idr >= (guint) self->idr_period)
+        idr = TRUE;
+
+    if (self->idr_interval > 0 &&
+        GST_CLOCK_TIME_IS_VALID (running_time) &&
+        GST_CLOCK_TIME_IS_VALID (self->last_idr_time) &&
+        running_time >= self->last_idr_time + self->idr_interval * GST_MSECOND)
+        idr = TRUE;
+
+    if (self->scene_cut_threshold > 0 && is_scene_cut (self, buf))
+    {
+        GST_DEBUG_OBJECT (self, "scene cut at %" GST_TIME_FORMAT,
+                          GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+        idr = TRUE;
+    }
+
+    g_mutex_lock (self->idr_lock);
 
-    /* Currently we use this logic to handle IDR period since the latest
-     * EZSDK version doesn't have support for OMX_IndexConfigVideoAVCIntraPeriod
-	 */
-    if ((self->idr_period > 0) || (self->force_idr))
+    if (self->force_idr)
     {
-        if ((cont == self->idr_period) || (self->force_idr))
+        self->force_idr = FALSE;
+        idr = TRUE;
+    }
+
+    while ((request = g_queue_peek_head (self->pending_requests)))
+    {
+        if (GST_CLOCK_TIME_IS_VALID (request->running_time) &&
+            GST_CLOCK_TIME_IS_VALID (running_time) &&
+            running_time < request->running_time)
+            break;
+
+        g_queue_pop_head (self->pending_requests);
+        request->timestamp = GST_BUFFER_TIMESTAMP (buf);
+        g_queue_push_tail (self->applied_requests, request);
+        idr = TRUE;
+    }
+
+    g_mutex_unlock (self->idr_lock);
+
+    if (idr)
+    {
+        GST_LOG_OBJECT (self, "IDR frame after %u frames", self->frames_since_idr);
+
+        if (!first)
+            request_idr (omx_base);
+
+        self->frames_since_idr = 0;
+        self->last_idr_time = running_time;
+    }
+
+    return parent_class->pad_chain (pad, buf);
+}
+
+static gboolean
+pad_event (GstPad *pad, GstEvent *event)
+{
+    GstOmxH264Enc *self;
+    KeyUnitRequest *request;
+
+    self = GST_OMX_H264ENC (GST_OBJECT_PARENT (pad));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_CUSTOM_DOWNSTREAM:
         {
-            OMX_CONFIG_INTRAREFRESHVOPTYPE confIntraRefreshVOP;
+            request = parse_force_key_unit (event);
+            if (!request)
+                break;
 
-            _G_OMX_INIT_PARAM (&confIntraRefreshVOP);
-            confIntraRefreshVOP.nPortIndex = omx_base->out_port->port_index;
+            /* announced again downstream with the IDR frame */
+            GST_DEBUG_OBJECT (self, "downstream key unit request, count %u",
+                              request->count);
 
-			OMX_GetConfig (g_omx_core_get_handle (omx_base->gomx),
-                              OMX_IndexConfigVideoIntraVOPRefresh,
-                              &confIntraRefreshVOP);
-            confIntraRefreshVOP.IntraRefreshVOP = TRUE;
+            g_mutex_lock (self->idr_lock);
+            g_queue_push_tail (self->pending_requests, request);
+            g_mutex_unlock (self->idr_lock);
 
-			OMX_SetConfig (g_omx_core_get_handle (omx_base->gomx),
-                           OMX_IndexConfigVideoIntraVOPRefresh,
-                           &confIntraRefreshVOP);
+            gst_event_unref (event);
+            return TRUE;
+        }
+        case GST_EVENT_NEWSEGMENT:
+        {
+            gboolean update;
+            gdouble rate, applied_rate;
+            GstFormat format;
+            gint64 start, stop, position;
 
-            if (cont == self->idr_period)
-                cont = 0;
+            gst_event_parse_new_segment_full (event, &update, &rate,
+                    &applied_rate, &format, &start, &stop, &position);
 
-            if (self->force_idr)
+            if (format == GST_FORMAT_TIME)
             {
-                self->force_idr = FALSE;
-                cont++;
+                g_mutex_lock (self->idr_lock);
+                gst_segment_set_newsegment_full (&self->segment, update, rate,
+                        applied_rate, format, start, stop, position);
+                g_mutex_unlock (self->idr_lock);
             }
-        } else {
-            cont++;
-		}
+            break;
+        }
+        case GST_EVENT_FLUSH_STOP:
+            clear_requests (self);
+            g_mutex_lock (self->idr_lock);
+            gst_segment_init (&self->segment, GST_FORMAT_TIME);
+            g_mutex_unlock (self->idr_lock);
+            break;
+        default:
+            break;
+    }
+
+    return parent_class->pad_event (pad, event);
+}
+
+static gboolean
+src_event (GstPad *pad, GstEvent *event)
+{
+    GstOmxH264Enc *self;
+    KeyUnitRequest *request;
+
+    self = GST_OMX_H264ENC (GST_OBJECT_PARENT (pad));
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_UPSTREAM &&
+        (request = parse_force_key_unit (event)))
+    {
+        GST_DEBUG_OBJECT (self, "upstream key unit request at %" GST_TIME_FORMAT
+                          ", count %u", GST_TIME_ARGS (request->running_time),
+                          request->count);
+
+        g_mutex_lock (self->idr_lock);
+        g_queue_push_tail (self->pending_requests, request);
+        g_mutex_unlock (self->idr_lock);
+
+        gst_event_unref (event);
+        return TRUE;
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+/*
+ * Tell downstream about the IDR frames which were asked for with a
+ * GstForceKeyUnit event, right before pushing them.
+ */
+static GstFlowReturn
+push_buffer (GstOmxBaseFilter *omx_base, GstBuffer *buf)
+{
+    GstOmxH264Enc *self;
+    KeyUnitRequest *request;
+    GstStructure *structure = NULL;
+    GstClockTime timestamp;
+
+    self = GST_OMX_H264ENC (omx_base);
+    timestamp = GST_BUFFER_TIMESTAMP (buf);
+
+    if (!(omx_base->out_port->n_flags & OMX_BUFFERFLAG_SYNCFRAME))
+        return parent_class->push_buffer (omx_base, buf);
+
+    g_mutex_lock (self->idr_lock);
+
+    while ((request = g_queue_peek_head (self->applied_requests)))
+    {
+        if (GST_CLOCK_TIME_IS_VALID (timestamp) &&
+            GST_CLOCK_TIME_IS_VALID (request->timestamp) &&
+            timestamp < request->timestamp)
+            break;
+
+        g_queue_pop_head (self->applied_requests);
+
+        if (!structure)
+        {
+            structure = gst_structure_new ("GstForceKeyUnit",
+                    "timestamp", G_TYPE_UINT64, timestamp,
+                    "stream-time", G_TYPE_UINT64,
+                    gst_segment_to_stream_time (&self->segment, GST_FORMAT_TIME, timestamp),
+                    "running-time", G_TYPE_UINT64,
+                    gst_segment_to_running_time (&self->segment, GST_FORMAT_TIME, timestamp),
+                    "all-headers", G_TYPE_BOOLEAN, request->all_headers,
+                    "count", G_TYPE_UINT, request->count,
+                    NULL);
+        }
+        else if (request->all_headers)
+        {
+            gst_structure_set (structure, "all-headers", G_TYPE_BOOLEAN, TRUE, NULL);
+        }
+
+        g_free (request);
     }
 
+    g_mutex_unlock (self->idr_lock);
+
+    if (structure)
+        gst_pad_push_event (omx_base->srcpad,
+                gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM, structure));
+
+    return parent_class->push_buffer (omx_base, buf);
 }
 
 static void
@@ -516,12 +862,20 @@ type_instance_init (GTypeInstance *instance,
 
     omx_base->omx_setup = omx_setup;
 
-    omx_base_filter->push_cb = omx_h264_push_cb;
-
     omx_base->compression_format = OMX_VIDEO_CodingAVC;
 
     omx_base_filter->gomx->settings_changed_cb = settings_changed_cb;
 
+    gst_pad_set_event_function (omx_base_filter->srcpad, src_event);
+
     self->idr_period = 0;
     self->force_idr = FALSE;
+    self->idr_interval = DEFAULT_IDR_INTERVAL;
+    self->scene_cut_threshold = DEFAULT_SCENE_CUT_THRESHOLD;
+
+    gst_segment_init (&self->segment, GST_FORMAT_TIME);
+    self->last_idr_time = GST_CLOCK_TIME_NONE;
+    self->idr_lock = g_mutex_new ();
+    self->pending_requests = g_queue_new ();
+    self->applied_requests = g_queue_new ();
 }
@@ -40,6 +40,23 @@ struct GstOmxH264Enc
     gboolean bytestream;
     gint idr_period;
     gint force_idr;
+    guint idr_interval;         /**< max time between IDR frames, in ms */
+    guint scene_cut_threshold;  /**< mean luma difference of a scene cut */
+
+    /* IDR scheduling, done on the sink pad streaming thread */
+    GstSegment segment;
+    guint frames_since_idr;
+    GstClockTime last_idr_time;     /**< running time of the last IDR */
+    guint8 *luma;                   /**< subsampled luma of the last frame */
+    gsize luma_size;
+
+    /* idr_lock protects force_idr and the GstForceKeyUnit requests which
+     * are still to be applied to an input frame (pending_requests), or
+     * announced downstream with the IDR frame (applied_requests).
+     */
+    GMutex *idr_lock;
+    GQueue *pending_requests;
+    GQueue *applied_requests;
 };
 
 struct GstOmxH264EncClass
@@ -0,0 +1,1173 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Mosaic display sink: one OMX.TI.VPSSM3.VFDC handle showing several streams
+ * side by side.  Each requested sink_%d pad is a window of the VFDC mosaic
+ * layout, fed through its own input port, so the compositing is done by the
+ * display hardware instead of videomixer on the ARM.
+ *
+ * The windows are laid out once every requested pad has received its first
+ * buffer.  Moving a window (the pad's left and top properties) or a caps
+ * change that still fits the port buffers creates a new layout, which the
+ * next buffer switches to; the display keeps running throughout.
+ *
+ * Like omx_videosink with sync=false, buffers are queued to the display as
+ * they arrive and the display paces upstream by returning them at vsync.
+ */
+
+#include "gstomx_mosaicsink.h"
+#include "gstomx_videosink.h"
+#include "gstomx.h"
+#include "gstomx_buffertransport.h"
+
+#include <stdio.h> /* for sscanf */
+#include <string.h> /* for memset */
+
+#include <xdc/std.h>
+#include <OMX_TI_Index.h>
+#include <OMX_TI_Common.h>
+#include <omx_vfdc.h>
+
+#define MAX_WINDOWS \
+    G_N_ELEMENTS (((OMX_PARAM_VFDC_CREATEMOSAICLAYOUT *) NULL)->sMosaicWinFmt)
+
+enum
+{
+    ARG_0,
+    ARG_COMPONENT_ROLE,
+    ARG_COMPONENT_NAME,
+    ARG_LIBRARY_NAME,
+    ARG_DISPLAY_MODE,
+    ARG_NUM_WINDOWS,
+};
+
+enum
+{
+    PAD_ARG_0,
+    PAD_ARG_LEFT,
+    PAD_ARG_TOP,
+    PAD_ARG_WIDTH,
+    PAD_ARG_HEIGHT,
+};
+
+GSTOMX_BOILERPLATE (GstOmxMosaicSink, gst_omx_mosaicsink, GstElement, GST_TYPE_ELEMENT);
+
+G_DEFINE_TYPE (GstOmxMosaicSinkPad, gst_omx_mosaicsink_pad, GST_TYPE_PAD);
+
+static GstStaticPadTemplate sink_template =
+        GST_STATIC_PAD_TEMPLATE ("sink_%d",
+                GST_PAD_SINK,
+                GST_PAD_REQUEST,
+                GST_STATIC_CAPS ("video/x-raw-yuv, "
+                        "format = (fourcc) YUY2, "
+                        "width = (int) [ 16, 4096 ], "
+                        "height = (int) [ 16, 4096 ], "
+                        "framerate = (fraction) [ 0, MAX ]")
+        );
+
+static inline GstOmxMosaicSinkPad *
+get_window (GstOmxMosaicSink *self, guint index)
+{
+    if (index < self->windows->len)
+        return g_ptr_array_index (self->windows, index);
+
+    return NULL;
+}
+
+/*
+ * Window pad
+ */
+
+static void
+pad_set_property (GObject *obj,
+                  guint prop_id,
+                  const GValue *value,
+                  GParamSpec *pspec)
+{
+    GstOmxMosaicSinkPad *pad;
+    GstOmxMosaicSink *self;
+
+    pad = GST_OMX_MOSAICSINK_PAD (obj);
+
+    GST_OBJECT_LOCK (pad);
+
+    switch (prop_id)
+    {
+        case PAD_ARG_LEFT:
+            pad->left = g_value_get_uint (value) & ~1;
+            pad->positioned = TRUE;
+            break;
+        case PAD_ARG_TOP:
+            pad->top = g_value_get_uint (value) & ~1;
+            pad->positioned = TRUE;
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+
+    self = pad->self;
+
+    GST_OBJECT_UNLOCK (pad);
+
+    /* not under the object lock of the pad, which nests in ready_lock */
+    if (self)
+    {
+        g_mutex_lock (self->ready_lock);
+        self->layout_changed = TRUE;
+        g_mutex_unlock (self->ready_lock);
+    }
+}
+
+static void
+pad_get_property (GObject *obj,
+                  guint prop_id,
+                  GValue *value,
+                  GParamSpec *pspec)
+{
+    GstOmxMosaicSinkPad *pad;
+
+    pad = GST_OMX_MOSAICSINK_PAD (obj);
+
+    GST_OBJECT_LOCK (pad);
+
+    switch (prop_id)
+    {
+        case PAD_ARG_LEFT:
+            g_value_set_uint (value, pad->left);
+            break;
+        case PAD_ARG_TOP:
+            g_value_set_uint (value, pad->top);
+            break;
+        case PAD_ARG_WIDTH:
+            g_value_set_int (value, pad->width);
+            break;
+        case PAD_ARG_HEIGHT:
+            g_value_set_int (value, pad->height);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+
+    GST_OBJECT_UNLOCK (pad);
+}
+
+static void
+gst_omx_mosaicsink_pad_class_init (GstOmxMosaicSinkPadClass *klass)
+{
+    GObjectClass *gobject_class;
+
+    gobject_class = G_OBJECT_CLASS (klass);
+
+    gobject_class->set_property = pad_set_property;
+    gobject_class->get_property = pad_get_property;
+
+    g_object_class_install_property (gobject_class, PAD_ARG_LEFT,
+                                     g_param_spec_uint ("left", "Left",
+                                                        "The left most co-ordinate of the window on the display",
+                                                        0, G_MAXUINT, 0, G_PARAM_READWRITE));
+    g_object_class_install_property (gobject_class, PAD_ARG_TOP,
+                                     g_param_spec_uint ("top", "Top",
+                                                        "The top most co-ordinate of the window on the display",
+                                                        0, G_MAXUINT, 0, G_PARAM_READWRITE));
+    g_object_class_install_property (gobject_class, PAD_ARG_WIDTH,
+                                     g_param_spec_int ("width", "Width",
+                                                       "Width of the window, as negotiated",
+                                                       0, G_MAXINT, 0, G_PARAM_READABLE));
+    g_object_class_install_property (gobject_class, PAD_ARG_HEIGHT,
+                                     g_param_spec_int ("height", "Height",
+                                                       "Height of the window, as negotiated",
+                                                       0, G_MAXINT, 0, G_PARAM_READABLE));
+}
+
+static void
+gst_omx_mosaicsink_pad_init (GstOmxMosaicSinkPad *pad)
+{
+}
+
+/*
+ * Layout
+ */
+
+static void
+fill_layout (GstOmxMosaicSink *self,
+             OMX_PARAM_VFDC_CREATEMOSAICLAYOUT *mosaicLayout)
+{
+    gint maxWidth = 0, maxHeight = 0, mode = 0;
+    guint cols, rows;
+    guint i;
+
+    gstomx_videosink_get_display_mode (self->display_mode, &mode, &maxWidth, &maxHeight);
+
+    /* grid for the windows without a position of their own */
+    for (cols = 1; cols * cols < self->windows->len; cols++);
+    rows = (self->windows->len + cols - 1) / cols;
+
+    _G_OMX_INIT_PARAM (mosaicLayout);
+    mosaicLayout->nPortIndex = 0;
+
+    for (i = 0; i < self->windows->len; i++)
+    {
+        GstOmxMosaicSinkPad *pad = get_window (self, i);
+        guint left, top;
+
+        GST_OBJECT_LOCK (pad);
+
+        if (!pad->positioned)
+        {
+            pad->left = ((i % cols) * (maxWidth / cols)) & ~1;
+            pad->top = ((i / cols) * (maxHeight / rows)) & ~1;
+        }
+
+        /* keep the window on the screen, the driver rejects the layout
+         * otherwise */
+        left = MIN (pad->left, (guint) MAX (maxWidth - pad->width, 0) & ~1);
+        top = MIN (pad->top, (guint) MAX (maxHeight - pad->height, 0) & ~1);
+
+        mosaicLayout->sMosaicWinFmt[i].winStartX = left;
+        mosaicLayout->sMosaicWinFmt[i].winStartY = top;
+        mosaicLayout->sMosaicWinFmt[i].winWidth = pad->width;
+        mosaicLayout->sMosaicWinFmt[i].winHeight = pad->height;
+        mosaicLayout->sMosaicWinFmt[i].pitch[VFDC_YUV_INT_ADDR_IDX] = pad->width * 2;
+
+        GST_OBJECT_UNLOCK (pad);
+
+        mosaicLayout->sMosaicWinFmt[i].dataFormat = VFDC_DF_YUV422I_YVYU;
+        mosaicLayout->sMosaicWinFmt[i].bpp = VFDC_BPP_BITS16;
+        mosaicLayout->sMosaicWinFmt[i].priority = 0;
+
+        GST_DEBUG_OBJECT (self, "window %u: %ux%u at %u,%u", i,
+                mosaicLayout->sMosaicWinFmt[i].winWidth,
+                mosaicLayout->sMosaicWinFmt[i].winHeight, left, top);
+    }
+
+    mosaicLayout->nDisChannelNum = 0;
+    mosaicLayout->nNumWindows = self->windows->len;
+}
+
+/* map window i of layout layout_id to input port i */
+static OMX_ERRORTYPE
+select_layout (GstOmxMosaicSink *self,
+               guint layout_id)
+{
+    OMX_CONFIG_VFDC_MOSAICLAYOUT_PORT2WINMAP port2Winmap;
+    guint i;
+
+    _G_OMX_INIT_PARAM (&port2Winmap);
+    port2Winmap.nLayoutId = layout_id;
+    port2Winmap.numWindows = self->windows->len;
+    for (i = 0; i < self->windows->len; i++)
+        port2Winmap.omxPortList[i] = OMX_VFDC_INPUT_PORT_START_INDEX + i;
+
+    return OMX_SetConfig (self->gomx->omx_handle,
+            (OMX_INDEXTYPE) OMX_TI_IndexConfigVFDCMosaicPort2WinMap, &port2Winmap);
+}
+
+/* give the slot of a layout no longer shown back to the driver */
+static void
+delete_layout (GstOmxMosaicSink *self,
+               guint layout_id)
+{
+    OMX_PARAM_VFDC_DELETEMOSAICLAYOUT deleteLayout;
+    OMX_ERRORTYPE err;
+
+    _G_OMX_INIT_PARAM (&deleteLayout);
+    deleteLayout.nPortIndex = 0;
+    deleteLayout.nLayoutId = layout_id;
+
+    err = OMX_SetParameter (self->gomx->omx_handle,
+            (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCDeleteMosaicLayout, &deleteLayout);
+
+    if (err != OMX_ErrorNone)
+        GST_WARNING_OBJECT (self, "failed to delete layout %u: %s", layout_id,
+                g_omx_error_to_str (err));
+}
+
+/*
+ * Called with ready_lock, while the display is running.  The driver only
+ * has a few layout slots, so the layout replaced is deleted straight away,
+ * and at most two of ours exist at any time.
+ */
+static void
+update_layout (GstOmxMosaicSink *self)
+{
+    OMX_PARAM_VFDC_CREATEMOSAICLAYOUT mosaicLayout;
+    OMX_ERRORTYPE err;
+    guint layout_id;
+
+    self->layout_changed = FALSE;
+
+    fill_layout (self, &mosaicLayout);
+
+    err = OMX_SetParameter (self->gomx->omx_handle,
+            (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCCreateMosaicLayout, &mosaicLayout);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_ELEMENT_WARNING (self, RESOURCE, SETTINGS, (NULL),
+                ("failed to create layout: %s, keeping the old one",
+                 g_omx_error_to_str (err)));
+        return;
+    }
+
+    /* as assigned by the driver */
+    layout_id = mosaicLayout.nLayoutId;
+
+    err = select_layout (self, layout_id);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_ELEMENT_WARNING (self, RESOURCE, SETTINGS, (NULL),
+                ("failed to switch layout: %s, keeping the old one",
+                 g_omx_error_to_str (err)));
+        delete_layout (self, layout_id);
+        return;
+    }
+
+    delete_layout (self, self->layout_id);
+    self->layout_id = layout_id;
+
+    GST_INFO_OBJECT (self, "switched to layout %u", self->layout_id);
+}
+
+/* called with ready_lock, once every window has its first buffer */
+static gboolean
+omx_setup (GstOmxMosaicSink *self)
+{
+    GOmxCore *gomx = self->gomx;
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    OMX_PARAM_VFDC_DRIVERINSTID driverId;
+    OMX_PARAM_VFDC_CREATEMOSAICLAYOUT mosaicLayout;
+    OMX_PARAM_BUFFER_MEMORYTYPE memTypeCfg;
+    OMX_ERRORTYPE err;
+    gint maxWidth = 0, maxHeight = 0, mode = 0;
+    guint i;
+
+    GST_LOG_OBJECT (self, "begin");
+
+    /* the VFDC input ports are numbered from 0 without gaps */
+    for (i = 0; i < self->windows->len; i++)
+    {
+        if (!get_window (self, i))
+        {
+            GST_ERROR_OBJECT (self, "sink_%u was not requested, windows must "
+                    "be numbered from 0 without gaps", i);
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < self->windows->len; i++)
+    {
+        GstOmxMosaicSinkPad *pad = get_window (self, i);
+        GOmxPort *in_port;
+
+        in_port = pad->in_port = g_omx_core_get_port (gomx, "in",
+                OMX_VFDC_INPUT_PORT_START_INDEX + i);
+
+        /* set input port definition */
+        G_OMX_PORT_GET_DEFINITION (in_port, &param);
+
+        param.nBufferSize = (pad->width * pad->height * 2);
+        param.format.video.nFrameWidth = pad->width;
+        param.format.video.nFrameHeight = pad->height;
+        param.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
+        param.format.video.eColorFormat = OMX_COLOR_FormatYCbYCr;
+        param.nBufferCountActual = 5;
+
+        /* share the upstream OMX buffers if we can, as GstOmxBaseSink */
+        if (pad->upstream_port)
+        {
+            GOmxPort *port = pad->upstream_port;
+            guint j;
+
+            param.nBufferCountActual = port->num_buffers;
+
+            if (in_port->share_buffer_info)
+            {
+                g_free (in_port->share_buffer_info->pBuffer);
+                g_free (in_port->share_buffer_info);
+            }
+            in_port->share_buffer_info = g_new0 (OmxBufferInfo, 1);
+            in_port->share_buffer_info->num_buffers = port->num_buffers;
+            in_port->share_buffer_info->pBuffer = g_new (OMX_U8 *, port->num_buffers);
+            for (j = 0; j < port->num_buffers; j++)
+                in_port->share_buffer_info->pBuffer[j] = port->buffers[j]->pBuffer;
+
+            in_port->omx_allocate = FALSE;
+            in_port->always_copy = FALSE;
+        }
+        else
+        {
+            in_port->omx_allocate = TRUE;
+            in_port->always_copy = TRUE;
+        }
+        in_port->share_buffer = FALSE;
+
+        G_OMX_PORT_SET_DEFINITION (in_port, &param);
+        g_omx_port_setup (in_port, &param);
+
+        /* set input memory to Raw */
+        _G_OMX_INIT_PARAM (&memTypeCfg);
+        memTypeCfg.nPortIndex = in_port->port_index;
+        memTypeCfg.eBufMemoryType = OMX_BUFFER_MEMORY_DEFAULT;
+
+        OMX_SetParameter (gomx->omx_handle, OMX_TI_IndexParamBuffMemType, &memTypeCfg);
+    }
+
+    /* get the display mode set via property */
+    gstomx_videosink_get_display_mode (self->display_mode, &mode, &maxWidth, &maxHeight);
+
+    /* set display driver mode */
+    _G_OMX_INIT_PARAM (&driverId);
+    driverId.nDrvInstID = 0; /* on chip HDMI */
+    driverId.eDispVencMode = mode;
+
+    OMX_SetParameter (gomx->omx_handle, (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCDriverInstId, &driverId);
+
+    /* set mosaic window information */
+    fill_layout (self, &mosaicLayout);
+
+    err = OMX_SetParameter (gomx->omx_handle,
+            (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCCreateMosaicLayout, &mosaicLayout);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_ERROR_OBJECT (self, "failed to create layout: %s", g_omx_error_to_str (err));
+        return FALSE;
+    }
+
+    /* set port to window mapping */
+    self->layout_id = mosaicLayout.nLayoutId;
+    self->layout_changed = FALSE;
+
+    err = select_layout (self, self->layout_id);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_ERROR_OBJECT (self, "failed to map ports to windows: %s", g_omx_error_to_str (err));
+        return FALSE;
+    }
+
+    /* enable the input ports */
+    for (i = 0; i < self->windows->len; i++)
+    {
+        GstOmxMosaicSinkPad *pad = get_window (self, i);
+
+        OMX_SendCommand (gomx->omx_handle, OMX_CommandPortEnable, pad->in_port->port_index, NULL);
+        g_sem_down (gomx->port_sem);
+    }
+
+    GST_LOG_OBJECT (self, "end");
+
+    return TRUE;
+}
+
+/* called with ready_lock */
+static void
+prepare (GstOmxMosaicSink *self)
+{
+    GOmxCore *gomx = self->gomx;
+
+    GST_INFO_OBJECT (self, "omx: prepare %u windows", self->windows->len);
+
+    if (!omx_setup (self))
+    {
+        self->failed = TRUE;
+        goto leave;
+    }
+
+    g_omx_core_prepare (gomx);
+    g_omx_core_start (gomx);
+
+    if (gomx->omx_state != OMX_StateExecuting)
+    {
+        self->failed = TRUE;
+        goto leave;
+    }
+
+    self->ready = TRUE;
+
+leave:
+    g_cond_broadcast (self->ready_cond);
+}
+
+/*
+ * The layout can only be created for all windows at once, so the first
+ * buffer of each window waits here until every window has one.
+ */
+static gboolean
+wait_for_windows (GstOmxMosaicSink *self,
+                  GstOmxMosaicSinkPad *pad,
+                  GstBuffer *buf)
+{
+    gboolean ready;
+    guint i;
+
+    g_mutex_lock (self->ready_lock);
+
+    if (!pad->have_buffer)
+    {
+        pad->have_buffer = TRUE;
+        pad->upstream_port = GST_IS_OMXBUFFERTRANSPORT (buf) ?
+                GST_GET_OMXPORT (buf) : NULL;
+    }
+
+    if (!self->ready && !self->failed)
+    {
+        gboolean all = TRUE;
+
+        for (i = 0; i < self->windows->len; i++)
+        {
+            GstOmxMosaicSinkPad *other = get_window (self, i);
+            if (other && !other->have_buffer)
+                all = FALSE;
+        }
+
+        if (all)
+            prepare (self);
+        else
+            GST_DEBUG_OBJECT (self, "window %u: waiting for the other windows",
+                    pad->index);
+    }
+
+    while (!self->ready && !self->failed && !self->flushing && !pad->flushing)
+        g_cond_wait (self->ready_cond, self->ready_lock);
+
+    ready = self->ready;
+
+    g_mutex_unlock (self->ready_lock);
+
+    return ready;
+}
+
+static GstFlowReturn
+pad_chain (GstPad *gst_pad,
+           GstBuffer *buf)
+{
+    GstOmxMosaicSinkPad *pad;
+    GstOmxMosaicSink *self;
+    GOmxCore *gomx;
+    GOmxPort *in_port;
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    pad = GST_OMX_MOSAICSINK_PAD (gst_pad);
+    self = pad->self;
+    gomx = self->gomx;
+
+    GST_LOG_OBJECT (self, "begin: window %u, size=%u", pad->index, GST_BUFFER_SIZE (buf));
+
+    if (G_UNLIKELY (!self->ready))
+    {
+        if (!wait_for_windows (self, pad, buf))
+        {
+            if (self->failed)
+            {
+                GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                        ("Failed to configure OpenMAX component"));
+                ret = GST_FLOW_ERROR;
+            }
+            else
+            {
+                ret = GST_FLOW_WRONG_STATE;
+            }
+
+            gst_buffer_unref (buf);
+            goto leave;
+        }
+    }
+
+    g_mutex_lock (self->ready_lock);
+    if (G_UNLIKELY (self->layout_changed) && self->ready)
+        update_layout (self);
+    g_mutex_unlock (self->ready_lock);
+
+    in_port = pad->in_port;
+
+    if (G_LIKELY (in_port->enabled))
+    {
+        while (TRUE)
+        {
+            gint sent = g_omx_port_send (in_port, buf);
+
+            if (G_UNLIKELY (sent < 0))
+            {
+                ret = GST_FLOW_WRONG_STATE;
+                break;
+            }
+            else if (sent < GST_BUFFER_SIZE (buf))
+            {
+                GstBuffer *subbuf = gst_buffer_create_sub (buf, sent,
+                        GST_BUFFER_SIZE (buf) - sent);
+                gst_buffer_unref (buf);
+                buf = subbuf;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+    else
+    {
+        GST_WARNING_OBJECT (self, "window %u: done", pad->index);
+        ret = GST_FLOW_UNEXPECTED;
+    }
+
+    gst_buffer_unref (buf);
+
+    if (gomx->omx_error != OMX_ErrorNone)
+    {
+        GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL),
+                ("Error from OpenMAX component"));
+        ret = GST_FLOW_ERROR;
+    }
+
+leave:
+    GST_LOG_OBJECT (self, "end");
+
+    return ret;
+}
+
+static gboolean
+pad_event (GstPad *gst_pad,
+           GstEvent *event)
+{
+    GstOmxMosaicSinkPad *pad;
+    GstOmxMosaicSink *self;
+
+    pad = GST_OMX_MOSAICSINK_PAD (gst_pad);
+    self = pad->self;
+
+    GST_DEBUG_OBJECT (self, "window %u: event: %s", pad->index,
+            GST_EVENT_TYPE_NAME (event));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_EOS:
+            {
+                gboolean all = TRUE;
+                guint i;
+
+                /* we are done once every window is */
+                g_mutex_lock (self->ready_lock);
+                pad->eos = TRUE;
+                for (i = 0; i < self->windows->len; i++)
+                {
+                    GstOmxMosaicSinkPad *other = get_window (self, i);
+                    if (other && !other->eos)
+                        all = FALSE;
+                }
+                g_mutex_unlock (self->ready_lock);
+
+                if (all)
+                {
+                    gst_element_post_message (GST_ELEMENT (self),
+                            gst_message_new_eos (GST_OBJECT (self)));
+                }
+            }
+            break;
+
+        case GST_EVENT_FLUSH_START:
+            /* also wakes up this window if it waits for the other ones */
+            g_mutex_lock (self->ready_lock);
+            pad->flushing = TRUE;
+            g_cond_broadcast (self->ready_cond);
+            g_mutex_unlock (self->ready_lock);
+
+            /* unlock loops */
+            if (self->ready)
+                g_omx_port_pause (pad->in_port);
+            break;
+
+        case GST_EVENT_FLUSH_STOP:
+            g_mutex_lock (self->ready_lock);
+            pad->flushing = FALSE;
+            pad->eos = FALSE;
+            g_mutex_unlock (self->ready_lock);
+
+            if (self->ready)
+            {
+                g_omx_port_flush (pad->in_port);
+                g_omx_port_resume (pad->in_port);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    gst_event_unref (event);
+
+    return TRUE;
+}
+
+static gboolean
+pad_setcaps (GstPad *gst_pad,
+             GstCaps *caps)
+{
+    GstOmxMosaicSinkPad *pad;
+    GstOmxMosaicSink *self;
+    GstStructure *structure;
+    gint width, height;
+
+    pad = GST_OMX_MOSAICSINK_PAD (gst_pad);
+    self = pad->self;
+
+    GST_INFO_OBJECT (self, "setcaps (sink_%u): %" GST_PTR_FORMAT, pad->index, caps);
+
+    g_return_val_if_fail (gst_caps_get_size (caps) == 1, FALSE);
+
+    structure = gst_caps_get_structure (caps, 0);
+
+    if (!(gst_structure_get_int (structure, "width", &width) &&
+          gst_structure_get_int (structure, "height", &height)))
+    {
+        GST_WARNING_OBJECT (self, "width and/or height is not set in caps");
+        return FALSE;
+    }
+
+    g_mutex_lock (self->ready_lock);
+
+    /* once running, a new size has to fit in the buffers of the port */
+    if (self->ready && (width != pad->width || height != pad->height))
+    {
+        OMX_PARAM_PORTDEFINITIONTYPE param;
+
+        G_OMX_PORT_GET_DEFINITION (pad->in_port, &param);
+
+        if (width * height * 2 > param.nBufferSize)
+        {
+            GST_WARNING_OBJECT (self, "window %u: %dx%d does not fit the %u byte "
+                    "port buffers", pad->index, width, height, (guint) param.nBufferSize);
+            g_mutex_unlock (self->ready_lock);
+            return FALSE;
+        }
+
+        self->layout_changed = TRUE;
+    }
+
+    GST_OBJECT_LOCK (pad);
+    pad->width = width;
+    pad->height = height;
+    GST_OBJECT_UNLOCK (pad);
+
+    g_mutex_unlock (self->ready_lock);
+
+    return TRUE;
+}
+
+/*
+ * Element
+ */
+
+static GstPad *
+request_new_pad (GstElement *element,
+                 GstPadTemplate *templ,
+                 const gchar *name)
+{
+    GstOmxMosaicSink *self;
+    GstOmxMosaicSinkPad *pad;
+    guint index;
+    gchar *pad_name;
+
+    self = GST_OMX_MOSAICSINK (element);
+
+    g_mutex_lock (self->ready_lock);
+
+    if (self->ready)
+    {
+        GST_WARNING_OBJECT (self, "cannot add a window to a running display");
+        goto fail;
+    }
+
+    if (name)
+    {
+        if (sscanf (name, "sink_%u", &index) != 1)
+        {
+            GST_WARNING_OBJECT (self, "invalid pad name %s", name);
+            goto fail;
+        }
+    }
+    else
+    {
+        /* first free window */
+        for (index = 0; get_window (self, index); index++);
+    }
+
+    if (index >= MAX_WINDOWS || get_window (self, index))
+    {
+        GST_WARNING_OBJECT (self, "window %u is not available", index);
+        goto fail;
+    }
+
+    pad_name = g_strdup_printf ("sink_%u", index);
+    pad = g_object_new (GST_OMX_MOSAICSINK_PAD_TYPE,
+            "name", pad_name, "direction", GST_PAD_SINK, "template", templ, NULL);
+    g_free (pad_name);
+
+    pad->self = self;
+    pad->index = index;
+
+    gst_pad_set_chain_function (GST_PAD (pad), GST_DEBUG_FUNCPTR (pad_chain));
+    gst_pad_set_event_function (GST_PAD (pad), GST_DEBUG_FUNCPTR (pad_event));
+    gst_pad_set_setcaps_function (GST_PAD (pad), GST_DEBUG_FUNCPTR (pad_setcaps));
+
+    if (index >= self->windows->len)
+        g_ptr_array_set_size (self->windows, index + 1);
+    g_ptr_array_index (self->windows, index) = pad;
+
+    g_mutex_unlock (self->ready_lock);
+
+    GST_INFO_OBJECT (self, "added window %u", index);
+
+    if (GST_STATE (element) > GST_STATE_READY)
+        gst_pad_set_active (GST_PAD (pad), TRUE);
+
+    gst_element_add_pad (element, GST_PAD (pad));
+
+    return GST_PAD (pad);
+
+fail:
+    g_mutex_unlock (self->ready_lock);
+    return NULL;
+}
+
+static void
+release_pad (GstElement *element,
+             GstPad *gst_pad)
+{
+    GstOmxMosaicSink *self;
+    GstOmxMosaicSinkPad *pad;
+
+    self = GST_OMX_MOSAICSINK (element);
+    pad = GST_OMX_MOSAICSINK_PAD (gst_pad);
+
+    g_mutex_lock (self->ready_lock);
+
+    if (self->ready)
+    {
+        GST_WARNING_OBJECT (self, "cannot remove a window from a running display");
+        g_mutex_unlock (self->ready_lock);
+        return;
+    }
+
+    g_ptr_array_index (self->windows, pad->index) = NULL;
+    while (self->windows->len && !get_window (self, self->windows->len - 1))
+        g_ptr_array_set_size (self->windows, self->windows->len - 1);
+
+    g_mutex_unlock (self->ready_lock);
+
+    GST_INFO_OBJECT (self, "removed window %u", pad->index);
+
+    pad->self = NULL;
+    gst_element_remove_pad (element, gst_pad);
+}
+
+static GstStateChangeReturn
+change_state (GstElement *element,
+              GstStateChange transition)
+{
+    GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+    GstOmxMosaicSink *self;
+    GOmxCore *core;
+    guint i;
+
+    self = GST_OMX_MOSAICSINK (element);
+    core = self->gomx;
+
+    GST_INFO_OBJECT (self, "begin: changing state %s -> %s",
+                     gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (transition)),
+                     gst_element_state_get_name (GST_STATE_TRANSITION_NEXT (transition)));
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_NULL_TO_READY:
+            g_omx_core_init (core);
+            if (core->omx_state != OMX_StateLoaded)
+            {
+                ret = GST_STATE_CHANGE_FAILURE;
+                goto leave;
+            }
+            break;
+
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            g_mutex_lock (self->ready_lock);
+            self->flushing = FALSE;
+            self->failed = FALSE;
+            for (i = 0; i < self->windows->len; i++)
+            {
+                GstOmxMosaicSinkPad *pad = get_window (self, i);
+                if (pad)
+                    pad->flushing = FALSE;
+            }
+            g_mutex_unlock (self->ready_lock);
+            break;
+
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            /* release chains waiting for the other windows */
+            g_mutex_lock (self->ready_lock);
+            self->flushing = TRUE;
+            g_cond_broadcast (self->ready_cond);
+            g_mutex_unlock (self->ready_lock);
+
+            /* unlock chains waiting for a free buffer */
+            if (self->ready)
+            {
+                for (i = 0; i < self->windows->len; i++)
+                    g_omx_port_finish (get_window (self, i)->in_port);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+    if (ret == GST_STATE_CHANGE_FAILURE)
+        goto leave;
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            g_mutex_lock (self->ready_lock);
+            if (self->ready)
+            {
+                g_omx_core_stop (core);
+                g_omx_core_unload (core);
+                self->ready = FALSE;
+            }
+            for (i = 0; i < self->windows->len; i++)
+            {
+                GstOmxMosaicSinkPad *pad = get_window (self, i);
+                if (pad)
+                {
+                    pad->have_buffer = FALSE;
+                    pad->upstream_port = NULL;
+                    pad->eos = FALSE;
+                }
+            }
+            g_mutex_unlock (self->ready_lock);
+            if (core->omx_state != OMX_StateLoaded &&
+                core->omx_state != OMX_StateInvalid)
+            {
+                ret = GST_STATE_CHANGE_FAILURE;
+                goto leave;
+            }
+            break;
+
+        case GST_STATE_CHANGE_READY_TO_NULL:
+            g_omx_core_deinit (core);
+            break;
+
+        default:
+            break;
+    }
+
+leave:
+    GST_LOG_OBJECT (self, "end");
+
+    return ret;
+}
+
+static void
+finalize (GObject *obj)
+{
+    GstOmxMosaicSink *self;
+
+    self = GST_OMX_MOSAICSINK (obj);
+
+    g_omx_core_free (self->gomx);
+
+    /* the pads themselves are owned by the element */
+    g_ptr_array_free (self->windows, TRUE);
+
+    g_free (self->omx_role);
+    g_free (self->omx_component);
+    g_free (self->omx_library);
+    g_free (self->display_mode);
+
+    g_cond_free (self->ready_cond);
+    g_mutex_free (self->ready_lock);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMosaicSink *self;
+
+    self = GST_OMX_MOSAICSINK (obj);
+
+    switch (prop_id)
+    {
+        case ARG_COMPONENT_ROLE:
+            g_free (self->omx_role);
+            self->omx_role = g_value_dup_string (value);
+            break;
+        case ARG_COMPONENT_NAME:
+            g_free (self->omx_component);
+            self->omx_component = g_value_dup_string (value);
+            break;
+        case ARG_LIBRARY_NAME:
+            g_free (self->omx_library);
+            self->omx_library = g_value_dup_string (value);
+            break;
+        case ARG_DISPLAY_MODE:
+            g_free (self->display_mode);
+            self->display_mode = g_value_dup_string (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMosaicSink *self;
+
+    self = GST_OMX_MOSAICSINK (obj);
+
+    switch (prop_id)
+    {
+        case ARG_COMPONENT_ROLE:
+            g_value_set_string (value, self->omx_role);
+            break;
+        case ARG_COMPONENT_NAME:
+            g_value_set_string (value, self->omx_component);
+            break;
+        case ARG_LIBRARY_NAME:
+            g_value_set_string (value, self->omx_library);
+            break;
+        case ARG_DISPLAY_MODE:
+            g_value_set_string (value, self->display_mode);
+            break;
+        case ARG_NUM_WINDOWS:
+            g_mutex_lock (self->ready_lock);
+            g_value_set_uint (value, self->windows->len);
+            g_mutex_unlock (self->ready_lock);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+type_base_init (gpointer g_class)
+{
+    GstElementClass *element_class;
+
+    element_class = GST_ELEMENT_CLASS (g_class);
+
+    {
+        GstElementDetails details;
+
+        details.longname = "OpenMAX IL mosaic videosink element";
+        details.klass = "Video/Sink";
+        details.description = "Renders several videos in windows of one display";
+        details.author = "Texas Instruments";
+
+        gst_element_class_set_details (element_class, &details);
+    }
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&sink_template));
+}
+
+static void
+type_class_init (gpointer g_class,
+                 gpointer class_data)
+{
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+    gstelement_class = GST_ELEMENT_CLASS (g_class);
+
+    gobject_class->finalize = finalize;
+    gstelement_class->change_state = change_state;
+    gstelement_class->request_new_pad = request_new_pad;
+    gstelement_class->release_pad = release_pad;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_COMPONENT_ROLE,
+                                         g_param_spec_string ("component-role", "Component role",
+                                                              "Role of the OpenMAX IL component",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_COMPONENT_NAME,
+                                         g_param_spec_string ("component-name", "Component name",
+                                                              "Name of the OpenMAX IL component to use",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_LIBRARY_NAME,
+                                         g_param_spec_string ("library-name", "Library name",
+                                                              "Name of the OpenMAX IL implementation library to use",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_DISPLAY_MODE,
+                                         g_param_spec_string ("display-mode", "Display mode",
+                                                              "Display driver configuration mode, as omx_videosink",
+                                                              "OMX_DC_MODE_1080P_60", G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_NUM_WINDOWS,
+                                         g_param_spec_uint ("num-windows", "Number of windows",
+                                                            "Number of windows in the mosaic",
+                                                            0, MAX_WINDOWS, 0, G_PARAM_READABLE));
+    }
+}
+
+static void
+type_instance_init (GTypeInstance *instance,
+                    gpointer g_class)
+{
+    GstOmxMosaicSink *self;
+
+    self = GST_OMX_MOSAICSINK (instance);
+
+    GST_LOG_OBJECT (self, "begin");
+
+    GST_OBJECT_FLAG_SET (self, GST_ELEMENT_IS_SINK);
+
+    self->windows = g_ptr_array_new ();
+    self->ready_lock = g_mutex_new ();
+    self->ready_cond = g_cond_new ();
+    self->display_mode = g_strdup ("OMX_DC_MODE_1080P_60");
+
+    /* GOmx; the ports are created once the windows are known */
+    self->gomx = g_omx_core_new (self, g_class);
+
+    GST_LOG_OBJECT (self, "end");
+}
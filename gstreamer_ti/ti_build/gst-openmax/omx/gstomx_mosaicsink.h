@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_MOSAICSINK_H
+#define GSTOMX_MOSAICSINK_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_OMX_MOSAICSINK(obj) (GstOmxMosaicSink *) (obj)
+#define GST_OMX_MOSAICSINK_TYPE (gst_omx_mosaicsink_get_type ())
+
+#define GST_OMX_MOSAICSINK_PAD(obj) (GstOmxMosaicSinkPad *) (obj)
+#define GST_OMX_MOSAICSINK_PAD_TYPE (gst_omx_mosaicsink_pad_get_type ())
+
+typedef struct GstOmxMosaicSink GstOmxMosaicSink;
+typedef struct GstOmxMosaicSinkClass GstOmxMosaicSinkClass;
+typedef struct GstOmxMosaicSinkPad GstOmxMosaicSinkPad;
+typedef struct GstOmxMosaicSinkPadClass GstOmxMosaicSinkPadClass;
+
+#include "gstomx_util.h"
+
+/**
+ * One mosaic window: a sink_%d pad feeding VFDC input port
+ * OMX_VFDC_INPUT_PORT_START_INDEX + index.  The window has the size of the
+ * incoming frames; left and top may be changed at any time.  Until either
+ * is set the window is placed in a grid cell by its index.
+ */
+struct GstOmxMosaicSinkPad
+{
+    GstPad pad;
+
+    GstOmxMosaicSink *self;
+    guint index;
+
+    GOmxPort *in_port;
+
+    /* protected by the object lock of the pad */
+    guint left, top;
+    gboolean positioned;
+    gint width, height;
+
+    /* protected by the ready_lock of the element */
+    gboolean have_buffer;
+    GOmxPort *upstream_port;
+    gboolean eos;
+    gboolean flushing;
+};
+
+struct GstOmxMosaicSinkPadClass
+{
+    GstPadClass parent_class;
+};
+
+struct GstOmxMosaicSink
+{
+    GstElement element;
+
+    GOmxCore *gomx;
+
+    /** GstOmxMosaicSinkPad, indexed by window number */
+    GPtrArray *windows;
+
+    char *omx_role;
+    char *omx_component;
+    char *omx_library;
+    gchar *display_mode;
+
+    /** protects windows, ready, flushing, failed, layout_changed and the
+     * window state of the pads */
+    GMutex *ready_lock;
+    GCond *ready_cond;
+    gboolean ready;
+    gboolean flushing;       /**< going to READY, a pad flushes on its own */
+    gboolean failed;
+
+    /** a window moved or changed size: the next buffer switches layout */
+    gboolean layout_changed;
+    /** the layout shown, as numbered by the driver */
+    guint layout_id;
+};
+
+struct GstOmxMosaicSinkClass
+{
+    GstElementClass parent_class;
+};
+
+GType gst_omx_mosaicsink_get_type (void);
+GType gst_omx_mosaicsink_pad_get_type (void);
+
+G_END_DECLS
+
+#endif /* GSTOMX_MOSAICSINK_H */
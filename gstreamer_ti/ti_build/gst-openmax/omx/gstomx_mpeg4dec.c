@@ -105,6 +105,33 @@ type_class_init (gpointer g_class,
 {
 }
 
+/* B-VOPs are never used for prediction.  A packed buffer holds a P-VOP and
+ * a B-VOP, so every VOP in the buffer has to be a B-VOP.
+ */
+static gboolean
+is_droppable (GstOmxBaseVideoDec *self,
+              GstBuffer *buf)
+{
+    const guint8 *data = GST_BUFFER_DATA (buf);
+    guint size = GST_BUFFER_SIZE (buf);
+    gboolean has_vop = FALSE;
+    guint i;
+
+    for (i = 0; i + 4 < size; i++)
+    {
+        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1 &&
+            data[i + 3] == 0xb6)
+        {
+            /* vop_coding_type */
+            if ((data[i + 4] >> 6) != 2)
+                return FALSE;
+            has_vop = TRUE;
+        }
+    }
+
+    return has_vop;
+}
+
 static void
 type_instance_init (GTypeInstance *instance,
                     gpointer g_class)
@@ -114,4 +141,5 @@ type_instance_init (GTypeInstance *instance,
     omx_base = GST_OMX_BASE_VIDEODEC (instance);
 
     omx_base->compression_format = OMX_VIDEO_CodingMPEG4;
+    omx_base->is_droppable = is_droppable;
 }
@@ -0,0 +1,1494 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Multi-channel scaler: one OMX.TI.VPSSM3.VFPC.INDTXSCWB handle serving
+ * several streams.  Each requested sink_%d pad gets a matching src_%d pad,
+ * and a VFPC channel with its own input and output resolution.  The component
+ * is configured and moved to Idle once every requested channel has received
+ * its first buffer, ended, or been released, so all channels must be
+ * requested before data flows.  The channels it starts with are given VFPC
+ * channel ids from 0, in the order of their pads.
+ */
+
+#include "gstomx_mscaler.h"
+#include "gstomx.h"
+#include "gstomx_buffertransport.h"
+
+#include <OMX_TI_Index.h>
+#include <OMX_TI_Common.h>
+#include <omx_vfpc.h>
+
+#include <stdio.h> /* for sscanf */
+#include <string.h> /* for memset */
+
+#define MAX_CHANNELS (OMX_VFPC_OUTPUT_PORT_START_INDEX - OMX_VFPC_INPUT_PORT_START_INDEX)
+
+#define DEFAULT_OUTPUT_BUFFERS 8
+#define DEFAULT_EOS_TIMEOUT 1000
+
+enum
+{
+    ARG_0,
+    ARG_COMPONENT_ROLE,
+    ARG_COMPONENT_NAME,
+    ARG_LIBRARY_NAME,
+    ARG_NUM_CHANNELS,
+    ARG_NUM_OUTPUT_BUFFERS,
+    ARG_OUTPUT_MEMORY,
+    ARG_EOS_TIMEOUT,
+};
+
+GSTOMX_BOILERPLATE (GstOmxMScaler, gst_omx_mscaler, GstElement, GST_TYPE_ELEMENT);
+
+static GstStaticPadTemplate sink_template =
+        GST_STATIC_PAD_TEMPLATE ("sink_%d",
+                GST_PAD_SINK,
+                GST_PAD_REQUEST,
+                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV_STRIDED (
+                        "{NV12}", "[ 0, max ]"))
+        );
+
+static GstStaticPadTemplate src_template =
+        GST_STATIC_PAD_TEMPLATE ("src_%d",
+                GST_PAD_SRC,
+                GST_PAD_SOMETIMES,
+                GST_STATIC_CAPS (GST_VIDEO_CAPS_YUV ( "{YUY2}" ))
+        );
+
+static inline GstOmxMScalerChannel *
+get_channel (GstOmxMScaler *self, guint index)
+{
+    if (index < self->channels->len)
+        return g_ptr_array_index (self->channels, index);
+
+    return NULL;
+}
+
+static gint
+gstomx_calculate_stride (int width, GstVideoFormat format)
+{
+    switch (format)
+    {
+        case GST_VIDEO_FORMAT_NV12:
+            return width;
+        case GST_VIDEO_FORMAT_YUY2:
+            return width * 2;
+        default:
+            GST_ERROR ("unsupported color format");
+    }
+    return -1;
+}
+
+static GstCaps *
+create_src_caps (GstOmxMScalerChannel *ch)
+{
+    GstCaps *caps;
+    GstStructure *struc;
+    int width, height;
+
+    width = ch->in_width;
+    height = ch->in_height;
+
+    caps = gst_pad_peer_get_caps (ch->srcpad);
+
+    if (caps && !gst_caps_is_empty (caps))
+    {
+        GstStructure *s;
+
+        s = gst_caps_get_structure (caps, 0);
+
+        if (!(gst_structure_get_int (s, "width", &width) &&
+            gst_structure_get_int (s, "height", &height)))
+        {
+            width = ch->in_width;
+            height = ch->in_height;
+        }
+    }
+
+    if (caps)
+        gst_caps_unref (caps);
+
+    caps = gst_caps_new_empty ();
+    struc = gst_structure_new (("video/x-raw-yuv"),
+            "width",  G_TYPE_INT, width,
+            "height", G_TYPE_INT, height,
+            "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('Y', 'U', 'Y', '2'),
+            NULL);
+
+    if (ch->framerate_denom)
+    {
+        gst_structure_set (struc,
+        "framerate", GST_TYPE_FRACTION, ch->framerate_num, ch->framerate_denom, NULL);
+    }
+
+    gst_caps_append_structure (caps, struc);
+
+    ch->out_width = width;
+    ch->out_height = height;
+    ch->out_stride = gstomx_calculate_stride (width, GST_VIDEO_FORMAT_YUY2);
+
+    return caps;
+}
+
+/* same as GstOmxBaseFilter: share the upstream OMX buffers if we can */
+static void
+setup_input_buffer (GstOmxMScalerChannel *ch)
+{
+    GOmxPort *in_port = ch->in_port;
+    GOmxPort *port = ch->upstream_port;
+
+    if (port)
+    {
+        OMX_PARAM_PORTDEFINITIONTYPE param;
+        guint i;
+
+        G_OMX_PORT_GET_DEFINITION (in_port, &param);
+        param.nBufferCountActual = port->num_buffers;
+        G_OMX_PORT_SET_DEFINITION (in_port, &param);
+
+        if (in_port->share_buffer_info)
+        {
+            g_free (in_port->share_buffer_info->pBuffer);
+            g_free (in_port->share_buffer_info);
+        }
+
+        in_port->share_buffer_info = g_new (OmxBufferInfo, 1);
+        in_port->share_buffer_info->num_buffers = port->num_buffers;
+        in_port->share_buffer_info->pBuffer = g_new (OMX_U8 *, port->num_buffers);
+        for (i = 0; i < port->num_buffers; i++)
+            in_port->share_buffer_info->pBuffer[i] = port->buffers[i]->pBuffer;
+
+        in_port->omx_allocate = FALSE;
+        in_port->always_copy = FALSE;
+    }
+    else
+    {
+        in_port->omx_allocate = TRUE;
+        in_port->always_copy = TRUE;
+    }
+}
+
+static gboolean
+set_channel_resolution (GstOmxMScaler *self,
+                        GstOmxMScalerChannel *ch,
+                        OMX_DIRTYPE dir)
+{
+    OMX_CONFIG_VIDCHANNEL_RESOLUTION chResolution;
+    OMX_ERRORTYPE err;
+
+    _G_OMX_INIT_PARAM (&chResolution);
+    if (dir == OMX_DirInput)
+    {
+        chResolution.Frm0Width = ch->in_width;
+        chResolution.Frm0Height = ch->in_height;
+        chResolution.Frm0Pitch = ch->in_stride;
+    }
+    else
+    {
+        chResolution.Frm0Width = ch->out_width;
+        chResolution.Frm0Height = ch->out_height;
+        chResolution.Frm0Pitch = ch->out_stride;
+    }
+    chResolution.Frm1Width = 0;
+    chResolution.Frm1Height = 0;
+    chResolution.Frm1Pitch = 0;
+    chResolution.FrmStartX = 0;
+    chResolution.FrmStartY = 0;
+    chResolution.FrmCropWidth = 0;
+    chResolution.FrmCropHeight = 0;
+    chResolution.eDir = dir;
+    chResolution.nChId = ch->id;
+    err = OMX_SetConfig (self->gomx->omx_handle,
+            OMX_TI_IndexConfigVidChResolution, &chResolution);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_ERROR_OBJECT (self, "channel %u: failed to set %s resolution: %s",
+                ch->index, dir == OMX_DirInput ? "input" : "output",
+                g_omx_error_to_str (err));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+setup_channel_ports (GstOmxMScaler *self,
+                     GstOmxMScalerChannel *ch)
+{
+    GOmxCore *gomx = self->gomx;
+    OMX_PARAM_PORTDEFINITIONTYPE paramPort;
+    OMX_PARAM_BUFFER_MEMORYTYPE memTypeCfg;
+    GstCaps *caps;
+    OMX_ERRORTYPE err;
+
+    ch->in_port = g_omx_core_get_port (gomx, "in",
+            OMX_VFPC_INPUT_PORT_START_INDEX + ch->id);
+    ch->out_port = g_omx_core_get_port (gomx, "out",
+            OMX_VFPC_OUTPUT_PORT_START_INDEX + ch->id);
+
+    ch->in_port->omx_allocate = TRUE;
+    ch->in_port->share_buffer = FALSE;
+    ch->in_port->always_copy  = FALSE;
+
+    ch->out_port->omx_allocate = TRUE;
+    ch->out_port->share_buffer = FALSE;
+    ch->out_port->always_copy = FALSE;
+    G_OMX_PORT_SET_BUFFER_COUNT (ch->out_port, self->output_buffers);
+
+    /* set the output cap */
+    caps = create_src_caps (ch);
+    gst_pad_set_caps (ch->srcpad, caps);
+
+    /* save the src caps later needed by omx transport buffer */
+    if (ch->out_port->caps)
+        gst_caps_unref (ch->out_port->caps);
+    ch->out_port->caps = caps;
+
+    /* Setting Memory type at input and output port to Raw Memory */
+    GST_LOG_OBJECT (self, "channel %u: setting ports to Raw memory", ch->index);
+
+    _G_OMX_INIT_PARAM (&memTypeCfg);
+    memTypeCfg.nPortIndex = ch->in_port->port_index;
+    memTypeCfg.eBufMemoryType = OMX_BUFFER_MEMORY_DEFAULT;
+    err = OMX_SetParameter (gomx->omx_handle, OMX_TI_IndexParamBuffMemType, &memTypeCfg);
+
+    if (err != OMX_ErrorNone)
+        goto fail;
+
+    _G_OMX_INIT_PARAM (&memTypeCfg);
+    memTypeCfg.nPortIndex = ch->out_port->port_index;
+    memTypeCfg.eBufMemoryType = OMX_BUFFER_MEMORY_DEFAULT;
+    err = OMX_SetParameter (gomx->omx_handle, OMX_TI_IndexParamBuffMemType, &memTypeCfg);
+
+    if (err != OMX_ErrorNone)
+        goto fail;
+
+    /* Input port configuration. */
+    GST_LOG_OBJECT (self, "channel %u: setting port definition (input)", ch->index);
+
+    G_OMX_PORT_GET_DEFINITION (ch->in_port, &paramPort);
+    paramPort.format.video.nFrameWidth = ch->in_width;
+    paramPort.format.video.nFrameHeight = ch->in_height;
+    paramPort.format.video.nStride = ch->in_stride;
+    paramPort.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
+    paramPort.format.video.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
+    paramPort.nBufferSize =  ch->in_stride * ch->in_height * 1.5;
+    paramPort.nBufferAlignment = 0;
+    paramPort.bBuffersContiguous = 0;
+    G_OMX_PORT_SET_DEFINITION (ch->in_port, &paramPort);
+
+    setup_input_buffer (ch);
+
+    G_OMX_PORT_GET_DEFINITION (ch->in_port, &paramPort);
+    g_omx_port_setup (ch->in_port, &paramPort);
+
+    /* Output port configuration. */
+    GST_LOG_OBJECT (self, "channel %u: setting port definition (output)", ch->index);
+
+    G_OMX_PORT_GET_DEFINITION (ch->out_port, &paramPort);
+    paramPort.format.video.nFrameWidth = ch->out_width;
+    paramPort.format.video.nFrameHeight = ch->out_height;
+    paramPort.format.video.nStride = ch->out_stride;
+    paramPort.format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
+    paramPort.format.video.eColorFormat = OMX_COLOR_FormatYCbYCr;
+    paramPort.nBufferSize =  ch->out_stride * ch->out_height;
+    paramPort.nBufferCountActual = DEFAULT_OUTPUT_BUFFERS;
+    paramPort.nBufferAlignment = 0;
+    paramPort.bBuffersContiguous = 0;
+    G_OMX_PORT_SET_DEFINITION (ch->out_port, &paramPort);
+    g_omx_port_setup (ch->out_port, &paramPort);
+
+    return TRUE;
+
+fail:
+    GST_ERROR_OBJECT (self, "channel %u: failed to configure ports: %s",
+            ch->index, g_omx_error_to_str (err));
+    return FALSE;
+}
+
+/* the channels the component is configured with: those which got a buffer */
+static inline gboolean
+channel_starts (GstOmxMScalerChannel *ch)
+{
+    return ch && ch->have_buffer;
+}
+
+/* called with ready_lock, once every channel has its first buffer or ended */
+static gboolean
+omx_setup (GstOmxMScaler *self)
+{
+    GOmxCore *gomx = self->gomx;
+    OMX_PARAM_VFPC_NUMCHANNELPERHANDLE numChannels;
+    OMX_CONFIG_ALG_ENABLE algEnable;
+    OMX_ERRORTYPE err;
+    guint num_channels = 0;
+    guint i;
+
+    GST_LOG_OBJECT (self, "begin");
+
+    /* VFPC channels are numbered from 0 without gaps */
+    for (i = 0; i < self->channels->len; i++)
+    {
+        GstOmxMScalerChannel *ch = get_channel (self, i);
+
+        if (!channel_starts (ch))
+            continue;
+
+        ch->id = num_channels++;
+
+        if (!setup_channel_ports (self, ch))
+            return FALSE;
+    }
+
+    /* Set number of channels */
+    GST_LOG_OBJECT (self, "Setting number of channels to %u", num_channels);
+
+    _G_OMX_INIT_PARAM (&numChannels);
+    numChannels.nNumChannelsPerHandle = num_channels;
+    err = OMX_SetParameter (gomx->omx_handle,
+        (OMX_INDEXTYPE) OMX_TI_IndexParamVFPCNumChPerHandle, &numChannels);
+
+    if (err != OMX_ErrorNone)
+    {
+        GST_ERROR_OBJECT (self, "failed to set number of channels: %s",
+                g_omx_error_to_str (err));
+        return FALSE;
+    }
+
+    for (i = 0; i < self->channels->len; i++)
+    {
+        GstOmxMScalerChannel *ch = get_channel (self, i);
+
+        if (!channel_starts (ch))
+            continue;
+
+        if (!set_channel_resolution (self, ch, OMX_DirInput) ||
+            !set_channel_resolution (self, ch, OMX_DirOutput))
+            return FALSE;
+
+        _G_OMX_INIT_PARAM (&algEnable);
+        algEnable.nPortIndex = 0;
+        algEnable.nChId = ch->id;
+        algEnable.bAlgBypass = OMX_FALSE;
+
+        err = OMX_SetConfig (gomx->omx_handle, (OMX_INDEXTYPE) OMX_TI_IndexConfigAlgEnable, &algEnable);
+
+        if (err != OMX_ErrorNone)
+        {
+            GST_ERROR_OBJECT (self, "channel %u: failed to enable scaler: %s",
+                    ch->index, g_omx_error_to_str (err));
+            return FALSE;
+        }
+    }
+
+    /* enable the ports of every channel */
+    for (i = 0; i < self->channels->len; i++)
+    {
+        GstOmxMScalerChannel *ch = get_channel (self, i);
+
+        if (!channel_starts (ch))
+            continue;
+
+        OMX_SendCommand (gomx->omx_handle,
+                OMX_CommandPortEnable, ch->in_port->port_index, NULL);
+        g_sem_down (gomx->port_sem);
+
+        OMX_SendCommand (gomx->omx_handle,
+                OMX_CommandPortEnable, ch->out_port->port_index, NULL);
+        g_sem_down (gomx->port_sem);
+    }
+
+    GST_LOG_OBJECT (self, "end");
+
+    return TRUE;
+}
+
+static GstFlowReturn
+push_buffer (GstOmxMScalerChannel *ch,
+             GstBuffer *buf)
+{
+    GstFlowReturn ret;
+
+    GST_BUFFER_DURATION (buf) = ch->duration;
+
+    PRINT_BUFFER (ch->self, buf);
+
+    GST_LOG_OBJECT (ch->self, "channel %u: begin", ch->index);
+    ret = gst_pad_push (ch->srcpad, buf);
+    GST_LOG_OBJECT (ch->self, "channel %u: end", ch->index);
+
+    return ret;
+}
+
+static void
+output_loop (gpointer data)
+{
+    GstOmxMScalerChannel *ch = data;
+    GstOmxMScaler *self = ch->self;
+    GOmxPort *out_port = ch->out_port;
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    GST_LOG_OBJECT (self, "begin");
+
+    if (G_LIKELY (out_port->enabled))
+    {
+        gpointer obj = g_omx_port_recv (out_port);
+
+        if (G_UNLIKELY (!obj))
+        {
+            GST_WARNING_OBJECT (self, "channel %u: null buffer: leaving", ch->index);
+            ret = GST_FLOW_WRONG_STATE;
+            goto leave;
+        }
+
+        if (G_LIKELY (GST_IS_BUFFER (obj)))
+        {
+            /* pushed under eos_lock, so that pad_event can not send EOS
+             * between the check and the push
+             */
+            g_mutex_lock (self->eos_lock);
+            if (G_UNLIKELY (ch->eos_pushed))
+            {
+                GST_WARNING_OBJECT (self, "channel %u: dropping buffer after EOS",
+                        ch->index);
+                gst_buffer_unref (GST_BUFFER (obj));
+                ret = GST_FLOW_UNEXPECTED;
+            }
+            else
+            {
+                ret = push_buffer (ch, GST_BUFFER (obj));
+                GST_DEBUG_OBJECT (self, "channel %u: ret=%s", ch->index,
+                        gst_flow_get_name (ret));
+            }
+            g_mutex_unlock (self->eos_lock);
+        }
+        else if (GST_IS_EVENT (obj))
+        {
+            gboolean push;
+
+            GST_DEBUG_OBJECT (self, "channel %u: got eos", ch->index);
+
+            g_mutex_lock (self->eos_lock);
+            push = !ch->eos_pushed;
+            ch->eos_pushed = TRUE;
+            g_mutex_unlock (self->eos_lock);
+
+            if (push)
+                gst_pad_push_event (ch->srcpad, obj);
+            else
+                gst_event_unref (obj);
+
+            ret = GST_FLOW_UNEXPECTED;
+            goto leave;
+        }
+    }
+
+leave:
+
+    g_mutex_lock (self->eos_lock);
+    ch->last_pad_push_return = ret;
+
+    if (self->gomx->omx_error != OMX_ErrorNone)
+    {
+        GST_DEBUG_OBJECT (self, "omx_error=%s", g_omx_error_to_str (self->gomx->omx_error));
+        ret = GST_FLOW_ERROR;
+    }
+
+    /* a pending EOS drain will not complete anymore */
+    if (ret != GST_FLOW_OK)
+        g_cond_broadcast (self->eos_cond);
+    g_mutex_unlock (self->eos_lock);
+
+    if (ret != GST_FLOW_OK)
+    {
+        GST_INFO_OBJECT (self, "channel %u: pause task, reason:  %s",
+                         ch->index, gst_flow_get_name (ret));
+        gst_pad_pause_task (ch->srcpad);
+    }
+
+    GST_LOG_OBJECT (self, "end");
+}
+
+/* called with ready_lock */
+static void
+prepare (GstOmxMScaler *self)
+{
+    GOmxCore *gomx = self->gomx;
+    guint i;
+
+    GST_INFO_OBJECT (self, "omx: prepare %u channels", self->channels->len);
+
+    if (!omx_setup (self))
+    {
+        self->failed = TRUE;
+        goto leave;
+    }
+
+    g_omx_core_prepare (gomx);
+
+    if (gomx->omx_state != OMX_StateIdle)
+    {
+        self->failed = TRUE;
+        goto leave;
+    }
+
+    self->ready = TRUE;
+
+    for (i = 0; i < self->channels->len; i++)
+    {
+        GstOmxMScalerChannel *ch = get_channel (self, i);
+
+        if (!channel_starts (ch))
+            continue;
+
+        ch->active = TRUE;
+        gst_pad_start_task (ch->srcpad, output_loop, ch);
+    }
+
+leave:
+    g_cond_broadcast (self->ready_cond);
+}
+
+/*
+ * Called with ready_lock whenever a channel gets its first buffer, ends or
+ * goes away: prepares the component once every remaining channel has a
+ * buffer, leaving out the channels which ended before theirs.
+ */
+static void
+check_channels (GstOmxMScaler *self)
+{
+    gboolean any = FALSE;
+    guint i;
+
+    if (self->ready || self->failed)
+        return;
+
+    for (i = 0; i < self->channels->len; i++)
+    {
+        GstOmxMScalerChannel *ch = get_channel (self, i);
+
+        if (!ch || ch->ended)
+            continue;
+
+        if (!ch->have_buffer)
+        {
+            GST_DEBUG_OBJECT (self, "waiting for channel %u", ch->index);
+            return;
+        }
+
+        any = TRUE;
+    }
+
+    if (any)
+        prepare (self);
+}
+
+/*
+ * The component can only be configured for all channels at once, so the
+ * first buffer of each channel waits here until every channel has one.
+ */
+static gboolean
+wait_for_channels (GstOmxMScaler *self,
+                   GstOmxMScalerChannel *ch,
+                   GstBuffer *buf)
+{
+    gboolean ready;
+
+    g_mutex_lock (self->ready_lock);
+
+    if (!ch->have_buffer)
+    {
+        ch->have_buffer = TRUE;
+        ch->ended = FALSE;
+        ch->upstream_port = GST_IS_OMXBUFFERTRANSPORT (buf) ?
+                GST_GET_OMXPORT (buf) : NULL;
+    }
+
+    check_channels (self);
+
+    while (!self->ready && !self->failed && !self->flushing &&
+           ch->last_pad_push_return == GST_FLOW_OK)
+    {
+        g_cond_wait (self->ready_cond, self->ready_lock);
+    }
+
+    ready = self->ready;
+
+    g_mutex_unlock (self->ready_lock);
+
+    return ready;
+}
+
+static GstFlowReturn
+pad_chain (GstPad *pad,
+           GstBuffer *buf)
+{
+    GstOmxMScalerChannel *ch;
+    GstOmxMScaler *self;
+    GOmxCore *gomx;
+    GOmxPort *in_port;
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    ch = gst_pad_get_element_private (pad);
+    self = ch->self;
+    gomx = self->gomx;
+
+    PRINT_BUFFER (self, buf);
+
+    GST_LOG_OBJECT (self, "begin: channel %u, size=%u, state=%d",
+            ch->index, GST_BUFFER_SIZE (buf), gomx->omx_state);
+
+    if (G_UNLIKELY (!self->ready))
+    {
+        if (!wait_for_channels (self, ch, buf))
+            goto out_flushing;
+    }
+
+    if (G_UNLIKELY (!ch->active))
+    {
+        /* ended before its first buffer, the scaler runs without it */
+        GST_WARNING_OBJECT (self, "channel %u: not part of the running scaler",
+                ch->index);
+        gst_buffer_unref (buf);
+        ret = GST_FLOW_UNEXPECTED;
+        goto leave;
+    }
+
+    in_port = ch->in_port;
+
+    if (G_LIKELY (in_port->enabled))
+    {
+        if (G_UNLIKELY (gomx->omx_state == OMX_StateIdle))
+        {
+            g_mutex_lock (self->ready_lock);
+            if (gomx->omx_state == OMX_StateIdle)
+            {
+                GST_INFO_OBJECT (self, "omx: play");
+                g_omx_core_start (gomx);
+            }
+            g_mutex_unlock (self->ready_lock);
+
+            if (gomx->omx_state != OMX_StateExecuting)
+                goto out_flushing;
+        }
+
+        while (TRUE)
+        {
+            gint sent;
+
+            if (ch->last_pad_push_return != GST_FLOW_OK ||
+                !(gomx->omx_state == OMX_StateExecuting ||
+                  gomx->omx_state == OMX_StatePause))
+            {
+                GST_DEBUG_OBJECT (self, "channel %u: last_pad_push_return=%d",
+                        ch->index, ch->last_pad_push_return);
+                goto out_flushing;
+            }
+
+            sent = g_omx_port_send (in_port, buf);
+
+            if (G_UNLIKELY (sent < 0))
+            {
+                ret = GST_FLOW_WRONG_STATE;
+                goto out_flushing;
+            }
+            else if (sent < GST_BUFFER_SIZE (buf))
+            {
+                GstBuffer *subbuf = gst_buffer_create_sub (buf, sent,
+                        GST_BUFFER_SIZE (buf) - sent);
+                gst_buffer_unref (buf);
+                buf = subbuf;
+            }
+            else
+            {
+                gst_buffer_unref (buf);
+                break;
+            }
+        }
+    }
+    else
+    {
+        GST_WARNING_OBJECT (self, "channel %u: done", ch->index);
+        gst_buffer_unref (buf);
+        ret = GST_FLOW_UNEXPECTED;
+    }
+
+leave:
+
+    GST_LOG_OBJECT (self, "end");
+
+    return ret;
+
+    /* special conditions */
+out_flushing:
+    {
+        const gchar *error_msg = NULL;
+
+        if (self->failed)
+        {
+            error_msg = "Failed to configure OpenMAX component";
+        }
+        else if (gomx->omx_error)
+        {
+            error_msg = "Error from OpenMAX component";
+        }
+        else if (self->ready &&
+                 gomx->omx_state != OMX_StateExecuting &&
+                 gomx->omx_state != OMX_StatePause)
+        {
+            error_msg = "OpenMAX component in wrong state";
+        }
+
+        if (error_msg)
+        {
+            GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL), (error_msg));
+            ret = GST_FLOW_ERROR;
+        }
+        else if (ret == GST_FLOW_OK)
+        {
+            ret = GST_FLOW_WRONG_STATE;
+        }
+
+        gst_buffer_unref (buf);
+
+        goto leave;
+    }
+}
+
+/**
+ * Wait until output_loop has pushed the EOS flagged buffer of the channel,
+ * like GstOmxBaseFilter does.  Returns FALSE if that did not happen within
+ * eos-timeout, or if the output loop stopped first; EOS is then up to the
+ * caller, and output_loop drops whatever the component returns later.
+ */
+static gboolean
+wait_for_eos (GstOmxMScalerChannel *ch)
+{
+    GstOmxMScaler *self = ch->self;
+    GTimeVal deadline;
+    gboolean pushed;
+
+    g_get_current_time (&deadline);
+    g_time_val_add (&deadline, (glong) self->eos_timeout * 1000);
+
+    g_mutex_lock (self->eos_lock);
+
+    while (!ch->eos_pushed &&
+           ch->last_pad_push_return == GST_FLOW_OK &&
+           self->gomx->omx_error == OMX_ErrorNone)
+    {
+        if (self->eos_timeout < 0)
+        {
+            g_cond_wait (self->eos_cond, self->eos_lock);
+        }
+        else if (!g_cond_timed_wait (self->eos_cond, self->eos_lock, &deadline))
+        {
+            GST_WARNING_OBJECT (self, "channel %u: component did not return EOS "
+                    "within %d ms", ch->index, self->eos_timeout);
+            break;
+        }
+    }
+
+    pushed = ch->eos_pushed;
+    ch->eos_pushed = TRUE;
+
+    g_mutex_unlock (self->eos_lock);
+
+    return pushed;
+}
+
+static gboolean
+pad_event (GstPad *pad,
+           GstEvent *event)
+{
+    GstOmxMScalerChannel *ch;
+    GstOmxMScaler *self;
+    gboolean ret = TRUE;
+
+    ch = gst_pad_get_element_private (pad);
+    self = ch->self;
+
+    GST_INFO_OBJECT (self, "begin: channel %u, event=%s", ch->index,
+            GST_EVENT_TYPE_NAME (event));
+
+    switch (GST_EVENT_TYPE (event))
+    {
+        case GST_EVENT_FLUSH_START:
+            gst_pad_push_event (ch->srcpad, event);
+
+            /* also wakes up a chain waiting for the other channels, and an
+             * EOS drain */
+            g_mutex_lock (self->ready_lock);
+            g_mutex_lock (self->eos_lock);
+            ch->last_pad_push_return = GST_FLOW_WRONG_STATE;
+            g_cond_broadcast (self->eos_cond);
+            g_mutex_unlock (self->eos_lock);
+            g_cond_broadcast (self->ready_cond);
+            g_mutex_unlock (self->ready_lock);
+
+            if (ch->active)
+            {
+                g_omx_port_pause (ch->in_port);
+                g_omx_port_pause (ch->out_port);
+            }
+
+            gst_pad_pause_task (ch->srcpad);
+
+            ret = TRUE;
+            break;
+
+        case GST_EVENT_FLUSH_STOP:
+            gst_pad_push_event (ch->srcpad, event);
+
+            g_mutex_lock (self->ready_lock);
+            if (!self->ready)
+                ch->ended = FALSE;
+            g_mutex_unlock (self->ready_lock);
+
+            g_mutex_lock (self->eos_lock);
+            ch->last_pad_push_return = GST_FLOW_OK;
+            ch->eos_pushed = FALSE;
+            g_mutex_unlock (self->eos_lock);
+
+            if (ch->active)
+            {
+                g_omx_port_flush (ch->in_port);
+                g_omx_port_flush (ch->out_port);
+                g_omx_port_resume (ch->in_port);
+                g_omx_port_resume (ch->out_port);
+
+                gst_pad_start_task (ch->srcpad, output_loop, ch);
+            }
+
+            ret = TRUE;
+            break;
+
+        case GST_EVENT_EOS:
+            g_mutex_lock (self->ready_lock);
+            if (!self->ready && !ch->have_buffer)
+            {
+                /* the other channels do not wait for this one anymore */
+                GST_INFO_OBJECT (self, "channel %u: ended before its first buffer",
+                        ch->index);
+                ch->ended = TRUE;
+                check_channels (self);
+            }
+            g_mutex_unlock (self->ready_lock);
+
+            /* the EOS flagged buffer comes back on the output port of the
+             * channel after the frames the component still holds */
+            if (ch->active && ch->last_pad_push_return == GST_FLOW_OK)
+            {
+                if (g_omx_port_send (ch->in_port, event) >= 0 &&
+                    wait_for_eos (ch))
+                {
+                    gst_event_unref (event);
+                    break;
+                }
+            }
+
+            g_mutex_lock (self->eos_lock);
+            ch->eos_pushed = TRUE;
+            g_mutex_unlock (self->eos_lock);
+
+            ret = gst_pad_push_event (ch->srcpad, event);
+            break;
+
+        default:
+            ret = gst_pad_push_event (ch->srcpad, event);
+            break;
+    }
+
+    GST_LOG_OBJECT (self, "end");
+
+    return ret;
+}
+
+static gboolean
+sink_setcaps (GstPad *pad,
+              GstCaps *caps)
+{
+    GstOmxMScalerChannel *ch;
+    GstOmxMScaler *self;
+    GstStructure *structure;
+    GstVideoFormat format;
+    const GValue *framerate;
+
+    ch = gst_pad_get_element_private (pad);
+    self = ch->self;
+
+    GST_INFO_OBJECT (self, "setcaps (sink_%u): %" GST_PTR_FORMAT, ch->index, caps);
+
+    g_return_val_if_fail (caps, FALSE);
+    g_return_val_if_fail (gst_caps_is_fixed (caps), FALSE);
+
+    structure = gst_caps_get_structure (caps, 0);
+
+    if (!gst_video_format_parse_caps_strided (caps,
+            &format, &ch->in_width, &ch->in_height, &ch->in_stride))
+    {
+        GST_WARNING_OBJECT (self, "width and/or height is not set in caps");
+        return FALSE;
+    }
+
+    if (!ch->in_stride)
+        ch->in_stride = gstomx_calculate_stride (ch->in_width, format);
+
+    framerate = gst_structure_get_value (structure, "framerate");
+    if (framerate)
+    {
+        ch->framerate_num = gst_value_get_fraction_numerator (framerate);
+        ch->framerate_denom = gst_value_get_fraction_denominator (framerate);
+
+        if (ch->framerate_num)
+        {
+            ch->duration = gst_util_uint64_scale_int (GST_SECOND,
+                    ch->framerate_denom, ch->framerate_num);
+        }
+    }
+
+    return gst_pad_set_caps (pad, caps);
+}
+
+static gboolean
+activate_push (GstPad *pad,
+               gboolean active)
+{
+    GstOmxMScalerChannel *ch;
+    GstOmxMScaler *self;
+    gboolean result = TRUE;
+
+    ch = gst_pad_get_element_private (pad);
+    self = ch->self;
+
+    if (active)
+    {
+        GST_DEBUG_OBJECT (self, "channel %u: activate", ch->index);
+
+        g_mutex_lock (self->eos_lock);
+        ch->last_pad_push_return = GST_FLOW_OK;
+        ch->eos_pushed = FALSE;
+        g_mutex_unlock (self->eos_lock);
+
+        /* we do not start the task yet if the pad is not connected */
+        if (gst_pad_is_linked (pad) && ch->active)
+        {
+            g_omx_port_resume (ch->in_port);
+            g_omx_port_resume (ch->out_port);
+
+            result = gst_pad_start_task (pad, output_loop, ch);
+        }
+    }
+    else
+    {
+        GST_DEBUG_OBJECT (self, "channel %u: deactivate", ch->index);
+
+        /* wake up an EOS drain, the output loop is about to stop */
+        g_mutex_lock (self->eos_lock);
+        ch->last_pad_push_return = GST_FLOW_WRONG_STATE;
+        g_cond_broadcast (self->eos_cond);
+        g_mutex_unlock (self->eos_lock);
+
+        if (ch->active)
+        {
+            /* unlock loops */
+            g_omx_port_pause (ch->in_port);
+            g_omx_port_pause (ch->out_port);
+        }
+
+        /* make sure streaming finishes */
+        result = gst_pad_stop_task (pad);
+    }
+
+    return result;
+}
+
+static GstPad *
+request_new_pad (GstElement *element,
+                 GstPadTemplate *templ,
+                 const gchar *name)
+{
+    GstOmxMScaler *self;
+    GstOmxMScalerChannel *ch;
+    GstElementClass *element_class;
+    guint index;
+    gchar *pad_name;
+
+    self = GST_OMX_MSCALER (element);
+    element_class = GST_ELEMENT_GET_CLASS (element);
+
+    g_mutex_lock (self->ready_lock);
+
+    if (self->ready)
+    {
+        GST_WARNING_OBJECT (self, "cannot add a channel to a running scaler");
+        goto fail;
+    }
+
+    if (name)
+    {
+        if (sscanf (name, "sink_%u", &index) != 1)
+        {
+            GST_WARNING_OBJECT (self, "invalid pad name %s", name);
+            goto fail;
+        }
+    }
+    else
+    {
+        /* first free channel */
+        for (index = 0; get_channel (self, index); index++);
+    }
+
+    if (index >= MAX_CHANNELS || get_channel (self, index))
+    {
+        GST_WARNING_OBJECT (self, "channel %u is not available", index);
+        goto fail;
+    }
+
+    ch = g_new0 (GstOmxMScalerChannel, 1);
+    ch->self = self;
+    ch->index = index;
+    ch->duration = GST_CLOCK_TIME_NONE;
+    ch->last_pad_push_return = GST_FLOW_OK;
+
+    pad_name = g_strdup_printf ("sink_%u", index);
+    ch->sinkpad = gst_pad_new_from_template (templ, pad_name);
+    g_free (pad_name);
+
+    pad_name = g_strdup_printf ("src_%u", index);
+    ch->srcpad = gst_pad_new_from_template (
+            gst_element_class_get_pad_template (element_class, "src_%d"), pad_name);
+    g_free (pad_name);
+
+    gst_pad_set_element_private (ch->sinkpad, ch);
+    gst_pad_set_element_private (ch->srcpad, ch);
+
+    gst_pad_set_chain_function (ch->sinkpad, GST_DEBUG_FUNCPTR (pad_chain));
+    gst_pad_set_event_function (ch->sinkpad, GST_DEBUG_FUNCPTR (pad_event));
+    gst_pad_set_setcaps_function (ch->sinkpad, GST_DEBUG_FUNCPTR (sink_setcaps));
+
+    gst_pad_set_activatepush_function (ch->srcpad, GST_DEBUG_FUNCPTR (activate_push));
+    gst_pad_use_fixed_caps (ch->srcpad);
+
+    if (index >= self->channels->len)
+        g_ptr_array_set_size (self->channels, index + 1);
+    g_ptr_array_index (self->channels, index) = ch;
+
+    g_mutex_unlock (self->ready_lock);
+
+    GST_INFO_OBJECT (self, "added channel %u", index);
+
+    if (GST_STATE (element) > GST_STATE_READY)
+    {
+        gst_pad_set_active (ch->sinkpad, TRUE);
+        gst_pad_set_active (ch->srcpad, TRUE);
+    }
+
+    gst_element_add_pad (element, ch->srcpad);
+    gst_element_add_pad (element, ch->sinkpad);
+
+    return ch->sinkpad;
+
+fail:
+    g_mutex_unlock (self->ready_lock);
+    return NULL;
+}
+
+static void
+release_pad (GstElement *element,
+             GstPad *pad)
+{
+    GstOmxMScaler *self;
+    GstOmxMScalerChannel *ch;
+
+    self = GST_OMX_MSCALER (element);
+    ch = gst_pad_get_element_private (pad);
+
+    g_mutex_lock (self->ready_lock);
+
+    if (self->ready)
+    {
+        /* the component can not drop a channel, and the pad stays */
+        g_mutex_unlock (self->ready_lock);
+        GST_ELEMENT_ERROR (self, CORE, PAD, (NULL),
+                ("cannot remove channel %u from a running scaler", ch->index));
+        return;
+    }
+
+    g_ptr_array_index (self->channels, ch->index) = NULL;
+    while (self->channels->len && !get_channel (self, self->channels->len - 1))
+        g_ptr_array_set_size (self->channels, self->channels->len - 1);
+
+    /* release its own first buffer, and start the others if they only
+     * waited for this channel */
+    g_mutex_lock (self->eos_lock);
+    ch->last_pad_push_return = GST_FLOW_WRONG_STATE;
+    g_mutex_unlock (self->eos_lock);
+    check_channels (self);
+    g_cond_broadcast (self->ready_cond);
+
+    g_mutex_unlock (self->ready_lock);
+
+    GST_INFO_OBJECT (self, "removed channel %u", ch->index);
+
+    gst_pad_set_active (ch->sinkpad, FALSE);
+    gst_pad_set_active (ch->srcpad, FALSE);
+
+    gst_element_remove_pad (element, ch->srcpad);
+    gst_element_remove_pad (element, ch->sinkpad);
+
+    g_free (ch);
+}
+
+static GstStateChangeReturn
+change_state (GstElement *element,
+              GstStateChange transition)
+{
+    GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
+    GstOmxMScaler *self;
+    GOmxCore *core;
+    guint i;
+
+    self = GST_OMX_MSCALER (element);
+    core = self->gomx;
+
+    GST_INFO_OBJECT (self, "begin: changing state %s -> %s",
+                     gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (transition)),
+                     gst_element_state_get_name (GST_STATE_TRANSITION_NEXT (transition)));
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_NULL_TO_READY:
+            g_omx_core_init (core);
+            if (core->omx_state != OMX_StateLoaded)
+            {
+                ret = GST_STATE_CHANGE_FAILURE;
+                goto leave;
+            }
+            break;
+
+        case GST_STATE_CHANGE_READY_TO_PAUSED:
+            g_mutex_lock (self->ready_lock);
+            self->flushing = FALSE;
+            self->failed = FALSE;
+            g_mutex_unlock (self->ready_lock);
+            break;
+
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            /* release chains waiting for the other channels */
+            g_mutex_lock (self->ready_lock);
+            self->flushing = TRUE;
+            g_cond_broadcast (self->ready_cond);
+            g_mutex_unlock (self->ready_lock);
+            break;
+
+        default:
+            break;
+    }
+
+    ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+    if (ret == GST_STATE_CHANGE_FAILURE)
+        goto leave;
+
+    switch (transition)
+    {
+        case GST_STATE_CHANGE_PAUSED_TO_READY:
+            g_mutex_lock (self->ready_lock);
+            if (self->ready)
+            {
+                /* unlock */
+                for (i = 0; i < self->channels->len; i++)
+                {
+                    GstOmxMScalerChannel *ch = get_channel (self, i);
+
+                    if (ch && ch->active)
+                    {
+                        g_omx_port_finish (ch->in_port);
+                        g_omx_port_finish (ch->out_port);
+                    }
+                }
+
+                g_omx_core_stop (core);
+                g_omx_core_unload (core);
+                self->ready = FALSE;
+            }
+            for (i = 0; i < self->channels->len; i++)
+            {
+                GstOmxMScalerChannel *ch = get_channel (self, i);
+                if (ch)
+                {
+                    ch->have_buffer = FALSE;
+                    ch->ended = FALSE;
+                    ch->active = FALSE;
+                    ch->upstream_port = NULL;
+                }
+            }
+            g_mutex_unlock (self->ready_lock);
+            if (core->omx_state != OMX_StateLoaded &&
+                core->omx_state != OMX_StateInvalid)
+            {
+                ret = GST_STATE_CHANGE_FAILURE;
+                goto leave;
+            }
+            break;
+
+        case GST_STATE_CHANGE_READY_TO_NULL:
+            g_omx_core_deinit (core);
+            break;
+
+        default:
+            break;
+    }
+
+leave:
+    GST_LOG_OBJECT (self, "end");
+
+    return ret;
+}
+
+static void
+finalize (GObject *obj)
+{
+    GstOmxMScaler *self;
+    guint i;
+
+    self = GST_OMX_MSCALER (obj);
+
+    g_omx_core_free (self->gomx);
+
+    for (i = 0; i < self->channels->len; i++)
+        g_free (get_channel (self, i));
+    g_ptr_array_free (self->channels, TRUE);
+
+    g_free (self->omx_role);
+    g_free (self->omx_component);
+    g_free (self->omx_library);
+
+    g_cond_free (self->ready_cond);
+    g_mutex_free (self->ready_lock);
+    g_cond_free (self->eos_cond);
+    g_mutex_free (self->eos_lock);
+
+    G_OBJECT_CLASS (parent_class)->finalize (obj);
+}
+
+static void
+set_property (GObject *obj,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMScaler *self;
+
+    self = GST_OMX_MSCALER (obj);
+
+    switch (prop_id)
+    {
+        case ARG_COMPONENT_ROLE:
+            g_free (self->omx_role);
+            self->omx_role = g_value_dup_string (value);
+            break;
+        case ARG_COMPONENT_NAME:
+            g_free (self->omx_component);
+            self->omx_component = g_value_dup_string (value);
+            break;
+        case ARG_LIBRARY_NAME:
+            g_free (self->omx_library);
+            self->omx_library = g_value_dup_string (value);
+            break;
+        case ARG_NUM_OUTPUT_BUFFERS:
+            /* for the channels set up from now on */
+            self->output_buffers = g_value_get_int (value);
+            break;
+        case ARG_EOS_TIMEOUT:
+            self->eos_timeout = g_value_get_int (value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+get_property (GObject *obj,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    GstOmxMScaler *self;
+
+    self = GST_OMX_MSCALER (obj);
+
+    switch (prop_id)
+    {
+        case ARG_COMPONENT_ROLE:
+            g_value_set_string (value, self->omx_role);
+            break;
+        case ARG_COMPONENT_NAME:
+            g_value_set_string (value, self->omx_component);
+            break;
+        case ARG_LIBRARY_NAME:
+            g_value_set_string (value, self->omx_library);
+            break;
+        case ARG_NUM_CHANNELS:
+            g_mutex_lock (self->ready_lock);
+            g_value_set_uint (value, self->channels->len);
+            g_mutex_unlock (self->ready_lock);
+            break;
+        case ARG_NUM_OUTPUT_BUFFERS:
+            g_value_set_int (value, self->output_buffers);
+            break;
+        case ARG_OUTPUT_MEMORY:
+            {
+                guint64 memory = 0;
+                guint i;
+
+                g_mutex_lock (self->ready_lock);
+                for (i = 0; i < self->channels->len; i++)
+                {
+                    GstOmxMScalerChannel *ch = g_ptr_array_index (self->channels, i);
+
+                    if (ch && ch->out_port)
+                        memory += ch->out_port->memory;
+                }
+                g_mutex_unlock (self->ready_lock);
+
+                g_value_set_uint64 (value, memory);
+            }
+            break;
+        case ARG_EOS_TIMEOUT:
+            g_value_set_int (value, self->eos_timeout);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (obj, prop_id, pspec);
+            break;
+    }
+}
+
+static void
+type_base_init (gpointer g_class)
+{
+    GstElementClass *element_class;
+
+    element_class = GST_ELEMENT_CLASS (g_class);
+
+    {
+        GstElementDetails details;
+
+        details.longname = "OpenMAX IL for OMX.TI.VPSSM3.VFPC.INDTXSCWB component (multi-channel)";
+        details.klass = "Filter";
+        details.description = "Scale several video streams using one VPSS Scaler handle";
+        details.author = "Texas Instruments";
+
+        gst_element_class_set_details (element_class, &details);
+    }
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&sink_template));
+
+    gst_element_class_add_pad_template (element_class,
+        gst_static_pad_template_get (&src_template));
+}
+
+static void
+type_class_init (gpointer g_class,
+                 gpointer class_data)
+{
+    GObjectClass *gobject_class;
+    GstElementClass *gstelement_class;
+
+    gobject_class = G_OBJECT_CLASS (g_class);
+    gstelement_class = GST_ELEMENT_CLASS (g_class);
+
+    gobject_class->finalize = finalize;
+    gstelement_class->change_state = change_state;
+    gstelement_class->request_new_pad = request_new_pad;
+    gstelement_class->release_pad = release_pad;
+
+    /* Properties stuff */
+    {
+        gobject_class->set_property = set_property;
+        gobject_class->get_property = get_property;
+
+        g_object_class_install_property (gobject_class, ARG_COMPONENT_ROLE,
+                                         g_param_spec_string ("component-role", "Component role",
+                                                              "Role of the OpenMAX IL component",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_COMPONENT_NAME,
+                                         g_param_spec_string ("component-name", "Component name",
+                                                              "Name of the OpenMAX IL component to use",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_LIBRARY_NAME,
+                                         g_param_spec_string ("library-name", "Library name",
+                                                              "Name of the OpenMAX IL implementation library to use",
+                                                              NULL, G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_NUM_CHANNELS,
+                                         g_param_spec_uint ("num-channels", "Number of channels",
+                                                            "Number of channels sharing the component",
+                                                            0, MAX_CHANNELS, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_NUM_OUTPUT_BUFFERS,
+                                         g_param_spec_int ("output-buffers", "Output buffers",
+                                                           "The number of OMX output buffers of each channel "
+                                                           "(-1 = as few as the stream needs)",
+                                                           GOMX_PORT_AUTO_BUFFERS, GOMX_PORT_MAX_BUFFERS, DEFAULT_OUTPUT_BUFFERS,
+                                                           G_PARAM_READWRITE));
+
+        g_object_class_install_property (gobject_class, ARG_OUTPUT_MEMORY,
+                                         g_param_spec_uint64 ("output-memory", "Output memory",
+                                                              "Bytes allocated for the OMX output buffers of all channels",
+                                                              0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+        g_object_class_install_property (gobject_class, ARG_EOS_TIMEOUT,
+                                         g_param_spec_int ("eos-timeout", "EOS timeout",
+                                                           "Milliseconds to wait for each channel to drain "
+                                                           "on EOS (-1 = forever)",
+                                                           -1, G_MAXINT, DEFAULT_EOS_TIMEOUT, G_PARAM_READWRITE));
+    }
+}
+
+static void
+type_instance_init (GTypeInstance *instance,
+                    gpointer g_class)
+{
+    GstOmxMScaler *self;
+
+    self = GST_OMX_MSCALER (instance);
+
+    GST_LOG_OBJECT (self, "begin");
+
+    self->channels = g_ptr_array_new ();
+    self->output_buffers = DEFAULT_OUTPUT_BUFFERS;
+    self->ready_lock = g_mutex_new ();
+    self->ready_cond = g_cond_new ();
+    self->eos_lock = g_mutex_new ();
+    self->eos_cond = g_cond_new ();
+    self->eos_timeout = DEFAULT_EOS_TIMEOUT;
+
+    /* GOmx; the ports are created once the channels are known */
+    self->gomx = g_omx_core_new (self, g_class);
+
+    GST_LOG_OBJECT (self, "end");
+}
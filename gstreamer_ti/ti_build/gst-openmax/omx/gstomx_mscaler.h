@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef GSTOMX_MSCALER_H
+#define GSTOMX_MSCALER_H
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_OMX_MSCALER(obj) (GstOmxMScaler *) (obj)
+#define GST_OMX_MSCALER_TYPE (gst_omx_mscaler_get_type ())
+
+typedef struct GstOmxMScaler GstOmxMScaler;
+typedef struct GstOmxMScalerClass GstOmxMScalerClass;
+typedef struct GstOmxMScalerChannel GstOmxMScalerChannel;
+
+#include "gstomx_util.h"
+
+/**
+ * One scaler channel: a sink_%d/src_%d pad pair mapped onto VFPC input and
+ * output port START_INDEX + index of the shared component.
+ */
+struct GstOmxMScalerChannel
+{
+    GstOmxMScaler *self;
+    guint index;
+
+    /** VFPC channel id, from 0 over the channels of the running scaler */
+    guint id;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    GOmxPort *in_port;
+    GOmxPort *out_port;
+
+    gint in_width, in_height, in_stride;
+    gint out_width, out_height, out_stride;
+    gint framerate_num, framerate_denom;
+    GstClockTime duration;
+
+    /** first buffer received, upstream_port is valid */
+    gboolean have_buffer;
+    /** EOS before the first buffer, the scaler starts without the channel */
+    gboolean ended;
+    /** configured on the component, only set while the scaler is ready */
+    gboolean active;
+    /** port of the upstream OMX element when it pushes transport buffers */
+    GOmxPort *upstream_port;
+
+    /** protected by the eos_lock of the scaler, see GstOmxBaseFilter */
+    GstFlowReturn last_pad_push_return;
+    gboolean eos_pushed;
+};
+
+struct GstOmxMScaler
+{
+    GstElement element;
+
+    GOmxCore *gomx;
+
+    /** GstOmxMScalerChannel, indexed by channel number */
+    GPtrArray *channels;
+
+    char *omx_role;
+    char *omx_component;
+    char *omx_library;
+
+    /** nBufferCountActual of the output ports, GOMX_PORT_AUTO_BUFFERS tunes
+     * it per channel */
+    gint output_buffers;
+
+    /** protects channels, ready, flushing and failed */
+    GMutex *ready_lock;
+    GCond *ready_cond;
+    gboolean ready;
+    gboolean flushing;
+    gboolean failed;
+
+    /* EOS drain of each channel, as in GstOmxBaseFilter: the sink pad waits
+     * on eos_cond, for at most eos_timeout milliseconds (-1 waits forever),
+     * until the output port of the channel returns the EOS flagged buffer.
+     */
+    GMutex *eos_lock;
+    GCond *eos_cond;
+    gint eos_timeout;
+};
+
+struct GstOmxMScalerClass
+{
+    GstElementClass parent_class;
+};
+
+GType gst_omx_mscaler_get_type (void);
+
+G_END_DECLS
+
+#endif /* GSTOMX_MSCALER_H */
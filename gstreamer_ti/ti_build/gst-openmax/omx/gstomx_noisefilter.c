@@ -76,13 +76,17 @@ create_src_caps (GstOmxBaseFilter *omx_base)
     GstCaps *caps;    
     GstOmxBaseVfpc *self;
     GstStructure *struc;
+    gint left, top, width, height;
 
     self = GST_OMX_BASE_VFPC (omx_base);
 
+    /* the noise filter does not scale, the output is the crop area */
+    gstomx_vfpc_get_crop (self, &left, &top, &width, &height);
+
     caps = gst_caps_new_empty ();
     struc = gst_structure_new (("video/x-raw-yuv"),
-            "width",  G_TYPE_INT, self->in_width,
-            "height", G_TYPE_INT, self->in_height,
+            "width",  G_TYPE_INT, width,
+            "height", G_TYPE_INT, height,
             "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('N', 'V', '1', '2'),
             NULL);
 
@@ -105,7 +109,6 @@ omx_setup (GstOmxBaseFilter *omx_base)
     OMX_PARAM_PORTDEFINITIONTYPE paramPort;
     OMX_PARAM_BUFFER_MEMORYTYPE memTypeCfg;
     OMX_PARAM_VFPC_NUMCHANNELPERHANDLE numChannels;
-    OMX_CONFIG_VIDCHANNEL_RESOLUTION chResolution;
     OMX_CONFIG_ALG_ENABLE algEnable;
     GstOmxBaseVfpc *self;
 
@@ -181,44 +184,14 @@ omx_setup (GstOmxBaseFilter *omx_base)
     if (err != OMX_ErrorNone)
         return;
 
-    /* Set input channel resolution */
-    GST_LOG_OBJECT (self, "Setting channel resolution (input)");
-
-    _G_OMX_INIT_PARAM (&chResolution);
-    chResolution.Frm0Width = self->in_width;
-    chResolution.Frm0Height = self->in_height;
-    chResolution.Frm0Pitch = self->in_stride;
-    chResolution.Frm1Width = 0;
-    chResolution.Frm1Height = 0;
-    chResolution.Frm1Pitch = 0;
-    chResolution.FrmStartX = self->left;
-    chResolution.FrmStartY = self->top;
-    chResolution.FrmCropWidth = 0;
-    chResolution.FrmCropHeight = 0;
-    chResolution.eDir = OMX_DirInput;
-    chResolution.nChId = 0;
-    err = OMX_SetConfig (gomx->omx_handle, OMX_TI_IndexConfigVidChResolution, &chResolution);
+    /* Set input channel resolution, along with the crop */
+    err = gstomx_vfpc_set_input_resolution (self);
 
     if (err != OMX_ErrorNone)
         return;
 
     /* Set output channel resolution */
-    GST_LOG_OBJECT (self, "Setting channel resolution (output)");
-
-    _G_OMX_INIT_PARAM (&chResolution);
-    chResolution.Frm0Width = self->out_width;
-    chResolution.Frm0Height = self->out_height;
-    chResolution.Frm0Pitch = self->out_stride;
-    chResolution.Frm1Width = 0;
-    chResolution.Frm1Height = 0;
-    chResolution.Frm1Pitch = 0;
-    chResolution.FrmStartX = 0;
-    chResolution.FrmStartY = 0;
-    chResolution.FrmCropWidth = 0;
-    chResolution.FrmCropHeight = 0;
-    chResolution.eDir = OMX_DirOutput;
-    chResolution.nChId = 0;
-    err = OMX_SetConfig (gomx->omx_handle, OMX_TI_IndexConfigVidChResolution, &chResolution);
+    err = gstomx_vfpc_set_output_resolution (self);
 
     if (err != OMX_ErrorNone)
         return;
@@ -243,6 +216,7 @@ type_instance_init (GTypeInstance *instance,
     self = GST_OMX_BASE_VFPC (instance);
 
     self->omx_setup = omx_setup;
+    self->create_src_caps = create_src_caps;
     g_object_set (self, "port-index", 0, NULL);
 }
 
@@ -43,6 +43,9 @@ static OMX_BUFFERHEADERTYPE * request_buffer (GOmxPort *port);
 static void release_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
 static void setup_shared_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
 
+/* queued behind the buffers returned before an OMX_EventPortSettingsChanged */
+static OMX_BUFFERHEADERTYPE settings_marker;
+
 #define DEBUG(port, fmt, args...) \
     GST_DEBUG ("<%s:%s> "fmt, GST_OBJECT_NAME ((port)->core->object), (port)->name, ##args)
 #define LOG(port, fmt, args...) \
@@ -71,6 +74,8 @@ g_omx_port_new (GOmxCore *core, const gchar *name, guint index)
 
     port->ignore_count = 0;
     port->n_offset = 0;
+    port->n_flags = 0;
+    port->settings_changed = FALSE;
     port->vp6_hack = FALSE;
 
     return port;
@@ -81,17 +86,53 @@ g_omx_port_free (GOmxPort *port)
 {
     DEBUG (port, "begin");
 
+    gst_omxbuffertransport_pool_free (port);
+
     g_mutex_free (port->mutex);
     async_queue_free (port->queue);
 
     g_free (port->name);
 
+    if (port->buffer_table)
+        g_hash_table_destroy (port->buffer_table);
+
     g_free (port->buffers);
     g_free (port);
 
     GST_DEBUG ("end");
 }
 
+/**
+ * Brings the port back to the state g_omx_port_new() left it in, keeping
+ * the settings of the application and what tune_buffer_count() learnt, for
+ * the next component of the core.
+ */
+void
+g_omx_port_reset (GOmxPort *port)
+{
+    DEBUG (port, "reset");
+
+    gst_omxbuffertransport_pool_free (port);
+
+    if (port->buffer_table)
+    {
+        g_hash_table_destroy (port->buffer_table);
+        port->buffer_table = NULL;
+    }
+
+    g_free (port->buffers);
+    port->buffers = NULL;
+    port->memory = 0;
+    port->held = 0;
+
+    async_queue_flush (port->queue);
+    async_queue_enable (port->queue);
+
+    port->enabled = TRUE;
+    port->ignore_count = 0;
+    port->settings_changed = FALSE;
+}
+
 void
 g_omx_port_setup (GOmxPort *port,
                   OMX_PARAM_PORTDEFINITIONTYPE *omx_port)
@@ -140,6 +181,52 @@ buffer_alloc (GOmxPort *port, gint len)
 }
 
 
+/* Bookkeeping for tune_buffer_count(), held being the buffers the peer of
+ * the port holds after one more was handed to it.
+ */
+static inline void
+update_held (GOmxPort *port,
+             guint held,
+             gboolean stalled)
+{
+    port->buffers_used = TRUE;
+
+    if (held > port->held_peak)
+        port->held_peak = held;
+
+    if (G_UNLIKELY (stalled))
+        port->stalls++;
+}
+
+/* The smallest number of buffers which would have done since the buffers
+ * were allocated last: an input port needs the most buffers the component
+ * held plus the one being filled, and one more if that was not enough, an
+ * output port needs the component's minimum on top of the most buffers
+ * held downstream, which is more than it had if it ran short.  Without
+ * anything to go by yet, the minimum of the component, and for an output
+ * port one more to be on its way downstream.
+ */
+static guint
+tune_buffer_count (GOmxPort *port)
+{
+    guint count;
+
+    if (!port->buffers_used)
+        count = port->min_buffers + (port->type == GOMX_PORT_OUTPUT ? 1 : 0);
+    else if (port->type == GOMX_PORT_INPUT)
+        count = port->held_peak + 1 + (port->stalls ? 1 : 0);
+    else
+        count = port->min_buffers + port->held_peak;
+
+    count = CLAMP (count, MAX (port->min_buffers, 1), GOMX_PORT_MAX_BUFFERS);
+
+    GST_INFO_OBJECT (port->core->object, "<%s> held at most %u of %u buffers, "
+            "stalled %u times: %u buffers", port->name, port->held_peak,
+            port->num_buffers, port->stalls, count);
+
+    return count;
+}
+
 /**
  * Ensure that srcpad caps are set before beginning transition-to-idle or
  * transition-to-loaded.  This is a bit ugly, because it requires pad-alloc'ing
@@ -166,11 +253,30 @@ g_omx_port_prepare (GOmxPort *port)
                 size, GST_BUFFER_SIZE (buf));
     }
 
+    gst_buffer_unref (buf);
+
     /* number of buffers could have changed */
     G_OMX_PORT_GET_DEFINITION (port, &param);
+    port->min_buffers = param.nBufferCountMin;
+
+    if (port->auto_buffers)
+        port->buffer_count = tune_buffer_count (port);
+
+    /* the buffers of an upstream port are used as they are */
+    if (port->buffer_count && !port->share_buffer_info &&
+        port->buffer_count != param.nBufferCountActual)
+    {
+        param.nBufferCountActual = CLAMP (port->buffer_count,
+                param.nBufferCountMin, GOMX_PORT_MAX_BUFFERS);
+        G_OMX_PORT_SET_DEFINITION (port, &param);
+        G_OMX_PORT_GET_DEFINITION (port, &param);
+    }
+
     port->num_buffers = param.nBufferCountActual;
 
-    gst_buffer_unref (buf);
+    port->held_peak = 0;
+    port->stalls = 0;
+    port->buffers_used = FALSE;
 
 /* REVISIT: In WBU code these macros are implemented in OMX_TI_Core.h and EZSDK is missing it hence
    commenting out code for now
@@ -214,6 +320,11 @@ g_omx_port_allocate_buffers (GOmxPort *port)
 
     port->buffers = g_new0 (OMX_BUFFERHEADERTYPE *, port->num_buffers);
 
+    /* every buffer header can be sitting in the queue at once, so size it
+     * up front and keep push/pop allocation free:
+     */
+    async_queue_set_capacity (port->queue, port->num_buffers);
+
     for (i = 0; i < port->num_buffers; i++)
     {
 
@@ -258,7 +369,27 @@ g_omx_port_allocate_buffers (GOmxPort *port)
             }
         }
     }
-    
+
+    port->memory = (gsize) size * port->num_buffers;
+    GST_INFO_OBJECT (port->core->object, "<%s> %u buffers of %u bytes, %"
+            G_GSIZE_FORMAT " bytes", port->name, port->num_buffers, size,
+            port->memory);
+
+    /* index the headers by data pointer, so that zero-copy sends can find
+     * the header belonging to an upstream buffer without scanning:
+     */
+    port->buffer_table = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    for (i = 0; i < port->num_buffers; i++)
+    {
+        if (port->buffers[i]->pBuffer)
+            g_hash_table_insert (port->buffer_table,
+                    port->buffers[i]->pBuffer, port->buffers[i]);
+    }
+
+    /* and recycle the buffer transports of the headers */
+    gst_omxbuffertransport_pool_new (port);
+
     DEBUG (port, "end");
 }
 
@@ -282,6 +413,12 @@ g_omx_port_free_buffers (GOmxPort *port)
          */
         omx_buffer = async_queue_pop_full (port->queue, TRUE, TRUE);
 
+        if (G_UNLIKELY (omx_buffer == &settings_marker))
+        {
+            i--;
+            continue;
+        }
+
         if (omx_buffer)
         {
 #if 0
@@ -299,8 +436,21 @@ g_omx_port_free_buffers (GOmxPort *port)
         }
     }
 
+    /* all headers are back, so are their transports */
+    gst_omxbuffertransport_pool_free (port);
+
+    if (port->buffer_table)
+    {
+        g_hash_table_destroy (port->buffer_table);
+        port->buffer_table = NULL;
+    }
+
     g_free (port->buffers);
     port->buffers = NULL;
+    port->memory = 0;
+
+    /* flushed buffers still to come back were collected above */
+    port->ignore_count = 0;
 
     DEBUG (port, "end");
 }
@@ -484,7 +634,8 @@ send_prep_buffer_data (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstBuff
         }
         else
         {
-            if (port->always_copy) 
+            if (port->always_copy &&
+                GST_BUFFER_DATA (buf) != omx_buffer->pBuffer + omx_buffer->nOffset)
             {
                 memcpy (omx_buffer->pBuffer + omx_buffer->nOffset,
                     GST_BUFFER_DATA (buf), omx_buffer->nFilledLen);
@@ -524,16 +675,39 @@ send_prep_eos_event (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer, GstEvent
     }
 }
 
-static gint
-omxbuffer_index (GOmxPort *port, OMX_U8 *pBuffer)
+/**
+ * Find the buffer header which was set up (with OMX_UseBuffer() or
+ * OMX_AllocateBuffer()) for the memory at @data.
+ *
+ * Returns <code>NULL</code> if no header of this port uses @data.
+ */
+OMX_BUFFERHEADERTYPE *
+g_omx_port_lookup_buffer (GOmxPort *port, gconstpointer data)
 {
-    int i;
-    
-    for (i=0; i < port->num_buffers; i++) 
-        if (port->buffers[i]->pBuffer == pBuffer)
-            return i;
+    if (G_UNLIKELY (!port->buffer_table))
+        return NULL;
 
-    return 0; 
+    return g_hash_table_lookup (port->buffer_table, data);
+}
+
+/**
+ * Find the buffer header of this port that shares memory with @buf.  If @buf
+ * is a GstOmxBufferTransport, the upstream header's pBuffer is used as well,
+ * so sub-buffers of a transport still resolve to the right header.
+ *
+ * Returns <code>NULL</code> if @buf is not backed by one of our buffers.
+ */
+OMX_BUFFERHEADERTYPE *
+g_omx_port_get_buffer_header (GOmxPort *port, GstBuffer *buf)
+{
+    OMX_BUFFERHEADERTYPE *omx_buffer;
+
+    omx_buffer = g_omx_port_lookup_buffer (port, GST_BUFFER_DATA (buf));
+
+    if (!omx_buffer && GST_IS_OMXBUFFERTRANSPORT (buf) && GST_GET_OMXBUFFER (buf))
+        omx_buffer = g_omx_port_lookup_buffer (port, GST_GET_OMXBUFFER (buf)->pBuffer);
+
+    return omx_buffer;
 }
 
 /* we are configured not copy the input buffer then update the pBuffer
@@ -544,11 +718,16 @@ static OMX_BUFFERHEADERTYPE *
 get_input_buffer_header (GOmxPort *port, GstBuffer *src)
 {
     OMX_BUFFERHEADERTYPE *omx_buffer;
-    int index;
 
-    index = omxbuffer_index(port, GST_BUFFER_DATA (src));
-     
-    omx_buffer = port->buffers[index];
+    omx_buffer = g_omx_port_get_buffer_header (port, src);
+
+    if (G_UNLIKELY (!omx_buffer))
+    {
+        GST_ELEMENT_ERROR (port->core->object, STREAM, FAILED, (NULL),
+                ("<%s> no OMX buffer header for shared buffer %p (data=%p)",
+                 port->name, src, GST_BUFFER_DATA (src)));
+        return NULL;
+    }
 
     omx_buffer->pBuffer = GST_BUFFER_DATA(src);
     omx_buffer->nOffset = GST_GET_OMXBUFFER(src)->nOffset;
@@ -593,7 +772,28 @@ g_omx_port_send (GOmxPort *port, gpointer obj)
 
         if (port->always_copy) 
         {
-            omx_buffer = request_buffer (port);
+            if (GST_IS_BUFFER (obj) && GST_IS_OMXBUFFERTRANSPORT (obj) &&
+                GST_GET_OMXPORT (obj) == port && GST_GET_OMXBUFFER (obj))
+            {
+                /* pad_alloc'd from this port, so the data is already in the
+                 * header: take it over from the buffer rather than copying
+                 */
+                omx_buffer = GST_GET_OMXBUFFER (obj);
+                GST_OMXBUFFERTRANSPORT (obj)->omxbuffer = NULL;
+            }
+            else
+            {
+                gboolean stalled;
+
+                /* the component holds all of them */
+                stalled = async_queue_length (port->queue) == 0;
+
+                omx_buffer = request_buffer (port);
+
+                if (omx_buffer)
+                    update_held (port, port->num_buffers -
+                            async_queue_length (port->queue) - 1, stalled);
+            }
 
             if (!omx_buffer)
             {
@@ -625,6 +825,9 @@ g_omx_port_send (GOmxPort *port, gpointer obj)
                 omx_buffer = get_input_buffer_header (port, obj);
             else
                 return -1; /* something went wrong */
+
+            if (!omx_buffer)
+                return -1;
         }
 
         send_prep (port, omx_buffer, obj);
@@ -662,6 +865,13 @@ g_omx_port_recv (GOmxPort *port)
             return NULL;
         }
 
+        if (G_UNLIKELY (omx_buffer == &settings_marker))
+        {
+            DEBUG (port, "settings changed");
+            port->settings_changed = TRUE;
+            return NULL;
+        }
+
         DEBUG (port, "omx_buffer=%p size=%lu, len=%lu, flags=%lu, offset=%lu, timestamp=%lld",
                 omx_buffer, omx_buffer->nAllocLen, omx_buffer->nFilledLen, omx_buffer->nFlags,
                 omx_buffer->nOffset, omx_buffer->nTimeStamp);
@@ -705,7 +915,14 @@ g_omx_port_recv (GOmxPort *port)
                     memcpy (GST_BUFFER_DATA (buf), omx_buffer->pBuffer, omx_buffer->nFilledLen);
                 }
                 else {
+                    guint held;
+
                     buf = gst_omxbuffertransport_new (port, omx_buffer);
+
+                    /* until the buffer transport releases it */
+                    held = g_atomic_int_exchange_and_add (&port->held, 1) + 1;
+                    update_held (port, held,
+                            port->num_buffers - held < port->min_buffers);
                 }
             }
             else if (buf)
@@ -729,6 +946,7 @@ g_omx_port_recv (GOmxPort *port)
             }
 
             port->n_offset = omx_buffer->nOffset;
+            port->n_flags = omx_buffer->nFlags;
 
             ret = buf;
         }
@@ -824,8 +1042,16 @@ g_omx_port_flush (GOmxPort *port)
          * yet processed in the output_loop.
          */
         OMX_BUFFERHEADERTYPE *omx_buffer;
+        gboolean settings_changed = FALSE;
+
         while ((omx_buffer = async_queue_pop_full (port->queue, FALSE, TRUE)))
         {
+            if (omx_buffer == &settings_marker)
+            {
+                settings_changed = TRUE;
+                continue;
+            }
+
             omx_buffer->nFilledLen = 0;
 
 #ifdef USE_OMXTICORE
@@ -845,6 +1071,10 @@ g_omx_port_flush (GOmxPort *port)
                 release_buffer (port, omx_buffer);
             }
         }
+
+        /* the port still has to be reconfigured after the flush */
+        if (settings_changed)
+            async_queue_push (port->queue, &settings_marker);
     }
 
     DEBUG (port, "SendCommand(Flush, %d)", port->port_index);
@@ -900,6 +1130,12 @@ g_omx_port_disable (GOmxPort *port)
     OMX_SendCommand (g_omx_core_get_handle (port->core),
             OMX_CommandPortDisable, port->port_index, NULL);
 
+    /* the disable only completes once every buffer is freed, and a sink may
+     * hold on to its last buffer for as long as it likes:
+     */
+    if (port->type == GOMX_PORT_OUTPUT)
+        gst_omxbuffertransport_pool_detach (port);
+
     g_omx_port_free_buffers (port);
 
     g_sem_down (port->core->port_sem);
@@ -915,6 +1151,22 @@ g_omx_port_finish (GOmxPort *port)
     async_queue_disable (port->queue);
 }
 
+/**
+ * Called on OMX_EventPortSettingsChanged for an output port.  The buffers
+ * the component returned before the event are still received, then
+ * g_omx_port_recv() returns NULL with port->settings_changed set, and the
+ * caller has to disable the port, look at its new definition and enable it
+ * again before receiving anything else.
+ */
+void
+g_omx_port_settings_changed (GOmxPort *port)
+{
+    g_return_if_fail (port->type == GOMX_PORT_OUTPUT);
+
+    DEBUG (port, "settings changed");
+    async_queue_push (port->queue, &settings_marker);
+}
+
 
 /*
  * Some domain specific port related utility functions:
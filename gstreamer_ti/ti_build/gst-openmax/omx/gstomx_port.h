@@ -61,6 +61,9 @@ struct GOmxPort
     guint num_buffers;
     guint port_index;
     OMX_BUFFERHEADERTYPE **buffers;
+    GHashTable *buffer_table; /**< pBuffer -> OMX_BUFFERHEADERTYPE, valid while buffers are allocated */
+    GHashTable *transport_pool; /**< OMX_BUFFERHEADERTYPE -> its GstOmxBufferTransport, see gst_omxbuffertransport_new() */
+    guint transports_allocated; /**< transports created for transport_pool */
 
     GMutex *mutex;
     gboolean enabled;
@@ -77,6 +80,33 @@ struct GOmxPort
     /** nOffset value of the last received (input) or next sent (output) port */
     guint n_offset;     /* a bit ugly.. but..  */
 
+    /** nFlags value of the last received buffer (output ports) */
+    guint n_flags;
+
+    /** set by g_omx_port_recv() when it stops at a settings change, see
+     * g_omx_port_settings_changed() */
+    gboolean settings_changed;
+
+    /** nBufferCountActual asked for by the application, 0 leaves it to the
+     * element and the component, see g_omx_port_prepare() */
+    guint buffer_count;
+    /** pick buffer_count from how the buffers were used so far */
+    gboolean auto_buffers;
+    /** nBufferCountMin of the component */
+    guint min_buffers;
+
+    /** buffers held by the peer of the port, ie. the component for an input
+     * port and downstream for an output port: now, at most, and how many
+     * times it had too many for the port to go on, since the buffers were
+     * allocated */
+    gint held;
+    guint held_peak;
+    guint stalls;
+    gboolean buffers_used;
+
+    /** bytes allocated for the buffers */
+    gsize memory;
+
     /** variable to indicate if the conversion from elementary to intermediate video data is done */
     gboolean vp6_hack;  /* only needed for vp6 */
 
@@ -92,6 +122,20 @@ struct GOmxPort
 
 /* Macros. */
 
+/** upper limit of nBufferCountActual for the "input-buffers" and
+ * "output-buffers" properties */
+#define GOMX_PORT_MAX_BUFFERS 32
+
+/** value of those properties to set auto_buffers; 0 leaves the count to the
+ * element */
+#define GOMX_PORT_AUTO_BUFFERS -1
+
+/** apply the value of an "input-buffers" or "output-buffers" property */
+#define G_OMX_PORT_SET_BUFFER_COUNT(port, count) G_STMT_START {  \
+        (port)->auto_buffers = ((count) == GOMX_PORT_AUTO_BUFFERS); \
+        (port)->buffer_count = MAX ((count), 0);                   \
+    } G_STMT_END
+
 #define G_OMX_PORT_GET_PARAM(port, idx, param) G_STMT_START {  \
 		_G_OMX_INIT_PARAM (param);                         \
         (param)->nPortIndex = (port)->port_index;          \
@@ -123,6 +167,7 @@ struct GOmxPort
 
 GOmxPort *g_omx_port_new (GOmxCore *core, const gchar *name, guint index);
 void g_omx_port_free (GOmxPort *port);
+void g_omx_port_reset (GOmxPort *port);
 
 void g_omx_port_setup (GOmxPort *port, OMX_PARAM_PORTDEFINITIONTYPE *omx_port);
 void g_omx_port_prepare (GOmxPort *port);
@@ -135,9 +180,12 @@ void g_omx_port_flush (GOmxPort *port);
 void g_omx_port_enable (GOmxPort *port);
 void g_omx_port_disable (GOmxPort *port);
 void g_omx_port_finish (GOmxPort *port);
+void g_omx_port_settings_changed (GOmxPort *port);
 void g_omx_port_push_buffer (GOmxPort *port, OMX_BUFFERHEADERTYPE *omx_buffer);
 gint g_omx_port_send (GOmxPort *port, gpointer obj);
 gpointer g_omx_port_recv (GOmxPort *port);
+OMX_BUFFERHEADERTYPE *g_omx_port_lookup_buffer (GOmxPort *port, gconstpointer data);
+OMX_BUFFERHEADERTYPE *g_omx_port_get_buffer_header (GOmxPort *port, GstBuffer *buf);
 
 /*
  * Some domain specific port related utility functions:
@@ -70,15 +70,19 @@ create_src_caps (GstOmxBaseFilter *omx_base)
     GstCaps *caps;    
     GstOmxBaseVfpc *self;
     int width, height;
+    gint left, top, crop_width, crop_height;
     GstStructure *struc;
 
     self = GST_OMX_BASE_VFPC (omx_base);
     caps = gst_pad_peer_get_caps (omx_base->srcpad);
 
+    /* unless downstream asks for a size, keep the size of the crop area */
+    gstomx_vfpc_get_crop (self, &left, &top, &crop_width, &crop_height);
+
     if (gst_caps_is_empty (caps))
     {
-        width = self->in_width;
-        height = self->in_height;
+        width = crop_width;
+        height = crop_height;
     }
     else
     {
@@ -89,8 +93,8 @@ create_src_caps (GstOmxBaseFilter *omx_base)
         if (!(gst_structure_get_int (s, "width", &width) &&
             gst_structure_get_int (s, "height", &height)))
         {
-            width = self->in_width;
-            height = self->in_height;    
+            width = crop_width;
+            height = crop_height;
         }
     }
 
@@ -121,7 +125,6 @@ omx_setup (GstOmxBaseFilter *omx_base)
     OMX_PARAM_PORTDEFINITIONTYPE paramPort;
     OMX_PARAM_BUFFER_MEMORYTYPE memTypeCfg;
     OMX_PARAM_VFPC_NUMCHANNELPERHANDLE numChannels;
-    OMX_CONFIG_VIDCHANNEL_RESOLUTION chResolution;
     OMX_CONFIG_ALG_ENABLE algEnable;
     GstOmxBaseVfpc *self;
 
@@ -197,44 +200,14 @@ omx_setup (GstOmxBaseFilter *omx_base)
     if (err != OMX_ErrorNone)
         return;
 
-    /* Set input channel resolution */
-    GST_LOG_OBJECT (self, "Setting channel resolution (input)");
-
-    _G_OMX_INIT_PARAM (&chResolution);
-    chResolution.Frm0Width = self->in_width;
-    chResolution.Frm0Height = self->in_height;
-    chResolution.Frm0Pitch = self->in_stride;
-    chResolution.Frm1Width = 0;
-    chResolution.Frm1Height = 0;
-    chResolution.Frm1Pitch = 0;
-    chResolution.FrmStartX = 0;//self->left;
-    chResolution.FrmStartY = 0;//self->top;
-    chResolution.FrmCropWidth = 0;//self->in_width - self->left;
-    chResolution.FrmCropHeight = 0;//self->in_height - self->top;
-    chResolution.eDir = OMX_DirInput;
-    chResolution.nChId = 0;
-    err = OMX_SetConfig (gomx->omx_handle, OMX_TI_IndexConfigVidChResolution, &chResolution);
+    /* Set input channel resolution, along with the crop */
+    err = gstomx_vfpc_set_input_resolution (self);
 
     if (err != OMX_ErrorNone)
         return;
 
     /* Set output channel resolution */
-    GST_LOG_OBJECT (self, "Setting channel resolution (output)");
-
-    _G_OMX_INIT_PARAM (&chResolution);
-    chResolution.Frm0Width = self->out_width;
-    chResolution.Frm0Height = self->out_height;
-    chResolution.Frm0Pitch = self->out_stride;
-    chResolution.Frm1Width = 0;
-    chResolution.Frm1Height = 0;
-    chResolution.Frm1Pitch = 0;
-    chResolution.FrmStartX = 0;
-    chResolution.FrmStartY = 0;
-    chResolution.FrmCropWidth = 0;
-    chResolution.FrmCropHeight = 0;
-    chResolution.eDir = OMX_DirOutput;
-    chResolution.nChId = 0;
-    err = OMX_SetConfig (gomx->omx_handle, OMX_TI_IndexConfigVidChResolution, &chResolution);
+    err = gstomx_vfpc_set_output_resolution (self);
 
     if (err != OMX_ErrorNone)
         return;
@@ -265,6 +238,7 @@ type_instance_init (GTypeInstance *instance,
     self = GST_OMX_BASE_VFPC (instance);
 
     self->omx_setup = omx_setup;
+    self->create_src_caps = create_src_caps;
     g_object_set (self, "port-index", 0, NULL);
 }
 
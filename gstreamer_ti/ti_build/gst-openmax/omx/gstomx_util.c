@@ -22,6 +22,7 @@
 
 #include "gstomx_util.h"
 #include <dlfcn.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "gstomx.h"
@@ -74,9 +75,21 @@ imp_new (const gchar *name)
     return imp;
 }
 
+static void imp_deinit (GOmxImp *imp);
+static void pool_free (GOmxImp *imp, GList *handles, gboolean release_imp);
+
 static void
 imp_free (GOmxImp *imp)
 {
+    if (imp->handle_pool)
+    {
+        imp->client_count -= g_list_length (imp->handle_pool);
+        pool_free (imp, imp->handle_pool, FALSE);
+        imp->handle_pool = NULL;
+        if (imp->client_count == 0)
+            imp_deinit (imp);
+    }
+
     if (imp->dl_handle)
     {
         dlclose (imp->dl_handle);
@@ -129,6 +142,16 @@ g_omx_request_imp (const gchar *name)
     return imp;
 }
 
+static void
+imp_deinit (GOmxImp *imp)
+{
+    #ifdef USE_STATIC
+    OMX_Deinit();
+    #else
+    imp->sym_table.deinit ();
+    #endif
+}
+
 void
 g_omx_release_imp (GOmxImp *imp)
 {
@@ -136,13 +159,420 @@ g_omx_release_imp (GOmxImp *imp)
     imp->client_count--;
     if (imp->client_count == 0)
     {
+        imp_deinit (imp);
+    }
+    g_mutex_unlock (imp->mutex);
+}
+
+/*
+ * Handle pool:
+ *
+ * A core going to NULL with its component in OMX_StateLoaded hands the
+ * component to the pool of its library instead of freeing it, when its
+ * pool_size allows more components of that kind (component name and role)
+ * to be kept.  The next core asking for the same kind gets
+ * it, which saves OMX_GetHandle() when pipelines are torn down and built
+ * again.  A pooled component is kept for the pool_timeout of the core
+ * that released it, in ms (-1 for ever); expired ones are freed the next time the
+ * pool of their library is used.
+ *
+ * A core with a pool_prewarm count also fills the pool up to that many
+ * components of its kind, bounded by its pool_size, from a background
+ * thread once it has loaded its own (see g_omx_prewarm_handles()), so that
+ * the next element of that kind does not wait for OMX_GetHandle() either,
+ * not even the first one to come after startup.
+ *
+ * The size, the timeout and the prewarm count are per core: elements expose
+ * them as properties, and OMX_HANDLE_POOL, OMX_HANDLE_POOL_TIMEOUT and
+ * OMX_HANDLE_POOL_PREWARM in the environment only give their defaults, see
+ * g_omx_handle_pool_defaults().
+ *
+ * Only Loaded components are kept.  In OMX_StateIdle a component owns the
+ * buffers of its enabled ports, whose headers point at the GOmxPort and the
+ * buffer transports of the element that allocated them, and the port
+ * definitions can not be changed anymore.  Handing it over would need the
+ * next element to know its port configuration, buffer counts included,
+ * before it loads a component, whereas it only learns them from the
+ * component and from caps negotiation afterwards; and as the ports are
+ * configured again from Loaded on every startup anyway, a Loaded component
+ * leaves nothing to gain but the OMX_GetHandle().
+ *
+ * Each pooled component holds a reference on its GOmxImp, so that the
+ * library is not deinitialized underneath it.
+ */
+
+typedef struct
+{
+    OMX_HANDLETYPE handle;
+    gchar *kind;
+    glong timeout;
+    GTimeVal released;
+} GOmxPooledHandle;
+
+/**
+ * The size, the timeout and the prewarm count of the handle pool for
+ * elements which do not set their own, from OMX_HANDLE_POOL (0, no pool, by
+ * default), OMX_HANDLE_POOL_TIMEOUT (GOMX_HANDLE_POOL_TIMEOUT_DEFAULT by
+ * default) and OMX_HANDLE_POOL_PREWARM (0, none, by default).
+ */
+void
+g_omx_handle_pool_defaults (guint *size,
+                            gint *timeout,
+                            guint *prewarm)
+{
+    const gchar *value;
+
+    value = g_getenv ("OMX_HANDLE_POOL");
+    *size = value ? strtoul (value, NULL, 0) : 0;
+
+    value = g_getenv ("OMX_HANDLE_POOL_TIMEOUT");
+    *timeout = value ? strtol (value, NULL, 0) : GOMX_HANDLE_POOL_TIMEOUT_DEFAULT;
+
+    value = g_getenv ("OMX_HANDLE_POOL_PREWARM");
+    *prewarm = value ? strtoul (value, NULL, 0) : 0;
+}
+
+static gchar *
+handle_kind (const gchar *component_name,
+             const gchar *component_role)
+{
+    return g_strdup_printf ("%s/%s", component_name,
+                            component_role ? component_role : "");
+}
+
+/* Takes the components unused for longer than their timeout out of the
+ * pool, with imp->mutex held.
+ */
+static GList *
+pool_expire (GOmxImp *imp)
+{
+    GList *expired = NULL;
+    GList *list, *next;
+    GTimeVal now;
+
+    g_get_current_time (&now);
+
+    for (list = imp->handle_pool; list; list = next)
+    {
+        GOmxPooledHandle *pooled = list->data;
+        glong age;
+
+        next = list->next;
+
+        if (pooled->timeout < 0)
+            continue;
+
+        age = (now.tv_sec - pooled->released.tv_sec) * 1000 +
+              (now.tv_usec - pooled->released.tv_usec) / 1000;
+
+        if (age >= pooled->timeout)
+        {
+            imp->handle_pool = g_list_remove_link (imp->handle_pool, list);
+            expired = g_list_concat (expired, list);
+        }
+    }
+
+    return expired;
+}
+
+/* Frees components taken out of the pool, with imp->mutex not held unless
+ * release_imp is FALSE.
+ */
+static void
+pool_free (GOmxImp *imp,
+           GList *handles,
+           gboolean release_imp)
+{
+    GList *list;
+
+    for (list = handles; list; list = list->next)
+    {
+        GOmxPooledHandle *pooled = list->data;
+        OMX_ERRORTYPE omx_error;
+
+        #ifdef USE_STATIC
+        omx_error = OMX_FreeHandle (pooled->handle);
+        #else
+        omx_error = imp->sym_table.free_handle (pooled->handle);
+        #endif
+        GST_DEBUG ("OMX_FreeHandle(%p) -> %s (%s, pooled)", pooled->handle,
+                   g_omx_error_to_str (omx_error), pooled->kind);
+
+        g_free (pooled->kind);
+        g_free (pooled);
+
+        if (release_imp)
+            g_omx_release_imp (imp);
+    }
+
+    g_list_free (handles);
+}
+
+/**
+ * Takes a loaded component of the given kind out of the pool, or returns
+ * NULL if there is none.  The callbacks of the component are to be set by
+ * the caller, who also holds its own reference on imp.
+ */
+OMX_HANDLETYPE
+g_omx_acquire_handle (GOmxImp *imp,
+                      const gchar *component_name,
+                      const gchar *component_role)
+{
+    OMX_HANDLETYPE handle = NULL;
+    GList *expired;
+    GList *list;
+    gchar *kind;
+
+    kind = handle_kind (component_name, component_role);
+
+    g_mutex_lock (imp->mutex);
+
+    expired = pool_expire (imp);
+
+    /* the most recently used one */
+    for (list = g_list_last (imp->handle_pool); list; list = list->prev)
+    {
+        GOmxPooledHandle *pooled = list->data;
+
+        if (strcmp (pooled->kind, kind) == 0)
+        {
+            handle = pooled->handle;
+            imp->handle_pool = g_list_delete_link (imp->handle_pool, list);
+            g_free (pooled->kind);
+            g_free (pooled);
+            break;
+        }
+    }
+
+    g_mutex_unlock (imp->mutex);
+
+    pool_free (imp, expired, TRUE);
+
+    if (handle)
+    {
+        GST_DEBUG ("reusing %p (%s)", handle, kind);
+        g_omx_release_imp (imp);
+    }
+
+    g_free (kind);
+
+    return handle;
+}
+
+/**
+ * Puts a component in OMX_StateLoaded in the pool for timeout ms, unless
+ * size components of its kind are pooled already (size 0 disables the
+ * pool), in which case FALSE is returned and the caller is to free it.  The
+ * component must not call back into its previous owner anymore.
+ */
+gboolean
+g_omx_release_handle (GOmxImp *imp,
+                      OMX_HANDLETYPE handle,
+                      const gchar *component_name,
+                      const gchar *component_role,
+                      guint size,
+                      gint timeout)
+{
+    GList *expired;
+    GList *list;
+    gchar *kind;
+    guint count = 0;
+
+    if (size == 0 && !imp->handle_pool)
+        return FALSE;
+
+    kind = handle_kind (component_name, component_role);
+
+    g_mutex_lock (imp->mutex);
+
+    expired = pool_expire (imp);
+
+    for (list = imp->handle_pool; list; list = list->next)
+    {
+        GOmxPooledHandle *pooled = list->data;
+
+        if (strcmp (pooled->kind, kind) == 0)
+            count++;
+    }
+
+    if (count < size)
+    {
+        GOmxPooledHandle *pooled;
+
+        pooled = g_new0 (GOmxPooledHandle, 1);
+        pooled->handle = handle;
+        pooled->kind = kind;
+        pooled->timeout = timeout;
+        g_get_current_time (&pooled->released);
+
+        imp->handle_pool = g_list_append (imp->handle_pool, pooled);
+        imp->client_count++;
+
+        GST_DEBUG ("pooled %p (%s), %u of %u", handle, kind, count + 1, size);
+        kind = NULL;
+    }
+
+    g_mutex_unlock (imp->mutex);
+
+    pool_free (imp, expired, TRUE);
+
+    if (kind)
+    {
+        g_free (kind);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+typedef struct
+{
+    GOmxImp *imp;
+    gchar *component_name;
+    gchar *component_role;
+    guint count;
+    guint size;
+    gint timeout;
+} GOmxPrewarm;
+
+/* one thread, so that two elements of a kind do not both fill up the pool */
+static GThreadPool *prewarm_pool;
+G_LOCK_DEFINE_STATIC (prewarm_pool);
+
+/* A prewarmed component calls back nobody until a core acquires it. */
+static OMX_ERRORTYPE
+prewarm_event (OMX_HANDLETYPE omx_handle,
+               OMX_PTR app_data,
+               OMX_EVENTTYPE event,
+               OMX_U32 data_1,
+               OMX_U32 data_2,
+               OMX_PTR event_data)
+{
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+prewarm_buffer_done (OMX_HANDLETYPE omx_handle,
+                     OMX_PTR app_data,
+                     OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    return OMX_ErrorNone;
+}
+
+static OMX_CALLBACKTYPE prewarm_callbacks =
+        { prewarm_event, prewarm_buffer_done, prewarm_buffer_done };
+
+static void
+prewarm_thread (gpointer data,
+                gpointer user_data)
+{
+    GOmxPrewarm *prewarm = data;
+    GOmxImp *imp = prewarm->imp;
+    GList *list;
+    gchar *kind;
+    guint count = 0;
+
+    kind = handle_kind (prewarm->component_name, prewarm->component_role);
+
+    g_mutex_lock (imp->mutex);
+    for (list = imp->handle_pool; list; list = list->next)
+    {
+        GOmxPooledHandle *pooled = list->data;
+
+        if (strcmp (pooled->kind, kind) == 0)
+            count++;
+    }
+    g_mutex_unlock (imp->mutex);
+
+    for (; count < prewarm->count; count++)
+    {
+        OMX_HANDLETYPE handle = NULL;
+        OMX_ERRORTYPE omx_error;
+
         #ifdef USE_STATIC
-        OMX_Deinit();
+        omx_error = OMX_GetHandle (&handle, (char *) prewarm->component_name,
+                                   NULL, &prewarm_callbacks);
         #else
-        imp->sym_table.deinit ();
+        omx_error = imp->sym_table.get_handle (&handle,
+                                               (char *) prewarm->component_name,
+                                               NULL, &prewarm_callbacks);
         #endif
+        GST_DEBUG ("OMX_GetHandle(&%p) -> %s (%s, prewarm)", handle,
+                   g_omx_error_to_str (omx_error), kind);
+
+        if (omx_error || !handle)
+            break;
+
+        if (prewarm->component_role)
+        {
+            OMX_PARAM_COMPONENTROLETYPE param;
+
+            _G_OMX_INIT_PARAM (&param);
+            OMX_GetParameter (handle, OMX_IndexParamStandardComponentRole, &param);
+            strcpy ((char *) param.cRole, prewarm->component_role);
+            OMX_SetParameter (handle, OMX_IndexParamStandardComponentRole, &param);
+        }
+
+        if (!g_omx_release_handle (imp, handle, prewarm->component_name,
+                                   prewarm->component_role,
+                                   prewarm->size, prewarm->timeout))
+        {
+            /* filled up by released components in the meantime */
+            #ifdef USE_STATIC
+            OMX_FreeHandle (handle);
+            #else
+            imp->sym_table.free_handle (handle);
+            #endif
+            break;
+        }
     }
+
+    g_free (kind);
+    g_free (prewarm->component_name);
+    g_free (prewarm->component_role);
+    g_free (prewarm);
+
+    g_omx_release_imp (imp);
+}
+
+/**
+ * Fills the pool up to count loaded components of the given kind, but not
+ * beyond size, from a background thread; they are kept for timeout ms like
+ * the ones released by g_omx_release_handle().  The caller holds a reference
+ * on imp, which is taken for as long as that runs.
+ */
+void
+g_omx_prewarm_handles (GOmxImp *imp,
+                       const gchar *component_name,
+                       const gchar *component_role,
+                       guint count,
+                       guint size,
+                       gint timeout)
+{
+    GOmxPrewarm *prewarm;
+
+    count = MIN (count, size);
+    if (count == 0)
+        return;
+
+    g_mutex_lock (imp->mutex);
+    imp->client_count++;
     g_mutex_unlock (imp->mutex);
+
+    prewarm = g_new0 (GOmxPrewarm, 1);
+    prewarm->imp = imp;
+    prewarm->component_name = g_strdup (component_name);
+    prewarm->component_role = g_strdup (component_role);
+    prewarm->count = count;
+    prewarm->size = size;
+    prewarm->timeout = timeout;
+
+    G_LOCK (prewarm_pool);
+    if (!prewarm_pool)
+        prewarm_pool = g_thread_pool_new (prewarm_thread, NULL, 1, FALSE, NULL);
+    G_UNLOCK (prewarm_pool);
+
+    g_thread_pool_push (prewarm_pool, prewarm, NULL);
 }
 
 /*
@@ -67,8 +67,13 @@ struct GOmxImp
     void *dl_handle;
     GOmxSymbolTable sym_table;
     GMutex *mutex;
+    GList *handle_pool; /**< loaded components kept for reuse, see
+                             g_omx_release_handle() */
 };
 
+/** default time a component is kept in the handle pool, in ms */
+#define GOMX_HANDLE_POOL_TIMEOUT_DEFAULT 60000
+
 /* Functions. */
 
 void g_omx_init (void);
@@ -76,6 +81,10 @@ void g_omx_deinit (void);
 
 GOmxImp * g_omx_request_imp (const gchar *name);
 void g_omx_release_imp (GOmxImp *imp);
+OMX_HANDLETYPE g_omx_acquire_handle (GOmxImp *imp, const gchar *component_name, const gchar *component_role);
+gboolean g_omx_release_handle (GOmxImp *imp, OMX_HANDLETYPE handle, const gchar *component_name, const gchar *component_role, guint size, gint timeout);
+void g_omx_prewarm_handles (GOmxImp *imp, const gchar *component_name, const gchar *component_role, guint count, guint size, gint timeout);
+void g_omx_handle_pool_defaults (guint *size, gint *timeout, guint *prewarm);
 
 const char * g_omx_error_to_str (OMX_ERRORTYPE omx_error);
 OMX_COLOR_FORMATTYPE g_omx_fourcc_to_colorformat (guint32 fourcc);
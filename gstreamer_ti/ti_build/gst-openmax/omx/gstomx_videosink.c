@@ -161,8 +161,8 @@ exit:
     return ret;
 }
 
-static int
-get_display_mode_from_string (char *str, int *mode, int *maxWidth, int *maxHeight)
+void
+gstomx_videosink_get_display_mode (const char *str, int *mode, int *maxWidth, int *maxHeight)
 {
     if (!strcmp (str, "OMX_DC_MODE_1080P_30"))
     {
@@ -258,7 +258,7 @@ omx_setup (GstBaseSink *gst_sink, GstCaps *caps)
     g_omx_port_setup (omx_base->in_port, &param);
 
     /* get the display mode set via property */
-    get_display_mode_from_string (sink->display_mode, &mode, &maxWidth, &maxHeight);
+    gstomx_videosink_get_display_mode (sink->display_mode, &mode, &maxWidth, &maxHeight);
 
     /* set display driver mode */
     _G_OMX_INIT_PARAM (&driverId);
@@ -56,6 +56,8 @@ struct GstOmxVideoSinkClass
 
 GType gst_omx_videosink_get_type (void);
 
+void gstomx_videosink_get_display_mode (const char *str, int *mode, int *maxWidth, int *maxHeight);
+
 G_END_DECLS
 
 #endif /* GSTOMX_VIDEOSINK_H */
@@ -33,12 +33,22 @@ GST_DEBUG_CATEGORY_STATIC (gst_perf_debug);
 #define DEFAULT_INTERVAL  1
 #define PRINT_ARM_LOAD    TRUE
 #define PRINT_FPS         TRUE
+#define DEFAULT_MESSAGE   FALSE
+#define DEFAULT_FORMAT    GST_PERF_FORMAT_CSV
 
 enum
 {
   PROP_0,
   PROP_PRINT_ARM_LOAD,
-  PROP_PRINT_FPS
+  PROP_PRINT_FPS,
+  PROP_MESSAGE,
+  PROP_LOCATION,
+  PROP_FORMAT
+};
+
+/* lower bound of each latency bucket, in milliseconds, after "early" */
+static const gint latency_bounds[GST_PERF_LATENCY_BUCKETS - 1] = {
+  0, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512
 };
 
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -62,6 +72,36 @@ static GstFlowReturn gst_perf_transform_ip (GstBaseTransform * trans,GstBuffer *
 static gboolean gst_perf_start (GstBaseTransform * trans);
 static gboolean gst_perf_stop (GstBaseTransform * trans);
 static void gst_perf_set_property (GObject * object, guint prop_id, const GValue * value, GParamSpec * pspec);
+static void gst_perf_get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_perf_finalize (GObject * object);
+static gboolean gst_perf_src_event (GstBaseTransform * trans, GstEvent * event);
+
+GType
+gst_perf_format_get_type (void)
+{
+    static GType type = 0;
+
+    if (!type)
+    {
+        static const GEnumValue vals[] =
+        {
+            {GST_PERF_FORMAT_CSV,   "Comma separated values",  "csv"},
+            {GST_PERF_FORMAT_JSON,  "One JSON object per line", "json"},
+            {0, NULL, NULL },
+        };
+
+        type = g_enum_register_static ("GstPerfFormat", vals);
+    }
+
+    return type;
+}
+
+static void
+gst_perf_update_enabled (Gstperf * self)
+{
+    self->detailed = self->post_messages || self->location != NULL;
+    self->enabled = self->detailed || self->print_fps || self->print_arm_load;
+}
 
 static void
 gst_perf_init (Gstperf * perf, GstperfClass * gclass)
@@ -72,6 +112,9 @@ gst_perf_init (Gstperf * perf, GstperfClass * gclass)
     self->fps_update_interval = GST_SECOND * DEFAULT_INTERVAL;
     self->print_arm_load = PRINT_ARM_LOAD;
     self->print_fps = PRINT_FPS;
+    self->post_messages = DEFAULT_MESSAGE;
+    self->format = DEFAULT_FORMAT;
+    gst_perf_update_enabled (self);
 }
 
 static gboolean
@@ -97,9 +140,6 @@ display_current_fps (gpointer data)
     frames_count, rr, average_fps);
     g_print ("%s", fps_message);
 
-    self->last_frames_count = frames_count;
-    self->last_ts = current_ts;
-
     return TRUE;
 }
 
@@ -168,6 +208,8 @@ gst_perf_class_init (GstperfClass * klass)
     gobject_class = (GObjectClass *) klass;
 
     gobject_class->set_property = gst_perf_set_property;
+    gobject_class->get_property = gst_perf_get_property;
+    gobject_class->finalize = gst_perf_finalize;
     gobject_class = (GObjectClass *) klass;
     trans_class = (GstBaseTransformClass *) klass;
 
@@ -175,6 +217,7 @@ gst_perf_class_init (GstperfClass * klass)
     trans_class->prepare_output_buffer = GST_DEBUG_FUNCPTR (gst_perf_prepare_output_buffer);
     trans_class->start = GST_DEBUG_FUNCPTR (gst_perf_start);
     trans_class->stop = GST_DEBUG_FUNCPTR (gst_perf_stop);
+    trans_class->src_event = GST_DEBUG_FUNCPTR (gst_perf_src_event);
 
     trans_class->passthrough_on_same_caps = FALSE;
 
@@ -187,6 +230,31 @@ gst_perf_class_init (GstperfClass * klass)
     g_object_class_install_property (gobject_class, PROP_PRINT_FPS,
       g_param_spec_boolean ("print-fps", "print-fps",
           "Print framerate", PRINT_FPS, G_PARAM_WRITABLE));
+
+    g_object_class_install_property (gobject_class, PROP_MESSAGE,
+      g_param_spec_boolean ("message", "message",
+          "Post a \"perf\" element message with the statistics of every interval",
+          DEFAULT_MESSAGE, G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class, PROP_LOCATION,
+      g_param_spec_string ("location", "location",
+          "File to write the statistics of every interval to, opened on start",
+          NULL, G_PARAM_READWRITE));
+
+    g_object_class_install_property (gobject_class, PROP_FORMAT,
+      g_param_spec_enum ("format", "format",
+          "Format of the file written to location", GST_TYPE_PERF_FORMAT,
+          DEFAULT_FORMAT, G_PARAM_READWRITE));
+}
+
+static void
+gst_perf_finalize (GObject * object)
+{
+    Gstperf *perf = GST_PERF (object);
+
+    g_free (perf->location);
+
+    G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
 static void
@@ -204,86 +272,391 @@ gst_perf_set_property (GObject * object, guint prop_id,
             perf->print_fps = g_value_get_boolean(value);
             break;
 
+        case PROP_MESSAGE:
+            perf->post_messages = g_value_get_boolean(value);
+            break;
+
+        case PROP_LOCATION:
+            g_free (perf->location);
+            perf->location = g_value_dup_string(value);
+            break;
+
+        case PROP_FORMAT:
+            perf->format = g_value_get_enum(value);
+            break;
+
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
     }
+
+    gst_perf_update_enabled (perf);
 }
 
-static gboolean
-gst_perf_start (GstBaseTransform * trans)
+static void
+gst_perf_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
 {
-    Gstperf *self = (Gstperf *) trans;
+    Gstperf *perf = GST_PERF (object);
 
-    /* Init counters */
-    self->frames_count = G_GUINT64_CONSTANT (0);
-    self->total_size = G_GUINT64_CONSTANT (0);
-    self->last_frames_count = G_GUINT64_CONSTANT (0);
+    switch (prop_id) {
+        case PROP_MESSAGE:
+            g_value_set_boolean (value, perf->post_messages);
+            break;
 
-    /* init time stamps */
-    self->last_ts = self->start_ts = self->interval_ts = GST_CLOCK_TIME_NONE;
+        case PROP_LOCATION:
+            g_value_set_string (value, perf->location);
+            break;
 
-    return TRUE;
+        case PROP_FORMAT:
+            g_value_set_enum (value, perf->format);
+            break;
+
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+            break;
+    }
 }
 
-static gboolean
-gst_perf_stop (GstBaseTransform * trans)
+static void
+gst_perf_reset_interval (Gstperf * self)
 {
-
-    return TRUE;
+    self->interval_bytes = 0;
+    self->interval_min = GST_CLOCK_TIME_NONE;
+    self->interval_max = 0;
+    self->interval_sum = 0;
+    self->interval_count = 0;
+    memset (self->latency, 0, sizeof (self->latency));
+    self->dropped = 0;
+    g_atomic_int_set (&self->late, 0);
 }
 
-static int 
-print_cpu_load (Gstperf *perf)
+/* Reads the load of every core since the previous call, 0 for the first.
+ * Returns the number of cores found, with the overall load in cpu_load[0]
+ * and the one of each core from cpu_load[1] on.
+ */
+static guint
+read_cpu_load (Gstperf *perf)
 {
-    int   cpuLoadFound = FALSE;
-    unsigned long   nice, sys, idle, iowait, irq, softirq, steal;  
-    unsigned long   deltaTotal;
-    char  textBuf[4];
+    char line[256];
     FILE *fptr;
-    int load;
+    guint n = 0;
 
     /* Read the overall system information */
     fptr = fopen("/proc/stat", "r");
 
     if (fptr == NULL) {
-        return -1;
+        return 0;
     }
 
-    perf->prevTotal = perf->total;
-    perf->prevuserTime = perf->userTime;
+    /* the "cpu" and "cpuN" lines come first */
+    while (n <= GST_PERF_MAX_CPUS && fgets (line, sizeof (line), fptr) &&
+           strncmp (line, "cpu", 3) == 0) {
+        unsigned long user, nice, sys, idle;
+        unsigned long iowait = 0, irq = 0, softirq = 0, steal = 0;
+        unsigned long total, busy, deltaTotal;
 
-    /* Scan the file line by line */
-    while (fscanf(fptr, "%4s %lu %lu %lu %lu %lu %lu %lu %lu", textBuf,
-                  &perf->userTime, &nice, &sys, &idle, &iowait, &irq, &softirq,
-                  &steal) != EOF) {
-        if (strcmp(textBuf, "cpu") == 0) {
-            cpuLoadFound = TRUE;
-            break;
+        if (sscanf (line, "%*s %lu %lu %lu %lu %lu %lu %lu %lu", &user, &nice,
+                    &sys, &idle, &iowait, &irq, &softirq, &steal) < 4) {
+            continue;
+        }
+
+        total = user + nice + sys + idle + iowait + irq + softirq + steal;
+        busy = total - idle;
+        deltaTotal = total - perf->cpu_total[n];
+
+        if (perf->cpu_total[n] && deltaTotal) {
+            perf->cpu_load[n] = 100 * (busy - perf->cpu_busy[n]) / deltaTotal;
+        } else {
+            perf->cpu_load[n] = 0;
         }
+
+        perf->cpu_total[n] = total;
+        perf->cpu_busy[n] = busy;
+        n++;
+    }
+
+    fclose (fptr);
+
+    perf->ncpus = n ? n - 1 : 0;
+
+    return perf->ncpus;
+}
+
+static void
+write_header (Gstperf * self)
+{
+    guint i;
+
+    if (self->format != GST_PERF_FORMAT_CSV)
+        return;
+
+    fprintf (self->file, "time,frames,fps,average-fps,interval-min,"
+        "interval-avg,interval-max,bytes-per-second,dropped,late");
+
+    fprintf (self->file, ",latency-early");
+    for (i = 0; i < G_N_ELEMENTS (latency_bounds); i++)
+        fprintf (self->file, ",latency-%dms", latency_bounds[i]);
+
+    fprintf (self->file, ",cpu");
+    for (i = 0; i < self->ncpus; i++)
+        fprintf (self->file, ",cpu%d", i);
+
+    fprintf (self->file, "\n");
+    fflush (self->file);
+}
+
+static void
+write_structure (Gstperf * self, const GstStructure * s)
+{
+    const gchar *sep = (self->format == GST_PERF_FORMAT_CSV) ? "," : ", ";
+    gchar fps[G_ASCII_DTOSTR_BUF_SIZE], average_fps[G_ASCII_DTOSTR_BUF_SIZE];
+    gchar bps[G_ASCII_DTOSTR_BUF_SIZE];
+    const GValue *array;
+    guint64 frames;
+    GstClockTime time, min, avg, max;
+    gdouble value;
+    guint dropped, late, i, size;
+    gint cpu;
+
+    gst_structure_get_clock_time (s, "time", &time);
+    gst_structure_get_uint64 (s, "frames", &frames);
+    gst_structure_get_double (s, "fps", &value);
+    g_ascii_formatd (fps, sizeof (fps), "%.2f", value);
+    gst_structure_get_double (s, "average-fps", &value);
+    g_ascii_formatd (average_fps, sizeof (average_fps), "%.2f", value);
+    gst_structure_get_clock_time (s, "interval-min", &min);
+    gst_structure_get_clock_time (s, "interval-avg", &avg);
+    gst_structure_get_clock_time (s, "interval-max", &max);
+    gst_structure_get_double (s, "bytes-per-second", &value);
+    g_ascii_formatd (bps, sizeof (bps), "%.0f", value);
+    gst_structure_get_uint (s, "dropped", &dropped);
+    gst_structure_get_uint (s, "late", &late);
+    gst_structure_get_int (s, "cpu-load", &cpu);
+
+    if (self->format == GST_PERF_FORMAT_CSV) {
+        fprintf (self->file, "%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT
+            ",%s,%s,%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT ",%" G_GUINT64_FORMAT
+            ",%s,%u,%u,", time, frames, fps, average_fps, min, avg, max, bps,
+            dropped, late);
+    } else {
+        fprintf (self->file, "{\"time\": %" G_GUINT64_FORMAT ", \"frames\": %"
+            G_GUINT64_FORMAT ", \"fps\": %s, \"average-fps\": %s, "
+            "\"interval-min\": %" G_GUINT64_FORMAT ", \"interval-avg\": %"
+            G_GUINT64_FORMAT ", \"interval-max\": %" G_GUINT64_FORMAT ", "
+            "\"bytes-per-second\": %s, \"dropped\": %u, \"late\": %u, "
+            "\"latency-histogram\": [", time, frames, fps, average_fps, min, avg,
+            max, bps, dropped, late);
     }
 
-    if (fclose(fptr) != 0) {
-        return -1;
+    array = gst_structure_get_value (s, "latency-histogram");
+    size = gst_value_array_get_size (array);
+    for (i = 0; i < size; i++) {
+        fprintf (self->file, "%s%u", i ? sep : "",
+            g_value_get_uint (gst_value_array_get_value (array, i)));
     }
 
-    if (!cpuLoadFound) {
-        return -1;
+    if (self->format == GST_PERF_FORMAT_CSV)
+        fprintf (self->file, ",%d", cpu);
+    else
+        fprintf (self->file, "], \"cpu-load\": %d, \"cpu-core-load\": [", cpu);
+
+    array = gst_structure_get_value (s, "cpu-core-load");
+    size = gst_value_array_get_size (array);
+    for (i = 0; i < size; i++) {
+        fprintf (self->file, "%s%d",
+            (i || self->format == GST_PERF_FORMAT_CSV) ? sep : "",
+            g_value_get_int (gst_value_array_get_value (array, i)));
+    }
+
+    fprintf (self->file, (self->format == GST_PERF_FORMAT_CSV) ? "\n" : "]}\n");
+    fflush (self->file);
+}
+
+/* Bus message and file output for the interval ending at @ts */
+static void
+report_interval (Gstperf * self, GstClockTime ts)
+{
+    GstStructure *s;
+    GValue array = { 0 };
+    GValue item = { 0 };
+    gdouble time_diff, time_elapsed;
+    guint i;
+
+    time_diff = (gdouble) (ts - self->last_ts) / GST_SECOND;
+    time_elapsed = (gdouble) (ts - self->start_ts) / GST_SECOND;
+
+    s = gst_structure_new ("perf",
+        "time", GST_TYPE_CLOCK_TIME, (GstClockTime) (ts - self->start_ts),
+        "frames", G_TYPE_UINT64, self->frames_count,
+        "fps", G_TYPE_DOUBLE,
+        (gdouble) (self->frames_count - self->last_frames_count) / time_diff,
+        "average-fps", G_TYPE_DOUBLE, (gdouble) self->frames_count / time_elapsed,
+        "interval-min", GST_TYPE_CLOCK_TIME,
+        self->interval_count ? self->interval_min : (GstClockTime) 0,
+        "interval-avg", GST_TYPE_CLOCK_TIME,
+        self->interval_count ? self->interval_sum / self->interval_count : (GstClockTime) 0,
+        "interval-max", GST_TYPE_CLOCK_TIME, self->interval_max,
+        "bytes-per-second", G_TYPE_DOUBLE, (gdouble) self->interval_bytes / time_diff,
+        "dropped", G_TYPE_UINT, self->dropped,
+        "late", G_TYPE_UINT, (guint) g_atomic_int_get (&self->late),
+        "cpu-load", G_TYPE_INT, self->cpu_load[0],
+        NULL);
+
+    g_value_init (&array, GST_TYPE_ARRAY);
+    g_value_init (&item, G_TYPE_UINT);
+    for (i = 0; i < GST_PERF_LATENCY_BUCKETS; i++) {
+        g_value_set_uint (&item, self->latency[i]);
+        gst_value_array_append_value (&array, &item);
     }
+    gst_structure_set_value (s, "latency-histogram", &array);
+    g_value_unset (&item);
+    g_value_unset (&array);
+
+    g_value_init (&array, GST_TYPE_ARRAY);
+    g_value_init (&item, G_TYPE_INT);
+    for (i = 1; i <= self->ncpus; i++) {
+        g_value_set_int (&item, self->cpu_load[i]);
+        gst_value_array_append_value (&array, &item);
+    }
+    gst_structure_set_value (s, "cpu-core-load", &array);
+    g_value_unset (&item);
+    g_value_unset (&array);
 
-    perf->total = perf->userTime + nice + sys + idle + iowait + irq + softirq +
-                  steal;
-    perf->userTime += nice + sys + iowait + irq + softirq + steal;
-    deltaTotal = perf->total - perf->prevTotal;
+    if (self->file)
+        write_structure (self, s);
 
-    if(deltaTotal) {
-        load = 100 * (perf->userTime - perf->prevuserTime) / deltaTotal;
+    if (self->post_messages) {
+        gst_element_post_message (GST_ELEMENT_CAST (self),
+            gst_message_new_element (GST_OBJECT_CAST (self), s));
     } else {
-        load = 0;
+        gst_structure_free (s);
+    }
+}
+
+/* Per buffer statistics only the bus message and the file report */
+static void
+measure_buffer (Gstperf * self, GstBuffer * buf)
+{
+    GstBaseTransform *trans = GST_BASE_TRANSFORM (self);
+    GstClockTime timestamp = GST_BUFFER_TIMESTAMP (buf);
+    GstClockTime duration = GST_BUFFER_DURATION (buf);
+    GstClockTime running_time, base_time;
+    GstClock *clock;
+
+    if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+        return;
+
+    /* frames missing from the timestamp sequence were dropped upstream */
+    if (GST_CLOCK_TIME_IS_VALID (duration) && duration > 0 &&
+        GST_CLOCK_TIME_IS_VALID (self->next_timestamp) &&
+        timestamp > self->next_timestamp + duration / 2) {
+        self->dropped += (timestamp - self->next_timestamp + duration / 2) / duration;
+    }
+    self->next_timestamp = GST_CLOCK_TIME_IS_VALID (duration) ?
+        timestamp + duration : GST_CLOCK_TIME_NONE;
+
+    /* latency: how late the buffer passes by compared to its running time */
+    GST_OBJECT_LOCK (self);
+    clock = GST_ELEMENT_CLOCK (self);
+    if (clock)
+        gst_object_ref (clock);
+    base_time = GST_ELEMENT_CAST (self)->base_time;
+    GST_OBJECT_UNLOCK (self);
+
+    if (!clock)
+        return;
+
+    running_time = gst_segment_to_running_time (&trans->segment,
+        GST_FORMAT_TIME, timestamp);
+
+    if (GST_CLOCK_TIME_IS_VALID (running_time)) {
+        GstClockTimeDiff latency;
+        guint i;
+
+        latency = GST_CLOCK_DIFF (base_time + running_time,
+            gst_clock_get_time (clock));
+
+        if (latency < 0) {
+            i = 0;
+        } else {
+            for (i = G_N_ELEMENTS (latency_bounds); i > 1; i--) {
+                if (latency >= (GstClockTimeDiff) (latency_bounds[i - 1] * GST_MSECOND))
+                    break;
+            }
+        }
+
+        self->latency[i]++;
+    }
+
+    gst_object_unref (clock);
+}
+
+static gboolean
+gst_perf_src_event (GstBaseTransform * trans, GstEvent * event)
+{
+    Gstperf *self = GST_PERF (trans);
+
+    if (self->detailed && GST_EVENT_TYPE (event) == GST_EVENT_QOS) {
+        gdouble proportion;
+        GstClockTimeDiff diff;
+        GstClockTime timestamp;
+
+        gst_event_parse_qos (event, &proportion, &diff, &timestamp);
+        if (diff > 0)
+            g_atomic_int_inc (&self->late);
     }
 
-    g_print ("\tarm-load: %d", load);
-    return 0;
+    return GST_BASE_TRANSFORM_CLASS (parent_class)->src_event (trans, event);
+}
+
+static gboolean
+gst_perf_start (GstBaseTransform * trans)
+{
+    Gstperf *self = (Gstperf *) trans;
+
+    /* Init counters */
+    self->frames_count = G_GUINT64_CONSTANT (0);
+    self->total_size = G_GUINT64_CONSTANT (0);
+    self->last_frames_count = G_GUINT64_CONSTANT (0);
+
+    /* init time stamps */
+    self->last_ts = self->start_ts = self->interval_ts = GST_CLOCK_TIME_NONE;
+    self->prev_buffer_ts = self->next_timestamp = GST_CLOCK_TIME_NONE;
+
+    gst_perf_reset_interval (self);
+
+    /* baseline for the load of the first interval */
+    memset (self->cpu_total, 0, sizeof (self->cpu_total));
+    memset (self->cpu_load, 0, sizeof (self->cpu_load));
+    read_cpu_load (self);
+
+    if (self->location) {
+        self->file = fopen (self->location, "w");
+        if (!self->file) {
+            GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE,
+                ("Could not open file \"%s\" for writing.", self->location),
+                GST_ERROR_SYSTEM);
+            return FALSE;
+        }
+
+        write_header (self);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+gst_perf_stop (GstBaseTransform * trans)
+{
+    Gstperf *self = (Gstperf *) trans;
+
+    if (self->file) {
+        fclose (self->file);
+        self->file = NULL;
+    }
+
+    return TRUE;
 }
 
 static GstFlowReturn
@@ -292,25 +665,52 @@ gst_perf_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
     Gstperf *self = GST_PERF (trans);
     GstClockTime ts;
 
+    /* nothing is reported, stay out of the way */
+    if (!self->enabled)
+        return GST_FLOW_OK;
+
     {
         self->frames_count++;
         self->total_size += GST_BUFFER_SIZE(buf);
+        self->interval_bytes += GST_BUFFER_SIZE(buf);
 
         ts = gst_util_get_timestamp ();
         if (G_UNLIKELY (!GST_CLOCK_TIME_IS_VALID (self->start_ts))) {
             self->interval_ts = self->last_ts = self->start_ts = ts;
+        } else {
+            GstClockTime interval = ts - self->prev_buffer_ts;
+
+            self->interval_min = MIN (self->interval_min, interval);
+            self->interval_max = MAX (self->interval_max, interval);
+            self->interval_sum += interval;
+            self->interval_count++;
         }
+        self->prev_buffer_ts = ts;
 
-        if (GST_CLOCK_DIFF (self->interval_ts, ts) > self->fps_update_interval) {
+        if (self->detailed)
+            measure_buffer (self, buf);
+
+        if (GST_CLOCK_DIFF (self->interval_ts, ts) > (GstClockTimeDiff) self->fps_update_interval) {
+
+            if (self->print_arm_load || self->detailed)
+                read_cpu_load (self);
 
             if (self->print_fps) 
                 display_current_fps (self);
 
             if (self->print_arm_load) 
-                print_cpu_load (self);
+                g_print ("\tarm-load: %d", self->cpu_load[0]);
+
+            if (self->print_fps || self->print_arm_load)
+                g_print ("\n");
+
+            if (self->detailed)
+                report_interval (self, ts);
 
-            g_print ("\n");
+            self->last_frames_count = self->frames_count;
+            self->last_ts = ts;
             self->interval_ts = ts;
+            gst_perf_reset_interval (self);
         }
     }
 
@@ -45,6 +45,19 @@ G_BEGIN_DECLS
 typedef struct _Gstperf      Gstperf;
 typedef struct _GstperfClass GstperfClass;
 
+#define GST_TYPE_PERF_FORMAT (gst_perf_format_get_type())
+
+/* Format of the file written to the location property */
+typedef enum
+{
+  GST_PERF_FORMAT_CSV,
+  GST_PERF_FORMAT_JSON
+} GstPerfFormat;
+
+/* Latency buckets: early, then [0, 1ms), [1ms, 2ms) ... [512ms, inf) */
+#define GST_PERF_LATENCY_BUCKETS 12
+#define GST_PERF_MAX_CPUS 32
+
 /* _Gstperf object */
 struct _Gstperf
 {
@@ -60,11 +73,35 @@ struct _Gstperf
   GstClockTime last_ts;
   GstClockTime interval_ts;
 
-  gboolean print_fps, print_arm_load, fps_update_interval;
-  unsigned long int  total;
-  unsigned long int  prevTotal;
-  unsigned long int userTime;
-  unsigned long int  prevuserTime;
+  gboolean print_fps, print_arm_load;
+  GstClockTime fps_update_interval;
+
+  /* structured output */
+  gboolean post_messages;
+  gchar *location;
+  GstPerfFormat format;
+  FILE *file;
+
+  /* any output enabled, buffers are not looked at otherwise */
+  gboolean enabled;
+  /* bus message or file enabled, collect the per buffer statistics */
+  gboolean detailed;
+
+  /* per interval statistics */
+  guint64 interval_bytes;
+  GstClockTime prev_buffer_ts;
+  GstClockTime interval_min, interval_max, interval_sum;
+  guint interval_count;
+  guint latency[GST_PERF_LATENCY_BUCKETS];
+  GstClockTime next_timestamp;
+  guint dropped;
+  gint late;
+
+  /* CPU load from /proc/stat, index 0 for all the cores together */
+  guint ncpus;
+  unsigned long cpu_total[GST_PERF_MAX_CPUS + 1];
+  unsigned long cpu_busy[GST_PERF_MAX_CPUS + 1];
+  gint cpu_load[GST_PERF_MAX_CPUS + 1];
 };
 
 /* _GstperfClass object */
@@ -75,6 +112,7 @@ struct _GstperfClass
 
 /* External function enclarations */
 GType gst_perf_get_type(void);
+GType gst_perf_format_get_type(void);
 
 G_END_DECLS
 
@@ -111,6 +111,91 @@ START_TEST (test_async_queue_process)
 }
 END_TEST
 
+START_TEST (test_async_queue_wrap)
+{
+    AsyncQueue *queue;
+    gpointer foo;
+    gpointer bar;
+    guint i;
+
+    queue = async_queue_new_full (4);
+    fail_if (!queue,
+             "Construction failed");
+
+    /* keep the ring partially filled so head and tail wrap around */
+    foo = bar = GINT_TO_POINTER (1);
+    for (i = 0; i < PROCESS_COUNT; i++, foo++)
+    {
+        async_queue_push (queue, foo);
+        if (i % 3 != 2)
+        {
+            gpointer tmp;
+            tmp = async_queue_pop (queue);
+            fail_if (tmp != bar,
+                     "Pop failed");
+            bar++;
+        }
+    }
+
+    /* more than the initial capacity is still queued */
+    fail_if (queue->length <= 4,
+             "Wrong length");
+
+    while (queue->length)
+    {
+        gpointer tmp;
+        tmp = async_queue_pop (queue);
+        fail_if (tmp != bar,
+                 "Pop failed");
+        bar++;
+    }
+
+    fail_if (bar != foo,
+             "Elements lost");
+
+    async_queue_free (queue);
+}
+END_TEST
+
+START_TEST (test_async_queue_capacity)
+{
+    AsyncQueue *queue;
+    gpointer foo;
+    guint i;
+
+    queue = async_queue_new_full (2);
+    fail_if (!queue,
+             "Construction failed");
+
+    foo = GINT_TO_POINTER (1);
+    async_queue_push (queue, foo++);
+    async_queue_pop (queue);
+    async_queue_push (queue, foo++);
+
+    /* growing must keep the queued element, even if it was wrapped */
+    async_queue_set_capacity (queue, 8);
+    fail_if (queue->capacity != 8,
+             "Capacity not set");
+
+    for (i = 0; i < 7; i++, foo++)
+        async_queue_push (queue, foo);
+
+    fail_if (queue->capacity != 8,
+             "Unexpected reallocation");
+
+    foo = GINT_TO_POINTER (2);
+    for (i = 0; i < 8; i++, foo++)
+    {
+        gpointer tmp;
+        tmp = async_queue_pop (queue);
+        fail_if (tmp != foo,
+                 "Pop failed");
+    }
+
+    async_queue_free (queue);
+}
+END_TEST
+
 static gpointer
 push_func (gpointer data)
 {
@@ -392,6 +477,8 @@ util_suite (void)
     tcase_add_test (tc_core, test_async_queue_create);
     tcase_add_test (tc_core, test_async_queue_pop);
     tcase_add_test (tc_core, test_async_queue_process);
+    tcase_add_test (tc_core, test_async_queue_wrap);
+    tcase_add_test (tc_core, test_async_queue_capacity);
     tcase_add_test (tc_core, test_async_queue_threads);
     tcase_add_test (tc_core, test_async_queue_disable_simple);
     tcase_add_test (tc_core, test_async_queue_disable);
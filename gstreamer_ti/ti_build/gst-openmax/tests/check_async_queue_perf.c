@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/*
+ * Stress benchmark for AsyncQueue.  A producer thread plays the part of the
+ * OMX callback thread and a consumer thread the part of the pad task.  The
+ * producer can only have QUEUE_DEPTH elements in flight, like a port with
+ * QUEUE_DEPTH buffer headers.  The ring based AsyncQueue is compared against
+ * the GList based implementation it replaced.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+
+#include "async_queue.h"
+#include "sem.h"
+
+#define PROCESS_COUNT 0x40000
+#define QUEUE_DEPTH 32
+
+/*
+ * Reference GList based queue, as async_queue.c was before the ring.
+ */
+
+typedef struct ListQueue ListQueue;
+
+struct ListQueue
+{
+    GMutex *mutex;
+    GCond *condition;
+    GList *head;
+    GList *tail;
+    guint length;
+};
+
+static gpointer
+list_queue_new (void)
+{
+    ListQueue *queue;
+
+    queue = g_slice_new0 (ListQueue);
+    queue->condition = g_cond_new ();
+    queue->mutex = g_mutex_new ();
+
+    return queue;
+}
+
+static void
+list_queue_free (gpointer data)
+{
+    ListQueue *queue = data;
+
+    g_cond_free (queue->condition);
+    g_mutex_free (queue->mutex);
+    g_list_free (queue->head);
+    g_slice_free (ListQueue, queue);
+}
+
+static void
+list_queue_push (gpointer data,
+                 gpointer item)
+{
+    ListQueue *queue = data;
+
+    g_mutex_lock (queue->mutex);
+
+    queue->head = g_list_prepend (queue->head, item);
+    if (!queue->tail)
+        queue->tail = queue->head;
+    queue->length++;
+
+    g_cond_signal (queue->condition);
+
+    g_mutex_unlock (queue->mutex);
+}
+
+static gpointer
+list_queue_pop (gpointer data)
+{
+    ListQueue *queue = data;
+    gpointer item = NULL;
+
+    g_mutex_lock (queue->mutex);
+
+    if (!queue->tail)
+        g_cond_wait (queue->condition, queue->mutex);
+
+    if (queue->tail)
+    {
+        GList *node = queue->tail;
+        item = node->data;
+
+        queue->tail = node->prev;
+        if (queue->tail)
+            queue->tail->next = NULL;
+        else
+            queue->head = NULL;
+        queue->length--;
+        g_list_free_1 (node);
+    }
+
+    g_mutex_unlock (queue->mutex);
+
+    return item;
+}
+
+/*
+ * Wrappers for the ring based AsyncQueue.
+ */
+
+static gpointer
+ring_queue_new (void)
+{
+    return async_queue_new_full (QUEUE_DEPTH);
+}
+
+static void
+ring_queue_free (gpointer data)
+{
+    async_queue_free (data);
+}
+
+static void
+ring_queue_push (gpointer data,
+                 gpointer item)
+{
+    async_queue_push (data, item);
+}
+
+static gpointer
+ring_queue_pop (gpointer data)
+{
+    return async_queue_pop (data);
+}
+
+typedef struct QueueImpl QueueImpl;
+
+struct QueueImpl
+{
+    const gchar *name;
+    gpointer (*new) (void);
+    void (*free) (gpointer queue);
+    void (*push) (gpointer queue, gpointer item);
+    gpointer (*pop) (gpointer queue);
+};
+
+static const QueueImpl list_impl = {
+    "list", list_queue_new, list_queue_free, list_queue_push, list_queue_pop
+};
+
+static const QueueImpl ring_impl = {
+    "ring", ring_queue_new, ring_queue_free, ring_queue_push, ring_queue_pop
+};
+
+typedef struct CustomData CustomData;
+
+struct CustomData
+{
+    const QueueImpl *impl;
+    gpointer queue;
+    GSem *credits;
+    GTimeVal *push_time;
+    gint64 *latency;
+    guint popped;
+    gboolean in_order;
+};
+
+static inline gint64
+elapsed_usec (const GTimeVal *start,
+              const GTimeVal *end)
+{
+    return (end->tv_sec - start->tv_sec) * G_GINT64_CONSTANT (1000000) +
+           (end->tv_usec - start->tv_usec);
+}
+
+static gpointer
+push_func (gpointer data)
+{
+    CustomData *custom_data = data;
+    guint i;
+
+    for (i = 0; i < PROCESS_COUNT; i++)
+    {
+        g_sem_down (custom_data->credits);
+        g_get_current_time (&custom_data->push_time[i]);
+        custom_data->impl->push (custom_data->queue, GUINT_TO_POINTER (i + 1));
+    }
+
+    return NULL;
+}
+
+static gpointer
+pop_func (gpointer data)
+{
+    CustomData *custom_data = data;
+    guint i;
+
+    custom_data->in_order = TRUE;
+
+    for (i = 0; i < PROCESS_COUNT; )
+    {
+        gpointer tmp;
+        guint index;
+        GTimeVal now;
+
+        tmp = custom_data->impl->pop (custom_data->queue);
+        if (!tmp)
+            continue;
+
+        g_get_current_time (&now);
+        index = GPOINTER_TO_UINT (tmp) - 1;
+
+        if (index != i)
+            custom_data->in_order = FALSE;
+
+        custom_data->latency[i] =
+            elapsed_usec (&custom_data->push_time[index], &now);
+        custom_data->popped++;
+        i++;
+
+        g_sem_up (custom_data->credits);
+    }
+
+    return NULL;
+}
+
+static int
+compare_gint64 (const void *a,
+                const void *b)
+{
+    gint64 x = *(const gint64 *) a;
+    gint64 y = *(const gint64 *) b;
+
+    return (x > y) - (x < y);
+}
+
+static void
+run_benchmark (const QueueImpl *impl)
+{
+    CustomData *custom_data;
+    GThread *push_thread;
+    GThread *pop_thread;
+    GTimer *timer;
+    gdouble seconds;
+    guint i;
+
+    custom_data = g_new0 (CustomData, 1);
+    custom_data->impl = impl;
+    custom_data->queue = impl->new ();
+    custom_data->credits = g_sem_new ();
+    custom_data->push_time = g_new0 (GTimeVal, PROCESS_COUNT);
+    custom_data->latency = g_new0 (gint64, PROCESS_COUNT);
+
+    for (i = 0; i < QUEUE_DEPTH; i++)
+        g_sem_up (custom_data->credits);
+
+    timer = g_timer_new ();
+
+    pop_thread = g_thread_create (pop_func, custom_data, TRUE, NULL);
+    push_thread = g_thread_create (push_func, custom_data, TRUE, NULL);
+
+    g_thread_join (push_thread);
+    g_thread_join (pop_thread);
+
+    seconds = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    fail_if (custom_data->popped != PROCESS_COUNT,
+             "%s: lost elements", impl->name);
+    fail_if (!custom_data->in_order,
+             "%s: elements out of order", impl->name);
+
+    qsort (custom_data->latency, PROCESS_COUNT, sizeof (gint64),
+           compare_gint64);
+
+    g_print ("%s: %u push/pop in %.3f s, %.0f ops/s, "
+             "latency p50=%" G_GINT64_FORMAT " p99=%" G_GINT64_FORMAT
+             " p99.9=%" G_GINT64_FORMAT " max=%" G_GINT64_FORMAT " usec\n",
+             impl->name, PROCESS_COUNT, seconds, PROCESS_COUNT / seconds,
+             custom_data->latency[PROCESS_COUNT / 2],
+             custom_data->latency[PROCESS_COUNT * 99 / 100],
+             custom_data->latency[PROCESS_COUNT * 999 / 1000],
+             custom_data->latency[PROCESS_COUNT - 1]);
+
+    g_free (custom_data->latency);
+    g_free (custom_data->push_time);
+    g_sem_free (custom_data->credits);
+    impl->free (custom_data->queue);
+    g_free (custom_data);
+}
+
+START_TEST (test_async_queue_perf_list)
+{
+    run_benchmark (&list_impl);
+}
+END_TEST
+
+START_TEST (test_async_queue_perf_ring)
+{
+    run_benchmark (&ring_impl);
+}
+END_TEST
+
+Suite *
+util_suite (void)
+{
+    Suite *s = suite_create ("util-perf");
+
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+    TCase *tc_perf = tcase_create ("Perf");
+    tcase_set_timeout (tc_perf, 60);
+    tcase_add_test (tc_perf, test_async_queue_perf_list);
+    tcase_add_test (tc_perf, test_async_queue_perf_ring);
+    suite_add_tcase (s, tc_perf);
+
+    return s;
+}
+
+int
+main (void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = util_suite ();
+    sr = srunner_create (s);
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+
+    return (number_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The "input-buffers" and "output-buffers" of GstOmxBaseFilter, run on
+ * omx_h264dec against the DM816x mock in standalone/dm816x.c, with a sink
+ * holding on to the last few frames: a count that is set overrides the one
+ * of the element, 0 (the default) leaves it to the element, -1 sizes the
+ * ports from what the previous run used, and "input-memory" and
+ * "output-memory" report what the buffers take.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define BUFFER_SIZE 0x100
+#define FRAME_COUNT 32
+
+/* what omx_h264dec sets up */
+#define H264DEC_OUTPUT_BUFFERS 6
+
+/* see standalone/dm816x.c */
+#define MOCK_INPUT_BUFFERS_MIN 2
+#define MOCK_OUTPUT_BUFFERS_MIN 4
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-h264"));
+
+static GstElement *filter;
+static GstPad *mysrcpad;
+static GstPad *mysinkpad;
+
+static GMutex *eos_mutex;
+static GCond *eos_cond;
+static gboolean eos;
+
+/* the frames the sink holds on to */
+static GQueue *held;
+static guint hold;
+
+/* the buffer counts and memory seen while decoding */
+static gint input_buffers;
+static gint output_buffers;
+static guint64 input_memory;
+static guint64 output_memory;
+
+static GstFlowReturn
+test_sink_chain (GstPad *pad,
+                 GstBuffer *buf)
+{
+    if (!output_memory)
+    {
+        g_object_get (filter,
+                      "input-buffers", &input_buffers,
+                      "output-buffers", &output_buffers,
+                      "input-memory", &input_memory,
+                      "output-memory", &output_memory,
+                      NULL);
+    }
+
+    g_queue_push_tail (held, buf);
+    while (g_queue_get_length (held) > hold)
+        gst_buffer_unref (g_queue_pop_head (held));
+
+    return GST_FLOW_OK;
+}
+
+static gboolean
+test_sink_event (GstPad *pad,
+                 GstEvent *event)
+{
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        g_mutex_lock (eos_mutex);
+        eos = TRUE;
+        g_cond_signal (eos_cond);
+        g_mutex_unlock (eos_mutex);
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+static void
+setup (void)
+{
+    filter = gst_check_setup_element ("omx_h264dec");
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+
+    gst_pad_set_chain_function (mysinkpad, test_sink_chain);
+    gst_pad_set_event_function (mysinkpad, test_sink_event);
+
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    g_object_set (G_OBJECT (filter), "library-name", "libomxil-dm816x.so", NULL);
+
+    eos_mutex = g_mutex_new ();
+    eos_cond = g_cond_new ();
+    held = g_queue_new ();
+}
+
+static void
+teardown (void)
+{
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_check_teardown_element (filter);
+
+    g_queue_free (held);
+    g_mutex_free (eos_mutex);
+    g_cond_free (eos_cond);
+}
+
+/* Decode FRAME_COUNT frames from NULL to NULL, with the sink holding the
+ * last @frames of them until the end.
+ */
+static void
+decode (guint frames)
+{
+    GstCaps *caps;
+    guint i;
+
+    hold = frames;
+    eos = FALSE;
+    input_buffers = output_buffers = 0;
+    input_memory = output_memory = 0;
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    caps = gst_caps_from_string ("video/x-h264,width=176,height=144,framerate=30/1");
+
+    for (i = 0; i < FRAME_COUNT; i++)
+    {
+        GstBuffer *inbuffer;
+
+        inbuffer = gst_buffer_new_and_alloc (BUFFER_SIZE);
+        memset (GST_BUFFER_DATA (inbuffer), 0, BUFFER_SIZE);
+        GST_BUFFER_TIMESTAMP (inbuffer) = i * GST_SECOND / 30;
+        gst_buffer_set_caps (inbuffer, caps);
+
+        fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+    }
+
+    gst_caps_unref (caps);
+
+    fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+    g_mutex_lock (eos_mutex);
+    while (!eos)
+        g_cond_wait (eos_cond, eos_mutex);
+    g_mutex_unlock (eos_mutex);
+
+    /* the output port only goes down with all of its buffers back */
+    while (!g_queue_is_empty (held))
+        gst_buffer_unref (g_queue_pop_head (held));
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+}
+
+GST_START_TEST (test_default)
+{
+    decode (2);
+    fail_unless_equals_int (output_buffers, H264DEC_OUTPUT_BUFFERS);
+
+    /* and back to it after being tuned */
+    g_object_set (G_OBJECT (filter), "output-buffers", -1, NULL);
+    decode (0);
+    decode (0);
+    fail_unless_equals_int (output_buffers, MOCK_OUTPUT_BUFFERS_MIN + 1);
+
+    g_object_set (G_OBJECT (filter), "output-buffers", 0, NULL);
+    decode (0);
+    fail_unless_equals_int (output_buffers, H264DEC_OUTPUT_BUFFERS);
+}
+GST_END_TEST
+
+GST_START_TEST (test_fixed)
+{
+    guint64 memory;
+
+    /* above the old limit of 10, and over the 6 omx_h264dec sets up */
+    g_object_set (G_OBJECT (filter),
+                  "input-buffers", 3,
+                  "output-buffers", 20,
+                  NULL);
+
+    decode (2);
+
+    fail_unless_equals_int (input_buffers, 3);
+    fail_unless_equals_int (output_buffers, 20);
+    fail_unless (input_memory > 0);
+    fail_unless (output_memory > 0);
+    fail_unless (output_memory % 20 == 0);
+
+    /* nothing allocated outside of PAUSED and PLAYING */
+    g_object_get (filter, "output-memory", &memory, NULL);
+    fail_unless (memory == 0);
+
+    /* down to the minimum of the component */
+    g_object_set (G_OBJECT (filter), "output-buffers", 1, NULL);
+    decode (0);
+    fail_unless_equals_int (output_buffers, MOCK_OUTPUT_BUFFERS_MIN);
+}
+GST_END_TEST
+
+GST_START_TEST (test_auto)
+{
+    guint first, tuned;
+    guint64 memory;
+
+    g_object_set (G_OBJECT (filter),
+                  "input-buffers", -1,
+                  "output-buffers", -1,
+                  NULL);
+
+    /* nothing to go by: the minimum, and one on its way downstream */
+    decode (2);
+    first = output_buffers;
+    memory = output_memory;
+    fail_unless_equals_int (first, MOCK_OUTPUT_BUFFERS_MIN + 1);
+    fail_unless_equals_int (input_buffers, MOCK_INPUT_BUFFERS_MIN);
+
+    /* the sink held 2 frames while the next one came: the component ran
+     * short, and gets the minimum on top of those 3 */
+    decode (2);
+    tuned = output_buffers;
+    fail_unless_equals_int (tuned, MOCK_OUTPUT_BUFFERS_MIN + 3);
+    fail_unless (output_memory > memory);
+
+    /* which is enough */
+    decode (2);
+    fail_unless_equals_int (output_buffers, tuned);
+
+    /* and shrinks back once the sink keeps nothing */
+    decode (0);
+    decode (0);
+    fail_unless_equals_int (output_buffers, MOCK_OUTPUT_BUFFERS_MIN + 1);
+
+    /* the component hands input back straight away, so it never needs
+     * more than one buffer on top of the one being filled */
+    fail_unless (input_buffers >= MOCK_INPUT_BUFFERS_MIN);
+    fail_unless (input_buffers <= MOCK_INPUT_BUFFERS_MIN + 1);
+}
+GST_END_TEST
+
+static Suite *
+buffer_count_suite (void)
+{
+    Suite *s = suite_create ("buffer_count");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 30);
+    tcase_add_checked_fixture (tc_chain, setup, teardown);
+    tcase_add_test (tc_chain, test_default);
+    tcase_add_test (tc_chain, test_fixed);
+    tcase_add_test (tc_chain, test_auto);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (buffer_count);
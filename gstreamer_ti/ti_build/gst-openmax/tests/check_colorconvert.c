@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The gstcolorconvert element and its kernels: every conversion between
+ * NV12, I420, YUY2 and UYVY is checked pixel by pixel against the
+ * definition, the NEON kernels against the scalar ones where built, and the
+ * element with plain and strided caps.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gstcolorconvert_kernels.h"
+
+static const GstVideoFormat formats[] = {
+    GST_VIDEO_FORMAT_NV12,
+    GST_VIDEO_FORMAT_I420,
+    GST_VIDEO_FORMAT_YUY2,
+    GST_VIDEO_FORMAT_UYVY,
+};
+
+static gboolean
+is_420 (GstVideoFormat format)
+{
+    return format == GST_VIDEO_FORMAT_I420 || format == GST_VIDEO_FORMAT_NV12;
+}
+
+/*
+ * Samples of a frame, straight from the definition of the formats.
+ */
+
+static guint8 *
+sample (const GstColorConvertFrame *frame,
+        gint component,
+        gint x,
+        gint y)
+{
+    guint8 *row;
+
+    switch (frame->format)
+    {
+        case GST_VIDEO_FORMAT_NV12:
+            if (component == 0)
+                return frame->data[0] + y * frame->stride[0] + x;
+            return frame->data[1] + (y / 2) * frame->stride[1] + 2 * x + component - 1;
+        case GST_VIDEO_FORMAT_I420:
+            if (component == 0)
+                return frame->data[0] + y * frame->stride[0] + x;
+            return frame->data[component] + (y / 2) * frame->stride[component] + x;
+        case GST_VIDEO_FORMAT_YUY2:
+            row = frame->data[0] + y * frame->stride[0];
+            if (component == 0)
+                return row + 2 * x;
+            return row + 4 * x + (component == 1 ? 1 : 3);
+        case GST_VIDEO_FORMAT_UYVY:
+            row = frame->data[0] + y * frame->stride[0];
+            if (component == 0)
+                return row + 2 * x + 1;
+            return row + 4 * x + (component == 1 ? 0 : 2);
+        default:
+            g_assert_not_reached ();
+            return NULL;
+    }
+}
+
+/* Luma at x, chroma at x for pixel pair x */
+#define SAMPLE(frame, c, x, y) (*sample ((frame), (c), (x), (y)))
+
+static void
+check_converted (const GstColorConvertFrame *src,
+                 const GstColorConvertFrame *dst)
+{
+    gint x, y, c;
+
+    for (y = 0; y < src->height; y++)
+    {
+        for (x = 0; x < src->width; x++)
+            fail_unless_equals_int (SAMPLE (dst, 0, x, y), SAMPLE (src, 0, x, y));
+
+        /* once per chroma row of dst */
+        if (is_420 (dst->format) && y % 2)
+            continue;
+
+        for (x = 0; x < src->width / 2; x++)
+        {
+            for (c = 1; c <= 2; c++)
+            {
+                gint expected;
+
+                if (is_420 (src->format) || !is_420 (dst->format))
+                {
+                    expected = SAMPLE (src, c, x, y);
+                }
+                else
+                {
+                    gint y1 = MIN (y + 1, src->height - 1);
+
+                    expected = (SAMPLE (src, c, x, y) + SAMPLE (src, c, x, y1) + 1) / 2;
+                }
+
+                fail_unless_equals_int (SAMPLE (dst, c, x, y), expected);
+            }
+        }
+    }
+}
+
+static guint8 *
+new_frame (GstColorConvertFrame *frame,
+           GstVideoFormat format,
+           gint width,
+           gint height,
+           gint rowstride,
+           GRand *rand)
+{
+    guint8 *data;
+    guint i;
+
+    fail_unless (gst_color_convert_frame_init (frame, format, width, height,
+                                               rowstride));
+
+    data = g_malloc (frame->size);
+    for (i = 0; i < frame->size; i++)
+        data[i] = g_rand_int (rand);
+    gst_color_convert_frame_set_data (frame, data);
+
+    return data;
+}
+
+static gboolean
+visible_equal (const GstColorConvertFrame *a,
+               const GstColorConvertFrame *b)
+{
+    gint x, y;
+
+    for (y = 0; y < a->height; y++)
+    {
+        for (x = 0; x < a->width; x++)
+        {
+            if (SAMPLE (a, 0, x, y) != SAMPLE (b, 0, x, y))
+                return FALSE;
+            if (x < a->width / 2 &&
+                (SAMPLE (a, 1, x, y) != SAMPLE (b, 1, x, y) ||
+                 SAMPLE (a, 2, x, y) != SAMPLE (b, 2, x, y)))
+                return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void
+check_kernels (gint width,
+               gint height,
+               gint padding)
+{
+    const GstColorConvertKernels *neon = gst_color_convert_kernels_neon ();
+    GRand *rand = g_rand_new_with_seed (width * height);
+    guint i, j;
+
+    for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+        for (j = 0; j < G_N_ELEMENTS (formats); j++)
+        {
+            GstColorConvertFrame src, dst, simd;
+            guint8 *src_data, *dst_data, *simd_data;
+            gint in_stride = 0, out_stride = 0;
+
+            if (padding)
+            {
+                in_stride = (is_420 (formats[i]) ? 1 : 2) * width + padding;
+                out_stride = (is_420 (formats[j]) ? 1 : 2) * width + 2 * padding;
+            }
+
+            src_data = new_frame (&src, formats[i], width, height, in_stride, rand);
+            dst_data = new_frame (&dst, formats[j], width, height, out_stride, rand);
+
+            gst_color_convert_frame (&gst_color_convert_kernels_c, &dst, &src);
+            check_converted (&src, &dst);
+
+            if (neon)
+            {
+                simd_data = new_frame (&simd, formats[j], width, height,
+                                       out_stride, rand);
+                gst_color_convert_frame (neon, &simd, &src);
+                fail_unless (visible_equal (&simd, &dst),
+                             "%s differs from c for %dx%d",
+                             neon->name, width, height);
+                g_free (simd_data);
+            }
+
+            g_free (src_data);
+            g_free (dst_data);
+        }
+    }
+
+    g_rand_free (rand);
+}
+
+GST_START_TEST (test_kernels)
+{
+    GstColorConvertFrame frame;
+
+    /* the tails of the SIMD kernels, and odd heights */
+    check_kernels (2, 1, 0);
+    check_kernels (34, 3, 0);
+    check_kernels (66, 7, 0);
+    check_kernels (176, 144, 0);
+    check_kernels (96, 9, 32);
+
+    /* incomplete pairs of pixels, too short rows */
+    fail_if (gst_color_convert_frame_init (&frame, GST_VIDEO_FORMAT_NV12, 33, 2, 0));
+    fail_if (gst_color_convert_frame_init (&frame, GST_VIDEO_FORMAT_YUY2, 32, 2, 48));
+    fail_if (gst_color_convert_frame_init (&frame, GST_VIDEO_FORMAT_RGB, 32, 2, 0));
+}
+GST_END_TEST
+
+/*
+ * The element.
+ */
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate sinktemplate_yuy2 =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-raw-yuv, format=(fourcc)YUY2"));
+
+static GstStaticPadTemplate sinktemplate_uyvy_strided =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-raw-yuv-strided, "
+                                          "format=(fourcc)UYVY, rowstride=(int)768"));
+
+static void
+convert (GstStaticPadTemplate *sinktemplate,
+         const gchar *incaps,
+         GstVideoFormat in_format,
+         gint in_stride,
+         GstVideoFormat out_format,
+         gint out_stride,
+         gboolean simd)
+{
+    GstElement *convert;
+    GstPad *mysrcpad, *mysinkpad;
+    GstColorConvertFrame in, out;
+    GstBuffer *inbuffer, *outbuffer;
+    GstCaps *caps;
+    GRand *rand;
+    guint i;
+
+    convert = gst_check_setup_element ("gstcolorconvert");
+    mysrcpad = gst_check_setup_src_pad (convert, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (convert, sinktemplate, NULL);
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    g_object_set (convert, "simd", simd, NULL);
+
+    fail_unless_equals_int (gst_element_set_state (convert, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    fail_unless (gst_color_convert_frame_init (&in, in_format, 352, 288, in_stride));
+    inbuffer = gst_buffer_new_and_alloc (in.size);
+    rand = g_rand_new_with_seed (in.size);
+    for (i = 0; i < in.size; i++)
+        GST_BUFFER_DATA (inbuffer)[i] = g_rand_int (rand);
+    g_rand_free (rand);
+    gst_color_convert_frame_set_data (&in, GST_BUFFER_DATA (inbuffer));
+
+    caps = gst_caps_from_string (incaps);
+    gst_buffer_set_caps (inbuffer, caps);
+    gst_caps_unref (caps);
+
+    /* keep the input to compare with */
+    gst_buffer_ref (inbuffer);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_OK);
+    fail_unless_equals_int (g_list_length (buffers), 1);
+
+    outbuffer = GST_BUFFER (buffers->data);
+    fail_unless (gst_color_convert_frame_init (&out, out_format, 352, 288, out_stride));
+    fail_unless_equals_int (GST_BUFFER_SIZE (outbuffer), out.size);
+    gst_color_convert_frame_set_data (&out, GST_BUFFER_DATA (outbuffer));
+
+    check_converted (&in, &out);
+
+    gst_buffer_unref (inbuffer);
+    gst_check_drop_buffers ();
+
+    gst_element_set_state (convert, GST_STATE_NULL);
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (convert);
+    gst_check_teardown_sink_pad (convert);
+    gst_check_teardown_element (convert);
+}
+
+GST_START_TEST (test_element)
+{
+    gint simd;
+
+    for (simd = 0; simd <= 1; simd++)
+    {
+        convert (&sinktemplate_yuy2,
+                 "video/x-raw-yuv, format=(fourcc)I420, width=(int)352, "
+                 "height=(int)288, framerate=(fraction)30/1",
+                 GST_VIDEO_FORMAT_I420, 0, GST_VIDEO_FORMAT_YUY2, 0, simd);
+
+        /* as the OMX elements have it */
+        convert (&sinktemplate_uyvy_strided,
+                 "video/x-raw-yuv-strided, format=(fourcc)NV12, width=(int)352, "
+                 "height=(int)288, rowstride=(int)384, framerate=(fraction)30/1",
+                 GST_VIDEO_FORMAT_NV12, 384, GST_VIDEO_FORMAT_UYVY, 768, simd);
+    }
+}
+GST_END_TEST
+
+static Suite *
+colorconvert_suite (void)
+{
+    Suite *s = suite_create ("colorconvert");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_add_test (tc_chain, test_kernels);
+    tcase_add_test (tc_chain, test_element);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (colorconvert);
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2011-2012 Texas Instruments Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Benchmark for the gstcolorconvert kernels: every conversion between NV12,
+ * I420, YUY2 and UYVY at 720p and 1080p, with the scalar kernels and with
+ * the NEON ones where built.
+ */
+
+#include <check.h>
+#include <string.h>
+
+#include "gstcolorconvert_kernels.h"
+
+#define FRAME_COUNT 20
+
+static const GstVideoFormat formats[] = {
+    GST_VIDEO_FORMAT_NV12,
+    GST_VIDEO_FORMAT_I420,
+    GST_VIDEO_FORMAT_YUY2,
+    GST_VIDEO_FORMAT_UYVY,
+};
+
+/* Milliseconds per frame */
+static gdouble
+run_benchmark (const GstColorConvertKernels *kernels,
+               GstColorConvertFrame *dst,
+               GstColorConvertFrame *src)
+{
+    GTimer *timer;
+    gdouble seconds;
+    guint i;
+
+    /* warm up the caches */
+    gst_color_convert_frame (kernels, dst, src);
+
+    timer = g_timer_new ();
+    for (i = 0; i < FRAME_COUNT; i++)
+        gst_color_convert_frame (kernels, dst, src);
+    seconds = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    return seconds * 1000.0 / FRAME_COUNT;
+}
+
+static void
+run_size (gint width,
+          gint height)
+{
+    const GstColorConvertKernels *neon = gst_color_convert_kernels_neon ();
+    guint i, j;
+
+    for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+        for (j = 0; j < G_N_ELEMENTS (formats); j++)
+        {
+            GstColorConvertFrame src, dst;
+            guint8 *src_data, *dst_data;
+            gdouble c_time, neon_time;
+
+            if (i == j)
+                continue;
+
+            fail_unless (gst_color_convert_frame_init (&src, formats[i], width, height, 0));
+            fail_unless (gst_color_convert_frame_init (&dst, formats[j], width, height, 0));
+
+            src_data = g_malloc (src.size);
+            dst_data = g_malloc (dst.size);
+            memset (src_data, 0x80, src.size);
+            gst_color_convert_frame_set_data (&src, src_data);
+            gst_color_convert_frame_set_data (&dst, dst_data);
+
+            c_time = run_benchmark (&gst_color_convert_kernels_c, &dst, &src);
+
+            g_print ("%dp %" GST_FOURCC_FORMAT " -> %" GST_FOURCC_FORMAT
+                     ": c %.2f ms", height,
+                     GST_FOURCC_ARGS (gst_video_format_to_fourcc (formats[i])),
+                     GST_FOURCC_ARGS (gst_video_format_to_fourcc (formats[j])),
+                     c_time);
+
+            if (neon)
+            {
+                neon_time = run_benchmark (neon, &dst, &src);
+                g_print (", %s %.2f ms, x%.1f", neon->name, neon_time,
+                         c_time / neon_time);
+            }
+
+            g_print ("\n");
+
+            g_free (src_data);
+            g_free (dst_data);
+        }
+    }
+}
+
+START_TEST (test_colorconvert_perf_720p)
+{
+    run_size (1280, 720);
+}
+END_TEST
+
+START_TEST (test_colorconvert_perf_1080p)
+{
+    run_size (1920, 1080);
+}
+END_TEST
+
+Suite *
+colorconvert_suite (void)
+{
+    Suite *s = suite_create ("colorconvert-perf");
+
+    TCase *tc_perf = tcase_create ("Perf");
+    tcase_set_timeout (tc_perf, 120);
+    tcase_add_test (tc_perf, test_colorconvert_perf_720p);
+    tcase_add_test (tc_perf, test_colorconvert_perf_1080p);
+    suite_add_tcase (s, tc_perf);
+
+    return s;
+}
+
+int
+main (void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = colorconvert_suite ();
+    sr = srunner_create (s);
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+
+    return (number_failed == 0) ? 0 : 1;
+}
@@ -0,0 +1,811 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Tests for the DM816x mock components in standalone/dm816x.c, driven
+ * through the OpenMAX IL core entry points the way GOmxImp does.
+ */
+
+#include <check.h>
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+
+#include <xdc/std.h>
+#include <OMX_TI_Index.h>
+#include <OMX_TI_Common.h>
+#include <omx_vfpc.h>
+
+#include <glib.h>
+#include <dlfcn.h>
+#include <string.h>
+
+#define TIMEOUT_USEC 5000000
+#define MAX_BUFFERS 16
+
+static const char *lib_name;
+static void *dl_handle;
+static OMX_ERRORTYPE (*init) (void);
+static OMX_ERRORTYPE (*deinit) (void);
+static OMX_ERRORTYPE (*get_handle) (OMX_HANDLETYPE *handle,
+                                    OMX_STRING name,
+                                    OMX_PTR data,
+                                    OMX_CALLBACKTYPE *callbacks);
+static OMX_ERRORTYPE (*free_handle) (OMX_HANDLETYPE handle);
+
+typedef struct CustomData CustomData;
+
+struct CustomData
+{
+    OMX_HANDLETYPE omx_handle;
+    GMutex *mutex;
+    GCond *condition;
+    OMX_STATETYPE omx_state;
+    OMX_ERRORTYPE omx_error;
+    guint port_events;
+    guint flush_events;
+    guint eos_events;
+    guint empty_done;
+    guint fill_done;
+    GQueue *filled;
+};
+
+static CustomData *
+custom_data_new (void)
+{
+    CustomData *custom_data;
+    custom_data = g_new0 (CustomData, 1);
+    custom_data->condition = g_cond_new ();
+    custom_data->mutex = g_mutex_new ();
+    custom_data->omx_state = OMX_StateLoaded;
+    custom_data->filled = g_queue_new ();
+    return custom_data;
+}
+
+static void
+custom_data_free (CustomData *custom_data)
+{
+    g_queue_free (custom_data->filled);
+    g_mutex_free (custom_data->mutex);
+    g_cond_free (custom_data->condition);
+    g_free (custom_data);
+}
+
+static OMX_ERRORTYPE
+EventHandler (OMX_HANDLETYPE omx_handle,
+              OMX_PTR app_data,
+              OMX_EVENTTYPE event,
+              OMX_U32 data_1,
+              OMX_U32 data_2,
+              OMX_PTR event_data)
+{
+    CustomData *core = app_data;
+
+    g_mutex_lock (core->mutex);
+
+    switch (event)
+    {
+        case OMX_EventCmdComplete:
+            switch ((OMX_COMMANDTYPE) data_1)
+            {
+                case OMX_CommandStateSet:
+                    core->omx_state = data_2;
+                    break;
+                case OMX_CommandFlush:
+                    core->flush_events++;
+                    break;
+                case OMX_CommandPortEnable:
+                case OMX_CommandPortDisable:
+                    core->port_events++;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case OMX_EventBufferFlag:
+            if (data_2 & OMX_BUFFERFLAG_EOS)
+                core->eos_events++;
+            break;
+        case OMX_EventError:
+            core->omx_error = data_1;
+            break;
+        default:
+            break;
+    }
+
+    g_cond_signal (core->condition);
+    g_mutex_unlock (core->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+EmptyBufferDone (OMX_HANDLETYPE omx_handle,
+                 OMX_PTR app_data,
+                 OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    CustomData *core = app_data;
+
+    g_mutex_lock (core->mutex);
+    core->empty_done++;
+    g_cond_signal (core->condition);
+    g_mutex_unlock (core->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+FillBufferDone (OMX_HANDLETYPE omx_handle,
+                OMX_PTR app_data,
+                OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    CustomData *core = app_data;
+
+    g_mutex_lock (core->mutex);
+    core->fill_done++;
+    g_queue_push_tail (core->filled, omx_buffer);
+    g_cond_signal (core->condition);
+    g_mutex_unlock (core->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_CALLBACKTYPE callbacks = { EventHandler, EmptyBufferDone, FillBufferDone };
+
+#define INIT_PARAM(param) G_STMT_START {                \
+        memset ((param), 0, sizeof (*(param)));         \
+        (param)->nSize = sizeof (*(param));             \
+        (param)->nVersion.s.nVersionMajor = 1;          \
+        (param)->nVersion.s.nVersionMinor = 1;          \
+    } G_STMT_END
+
+/* Wait until *value reaches at least count, FALSE on timeout. */
+static gboolean
+wait_for_count (CustomData *core,
+                guint *value,
+                guint count)
+{
+    GTimeVal deadline;
+    gboolean ret = TRUE;
+
+    g_get_current_time (&deadline);
+    g_time_val_add (&deadline, TIMEOUT_USEC);
+
+    g_mutex_lock (core->mutex);
+    while (*value < count && ret)
+        ret = g_cond_timed_wait (core->condition, core->mutex, &deadline);
+    ret = *value >= count;
+    g_mutex_unlock (core->mutex);
+
+    return ret;
+}
+
+static gboolean
+wait_for_state (CustomData *core,
+                OMX_STATETYPE state)
+{
+    GTimeVal deadline;
+    gboolean ret = TRUE;
+
+    g_get_current_time (&deadline);
+    g_time_val_add (&deadline, TIMEOUT_USEC);
+
+    g_mutex_lock (core->mutex);
+    while (core->omx_state != state && ret)
+        ret = g_cond_timed_wait (core->condition, core->mutex, &deadline);
+    ret = core->omx_state == state;
+    g_mutex_unlock (core->mutex);
+
+    return ret;
+}
+
+static gboolean
+wait_for_error (CustomData *core,
+                OMX_ERRORTYPE error)
+{
+    GTimeVal deadline;
+    gboolean ret = TRUE;
+
+    g_get_current_time (&deadline);
+    g_time_val_add (&deadline, TIMEOUT_USEC);
+
+    g_mutex_lock (core->mutex);
+    while (core->omx_error != error && ret)
+        ret = g_cond_timed_wait (core->condition, core->mutex, &deadline);
+    ret = core->omx_error == error;
+    g_mutex_unlock (core->mutex);
+
+    return ret;
+}
+
+static CustomData *
+setup_component (const gchar *name)
+{
+    CustomData *core;
+    OMX_ERRORTYPE omx_error;
+
+    core = custom_data_new ();
+
+    omx_error = init ();
+    fail_if (omx_error != OMX_ErrorNone);
+
+    omx_error = get_handle (&core->omx_handle, (OMX_STRING) name, core, &callbacks);
+    fail_if (omx_error != OMX_ErrorNone, "%s: %x", name, omx_error);
+
+    return core;
+}
+
+static void
+teardown_component (CustomData *core)
+{
+    fail_if (free_handle (core->omx_handle) != OMX_ErrorNone);
+    fail_if (deinit () != OMX_ErrorNone);
+    custom_data_free (core);
+}
+
+static void
+set_video_port (CustomData *core,
+                OMX_U32 index,
+                OMX_U32 width,
+                OMX_U32 height,
+                OMX_COLOR_FORMATTYPE color,
+                OMX_U32 count)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+
+    INIT_PARAM (&param);
+    param.nPortIndex = index;
+    fail_if (OMX_GetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param));
+
+    param.format.video.nFrameWidth = width;
+    param.format.video.nFrameHeight = height;
+    param.format.video.nStride = 0;
+    param.format.video.eColorFormat = color;
+    param.nBufferSize = 0;
+    param.nBufferCountActual = count;
+    fail_if (OMX_SetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param));
+}
+
+static guint
+allocate_port (CustomData *core,
+               OMX_U32 index,
+               OMX_BUFFERHEADERTYPE **buffers)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE param;
+    guint i;
+
+    INIT_PARAM (&param);
+    param.nPortIndex = index;
+    fail_if (OMX_GetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param));
+    fail_if (param.nBufferCountActual > MAX_BUFFERS);
+
+    for (i = 0; i < param.nBufferCountActual; i++)
+    {
+        fail_if (OMX_AllocateBuffer (core->omx_handle, &buffers[i], index,
+                                     NULL, param.nBufferSize));
+    }
+
+    return param.nBufferCountActual;
+}
+
+static void
+free_port (CustomData *core,
+           OMX_U32 index,
+           OMX_BUFFERHEADERTYPE **buffers,
+           guint count)
+{
+    guint i;
+
+    for (i = 0; i < count; i++)
+        fail_if (OMX_FreeBuffer (core->omx_handle, index, buffers[i]));
+}
+
+START_TEST (test_handles)
+{
+    static const gchar *names[] = {
+        "OMX.TI.DUCATI.VIDDEC",
+        "OMX.TI.DUCATI.VIDENC",
+        "OMX.TI.VPSSM3.VFPC.INDTXSCWB",
+        "OMX.TI.VPSSM3.VFPC.NF",
+        "OMX.TI.VPSSM3.VFDC",
+        "OMX.TI.VPSSM3.CTRL.DC",
+        "OMX.TI.VPSSM3.VFCC",
+    };
+    OMX_HANDLETYPE omx_handle;
+    guint i;
+
+    fail_if (init () != OMX_ErrorNone);
+
+    for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+        OMX_STATETYPE state;
+
+        fail_if (get_handle (&omx_handle, (OMX_STRING) names[i], NULL, &callbacks),
+                 "%s", names[i]);
+        fail_if (OMX_GetState (omx_handle, &state));
+        fail_if (state != OMX_StateLoaded);
+        fail_if (free_handle (omx_handle));
+    }
+
+    fail_if (get_handle (&omx_handle, "OMX.TI.DUCATI.FOO", NULL, &callbacks) !=
+             OMX_ErrorComponentNotFound);
+
+    fail_if (deinit () != OMX_ErrorNone);
+}
+END_TEST
+
+START_TEST (test_state_machine)
+{
+    CustomData *core;
+    OMX_BUFFERHEADERTYPE *in[MAX_BUFFERS];
+    OMX_BUFFERHEADERTYPE *out[MAX_BUFFERS];
+    guint in_count, out_count;
+
+    core = setup_component ("OMX.TI.DUCATI.VIDDEC");
+
+    set_video_port (core, 1, 176, 144, OMX_COLOR_FormatYUV420SemiPlanar, 4);
+
+    /* idle is only reached once the ports are populated */
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    g_usleep (50000);
+    fail_if (core->omx_state != OMX_StateLoaded);
+
+    in_count = allocate_port (core, 0, in);
+    out_count = allocate_port (core, 1, out);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    /* parameters are read-only on enabled ports past loaded */
+    {
+        OMX_PARAM_PORTDEFINITIONTYPE param;
+
+        INIT_PARAM (&param);
+        param.nPortIndex = 1;
+        OMX_GetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param);
+        fail_if (param.nBufferSize < 176 * 144 * 3 / 2);
+        fail_if (!param.bPopulated);
+        fail_if (OMX_SetParameter (core->omx_handle, OMX_IndexParamPortDefinition, &param) !=
+                 OMX_ErrorIncorrectStateOperation);
+    }
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+    fail_unless (wait_for_state (core, OMX_StateExecuting));
+
+    /* executing to loaded is not allowed */
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+    fail_unless (wait_for_error (core, OMX_ErrorIncorrectStateTransition));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+    free_port (core, 0, in, in_count);
+    free_port (core, 1, out, out_count);
+    fail_unless (wait_for_state (core, OMX_StateLoaded));
+
+    teardown_component (core);
+}
+END_TEST
+
+START_TEST (test_encode)
+{
+    CustomData *core;
+    OMX_BUFFERHEADERTYPE *in[MAX_BUFFERS];
+    OMX_BUFFERHEADERTYPE *out[MAX_BUFFERS];
+    guint in_count, out_count;
+    guint i, frames = 8;
+
+    core = setup_component ("OMX.TI.DUCATI.VIDENC");
+
+    set_video_port (core, 0, 176, 144, OMX_COLOR_FormatYUV420SemiPlanar, 2);
+
+    {
+        OMX_VIDEO_CONFIG_AVCINTRAPERIOD period;
+
+        INIT_PARAM (&period);
+        period.nPortIndex = 1;
+        period.nIDRPeriod = 1;
+        period.nPFrames = 3;
+        fail_if (OMX_SetConfig (core->omx_handle, OMX_IndexConfigVideoAVCIntraPeriod, &period));
+
+        INIT_PARAM (&period);
+        period.nPortIndex = 1;
+        fail_if (OMX_GetConfig (core->omx_handle, OMX_IndexConfigVideoAVCIntraPeriod, &period));
+        fail_if (period.nPFrames != 3);
+    }
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    in_count = allocate_port (core, 0, in);
+    out_count = allocate_port (core, 1, out);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+    fail_unless (wait_for_state (core, OMX_StateExecuting));
+
+    for (i = 0; i < out_count; i++)
+        fail_if (OMX_FillThisBuffer (core->omx_handle, out[i]));
+
+    for (i = 0; i < frames; i++)
+    {
+        OMX_BUFFERHEADERTYPE *omx_buffer = in[i % in_count];
+        OMX_BUFFERHEADERTYPE *encoded;
+
+        /* wait for the input buffer to come back before reusing it */
+        fail_unless (wait_for_count (core, &core->empty_done, i + 1 - MIN (i + 1, in_count)));
+
+        omx_buffer->nFilledLen = 176 * 144 * 3 / 2;
+        omx_buffer->nTimeStamp = i * 33333;
+        omx_buffer->nFlags = (i == frames - 1) ? OMX_BUFFERFLAG_EOS : 0;
+
+        if (i == 5)
+        {
+            OMX_CONFIG_INTRAREFRESHVOPTYPE refresh;
+
+            INIT_PARAM (&refresh);
+            refresh.nPortIndex = 1;
+            refresh.IntraRefreshVOP = OMX_TRUE;
+            fail_if (OMX_SetConfig (core->omx_handle, OMX_IndexConfigVideoIntraVOPRefresh, &refresh));
+        }
+
+        fail_if (OMX_EmptyThisBuffer (core->omx_handle, omx_buffer));
+
+        fail_unless (wait_for_count (core, &core->fill_done, i + 1));
+
+        g_mutex_lock (core->mutex);
+        encoded = g_queue_pop_head (core->filled);
+        g_mutex_unlock (core->mutex);
+
+        fail_if (encoded->nTimeStamp != i * 33333);
+        fail_if (encoded->nFilledLen < 5);
+        fail_if (memcmp (encoded->pBuffer, "\x00\x00\x00\x01", 4));
+
+        /* intra every nPFrames + 1, or when asked for */
+        if (i == 0 || i == 4 || i == 5)
+        {
+            fail_unless (encoded->nFlags & OMX_BUFFERFLAG_SYNCFRAME, "frame %d", i);
+            fail_unless ((encoded->pBuffer[4] & 0x1f) == 7, "frame %d", i);
+        }
+        else
+        {
+            fail_if (encoded->nFlags & OMX_BUFFERFLAG_SYNCFRAME, "frame %d", i);
+            fail_unless ((encoded->pBuffer[4] & 0x1f) == 1, "frame %d", i);
+        }
+
+        fail_if (OMX_FillThisBuffer (core->omx_handle, encoded));
+    }
+
+    fail_unless (wait_for_count (core, &core->eos_events, 1));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    /* every buffer is back once idle */
+    fail_if (core->empty_done != frames);
+    fail_if (core->fill_done != frames + out_count);
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+    free_port (core, 0, in, in_count);
+    free_port (core, 1, out, out_count);
+    fail_unless (wait_for_state (core, OMX_StateLoaded));
+
+    teardown_component (core);
+}
+END_TEST
+
+START_TEST (test_scale)
+{
+    CustomData *core;
+    OMX_BUFFERHEADERTYPE *in[MAX_BUFFERS];
+    OMX_BUFFERHEADERTYPE *out[MAX_BUFFERS];
+    OMX_BUFFERHEADERTYPE *scaled;
+    guint in_count, out_count;
+    OMX_U32 in_port = OMX_VFPC_INPUT_PORT_START_INDEX + 1;
+    OMX_U32 out_port = OMX_VFPC_OUTPUT_PORT_START_INDEX + 1;
+    guint i;
+
+    core = setup_component ("OMX.TI.VPSSM3.VFPC.INDTXSCWB");
+
+    set_video_port (core, in_port, 64, 32, OMX_COLOR_FormatYUV420SemiPlanar, 2);
+    set_video_port (core, out_port, 32, 16, OMX_COLOR_FormatYCbYCr, 2);
+
+    /* crop the right half of the input */
+    {
+        OMX_CONFIG_VIDCHANNEL_RESOLUTION resolution;
+
+        INIT_PARAM (&resolution);
+        resolution.Frm0Width = 64;
+        resolution.Frm0Height = 32;
+        resolution.Frm0Pitch = 64;
+        resolution.FrmStartX = 32;
+        resolution.FrmStartY = 0;
+        resolution.FrmCropWidth = 32;
+        resolution.FrmCropHeight = 32;
+        resolution.eDir = OMX_DirInput;
+        resolution.nChId = 1;
+        fail_if (OMX_SetConfig (core->omx_handle,
+                                (OMX_INDEXTYPE) OMX_TI_IndexConfigVidChResolution, &resolution));
+    }
+
+    /* ports of the VPSS components start disabled */
+    OMX_SendCommand (core->omx_handle, OMX_CommandPortEnable, in_port, NULL);
+    OMX_SendCommand (core->omx_handle, OMX_CommandPortEnable, out_port, NULL);
+    fail_unless (wait_for_count (core, &core->port_events, 2));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    in_count = allocate_port (core, in_port, in);
+    out_count = allocate_port (core, out_port, out);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+    fail_unless (wait_for_state (core, OMX_StateExecuting));
+
+    /* left half dark, right half bright, chroma 0x40/0xc0 */
+    for (i = 0; i < 32; i++)
+    {
+        memset (in[0]->pBuffer + i * 64, 0x10, 32);
+        memset (in[0]->pBuffer + i * 64 + 32, 0xe0, 32);
+    }
+    for (i = 0; i < 64 * 16; i += 2)
+    {
+        in[0]->pBuffer[64 * 32 + i] = 0x40;
+        in[0]->pBuffer[64 * 32 + i + 1] = 0xc0;
+    }
+    in[0]->nFilledLen = 64 * 32 * 3 / 2;
+    in[0]->nTimeStamp = 1234;
+
+    fail_if (OMX_FillThisBuffer (core->omx_handle, out[0]));
+    fail_if (OMX_EmptyThisBuffer (core->omx_handle, in[0]));
+    fail_unless (wait_for_count (core, &core->fill_done, 1));
+    fail_unless (wait_for_count (core, &core->empty_done, 1));
+
+    scaled = g_queue_pop_head (core->filled);
+    fail_if (scaled->nFilledLen != 32 * 16 * 2);
+    fail_if (scaled->nTimeStamp != 1234);
+
+    for (i = 0; i < scaled->nFilledLen; i += 4)
+    {
+        fail_if (scaled->pBuffer[i] != 0xe0, "offset %d", i);
+        fail_if (scaled->pBuffer[i + 1] != 0x40, "offset %d", i);
+        fail_if (scaled->pBuffer[i + 2] != 0xe0, "offset %d", i);
+        fail_if (scaled->pBuffer[i + 3] != 0xc0, "offset %d", i);
+    }
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+    free_port (core, in_port, in, in_count);
+    free_port (core, out_port, out, out_count);
+    fail_unless (wait_for_state (core, OMX_StateLoaded));
+
+    teardown_component (core);
+}
+END_TEST
+
+START_TEST (test_flush)
+{
+    CustomData *core;
+    OMX_BUFFERHEADERTYPE *out[MAX_BUFFERS];
+    guint out_count;
+    guint i;
+
+    core = setup_component ("OMX.TI.VPSSM3.VFCC");
+
+    set_video_port (core, 0, 64, 32, OMX_COLOR_FormatYCbYCr, 4);
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    out_count = allocate_port (core, 0, out);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    /* nothing is captured before executing */
+    for (i = 0; i < out_count; i++)
+        fail_if (OMX_FillThisBuffer (core->omx_handle, out[i]));
+    g_usleep (50000);
+    fail_if (core->fill_done != 0);
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandFlush, OMX_ALL, NULL);
+    fail_unless (wait_for_count (core, &core->flush_events, 1));
+    fail_if (core->fill_done != out_count);
+
+    for (i = 0; i < out_count; i++)
+    {
+        OMX_BUFFERHEADERTYPE *omx_buffer = g_queue_pop_head (core->filled);
+        fail_if (omx_buffer->nFilledLen != 0);
+    }
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+    free_port (core, 0, out, out_count);
+    fail_unless (wait_for_state (core, OMX_StateLoaded));
+
+    teardown_component (core);
+}
+END_TEST
+
+START_TEST (test_delay)
+{
+    CustomData *core;
+    OMX_BUFFERHEADERTYPE *in[MAX_BUFFERS];
+    guint in_count;
+    GTimer *timer;
+    guint i, frames = 5;
+
+    g_setenv ("OMX_MOCK_DELAY_VFDC", "20000", TRUE);
+    core = setup_component ("OMX.TI.VPSSM3.VFDC");
+    g_unsetenv ("OMX_MOCK_DELAY_VFDC");
+
+    set_video_port (core, 0, 64, 32, OMX_COLOR_FormatYCbYCr, frames);
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandPortEnable, 0, NULL);
+    fail_unless (wait_for_count (core, &core->port_events, 1));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    in_count = allocate_port (core, 0, in);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+    fail_unless (wait_for_state (core, OMX_StateExecuting));
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < in_count; i++)
+    {
+        in[i]->nFilledLen = 64 * 32 * 2;
+        in[i]->nFlags = (i == in_count - 1) ? OMX_BUFFERFLAG_EOS : 0;
+        fail_if (OMX_EmptyThisBuffer (core->omx_handle, in[i]));
+    }
+
+    fail_unless (wait_for_count (core, &core->empty_done, in_count));
+    fail_unless (wait_for_count (core, &core->eos_events, 1));
+
+    /* one vsync per frame */
+    fail_if (g_timer_elapsed (timer, NULL) < frames * 0.020 * 0.9);
+    g_timer_destroy (timer);
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+    free_port (core, 0, in, in_count);
+    fail_unless (wait_for_state (core, OMX_StateLoaded));
+
+    teardown_component (core);
+}
+END_TEST
+
+START_TEST (test_depth)
+{
+    CustomData *core;
+    OMX_BUFFERHEADERTYPE *in[MAX_BUFFERS];
+    OMX_BUFFERHEADERTYPE *out[MAX_BUFFERS];
+    guint in_count, out_count;
+    guint i, decoded = 0, frames = 6;
+    gboolean eos = FALSE;
+
+    g_setenv ("OMX_MOCK_DEPTH_VIDDEC", "3", TRUE);
+    core = setup_component ("OMX.TI.DUCATI.VIDDEC");
+    g_unsetenv ("OMX_MOCK_DEPTH_VIDDEC");
+
+    set_video_port (core, 1, 176, 144, OMX_COLOR_FormatYUV420SemiPlanar, 8);
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    in_count = allocate_port (core, 0, in);
+    out_count = allocate_port (core, 1, out);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+    fail_unless (wait_for_state (core, OMX_StateExecuting));
+
+    for (i = 0; i < out_count; i++)
+        fail_if (OMX_FillThisBuffer (core->omx_handle, out[i]));
+
+    for (i = 0; i < frames; i++)
+    {
+        fail_unless (wait_for_count (core, &core->empty_done, i + 1 - MIN (i + 1, in_count)));
+
+        in[i % in_count]->nFilledLen = 16;
+        in[i % in_count]->nFlags = 0;
+        fail_if (OMX_EmptyThisBuffer (core->omx_handle, in[i % in_count]));
+    }
+
+    /* the last three frames stay in the component until EOS */
+    fail_unless (wait_for_count (core, &core->empty_done, frames));
+    fail_unless (wait_for_count (core, &core->fill_done, frames - 3));
+    g_usleep (50000);
+    fail_if (core->fill_done != frames - 3);
+
+    in[0]->nFilledLen = 0;
+    in[0]->nFlags = OMX_BUFFERFLAG_EOS;
+    fail_if (OMX_EmptyThisBuffer (core->omx_handle, in[0]));
+
+    fail_unless (wait_for_count (core, &core->eos_events, 1));
+    fail_unless (wait_for_count (core, &core->fill_done, frames + 1));
+
+    while (!g_queue_is_empty (core->filled))
+    {
+        OMX_BUFFERHEADERTYPE *omx_buffer = g_queue_pop_head (core->filled);
+
+        fail_if (eos, "buffer after EOS");
+        if (omx_buffer->nFilledLen > 0)
+            decoded++;
+        eos = (omx_buffer->nFlags & OMX_BUFFERFLAG_EOS) != 0;
+    }
+
+    fail_unless (eos);
+    fail_if (decoded != frames);
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    fail_unless (wait_for_state (core, OMX_StateIdle));
+
+    OMX_SendCommand (core->omx_handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+    free_port (core, 0, in, in_count);
+    free_port (core, 1, out, out_count);
+    fail_unless (wait_for_state (core, OMX_StateLoaded));
+
+    teardown_component (core);
+}
+END_TEST
+
+static Suite *
+util_suite (void)
+{
+    Suite *s = suite_create ("dm816x");
+    TCase *tc_chain = tcase_create ("general");
+
+    lib_name = "libomxil-dm816x.so";
+
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+    {
+        dl_handle = dlopen (lib_name, RTLD_LAZY);
+        if (!dl_handle)
+            g_error ("failed to load %s: %s", lib_name, dlerror ());
+
+        init = dlsym (dl_handle, "OMX_Init");
+        deinit = dlsym (dl_handle, "OMX_Deinit");
+        get_handle = dlsym (dl_handle, "OMX_GetHandle");
+        free_handle = dlsym (dl_handle, "OMX_FreeHandle");
+    }
+
+    tcase_set_timeout (tc_chain, 30);
+    tcase_add_test (tc_chain, test_handles);
+    tcase_add_test (tc_chain, test_state_machine);
+    tcase_add_test (tc_chain, test_encode);
+    tcase_add_test (tc_chain, test_scale);
+    tcase_add_test (tc_chain, test_flush);
+    tcase_add_test (tc_chain, test_delay);
+    tcase_add_test (tc_chain, test_depth);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+int
+main (void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = util_suite ();
+    sr = srunner_create (s);
+    srunner_run_all (sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed (sr);
+    srunner_free (sr);
+
+    return (number_failed == 0) ? 0 : 1;
+}
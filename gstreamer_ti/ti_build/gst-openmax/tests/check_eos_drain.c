@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * EOS handling of GstOmxBaseFilter, run on omx_h264dec against the DM816x
+ * mock in standalone/dm816x.c: the frames still held by the component must
+ * come out before EOS, whatever the depth of its pipeline.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define BUFFER_SIZE 0x100
+#define BUFFER_COUNT 16
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-h264"));
+
+static GMutex *eos_mutex;
+static GCond *eos_cond;
+static guint eos_count;
+
+static gboolean
+test_sink_event (GstPad *pad,
+                 GstEvent *event)
+{
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        g_mutex_lock (eos_mutex);
+        eos_count++;
+        g_cond_signal (eos_cond);
+        g_mutex_unlock (eos_mutex);
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+/* Decode BUFFER_COUNT frames with the mock holding @depth of them, and
+ * return the number of frames which made it downstream before EOS.
+ */
+static guint
+drain (guint depth,
+       gboolean drop_eos,
+       gint eos_timeout)
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstPad *mysinkpad;
+    GstCaps *caps;
+    gchar *value;
+    guint i, count;
+
+    filter = gst_check_setup_element ("omx_h264dec");
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    gst_pad_set_event_function (mysinkpad, test_sink_event);
+
+    eos_mutex = g_mutex_new ();
+    eos_cond = g_cond_new ();
+    eos_count = 0;
+
+    g_object_set (G_OBJECT (filter),
+                  "library-name", "libomxil-dm816x.so",
+                  "eos-timeout", eos_timeout,
+                  NULL);
+
+    /* the mock reads its settings when the handle is created */
+    value = g_strdup_printf ("%u", depth);
+    g_setenv ("OMX_MOCK_DEPTH_VIDDEC", value, TRUE);
+    g_free (value);
+    if (drop_eos)
+        g_setenv ("OMX_MOCK_DROP_EOS_VIDDEC", "1", TRUE);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    g_unsetenv ("OMX_MOCK_DEPTH_VIDDEC");
+    g_unsetenv ("OMX_MOCK_DROP_EOS_VIDDEC");
+
+    caps = gst_caps_from_string ("video/x-h264,width=176,height=144,framerate=30/1");
+
+    for (i = 0; i < BUFFER_COUNT; i++)
+    {
+        GstBuffer *inbuffer;
+
+        inbuffer = gst_buffer_new_and_alloc (BUFFER_SIZE);
+        memset (GST_BUFFER_DATA (inbuffer), i, BUFFER_SIZE);
+        GST_BUFFER_TIMESTAMP (inbuffer) = i * GST_SECOND / 30;
+        gst_buffer_set_caps (inbuffer, caps);
+
+        fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+    }
+
+    gst_caps_unref (caps);
+
+    fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+    g_mutex_lock (eos_mutex);
+    while (!eos_count)
+        g_cond_wait (eos_cond, eos_mutex);
+    g_mutex_unlock (eos_mutex);
+
+    count = g_list_length (buffers);
+
+    /* nothing may follow EOS, and there is only one */
+    g_usleep (G_USEC_PER_SEC / 10);
+    fail_unless_equals_int (g_list_length (buffers), count);
+    fail_unless_equals_int (eos_count, 1);
+
+    /* cleanup */
+    gst_check_drop_buffers ();
+
+    gst_element_set_state (filter, GST_STATE_NULL);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_check_teardown_element (filter);
+
+    g_mutex_free (eos_mutex);
+    g_cond_free (eos_cond);
+
+    return count;
+}
+
+GST_START_TEST (test_drain)
+{
+    static const guint depths[] = { 0, 1, 2, 4, 7 };
+    guint i;
+
+    /* without a timeout, EOS can only come from the component */
+    for (i = 0; i < G_N_ELEMENTS (depths); i++)
+    {
+        fail_unless_equals_int (drain (depths[i], FALSE, -1), BUFFER_COUNT);
+    }
+}
+GST_END_TEST
+
+GST_START_TEST (test_timeout)
+{
+    GTimer *timer;
+
+    /* the component swallows EOS: give up waiting after eos-timeout */
+    timer = g_timer_new ();
+    fail_unless_equals_int (drain (0, TRUE, 200), BUFFER_COUNT);
+    fail_if (g_timer_elapsed (timer, NULL) < 0.200 * 0.9);
+    g_timer_destroy (timer);
+}
+GST_END_TEST
+
+static Suite *
+eos_drain_suite (void)
+{
+    Suite *s = suite_create ("eos_drain");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 30);
+    tcase_add_test (tc_chain, test_drain);
+    tcase_add_test (tc_chain, test_timeout);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (eos_drain);
@@ -0,0 +1,577 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+/*
+ * Drives a GOmxPort in zero-copy (shared buffer) mode against a mock OMX
+ * component, and checks that every GstOmxBufferTransport coming from the
+ * upstream port is sent with its own buffer header.  Also checks the
+ * buffers a sink pad_allocs from its own input port are sent without a copy,
+ * and that an output port recycles its buffer transports instead of
+ * allocating one per buffer received.
+ */
+
+#include <stdio.h>
+
+#include <gst/check/gstcheck.h>
+
+#include "gstomx_util.h"
+#include "gstomx_port.h"
+#include "gstomx_buffertransport.h"
+
+GST_DEBUG_CATEGORY (gstomx_debug);
+GST_DEBUG_CATEGORY (gstomx_ppm);
+
+#define NUM_BUFFERS 48
+#define BUFFER_SIZE 0x100
+#define LOOKUP_COUNT 0x100000
+#define SOAK_COUNT 200000
+#define SOAK_HELD 4
+#define SOAK_RSS_PAGES 64
+
+typedef struct MockComp MockComp;
+
+struct MockComp
+{
+    OMX_COMPONENTTYPE comp;
+    OMX_PARAM_PORTDEFINITIONTYPE port_def;
+    GOmxCore *core;
+    GOmxPort *in_port;
+    GOmxPort *out_port;
+    OMX_BUFFERHEADERTYPE *last_etb;
+    guint etb_count;
+};
+
+static MockComp mock;
+static GOmxCore *core;
+static GOmxPort *up_port;
+static GOmxPort *in_port;
+static GOmxPort *out_port;
+static OMX_U8 *blocks[NUM_BUFFERS];
+static GstBus *bus;
+
+/*
+ * Mock OMX component
+ */
+
+static OMX_ERRORTYPE
+mock_GetParameter (OMX_HANDLETYPE handle,
+                   OMX_INDEXTYPE index,
+                   OMX_PTR param)
+{
+    if (index == OMX_IndexParamPortDefinition)
+    {
+        OMX_PARAM_PORTDEFINITIONTYPE *port_def = param;
+        memcpy (port_def, &mock.port_def, sizeof (*port_def));
+    }
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+mock_UseBuffer (OMX_HANDLETYPE handle,
+                OMX_BUFFERHEADERTYPE **buffer_header,
+                OMX_U32 index,
+                OMX_PTR data,
+                OMX_U32 size,
+                OMX_U8 *buffer)
+{
+    OMX_BUFFERHEADERTYPE *new;
+
+    new = g_new0 (OMX_BUFFERHEADERTYPE, 1);
+    new->nSize = sizeof (OMX_BUFFERHEADERTYPE);
+    new->pBuffer = buffer;
+    new->nAllocLen = size;
+    new->nInputPortIndex = index;
+
+    *buffer_header = new;
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+mock_FreeBuffer (OMX_HANDLETYPE handle,
+                 OMX_U32 index,
+                 OMX_BUFFERHEADERTYPE *buffer_header)
+{
+    g_free (buffer_header);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+mock_EmptyThisBuffer (OMX_HANDLETYPE handle,
+                      OMX_BUFFERHEADERTYPE *buffer_header)
+{
+    mock.last_etb = buffer_header;
+    mock.etb_count++;
+
+    /* consume it right away, like EmptyBufferDone would */
+    g_omx_core_got_buffer (mock.core, mock.in_port, buffer_header);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+mock_FillThisBuffer (OMX_HANDLETYPE handle,
+                     OMX_BUFFERHEADERTYPE *buffer_header)
+{
+    /* upstream transports are handed back here when unref'd, and those of
+     * the output port are filled right away, like FillBufferDone would
+     */
+    if (mock.out_port && buffer_header->pBuffer &&
+        g_omx_port_lookup_buffer (mock.out_port, buffer_header->pBuffer) == buffer_header)
+    {
+        buffer_header->nFilledLen = BUFFER_SIZE;
+        g_omx_core_got_buffer (mock.core, mock.out_port, buffer_header);
+    }
+
+    return OMX_ErrorNone;
+}
+
+/*
+ * Fixture
+ */
+
+static void
+setup (void)
+{
+    guint i;
+
+    memset (&mock, 0, sizeof (mock));
+    mock.comp.nSize = sizeof (OMX_COMPONENTTYPE);
+    mock.comp.GetParameter = mock_GetParameter;
+    mock.comp.UseBuffer = mock_UseBuffer;
+    mock.comp.FreeBuffer = mock_FreeBuffer;
+    mock.comp.EmptyThisBuffer = mock_EmptyThisBuffer;
+    mock.comp.FillThisBuffer = mock_FillThisBuffer;
+
+    mock.port_def.nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+    mock.port_def.nPortIndex = 0;
+    mock.port_def.eDir = OMX_DirInput;
+    mock.port_def.nBufferCountActual = NUM_BUFFERS;
+    mock.port_def.nBufferCountMin = 1;
+    mock.port_def.nBufferSize = BUFFER_SIZE;
+
+    core = g_new0 (GOmxCore, 1);
+    core->object = gst_element_factory_make ("fakesink", NULL);
+    core->omx_handle = &mock.comp;
+    core->omx_state = OMX_StateExecuting;
+    core->ports = g_ptr_array_new ();
+    core->use_timestamps = FALSE;
+
+    bus = gst_bus_new ();
+    gst_element_set_bus (core->object, bus);
+
+    /* the upstream output port owning the shared memory */
+    up_port = g_omx_port_new (core, "up", 1);
+    up_port->type = GOMX_PORT_OUTPUT;
+    up_port->num_buffers = NUM_BUFFERS;
+    up_port->buffers = g_new0 (OMX_BUFFERHEADERTYPE *, NUM_BUFFERS);
+
+    for (i = 0; i < NUM_BUFFERS; i++)
+    {
+        blocks[i] = g_malloc0 (BUFFER_SIZE);
+        up_port->buffers[i] = g_new0 (OMX_BUFFERHEADERTYPE, 1);
+        up_port->buffers[i]->pBuffer = blocks[i];
+        up_port->buffers[i]->nFilledLen = BUFFER_SIZE;
+        up_port->buffers[i]->nAllocLen = BUFFER_SIZE;
+    }
+
+    /* our input port, set up like GstOmxBaseFilter does for transports */
+    in_port = g_omx_port_new (core, "in", 0);
+    in_port->type = GOMX_PORT_INPUT;
+    in_port->num_buffers = NUM_BUFFERS;
+    in_port->omx_allocate = FALSE;
+    in_port->always_copy = FALSE;
+    in_port->share_buffer_info = g_new0 (OmxBufferInfo, 1);
+    in_port->share_buffer_info->num_buffers = NUM_BUFFERS;
+    in_port->share_buffer_info->pBuffer = g_new0 (OMX_U8 *, NUM_BUFFERS);
+
+    for (i = 0; i < NUM_BUFFERS; i++)
+        in_port->share_buffer_info->pBuffer[i] = blocks[i];
+
+    mock.core = core;
+    mock.in_port = in_port;
+
+    g_omx_port_allocate_buffers (in_port);
+}
+
+static void
+teardown (void)
+{
+    guint i;
+
+    /* hand every header back, so that freeing does not wait for them */
+    async_queue_flush (in_port->queue);
+    for (i = 0; i < NUM_BUFFERS; i++)
+        g_omx_port_push_buffer (in_port, in_port->buffers[i]);
+
+    g_omx_port_free_buffers (in_port);
+    fail_unless (in_port->buffer_table == NULL);
+
+    g_free (in_port->share_buffer_info->pBuffer);
+    g_free (in_port->share_buffer_info);
+    g_omx_port_free (in_port);
+
+    for (i = 0; i < NUM_BUFFERS; i++)
+    {
+        g_free (up_port->buffers[i]);
+        g_free (blocks[i]);
+    }
+    g_omx_port_free (up_port);
+
+    gst_element_set_bus (core->object, NULL);
+    gst_object_unref (bus);
+    gst_object_unref (core->object);
+    g_ptr_array_free (core->ports, TRUE);
+    g_free (core);
+}
+
+/* an output port sharing the blocks, as a decoder's would be, with all its
+ * buffers filled and waiting to be received
+ */
+static void
+setup_out_port (void)
+{
+    guint i;
+
+    out_port = g_omx_port_new (core, "out", 1);
+    out_port->type = GOMX_PORT_OUTPUT;
+    out_port->num_buffers = NUM_BUFFERS;
+    out_port->omx_allocate = FALSE;
+    out_port->always_copy = FALSE;
+    out_port->share_buffer_info = g_new0 (OmxBufferInfo, 1);
+    out_port->share_buffer_info->num_buffers = NUM_BUFFERS;
+    out_port->share_buffer_info->pBuffer = g_new0 (OMX_U8 *, NUM_BUFFERS);
+
+    for (i = 0; i < NUM_BUFFERS; i++)
+        out_port->share_buffer_info->pBuffer[i] = blocks[i];
+
+    g_omx_port_allocate_buffers (out_port);
+    fail_unless (out_port->transport_pool != NULL);
+
+    mock.out_port = out_port;
+    for (i = 0; i < NUM_BUFFERS; i++)
+        mock_FillThisBuffer (&mock.comp, out_port->buffers[i]);
+}
+
+static void
+free_out_port (void)
+{
+    mock.out_port = NULL;
+
+    g_omx_port_free_buffers (out_port);
+    fail_unless (out_port->transport_pool == NULL);
+
+    g_free (out_port->share_buffer_info->pBuffer);
+    g_free (out_port->share_buffer_info);
+    g_omx_port_free (out_port);
+}
+
+/* resident set size in pages, 0 if unknown */
+static glong
+rss_pages (void)
+{
+    glong size, resident = 0;
+    FILE *f;
+
+    f = fopen ("/proc/self/statm", "r");
+    if (f)
+    {
+        if (fscanf (f, "%ld %ld", &size, &resident) != 2)
+            resident = 0;
+        fclose (f);
+    }
+
+    return resident;
+}
+
+/* the lookup as it was done before the table */
+static OMX_BUFFERHEADERTYPE *
+linear_lookup (GOmxPort *port, OMX_U8 *pBuffer)
+{
+    guint i;
+
+    for (i = 0; i < port->num_buffers; i++)
+        if (port->buffers[i]->pBuffer == pBuffer)
+            return port->buffers[i];
+
+    return NULL;
+}
+
+/*
+ * Tests
+ */
+
+GST_START_TEST (test_lookup)
+{
+    guint i;
+
+    fail_unless (in_port->buffer_table != NULL);
+
+    for (i = 0; i < NUM_BUFFERS; i++)
+    {
+        fail_unless (g_omx_port_lookup_buffer (in_port, blocks[i]) ==
+                     in_port->buffers[i]);
+        fail_unless (g_omx_port_lookup_buffer (in_port, blocks[i] + 1) == NULL);
+    }
+}
+GST_END_TEST
+
+GST_START_TEST (test_send_transport)
+{
+    guint i;
+
+    /* out of allocation order, to catch a lookup falling back to index 0 */
+    for (i = NUM_BUFFERS; i-- > 0; )
+    {
+        GstBuffer *buf;
+        gint sent;
+
+        buf = gst_omxbuffertransport_new (up_port, up_port->buffers[i]);
+        fail_unless (buf != NULL);
+
+        fail_unless (g_omx_port_get_buffer_header (in_port, buf) ==
+                     in_port->buffers[i]);
+
+        sent = g_omx_port_send (in_port, buf);
+        fail_unless_equals_int (sent, BUFFER_SIZE);
+
+        fail_unless (mock.last_etb == in_port->buffers[i]);
+        fail_unless (mock.last_etb->pBuffer == blocks[i]);
+        fail_unless (mock.last_etb->pAppPrivate == NULL);
+
+        ASSERT_BUFFER_REFCOUNT (buf, "buf", 1);
+        gst_buffer_unref (buf);
+    }
+
+    fail_unless_equals_int (mock.etb_count, NUM_BUFFERS);
+    fail_unless (gst_bus_poll (bus, GST_MESSAGE_ERROR, 0) == NULL);
+}
+GST_END_TEST
+
+GST_START_TEST (test_send_unknown)
+{
+    OMX_BUFFERHEADERTYPE foreign = { 0 };
+    GstBuffer *buf;
+    GstMessage *msg;
+    gint sent;
+
+    foreign.pBuffer = g_malloc0 (BUFFER_SIZE);
+    foreign.nFilledLen = BUFFER_SIZE;
+
+    buf = gst_omxbuffertransport_new (up_port, &foreign);
+
+    /* must not silently reuse another header */
+    sent = g_omx_port_send (in_port, buf);
+    fail_unless (sent < 0);
+    fail_unless_equals_int (mock.etb_count, 0);
+
+    msg = gst_bus_poll (bus, GST_MESSAGE_ERROR, 0);
+    fail_unless (msg != NULL, "lookup miss was not reported");
+    gst_message_unref (msg);
+
+    gst_buffer_unref (buf);
+    g_free (foreign.pBuffer);
+}
+GST_END_TEST
+
+GST_START_TEST (test_send_own)
+{
+    OMX_BUFFERHEADERTYPE *omx_buffer;
+    GstBuffer *buf;
+    guint i;
+    gint sent;
+
+    /* copy mode, with all the headers free, as after g_omx_core_start() */
+    in_port->always_copy = TRUE;
+    for (i = 0; i < NUM_BUFFERS; i++)
+        g_omx_port_push_buffer (in_port, in_port->buffers[i]);
+
+    /* what GstOmxBaseSink's buffer_alloc hands out */
+    omx_buffer = async_queue_pop (in_port->queue);
+    omx_buffer->nFilledLen = BUFFER_SIZE / 2;
+    buf = gst_omxbuffertransport_new (in_port, omx_buffer);
+    memset (GST_BUFFER_DATA (buf), 0x5a, GST_BUFFER_SIZE (buf));
+
+    sent = g_omx_port_send (in_port, buf);
+    fail_unless_equals_int (sent, BUFFER_SIZE / 2);
+    fail_unless_equals_int (mock.etb_count, 1);
+
+    /* the very same header and memory went out, no other header used */
+    fail_unless (mock.last_etb == omx_buffer);
+    fail_unless (mock.last_etb->pBuffer == GST_BUFFER_DATA (buf));
+    fail_unless_equals_int (in_port->queue->length, NUM_BUFFERS);
+
+    /* and the buffer does not send it a second time when freed */
+    gst_buffer_unref (buf);
+    fail_unless_equals_int (mock.etb_count, 1);
+    fail_unless_equals_int (in_port->queue->length, NUM_BUFFERS);
+
+    /* an allocated buffer which never got sent goes back to the queue */
+    omx_buffer = async_queue_pop (in_port->queue);
+    buf = gst_omxbuffertransport_new (in_port, omx_buffer);
+    fail_unless_equals_int (in_port->queue->length, NUM_BUFFERS - 1);
+    gst_buffer_unref (buf);
+    fail_unless_equals_int (mock.etb_count, 1);
+    fail_unless_equals_int (in_port->queue->length, NUM_BUFFERS);
+}
+GST_END_TEST
+
+GST_START_TEST (test_transport_soak)
+{
+    GstBuffer *held[SOAK_HELD] = { NULL };
+    GHashTable *seen;
+    glong rss_start = 0, rss_end;
+    guint i;
+
+    setup_out_port ();
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    /* keep a few buffers downstream at a time, like a sink would */
+    for (i = 0; i < SOAK_COUNT; i++)
+    {
+        GstBuffer *buf;
+
+        buf = g_omx_port_recv (out_port);
+        fail_unless (buf != NULL);
+        fail_unless (GST_IS_OMXBUFFERTRANSPORT (buf));
+        fail_unless_equals_int (GST_BUFFER_SIZE (buf), BUFFER_SIZE);
+        fail_unless (GST_BUFFER_TIMESTAMP (buf) == GST_CLOCK_TIME_NONE);
+
+        g_hash_table_insert (seen, buf, buf);
+
+        if (held[i % SOAK_HELD])
+            gst_buffer_unref (held[i % SOAK_HELD]);
+        held[i % SOAK_HELD] = buf;
+
+        /* after the pool has warmed up */
+        if (i == SOAK_COUNT / 10)
+            rss_start = rss_pages ();
+    }
+
+    rss_end = rss_pages ();
+
+    for (i = 0; i < SOAK_HELD; i++)
+        gst_buffer_unref (held[i]);
+
+    fail_unless (out_port->transports_allocated <= NUM_BUFFERS,
+            "%u transports allocated for %u buffers",
+            out_port->transports_allocated, NUM_BUFFERS);
+    fail_unless (g_hash_table_size (seen) <= NUM_BUFFERS);
+    fail_unless_equals_int (out_port->held, 0);
+
+    g_print ("%d buffers received, %u transports allocated, rss %ld -> %ld pages\n",
+             SOAK_COUNT, out_port->transports_allocated, rss_start, rss_end);
+    fail_unless (rss_end - rss_start < SOAK_RSS_PAGES,
+            "rss grew by %ld pages", rss_end - rss_start);
+
+    g_hash_table_destroy (seen);
+    free_out_port ();
+}
+GST_END_TEST
+
+GST_START_TEST (test_transport_additional_headers)
+{
+    OMX_BUFFERHEADERTYPE *extra[2];
+    GstBuffer *buf, *again;
+
+    setup_out_port ();
+
+    buf = g_omx_port_recv (out_port);
+    fail_unless (buf != NULL);
+
+    /* two more headers riding along with the first, as for interlaced
+     * fields, held like the first one
+     */
+    extra[0] = async_queue_pop (out_port->queue);
+    extra[1] = async_queue_pop (out_port->queue);
+    g_atomic_int_add (&out_port->held, 2);
+    gst_omxbuffertransport_set_additional_headers (GST_OMXBUFFERTRANSPORT (buf),
+            2, extra);
+    fail_unless (GST_OMXBUFFERTRANSPORT (buf)->addHeader != NULL);
+
+    /* every header goes back to the component, and the array with them */
+    gst_buffer_unref (buf);
+    fail_unless_equals_int (out_port->held, 0);
+    fail_unless_equals_int (out_port->queue->length, NUM_BUFFERS);
+    fail_unless (GST_OMXBUFFERTRANSPORT (buf)->addHeader == NULL);
+    fail_unless_equals_int (GST_OMXBUFFERTRANSPORT (buf)->numAdditionalHeaders, 0);
+
+    /* the same header gets the same, clean, transport back */
+    while ((again = g_omx_port_recv (out_port)) != buf)
+        gst_buffer_unref (again);
+    fail_unless (GST_OMXBUFFERTRANSPORT (again)->addHeader == NULL);
+    ASSERT_BUFFER_REFCOUNT (again, "again", 1);
+    gst_buffer_unref (again);
+
+    free_out_port ();
+}
+GST_END_TEST
+
+GST_START_TEST (test_lookup_cost)
+{
+    GTimer *timer;
+    gdouble table_time, linear_time;
+    guint i, hits;
+
+    timer = g_timer_new ();
+
+    hits = 0;
+    g_timer_start (timer);
+    for (i = 0; i < LOOKUP_COUNT; i++)
+        hits += g_omx_port_lookup_buffer (in_port, blocks[i % NUM_BUFFERS]) != NULL;
+    table_time = g_timer_elapsed (timer, NULL);
+    fail_unless_equals_int (hits, LOOKUP_COUNT);
+
+    hits = 0;
+    g_timer_start (timer);
+    for (i = 0; i < LOOKUP_COUNT; i++)
+        hits += linear_lookup (in_port, blocks[i % NUM_BUFFERS]) != NULL;
+    linear_time = g_timer_elapsed (timer, NULL);
+    fail_unless_equals_int (hits, LOOKUP_COUNT);
+
+    g_timer_destroy (timer);
+
+    g_print ("%d buffers: table %.1f ns/lookup, linear scan %.1f ns/lookup\n",
+             NUM_BUFFERS, table_time * 1e9 / LOOKUP_COUNT,
+             linear_time * 1e9 / LOOKUP_COUNT);
+}
+GST_END_TEST
+
+static Suite *
+gstomx_port_suite (void)
+{
+    Suite *s = suite_create ("gstomx_port");
+    TCase *tc_chain = tcase_create ("general");
+
+    GST_DEBUG_CATEGORY_INIT (gstomx_debug, "omx", 0, "gst-openmax");
+    GST_DEBUG_CATEGORY_INIT (gstomx_util_debug, "omx_util", 0, "gst-openmax utility");
+    GST_DEBUG_CATEGORY_INIT (gstomx_ppm, "omx_ppm", 0, "gst-openmax performance");
+
+    tcase_set_timeout (tc_chain, 20);
+    tcase_add_checked_fixture (tc_chain, setup, teardown);
+    tcase_add_test (tc_chain, test_lookup);
+    tcase_add_test (tc_chain, test_send_transport);
+    tcase_add_test (tc_chain, test_send_unknown);
+    tcase_add_test (tc_chain, test_send_own);
+    tcase_add_test (tc_chain, test_transport_soak);
+    tcase_add_test (tc_chain, test_transport_additional_headers);
+    tcase_add_test (tc_chain, test_lookup_cost);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (gstomx_port);
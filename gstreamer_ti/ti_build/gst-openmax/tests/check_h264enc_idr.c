@@ -0,0 +1,386 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * IDR scheduling of omx_h264enc, run against the DM816x mock in
+ * standalone/dm816x.c: the key frames must come out at the positions the
+ * period, interval, scene cut and GstForceKeyUnit settings ask for, for
+ * each encoder on its own.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define WIDTH 176
+#define HEIGHT 144
+#define FRAME_SIZE (WIDTH * HEIGHT * 3 / 2)
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-raw-yuv"));
+
+typedef struct
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstPad *mysinkpad;
+    GstCaps *caps;
+
+    GMutex *lock;
+    GCond *cond;
+    gboolean eos;
+    GString *key_frames;    /* indexes of the key frames which came out */
+    GString *key_units;     /* indexes GstForceKeyUnit events announced */
+} Encoder;
+
+static guint
+frame_index (GstClockTime timestamp)
+{
+    return gst_util_uint64_scale_round (timestamp, 30, GST_SECOND);
+}
+
+static void
+append_index (GString *str,
+              guint index)
+{
+    g_string_append_printf (str, "%s%u", str->len ? "," : "", index);
+}
+
+static GstFlowReturn
+test_sink_chain (GstPad *pad,
+                 GstBuffer *buf)
+{
+    Encoder *enc = gst_pad_get_element_private (pad);
+
+    g_mutex_lock (enc->lock);
+    if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT))
+        append_index (enc->key_frames, frame_index (GST_BUFFER_TIMESTAMP (buf)));
+    g_mutex_unlock (enc->lock);
+
+    gst_buffer_unref (buf);
+
+    return GST_FLOW_OK;
+}
+
+static gboolean
+test_sink_event (GstPad *pad,
+                 GstEvent *event)
+{
+    Encoder *enc = gst_pad_get_element_private (pad);
+    const GstStructure *structure;
+
+    structure = gst_event_get_structure (event);
+
+    g_mutex_lock (enc->lock);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        enc->eos = TRUE;
+        g_cond_signal (enc->cond);
+    }
+    else if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_DOWNSTREAM &&
+             gst_structure_has_name (structure, "GstForceKeyUnit"))
+    {
+        GstClockTime timestamp;
+
+        fail_unless (gst_structure_get_clock_time (structure, "timestamp", &timestamp));
+        append_index (enc->key_units, frame_index (timestamp));
+    }
+    g_mutex_unlock (enc->lock);
+
+    return gst_pad_event_default (pad, event);
+}
+
+static Encoder *
+setup_encoder (void)
+{
+    Encoder *enc;
+
+    enc = g_new0 (Encoder, 1);
+
+    enc->filter = gst_check_setup_element ("omx_h264enc");
+    enc->mysrcpad = gst_check_setup_src_pad (enc->filter, &srctemplate, NULL);
+    enc->mysinkpad = gst_check_setup_sink_pad (enc->filter, &sinktemplate, NULL);
+
+    gst_pad_set_element_private (enc->mysinkpad, enc);
+    gst_pad_set_chain_function (enc->mysinkpad, test_sink_chain);
+    gst_pad_set_event_function (enc->mysinkpad, test_sink_event);
+
+    gst_pad_set_active (enc->mysrcpad, TRUE);
+    gst_pad_set_active (enc->mysinkpad, TRUE);
+
+    enc->lock = g_mutex_new ();
+    enc->cond = g_cond_new ();
+    enc->key_frames = g_string_new (NULL);
+    enc->key_units = g_string_new (NULL);
+
+    enc->caps = gst_caps_new_simple ("video/x-raw-yuv",
+                                     "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('N', 'V', '1', '2'),
+                                     "width", G_TYPE_INT, WIDTH,
+                                     "height", G_TYPE_INT, HEIGHT,
+                                     "framerate", GST_TYPE_FRACTION, 30, 1,
+                                     NULL);
+
+    g_object_set (G_OBJECT (enc->filter), "library-name", "libomxil-dm816x.so", NULL);
+
+    fail_unless_equals_int (gst_element_set_state (enc->filter, GST_STATE_READY),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    /* keep the intra period of the component out of the way */
+    g_object_set (G_OBJECT (enc->filter), "i-period", 1000, NULL);
+
+    return enc;
+}
+
+static void
+start_encoder (Encoder *enc)
+{
+    fail_unless_equals_int (gst_element_set_state (enc->filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+}
+
+static void
+push_frame (Encoder *enc,
+            guint index,
+            guint8 luma)
+{
+    GstBuffer *inbuffer;
+
+    inbuffer = gst_buffer_new_and_alloc (FRAME_SIZE);
+    memset (GST_BUFFER_DATA (inbuffer), luma, WIDTH * HEIGHT);
+    memset (GST_BUFFER_DATA (inbuffer) + WIDTH * HEIGHT, 0x80, WIDTH * HEIGHT / 2);
+    GST_BUFFER_TIMESTAMP (inbuffer) = gst_util_uint64_scale (index, GST_SECOND, 30);
+    GST_BUFFER_DURATION (inbuffer) = gst_util_uint64_scale (1, GST_SECOND, 30);
+    gst_buffer_set_caps (inbuffer, enc->caps);
+
+    fail_unless (gst_pad_push (enc->mysrcpad, inbuffer) == GST_FLOW_OK);
+}
+
+static GstEvent *
+new_force_key_unit (GstEventType type,
+                    GstClockTime running_time,
+                    guint count)
+{
+    return gst_event_new_custom (type,
+            gst_structure_new ("GstForceKeyUnit",
+                               "running-time", G_TYPE_UINT64, running_time,
+                               "all-headers", G_TYPE_BOOLEAN, TRUE,
+                               "count", G_TYPE_UINT, count,
+                               NULL));
+}
+
+/* Drain the encoder and check where the key frames and GstForceKeyUnit
+ * events came out.
+ */
+static void
+finish_encoder (Encoder *enc,
+                const gchar *key_frames,
+                const gchar *key_units)
+{
+    fail_unless (gst_pad_push_event (enc->mysrcpad, gst_event_new_eos ()));
+
+    g_mutex_lock (enc->lock);
+    while (!enc->eos)
+        g_cond_wait (enc->cond, enc->lock);
+    g_mutex_unlock (enc->lock);
+
+    fail_unless_equals_string (enc->key_frames->str, key_frames);
+    fail_unless_equals_string (enc->key_units->str, key_units);
+
+    /* cleanup */
+    gst_element_set_state (enc->filter, GST_STATE_NULL);
+
+    gst_pad_set_active (enc->mysrcpad, FALSE);
+    gst_pad_set_active (enc->mysinkpad, FALSE);
+    gst_check_teardown_src_pad (enc->filter);
+    gst_check_teardown_sink_pad (enc->filter);
+    gst_check_teardown_element (enc->filter);
+
+    gst_caps_unref (enc->caps);
+    g_string_free (enc->key_frames, TRUE);
+    g_string_free (enc->key_units, TRUE);
+    g_mutex_free (enc->lock);
+    g_cond_free (enc->cond);
+    g_free (enc);
+}
+
+GST_START_TEST (test_idr_period)
+{
+    Encoder *enc;
+    guint i;
+
+    enc = setup_encoder ();
+    g_object_set (G_OBJECT (enc->filter), "force-idr-period", 10, NULL);
+    start_encoder (enc);
+
+    for (i = 0; i < 25; i++)
+        push_frame (enc, i, 0x10);
+
+    finish_encoder (enc, "0,10,20", "");
+}
+GST_END_TEST
+
+GST_START_TEST (test_two_encoders)
+{
+    Encoder *enc1, *enc2;
+    guint i;
+
+    /* each encoder keeps its own count of frames since the last IDR */
+    enc1 = setup_encoder ();
+    g_object_set (G_OBJECT (enc1->filter), "force-idr-period", 5, NULL);
+    start_encoder (enc1);
+
+    enc2 = setup_encoder ();
+    g_object_set (G_OBJECT (enc2->filter), "force-idr-period", 7, NULL);
+    start_encoder (enc2);
+
+    for (i = 0; i < 16; i++)
+    {
+        push_frame (enc1, i, 0x10);
+        push_frame (enc2, i, 0x10);
+    }
+
+    finish_encoder (enc1, "0,5,10,15", "");
+    finish_encoder (enc2, "0,7,14", "");
+}
+GST_END_TEST
+
+GST_START_TEST (test_force_idr)
+{
+    Encoder *enc;
+    guint i;
+
+    enc = setup_encoder ();
+    g_object_set (G_OBJECT (enc->filter), "force-idr-period", 10, NULL);
+    start_encoder (enc);
+
+    /* a forced IDR restarts the period */
+    for (i = 0; i < 20; i++)
+    {
+        if (i == 4)
+            g_object_set (G_OBJECT (enc->filter), "force-idr", TRUE, NULL);
+        push_frame (enc, i, 0x10);
+    }
+
+    finish_encoder (enc, "0,4,14", "");
+}
+GST_END_TEST
+
+GST_START_TEST (test_upstream_force_key_unit)
+{
+    Encoder *enc;
+    guint i;
+
+    enc = setup_encoder ();
+    start_encoder (enc);
+
+    for (i = 0; i < 20; i++)
+    {
+        /* ask for the first frame from frame 12 on */
+        if (i == 3)
+            fail_unless (gst_pad_push_event (enc->mysinkpad,
+                        new_force_key_unit (GST_EVENT_CUSTOM_UPSTREAM,
+                                gst_util_uint64_scale (12, GST_SECOND, 30), 1)));
+        push_frame (enc, i, 0x10);
+    }
+
+    finish_encoder (enc, "0,12", "12");
+}
+GST_END_TEST
+
+GST_START_TEST (test_downstream_force_key_unit)
+{
+    Encoder *enc;
+    guint i;
+
+    enc = setup_encoder ();
+    start_encoder (enc);
+
+    for (i = 0; i < 20; i++)
+    {
+        if (i == 9)
+            fail_unless (gst_pad_push_event (enc->mysrcpad,
+                        new_force_key_unit (GST_EVENT_CUSTOM_DOWNSTREAM,
+                                GST_CLOCK_TIME_NONE, 1)));
+        push_frame (enc, i, 0x10);
+    }
+
+    finish_encoder (enc, "0,9", "9");
+}
+GST_END_TEST
+
+GST_START_TEST (test_idr_interval)
+{
+    Encoder *enc;
+    guint i;
+
+    enc = setup_encoder ();
+    g_object_set (G_OBJECT (enc->filter), "idr-interval", 500, NULL);
+    start_encoder (enc);
+
+    for (i = 0; i < 40; i++)
+        push_frame (enc, i, 0x10);
+
+    finish_encoder (enc, "0,15,30", "");
+}
+GST_END_TEST
+
+GST_START_TEST (test_scene_cut)
+{
+    Encoder *enc;
+    guint i;
+
+    enc = setup_encoder ();
+    g_object_set (G_OBJECT (enc->filter), "scene-cut-threshold", 32, NULL);
+    start_encoder (enc);
+
+    /* a fade does not start a new GOP, a cut does */
+    for (i = 0; i < 20; i++)
+        push_frame (enc, i, i < 10 ? 0x10 + i * 4 : 0xc0);
+
+    finish_encoder (enc, "0,10", "");
+}
+GST_END_TEST
+
+static Suite *
+h264enc_idr_suite (void)
+{
+    Suite *s = suite_create ("h264enc_idr");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 30);
+    tcase_add_test (tc_chain, test_idr_period);
+    tcase_add_test (tc_chain, test_two_encoders);
+    tcase_add_test (tc_chain, test_force_idr);
+    tcase_add_test (tc_chain, test_upstream_force_key_unit);
+    tcase_add_test (tc_chain, test_downstream_force_key_unit);
+    tcase_add_test (tc_chain, test_idr_interval);
+    tcase_add_test (tc_chain, test_scene_cut);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (h264enc_idr);
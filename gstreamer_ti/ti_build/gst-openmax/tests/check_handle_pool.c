@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The handle pool of gstomx_util.c, run on omx_h264dec against the
+ * DM816x mock in standalone/dm816x.c with OMX_GetHandle() taking
+ * LOAD_DELAY: a decoder brought to NULL leaves its component for the next
+ * one, within the size and the timeout of the pool, set from
+ * OMX_HANDLE_POOL and OMX_HANDLE_POOL_TIMEOUT or from the "handle-pool" and
+ * "handle-pool-timeout" properties, and the component decodes for its new
+ * owner.  With OMX_HANDLE_POOL_PREWARM, a decoder loading its component
+ * fills the pool for the next one.
+ */
+
+#include <gst/check/gstcheck.h>
+
+/* in microseconds, see standalone/dm816x.c */
+#define LOAD_DELAY 100000
+
+#define FRAME_COUNT 16
+
+/* Seconds for a new decoder to get to READY, ie. to load its component */
+static gdouble
+load (GstElement **dec)
+{
+    GTimer *timer;
+    gdouble elapsed;
+
+    *dec = gst_element_factory_make ("omx_h264dec", NULL);
+    fail_unless (*dec != NULL);
+    g_object_set (*dec, "library-name", "libomxil-dm816x.so", NULL);
+
+    timer = g_timer_new ();
+    fail_unless_equals_int (gst_element_set_state (*dec, GST_STATE_READY),
+                            GST_STATE_CHANGE_SUCCESS);
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    return elapsed;
+}
+
+static void
+unload (GstElement *dec)
+{
+    fail_unless_equals_int (gst_element_set_state (dec, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+    gst_object_unref (dec);
+}
+
+static gboolean
+loaded_from_pool (gdouble elapsed)
+{
+    return elapsed < LOAD_DELAY / 2 / 1e6;
+}
+
+static void
+setup (void)
+{
+    gchar *value;
+
+    value = g_strdup_printf ("%d", LOAD_DELAY);
+    g_setenv ("OMX_MOCK_LOAD_DELAY_VIDDEC", value, TRUE);
+    g_free (value);
+
+    g_setenv ("OMX_HANDLE_POOL", "1", TRUE);
+}
+
+static void
+teardown (void)
+{
+    g_unsetenv ("OMX_MOCK_LOAD_DELAY_VIDDEC");
+    g_unsetenv ("OMX_HANDLE_POOL");
+    g_unsetenv ("OMX_HANDLE_POOL_TIMEOUT");
+    g_unsetenv ("OMX_HANDLE_POOL_PREWARM");
+}
+
+GST_START_TEST (test_reuse)
+{
+    GstElement *pipeline, *src, *filter, *dec, *sink;
+    GstCaps *caps;
+    GstBus *bus;
+    GstMessage *message;
+    gdouble elapsed;
+
+    elapsed = load (&dec);
+    fail_if (loaded_from_pool (elapsed));
+    unload (dec);
+
+    /* decode with the pooled component */
+    pipeline = gst_pipeline_new ("pipeline");
+    src = gst_element_factory_make ("fakesrc", NULL);
+    filter = gst_element_factory_make ("capsfilter", NULL);
+    sink = gst_element_factory_make ("fakesink", NULL);
+    elapsed = load (&dec);
+    fail_unless (loaded_from_pool (elapsed));
+
+    caps = gst_caps_from_string ("video/x-h264,width=176,height=144,framerate=30/1");
+    g_object_set (src,
+                  "num-buffers", FRAME_COUNT,
+                  "sizetype", 2,        /* fixed */
+                  "sizemax", 256,
+                  "filltype", 2,        /* zero */
+                  NULL);
+    g_object_set (filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+
+    gst_bin_add_many (GST_BIN (pipeline), src, filter, dec, sink, NULL);
+    fail_unless (gst_element_link_many (src, filter, dec, sink, NULL));
+
+    fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+             GST_STATE_CHANGE_FAILURE);
+
+    bus = gst_element_get_bus (pipeline);
+    message = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, 5 * GST_SECOND);
+    fail_unless (message != NULL);
+    fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+    gst_message_unref (message);
+    gst_object_unref (bus);
+
+    fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+    gst_object_unref (pipeline);
+
+    /* and back to the pool after going through OMX_StateExecuting */
+    elapsed = load (&dec);
+    fail_unless (loaded_from_pool (elapsed));
+    unload (dec);
+}
+GST_END_TEST
+
+GST_START_TEST (test_size)
+{
+    GstElement *dec[2];
+
+    load (&dec[0]);
+    load (&dec[1]);
+    unload (dec[0]);
+    unload (dec[1]);
+
+    /* only one was kept */
+    fail_unless (loaded_from_pool (load (&dec[0])));
+    fail_if (loaded_from_pool (load (&dec[1])));
+    unload (dec[0]);
+    unload (dec[1]);
+
+    /* without the pool */
+    g_unsetenv ("OMX_HANDLE_POOL");
+    load (&dec[0]);
+    unload (dec[0]);
+    fail_if (loaded_from_pool (load (&dec[0])));
+    unload (dec[0]);
+}
+GST_END_TEST
+
+GST_START_TEST (test_timeout)
+{
+    GstElement *dec;
+
+    g_setenv ("OMX_HANDLE_POOL_TIMEOUT", "50", TRUE);
+
+    load (&dec);
+    unload (dec);
+    fail_unless (loaded_from_pool (load (&dec)));
+    unload (dec);
+
+    g_usleep (100000);
+    fail_if (loaded_from_pool (load (&dec)));
+    unload (dec);
+}
+GST_END_TEST
+
+GST_START_TEST (test_properties)
+{
+    GstElement *dec;
+    guint size;
+    gint timeout;
+
+    g_unsetenv ("OMX_HANDLE_POOL");
+
+    load (&dec);
+    g_object_get (dec, "handle-pool", &size, "handle-pool-timeout", &timeout, NULL);
+    fail_unless_equals_int (size, 0);
+    fail_unless_equals_int (timeout, 60000);
+    g_object_set (dec, "handle-pool", 1, NULL);
+    unload (dec);
+
+    /* pooled by the property alone */
+    fail_unless (loaded_from_pool (load (&dec)));
+    g_object_set (dec, "handle-pool", 1, "handle-pool-timeout", 50, NULL);
+    unload (dec);
+
+    g_usleep (100000);
+    fail_if (loaded_from_pool (load (&dec)));
+    unload (dec);
+}
+GST_END_TEST
+
+GST_START_TEST (test_prewarm)
+{
+    GstElement *dec[2];
+    guint prewarm;
+
+    g_setenv ("OMX_HANDLE_POOL_PREWARM", "1", TRUE);
+
+    /* the first decoder loads its own, and a spare in the background */
+    fail_if (loaded_from_pool (load (&dec[0])));
+    g_object_get (dec[0], "handle-pool-prewarm", &prewarm, NULL);
+    fail_unless_equals_int (prewarm, 1);
+    g_usleep (2 * LOAD_DELAY);
+
+    /* which the second one gets while the first is still loaded */
+    fail_unless (loaded_from_pool (load (&dec[1])));
+    unload (dec[0]);
+    unload (dec[1]);
+
+    /* no spare beyond the size of the pool */
+    g_setenv ("OMX_HANDLE_POOL", "0", TRUE);
+    load (&dec[0]);
+    g_usleep (2 * LOAD_DELAY);
+    fail_if (loaded_from_pool (load (&dec[1])));
+    unload (dec[0]);
+    unload (dec[1]);
+}
+GST_END_TEST
+
+static Suite *
+handle_pool_suite (void)
+{
+    Suite *s = suite_create ("handle_pool");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 20);
+    tcase_add_checked_fixture (tc_chain, setup, teardown);
+    tcase_add_test (tc_chain, test_reuse);
+    tcase_add_test (tc_chain, test_size);
+    tcase_add_test (tc_chain, test_timeout);
+    tcase_add_test (tc_chain, test_properties);
+    tcase_add_test (tc_chain, test_prewarm);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (handle_pool);
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Runtime layout changes of omx_mosaicsink against the DM816x mock in
+ * standalone/dm816x.c, which like the display driver only has a few mosaic
+ * layout slots: a window moved on every frame, many more times than there
+ * are slots, must keep moving without the element running out of layouts.
+ */
+
+#include <gst/check/gstcheck.h>
+
+/* MOCK_VFDC_MAX_LAYOUTS in standalone/dm816x.c, times a few */
+#define NUM_FRAMES 20
+
+#define WIDTH 32
+#define HEIGHT 32
+
+/* move the window a little for every frame */
+static void
+handoff (GstElement *src,
+         GstBuffer *buffer,
+         GstPad *pad,
+         gpointer user_data)
+{
+    GstPad *window = user_data;
+    guint left;
+
+    g_object_get (window, "left", &left, NULL);
+    g_object_set (window, "left", left + 2, NULL);
+}
+
+GST_START_TEST (test_move_window)
+{
+    GstElement *pipeline, *src, *filter, *sink;
+    GstPad *window, *srcpad;
+    GstCaps *caps;
+    GstBus *bus;
+    GstMessage *message;
+    gboolean eos = FALSE;
+    guint left;
+
+    pipeline = gst_pipeline_new ("pipeline");
+    src = gst_element_factory_make ("fakesrc", NULL);
+    filter = gst_element_factory_make ("capsfilter", NULL);
+    sink = gst_element_factory_make ("omx_mosaicsink", NULL);
+    fail_unless (src && filter && sink);
+
+    g_object_set (src,
+                  "num-buffers", NUM_FRAMES,
+                  "sizetype", 2,        /* fixed */
+                  "sizemax", WIDTH * HEIGHT * 2,
+                  "filltype", 2,        /* zero */
+                  "signal-handoffs", TRUE,
+                  NULL);
+    caps = gst_caps_new_simple ("video/x-raw-yuv",
+                                "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('Y', 'U', 'Y', '2'),
+                                "width", G_TYPE_INT, WIDTH,
+                                "height", G_TYPE_INT, HEIGHT,
+                                "framerate", GST_TYPE_FRACTION, 30, 1,
+                                NULL);
+    g_object_set (filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+    g_object_set (sink, "library-name", "libomxil-dm816x.so", NULL);
+
+    gst_bin_add_many (GST_BIN (pipeline), src, filter, sink, NULL);
+    fail_unless (gst_element_link (src, filter));
+
+    window = gst_element_get_request_pad (sink, "sink_%d");
+    fail_unless (window != NULL);
+    srcpad = gst_element_get_static_pad (filter, "src");
+    fail_unless_equals_int (gst_pad_link (srcpad, window), GST_PAD_LINK_OK);
+    gst_object_unref (srcpad);
+
+    g_signal_connect (src, "handoff", G_CALLBACK (handoff), window);
+
+    fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+             GST_STATE_CHANGE_FAILURE);
+
+    /* a layout the driver refused is a warning, which must not happen */
+    bus = gst_element_get_bus (pipeline);
+    while (!eos)
+    {
+        message = gst_bus_timed_pop (bus, 10 * GST_SECOND);
+        fail_unless (message != NULL, "no EOS");
+
+        fail_if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_WARNING,
+                 "warning from %s", GST_MESSAGE_SRC_NAME (message));
+        fail_if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR,
+                 "error from %s", GST_MESSAGE_SRC_NAME (message));
+        eos = GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS;
+
+        gst_message_unref (message);
+    }
+    gst_object_unref (bus);
+
+    g_object_get (window, "left", &left, NULL);
+    fail_unless_equals_int (left, NUM_FRAMES * 2);
+
+    fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    gst_element_release_request_pad (sink, window);
+    gst_object_unref (window);
+    gst_object_unref (pipeline);
+}
+GST_END_TEST
+
+static Suite *
+mosaicsink_layout_suite (void)
+{
+    Suite *s = suite_create ("mosaicsink_layout");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 30);
+    tcase_add_test (tc_chain, test_move_window);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (mosaicsink_layout);
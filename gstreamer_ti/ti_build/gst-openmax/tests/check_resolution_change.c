@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Mid-stream resolution changes in omx_h264dec, run against the DM816x mock
+ * in standalone/dm816x.c: an elementary stream whose sequence parameter sets
+ * change the picture size goes through one running decoder, and every frame
+ * has to come out at the size of its sequence.  The time from the last frame
+ * of one size to the first of the next is reported.  The sink may hold on to
+ * its last frame, like a video sink does, which must not keep the decoder
+ * from switching nor change what the sink holds.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "h264_stream.h"
+
+#define FRAMES_PER_SEQUENCE 8
+#define MAX_FRAMES 64
+
+/* upper bound for the switch-over, generous for loaded build machines */
+#define MAX_SWITCH_TIME 0.5
+
+typedef struct
+{
+    gint width;
+    gint height;
+} Size;
+
+static const Size sequences[] = {
+    { 176, 144 },
+    { 352, 288 },
+    { 320, 180 },   /* cropped in the SPS */
+    { 176, 144 },
+};
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-h264"));
+
+/* what reached the sink, in order */
+typedef struct
+{
+    gint width;
+    gint height;
+    guint size;
+    gdouble time;
+} Frame;
+
+static Frame frames[MAX_FRAMES];
+static guint frame_count;
+static GTimer *timer;
+static GMutex *eos_mutex;
+static GCond *eos_cond;
+static gboolean eos;
+
+/* the last frame, when the sink holds on to it, and its first bytes */
+static gboolean hold;
+static GstBuffer *held;
+static guint8 held_data[64];
+static gboolean held_changed;
+
+/*
+ * Elementary stream generation
+ */
+
+typedef struct
+{
+    guint8 data[64];
+    guint pos;      /* in bits */
+} BitWriter;
+
+static void
+put_bits (BitWriter *writer,
+          guint value,
+          guint n)
+{
+    while (n--)
+    {
+        if (value & (1 << n))
+            writer->data[writer->pos / 8] |= 0x80 >> (writer->pos % 8);
+        writer->pos++;
+    }
+}
+
+static void
+put_ue (BitWriter *writer,
+        guint value)
+{
+    guint len = g_bit_storage (value + 1);
+
+    put_bits (writer, 0, len - 1);
+    put_bits (writer, value + 1, len);
+}
+
+/* Baseline profile SPS for a width x height picture */
+static void
+append_sps (GByteArray *stream,
+            gint width,
+            gint height)
+{
+    BitWriter writer = { { 0 }, 0 };
+    guint mbs_width = (width + 15) / 16;
+    guint mbs_height = (height + 15) / 16;
+    gboolean crop = (width % 16) || (height % 16);
+
+    put_bits (&writer, 66, 8);          /* profile_idc */
+    put_bits (&writer, 0, 8);           /* constraint flags */
+    put_bits (&writer, 30, 8);          /* level_idc */
+    put_ue (&writer, 0);                /* seq_parameter_set_id */
+    put_ue (&writer, 0);                /* log2_max_frame_num_minus4 */
+    put_ue (&writer, 0);                /* pic_order_cnt_type */
+    put_ue (&writer, 0);                /* log2_max_pic_order_cnt_lsb_minus4 */
+    put_ue (&writer, 1);                /* max_num_ref_frames */
+    put_bits (&writer, 0, 1);           /* gaps_in_frame_num_allowed_flag */
+    put_ue (&writer, mbs_width - 1);
+    put_ue (&writer, mbs_height - 1);
+    put_bits (&writer, 1, 1);           /* frame_mbs_only_flag */
+    put_bits (&writer, 1, 1);           /* direct_8x8_inference_flag */
+    put_bits (&writer, crop, 1);
+    if (crop)
+    {
+        /* in units of two pixels for 4:2:0 */
+        put_ue (&writer, 0);
+        put_ue (&writer, (mbs_width * 16 - width) / 2);
+        put_ue (&writer, 0);
+        put_ue (&writer, (mbs_height * 16 - height) / 2);
+    }
+    put_bits (&writer, 0, 1);           /* vui_parameters_present_flag */
+    put_bits (&writer, 1, 1);           /* rbsp_stop_one_bit */
+
+    append_nal (stream, 3, 7, writer.data, (writer.pos + 7) / 8);
+}
+
+static GstBuffer *
+create_frame (const Size *size,
+              guint index,
+              guint frame)
+{
+    static const guint8 pps[] = { 0xce, 0x38, 0x80 };
+    GByteArray *stream = g_byte_array_new ();
+    guint8 slice[32];
+    GstBuffer *buf;
+    GstCaps *caps;
+
+    if (frame == 0)
+    {
+        append_sps (stream, size->width, size->height);
+        append_nal (stream, 3, 8, pps, sizeof (pps));
+    }
+
+    memset (slice, 0x80 | index, sizeof (slice));
+    append_nal (stream, 3, frame == 0 ? 5 : 1, slice, sizeof (slice));
+
+    buf = gst_buffer_new_and_alloc (stream->len);
+    memcpy (GST_BUFFER_DATA (buf), stream->data, stream->len);
+    GST_BUFFER_TIMESTAMP (buf) = index * GST_SECOND / 30;
+    g_byte_array_free (stream, TRUE);
+
+    /* like a parser would, upstream follows the SPS */
+    caps = gst_caps_new_simple ("video/x-h264",
+                                "width", G_TYPE_INT, size->width,
+                                "height", G_TYPE_INT, size->height,
+                                "framerate", GST_TYPE_FRACTION, 30, 1,
+                                NULL);
+    gst_buffer_set_caps (buf, caps);
+    gst_caps_unref (caps);
+
+    return buf;
+}
+
+/*
+ * Sink
+ */
+
+/* frames are released straight away, or on the next one when holding */
+static GstFlowReturn
+test_sink_chain (GstPad *pad,
+                 GstBuffer *buf)
+{
+    GstStructure *structure;
+    Frame *frame;
+
+    fail_unless (GST_BUFFER_CAPS (buf) != NULL);
+    fail_unless (frame_count < MAX_FRAMES);
+
+    frame = &frames[frame_count];
+    structure = gst_caps_get_structure (GST_BUFFER_CAPS (buf), 0);
+    fail_unless (gst_structure_get_int (structure, "width", &frame->width));
+    fail_unless (gst_structure_get_int (structure, "height", &frame->height));
+    frame->size = GST_BUFFER_SIZE (buf);
+    frame->time = g_timer_elapsed (timer, NULL);
+    frame_count++;
+
+    if (held)
+    {
+        if (memcmp (GST_BUFFER_DATA (held), held_data,
+                    MIN (GST_BUFFER_SIZE (held), sizeof (held_data))))
+            held_changed = TRUE;
+        gst_buffer_unref (held);
+        held = NULL;
+    }
+
+    if (hold)
+    {
+        held = buf;
+        memcpy (held_data, GST_BUFFER_DATA (buf),
+                MIN (GST_BUFFER_SIZE (buf), sizeof (held_data)));
+    }
+    else
+    {
+        gst_buffer_unref (buf);
+    }
+
+    return GST_FLOW_OK;
+}
+
+static gboolean
+test_sink_event (GstPad *pad,
+                 GstEvent *event)
+{
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        g_mutex_lock (eos_mutex);
+        eos = TRUE;
+        g_cond_signal (eos_cond);
+        g_mutex_unlock (eos_mutex);
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+/* Decode all sequences with the mock holding @depth frames, and the sink
+ * its last one if @hold_last, and check what came out.
+ */
+static void
+decode (guint depth,
+        gboolean hold_last)
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstPad *mysinkpad;
+    gchar *value;
+    guint index;
+    guint i, j;
+
+    filter = gst_check_setup_element ("omx_h264dec");
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+
+    gst_pad_set_chain_function (mysinkpad, test_sink_chain);
+    gst_pad_set_event_function (mysinkpad, test_sink_event);
+
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    eos_mutex = g_mutex_new ();
+    eos_cond = g_cond_new ();
+    eos = FALSE;
+    frame_count = 0;
+    hold = hold_last;
+    held = NULL;
+    held_changed = FALSE;
+    timer = g_timer_new ();
+
+    g_object_set (G_OBJECT (filter), "library-name", "libomxil-dm816x.so", NULL);
+
+    value = g_strdup_printf ("%u", depth);
+    g_setenv ("OMX_MOCK_DEPTH_VIDDEC", value, TRUE);
+    g_free (value);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    g_unsetenv ("OMX_MOCK_DEPTH_VIDDEC");
+
+    index = 0;
+    for (i = 0; i < G_N_ELEMENTS (sequences); i++)
+    {
+        for (j = 0; j < FRAMES_PER_SEQUENCE; j++)
+        {
+            GstBuffer *inbuffer = create_frame (&sequences[i], index++, j);
+
+            fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+        }
+    }
+
+    fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+    g_mutex_lock (eos_mutex);
+    while (!eos)
+        g_cond_wait (eos_cond, eos_mutex);
+    g_mutex_unlock (eos_mutex);
+
+    fail_if (held_changed);
+    if (held)
+    {
+        gst_buffer_unref (held);
+        held = NULL;
+    }
+
+    /* no frame lost, each at the size of its sequence */
+    fail_unless_equals_int (frame_count,
+                            G_N_ELEMENTS (sequences) * FRAMES_PER_SEQUENCE);
+
+    for (index = 0; index < frame_count; index++)
+    {
+        const Size *size = &sequences[index / FRAMES_PER_SEQUENCE];
+
+        fail_unless_equals_int (frames[index].width, size->width);
+        fail_unless_equals_int (frames[index].height, size->height);
+        fail_unless_equals_int (frames[index].size,
+                                size->width * size->height * 3 / 2);
+
+        if (index > 0 && index % FRAMES_PER_SEQUENCE == 0)
+        {
+            gdouble switch_time = frames[index].time - frames[index - 1].time;
+
+            g_print ("depth %u: %dx%d -> %dx%d in %.3f ms\n", depth,
+                     frames[index - 1].width, frames[index - 1].height,
+                     size->width, size->height, switch_time * 1000.0);
+
+            fail_unless (switch_time < MAX_SWITCH_TIME);
+        }
+    }
+
+    /* cleanup */
+    gst_element_set_state (filter, GST_STATE_NULL);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_check_teardown_element (filter);
+
+    g_timer_destroy (timer);
+    g_mutex_free (eos_mutex);
+    g_cond_free (eos_cond);
+}
+
+GST_START_TEST (test_resolution_change)
+{
+    decode (0, FALSE);
+}
+GST_END_TEST
+
+GST_START_TEST (test_resolution_change_reordering)
+{
+    /* the frames held across a change come out at the old size first */
+    decode (2, FALSE);
+}
+GST_END_TEST
+
+GST_START_TEST (test_resolution_change_held)
+{
+    /* the sink keeps the last frame of the old size across each change */
+    decode (0, TRUE);
+}
+GST_END_TEST
+
+static Suite *
+resolution_change_suite (void)
+{
+    Suite *s = suite_create ("resolution_change");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 30);
+    tcase_add_test (tc_chain, test_resolution_change);
+    tcase_add_test (tc_chain, test_resolution_change_reordering);
+    tcase_add_test (tc_chain, test_resolution_change_held);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (resolution_change);
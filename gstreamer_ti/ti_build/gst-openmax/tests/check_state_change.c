@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * State transitions of GstOmxBaseFilter, run on omx_h264dec against the
+ * DM816x mock in standalone/dm816x.c, with the components taking some time
+ * to load and to change state: a transition which does not complete within
+ * "state-timeout" is an error, and with "async-state-change" the components
+ * of several channels load concurrently.  The startup time of pipelines of
+ * 1 to MAX_CHANNELS channels is reported either way.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#define MAX_CHANNELS 8
+
+/* in microseconds, see standalone/dm816x.c */
+#define LOAD_DELAY "100000"
+#define STATE_DELAY "20000"
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-h264"));
+
+/* fakesrc ! capsfilter ! omx_h264dec ! fakesink, channels times */
+static GstElement *
+create_pipeline (guint channels,
+                 gboolean async)
+{
+    GstElement *pipeline;
+    GstCaps *caps;
+    guint i;
+
+    pipeline = gst_pipeline_new ("pipeline");
+    caps = gst_caps_from_string ("video/x-h264,width=176,height=144,framerate=30/1");
+
+    for (i = 0; i < channels; i++)
+    {
+        GstElement *src, *filter, *dec, *sink;
+
+        src = gst_element_factory_make ("fakesrc", NULL);
+        filter = gst_element_factory_make ("capsfilter", NULL);
+        dec = gst_element_factory_make ("omx_h264dec", NULL);
+        sink = gst_element_factory_make ("fakesink", NULL);
+        fail_unless (src && filter && dec && sink);
+
+        g_object_set (src,
+                      "sizetype", 2,        /* fixed */
+                      "sizemax", 256,
+                      "filltype", 2,        /* zero */
+                      NULL);
+        g_object_set (filter, "caps", caps, NULL);
+        g_object_set (dec,
+                      "library-name", "libomxil-dm816x.so",
+                      "async-state-change", async,
+                      NULL);
+        g_object_set (sink, "sync", FALSE, NULL);
+
+        gst_bin_add_many (GST_BIN (pipeline), src, filter, dec, sink, NULL);
+        fail_unless (gst_element_link_many (src, filter, dec, sink, NULL));
+    }
+
+    gst_caps_unref (caps);
+
+    return pipeline;
+}
+
+/* Seconds from NULL until the first frame of every channel prerolled */
+static gdouble
+startup (guint channels,
+         gboolean async)
+{
+    GstElement *pipeline;
+    GstStateChangeReturn ret;
+    GTimer *timer;
+    gdouble elapsed;
+
+    pipeline = create_pipeline (channels, async);
+
+    timer = g_timer_new ();
+
+    ret = gst_element_set_state (pipeline, GST_STATE_PLAYING);
+    fail_if (ret == GST_STATE_CHANGE_FAILURE);
+
+    ret = gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+    fail_unless_equals_int (ret, GST_STATE_CHANGE_SUCCESS);
+
+    elapsed = g_timer_elapsed (timer, NULL);
+    g_timer_destroy (timer);
+
+    fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+    gst_object_unref (pipeline);
+
+    return elapsed;
+}
+
+static void
+setup (void)
+{
+    g_setenv ("OMX_MOCK_LOAD_DELAY_VIDDEC", LOAD_DELAY, TRUE);
+    g_setenv ("OMX_MOCK_STATE_DELAY_VIDDEC", STATE_DELAY, TRUE);
+}
+
+static void
+teardown (void)
+{
+    g_unsetenv ("OMX_MOCK_LOAD_DELAY_VIDDEC");
+    g_unsetenv ("OMX_MOCK_STATE_DELAY_VIDDEC");
+}
+
+GST_START_TEST (test_timeout)
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstPad *mysinkpad;
+    GstBuffer *inbuffer;
+    GstCaps *caps;
+    GstBus *bus;
+    GstMessage *message;
+    gboolean error = FALSE;
+    GTimer *timer;
+
+    /* much slower than the element waits for */
+    g_setenv ("OMX_MOCK_STATE_DELAY_VIDDEC", "500000", TRUE);
+
+    filter = gst_check_setup_element ("omx_h264dec");
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    bus = gst_bus_new ();
+    gst_element_set_bus (filter, bus);
+
+    g_object_set (G_OBJECT (filter),
+                  "library-name", "libomxil-dm816x.so",
+                  "state-timeout", 100,
+                  NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    caps = gst_caps_from_string ("video/x-h264,width=176,height=144,framerate=30/1");
+    inbuffer = gst_buffer_new_and_alloc (0x100);
+    memset (GST_BUFFER_DATA (inbuffer), 0, 0x100);
+    gst_buffer_set_caps (inbuffer, caps);
+    gst_caps_unref (caps);
+
+    /* the component gets to OMX_StateIdle too late */
+    timer = g_timer_new ();
+    fail_unless_equals_int (gst_pad_push (mysrcpad, inbuffer), GST_FLOW_ERROR);
+    fail_unless (g_timer_elapsed (timer, NULL) < 0.4);
+    g_timer_destroy (timer);
+
+    while ((message = gst_bus_pop (bus)))
+    {
+        if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+            error = TRUE;
+        gst_message_unref (message);
+    }
+    fail_unless (error);
+
+    /* cleanup */
+    gst_element_set_state (filter, GST_STATE_NULL);
+    gst_element_set_bus (filter, NULL);
+    gst_object_unref (bus);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_check_teardown_element (filter);
+}
+GST_END_TEST
+
+GST_START_TEST (test_async)
+{
+    GstElement *pipeline;
+
+    pipeline = create_pipeline (1, TRUE);
+
+    /* READY to PAUSED waits for the component in the background */
+    fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_ASYNC);
+    fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+                                                   GST_CLOCK_TIME_NONE),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    /* and going down while it loads is fine */
+    fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+    gst_element_set_state (pipeline, GST_STATE_PAUSED);
+    fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    gst_object_unref (pipeline);
+}
+GST_END_TEST
+
+GST_START_TEST (test_startup_time)
+{
+    guint channels;
+
+    for (channels = 1; channels <= MAX_CHANNELS; channels *= 2)
+    {
+        gdouble sync_time = startup (channels, FALSE);
+        gdouble async_time = startup (channels, TRUE);
+
+        g_print ("%u channels: %.1f ms, %.1f ms with async-state-change\n",
+                 channels, sync_time * 1000.0, async_time * 1000.0);
+
+        /* the components load concurrently */
+        if (channels == MAX_CHANNELS)
+            fail_unless (async_time < sync_time / 2);
+    }
+}
+GST_END_TEST
+
+static Suite *
+state_change_suite (void)
+{
+    Suite *s = suite_create ("state_change");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 60);
+    tcase_add_checked_fixture (tc_chain, setup, teardown);
+    tcase_add_test (tc_chain, test_timeout);
+    tcase_add_test (tc_chain, test_async);
+    tcase_add_test (tc_chain, test_startup_time);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (state_change);
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * QoS in omx_h264dec, run against the DM816x mock in standalone/dm816x.c:
+ * a sink that takes longer than a frame period for every frame sends QoS
+ * events upstream, and the decoder has to drop late pictures nothing is
+ * predicted from, never a reference picture, and post a QoS message for
+ * each one it drops.
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "h264_stream.h"
+
+#define NUM_FRAMES 45
+
+/* every third picture is a reference, the IDR first */
+#define IS_REFERENCE(index) ((index) % 3 == 0)
+
+/* microseconds the sink spends on each frame, three frame periods */
+#define SINK_DELAY 100000
+
+static GstStaticPadTemplate sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+                         GST_PAD_SINK,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+                         GST_PAD_SRC,
+                         GST_PAD_ALWAYS,
+                         GST_STATIC_CAPS ("video/x-h264"));
+
+static gboolean seen[NUM_FRAMES];
+static guint frame_count;
+static gboolean bad_frame;
+static GTimer *timer;
+static GMutex *eos_mutex;
+static GCond *eos_cond;
+static gboolean eos;
+
+/*
+ * Elementary stream generation
+ */
+
+static GstBuffer *
+create_frame (guint index)
+{
+    /* Baseline 176x144 */
+    static const guint8 sps[] = { 0x42, 0x00, 0x1e, 0xf4, 0x16, 0x27, 0x20 };
+    static const guint8 pps[] = { 0xce, 0x38, 0x80 };
+    GByteArray *stream = g_byte_array_new ();
+    guint8 slice[32];
+    GstBuffer *buf;
+    GstCaps *caps;
+
+    if (index == 0)
+    {
+        append_nal (stream, 3, 7, sps, sizeof (sps));
+        append_nal (stream, 3, 8, pps, sizeof (pps));
+    }
+
+    memset (slice, 0x80 | index, sizeof (slice));
+    if (IS_REFERENCE (index))
+        append_nal (stream, 3, index == 0 ? 5 : 1, slice, sizeof (slice));
+    else
+        append_nal (stream, 0, 1, slice, sizeof (slice));
+
+    buf = gst_buffer_new_and_alloc (stream->len);
+    memcpy (GST_BUFFER_DATA (buf), stream->data, stream->len);
+    GST_BUFFER_TIMESTAMP (buf) = index * GST_SECOND / 30;
+    GST_BUFFER_DURATION (buf) = GST_SECOND / 30;
+    g_byte_array_free (stream, TRUE);
+
+    caps = gst_caps_new_simple ("video/x-h264",
+                                "width", G_TYPE_INT, 176,
+                                "height", G_TYPE_INT, 144,
+                                "framerate", GST_TYPE_FRACTION, 30, 1,
+                                NULL);
+    gst_buffer_set_caps (buf, caps);
+    gst_caps_unref (caps);
+
+    return buf;
+}
+
+/*
+ * Sink
+ */
+
+/* Take SINK_DELAY for each frame, and tell upstream how late it came in
+ * against the wall clock, started by the first frame.
+ */
+static GstFlowReturn
+test_sink_chain (GstPad *pad,
+                 GstBuffer *buf)
+{
+    GstClockTime timestamp = GST_BUFFER_TIMESTAMP (buf);
+    GstClockTimeDiff jitter;
+    guint index;
+
+    /* OMX keeps microseconds, round back to the frame */
+    index = (timestamp + GST_MSECOND) * 30 / GST_SECOND;
+
+    if (index >= NUM_FRAMES || seen[index])
+        bad_frame = TRUE;
+    else
+        seen[index] = TRUE;
+
+    if (frame_count++ == 0)
+        g_timer_start (timer);
+
+    jitter = (GstClockTimeDiff) (g_timer_elapsed (timer, NULL) * GST_SECOND) -
+             (GstClockTimeDiff) timestamp;
+
+    gst_buffer_unref (buf);
+    g_usleep (SINK_DELAY);
+
+    gst_pad_push_event (pad, gst_event_new_qos (jitter > 0 ? 0.3 : 1.0,
+                                                jitter, timestamp));
+
+    return GST_FLOW_OK;
+}
+
+static gboolean
+test_sink_event (GstPad *pad,
+                 GstEvent *event)
+{
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+    {
+        g_mutex_lock (eos_mutex);
+        eos = TRUE;
+        g_cond_signal (eos_cond);
+        g_mutex_unlock (eos_mutex);
+    }
+
+    return gst_pad_event_default (pad, event);
+}
+
+/* Decode the stream into the slow sink, check what came out and return the
+ * number of frames dropped.
+ */
+static guint
+decode (gboolean qos)
+{
+    GstElement *filter;
+    GstPad *mysrcpad;
+    GstPad *mysinkpad;
+    GstBus *bus;
+    GstMessage *message;
+    guint64 last_dropped = 0;
+    guint messages = 0;
+    guint index;
+
+    filter = gst_check_setup_element ("omx_h264dec");
+    mysrcpad = gst_check_setup_src_pad (filter, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad (filter, &sinktemplate, NULL);
+
+    gst_pad_set_chain_function (mysinkpad, test_sink_chain);
+    gst_pad_set_event_function (mysinkpad, test_sink_event);
+
+    gst_pad_set_active (mysrcpad, TRUE);
+    gst_pad_set_active (mysinkpad, TRUE);
+
+    bus = gst_bus_new ();
+    gst_element_set_bus (filter, bus);
+
+    eos_mutex = g_mutex_new ();
+    eos_cond = g_cond_new ();
+    eos = FALSE;
+    frame_count = 0;
+    bad_frame = FALSE;
+    memset (seen, 0, sizeof (seen));
+    timer = g_timer_new ();
+
+    g_object_set (G_OBJECT (filter),
+                  "library-name", "libomxil-dm816x.so",
+                  "qos", qos,
+                  NULL);
+
+    fail_unless_equals_int (gst_element_set_state (filter, GST_STATE_PLAYING),
+                            GST_STATE_CHANGE_SUCCESS);
+
+    fail_unless (gst_pad_push_event (mysrcpad,
+                 gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+    for (index = 0; index < NUM_FRAMES; index++)
+        fail_unless (gst_pad_push (mysrcpad, create_frame (index)) == GST_FLOW_OK);
+
+    fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+    g_mutex_lock (eos_mutex);
+    while (!eos)
+        g_cond_wait (eos_cond, eos_mutex);
+    g_mutex_unlock (eos_mutex);
+
+    /* every frame at most once, and no reference picture lost */
+    fail_if (bad_frame);
+    for (index = 0; index < NUM_FRAMES; index++)
+    {
+        if (IS_REFERENCE (index))
+            fail_unless (seen[index], "reference frame %u dropped", index);
+    }
+
+    /* one message for each frame dropped */
+    while ((message = gst_bus_pop_filtered (bus, GST_MESSAGE_QOS)))
+    {
+        GstFormat format;
+        guint64 processed, dropped;
+        GstClockTime timestamp;
+
+        gst_message_parse_qos (message, NULL, NULL, NULL, &timestamp, NULL);
+        gst_message_parse_qos_stats (message, &format, &processed, &dropped);
+
+        fail_unless_equals_int (format, GST_FORMAT_BUFFERS);
+        fail_unless_equals_uint64 (dropped, last_dropped + 1);
+        index = (timestamp + GST_MSECOND) * 30 / GST_SECOND;
+        fail_if (IS_REFERENCE (index));
+        fail_if (seen[index]);
+
+        last_dropped = dropped;
+        messages++;
+        gst_message_unref (message);
+    }
+
+    fail_unless_equals_int (messages, NUM_FRAMES - frame_count);
+
+    /* cleanup */
+    gst_element_set_state (filter, GST_STATE_NULL);
+
+    gst_pad_set_active (mysrcpad, FALSE);
+    gst_pad_set_active (mysinkpad, FALSE);
+    gst_check_teardown_src_pad (filter);
+    gst_check_teardown_sink_pad (filter);
+    gst_element_set_bus (filter, NULL);
+    gst_object_unref (bus);
+    gst_check_teardown_element (filter);
+
+    g_timer_destroy (timer);
+    g_mutex_free (eos_mutex);
+    g_cond_free (eos_cond);
+
+    return messages;
+}
+
+GST_START_TEST (test_qos_drop)
+{
+    guint dropped = decode (TRUE);
+
+    GST_INFO ("%u of %u frames dropped", dropped, NUM_FRAMES);
+
+    fail_unless (dropped > 0);
+}
+GST_END_TEST
+
+GST_START_TEST (test_qos_disabled)
+{
+    fail_unless_equals_int (decode (FALSE), 0);
+}
+GST_END_TEST
+
+static Suite *
+videodec_qos_suite (void)
+{
+    Suite *s = suite_create ("videodec_qos");
+    TCase *tc_chain = tcase_create ("general");
+
+    tcase_set_timeout (tc_chain, 30);
+    tcase_add_test (tc_chain, test_qos_drop);
+    tcase_add_test (tc_chain, test_qos_disabled);
+    suite_add_tcase (s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN (videodec_qos);
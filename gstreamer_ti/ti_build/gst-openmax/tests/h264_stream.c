@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * H.264 elementary stream generation shared by the decoder tests.
+ */
+
+#include "h264_stream.h"
+
+/* Append a NAL unit with its start code, and emulation prevention bytes
+ * where the payload needs them.
+ */
+void
+append_nal (GByteArray *stream,
+            guint8 ref_idc,
+            guint8 type,
+            const guint8 *payload,
+            guint size)
+{
+    static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+    guint8 header = (ref_idc << 5) | type;
+    guint zeros = 0;
+    guint i;
+
+    g_byte_array_append (stream, start_code, sizeof (start_code));
+    g_byte_array_append (stream, &header, 1);
+
+    for (i = 0; i < size; i++)
+    {
+        if (zeros == 2 && payload[i] <= 0x03)
+        {
+            static const guint8 epb = 0x03;
+
+            g_byte_array_append (stream, &epb, 1);
+            zeros = 0;
+        }
+
+        g_byte_array_append (stream, &payload[i], 1);
+        zeros = payload[i] ? 0 : zeros + 1;
+    }
+}
@@ -0,0 +1,2253 @@
+/*
+ * Copyright (C) 2010-2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Host side mock of the DM816x OpenMAX IL components.
+ *
+ * The components used by the gst-openmax element table are implemented on
+ * top of plain memory, so that the elements can be run on a development
+ * host by pointing their "library-name" property at this library:
+ *
+ *   LD_LIBRARY_PATH=tests/standalone/.libs gst-launch \
+ *       videotestsrc ! omx_scaler library-name=libomxil-dm816x.so ! ...
+ *
+ * Every component has its own thread which completes commands
+ * asynchronously, the way the real components do, and processes buffers
+ * while in OMX_StateExecuting.  The time spent on every frame is read from
+ * the environment when the handle is created, in microseconds:
+ *
+ *   OMX_MOCK_DELAY           default for all components
+ *   OMX_MOCK_DELAY_<NAME>    per component, ie. OMX_MOCK_DELAY_VIDDEC
+ *
+ * The same way, OMX_MOCK_DEPTH sets how many input frames a component with
+ * both input and output ports holds before it produces the first output
+ * frame, like a decoder reordering frames does.  An EOS flagged input buffer
+ * drains them.  OMX_MOCK_DROP_EOS swallows EOS flagged input buffers
+ * instead of returning them on the output port, as some EZSDK components do.
+ *
+ * OMX_MOCK_LOAD_DELAY is spent in OMX_GetHandle(), and OMX_MOCK_STATE_DELAY
+ * on every state transition, like the coprocessor takes to load and to set
+ * up a component.
+ *
+ * The decoder reads the picture size from the H.264 sequence parameter sets
+ * of its input.  When it changes, the frames still held come out, then the
+ * output port definition is updated and OMX_EventPortSettingsChanged sent,
+ * and nothing is decoded until the client has disabled and enabled the
+ * output port again.
+ */
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+
+#include <xdc/std.h>
+#include <OMX_TI_Index.h>
+#include <OMX_TI_Common.h>
+#include <omx_vfpc.h>
+#include <omx_vfdc.h>
+#include <omx_vfcc.h>
+#include <omx_ctrl.h>
+
+#include <glib.h>
+
+#include <stdlib.h> /* For atol */
+#include <string.h> /* For memcpy, memset, strcmp */
+
+#define MOCK_MAX_PORTS 32
+#define MOCK_VFDC_NUM_PORTS 16
+#define MOCK_VFDC_MAX_LAYOUTS 4
+#define MOCK_FRAMERATE 30
+#define MOCK_NO_PORT 0xFFFFFFFE
+
+/* not defined by the EZSDK headers, only needs to be unique: */
+#define MOCK_INDEX_NAL_FORMAT ((OMX_INDEXTYPE) (OMX_IndexVendorStartUnused + 0x00F00000))
+
+typedef struct MockClass MockClass;
+typedef struct MockComponent MockComponent;
+typedef struct MockPort MockPort;
+typedef struct MockCommand MockCommand;
+
+typedef void (*MockProcessFunc) (MockComponent *comp,
+                                 MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                                 MockPort *out, OMX_BUFFERHEADERTYPE *out_buffer);
+
+/* Looks at the next input buffer before it is processed, with the lock
+ * held.  Returns FALSE if the output port settings changed, or are about
+ * to once the frames still held are out.
+ */
+typedef gboolean (*MockSettingsFunc) (MockComponent *comp,
+                                      MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                                      MockPort *out);
+
+struct MockClass
+{
+    const gchar *name;
+    guint num_in;
+    guint in_start;
+    guint num_out;
+    guint out_start;
+    gboolean enabled;
+    OMX_VIDEO_CODINGTYPE in_coding;
+    OMX_COLOR_FORMATTYPE in_color;
+    guint in_buffers;
+    OMX_VIDEO_CODINGTYPE out_coding;
+    OMX_COLOR_FORMATTYPE out_color;
+    guint out_buffers;
+    MockProcessFunc process;
+    const OMX_INDEXTYPE *indices;
+    MockSettingsFunc settings;
+};
+
+struct MockPort
+{
+    OMX_PARAM_PORTDEFINITIONTYPE def;
+    GQueue *pending;
+    /* copies of the input buffers consumed but not processed yet */
+    GQueue *held;
+    guint populated;
+    /* waiting for the client to disable the port after a settings change */
+    gboolean settings_changed;
+};
+
+struct MockCommand
+{
+    OMX_COMMANDTYPE cmd;
+    OMX_U32 param;
+    OMX_PTR data;
+};
+
+struct MockComponent
+{
+    const MockClass *klass;
+    OMX_COMPONENTTYPE *handle;
+    OMX_CALLBACKTYPE callbacks;
+    OMX_PTR app_data;
+
+    GMutex *mutex;
+    GCond *cond;
+    GThread *thread;
+    gboolean quit;
+
+    OMX_STATETYPE state;
+    GQueue *commands;
+
+    MockPort ports[MOCK_MAX_PORTS];
+    guint num_ports;
+    guint next_channel;
+
+    GHashTable *params;
+    gchar role[OMX_MAX_STRINGNAME_SIZE];
+
+    gulong delay;
+    gulong state_delay;
+    guint depth;
+    gboolean drop_eos;
+    guint frames;
+    gint p_frames;
+    gint force_intra;
+    /* the input buffer queued after an intra refresh request */
+    gpointer intra_buffer;
+    /* VFDC mosaic layout slots in use, one bit each, and the one shown */
+    guint layouts;
+    gint layout;
+};
+
+/* Common header of the parameter and config structures. */
+typedef struct
+{
+    OMX_U32 nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32 nPortIndex;
+} MockParamHeader;
+
+static void viddec_process (MockComponent *comp,
+                            MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                            MockPort *out, OMX_BUFFERHEADERTYPE *out_buffer);
+static void videnc_process (MockComponent *comp,
+                            MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                            MockPort *out, OMX_BUFFERHEADERTYPE *out_buffer);
+static void vfpc_process (MockComponent *comp,
+                          MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                          MockPort *out, OMX_BUFFERHEADERTYPE *out_buffer);
+static void vfdc_process (MockComponent *comp,
+                          MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                          MockPort *out, OMX_BUFFERHEADERTYPE *out_buffer);
+static void vfcc_process (MockComponent *comp,
+                          MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                          MockPort *out, OMX_BUFFERHEADERTYPE *out_buffer);
+
+static gboolean viddec_settings (MockComponent *comp,
+                                 MockPort *in, OMX_BUFFERHEADERTYPE *in_buffer,
+                                 MockPort *out);
+
+/*
+ * Component classes
+ */
+
+static const OMX_INDEXTYPE ducati_indices[] = {
+    OMX_TI_IndexParamBuffMemType,
+    MOCK_INDEX_NAL_FORMAT,
+    0
+};
+
+static const OMX_INDEXTYPE vfpc_indices[] = {
+    OMX_TI_IndexParamBuffMemType,
+    OMX_TI_IndexConfigVidChResolution,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFPCNumChPerHandle,
+    (OMX_INDEXTYPE) OMX_TI_IndexConfigAlgEnable,
+    0
+};
+
+static const OMX_INDEXTYPE vfdc_indices[] = {
+    OMX_TI_IndexParamBuffMemType,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCDriverInstId,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCCreateMosaicLayout,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCDeleteMosaicLayout,
+    (OMX_INDEXTYPE) OMX_TI_IndexConfigVFDCMosaicPort2WinMap,
+    0
+};
+
+static const OMX_INDEXTYPE ctrl_indices[] = {
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCDriverInstId,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFCCHwPortID,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFCCHwPortProperties,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamCTRLVidDecInfo,
+    0
+};
+
+static const OMX_INDEXTYPE vfcc_indices[] = {
+    OMX_TI_IndexParamBuffMemType,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFCCHwPortID,
+    (OMX_INDEXTYPE) OMX_TI_IndexParamVFCCHwPortProperties,
+    0
+};
+
+static const MockClass mock_classes[] = {
+    { "OMX.TI.DUCATI.VIDDEC", 1, 0, 1, 1, TRUE,
+      OMX_VIDEO_CodingAVC, OMX_COLOR_FormatUnused, 4,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYUV420SemiPlanar, 8,
+      viddec_process, ducati_indices, viddec_settings },
+    { "OMX.TI.DUCATI.VIDENC", 1, 0, 1, 1, TRUE,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYUV420SemiPlanar, 4,
+      OMX_VIDEO_CodingAVC, OMX_COLOR_FormatUnused, 4,
+      videnc_process, ducati_indices },
+    { "OMX.TI.VPSSM3.VFPC.INDTXSCWB",
+      OMX_VFPC_OUTPUT_PORT_START_INDEX - OMX_VFPC_INPUT_PORT_START_INDEX,
+      OMX_VFPC_INPUT_PORT_START_INDEX,
+      OMX_VFPC_OUTPUT_PORT_START_INDEX - OMX_VFPC_INPUT_PORT_START_INDEX,
+      OMX_VFPC_OUTPUT_PORT_START_INDEX, FALSE,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYUV420SemiPlanar, 4,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYCbYCr, 4,
+      vfpc_process, vfpc_indices },
+    { "OMX.TI.VPSSM3.VFPC.NF",
+      OMX_VFPC_OUTPUT_PORT_START_INDEX - OMX_VFPC_INPUT_PORT_START_INDEX,
+      OMX_VFPC_INPUT_PORT_START_INDEX,
+      OMX_VFPC_OUTPUT_PORT_START_INDEX - OMX_VFPC_INPUT_PORT_START_INDEX,
+      OMX_VFPC_OUTPUT_PORT_START_INDEX, FALSE,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYCbYCr, 4,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYUV420SemiPlanar, 4,
+      vfpc_process, vfpc_indices },
+    { "OMX.TI.VPSSM3.VFDC", MOCK_VFDC_NUM_PORTS, OMX_VFDC_INPUT_PORT_START_INDEX, 0, 0, FALSE,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYCbYCr, 4,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatUnused, 0,
+      vfdc_process, vfdc_indices },
+    { "OMX.TI.VPSSM3.CTRL.DC", 0, 0, 0, 0, FALSE,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatUnused, 0,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatUnused, 0,
+      NULL, ctrl_indices },
+    { "OMX.TI.VPSSM3.CTRL.TVP", 0, 0, 0, 0, FALSE,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatUnused, 0,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatUnused, 0,
+      NULL, ctrl_indices },
+    { "OMX.TI.VPSSM3.VFCC", 0, 0, 1, 0, TRUE,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatUnused, 0,
+      OMX_VIDEO_CodingUnused, OMX_COLOR_FormatYCbYCr, 8,
+      vfcc_process, vfcc_indices },
+    { NULL }
+};
+
+/*
+ * Helpers
+ */
+
+static inline gboolean
+is_input (MockComponent *comp,
+          MockPort *port)
+{
+    return port->def.eDir == OMX_DirInput;
+}
+
+static inline MockPort *
+get_port (MockComponent *comp,
+          OMX_U32 index)
+{
+    if (index >= comp->num_ports)
+        return NULL;
+
+    return &comp->ports[index];
+}
+
+static guint
+frame_stride (const OMX_VIDEO_PORTDEFINITIONTYPE *video)
+{
+    if (video->nStride > 0)
+        return video->nStride;
+
+    if (video->eColorFormat == OMX_COLOR_FormatYCbYCr)
+        return video->nFrameWidth * 2;
+
+    return video->nFrameWidth;
+}
+
+static guint
+frame_size (const OMX_VIDEO_PORTDEFINITIONTYPE *video)
+{
+    guint size;
+
+    size = frame_stride (video) * video->nFrameHeight;
+
+    if (video->eColorFormat == OMX_COLOR_FormatYUV420SemiPlanar ||
+        video->eColorFormat == OMX_COLOR_FormatYUV420Planar)
+        size = size * 3 / 2;
+
+    return size;
+}
+
+static void
+update_buffer_size (MockPort *port)
+{
+    OMX_VIDEO_PORTDEFINITIONTYPE *video;
+
+    video = &port->def.format.video;
+
+    if (video->eCompressionFormat != OMX_VIDEO_CodingUnused)
+        return;
+
+    video->nStride = frame_stride (video);
+    port->def.nBufferSize = MAX (port->def.nBufferSize, frame_size (video));
+}
+
+static gboolean
+index_supported (MockComponent *comp,
+                 OMX_INDEXTYPE index)
+{
+    const OMX_INDEXTYPE *cur;
+
+    if ((guint) index < OMX_IndexVendorStartUnused)
+        return TRUE;
+
+    for (cur = comp->klass->indices; *cur; cur++)
+    {
+        if (*cur == index)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gchar *
+param_key (OMX_INDEXTYPE index,
+           OMX_PTR param)
+{
+    if (index == (OMX_INDEXTYPE) OMX_TI_IndexConfigVidChResolution)
+    {
+        OMX_CONFIG_VIDCHANNEL_RESOLUTION *resolution = param;
+        return g_strdup_printf ("%x:%d:%lu", index,
+                                resolution->eDir, (gulong) resolution->nChId);
+    }
+
+    if (index == (OMX_INDEXTYPE) OMX_TI_IndexConfigAlgEnable)
+    {
+        OMX_CONFIG_ALG_ENABLE *enable = param;
+        return g_strdup_printf ("%x:%lu:%lu", index,
+                                (gulong) enable->nPortIndex, (gulong) enable->nChId);
+    }
+
+    return g_strdup_printf ("%x:%lu", index,
+                            (gulong) ((MockParamHeader *) param)->nPortIndex);
+}
+
+/* Copy a structure without trusting the size of the destination to be
+ * right, some callers reuse structures of other types.
+ */
+static void
+copy_param (OMX_PTR dest,
+            gconstpointer src)
+{
+    OMX_U32 size;
+
+    size = ((MockParamHeader *) dest)->nSize;
+    memcpy (dest, src, MIN (size, ((const MockParamHeader *) src)->nSize));
+    ((MockParamHeader *) dest)->nSize = size;
+}
+
+static void
+post_event (MockComponent *comp,
+            OMX_EVENTTYPE event,
+            OMX_U32 data_1,
+            OMX_U32 data_2,
+            OMX_PTR data)
+{
+    if (!comp->callbacks.EventHandler)
+        return;
+
+    g_mutex_unlock (comp->mutex);
+    comp->callbacks.EventHandler (comp->handle, comp->app_data,
+                                  event, data_1, data_2, data);
+    g_mutex_lock (comp->mutex);
+}
+
+static void
+return_buffer (MockComponent *comp,
+               MockPort *port,
+               OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    if (is_input (comp, port))
+    {
+        omx_buffer->nFilledLen = 0;
+        omx_buffer->nOffset = 0;
+
+        if (comp->callbacks.EmptyBufferDone)
+            comp->callbacks.EmptyBufferDone (comp->handle, comp->app_data, omx_buffer);
+    }
+    else
+    {
+        if (comp->callbacks.FillBufferDone)
+            comp->callbacks.FillBufferDone (comp->handle, comp->app_data, omx_buffer);
+    }
+}
+
+static OMX_BUFFERHEADERTYPE *
+hold_buffer (const OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    OMX_BUFFERHEADERTYPE *copy;
+
+    copy = g_slice_new (OMX_BUFFERHEADERTYPE);
+    *copy = *omx_buffer;
+    copy->pBuffer = NULL;
+
+    if (omx_buffer->nFilledLen > 0)
+        copy->pBuffer = g_memdup (omx_buffer->pBuffer,
+                                  omx_buffer->nOffset + omx_buffer->nFilledLen);
+
+    return copy;
+}
+
+static void
+free_held (OMX_BUFFERHEADERTYPE *copy)
+{
+    g_free (copy->pBuffer);
+    g_slice_free (OMX_BUFFERHEADERTYPE, copy);
+}
+
+/* Give back every buffer queued on the port, as required when flushing,
+ * disabling the port or leaving the executing state.
+ */
+static void
+return_pending (MockComponent *comp,
+                MockPort *port)
+{
+    OMX_BUFFERHEADERTYPE *omx_buffer;
+
+    while ((omx_buffer = g_queue_pop_head (port->held)))
+        free_held (omx_buffer);
+
+    while ((omx_buffer = g_queue_pop_head (port->pending)))
+    {
+        if (!is_input (comp, port))
+            omx_buffer->nFilledLen = 0;
+
+        g_mutex_unlock (comp->mutex);
+        return_buffer (comp, port, omx_buffer);
+        g_mutex_lock (comp->mutex);
+    }
+}
+
+static gboolean
+ports_populated (MockComponent *comp)
+{
+    guint i;
+
+    for (i = 0; i < comp->num_ports; i++)
+    {
+        MockPort *port = &comp->ports[i];
+
+        if (port->def.bEnabled && !port->def.bPopulated)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+ports_empty (MockComponent *comp)
+{
+    guint i;
+
+    for (i = 0; i < comp->num_ports; i++)
+    {
+        if (comp->ports[i].populated > 0)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+transition_allowed (OMX_STATETYPE from,
+                    OMX_STATETYPE to)
+{
+    if (to == OMX_StateInvalid)
+        return TRUE;
+
+    switch (from)
+    {
+        case OMX_StateLoaded:
+            return to == OMX_StateIdle || to == OMX_StateWaitForResources;
+        case OMX_StateWaitForResources:
+            return to == OMX_StateLoaded || to == OMX_StateIdle;
+        case OMX_StateIdle:
+            return to == OMX_StateLoaded || to == OMX_StateExecuting ||
+                   to == OMX_StatePause;
+        case OMX_StateExecuting:
+            return to == OMX_StateIdle || to == OMX_StatePause;
+        case OMX_StatePause:
+            return to == OMX_StateIdle || to == OMX_StateExecuting;
+        default:
+            return FALSE;
+    }
+}
+
+/*
+ * Commands
+ *
+ * Commands run on the component thread, with the lock held.  They return
+ * FALSE while they have to wait for the client, ie. for buffers to be
+ * allocated, and are retried whenever something changes.
+ */
+
+static gboolean
+run_state_set (MockComponent *comp,
+               OMX_STATETYPE state)
+{
+    guint i;
+
+    if (state == comp->state)
+    {
+        post_event (comp, OMX_EventError, OMX_ErrorSameState, 0, NULL);
+        return TRUE;
+    }
+
+    if (!transition_allowed (comp->state, state))
+    {
+        post_event (comp, OMX_EventError, OMX_ErrorIncorrectStateTransition, 0, NULL);
+        return TRUE;
+    }
+
+    switch (state)
+    {
+        case OMX_StateIdle:
+            if (comp->state == OMX_StateLoaded ||
+                comp->state == OMX_StateWaitForResources)
+            {
+                if (!ports_populated (comp))
+                    return FALSE;
+            }
+            else
+            {
+                for (i = 0; i < comp->num_ports; i++)
+                    return_pending (comp, &comp->ports[i]);
+            }
+            break;
+        case OMX_StateLoaded:
+            if (!ports_empty (comp))
+                return FALSE;
+            break;
+        default:
+            break;
+    }
+
+    if (comp->state_delay)
+    {
+        g_mutex_unlock (comp->mutex);
+        g_usleep (comp->state_delay);
+        g_mutex_lock (comp->mutex);
+    }
+
+    comp->state = state;
+
+    /* the display driver instance goes, and its layouts with it */
+    if (state == OMX_StateLoaded)
+    {
+        comp->frames = 0;
+        comp->layouts = 0;
+        comp->layout = -1;
+    }
+
+    post_event (comp, OMX_EventCmdComplete, OMX_CommandStateSet, state, NULL);
+
+    return TRUE;
+}
+
+/* The ports a command addressed to index applies to, from first up to last;
+ * FALSE for an index the component has no port for.
+ */
+static gboolean
+get_port_range (MockComponent *comp,
+                OMX_U32 index,
+                guint *first,
+                guint *last)
+{
+    if (index == OMX_ALL)
+    {
+        *first = 0;
+        *last = comp->num_ports;
+        return TRUE;
+    }
+
+    if (!get_port (comp, index))
+        return FALSE;
+
+    *first = index;
+    *last = index + 1;
+    return TRUE;
+}
+
+static gboolean
+run_port_enable (MockComponent *comp,
+                 OMX_U32 index)
+{
+    guint first, last, i;
+
+    if (!get_port_range (comp, index, &first, &last))
+    {
+        post_event (comp, OMX_EventError, OMX_ErrorBadPortIndex, 0, NULL);
+        return TRUE;
+    }
+
+    /* the command is retried until all its ports are populated, so none of
+     * them is completed before that:
+     */
+    for (i = first; i < last; i++)
+    {
+        MockPort *port = &comp->ports[i];
+
+        port->def.bEnabled = OMX_TRUE;
+
+        if (comp->state != OMX_StateLoaded &&
+            comp->state != OMX_StateWaitForResources &&
+            !port->def.bPopulated)
+            return FALSE;
+    }
+
+    for (i = first; i < last; i++)
+        post_event (comp, OMX_EventCmdComplete, OMX_CommandPortEnable, i, NULL);
+
+    return TRUE;
+}
+
+static gboolean
+run_port_disable (MockComponent *comp,
+                  OMX_U32 index)
+{
+    guint first, last, i;
+
+    if (!get_port_range (comp, index, &first, &last))
+    {
+        post_event (comp, OMX_EventError, OMX_ErrorBadPortIndex, 0, NULL);
+        return TRUE;
+    }
+
+    for (i = first; i < last; i++)
+    {
+        MockPort *port = &comp->ports[i];
+
+        return_pending (comp, port);
+
+        if (port->populated > 0)
+            return FALSE;
+    }
+
+    for (i = first; i < last; i++)
+    {
+        MockPort *port = &comp->ports[i];
+
+        port->def.bEnabled = OMX_FALSE;
+        port->settings_changed = FALSE;
+
+        post_event (comp, OMX_EventCmdComplete, OMX_CommandPortDisable, i, NULL);
+    }
+
+    return TRUE;
+}
+
+static gboolean
+run_flush (MockComponent *comp,
+           OMX_U32 index)
+{
+    if (index == OMX_ALL)
+    {
+        guint i;
+
+        for (i = 0; i < comp->num_ports; i++)
+            return_pending (comp, &comp->ports[i]);
+    }
+    else
+    {
+        return_pending (comp, get_port (comp, index));
+    }
+
+    /* a flush of all the ports is completed with a single event, which is
+     * what GOmxCore waits for:
+     */
+    post_event (comp, OMX_EventCmdComplete, OMX_CommandFlush, index, NULL);
+
+    return TRUE;
+}
+
+static gboolean
+run_command (MockComponent *comp,
+             MockCommand *command)
+{
+    switch (command->cmd)
+    {
+        case OMX_CommandStateSet:
+            return run_state_set (comp, command->param);
+        case OMX_CommandPortEnable:
+            return run_port_enable (comp, command->param);
+        case OMX_CommandPortDisable:
+            return run_port_disable (comp, command->param);
+        case OMX_CommandFlush:
+            return run_flush (comp, command->param);
+        case OMX_CommandMarkBuffer:
+        default:
+            post_event (comp, OMX_EventCmdComplete, command->cmd, command->param, NULL);
+            return TRUE;
+    }
+}
+
+/*
+ * Processing
+ */
+
+static void
+process_buffers (MockComponent *comp,
+                 MockPort *in,
+                 MockPort *out)
+{
+    OMX_BUFFERHEADERTYPE *in_buffer = NULL;
+    OMX_BUFFERHEADERTYPE *out_buffer = NULL;
+    gboolean held = FALSE;
+    OMX_U32 flags = 0;
+    OMX_U32 index;
+
+    if (in)
+    {
+        held = !g_queue_is_empty (in->held);
+        in_buffer = g_queue_pop_head (held ? in->held : in->pending);
+        flags = in_buffer->nFlags;
+    }
+
+    if (out && !((flags & OMX_BUFFERFLAG_EOS) && comp->drop_eos))
+        out_buffer = g_queue_pop_head (out->pending);
+
+    index = out ? out->def.nPortIndex : in->def.nPortIndex;
+
+    g_mutex_unlock (comp->mutex);
+
+    if (comp->delay)
+        g_usleep (comp->delay);
+
+    if (out_buffer || !out)
+        comp->klass->process (comp, in, in_buffer, out, out_buffer);
+
+    if (out_buffer)
+        return_buffer (comp, out, out_buffer);
+
+    if (held)
+        free_held (in_buffer);
+    else if (in_buffer)
+        return_buffer (comp, in, in_buffer);
+
+    g_mutex_lock (comp->mutex);
+
+    if ((flags & OMX_BUFFERFLAG_EOS) && !comp->drop_eos)
+        post_event (comp, OMX_EventBufferFlag, index, flags, NULL);
+}
+
+/* With a pipeline depth, input buffers are copied and given back right
+ * away, and a frame only comes out once depth newer ones have been taken.
+ * Returns TRUE if it took one.
+ */
+static gboolean
+hold_input (MockComponent *comp,
+            MockPort *in)
+{
+    OMX_BUFFERHEADERTYPE *in_buffer;
+
+    if (g_queue_is_empty (in->pending) ||
+        g_queue_get_length (in->held) > comp->depth)
+        return FALSE;
+
+    in_buffer = g_queue_pop_head (in->pending);
+    g_queue_push_tail (in->held, hold_buffer (in_buffer));
+
+    g_mutex_unlock (comp->mutex);
+    return_buffer (comp, in, in_buffer);
+    g_mutex_lock (comp->mutex);
+
+    return TRUE;
+}
+
+/* Held frames come out once the pipeline is full, or all of them once the
+ * EOS flagged buffer went in.
+ */
+static gboolean
+held_ready (MockComponent *comp,
+            MockPort *in)
+{
+    OMX_BUFFERHEADERTYPE *last;
+
+    last = g_queue_peek_tail (in->held);
+    if (!last)
+        return FALSE;
+
+    return g_queue_get_length (in->held) > comp->depth ||
+           (last->nFlags & OMX_BUFFERFLAG_EOS);
+}
+
+/* Process one frame on the next channel which has buffers available, in a
+ * round-robin manner so that no channel starves the others.
+ */
+static gboolean
+process (MockComponent *comp)
+{
+    const MockClass *klass = comp->klass;
+    guint channels;
+    guint i;
+
+    if (!klass->process)
+        return FALSE;
+
+    channels = klass->num_in ? klass->num_in : klass->num_out;
+
+    for (i = 0; i < channels; i++)
+    {
+        guint channel = (comp->next_channel + i) % channels;
+        MockPort *in = NULL;
+        MockPort *out = NULL;
+
+        if (klass->num_in)
+        {
+            in = &comp->ports[klass->in_start + channel];
+            if (!in->def.bEnabled)
+                continue;
+        }
+
+        if (klass->num_out)
+        {
+            out = &comp->ports[klass->out_start + channel];
+            if (!out->def.bEnabled || out->settings_changed)
+                continue;
+        }
+
+        if (in && out && klass->settings && !g_queue_is_empty (in->pending) &&
+            !klass->settings (comp, in, g_queue_peek_head (in->pending), out))
+        {
+            /* the frames held from before the change come out first */
+            if (g_queue_is_empty (in->held) || g_queue_is_empty (out->pending))
+                continue;
+
+            comp->next_channel = channel + 1;
+            process_buffers (comp, in, out);
+
+            return TRUE;
+        }
+
+        if (in && out && comp->depth)
+        {
+            if (hold_input (comp, in))
+            {
+                comp->next_channel = channel + 1;
+                return TRUE;
+            }
+
+            if (!held_ready (comp, in))
+                continue;
+        }
+        else if (in && g_queue_is_empty (in->pending))
+        {
+            continue;
+        }
+
+        if (out && g_queue_is_empty (out->pending))
+            continue;
+
+        comp->next_channel = channel + 1;
+        process_buffers (comp, in, out);
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gpointer
+mock_thread (gpointer data)
+{
+    MockComponent *comp = data;
+
+    g_mutex_lock (comp->mutex);
+
+    while (!comp->quit)
+    {
+        MockCommand *command;
+
+        command = g_queue_peek_head (comp->commands);
+
+        if (command && run_command (comp, command))
+        {
+            g_queue_pop_head (comp->commands);
+            g_slice_free (MockCommand, command);
+            continue;
+        }
+
+        if (comp->state == OMX_StateExecuting && process (comp))
+            continue;
+
+        g_cond_wait (comp->cond, comp->mutex);
+    }
+
+    g_mutex_unlock (comp->mutex);
+
+    return NULL;
+}
+
+/*
+ * Frame helpers
+ */
+
+static void
+fill_frame (const OMX_VIDEO_PORTDEFINITIONTYPE *video,
+            OMX_U8 *data,
+            guint size,
+            guint8 luma)
+{
+    if (video->eColorFormat == OMX_COLOR_FormatYCbYCr)
+    {
+        guint i;
+
+        for (i = 0; i + 1 < size; i += 2)
+        {
+            data[i] = luma;
+            data[i + 1] = 0x80;
+        }
+    }
+    else
+    {
+        guint luma_size;
+
+        luma_size = MIN (size, frame_stride (video) * video->nFrameHeight);
+        memset (data, luma, luma_size);
+        memset (data + luma_size, 0x80, size - luma_size);
+    }
+}
+
+static inline void
+read_pixel (const OMX_VIDEO_PORTDEFINITIONTYPE *video,
+            const OMX_U8 *data,
+            guint x,
+            guint y,
+            guint8 *yuv)
+{
+    guint stride = frame_stride (video);
+
+    if (video->eColorFormat == OMX_COLOR_FormatYCbYCr)
+    {
+        const OMX_U8 *pair = data + y * stride + (x & ~1) * 2;
+
+        yuv[0] = pair[(x & 1) * 2];
+        yuv[1] = pair[1];
+        yuv[2] = pair[3];
+    }
+    else
+    {
+        const OMX_U8 *chroma = data + stride * video->nFrameHeight +
+                               (y / 2) * stride + (x & ~1);
+
+        yuv[0] = data[y * stride + x];
+        yuv[1] = chroma[0];
+        yuv[2] = chroma[1];
+    }
+}
+
+static inline void
+write_pixel (const OMX_VIDEO_PORTDEFINITIONTYPE *video,
+             OMX_U8 *data,
+             guint x,
+             guint y,
+             const guint8 *yuv)
+{
+    guint stride = frame_stride (video);
+
+    if (video->eColorFormat == OMX_COLOR_FormatYCbYCr)
+    {
+        OMX_U8 *pair = data + y * stride + (x & ~1) * 2;
+
+        pair[(x & 1) * 2] = yuv[0];
+        if (!(x & 1))
+        {
+            pair[1] = yuv[1];
+            pair[3] = yuv[2];
+        }
+    }
+    else
+    {
+        data[y * stride + x] = yuv[0];
+        if (!(x & 1) && !(y & 1))
+        {
+            OMX_U8 *chroma = data + stride * video->nFrameHeight +
+                             (y / 2) * stride + x;
+
+            chroma[0] = yuv[1];
+            chroma[1] = yuv[2];
+        }
+    }
+}
+
+static inline gboolean
+format_supported (const OMX_VIDEO_PORTDEFINITIONTYPE *video)
+{
+    return video->eColorFormat == OMX_COLOR_FormatYCbYCr ||
+           video->eColorFormat == OMX_COLOR_FormatYUV420SemiPlanar;
+}
+
+/* Nearest neighbour scaling and color conversion between NV12 and YUYV,
+ * sampling the crop window of the source.
+ */
+static void
+convert_frame (const OMX_VIDEO_PORTDEFINITIONTYPE *src_video,
+               const OMX_U8 *src,
+               guint crop_x,
+               guint crop_y,
+               guint crop_width,
+               guint crop_height,
+               const OMX_VIDEO_PORTDEFINITIONTYPE *dest_video,
+               OMX_U8 *dest)
+{
+    guint x, y;
+
+    for (y = 0; y < dest_video->nFrameHeight; y++)
+    {
+        guint src_y = crop_y + y * crop_height / dest_video->nFrameHeight;
+
+        for (x = 0; x < dest_video->nFrameWidth; x++)
+        {
+            guint src_x = crop_x + x * crop_width / dest_video->nFrameWidth;
+            guint8 yuv[3];
+
+            read_pixel (src_video, src, src_x, src_y, yuv);
+            write_pixel (dest_video, dest, x, y, yuv);
+        }
+    }
+}
+
+/*
+ * Component specific processing, these run on the component thread
+ * without the lock held.
+ */
+
+static void
+viddec_process (MockComponent *comp,
+                MockPort *in,
+                OMX_BUFFERHEADERTYPE *in_buffer,
+                MockPort *out,
+                OMX_BUFFERHEADERTYPE *out_buffer)
+{
+    out_buffer->nOffset = 0;
+    out_buffer->nFilledLen = 0;
+    out_buffer->nTimeStamp = in_buffer->nTimeStamp;
+    out_buffer->nFlags = in_buffer->nFlags;
+
+    if (in_buffer->nFilledLen > 0 && out_buffer->pBuffer)
+    {
+        guint size;
+
+        size = MIN (frame_size (&out->def.format.video), out_buffer->nAllocLen);
+        fill_frame (&out->def.format.video, out_buffer->pBuffer, size,
+                    16 + comp->frames % 220);
+        out_buffer->nFilledLen = size;
+        comp->frames++;
+    }
+}
+
+/* Reads H.264 syntax elements out of a NAL unit, emulation prevention
+ * bytes removed.
+ */
+typedef struct
+{
+    const OMX_U8 *data;
+    guint size;
+    guint pos;      /* in bits */
+    guint zeros;    /* zero bytes in a row so far */
+    gboolean error;
+} BitReader;
+
+static guint
+read_bit (BitReader *reader)
+{
+    guint byte = reader->pos / 8;
+    guint bit;
+
+    if (byte >= reader->size)
+    {
+        reader->error = TRUE;
+        return 0;
+    }
+
+    /* skip the 0x03 of a 0x000003 sequence on entering it */
+    if (reader->pos % 8 == 0)
+    {
+        if (reader->zeros >= 2 && reader->data[byte] == 0x03)
+        {
+            reader->pos += 8;
+            reader->zeros = 0;
+            return read_bit (reader);
+        }
+
+        reader->zeros = reader->data[byte] ? 0 : reader->zeros + 1;
+    }
+
+    bit = (reader->data[byte] >> (7 - reader->pos % 8)) & 1;
+    reader->pos++;
+
+    return bit;
+}
+
+static guint
+read_bits (BitReader *reader,
+           guint n)
+{
+    guint value = 0;
+
+    while (n--)
+        value = (value << 1) | read_bit (reader);
+
+    return value;
+}
+
+static guint
+read_ue (BitReader *reader)
+{
+    guint zeros = 0;
+
+    while (!read_bit (reader) && !reader->error)
+    {
+        if (++zeros > 31)
+        {
+            reader->error = TRUE;
+            return 0;
+        }
+    }
+
+    return (1u << zeros) - 1 + read_bits (reader, zeros);
+}
+
+static gint
+read_se (BitReader *reader)
+{
+    guint value = read_ue (reader);
+
+    return (value & 1) ? (gint) (value + 1) / 2 : -(gint) (value / 2);
+}
+
+/* Picture size coded in a sequence parameter set, without the NAL header */
+static gboolean
+parse_sps_size (const OMX_U8 *data,
+                guint size,
+                guint *width,
+                guint *height)
+{
+    BitReader reader = { data, size, 0, 0, FALSE };
+    guint profile_idc;
+    guint width_mbs, height_map_units, frame_mbs_only;
+    guint crop_left = 0, crop_right = 0, crop_top = 0, crop_bottom = 0;
+    guint i, n;
+
+    profile_idc = read_bits (&reader, 8);
+    read_bits (&reader, 16);                /* constraint flags, level_idc */
+    read_ue (&reader);                      /* seq_parameter_set_id */
+
+    if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 ||
+        profile_idc == 244 || profile_idc == 44 || profile_idc == 83 ||
+        profile_idc == 86 || profile_idc == 118 || profile_idc == 128)
+    {
+        if (read_ue (&reader) == 3)         /* chroma_format_idc */
+            read_bit (&reader);
+        read_ue (&reader);                  /* bit_depth_luma_minus8 */
+        read_ue (&reader);                  /* bit_depth_chroma_minus8 */
+        read_bit (&reader);
+        if (read_bit (&reader))             /* scaling matrices: not needed */
+            return FALSE;
+    }
+
+    read_ue (&reader);                      /* log2_max_frame_num_minus4 */
+
+    switch (read_ue (&reader))              /* pic_order_cnt_type */
+    {
+        case 0:
+            read_ue (&reader);
+            break;
+        case 1:
+            read_bit (&reader);
+            read_se (&reader);
+            read_se (&reader);
+            n = read_ue (&reader);
+            for (i = 0; i < n && !reader.error; i++)
+                read_se (&reader);
+            break;
+        default:
+            break;
+    }
+
+    read_ue (&reader);                      /* max_num_ref_frames */
+    read_bit (&reader);
+    width_mbs = read_ue (&reader) + 1;
+    height_map_units = read_ue (&reader) + 1;
+    frame_mbs_only = read_bit (&reader);
+
+    if (!frame_mbs_only)
+        read_bit (&reader);
+    read_bit (&reader);                     /* direct_8x8_inference_flag */
+
+    if (read_bit (&reader))                 /* frame_cropping_flag */
+    {
+        crop_left = read_ue (&reader);
+        crop_right = read_ue (&reader);
+        crop_top = read_ue (&reader);
+        crop_bottom = read_ue (&reader);
+    }
+
+    if (reader.error)
+        return FALSE;
+
+    /* 4:2:0 only, where the crop is in units of two lines or columns */
+    *width = width_mbs * 16 - 2 * (crop_left + crop_right);
+    *height = (2 - frame_mbs_only) * (height_map_units * 16 -
+                                      2 * (crop_top + crop_bottom));
+
+    return TRUE;
+}
+
+static gboolean
+viddec_settings (MockComponent *comp,
+                 MockPort *in,
+                 OMX_BUFFERHEADERTYPE *in_buffer,
+                 MockPort *out)
+{
+    OMX_VIDEO_PORTDEFINITIONTYPE *video = &out->def.format.video;
+    const OMX_U8 *data;
+    guint width, height;
+    guint i;
+
+    data = in_buffer->pBuffer + in_buffer->nOffset;
+
+    for (i = 0; i + 4 < in_buffer->nFilledLen; i++)
+    {
+        if (data[i] != 0x00 || data[i + 1] != 0x00 || data[i + 2] != 0x01 ||
+            (data[i + 3] & 0x1f) != 7)
+            continue;
+
+        if (!parse_sps_size (data + i + 4, in_buffer->nFilledLen - i - 4,
+                             &width, &height))
+            continue;
+
+        if (width == video->nFrameWidth && height == video->nFrameHeight)
+            continue;
+
+        if (!g_queue_is_empty (in->held))
+            return FALSE;
+
+        video->nFrameWidth = width;
+        video->nFrameHeight = height;
+        video->nStride = 0;
+        out->def.nBufferSize = 0;
+        update_buffer_size (out);
+
+        out->settings_changed = TRUE;
+        post_event (comp, OMX_EventPortSettingsChanged, out->def.nPortIndex, 0, NULL);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+videnc_process (MockComponent *comp,
+                MockPort *in,
+                OMX_BUFFERHEADERTYPE *in_buffer,
+                MockPort *out,
+                OMX_BUFFERHEADERTYPE *out_buffer)
+{
+    static const OMX_U8 headers[] = {
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x28,
+        0xe9, 0x00, 0xf0, 0x04, 0x4b, 0x20,
+        0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80
+    };
+    OMX_U8 *data;
+    gboolean intra;
+    guint period;
+    guint size;
+    guint len = 0;
+
+    out_buffer->nOffset = 0;
+    out_buffer->nFilledLen = 0;
+    out_buffer->nTimeStamp = in_buffer->nTimeStamp;
+    out_buffer->nFlags = in_buffer->nFlags;
+
+    if (in_buffer->nFilledLen == 0 || !out_buffer->pBuffer)
+        return;
+
+    period = g_atomic_int_get (&comp->p_frames) + 1;
+    intra = (comp->frames % period == 0);
+
+    if (g_atomic_pointer_compare_and_exchange (&comp->intra_buffer, in_buffer, NULL))
+        intra = TRUE;
+
+    /* headers, start code and NAL unit header, then the slice payload: */
+    size = MAX (in_buffer->nFilledLen / 32, 16);
+    if ((intra ? sizeof (headers) : 0) + 5 + size > out_buffer->nAllocLen)
+        return;
+
+    data = out_buffer->pBuffer;
+
+    if (intra)
+    {
+        memcpy (data, headers, sizeof (headers));
+        len = sizeof (headers);
+    }
+
+    data[len++] = 0x00;
+    data[len++] = 0x00;
+    data[len++] = 0x00;
+    data[len++] = 0x01;
+    data[len++] = intra ? 0x65 : 0x41;
+
+    /* the payload avoids any start code emulation: */
+    memset (data + len, 0xa5, size);
+    len += size;
+
+    out_buffer->nFilledLen = len;
+    out_buffer->nFlags |= OMX_BUFFERFLAG_ENDOFFRAME;
+    if (intra)
+        out_buffer->nFlags |= OMX_BUFFERFLAG_SYNCFRAME;
+
+    comp->frames++;
+}
+
+static void
+vfpc_process (MockComponent *comp,
+              MockPort *in,
+              OMX_BUFFERHEADERTYPE *in_buffer,
+              MockPort *out,
+              OMX_BUFFERHEADERTYPE *out_buffer)
+{
+    const OMX_VIDEO_PORTDEFINITIONTYPE *src_video = &in->def.format.video;
+    const OMX_VIDEO_PORTDEFINITIONTYPE *dest_video = &out->def.format.video;
+    guint crop_x = 0, crop_y = 0;
+    guint crop_width = src_video->nFrameWidth;
+    guint crop_height = src_video->nFrameHeight;
+    guint size;
+
+    out_buffer->nOffset = 0;
+    out_buffer->nFilledLen = 0;
+    out_buffer->nTimeStamp = in_buffer->nTimeStamp;
+    out_buffer->nFlags = in_buffer->nFlags;
+
+    if (in_buffer->nFilledLen == 0 || !in_buffer->pBuffer || !out_buffer->pBuffer)
+        return;
+
+    /* honour the crop window of the input channel: */
+    {
+        OMX_CONFIG_VIDCHANNEL_RESOLUTION key;
+        OMX_CONFIG_VIDCHANNEL_RESOLUTION *resolution;
+        gchar *name;
+
+        key.eDir = OMX_DirInput;
+        key.nChId = in->def.nPortIndex - comp->klass->in_start;
+        name = param_key (OMX_TI_IndexConfigVidChResolution, &key);
+
+        g_mutex_lock (comp->mutex);
+        resolution = g_hash_table_lookup (comp->params, name);
+        if (resolution && resolution->FrmCropWidth && resolution->FrmCropHeight)
+        {
+            crop_x = resolution->FrmStartX;
+            crop_y = resolution->FrmStartY;
+            crop_width = resolution->FrmCropWidth;
+            crop_height = resolution->FrmCropHeight;
+        }
+        g_mutex_unlock (comp->mutex);
+
+        g_free (name);
+    }
+
+    size = frame_size (dest_video);
+
+    if (format_supported (src_video) && format_supported (dest_video) &&
+        in_buffer->nFilledLen >= frame_size (src_video) &&
+        out_buffer->nAllocLen >= size &&
+        crop_x + crop_width <= src_video->nFrameWidth &&
+        crop_y + crop_height <= src_video->nFrameHeight &&
+        dest_video->nFrameWidth > 0 && dest_video->nFrameHeight > 0)
+    {
+        convert_frame (src_video, in_buffer->pBuffer + in_buffer->nOffset,
+                       crop_x, crop_y, crop_width, crop_height,
+                       dest_video, out_buffer->pBuffer);
+    }
+    else
+    {
+        size = MIN (in_buffer->nFilledLen, out_buffer->nAllocLen);
+        memcpy (out_buffer->pBuffer, in_buffer->pBuffer + in_buffer->nOffset, size);
+    }
+
+    out_buffer->nFilledLen = size;
+    comp->frames++;
+}
+
+static void
+vfdc_process (MockComponent *comp,
+              MockPort *in,
+              OMX_BUFFERHEADERTYPE *in_buffer,
+              MockPort *out,
+              OMX_BUFFERHEADERTYPE *out_buffer)
+{
+    /* the frame is on screen until the next vsync, nothing else to do */
+    comp->frames++;
+}
+
+static void
+vfcc_process (MockComponent *comp,
+              MockPort *in,
+              OMX_BUFFERHEADERTYPE *in_buffer,
+              MockPort *out,
+              OMX_BUFFERHEADERTYPE *out_buffer)
+{
+    const OMX_VIDEO_PORTDEFINITIONTYPE *video = &out->def.format.video;
+    guint framerate;
+    guint size;
+
+    framerate = video->xFramerate >> 16;
+    if (!framerate)
+        framerate = MOCK_FRAMERATE;
+
+    out_buffer->nOffset = 0;
+    out_buffer->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+    out_buffer->nTimeStamp = (OMX_TICKS) comp->frames * 1000000 / framerate;
+    out_buffer->nFilledLen = 0;
+
+    if (out_buffer->pBuffer)
+    {
+        size = MIN (frame_size (video), out_buffer->nAllocLen);
+        fill_frame (video, out_buffer->pBuffer, size, 16 + comp->frames % 220);
+        out_buffer->nFilledLen = size;
+    }
+
+    comp->frames++;
+}
+
+/*
+ * Component methods
+ */
+
+#define GET_COMPONENT(handle) \
+        ((MockComponent *) ((OMX_COMPONENTTYPE *) (handle))->pComponentPrivate)
+
+static OMX_ERRORTYPE
+comp_GetComponentVersion (OMX_HANDLETYPE handle,
+                          OMX_STRING name,
+                          OMX_VERSIONTYPE *component_version,
+                          OMX_VERSIONTYPE *spec_version,
+                          OMX_UUIDTYPE *uuid)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+
+    g_strlcpy (name, comp->klass->name, OMX_MAX_STRINGNAME_SIZE);
+    component_version->nVersion = 0;
+    component_version->s.nVersionMajor = 1;
+    spec_version->nVersion = 0;
+    spec_version->s.nVersionMajor = 1;
+    spec_version->s.nVersionMinor = 1;
+    memset (uuid, 0, sizeof (OMX_UUIDTYPE));
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+comp_SendCommand (OMX_HANDLETYPE handle,
+                  OMX_COMMANDTYPE cmd,
+                  OMX_U32 param,
+                  OMX_PTR data)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+    guint first, count, i;
+
+    if (cmd == OMX_CommandPortEnable || cmd == OMX_CommandPortDisable ||
+        cmd == OMX_CommandFlush)
+    {
+        if (param != OMX_ALL && param >= comp->num_ports)
+            return OMX_ErrorBadPortIndex;
+    }
+
+    if (comp->state == OMX_StateInvalid)
+        return OMX_ErrorInvalidState;
+
+    /* enabling or disabling all the ports is completed port by port: */
+    if (param == OMX_ALL &&
+        (cmd == OMX_CommandPortEnable || cmd == OMX_CommandPortDisable))
+    {
+        first = 0;
+        count = comp->num_ports;
+    }
+    else
+    {
+        first = param;
+        count = 1;
+    }
+
+    g_mutex_lock (comp->mutex);
+
+    for (i = 0; i < count; i++)
+    {
+        MockCommand *command;
+
+        command = g_slice_new (MockCommand);
+        command->cmd = cmd;
+        command->param = first + i;
+        command->data = data;
+
+        g_queue_push_tail (comp->commands, command);
+    }
+
+    g_cond_signal (comp->cond);
+    g_mutex_unlock (comp->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+get_port_definition (MockComponent *comp,
+                     OMX_PARAM_PORTDEFINITIONTYPE *param)
+{
+    MockPort *port;
+
+    port = get_port (comp, param->nPortIndex);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    copy_param (param, &port->def);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+set_port_definition (MockComponent *comp,
+                     OMX_PARAM_PORTDEFINITIONTYPE *param)
+{
+    MockPort *port;
+
+    port = get_port (comp, param->nPortIndex);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    if (comp->state != OMX_StateLoaded && port->def.bEnabled)
+        return OMX_ErrorIncorrectStateOperation;
+
+    if (param->nBufferCountActual < port->def.nBufferCountMin)
+        return OMX_ErrorBadParameter;
+
+    port->def.nBufferCountActual = param->nBufferCountActual;
+    port->def.nBufferSize = param->nBufferSize;
+    port->def.format.video = param->format.video;
+    update_buffer_size (port);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+get_video_port_format (MockComponent *comp,
+                       OMX_VIDEO_PARAM_PORTFORMATTYPE *param)
+{
+    MockPort *port;
+
+    port = get_port (comp, param->nPortIndex);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    param->nIndex = 0;
+    param->eCompressionFormat = port->def.format.video.eCompressionFormat;
+    param->eColorFormat = port->def.format.video.eColorFormat;
+    param->xFramerate = port->def.format.video.xFramerate;
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+set_video_port_format (MockComponent *comp,
+                       OMX_VIDEO_PARAM_PORTFORMATTYPE *param)
+{
+    MockPort *port;
+    OMX_VIDEO_PORTDEFINITIONTYPE *video;
+
+    port = get_port (comp, param->nPortIndex);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    if (comp->state != OMX_StateLoaded && port->def.bEnabled)
+        return OMX_ErrorIncorrectStateOperation;
+
+    video = &port->def.format.video;
+
+    if (video->eCompressionFormat != OMX_VIDEO_CodingUnused)
+    {
+        if (param->eCompressionFormat != video->eCompressionFormat)
+            return OMX_ErrorUnsupportedSetting;
+        return OMX_ErrorNone;
+    }
+
+    if (param->eColorFormat != OMX_COLOR_FormatYUV420SemiPlanar &&
+        param->eColorFormat != OMX_COLOR_FormatYCbYCr)
+        return OMX_ErrorUnsupportedSetting;
+
+    video->eColorFormat = param->eColorFormat;
+    update_buffer_size (port);
+
+    return OMX_ErrorNone;
+}
+
+/* Like the display driver, only a few layouts can exist at once; the id of
+ * the one created is passed back in the structure.
+ */
+static OMX_ERRORTYPE
+create_layout (MockComponent *comp,
+               OMX_PARAM_VFDC_CREATEMOSAICLAYOUT *layout)
+{
+    guint i;
+
+    if (layout->nNumWindows == 0 || layout->nNumWindows > MOCK_VFDC_NUM_PORTS)
+        return OMX_ErrorBadParameter;
+
+    for (i = 0; i < MOCK_VFDC_MAX_LAYOUTS; i++)
+    {
+        if (!(comp->layouts & (1 << i)))
+        {
+            comp->layouts |= 1 << i;
+            layout->nLayoutId = i;
+            return OMX_ErrorNone;
+        }
+    }
+
+    return OMX_ErrorInsufficientResources;
+}
+
+static OMX_ERRORTYPE
+delete_layout (MockComponent *comp,
+               OMX_PARAM_VFDC_DELETEMOSAICLAYOUT *layout)
+{
+    if (layout->nLayoutId >= MOCK_VFDC_MAX_LAYOUTS ||
+        !(comp->layouts & (1 << layout->nLayoutId)))
+        return OMX_ErrorBadParameter;
+
+    /* the one shown can't go */
+    if ((gint) layout->nLayoutId == comp->layout)
+        return OMX_ErrorIncorrectStateOperation;
+
+    comp->layouts &= ~(1 << layout->nLayoutId);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+get_param (MockComponent *comp,
+           OMX_INDEXTYPE index,
+           OMX_PTR param)
+{
+    gpointer value;
+    gchar *key;
+
+    if (!index_supported (comp, index))
+        return OMX_ErrorUnsupportedIndex;
+
+    switch (index)
+    {
+        case OMX_IndexParamPortDefinition:
+            return get_port_definition (comp, param);
+        case OMX_IndexParamVideoPortFormat:
+            return get_video_port_format (comp, param);
+        case OMX_IndexParamStandardComponentRole:
+            {
+                OMX_PARAM_COMPONENTROLETYPE *role = param;
+                g_strlcpy ((gchar *) role->cRole, comp->role, OMX_MAX_STRINGNAME_SIZE);
+                return OMX_ErrorNone;
+            }
+        default:
+            break;
+    }
+
+    key = param_key (index, param);
+    value = g_hash_table_lookup (comp->params, key);
+    g_free (key);
+
+    /* not set yet, the caller initialized the structure: */
+    if (value)
+        copy_param (param, value);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+set_param (MockComponent *comp,
+           OMX_INDEXTYPE index,
+           OMX_PTR param)
+{
+    if (!index_supported (comp, index))
+        return OMX_ErrorUnsupportedIndex;
+
+    if (index == (OMX_INDEXTYPE) OMX_TI_IndexParamVFPCNumChPerHandle)
+    {
+        OMX_PARAM_VFPC_NUMCHANNELPERHANDLE *channels = param;
+        if (channels->nNumChannelsPerHandle == 0 ||
+            channels->nNumChannelsPerHandle > comp->klass->num_in)
+            return OMX_ErrorBadParameter;
+    }
+
+    if (index == (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCCreateMosaicLayout)
+        return create_layout (comp, param);
+
+    if (index == (OMX_INDEXTYPE) OMX_TI_IndexParamVFDCDeleteMosaicLayout)
+        return delete_layout (comp, param);
+
+    if (index == (OMX_INDEXTYPE) OMX_TI_IndexConfigVFDCMosaicPort2WinMap)
+    {
+        OMX_CONFIG_VFDC_MOSAICLAYOUT_PORT2WINMAP *map = param;
+        if (map->nLayoutId >= MOCK_VFDC_MAX_LAYOUTS ||
+            !(comp->layouts & (1 << map->nLayoutId)))
+            return OMX_ErrorBadParameter;
+        comp->layout = map->nLayoutId;
+    }
+
+    switch (index)
+    {
+        case OMX_IndexParamPortDefinition:
+            return set_port_definition (comp, param);
+        case OMX_IndexParamVideoPortFormat:
+            return set_video_port_format (comp, param);
+        case OMX_IndexParamStandardComponentRole:
+            {
+                OMX_PARAM_COMPONENTROLETYPE *role = param;
+                g_strlcpy (comp->role, (gchar *) role->cRole, OMX_MAX_STRINGNAME_SIZE);
+                return OMX_ErrorNone;
+            }
+        case OMX_IndexConfigVideoAVCIntraPeriod:
+            {
+                OMX_VIDEO_CONFIG_AVCINTRAPERIOD *period = param;
+                g_atomic_int_set (&comp->p_frames, period->nPFrames);
+                break;
+            }
+        case OMX_IndexConfigVideoIntraVOPRefresh:
+            {
+                OMX_CONFIG_INTRAREFRESHVOPTYPE *refresh = param;
+                if (refresh->IntraRefreshVOP)
+                    g_atomic_int_set (&comp->force_intra, TRUE);
+                /* a one-shot request, nothing to remember */
+                return OMX_ErrorNone;
+            }
+        default:
+            break;
+    }
+
+    g_hash_table_replace (comp->params, param_key (index, param),
+                          g_memdup (param, ((MockParamHeader *) param)->nSize));
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+comp_GetParameter (OMX_HANDLETYPE handle,
+                   OMX_INDEXTYPE index,
+                   OMX_PTR param)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+    OMX_ERRORTYPE err;
+
+    if (!param)
+        return OMX_ErrorBadParameter;
+
+    g_mutex_lock (comp->mutex);
+    err = get_param (comp, index, param);
+    g_mutex_unlock (comp->mutex);
+
+    return err;
+}
+
+static OMX_ERRORTYPE
+comp_SetParameter (OMX_HANDLETYPE handle,
+                   OMX_INDEXTYPE index,
+                   OMX_PTR param)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+    OMX_ERRORTYPE err;
+
+    if (!param)
+        return OMX_ErrorBadParameter;
+
+    g_mutex_lock (comp->mutex);
+    err = set_param (comp, index, param);
+    g_mutex_unlock (comp->mutex);
+
+    return err;
+}
+
+static OMX_ERRORTYPE
+comp_GetExtensionIndex (OMX_HANDLETYPE handle,
+                        OMX_STRING name,
+                        OMX_INDEXTYPE *index)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+
+    if (!strcmp (name, "OMX.TI.VideoEncode.Config.NALFormat") &&
+        index_supported (comp, MOCK_INDEX_NAL_FORMAT))
+    {
+        *index = MOCK_INDEX_NAL_FORMAT;
+        return OMX_ErrorNone;
+    }
+
+    return OMX_ErrorUnsupportedIndex;
+}
+
+static OMX_ERRORTYPE
+comp_GetState (OMX_HANDLETYPE handle,
+               OMX_STATETYPE *state)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+
+    g_mutex_lock (comp->mutex);
+    *state = comp->state;
+    g_mutex_unlock (comp->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+add_buffer (MockComponent *comp,
+            OMX_BUFFERHEADERTYPE **buffer_header,
+            OMX_U32 index,
+            OMX_PTR app_private,
+            OMX_U32 size,
+            OMX_U8 *data,
+            gboolean allocate)
+{
+    OMX_BUFFERHEADERTYPE *omx_buffer;
+    MockPort *port;
+
+    port = get_port (comp, index);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    omx_buffer = g_new0 (OMX_BUFFERHEADERTYPE, 1);
+    omx_buffer->nSize = sizeof (OMX_BUFFERHEADERTYPE);
+    omx_buffer->nVersion.s.nVersionMajor = 1;
+    omx_buffer->nVersion.s.nVersionMinor = 1;
+    omx_buffer->pBuffer = allocate ? g_malloc0 (size) : data;
+    omx_buffer->nAllocLen = size;
+    omx_buffer->pAppPrivate = app_private;
+    /* remember who owns the memory: */
+    omx_buffer->pPlatformPrivate = GINT_TO_POINTER (allocate);
+
+    if (is_input (comp, port))
+    {
+        omx_buffer->nInputPortIndex = index;
+        omx_buffer->nOutputPortIndex = MOCK_NO_PORT;
+    }
+    else
+    {
+        omx_buffer->nInputPortIndex = MOCK_NO_PORT;
+        omx_buffer->nOutputPortIndex = index;
+    }
+
+    g_mutex_lock (comp->mutex);
+
+    port->populated++;
+    port->def.bPopulated = (port->populated >= port->def.nBufferCountActual);
+
+    g_cond_signal (comp->cond);
+    g_mutex_unlock (comp->mutex);
+
+    *buffer_header = omx_buffer;
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+comp_UseBuffer (OMX_HANDLETYPE handle,
+                OMX_BUFFERHEADERTYPE **buffer_header,
+                OMX_U32 index,
+                OMX_PTR app_private,
+                OMX_U32 size,
+                OMX_U8 *data)
+{
+    return add_buffer (GET_COMPONENT (handle), buffer_header, index,
+                       app_private, size, data, FALSE);
+}
+
+static OMX_ERRORTYPE
+comp_AllocateBuffer (OMX_HANDLETYPE handle,
+                     OMX_BUFFERHEADERTYPE **buffer_header,
+                     OMX_U32 index,
+                     OMX_PTR app_private,
+                     OMX_U32 size)
+{
+    return add_buffer (GET_COMPONENT (handle), buffer_header, index,
+                       app_private, size, NULL, TRUE);
+}
+
+static OMX_ERRORTYPE
+comp_FreeBuffer (OMX_HANDLETYPE handle,
+                 OMX_U32 index,
+                 OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+    MockPort *port;
+
+    port = get_port (comp, index);
+    if (!port)
+        return OMX_ErrorBadPortIndex;
+
+    g_mutex_lock (comp->mutex);
+
+    if (port->populated == 0)
+    {
+        g_mutex_unlock (comp->mutex);
+        return OMX_ErrorBadParameter;
+    }
+
+    port->populated--;
+    port->def.bPopulated = OMX_FALSE;
+
+    g_cond_signal (comp->cond);
+    g_mutex_unlock (comp->mutex);
+
+    if (omx_buffer->pPlatformPrivate)
+        g_free (omx_buffer->pBuffer);
+    g_free (omx_buffer);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+queue_buffer (MockComponent *comp,
+              OMX_BUFFERHEADERTYPE *omx_buffer,
+              OMX_U32 index,
+              OMX_DIRTYPE dir)
+{
+    MockPort *port;
+
+    port = get_port (comp, index);
+    if (!port || port->def.eDir != dir)
+        return OMX_ErrorBadPortIndex;
+
+    g_mutex_lock (comp->mutex);
+
+    if (comp->state != OMX_StateExecuting && comp->state != OMX_StatePause &&
+        comp->state != OMX_StateIdle)
+    {
+        g_mutex_unlock (comp->mutex);
+        return OMX_ErrorIncorrectStateOperation;
+    }
+
+    /* like on the real encoder, an intra refresh applies to the next frame
+     * handed over, not to the one being processed when it is asked for */
+    if (dir == OMX_DirInput && omx_buffer->nFilledLen > 0)
+    {
+        if (g_atomic_int_compare_and_exchange (&comp->force_intra, TRUE, FALSE))
+            g_atomic_pointer_set (&comp->intra_buffer, omx_buffer);
+        else
+            g_atomic_pointer_compare_and_exchange (&comp->intra_buffer, omx_buffer, NULL);
+    }
+
+    g_queue_push_tail (port->pending, omx_buffer);
+
+    g_cond_signal (comp->cond);
+    g_mutex_unlock (comp->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE
+comp_EmptyThisBuffer (OMX_HANDLETYPE handle,
+                      OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    return queue_buffer (GET_COMPONENT (handle), omx_buffer,
+                         omx_buffer->nInputPortIndex, OMX_DirInput);
+}
+
+static OMX_ERRORTYPE
+comp_FillThisBuffer (OMX_HANDLETYPE handle,
+                     OMX_BUFFERHEADERTYPE *omx_buffer)
+{
+    return queue_buffer (GET_COMPONENT (handle), omx_buffer,
+                         omx_buffer->nOutputPortIndex, OMX_DirOutput);
+}
+
+static OMX_ERRORTYPE
+comp_SetCallbacks (OMX_HANDLETYPE handle,
+                   OMX_CALLBACKTYPE *callbacks,
+                   OMX_PTR app_data)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+
+    g_mutex_lock (comp->mutex);
+
+    if (callbacks)
+        comp->callbacks = *callbacks;
+    else
+        memset (&comp->callbacks, 0, sizeof (comp->callbacks));
+    comp->app_data = app_data;
+
+    g_mutex_unlock (comp->mutex);
+
+    return OMX_ErrorNone;
+}
+
+/*
+ * Construction
+ */
+
+static void
+init_port (MockComponent *comp,
+           guint index,
+           OMX_DIRTYPE dir,
+           OMX_VIDEO_CODINGTYPE coding,
+           OMX_COLOR_FORMATTYPE color,
+           guint buffers)
+{
+    MockPort *port = &comp->ports[index];
+    OMX_PARAM_PORTDEFINITIONTYPE *def = &port->def;
+
+    def->nSize = sizeof (OMX_PARAM_PORTDEFINITIONTYPE);
+    def->nVersion.s.nVersionMajor = 1;
+    def->nVersion.s.nVersionMinor = 1;
+    def->nPortIndex = index;
+    def->eDir = dir;
+    def->nBufferCountActual = buffers;
+    def->nBufferCountMin = MAX (buffers / 2, 1);
+    def->bEnabled = comp->klass->enabled;
+    def->bPopulated = OMX_FALSE;
+    def->eDomain = OMX_PortDomainVideo;
+    def->format.video.nFrameWidth = 1920;
+    def->format.video.nFrameHeight = 1080;
+    def->format.video.xFramerate = MOCK_FRAMERATE << 16;
+    def->format.video.eCompressionFormat = coding;
+    def->format.video.eColorFormat = color;
+
+    if (coding != OMX_VIDEO_CodingUnused)
+        def->nBufferSize = 1920 * 1080 / 2;
+
+    update_buffer_size (port);
+
+    port->pending = g_queue_new ();
+    port->held = g_queue_new ();
+}
+
+static OMX_ERRORTYPE
+comp_ComponentDeInit (OMX_HANDLETYPE handle)
+{
+    MockComponent *comp = GET_COMPONENT (handle);
+    MockCommand *command;
+    guint i;
+
+    g_mutex_lock (comp->mutex);
+    comp->quit = TRUE;
+    g_cond_signal (comp->cond);
+    g_mutex_unlock (comp->mutex);
+
+    g_thread_join (comp->thread);
+
+    while ((command = g_queue_pop_head (comp->commands)))
+        g_slice_free (MockCommand, command);
+    g_queue_free (comp->commands);
+
+    for (i = 0; i < comp->num_ports; i++)
+    {
+        OMX_BUFFERHEADERTYPE *omx_buffer;
+
+        while ((omx_buffer = g_queue_pop_head (comp->ports[i].held)))
+            free_held (omx_buffer);
+
+        g_queue_free (comp->ports[i].pending);
+        g_queue_free (comp->ports[i].held);
+    }
+
+    g_hash_table_destroy (comp->params);
+    g_cond_free (comp->cond);
+    g_mutex_free (comp->mutex);
+    g_free (comp);
+
+    return OMX_ErrorNone;
+}
+
+static gulong
+get_setting (const MockClass *klass,
+             const gchar *setting)
+{
+    const gchar *value;
+    gchar *name;
+
+    name = g_strdup_printf ("%s_%s", setting, strrchr (klass->name, '.') + 1);
+    value = g_getenv (name);
+    g_free (name);
+
+    if (!value)
+        value = g_getenv (setting);
+
+    return value ? atol (value) : 0;
+}
+
+OMX_ERRORTYPE
+OMX_Init (void)
+{
+    if (!g_thread_supported ())
+    {
+        g_thread_init (NULL);
+    }
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+OMX_Deinit (void)
+{
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+OMX_ComponentNameEnum (OMX_STRING name,
+                       OMX_U32 length,
+                       OMX_U32 index)
+{
+    if (index >= G_N_ELEMENTS (mock_classes) - 1)
+        return OMX_ErrorNoMore;
+
+    g_strlcpy (name, mock_classes[index].name, length);
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+OMX_GetHandle (OMX_HANDLETYPE *handle,
+               OMX_STRING component_name,
+               OMX_PTR app_data,
+               OMX_CALLBACKTYPE *callbacks)
+{
+    const MockClass *klass;
+    OMX_COMPONENTTYPE *omx_comp;
+    MockComponent *comp;
+    guint i;
+
+    for (klass = mock_classes; klass->name; klass++)
+    {
+        if (!strcmp (klass->name, component_name))
+            break;
+    }
+
+    if (!klass->name)
+        return OMX_ErrorComponentNotFound;
+
+    g_usleep (get_setting (klass, "OMX_MOCK_LOAD_DELAY"));
+
+    comp = g_new0 (MockComponent, 1);
+    comp->klass = klass;
+    comp->app_data = app_data;
+    if (callbacks)
+        comp->callbacks = *callbacks;
+    comp->mutex = g_mutex_new ();
+    comp->cond = g_cond_new ();
+    comp->state = OMX_StateLoaded;
+    comp->commands = g_queue_new ();
+    comp->params = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    comp->delay = get_setting (klass, "OMX_MOCK_DELAY");
+    comp->state_delay = get_setting (klass, "OMX_MOCK_STATE_DELAY");
+    comp->depth = get_setting (klass, "OMX_MOCK_DEPTH");
+    comp->drop_eos = get_setting (klass, "OMX_MOCK_DROP_EOS") != 0;
+    comp->p_frames = MOCK_FRAMERATE - 1;
+    comp->layout = -1;
+
+    comp->num_ports = MAX (klass->in_start + klass->num_in,
+                           klass->out_start + klass->num_out);
+
+    for (i = 0; i < klass->num_in; i++)
+        init_port (comp, klass->in_start + i, OMX_DirInput,
+                   klass->in_coding, klass->in_color, klass->in_buffers);
+
+    for (i = 0; i < klass->num_out; i++)
+        init_port (comp, klass->out_start + i, OMX_DirOutput,
+                   klass->out_coding, klass->out_color, klass->out_buffers);
+
+    omx_comp = g_new0 (OMX_COMPONENTTYPE, 1);
+    omx_comp->nSize = sizeof (OMX_COMPONENTTYPE);
+    omx_comp->nVersion.s.nVersionMajor = 1;
+    omx_comp->nVersion.s.nVersionMinor = 1;
+    omx_comp->pComponentPrivate = comp;
+
+    omx_comp->GetComponentVersion = comp_GetComponentVersion;
+    omx_comp->SendCommand = comp_SendCommand;
+    omx_comp->GetParameter = comp_GetParameter;
+    omx_comp->SetParameter = comp_SetParameter;
+    omx_comp->GetConfig = comp_GetParameter;
+    omx_comp->SetConfig = comp_SetParameter;
+    omx_comp->GetExtensionIndex = comp_GetExtensionIndex;
+    omx_comp->GetState = comp_GetState;
+    omx_comp->UseBuffer = comp_UseBuffer;
+    omx_comp->AllocateBuffer = comp_AllocateBuffer;
+    omx_comp->FreeBuffer = comp_FreeBuffer;
+    omx_comp->EmptyThisBuffer = comp_EmptyThisBuffer;
+    omx_comp->FillThisBuffer = comp_FillThisBuffer;
+    omx_comp->SetCallbacks = comp_SetCallbacks;
+    omx_comp->ComponentDeInit = comp_ComponentDeInit;
+
+    comp->handle = omx_comp;
+    comp->thread = g_thread_create (mock_thread, comp, TRUE, NULL);
+
+    *handle = omx_comp;
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE
+OMX_FreeHandle (OMX_HANDLETYPE handle)
+{
+    OMX_COMPONENTTYPE *omx_comp = handle;
+
+    if (!omx_comp)
+        return OMX_ErrorBadParameter;
+
+    omx_comp->ComponentDeInit (handle);
+    g_free (omx_comp);
+
+    return OMX_ErrorNone;
+}
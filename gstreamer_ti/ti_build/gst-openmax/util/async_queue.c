@@ -23,42 +23,109 @@
 
 #include "async_queue.h"
 
+/* The queue is a fixed size ring of pointers, so pushing and popping never
+ * touch the allocator.  The ring is sized once, from the number of buffers
+ * the owner can have in flight (see async_queue_set_capacity()); it only
+ * grows if that estimate turns out to be wrong.
+ */
+
+static void
+resize (AsyncQueue *queue,
+        guint capacity)
+{
+    gpointer *ring;
+    guint i;
+
+    ring = g_new (gpointer, capacity);
+
+    for (i = 0; i < queue->length; i++)
+    {
+        guint index = queue->head + i;
+        if (index >= queue->capacity)
+            index -= queue->capacity;
+        ring[i] = queue->ring[index];
+    }
+
+    g_free (queue->ring);
+    queue->ring = ring;
+    queue->capacity = capacity;
+    queue->head = 0;
+}
+
 AsyncQueue *
-async_queue_new (void)
+async_queue_new_full (guint capacity)
 {
     AsyncQueue *queue;
 
+    g_return_val_if_fail (capacity > 0, NULL);
+
     queue = g_slice_new0 (AsyncQueue);
 
     queue->condition = g_cond_new ();
     queue->mutex = g_mutex_new ();
+    queue->ring = g_new (gpointer, capacity);
+    queue->capacity = capacity;
     queue->enabled = TRUE;
 
     return queue;
 }
 
+AsyncQueue *
+async_queue_new (void)
+{
+    return async_queue_new_full (ASYNC_QUEUE_DEFAULT_CAPACITY);
+}
+
 void
 async_queue_free (AsyncQueue *queue)
 {
     g_cond_free (queue->condition);
     g_mutex_free (queue->mutex);
 
-    g_list_free (queue->head);
+    g_free (queue->ring);
     g_slice_free (AsyncQueue, queue);
 }
 
+/**
+ * Make sure the queue can hold at least @capacity elements without
+ * reallocating.  Queued elements are kept.
+ */
+void
+async_queue_set_capacity (AsyncQueue *queue,
+                          guint capacity)
+{
+    g_mutex_lock (queue->mutex);
+
+    if (capacity > queue->capacity)
+        resize (queue, capacity);
+
+    g_mutex_unlock (queue->mutex);
+}
+
 void
 async_queue_push (AsyncQueue *queue,
                   gpointer data)
 {
+    guint index;
+
     g_mutex_lock (queue->mutex);
 
-    queue->head = g_list_prepend (queue->head, data);
-    if (!queue->tail)
-        queue->tail = queue->head;
+    if (G_UNLIKELY (queue->length == queue->capacity))
+    {
+        /* should not happen when the capacity matches the number of
+         * buffers in flight; don't lose data if it does */
+        resize (queue, queue->capacity * 2);
+    }
+
+    index = queue->head + queue->length;
+    if (index >= queue->capacity)
+        index -= queue->capacity;
+
+    queue->ring[index] = data;
     queue->length++;
 
-    g_cond_signal (queue->condition);
+    if (queue->waiters)
+        g_cond_signal (queue->condition);
 
     g_mutex_unlock (queue->mutex);
 }
@@ -76,23 +143,21 @@ async_queue_pop_full (AsyncQueue *queue, gboolean wait, gboolean force)
         goto leave;
     }
 
-    if (wait && !queue->tail)
+    if (wait && !queue->length)
     {
+        queue->waiters++;
         g_cond_wait (queue->condition, queue->mutex);
+        queue->waiters--;
     }
 
-    if (queue->tail)
+    if (queue->length)
     {
-        GList *node = queue->tail;
-        data = node->data;
-
-        queue->tail = node->prev;
-        if (queue->tail)
-            queue->tail->next = NULL;
-        else
-            queue->head = NULL;
+        data = queue->ring[queue->head];
+
+        queue->head++;
+        if (queue->head == queue->capacity)
+            queue->head = 0;
         queue->length--;
-        g_list_free_1 (node);
     }
 
 leave:
@@ -128,8 +193,19 @@ void
 async_queue_flush (AsyncQueue *queue)
 {
     g_mutex_lock (queue->mutex);
-    g_list_free (queue->head);
-    queue->head = queue->tail = NULL;
+    queue->head = 0;
     queue->length = 0;
     g_mutex_unlock (queue->mutex);
 }
+
+guint
+async_queue_length (AsyncQueue *queue)
+{
+    guint length;
+
+    g_mutex_lock (queue->mutex);
+    length = queue->length;
+    g_mutex_unlock (queue->mutex);
+
+    return length;
+}
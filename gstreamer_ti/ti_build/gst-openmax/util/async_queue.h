@@ -26,17 +26,24 @@
 
 typedef struct AsyncQueue AsyncQueue;
 
+/* Default number of slots of a queue created with async_queue_new(). */
+#define ASYNC_QUEUE_DEFAULT_CAPACITY 16
+
 struct AsyncQueue
 {
     GMutex *mutex;
     GCond *condition;
-    GList *head;
-    GList *tail;
+    gpointer *ring;     /**< fixed size array of capacity slots */
+    guint capacity;
+    guint head;         /**< index of the oldest element */
     guint length;
+    guint waiters;      /**< number of threads blocked in pop */
     gboolean enabled;
 };
 
 AsyncQueue *async_queue_new (void);
+AsyncQueue *async_queue_new_full (guint capacity);
+void async_queue_set_capacity (AsyncQueue *queue, guint capacity);
 void async_queue_free (AsyncQueue *queue);
 void async_queue_push (AsyncQueue *queue, gpointer data);
 gpointer async_queue_pop_full (AsyncQueue *queue, gboolean wait, gboolean force);
@@ -44,5 +51,6 @@ gpointer async_queue_pop (AsyncQueue *queue);
 void async_queue_disable (AsyncQueue *queue);
 void async_queue_enable (AsyncQueue *queue);
 void async_queue_flush (AsyncQueue *queue);
+guint async_queue_length (AsyncQueue *queue);
 
 #endif /* ASYNC_QUEUE_H */
@@ -37,16 +37,22 @@ GST_DEBUG_CATEGORY_STATIC(gst_ticircbuffer_debug);
 /* Declare a global pointer to our buffer base class */
 static GstMiniObjectClass *parent_class;
 
+
 /* Static Function Declarations */
 static void      gst_ticircbuffer_init(GTypeInstance *instance,
                      gpointer g_class);
 static void      gst_ticircbuffer_class_init(gpointer g_class,
                      gpointer class_data);
 static void      gst_ticircbuffer_finalize(GstTICircBuffer* circBuf);
+static gboolean  gst_ticircbuffer_write(GstTICircBuffer *circBuf,
+                     GstBuffer *buf);
+static gboolean  gst_ticircbuffer_can_queue_direct(GstTICircBuffer *circBuf,
+                     GstBuffer *buf);
+static void      gst_ticircbuffer_direct_consumed(GstTICircBuffer *circBuf,
+                     Int32 bytesAvailable, Int32 bytesConsumed);
 static void      gst_ticircbuffer_wait_on_producer(GstTICircBuffer *circBuf);
 static void      gst_ticircbuffer_broadcast_producer(GstTICircBuffer *circBuf);
-static void      gst_ticircbuffer_wait_on_consumer(GstTICircBuffer *circBuf,
-                                                   Int32 bytesNeeded);
+static void      gst_ticircbuffer_wait_on_consumer(GstTICircBuffer *circBuf);
 static void      gst_ticircbuffer_broadcast_consumer(GstTICircBuffer *circBuf);
 static gboolean  gst_ticircbuffer_shift_data(GstTICircBuffer *circBuf);
 static Int32     gst_ticircbuffer_reset_read_pointer(GstTICircBuffer *circBuf);
@@ -56,6 +62,8 @@ static Int32     gst_ticircbuffer_data_size(GstTICircBuffer *circBuf);
 static Int32     gst_ticircbuffer_write_space(GstTICircBuffer *circBuf);
 static Int32     gst_ticircbuffer_is_empty(GstTICircBuffer *circBuf);
 static void      gst_ticircbuffer_display(GstTICircBuffer *circBuf);
+static void      gst_ticircbuffer_timestamp_consumed(GstTICircBuffer *circBuf,
+                     Int32 bytesConsumed);
 
 /* Useful macros */
 #define gst_ticircbuffer_first_window_free(circBuf) \
@@ -65,6 +73,13 @@ static void      gst_ticircbuffer_display(GstTICircBuffer *circBuf);
 /* Constants */
 #define DISP_SIZE 77
 
+/* Input timestamp and the stream offset of the first byte it applies to */
+typedef struct {
+    guint64       offset;
+    GstClockTime  timestamp;
+    gboolean      used;
+} GstTICircBufferTimeStamp;
+
 /******************************************************************************
  * gst_ticircbuffer_get_type
  *    Defines function pointers for initialization routines for this object.
@@ -132,17 +147,38 @@ static void gst_ticircbuffer_finalize(GstTICircBuffer* circBuf)
     }
 
     GST_LOG("Maximum bytes consumed:  %lu\n", circBuf->maxConsumed);
+    GST_LOG("Bytes copied:  %llu, bytes passed without copying:  %llu\n",
+        circBuf->bytesCopied, circBuf->bytesDirect);
+
+    if (circBuf->directBuf) {
+        gst_buffer_unref(circBuf->directBuf);
+    }
 
     if (circBuf->hBuf) {
         Buffer_delete(circBuf->hBuf);
     }
 
     if (circBuf->waitOnProducer) {
-        Rendezvous_delete(circBuf->waitOnProducer);
+        g_cond_free(circBuf->waitOnProducer);
     }
 
     if (circBuf->waitOnConsumer) {
-        Rendezvous_delete(circBuf->waitOnConsumer);
+        g_cond_free(circBuf->waitOnConsumer);
+    }
+
+    if (circBuf->lock) {
+        g_mutex_free(circBuf->lock);
+    }
+
+    if (circBuf->tsQueue) {
+        while (!g_queue_is_empty(circBuf->tsQueue)) {
+            g_free(g_queue_pop_head(circBuf->tsQueue));
+        }
+        g_queue_free(circBuf->tsQueue);
+    }
+
+    if (circBuf->tsLock) {
+        g_mutex_free(circBuf->tsLock);
     }
 }
 
@@ -154,10 +190,10 @@ static void gst_ticircbuffer_init(GTypeInstance *instance,
                 gpointer g_class)
 {
     GstTICircBuffer   *circBuf  = GST_TICIRCBUFFER(instance);
-    Rendezvous_Attrs   rzvAttrs = Rendezvous_Attrs_DEFAULT;
 
     GST_LOG("begin init");
 
+    circBuf->lock            = g_mutex_new();
     circBuf->hBuf            = NULL;
     circBuf->readPtr         = NULL;
     circBuf->writePtr        = NULL;
@@ -165,16 +201,26 @@ static void gst_ticircbuffer_init(GTypeInstance *instance,
     circBuf->dataDuration    = 0ULL;
     circBuf->windowSize      = 0UL;
     circBuf->readAheadSize   = 0UL;
-    circBuf->waitOnProducer  = Rendezvous_create(100, &rzvAttrs);
-    circBuf->waitOnConsumer  = Rendezvous_create(100, &rzvAttrs);
+    circBuf->waitOnProducer  = g_cond_new();
+    circBuf->waitOnConsumer  = g_cond_new();
     circBuf->drain           = FALSE;
-    circBuf->bytesNeeded     = 0UL;
     circBuf->maxConsumed     = 0UL;
+    circBuf->bytesCopied     = 0ULL;
+    circBuf->bytesDirect     = 0ULL;
     circBuf->displayBuffer   = FALSE;
     circBuf->contiguousData  = TRUE;
     circBuf->fixedBlockSize  = FALSE;
     circBuf->consumerAborted = FALSE;
+    circBuf->zeroCopy        = FALSE;
+    circBuf->directBuf       = NULL;
+    circBuf->directOffset    = 0;
     circBuf->userCopy       = NULL;
+    circBuf->tsLock          = g_mutex_new();
+    circBuf->tsQueue         = g_queue_new();
+    circBuf->bytesQueued     = 0ULL;
+    circBuf->bytesRead       = 0ULL;
+    circBuf->tsResync        = FALSE;
+    circBuf->flushOffset     = 0ULL;
 
     GST_LOG("end init");
 }
@@ -253,28 +299,93 @@ gboolean gst_ticircbuffer_copy_config (GstTICircBuffer *circBuf,
     return TRUE;    
 }
 
+/******************************************************************************
+ * gst_ticircbuffer_set_zero_copy
+ *     Let input buffers that are already in contiguous memory be handed to
+ *     the consumer as they are instead of being copied.  Only enable this
+ *     when every input buffer starts with a whole frame, as the consumer
+ *     sees each one on its own; whatever it leaves of one is moved to the
+ *     circular buffer to be read together with the data that follows.
+ ******************************************************************************/
+void gst_ticircbuffer_set_zero_copy(GstTICircBuffer *circBuf, gboolean enable)
+{
+    if (circBuf == NULL) {
+        return;
+    }
+
+    g_mutex_lock(circBuf->lock);
+    circBuf->zeroCopy = enable;
+    g_mutex_unlock(circBuf->lock);
+}
+
 /******************************************************************************
  * gst_ticircbuffer_queue_data
  *     Append received encoded data to end of circular buffer
  ******************************************************************************/
 gboolean gst_ticircbuffer_queue_data(GstTICircBuffer *circBuf, GstBuffer *buf)
 {
-    gboolean result = TRUE;
-    Int32    writeSpace;
+    gboolean result;
 
     /* If the circular buffer doesn't exist, do nothing */
     if (circBuf == NULL) {
-        goto exit_fail;
+        return FALSE;
+    }
+
+    /* Log the buffer timestamp if available */
+    if (GST_CLOCK_TIME_IS_VALID(GST_BUFFER_TIMESTAMP(buf))) {
+        GST_LOG("buffer received:  timestamp:  %llu, duration:  "
+            "%llu\n", GST_BUFFER_TIMESTAMP(buf), GST_BUFFER_DURATION(buf));
+    }
+    else {
+        GST_LOG("buffer received:  no timestamp available\n");
     }
 
-    /* Reset our mutex condition so a call to wait_on_consumer will block */
-    Rendezvous_reset(circBuf->waitOnConsumer);
+    g_mutex_lock(circBuf->lock);
+    result = gst_ticircbuffer_write(circBuf, buf);
+    g_mutex_unlock(circBuf->lock);
+
+    return result;
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_write
+ *     Append buf to the end of the circular buffer, blocking until there is
+ *     room for it.  Called with the lock held, which is released while
+ *     waiting on the consumer and while copying data.
+ ******************************************************************************/
+static gboolean gst_ticircbuffer_write(GstTICircBuffer *circBuf,
+                    GstBuffer *buf)
+{
+    Int32    writeSpace;
+    Int8    *writePtr;
 
     /* If the consumer aborted, abort the buffer queuing.  We don't want to
      * queue buffers that no one will read.
      */
     if (circBuf->consumerAborted) {
-        goto exit_fail;
+        return FALSE;
+    }
+
+    /* A buffer queued without copying must be used up before any data
+     * queued after it can be read.
+     */
+    while (circBuf->directBuf != NULL && !circBuf->consumerAborted) {
+        GST_LOG("blocking input until the uncopied buffer is consumed\n");
+        gst_ticircbuffer_wait_on_consumer(circBuf);
+    }
+
+    if (circBuf->consumerAborted) {
+        return FALSE;
+    }
+
+    if (gst_ticircbuffer_can_queue_direct(circBuf, buf)) {
+        circBuf->directBuf     = gst_buffer_ref(buf);
+        circBuf->directOffset  = 0;
+        circBuf->bytesDirect  += GST_BUFFER_SIZE(buf);
+        GST_LOG("queued %u bytes of data without copying\n",
+            GST_BUFFER_SIZE(buf));
+        goto queued;
     }
 
     /* If we run out of space, we need to move the data from the last buffer
@@ -316,67 +427,67 @@ gboolean gst_ticircbuffer_queue_data(GstTICircBuffer *circBuf, GstBuffer *buf)
                 GST_BUFFER_SIZE(buf) - writeSpace);
 
             subBuf = gst_buffer_create_sub(buf, 0, writeSpace);
-            tmpResult = gst_ticircbuffer_queue_data(circBuf, subBuf);
+            tmpResult = gst_ticircbuffer_write(circBuf, subBuf);
             gst_buffer_unref(subBuf);
 
-            if (!tmpResult) { goto exit_fail; }
+            if (!tmpResult) { return FALSE; }
 
             subBuf = gst_buffer_create_sub(buf, writeSpace,
                          GST_BUFFER_SIZE(buf) - writeSpace);
-            tmpResult = gst_ticircbuffer_queue_data(circBuf, subBuf);
+            tmpResult = gst_ticircbuffer_write(circBuf, subBuf);
             gst_buffer_unref(subBuf);
 
-            if (!tmpResult) { goto exit_fail; }
-
-            goto exit;
+            return tmpResult;
         }
 
         /* Block until either the first window is free, or there is enough
          * free space available to put our buffer.
          */
         GST_LOG("blocking input until processing thread catches up\n");
-        gst_ticircbuffer_wait_on_consumer(circBuf, GST_BUFFER_SIZE(buf));
+        gst_ticircbuffer_wait_on_consumer(circBuf);
         GST_LOG("unblocking input\n");
 
-        /* Reset our mutex condition so calling wait_on_consumer will block */
-        Rendezvous_reset(circBuf->waitOnConsumer);
-
         /* If the consumer aborted, abort the buffer queuing.  We don't want to
          * queue buffers that no one will read.
          */
         if (circBuf->consumerAborted) {
-            goto exit_fail;
+            return FALSE;
         }
 
         gst_ticircbuffer_shift_data(circBuf);
     }
 
-    /* Log the buffer timestamp if available */
-    if (GST_CLOCK_TIME_IS_VALID(GST_BUFFER_TIMESTAMP(buf))) {
-        GST_LOG("buffer received:  timestamp:  %llu, duration:  "
-            "%llu\n", GST_BUFFER_TIMESTAMP(buf), GST_BUFFER_DURATION(buf));
-    }
-    else {
-        GST_LOG("buffer received:  no timestamp available\n");
-    }
+    /* The space past the write pointer is never read by the consumer, so the
+     * data can be copied there without holding the lock.
+     */
+    writePtr = circBuf->writePtr;
+    g_mutex_unlock(circBuf->lock);
 
     /* Copy the buffer using user defined function */
     if (circBuf->userCopy) {
         GST_LOG("copying input buffer using user provided copy fxn\n");
-        if (circBuf->userCopy(circBuf->writePtr, buf, 
-              circBuf->userCopyData) < 0) {
+        if (circBuf->userCopy(writePtr, buf, circBuf->userCopyData) < 0) {
             GST_ERROR("failed to copy input buffer.\n");
-            goto exit_fail;
+            g_mutex_lock(circBuf->lock);
+            return FALSE;
         }
     }
-    else {        
-        memcpy(circBuf->writePtr, GST_BUFFER_DATA(buf), GST_BUFFER_SIZE(buf));
+    else {
+        memcpy(writePtr, GST_BUFFER_DATA(buf), GST_BUFFER_SIZE(buf));
     }
-    circBuf->writePtr += GST_BUFFER_SIZE(buf);
+
+    g_mutex_lock(circBuf->lock);
+    circBuf->writePtr    += GST_BUFFER_SIZE(buf);
+    circBuf->bytesCopied += GST_BUFFER_SIZE(buf);
 
     /* Copy new data to the end of the buffer */
     GST_LOG("queued %u bytes of data\n", GST_BUFFER_SIZE(buf));
 
+queued:
+    g_mutex_lock(circBuf->tsLock);
+    circBuf->bytesQueued += GST_BUFFER_SIZE(buf);
+    g_mutex_unlock(circBuf->tsLock);
+
     /* Output the buffer status to stdout if buffer debug is enabled */
     if (circBuf->displayBuffer) {
         gst_ticircbuffer_display(circBuf);
@@ -395,19 +506,42 @@ gboolean gst_ticircbuffer_queue_data(GstTICircBuffer *circBuf, GstBuffer *buf)
 
     /* If our buffer got low, some consuming threads may have blocked waiting
      * for more data.  If there is at least a window and our specified read
-     * ahead available in the buffer, unblock any threads.
+     * ahead available in the buffer, unblock any threads.  A buffer queued
+     * without copying can be read straight away.
      */
-    if (gst_ticircbuffer_data_size(circBuf) >=
+    if (circBuf->directBuf != NULL ||
+        gst_ticircbuffer_data_size(circBuf) >=
         circBuf->windowSize + circBuf->readAheadSize) {
         gst_ticircbuffer_broadcast_producer(circBuf);
     }
 
-    goto exit;
+    return TRUE;
+}
 
-exit_fail:
-    result = FALSE;
-exit:
-    return result;
+
+/******************************************************************************
+ * gst_ticircbuffer_can_queue_direct
+ *     Determine if buf can be handed to the consumer without being copied.
+ *     The codec reads its input through a DMAI buffer, so the data has to be
+ *     in contiguous memory already, and anything still in the circular
+ *     buffer has to be read before it.
+ ******************************************************************************/
+static gboolean gst_ticircbuffer_can_queue_direct(GstTICircBuffer *circBuf,
+                    GstBuffer *buf)
+{
+    if (!circBuf->zeroCopy || circBuf->userCopy != NULL ||
+        GST_BUFFER_SIZE(buf) == 0 || !GST_IS_TIDMAIBUFFERTRANSPORT(buf) ||
+        !gst_ticircbuffer_is_empty(circBuf)) {
+        return FALSE;
+    }
+
+    /* In fixedBlockSize mode the consumer takes exactly one window */
+    if (circBuf->fixedBlockSize &&
+        GST_BUFFER_SIZE(buf) != circBuf->windowSize) {
+        return FALSE;
+    }
+
+    return TRUE;
 }
 
 
@@ -417,6 +551,8 @@ exit:
 gboolean gst_ticircbuffer_data_consumed(
              GstTICircBuffer *circBuf, GstBuffer *buf, Int32 bytesConsumed)
 {
+    Int32 bytesAvailable;
+
     if (circBuf == NULL) {
         return FALSE;
     }
@@ -439,11 +575,22 @@ gboolean gst_ticircbuffer_data_consumed(
     }
 
     /* Release the reference buffer */
+    bytesAvailable = GST_BUFFER_SIZE(buf);
     gst_buffer_unref(buf);
 
+    g_mutex_lock(circBuf->lock);
+
     /* Update the read pointer */
     GST_LOG("%ld bytes consumed\n", bytesConsumed);
-    circBuf->readPtr  += bytesConsumed;
+    if (circBuf->directBuf != NULL) {
+        gst_ticircbuffer_direct_consumed(circBuf, bytesAvailable,
+            bytesConsumed);
+    }
+    else {
+        circBuf->readPtr  += bytesConsumed;
+    }
+
+    gst_ticircbuffer_timestamp_consumed(circBuf, bytesConsumed);
 
     /* Update the max bytes consumed statistic */
     if (bytesConsumed > circBuf->maxConsumed) {
@@ -458,10 +605,57 @@ gboolean gst_ticircbuffer_data_consumed(
     /* Unblock the input buffer queue if there is room for more buffers. */
     gst_ticircbuffer_broadcast_consumer(circBuf);
 
+    g_mutex_unlock(circBuf->lock);
+
     return TRUE;
 }
 
 
+/******************************************************************************
+ * gst_ticircbuffer_direct_consumed
+ *     Advance through the buffer queued without copying.  If the consumer
+ *     stopped short of the end of the data it was given, it needs more than
+ *     this buffer holds: move the rest into the (empty) circular buffer so it
+ *     is read together with the data queued next.
+ ******************************************************************************/
+static void gst_ticircbuffer_direct_consumed(GstTICircBuffer *circBuf,
+                Int32 bytesAvailable, Int32 bytesConsumed)
+{
+    Int8  *circBufStart = Buffer_getUserPtr(circBuf->hBuf);
+    Int32  remaining;
+
+    if (bytesConsumed <= 0) {
+        return;
+    }
+
+    circBuf->directOffset += bytesConsumed;
+    remaining = GST_BUFFER_SIZE(circBuf->directBuf) - circBuf->directOffset;
+
+    /* Keep handing out a buffer read one window at a time */
+    if (remaining > 0 && (bytesConsumed == bytesAvailable ||
+                          remaining > Buffer_getSize(circBuf->hBuf))) {
+        return;
+    }
+
+    if (remaining > 0) {
+        GST_LOG("moving %lu unconsumed bytes to the circular buffer\n",
+            remaining);
+        circBuf->readPtr = circBuf->writePtr = circBufStart;
+        memcpy(circBuf->writePtr, GST_BUFFER_DATA(circBuf->directBuf) +
+            circBuf->directOffset, remaining);
+        circBuf->writePtr    += remaining;
+        circBuf->bytesCopied += remaining;
+    }
+
+    gst_buffer_unref(circBuf->directBuf);
+    circBuf->directBuf    = NULL;
+    circBuf->directOffset = 0;
+
+    /* The producer may be waiting for the buffer to be released */
+    g_cond_broadcast(circBuf->waitOnConsumer);
+}
+
+
 /*****************************************************************************
  * gst_ticircbuffer_time_consumed
  *****************************************************************************/
@@ -472,6 +666,8 @@ gboolean gst_ticircbuffer_time_consumed(GstTICircBuffer *circBuf,
         return FALSE;
     }
 
+    g_mutex_lock(circBuf->lock);
+
     if (!GST_CLOCK_TIME_IS_VALID(timeConsumed)) {
         circBuf->dataDuration = GST_CLOCK_TIME_NONE;
     }
@@ -483,6 +679,8 @@ gboolean gst_ticircbuffer_time_consumed(GstTICircBuffer *circBuf,
         circBuf->dataDuration  -= timeConsumed;
     }
 
+    g_mutex_unlock(circBuf->lock);
+
     return TRUE;
 }
 
@@ -495,31 +693,43 @@ GstBuffer* gst_ticircbuffer_get_data(GstTICircBuffer *circBuf)
     Buffer_Handle  hCircBufWindow;
     Buffer_Attrs   bAttrs;
     GstBuffer     *result;
+    GstClockTime   dataTimeStamp;
+    Int8          *dataPtr;
     Int32          bufSize;
 
     if (circBuf == NULL) {
         return NULL;
     }
 
-    /* Reset our mutex condition so calling wait_on_consumer will block */
-    Rendezvous_reset(circBuf->waitOnProducer);
+    g_mutex_lock(circBuf->lock);
 
     /* Reset the read pointer to the beginning of the buffer when we're
      * approaching the buffer's end (see function definition for reset
-     * conditions).
+     * conditions).  This can open up space for the queue thread.
      */
     gst_ticircbuffer_reset_read_pointer(circBuf);
+    gst_ticircbuffer_broadcast_consumer(circBuf);
 
     /* Don't return any data util we have a full window available */
-    while (!circBuf->drain && !gst_ticircbuffer_window_available(circBuf)) {
+    while (!circBuf->drain && circBuf->directBuf == NULL &&
+           !gst_ticircbuffer_window_available(circBuf)) {
 
         GST_LOG("blocking output until a full window is available\n");
         gst_ticircbuffer_wait_on_producer(circBuf);
         GST_LOG("unblocking output\n");
         gst_ticircbuffer_reset_read_pointer(circBuf);
+        gst_ticircbuffer_broadcast_consumer(circBuf);
+    }
 
-        /* Reset our mutex condition so calling wait_on_consumer will block */
-        Rendezvous_reset(circBuf->waitOnProducer);
+    /* Data queued without copying is read from the buffer it came in */
+    if (circBuf->directBuf != NULL) {
+        dataPtr = (Int8*)GST_BUFFER_DATA(circBuf->directBuf) +
+                  circBuf->directOffset;
+        bufSize = GST_BUFFER_SIZE(circBuf->directBuf) - circBuf->directOffset;
+    }
+    else {
+        dataPtr = circBuf->readPtr;
+        bufSize = gst_ticircbuffer_data_available(circBuf);
     }
 
     /* Set the size of the buffer to be no larger than the window size.  Some
@@ -527,7 +737,6 @@ GstBuffer* gst_ticircbuffer_get_data(GstTICircBuffer *circBuf)
      * We need to pass it smaller buffer sizes though, as the EOS is detected
      * when we return a 0 size buffer.
      */
-    bufSize = gst_ticircbuffer_data_available(circBuf);
     if (bufSize > circBuf->windowSize) {
         bufSize = circBuf->windowSize;
     }
@@ -540,26 +749,194 @@ GstBuffer* gst_ticircbuffer_get_data(GstTICircBuffer *circBuf)
 
     hCircBufWindow = Buffer_create(bufSize, &bAttrs);
 
-    Buffer_setUserPtr(hCircBufWindow, circBuf->readPtr);
+    Buffer_setUserPtr(hCircBufWindow, dataPtr);
     Buffer_setNumBytesUsed(hCircBufWindow, bufSize);
 
-    GST_LOG("returning data at offset %u\n", circBuf->readPtr - 
-        Buffer_getUserPtr(circBuf->hBuf));
+    if (circBuf->directBuf == NULL) {
+        GST_LOG("returning data at offset %u\n", circBuf->readPtr -
+            Buffer_getUserPtr(circBuf->hBuf));
+    }
+    else {
+        GST_LOG("returning uncopied data at offset %lu\n",
+            circBuf->directOffset);
+    }
+
+    dataTimeStamp = circBuf->dataTimeStamp;
+
+    g_mutex_unlock(circBuf->lock);
 
     result = (GstBuffer*)(gst_tidmaibuffertransport_new(hCircBufWindow, NULL));
-    GST_BUFFER_TIMESTAMP(result) = circBuf->dataTimeStamp;
+    GST_BUFFER_TIMESTAMP(result) = dataTimeStamp;
     GST_BUFFER_DURATION(result)  = GST_CLOCK_TIME_NONE;
     return result;
 }
 
 
+/******************************************************************************
+ * gst_ticircbuffer_mark_timestamp
+ *     Record that the data queued from now on was stamped with timestamp.
+ *     Consumers can then look up the timestamp of the data at the read
+ *     pointer with gst_ticircbuffer_get_timestamp.
+ ******************************************************************************/
+void gst_ticircbuffer_mark_timestamp(GstTICircBuffer *circBuf,
+         GstClockTime timestamp)
+{
+    GstTICircBufferTimeStamp *entry;
+    gboolean                  resync;
+
+    if (circBuf == NULL || !GST_CLOCK_TIME_IS_VALID(timestamp)) {
+        return;
+    }
+
+    g_mutex_lock(circBuf->tsLock);
+
+    /* An earlier timestamp with no data behind it is superseded */
+    entry = (GstTICircBufferTimeStamp*) g_queue_peek_tail(circBuf->tsQueue);
+    if (entry == NULL || entry->offset != circBuf->bytesQueued) {
+        entry = g_new(GstTICircBufferTimeStamp, 1);
+        g_queue_push_tail(circBuf->tsQueue, entry);
+    }
+
+    entry->offset    = circBuf->bytesQueued;
+    entry->timestamp = timestamp;
+    entry->used      = FALSE;
+
+    resync            = circBuf->tsResync;
+    circBuf->tsResync = FALSE;
+
+    g_mutex_unlock(circBuf->tsLock);
+
+    /* The running total starts over from the first timestamp after a reset */
+    if (resync) {
+        g_mutex_lock(circBuf->lock);
+        circBuf->dataTimeStamp = timestamp;
+        g_mutex_unlock(circBuf->lock);
+    }
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_reset_timestamps
+ *     Forget the timestamps marked so far, on a flush.  The running total
+ *     restarts from the next timestamp marked, and the data still in the
+ *     buffer from before is reported by gst_ticircbuffer_flushed_bytes for
+ *     the consumer to throw away.  The byte counters carry on, since they
+ *     still locate that data.
+ ******************************************************************************/
+void gst_ticircbuffer_reset_timestamps(GstTICircBuffer *circBuf)
+{
+    if (circBuf == NULL) {
+        return;
+    }
+
+    g_mutex_lock(circBuf->tsLock);
+
+    while (!g_queue_is_empty(circBuf->tsQueue)) {
+        g_free(g_queue_pop_head(circBuf->tsQueue));
+    }
+    circBuf->tsResync    = TRUE;
+    circBuf->flushOffset = circBuf->bytesQueued;
+
+    g_mutex_unlock(circBuf->tsLock);
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_flushed_bytes
+ *     Return how many bytes at the read pointer were queued before the last
+ *     gst_ticircbuffer_reset_timestamps.
+ ******************************************************************************/
+Int32 gst_ticircbuffer_flushed_bytes(GstTICircBuffer *circBuf)
+{
+    Int32 result = 0;
+
+    if (circBuf == NULL) {
+        return 0;
+    }
+
+    g_mutex_lock(circBuf->tsLock);
+
+    if (circBuf->flushOffset > circBuf->bytesRead) {
+        result = (Int32)(circBuf->flushOffset - circBuf->bytesRead);
+    }
+
+    g_mutex_unlock(circBuf->tsLock);
+
+    return result;
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_get_timestamp
+ *     Return the timestamp of the data at the read pointer, which is that of
+ *     the last timestamp marked at or before it.  Each timestamp is only
+ *     handed out for one consume operation: data starting after it has been
+ *     used has no timestamp.
+ ******************************************************************************/
+GstClockTime gst_ticircbuffer_get_timestamp(GstTICircBuffer *circBuf)
+{
+    GstTICircBufferTimeStamp *entry;
+    GstClockTime              result = GST_CLOCK_TIME_NONE;
+
+    if (circBuf == NULL) {
+        return GST_CLOCK_TIME_NONE;
+    }
+
+    g_mutex_lock(circBuf->tsLock);
+
+    entry = (GstTICircBufferTimeStamp*) g_queue_peek_head(circBuf->tsQueue);
+    if (entry && !entry->used && entry->offset <= circBuf->bytesRead) {
+        result = entry->timestamp;
+    }
+
+    g_mutex_unlock(circBuf->tsLock);
+
+    return result;
+}
+
+
+/******************************************************************************
+ * gst_ticircbuffer_timestamp_consumed
+ *     Advance the stream offset of the read pointer, using up the timestamp
+ *     of the data consumed and dropping the ones that no longer apply.
+ ******************************************************************************/
+static void gst_ticircbuffer_timestamp_consumed(GstTICircBuffer *circBuf,
+                Int32 bytesConsumed)
+{
+    GstTICircBufferTimeStamp *entry;
+    GstTICircBufferTimeStamp *next;
+
+    if (bytesConsumed <= 0) {
+        return;
+    }
+
+    g_mutex_lock(circBuf->tsLock);
+
+    entry = (GstTICircBufferTimeStamp*) g_queue_peek_head(circBuf->tsQueue);
+    if (entry && entry->offset <= circBuf->bytesRead) {
+        entry->used = TRUE;
+    }
+
+    circBuf->bytesRead += bytesConsumed;
+
+    /* Keep only the last timestamp at or before the read pointer */
+    while ((next = (GstTICircBufferTimeStamp*)
+                g_queue_peek_nth(circBuf->tsQueue, 1)) != NULL &&
+           next->offset <= circBuf->bytesRead) {
+        g_free(g_queue_pop_head(circBuf->tsQueue));
+    }
+
+    g_mutex_unlock(circBuf->tsLock);
+}
+
+
 /******************************************************************************
  * gst_ticircbuffer_wait_on_producer
- *    Wait for a producer to process data
+ *    Wait for a producer to process data.  Called with the lock held.
  ******************************************************************************/
 static void gst_ticircbuffer_wait_on_producer(GstTICircBuffer *circBuf)
 {
-    Rendezvous_meet(circBuf->waitOnProducer);
+    g_cond_wait(circBuf->waitOnProducer, circBuf->lock);
 }
 
 
@@ -570,19 +947,17 @@ static void gst_ticircbuffer_wait_on_producer(GstTICircBuffer *circBuf)
 static void gst_ticircbuffer_broadcast_producer(GstTICircBuffer *circBuf)
 {
     GST_LOG("broadcast_producer: output unblocked\n");
-    Rendezvous_force(circBuf->waitOnProducer);
+    g_cond_broadcast(circBuf->waitOnProducer);
 }
 
 
 /******************************************************************************
  * gst_ticircbuffer_wait_on_consumer
- *    Wait for a consumer to process data
+ *    Wait for a consumer to process data.  Called with the lock held.
  ******************************************************************************/
-static void gst_ticircbuffer_wait_on_consumer(GstTICircBuffer *circBuf,
-                                              Int32 bytesNeeded)
+static void gst_ticircbuffer_wait_on_consumer(GstTICircBuffer *circBuf)
 {
-    circBuf->bytesNeeded = bytesNeeded;
-    Rendezvous_meet(circBuf->waitOnConsumer);
+    g_cond_wait(circBuf->waitOnConsumer, circBuf->lock);
 }
 
 /******************************************************************************
@@ -602,16 +977,17 @@ static void gst_ticircbuffer_broadcast_consumer(GstTICircBuffer *circBuf)
             canUnblock = TRUE;
     }
 
-    /* Otherwise, we can unblock if there is now enough space to queue the
-     * next input buffer.
+    /* Otherwise, we can unblock if there is any space to queue data in.  The
+     * queue thread splits its input buffer to fit, so waiting for room for
+     * the whole buffer could leave both threads blocked.
      */
-    else if (gst_ticircbuffer_write_space(circBuf) >= circBuf->bytesNeeded) {
+    else if (gst_ticircbuffer_write_space(circBuf) > 0) {
         canUnblock = TRUE;
     }
 
     if (canUnblock) {
         GST_LOG("broadcast_consumer: input unblocked\n");
-        Rendezvous_force(circBuf->waitOnConsumer);
+        g_cond_broadcast(circBuf->waitOnConsumer);
     }
 }
 
@@ -627,8 +1003,10 @@ void gst_ticircbuffer_consumer_aborted(GstTICircBuffer *circBuf)
         return;
     }
 
+    g_mutex_lock(circBuf->lock);
     circBuf->consumerAborted = TRUE;
-    Rendezvous_force(circBuf->waitOnConsumer);
+    g_cond_broadcast(circBuf->waitOnConsumer);
+    g_mutex_unlock(circBuf->lock);
 }
 
 
@@ -643,16 +1021,21 @@ void gst_ticircbuffer_drain(GstTICircBuffer *circBuf, gboolean status)
         return;
     }
 
+    g_mutex_lock(circBuf->lock);
+
     circBuf->drain = status;
 
     if (status == TRUE) {
         gst_ticircbuffer_broadcast_producer(circBuf);
     }
+
+    g_mutex_unlock(circBuf->lock);
 }
 
 /******************************************************************************
  * gst_ticircbuffer_shift_data
  *    Look for uncopied data in the last window and move it to the first one.
+ *    Called with the lock held.
  ******************************************************************************/
 static gboolean gst_ticircbuffer_shift_data(GstTICircBuffer *circBuf)
 {
@@ -660,6 +1043,7 @@ static gboolean gst_ticircbuffer_shift_data(GstTICircBuffer *circBuf)
     Int32     lastWinOffset = Buffer_getSize(circBuf->hBuf) -
                               (circBuf->windowSize + circBuf->readAheadSize);
     Int8*     lastWindow    = firstWindow + lastWinOffset;
+    Int8*     copyFrom;
     Int32     bytesToCopy   = 0;
     gboolean  writePtrReset = FALSE;
 
@@ -672,8 +1056,9 @@ static gboolean gst_ticircbuffer_shift_data(GstTICircBuffer *circBuf)
                 (UInt32)(circBuf->writePtr - firstWindow));
             circBuf->writePtr       = Buffer_getUserPtr(circBuf->hBuf);
             circBuf->contiguousData = FALSE;
+            return TRUE;
         }
-        return TRUE;
+        return FALSE;
     }
 
     /* Otherwise copy unconsumed data from the last window to the first one
@@ -683,14 +1068,23 @@ static gboolean gst_ticircbuffer_shift_data(GstTICircBuffer *circBuf)
         circBuf->writePtr >= circBuf->readPtr       &&
         circBuf->writePtr >= lastWindow + circBuf->windowSize)
     {
+        /* Data before the read pointer has been consumed already */
+        copyFrom    = MAX(lastWindow, circBuf->readPtr);
+        bytesToCopy = circBuf->writePtr - copyFrom;
 
-        bytesToCopy = circBuf->writePtr - lastWindow;
-
-        GST_LOG("shifting %lu bytes of data from %lu to 0\n", bytesToCopy,
-            (UInt32)(lastWindow - firstWindow));
+        GST_LOG("shifting %lu bytes of data from %lu to %lu\n", bytesToCopy,
+            (UInt32)(copyFrom - firstWindow),
+            (UInt32)(copyFrom - lastWindow));
 
+        /* The consumer cannot reach the first window before the write
+         * pointer is reset, so the lock need not be held while copying.
+         */
         if (bytesToCopy > 0) {
-            memcpy(firstWindow, lastWindow, bytesToCopy);
+            g_mutex_unlock(circBuf->lock);
+            memcpy(firstWindow + (copyFrom - lastWindow), copyFrom,
+                bytesToCopy);
+            g_mutex_lock(circBuf->lock);
+            circBuf->bytesCopied += bytesToCopy;
         }
 
         GST_LOG("resetting write pointer (%lu->%lu)\n",
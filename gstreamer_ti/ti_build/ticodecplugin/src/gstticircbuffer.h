@@ -49,13 +49,20 @@ typedef struct _GstTICircBuffer GstTICircBuffer;
 #define gst_ticircbuffer_unref(buf) \
             gst_mini_object_unref(GST_MINI_OBJECT_CAST(buf))
 
-/* _GstTICircBuffer object */
+/* _GstTICircBuffer object
+ *
+ * One producer thread (the chain function) queues data while one consumer
+ * thread (the codec thread) reads it.  The read and write pointers and the
+ * rest of the buffer state are protected by "lock"; the data itself is only
+ * copied outside of it, into space the consumer cannot see yet.
+ */
 struct _GstTICircBuffer {
 
     /* Parent Class */
     GstMiniObject      mini_object;
 
     /* Circular Buffer */
+    GMutex            *lock;
     Buffer_Handle      hBuf;
     Int8              *readPtr;
     Int8              *writePtr;
@@ -68,18 +75,42 @@ struct _GstTICircBuffer {
     GstClockTime       dataTimeStamp;
     GstClockTime       dataDuration;
 
+    /* Input timestamps and the stream offset they start at, for consumers
+     * that want the timestamp of the data they decode rather than a running
+     * total of the time consumed.
+     */
+    GMutex            *tsLock;
+    GQueue            *tsQueue;
+    guint64            bytesQueued;
+    guint64            bytesRead;
+
+    /* Set by gst_ticircbuffer_reset_timestamps: for the next timestamp
+     * marked to restart dataTimeStamp, and the stream offset the data queued
+     * after the reset starts at.
+     */
+    gboolean           tsResync;
+    guint64            flushOffset;
+
     /* Input Thresholds */
     Int32              windowSize;
     gboolean           drain;
-    Int32              bytesNeeded;
 
     /* Blocking Conditions to Throttle I/O */
-    Rendezvous_Handle  waitOnConsumer;
-    Rendezvous_Handle  waitOnProducer;
+    GCond             *waitOnConsumer;
+    GCond             *waitOnProducer;
+
+    /* Zero-copy input: a contiguous (DMAI) input buffer handed to the
+     * consumer as is instead of being copied into the circular buffer.
+     */
+    gboolean           zeroCopy;
+    GstBuffer         *directBuf;
+    Int32              directOffset;
 
     /* Debug / Stats */
     gboolean           displayBuffer;
     Int32              maxConsumed;
+    guint64            bytesCopied;
+    guint64            bytesDirect;
 
     /* Define user copy function */
     void               *userCopyData;
@@ -97,11 +128,18 @@ gboolean         gst_ticircbuffer_data_consumed(GstTICircBuffer *circBuf,
 gboolean         gst_ticircbuffer_time_consumed(
                      GstTICircBuffer *circBuf, GstClockTime timeConsumed);
 GstBuffer*       gst_ticircbuffer_get_data(GstTICircBuffer *circBuf);
+void             gst_ticircbuffer_mark_timestamp(GstTICircBuffer *circBuf,
+                     GstClockTime timestamp);
+GstClockTime     gst_ticircbuffer_get_timestamp(GstTICircBuffer *circBuf);
+void             gst_ticircbuffer_reset_timestamps(GstTICircBuffer *circBuf);
+Int32            gst_ticircbuffer_flushed_bytes(GstTICircBuffer *circBuf);
 void             gst_ticircbuffer_drain(GstTICircBuffer *circBuf,
                      gboolean status);
 void             gst_ticircbuffer_set_display(GstTICircBuffer *circBuf,
                      gboolean disp);
 void             gst_ticircbuffer_consumer_aborted(GstTICircBuffer *circBuf);
+void             gst_ticircbuffer_set_zero_copy(GstTICircBuffer *circBuf,
+                     gboolean enable);
 gboolean         gst_ticircbuffer_copy_config (GstTICircBuffer *circBuf,
                   Int (*userCopy) (Int8* dst, GstBuffer* src, void *data), 
                     void *data);
@@ -23,9 +23,12 @@
 /**
  * SECTION:element-dmaiperf
  *
- * DmaiPerf can be used to capture pipeline performance data.  Each 
- * second dmaiperf sends a frames per second, bytes per second, and
- * timestamp data using gst_element_post_message.
+ * DmaiPerf can be used to capture pipeline performance data.  Every
+ * interval milliseconds (one second by default) dmaiperf sends frames
+ * per second, bytes per second, and timestamp data using
+ * gst_element_post_message.  The DSP figures come from the server of the
+ * engine named by engine-name, or from the Server_Handle given in the
+ * server property.
  *
  * The performance messages can be used by your application.  However,
  * the dmaiperf element is EXPERIMENTAL and intended for engineers 
@@ -59,6 +62,17 @@
  * include Timestamp, bps, fps, CPU, and DSP.  For each memory
  * segment, the following keys are used: mem_seg, base, size, 
  * maxblocklen, and used.
+ *
+ * The same sample is also posted as a "dmaiperf" element message with
+ * typed fields: timestamp and interval (guint64, nanoseconds), fps
+ * (gdouble), bps (guint64), arm-load and dsp-load (gint percent, only
+ * when measured), and for the memory segments the parallel arrays
+ * mem-seg-name, mem-seg-base, mem-seg-size, mem-seg-maxblocklen and
+ * mem-seg-used.  With window-size set, the message also carries the
+ * minimum, maximum and percentile of each metric over the last
+ * window-size samples, as fps-min, fps-max, fps-percentile, and so on.
+ * The last sample can be read back through the fps, bps, arm-load,
+ * dsp-load and stats properties.
  * </refsect2>
  */
 
@@ -67,6 +81,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <gst/gst.h>
 #include <gst/video/video.h>
@@ -80,13 +95,30 @@ GST_DEBUG_CATEGORY_STATIC (gst_dmaiperf_debug);
 /* The message is variable length depending on configuration */
 #define GST_TIME_FORMAT_MAX_SIZE 4096
 
+#define DEFAULT_INTERVAL    1000
+#define DEFAULT_WINDOW_SIZE 0
+#define DEFAULT_PERCENTILE  95
 
 /* Element property identifier */
 enum
 {
   PROP_0,
   PROP_ENGINE_NAME,
-  PROP_PRINT_ARM_LOAD
+  PROP_PRINT_ARM_LOAD,
+  PROP_SERVER,
+  PROP_INTERVAL,
+  PROP_WINDOW_SIZE,
+  PROP_PERCENTILE,
+  PROP_FPS,
+  PROP_BPS,
+  PROP_ARM_LOAD,
+  PROP_DSP_LOAD,
+  PROP_STATS
+};
+
+/* Field name prefixes of the metrics in the rolling window */
+static const gchar *metric_names[GST_DMAIPERF_NUM_METRICS] = {
+  "fps", "bps", "arm-load", "dsp-load"
 };
 
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE ("sink",
@@ -114,7 +146,13 @@ static gboolean gst_dmaiperf_start (GstBaseTransform * trans);
 static gboolean gst_dmaiperf_stop (GstBaseTransform * trans);
 static void gst_dmaiperf_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
-static void gst_dmaiperf_cpu_perf (GstClockTime factor_d, GstClockTime factor_n, GstDmaiperf *dmaiperf ,Int * load);
+static void gst_dmaiperf_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_dmaiperf_finalize (GObject * object);
+static void gst_dmaiperf_sample (GstDmaiperf * dmaiperf, GstClockTime time);
+static void gst_dmaiperf_window_add (GstDmaiperf * dmaiperf,
+    GstStructure * s, const gdouble * sample, const gboolean * measured);
+static gint gst_dmaiperf_cpu_perf (GstDmaiperf * dmaiperf);
 
 /******************************************************************************
  * gst_dmaiperf_init
@@ -127,13 +165,27 @@ gst_dmaiperf_init (GstDmaiperf * dmaiperf, GstDmaiperfClass * gclass)
   dmaiperf->hDsp = NULL;
   dmaiperf->hEngine = NULL;
   dmaiperf->lastLoadstamp = GST_CLOCK_TIME_NONE;
-  dmaiperf->lastWorkload = 0;
+  dmaiperf->lastBusy = 0;
+  dmaiperf->lastTotal = 0;
   dmaiperf->fps = 0;
   dmaiperf->bps = 0;
   dmaiperf->engineName = NULL;
+  dmaiperf->hServer = NULL;
   dmaiperf->hCpu = NULL;
   dmaiperf->printArmLoad = FALSE;
+  dmaiperf->interval = DEFAULT_INTERVAL;
+  dmaiperf->windowSize = DEFAULT_WINDOW_SIZE;
+  dmaiperf->percentile = DEFAULT_PERCENTILE;
   dmaiperf->error = NULL;
+  dmaiperf->stats = NULL;
+  dmaiperf->lastFps = 0;
+  dmaiperf->lastBps = 0;
+  dmaiperf->armLoad = -1;
+  dmaiperf->dspLoad = -1;
+  dmaiperf->window = NULL;
+  dmaiperf->windowLength = 0;
+  dmaiperf->windowHead = 0;
+  dmaiperf->windowCount = 0;
 }
 
 /******************************************************************************
@@ -217,6 +269,8 @@ gst_dmaiperf_class_init (GstDmaiperfClass * klass)
   gobject_class = (GObjectClass *) klass;
 
   gobject_class->set_property = gst_dmaiperf_set_property;
+  gobject_class->get_property = gst_dmaiperf_get_property;
+  gobject_class->finalize = gst_dmaiperf_finalize;
   gobject_class = (GObjectClass *) klass;
   trans_class = (GstBaseTransformClass *) klass;
 
@@ -231,13 +285,57 @@ gst_dmaiperf_class_init (GstDmaiperfClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_ENGINE_NAME,
       g_param_spec_string ("engine-name", "engine-name",
-          "Engine Name", NULL, G_PARAM_WRITABLE));
+          "Engine Name", NULL, G_PARAM_READWRITE));
 
   g_object_class_install_property (gobject_class, PROP_PRINT_ARM_LOAD,
       g_param_spec_boolean ("print-arm-load", "print-arm-load",
-          "Print the CPU load info", FALSE, G_PARAM_WRITABLE));
+          "Print the CPU load info", FALSE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_SERVER,
+      g_param_spec_pointer ("server", "server",
+          "Server_Handle to report the DSP load and memory of, used instead "
+          "of the server of engine-name", G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_INTERVAL,
+      g_param_spec_uint ("interval", "interval",
+          "Sampling interval in milliseconds", 1, G_MAXUINT,
+          DEFAULT_INTERVAL, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_WINDOW_SIZE,
+      g_param_spec_uint ("window-size", "window-size",
+          "Number of samples to report the min, max and percentile over "
+          "(0 = off)", 0, 3600, DEFAULT_WINDOW_SIZE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_PERCENTILE,
+      g_param_spec_uint ("percentile", "percentile",
+          "Percentile to report over the window", 1, 100,
+          DEFAULT_PERCENTILE, G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_FPS,
+      g_param_spec_double ("fps", "fps",
+          "Frames per second in the last interval", 0, G_MAXDOUBLE, 0,
+          G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_BPS,
+      g_param_spec_uint64 ("bps", "bps",
+          "Bytes per second in the last interval", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_ARM_LOAD,
+      g_param_spec_int ("arm-load", "arm-load",
+          "ARM load in percent in the last interval (-1 = not measured)",
+          -1, 100, -1, G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_DSP_LOAD,
+      g_param_spec_int ("dsp-load", "dsp-load",
+          "DSP load in percent in the last interval (-1 = not measured)",
+          -1, 100, -1, G_PARAM_READABLE));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "stats",
+          "Copy of the last \"" GST_DMAIPERF_MESSAGE "\" message structure",
+          GST_TYPE_STRUCTURE, G_PARAM_READABLE));
 
-  
   GST_LOG ("initialized class init\n");
 }
 
@@ -255,6 +353,7 @@ gst_dmaiperf_set_property (GObject * object, guint prop_id,
 
   switch (prop_id) {
     case PROP_ENGINE_NAME:
+      g_free ((gpointer) dmaiperf->engineName);
       dmaiperf->engineName = g_strdup(g_value_get_string(value));
       break;
 
@@ -262,6 +361,26 @@ gst_dmaiperf_set_property (GObject * object, guint prop_id,
       dmaiperf->printArmLoad = g_value_get_boolean(value);
       break;
 
+    case PROP_SERVER:
+      dmaiperf->hServer = (Server_Handle) g_value_get_pointer (value);
+      break;
+
+    case PROP_INTERVAL:
+      dmaiperf->interval = g_value_get_uint (value);
+      break;
+
+    case PROP_WINDOW_SIZE:
+      GST_OBJECT_LOCK (dmaiperf);
+      dmaiperf->windowSize = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (dmaiperf);
+      break;
+
+    case PROP_PERCENTILE:
+      GST_OBJECT_LOCK (dmaiperf);
+      dmaiperf->percentile = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (dmaiperf);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -270,6 +389,101 @@ gst_dmaiperf_set_property (GObject * object, guint prop_id,
   GST_LOG ("end set_property\n");
 }
 
+/******************************************************************************
+ * gst_dmaiperf_get_property
+ *     Return values for requested element property.
+ ******************************************************************************/
+static void
+gst_dmaiperf_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstDmaiperf *dmaiperf = GST_DMAIPERF (object);
+
+  GST_LOG ("begin get_property\n");
+
+  switch (prop_id) {
+    case PROP_ENGINE_NAME:
+      g_value_set_string (value, dmaiperf->engineName);
+      break;
+
+    case PROP_PRINT_ARM_LOAD:
+      g_value_set_boolean (value, dmaiperf->printArmLoad);
+      break;
+
+    case PROP_SERVER:
+      g_value_set_pointer (value, dmaiperf->hServer);
+      break;
+
+    case PROP_INTERVAL:
+      g_value_set_uint (value, dmaiperf->interval);
+      break;
+
+    case PROP_WINDOW_SIZE:
+      g_value_set_uint (value, dmaiperf->windowSize);
+      break;
+
+    case PROP_PERCENTILE:
+      g_value_set_uint (value, dmaiperf->percentile);
+      break;
+
+    case PROP_FPS:
+      GST_OBJECT_LOCK (dmaiperf);
+      g_value_set_double (value, dmaiperf->lastFps);
+      GST_OBJECT_UNLOCK (dmaiperf);
+      break;
+
+    case PROP_BPS:
+      GST_OBJECT_LOCK (dmaiperf);
+      g_value_set_uint64 (value, dmaiperf->lastBps);
+      GST_OBJECT_UNLOCK (dmaiperf);
+      break;
+
+    case PROP_ARM_LOAD:
+      GST_OBJECT_LOCK (dmaiperf);
+      g_value_set_int (value, dmaiperf->armLoad);
+      GST_OBJECT_UNLOCK (dmaiperf);
+      break;
+
+    case PROP_DSP_LOAD:
+      GST_OBJECT_LOCK (dmaiperf);
+      g_value_set_int (value, dmaiperf->dspLoad);
+      GST_OBJECT_UNLOCK (dmaiperf);
+      break;
+
+    case PROP_STATS:
+      GST_OBJECT_LOCK (dmaiperf);
+      g_value_set_boxed (value, dmaiperf->stats);
+      GST_OBJECT_UNLOCK (dmaiperf);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+
+  GST_LOG ("end get_property\n");
+}
+
+/******************************************************************************
+ * gst_dmaiperf_finalize
+ *     Free the element properties and the last sample.
+ ******************************************************************************/
+static void
+gst_dmaiperf_finalize (GObject * object)
+{
+  GstDmaiperf *dmaiperf = GST_DMAIPERF (object);
+
+  g_free ((gpointer) dmaiperf->engineName);
+  dmaiperf->engineName = NULL;
+
+  if (dmaiperf->stats) {
+    gst_structure_free (dmaiperf->stats);
+    dmaiperf->stats = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 /******************************************************************************
  * gst_dmaiperf_start
  *    Start measuring pipeline performance
@@ -279,8 +493,12 @@ gst_dmaiperf_start (GstBaseTransform * trans)
 {
   GstDmaiperf *dmaiperf = (GstDmaiperf *) trans;
 
-  /* Make sure we know what codec we're using */
-  if (!dmaiperf->engineName) {
+  /* A server handed to us is used as is; otherwise ask the engine */
+  dmaiperf->hDsp = dmaiperf->hServer;
+
+  if (dmaiperf->hDsp) {
+    GST_INFO ("reporting on the server set through the \"server\" property");
+  } else if (!dmaiperf->engineName) {
     GST_ELEMENT_WARNING (dmaiperf, STREAM, CODEC_NOT_FOUND, (NULL),
         ("Engine name not specified, not printing DSP information"));
   } else {
@@ -299,16 +517,39 @@ gst_dmaiperf_start (GstBaseTransform * trans)
               ("Failed to open the DSP Server handler, unable to report DSP load"));
         } else {
           GST_ELEMENT_INFO (dmaiperf, STREAM, ENCODE, (NULL),
-              ("Printing DSP load every 1 second..."));
+              ("Printing DSP load every %u ms...", dmaiperf->interval));
         }
       }
   }
 
+  dmaiperf->lastLoadstamp = GST_CLOCK_TIME_NONE;
+  dmaiperf->lastBusy = 0;
+  dmaiperf->lastTotal = 0;
+  dmaiperf->fps = 0;
+  dmaiperf->bps = 0;
+  dmaiperf->windowHead = 0;
+  dmaiperf->windowCount = 0;
+
   if (dmaiperf->printArmLoad){
     Cpu_Attrs cpuAttrs = Cpu_Attrs_DEFAULT;
     dmaiperf->hCpu = Cpu_create(&cpuAttrs);
+
+    /* Read /proc/stat once so the first sample has a baseline */
+    if (dmaiperf->hCpu)
+      gst_dmaiperf_cpu_perf (dmaiperf);
   }
 
+  GST_OBJECT_LOCK (dmaiperf);
+  dmaiperf->lastFps = 0;
+  dmaiperf->lastBps = 0;
+  dmaiperf->armLoad = -1;
+  dmaiperf->dspLoad = -1;
+  if (dmaiperf->stats) {
+    gst_structure_free (dmaiperf->stats);
+    dmaiperf->stats = NULL;
+  }
+  GST_OBJECT_UNLOCK (dmaiperf);
+
   dmaiperf->error = g_error_new(GST_CORE_ERROR,GST_CORE_ERROR_TAG,"Performance Information");
 
   return TRUE;
@@ -323,12 +564,11 @@ static gboolean
 gst_dmaiperf_stop (GstBaseTransform * trans)
 {
   GstDmaiperf *dmaiperf = (GstDmaiperf *) trans;
-  if(dmaiperf->engineName){
-    g_free((gpointer)dmaiperf->engineName);
-  }
 
-  if (dmaiperf->error)
+  if (dmaiperf->error) {
     g_error_free(dmaiperf->error);
+    dmaiperf->error = NULL;
+  }
 
   if (dmaiperf->hEngine) {
     GST_DEBUG ("closing the engine\n");
@@ -345,112 +585,323 @@ gst_dmaiperf_stop (GstBaseTransform * trans)
     dmaiperf->hCpu = NULL;
   }
 
+  g_free (dmaiperf->window);
+  dmaiperf->window = NULL;
+  dmaiperf->windowLength = 0;
+
   return TRUE;
 }
 
 
 /******************************************************************************
- * gst_tividresize_transform
-  *    Transforms one incoming buffer to one outgoing buffer.
-   *****************************************************************************/
+ * gst_dmaiperf_transform_ip
+ *    Count the buffer, and take a sample once the interval is over.  The
+ *    first buffer only starts the first interval.
+ *****************************************************************************/
 static GstFlowReturn
 gst_dmaiperf_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
 {
   GstDmaiperf *dmaiperf = GST_DMAIPERF (trans);
+  GstClockTime time;
+
   GST_LOG ("Transform function\n");
 
-  GstClockTime time = gst_util_get_timestamp ();
-  if (!GST_CLOCK_TIME_IS_VALID (dmaiperf->lastLoadstamp) ||
-        (GST_CLOCK_TIME_IS_VALID (time) &&
-            GST_CLOCK_DIFF (dmaiperf->lastLoadstamp, time) > GST_SECOND)) {
-      gchar info[GST_TIME_FORMAT_MAX_SIZE];
-      gint idx;
-      /*Real data per second: Time spent / unit (1000msec)*/
-      
-      GstClockTime factor_n = GST_TIME_AS_MSECONDS(GST_CLOCK_DIFF (dmaiperf->lastLoadstamp, time));
-      GstClockTime factor_d = GST_TIME_AS_MSECONDS(GST_SECOND);
-      
-      idx = g_snprintf (info, GST_TIME_FORMAT_MAX_SIZE, "Timestamp: %" GST_TIME_FORMAT"; "
-          "bps: %llu; "
-          "fps: %llu; ",
-          GST_TIME_ARGS (time), (dmaiperf->bps * factor_d / factor_n), (dmaiperf->fps * factor_d / factor_n));
-
-      dmaiperf->fps = 0;
-      dmaiperf->bps = 0;
-
-      if (dmaiperf->hCpu){
-          Int load;
-          gst_dmaiperf_cpu_perf(factor_d, factor_n, dmaiperf, &load);
-          idx += g_snprintf (&info[idx], GST_TIME_FORMAT_MAX_SIZE - idx,
-              "CPU: %d; ",load);
-      }
+  time = gst_util_get_timestamp ();
+  if (!GST_CLOCK_TIME_IS_VALID (dmaiperf->lastLoadstamp)) {
+    dmaiperf->lastLoadstamp = time;
+  } else if (GST_CLOCK_DIFF (dmaiperf->lastLoadstamp, time) >=
+        (GstClockTimeDiff) dmaiperf->interval * GST_MSECOND) {
+    gst_dmaiperf_sample (dmaiperf, time);
+    dmaiperf->lastLoadstamp = time;
+  }
 
-      if (dmaiperf->hDsp) {
-          gint32 nsegs, i;
-          guint32 load = Server_getCpuLoad (dmaiperf->hDsp);
-          idx += g_snprintf (&info[idx], GST_TIME_FORMAT_MAX_SIZE-idx,
-              "DSP: %d; ", load);
-
-          Server_getNumMemSegs (dmaiperf->hDsp, &nsegs);
-          for (i = 0; i < nsegs; i++) {
-            Server_MemStat ms;
-            Server_getMemStat (dmaiperf->hDsp, i, &ms);
-            idx += g_snprintf (&info[idx], GST_TIME_FORMAT_MAX_SIZE - idx,
-                "mem_seg: %s; base: 0x%x; size: 0x%x; maxblocklen: 0x%x; used: 0x%x; ",
-                ms.name, (unsigned int) ms.base, (unsigned int) ms.size,
-                (unsigned int) ms.maxBlockLen, (unsigned int) ms.used);
-          }
-      }
+  dmaiperf->fps++;
+  dmaiperf->bps+= GST_BUFFER_SIZE(buf);
+
+  return GST_FLOW_OK;
+}
+
+/******************************************************************************
+ * gst_dmaiperf_array_append_string
+ * gst_dmaiperf_array_append_uint
+ *    Append one value to a GST_TYPE_ARRAY.
+ *****************************************************************************/
+static void
+gst_dmaiperf_array_append_string (GValue * array, const gchar * str)
+{
+  GValue value = { 0, };
 
-      if (idx ==  GST_TIME_FORMAT_MAX_SIZE){
-	/* more info than buffer can hold, make sure it has reasonable termination. */
-	info[GST_TIME_FORMAT_MAX_SIZE - 2] = '*';
-	info[GST_TIME_FORMAT_MAX_SIZE - 1] = '\0';
+  g_value_init (&value, G_TYPE_STRING);
+  g_value_set_string (&value, str);
+  gst_value_array_append_value (array, &value);
+  g_value_unset (&value);
+}
+
+static void
+gst_dmaiperf_array_append_uint (GValue * array, guint val)
+{
+  GValue value = { 0, };
+
+  g_value_init (&value, G_TYPE_UINT);
+  g_value_set_uint (&value, val);
+  gst_value_array_append_value (array, &value);
+  g_value_unset (&value);
+}
+
+/******************************************************************************
+ * gst_dmaiperf_sample
+ *    Measure the interval that ends at time, and post the result as an info
+ *    string and as a "dmaiperf" element message.
+ *****************************************************************************/
+static void
+gst_dmaiperf_sample (GstDmaiperf * dmaiperf, GstClockTime time)
+{
+  GstClockTimeDiff elapsed = GST_CLOCK_DIFF (dmaiperf->lastLoadstamp, time);
+  gdouble sample[GST_DMAIPERF_NUM_METRICS];
+  gboolean measured[GST_DMAIPERF_NUM_METRICS];
+  gchar info[GST_TIME_FORMAT_MAX_SIZE];
+  GstStructure *s;
+  gdouble fps;
+  guint64 bps;
+  gint armLoad = -1;
+  gint dspLoad = -1;
+  gint idx;
+
+  fps = (gdouble) dmaiperf->fps * GST_SECOND / elapsed;
+  bps = gst_util_uint64_scale (dmaiperf->bps, GST_SECOND, elapsed);
+  dmaiperf->fps = 0;
+  dmaiperf->bps = 0;
+
+  s = gst_structure_new (GST_DMAIPERF_MESSAGE,
+      "timestamp", G_TYPE_UINT64, (guint64) time,
+      "interval", G_TYPE_UINT64, (guint64) elapsed,
+      "fps", G_TYPE_DOUBLE, fps,
+      "bps", G_TYPE_UINT64, bps, NULL);
+
+  idx = g_snprintf (info, GST_TIME_FORMAT_MAX_SIZE, "Timestamp: %" GST_TIME_FORMAT"; "
+      "bps: %llu; "
+      "fps: %llu; ",
+      GST_TIME_ARGS (time), (unsigned long long) bps,
+      (unsigned long long) fps);
+
+  if (dmaiperf->hCpu){
+      armLoad = gst_dmaiperf_cpu_perf (dmaiperf);
+      gst_structure_set (s, "arm-load", G_TYPE_INT, armLoad, NULL);
+      idx += g_snprintf (&info[idx], GST_TIME_FORMAT_MAX_SIZE - idx,
+          "CPU: %d; ",armLoad);
+  }
+
+  if (dmaiperf->hDsp) {
+      GValue names = { 0, };
+      GValue bases = { 0, };
+      GValue sizes = { 0, };
+      GValue maxBlockLens = { 0, };
+      GValue useds = { 0, };
+      Int nsegs = 0;
+      Int i;
+
+      dspLoad = Server_getCpuLoad (dmaiperf->hDsp);
+      gst_structure_set (s, "dsp-load", G_TYPE_INT, dspLoad, NULL);
+      idx = MIN (idx, GST_TIME_FORMAT_MAX_SIZE - 1);
+      idx += g_snprintf (&info[idx], GST_TIME_FORMAT_MAX_SIZE-idx,
+          "DSP: %d; ", dspLoad);
+
+      g_value_init (&names, GST_TYPE_ARRAY);
+      g_value_init (&bases, GST_TYPE_ARRAY);
+      g_value_init (&sizes, GST_TYPE_ARRAY);
+      g_value_init (&maxBlockLens, GST_TYPE_ARRAY);
+      g_value_init (&useds, GST_TYPE_ARRAY);
+
+      if (Server_getNumMemSegs (dmaiperf->hDsp, &nsegs) != Server_EOK)
+        nsegs = 0;
+
+      for (i = 0; i < nsegs; i++) {
+        Server_MemStat ms;
+
+        if (Server_getMemStat (dmaiperf->hDsp, i, &ms) != Server_EOK)
+          continue;
+
+        gst_dmaiperf_array_append_string (&names, ms.name);
+        gst_dmaiperf_array_append_uint (&bases, ms.base);
+        gst_dmaiperf_array_append_uint (&sizes, ms.size);
+        gst_dmaiperf_array_append_uint (&maxBlockLens, ms.maxBlockLen);
+        gst_dmaiperf_array_append_uint (&useds, ms.used);
+
+        idx = MIN (idx, GST_TIME_FORMAT_MAX_SIZE - 1);
+        idx += g_snprintf (&info[idx], GST_TIME_FORMAT_MAX_SIZE - idx,
+            "mem_seg: %s; base: 0x%x; size: 0x%x; maxblocklen: 0x%x; used: 0x%x; ",
+            ms.name, (unsigned int) ms.base, (unsigned int) ms.size,
+            (unsigned int) ms.maxBlockLen, (unsigned int) ms.used);
       }
 
-      gst_element_post_message(
-        (GstElement *)dmaiperf,
-        gst_message_new_info((GstObject *)dmaiperf, dmaiperf->error, 
-          (const gchar *)info));
-      dmaiperf->lastLoadstamp = time;
+      gst_structure_set_value (s, "mem-seg-name", &names);
+      gst_structure_set_value (s, "mem-seg-base", &bases);
+      gst_structure_set_value (s, "mem-seg-size", &sizes);
+      gst_structure_set_value (s, "mem-seg-maxblocklen", &maxBlockLens);
+      gst_structure_set_value (s, "mem-seg-used", &useds);
+
+      g_value_unset (&names);
+      g_value_unset (&bases);
+      g_value_unset (&sizes);
+      g_value_unset (&maxBlockLens);
+      g_value_unset (&useds);
   }
 
-  dmaiperf->fps++;
-  dmaiperf->bps+= GST_BUFFER_SIZE(buf);
+  if (idx >= GST_TIME_FORMAT_MAX_SIZE - 1){
+    /* more info than buffer can hold, make sure it has reasonable termination. */
+    info[GST_TIME_FORMAT_MAX_SIZE - 2] = '*';
+    info[GST_TIME_FORMAT_MAX_SIZE - 1] = '\0';
+  }
 
-  return GST_FLOW_OK;;
+  sample[GST_DMAIPERF_FPS] = fps;
+  sample[GST_DMAIPERF_BPS] = bps;
+  sample[GST_DMAIPERF_ARM_LOAD] = armLoad;
+  sample[GST_DMAIPERF_DSP_LOAD] = dspLoad;
+  measured[GST_DMAIPERF_FPS] = TRUE;
+  measured[GST_DMAIPERF_BPS] = TRUE;
+  measured[GST_DMAIPERF_ARM_LOAD] = dmaiperf->hCpu != NULL;
+  measured[GST_DMAIPERF_DSP_LOAD] = dmaiperf->hDsp != NULL;
+  gst_dmaiperf_window_add (dmaiperf, s, sample, measured);
+
+  GST_OBJECT_LOCK (dmaiperf);
+  dmaiperf->lastFps = fps;
+  dmaiperf->lastBps = bps;
+  dmaiperf->armLoad = armLoad;
+  dmaiperf->dspLoad = dspLoad;
+  if (dmaiperf->stats)
+    gst_structure_free (dmaiperf->stats);
+  dmaiperf->stats = gst_structure_copy (s);
+  GST_OBJECT_UNLOCK (dmaiperf);
+
+  gst_element_post_message(
+    (GstElement *)dmaiperf,
+    gst_message_new_info((GstObject *)dmaiperf, dmaiperf->error, 
+      (const gchar *)info));
+  gst_element_post_message ((GstElement *) dmaiperf,
+      gst_message_new_element ((GstObject *) dmaiperf, s));
 }
 
 /****************************************************************************
-* gst_dmaiperf_cpu_perf
-*    Returns the cpu's workload
+* gst_dmaiperf_compare
+*    qsort comparison of two samples.
+*****************************************************************************/
+static int
+gst_dmaiperf_compare (const void *a, const void *b)
+{
+  gdouble x = *(const gdouble *) a;
+  gdouble y = *(const gdouble *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/****************************************************************************
+* gst_dmaiperf_window_add
+*    Add a sample to the rolling window and add the min, max and percentile
+*    of each measured metric over the window to s.  The window starts over
+*    when window-size changes.
 *****************************************************************************/
 static void
-gst_dmaiperf_cpu_perf (GstClockTime factor_d, GstClockTime factor_n,
-                        GstDmaiperf *dmaiperf, Int * load)
+gst_dmaiperf_window_add (GstDmaiperf * dmaiperf, GstStructure * s,
+    const gdouble * sample, const gboolean * measured)
 {
-    FILE * pStat;
+  gdouble *sorted;
+  guint windowSize, percentile, rank;
+  guint metric, i;
+
+  GST_OBJECT_LOCK (dmaiperf);
+  windowSize = dmaiperf->windowSize;
+  percentile = dmaiperf->percentile;
+  GST_OBJECT_UNLOCK (dmaiperf);
+
+  if (windowSize != dmaiperf->windowLength) {
+    g_free (dmaiperf->window);
+    dmaiperf->window = g_new (gdouble, windowSize * GST_DMAIPERF_NUM_METRICS);
+    dmaiperf->windowLength = windowSize;
+    dmaiperf->windowHead = 0;
+    dmaiperf->windowCount = 0;
+  }
+
+  if (windowSize == 0)
+    return;
+
+  memcpy (&dmaiperf->window[dmaiperf->windowHead * GST_DMAIPERF_NUM_METRICS],
+      sample, GST_DMAIPERF_NUM_METRICS * sizeof (gdouble));
+  dmaiperf->windowHead = (dmaiperf->windowHead + 1) % windowSize;
+  if (dmaiperf->windowCount < windowSize)
+    dmaiperf->windowCount++;
+
+  /* Nearest rank: the smallest sample with percentile % at or below it */
+  rank = (percentile * dmaiperf->windowCount + 99) / 100;
+  rank = CLAMP (rank, 1, dmaiperf->windowCount);
+
+  gst_structure_set (s,
+      "window-size", G_TYPE_UINT, dmaiperf->windowCount,
+      "percentile", G_TYPE_UINT, percentile, NULL);
+
+  sorted = g_new (gdouble, dmaiperf->windowCount);
+  for (metric = 0; metric < GST_DMAIPERF_NUM_METRICS; metric++) {
+    gchar *field;
 
-    char str[4];
-    int workload[7];
-    int totalWorkload;
+    if (!measured[metric])
+      continue;
+
+    for (i = 0; i < dmaiperf->windowCount; i++)
+      sorted[i] = dmaiperf->window[i * GST_DMAIPERF_NUM_METRICS + metric];
+    qsort (sorted, dmaiperf->windowCount, sizeof (gdouble),
+        gst_dmaiperf_compare);
+
+    field = g_strdup_printf ("%s-min", metric_names[metric]);
+    gst_structure_set (s, field, G_TYPE_DOUBLE, sorted[0], NULL);
+    g_free (field);
+
+    field = g_strdup_printf ("%s-max", metric_names[metric]);
+    gst_structure_set (s, field, G_TYPE_DOUBLE,
+        sorted[dmaiperf->windowCount - 1], NULL);
+    g_free (field);
+
+    field = g_strdup_printf ("%s-percentile", metric_names[metric]);
+    gst_structure_set (s, field, G_TYPE_DOUBLE, sorted[rank - 1], NULL);
+    g_free (field);
+  }
+  g_free (sorted);
+}
+
+/****************************************************************************
+* gst_dmaiperf_cpu_perf
+*    Returns the ARM load in percent since the last call, from the busy and
+*    total jiffies in /proc/stat.
+*****************************************************************************/
+static gint
+gst_dmaiperf_cpu_perf (GstDmaiperf * dmaiperf)
+{
+    FILE * pStat;
+    unsigned long long workload[7];
+    guint64 busy, total;
+    gint load = 0;
 
     pStat = fopen ("/proc/stat", "r");
-    if ( fscanf (pStat,"%s%d%d%d%d%d%d%d", &str[0], &workload[0], &workload[1],
-                 &workload[2], &workload[3], &workload[4], &workload[5],
-                 &workload[6]) != 8){
+    if (pStat == NULL ||
+        fscanf (pStat,"%*s%llu%llu%llu%llu%llu%llu%llu", &workload[0],
+                &workload[1], &workload[2], &workload[3], &workload[4],
+                &workload[5], &workload[6]) != 7){
         GST_ELEMENT_WARNING (dmaiperf, STREAM, ENCODE, (NULL),
               ("can't read /proc/stat\n"));
-        dmaiperf->lastWorkload = 0;
-        *load = 0;
-    } else {
-        totalWorkload =  workload[0] + workload[1] + workload[2] + workload[5] + workload[6];
-        if (dmaiperf->lastWorkload != 0){
-            *load = (totalWorkload - dmaiperf->lastWorkload) * factor_d / factor_n;
-        } else {
-            *load = 0;
-        }
-        dmaiperf->lastWorkload = totalWorkload;
+        if (pStat)
+            fclose (pStat);
+        dmaiperf->lastTotal = 0;
+        return 0;
     }
     fclose (pStat);
+
+    /* user, nice, system, irq and softirq are busy; idle and iowait not */
+    busy = workload[0] + workload[1] + workload[2] + workload[5] + workload[6];
+    total = busy + workload[3] + workload[4];
+    if (dmaiperf->lastTotal != 0 && total > dmaiperf->lastTotal){
+        load = (busy - dmaiperf->lastBusy) * 100 /
+            (total - dmaiperf->lastTotal);
+    }
+    dmaiperf->lastBusy = busy;
+    dmaiperf->lastTotal = total;
+
+    return load;
 }
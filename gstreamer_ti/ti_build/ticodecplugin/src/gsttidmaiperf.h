@@ -50,6 +50,19 @@ G_BEGIN_DECLS
 typedef struct _GstDmaiperf      GstDmaiperf;
 typedef struct _GstDmaiperfClass GstDmaiperfClass;
 
+/* Name of the element message posted with each sample */
+#define GST_DMAIPERF_MESSAGE "dmaiperf"
+
+/* Metrics kept in the rolling window */
+enum
+{
+  GST_DMAIPERF_FPS,
+  GST_DMAIPERF_BPS,
+  GST_DMAIPERF_ARM_LOAD,
+  GST_DMAIPERF_DSP_LOAD,
+  GST_DMAIPERF_NUM_METRICS
+};
+
 /* _GstDmaiperf object */
 struct _GstDmaiperf
 {
@@ -61,15 +74,35 @@ struct _GstDmaiperf
   Server_Handle     hDsp;
   Engine_Handle     hEngine;
   Cpu_Handle        hCpu;
-  const gchar       *engineName;
   GError            *error;
 
   /* Element property */
+  const gchar       *engineName;
+  Server_Handle     hServer;
+  gboolean          printArmLoad;
+  guint             interval;
+  guint             windowSize;
+  guint             percentile;
+
+  /* Counters for the current interval */
   GstClockTime      lastLoadstamp;
-  int               lastWorkload;
+  guint64           lastBusy;
+  guint64           lastTotal;
   guint32           fps;
-  guint32           bps;
-  gboolean          printArmLoad;
+  guint64           bps;
+
+  /* Last sample, guarded by the object lock */
+  GstStructure      *stats;
+  gdouble           lastFps;
+  guint64           lastBps;
+  gint              armLoad;
+  gint              dspLoad;
+
+  /* Rolling window of the last windowLength samples of each metric */
+  gdouble           *window;
+  guint             windowLength;
+  guint             windowHead;
+  guint             windowCount;
 };
 
 /* _GstDmaiperfClass object */
@@ -67,9 +67,22 @@ enum
   PROP_ICOLORSPACE,     /* iColorSpace    (string)  */
   PROP_OCOLORSPACE,     /* oColorSpace    (string)  */
   PROP_DISPLAY_BUFFER,  /* displayBuffer  (boolean) */
-  PROP_GEN_TIMESTAMPS   /* genTimeStamps  (boolean) */
+  PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
+  PROP_BATCH_SIZE,      /* batchSize      (int)     */
+  PROP_RTCODECTHREAD,   /* rtCodecThread  (boolean) */
+  PROP_THROUGHPUT       /* throughput     (double)  */
 };
 
+#define     DEFAULT_BATCH_SIZE          1
+#define     DEFAULT_RTCODECTHREAD       TRUE
+
+/* A qValue override, for the first frame queued after offset bytes */
+typedef struct _GstTIImgenc1QValue
+{
+  guint64       offset;
+  gint          qValue;
+} GstTIImgenc1QValue;
+
 /* Codec Attributes for conversion function */
 enum
 {
@@ -132,6 +145,8 @@ static void
  gst_tiimgenc1_class_init(GstTIImgenc1Class *g_class);
 static void
  gst_tiimgenc1_init(GstTIImgenc1 *object, GstTIImgenc1Class *g_class);
+static void
+ gst_tiimgenc1_dispose(GObject * object);
 static void
  gst_tiimgenc1_set_property (GObject *object, guint prop_id,
      const GValue *value, GParamSpec *pspec);
@@ -176,6 +191,14 @@ static void
     gst_tiimgenc1_string_cap(gchar *str);
 static void 
     gst_tiimgenc1_init_env(GstTIImgenc1 *imgenc1);
+static gboolean
+    gst_tiimgenc1_queue_qvalue(GstTIImgenc1 *imgenc1, GstEvent *event);
+static XDAS_Int32
+    gst_tiimgenc1_frame_qvalue(GstTIImgenc1 *imgenc1);
+static gboolean
+    gst_tiimgenc1_set_qvalue(GstTIImgenc1 *imgenc1, XDAS_Int32 qValue);
+static void
+    gst_tiimgenc1_rebase_qvalues(GstTIImgenc1 *imgenc1, guint64 bytesQueued);
 /******************************************************************************
  * gst_tiimgenc1_class_init_trampoline
  *    Boiler-plate function auto-generated by "make_element" script.
@@ -252,6 +275,28 @@ static void gst_tiimgenc1_base_init(gpointer gclass)
 }
 
 
+/******************************************************************************
+ * gst_tiimgenc1_dispose
+ *****************************************************************************/
+static void gst_tiimgenc1_dispose(GObject * object)
+{
+    GstTIImgenc1 *imgenc1 = GST_TIIMGENC1(object);
+
+    if (imgenc1->qValueQueue) {
+        gst_tiimgenc1_rebase_qvalues(imgenc1, G_MAXUINT64);
+        g_queue_free(imgenc1->qValueQueue);
+        imgenc1->qValueQueue = NULL;
+    }
+
+    if (imgenc1->qValueLock) {
+        g_mutex_free(imgenc1->qValueLock);
+        imgenc1->qValueLock = NULL;
+    }
+
+    G_OBJECT_CLASS(parent_class)->dispose (object);
+}
+
+
 /******************************************************************************
  * gst_tiimgenc1_class_init
  *    Boiler-plate function auto-generated by "make_element" script.
@@ -269,6 +314,7 @@ static void gst_tiimgenc1_class_init(GstTIImgenc1Class *klass)
 
     gobject_class->set_property = gst_tiimgenc1_set_property;
     gobject_class->get_property = gst_tiimgenc1_get_property;
+    gobject_class->dispose      = GST_DEBUG_FUNCPTR(gst_tiimgenc1_dispose);
 
     gstelement_class->change_state = gst_tiimgenc1_change_state;
 
@@ -337,6 +383,29 @@ static void gst_tiimgenc1_class_init(GstTIImgenc1Class *klass)
             "Set timestamps on output buffers",
             TRUE, G_PARAM_WRITABLE));
 
+    /* Snapshot pipelines hand us frames in bursts.  Queue a batch of them
+     * ahead of the codec so upstream is not held up while one is encoded,
+     * and keep as many output buffers so the codec can go on while the
+     * previous images are still being written out downstream.
+     */
+    g_object_class_install_property(gobject_class, PROP_BATCH_SIZE,
+        g_param_spec_int("batchSize",
+            "Batch size",
+            "Number of input frames queued ahead of the codec, and of output "
+            "buffers in flight unless numOutputBufs is set.  1 encodes one "
+            "frame at a time",
+            1, G_MAXINT32, DEFAULT_BATCH_SIZE, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_RTCODECTHREAD,
+        g_param_spec_boolean("RTCodecThread", "Real time codec thread",
+            "Exectue codec calls in real-time thread",
+            DEFAULT_RTCODECTHREAD, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_THROUGHPUT,
+        g_param_spec_double("throughput", "Encoded frames per second",
+            "Frames encoded per second over the current or last stream",
+            0, G_MAXDOUBLE, 0, G_PARAM_READABLE));
+
     GST_LOG("Finish\n");
 }
 
@@ -412,6 +481,18 @@ static void gst_tiimgenc1_init_env(GstTIImgenc1 *imgenc1)
                 &imgenc1->width,&imgenc1->height);
         GST_LOG("Setting resolution=%dx%d\n", imgenc1->width, imgenc1->height);
     }
+
+    if (gst_ti_env_is_defined("GST_TI_TIImgenc1_batchSize")) {
+        imgenc1->batchSize = gst_ti_env_get_int("GST_TI_TIImgenc1_batchSize");
+        GST_LOG("Setting batchSize=%d\n", imgenc1->batchSize);
+    }
+
+    if (gst_ti_env_is_defined("GST_TI_TIImgenc1_RTCodecThread")) {
+        imgenc1->rtCodecThread = 
+                gst_ti_env_get_boolean("GST_TI_TIImgenc1_RTCodecThread");
+        GST_LOG("Setting RTCodecThread =%s\n", 
+                    imgenc1->rtCodecThread ? "TRUE" : "FALSE");
+    }
     
     GST_LOG("gst_tiimgenc1_init_env - end");
 }
@@ -465,6 +546,8 @@ static void gst_tiimgenc1_init(GstTIImgenc1 *imgenc1, GstTIImgenc1Class *gclass)
     imgenc1->iColor             = NULL;
     imgenc1->oColor             = NULL;
     imgenc1->qValue             = 0;
+    imgenc1->batchSize          = DEFAULT_BATCH_SIZE;
+    imgenc1->rtCodecThread      = DEFAULT_RTCODECTHREAD;
     imgenc1->width              = 0;
     imgenc1->height             = 0;
 
@@ -483,6 +566,15 @@ static void gst_tiimgenc1_init(GstTIImgenc1 *imgenc1, GstTIImgenc1Class *gclass)
     imgenc1->numOutputBufs      = 0UL;
     imgenc1->hOutBufTab         = NULL;
     imgenc1->circBuf            = NULL;
+    imgenc1->hInBuf             = NULL;
+
+    imgenc1->qValueLock         = g_mutex_new();
+    imgenc1->qValueQueue        = g_queue_new();
+    imgenc1->baseQValue         = 0;
+
+    imgenc1->numFramesEncoded   = 0;
+    imgenc1->firstFrameTime     = GST_CLOCK_TIME_NONE;
+    imgenc1->lastFrameTime      = GST_CLOCK_TIME_NONE;
 
     gst_tiimgenc1_init_env(imgenc1);
 
@@ -590,6 +682,16 @@ static void gst_tiimgenc1_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"genTimeStamps\" to \"%s\"\n",
                 imgenc1->genTimeStamps ? "TRUE" : "FALSE");
             break;
+        case PROP_BATCH_SIZE:
+            imgenc1->batchSize = g_value_get_int(value);
+            GST_LOG("setting \"batchSize\" to \"%d\"\n",
+                imgenc1->batchSize);
+            break;
+        case PROP_RTCODECTHREAD:
+            imgenc1->rtCodecThread = g_value_get_boolean(value);
+            GST_LOG("setting \"RTCodecThread\" to \"%s\"\n",
+                imgenc1->rtCodecThread ? "TRUE" : "FALSE");
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -625,6 +727,23 @@ static void gst_tiimgenc1_get_property(GObject *object, guint prop_id,
         case PROP_ICOLORSPACE:
             g_value_set_string(value, imgenc1->iColor);
             break;
+        case PROP_BATCH_SIZE:
+            g_value_set_int(value, imgenc1->batchSize);
+            break;
+        case PROP_RTCODECTHREAD:
+            g_value_set_boolean(value, imgenc1->rtCodecThread);
+            break;
+        case PROP_THROUGHPUT:
+            if (imgenc1->numFramesEncoded > 0 &&
+                imgenc1->lastFrameTime > imgenc1->firstFrameTime) {
+                g_value_set_double(value,
+                    (gdouble) imgenc1->numFramesEncoded * GST_SECOND /
+                    (imgenc1->lastFrameTime - imgenc1->firstFrameTime));
+            }
+            else {
+                g_value_set_double(value, 0);
+            }
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -651,7 +770,7 @@ static gboolean gst_tiimgenc1_set_sink_caps_helper(GstPad *pad, GstCaps *caps)
 
     GST_LOG("Begin\n");
 
-    imgenc1   = GST_TIIMGENC1(gst_pad_get_parent(pad));
+    imgenc1   = GST_TIIMGENC1(GST_OBJECT_PARENT(pad));
 
     /* Determine which device the application is running on */
     if (Cpu_getDevice(NULL, &device) < 0) {
@@ -777,15 +896,13 @@ static gboolean gst_tiimgenc1_set_sink_caps_helper(GstPad *pad, GstCaps *caps)
 static gboolean gst_tiimgenc1_set_sink_caps(GstPad *pad, GstCaps *caps)
 {
     GstTIImgenc1 *imgenc1;
-    imgenc1   = GST_TIIMGENC1(gst_pad_get_parent(pad));
+    imgenc1   = GST_TIIMGENC1(GST_OBJECT_PARENT(pad));
 
     GST_LOG("Begin\n");
 
-    /* If this call fails then unref the gobject */
     if (!gst_tiimgenc1_set_sink_caps_helper(pad, caps)) {
         GST_ELEMENT_ERROR(imgenc1, STREAM, NOT_IMPLEMENTED,
         ("stream type not supported"), (NULL));
-        gst_object_unref(imgenc1);
         return FALSE;
     }
 
@@ -884,11 +1001,20 @@ static gboolean gst_tiimgenc1_sink_event(GstPad *pad, GstEvent *event)
             ret = gst_pad_push_event(imgenc1->srcpad, event);
             break;
 
+        case GST_EVENT_CUSTOM_DOWNSTREAM:
+            /* A qValue override for the next frame stops here */
+            if (gst_event_has_name(event, GST_TIIMGENC1_QVALUE_EVENT)) {
+                ret = gst_tiimgenc1_queue_qvalue(imgenc1, event);
+                gst_event_unref(event);
+                break;
+            }
+            ret = gst_pad_event_default(pad, event);
+            break;
+
         /* Unhandled events */
         case GST_EVENT_BUFFERSIZE:
         case GST_EVENT_CUSTOM_BOTH:
         case GST_EVENT_CUSTOM_BOTH_OOB:
-        case GST_EVENT_CUSTOM_DOWNSTREAM:
         case GST_EVENT_CUSTOM_DOWNSTREAM_OOB:
         case GST_EVENT_CUSTOM_UPSTREAM:
         case GST_EVENT_FLUSH_START:
@@ -973,6 +1099,123 @@ exit:
     return flow;
 }
 
+
+/******************************************************************************
+ * gst_tiimgenc1_queue_qvalue
+ *    Record the qValue override carried by event for the next frame queued.
+ *    Overrides are kept by stream offset, as the frame they apply to may not
+ *    reach the codec until the frames batched before it are encoded.
+ ******************************************************************************/
+static gboolean gst_tiimgenc1_queue_qvalue(GstTIImgenc1 *imgenc1,
+                    GstEvent *event)
+{
+    const GstStructure *structure = gst_event_get_structure(event);
+    GstTIImgenc1QValue *entry;
+    gint                qValue;
+
+    if (!gst_structure_get_int(structure, "qValue", &qValue) ||
+        qValue < 1 || qValue > 97) {
+        GST_WARNING("ignoring %s event without a qValue from 1 to 97\n",
+            GST_TIIMGENC1_QVALUE_EVENT);
+        return FALSE;
+    }
+
+    entry         = g_new(GstTIImgenc1QValue, 1);
+    entry->offset = imgenc1->circBuf ? imgenc1->circBuf->bytesQueued : 0;
+    entry->qValue = qValue;
+
+    GST_LOG("qValue %d requested for the frame at offset %llu\n",
+        entry->qValue, entry->offset);
+
+    g_mutex_lock(imgenc1->qValueLock);
+    g_queue_push_tail(imgenc1->qValueQueue, entry);
+    g_mutex_unlock(imgenc1->qValueLock);
+
+    return TRUE;
+}
+
+
+/******************************************************************************
+ * gst_tiimgenc1_frame_qvalue
+ *    Return the qValue to encode the frame at the read pointer of the
+ *    circular buffer with: the last override queued before it, or the
+ *    qValue property if there is none.
+ ******************************************************************************/
+static XDAS_Int32 gst_tiimgenc1_frame_qvalue(GstTIImgenc1 *imgenc1)
+{
+    GstTIImgenc1QValue *entry;
+    XDAS_Int32          qValue = imgenc1->baseQValue;
+    guint64             offset = imgenc1->circBuf->bytesRead;
+
+    g_mutex_lock(imgenc1->qValueLock);
+    while ((entry = g_queue_peek_head(imgenc1->qValueQueue)) != NULL &&
+           entry->offset <= offset) {
+        qValue = entry->qValue;
+        g_free(g_queue_pop_head(imgenc1->qValueQueue));
+    }
+    g_mutex_unlock(imgenc1->qValueLock);
+
+    return qValue;
+}
+
+
+/******************************************************************************
+ * gst_tiimgenc1_set_qvalue
+ *    Change the qValue of the running codec, if it is not qValue already.
+ ******************************************************************************/
+static gboolean gst_tiimgenc1_set_qvalue(GstTIImgenc1 *imgenc1,
+                    XDAS_Int32 qValue)
+{
+    IMGENC1_Status status;
+    XDAS_Int32     ret;
+
+    if (imgenc1->dynParams.qValue == qValue) {
+        return TRUE;
+    }
+
+    GST_LOG("changing qValue from %ld to %ld\n", imgenc1->dynParams.qValue,
+        qValue);
+
+    imgenc1->dynParams.qValue = qValue;
+    status.size               = sizeof(IMGENC1_Status);
+
+    ret = IMGENC1_control(Ienc1_getVisaHandle(imgenc1->hIe), XDM_SETPARAMS,
+              &imgenc1->dynParams, &status);
+
+    if (ret != IMGENC1_EOK) {
+        GST_ERROR("failed to set qValue %ld (extended error 0x%lx)\n",
+            qValue, status.extendedError);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/******************************************************************************
+ * gst_tiimgenc1_rebase_qvalues
+ *    Called when the circular buffer goes away after bytesQueued bytes.
+ *    Overrides for frames that were never encoded are dropped, and those
+ *    for frames not queued yet move to the start of the next stream.
+ ******************************************************************************/
+static void gst_tiimgenc1_rebase_qvalues(GstTIImgenc1 *imgenc1,
+                guint64 bytesQueued)
+{
+    GstTIImgenc1QValue *entry;
+    GList              *item;
+
+    g_mutex_lock(imgenc1->qValueLock);
+    while ((entry = g_queue_peek_head(imgenc1->qValueQueue)) != NULL &&
+           entry->offset < bytesQueued) {
+        g_free(g_queue_pop_head(imgenc1->qValueQueue));
+    }
+
+    for (item = imgenc1->qValueQueue->head; item; item = item->next) {
+        ((GstTIImgenc1QValue *) item->data)->offset = 0;
+    }
+    g_mutex_unlock(imgenc1->qValueLock);
+}
+
 /*******************************************************************************
  * gst_tiimgenc1_convert_fourcc
  *      This function will take in a fourcc value (as used in the format
@@ -1332,8 +1575,8 @@ static gboolean gst_tiimgenc1_init_image(GstTIImgenc1 *imgenc1)
     }
 
     /* Create encoder thread */
-    if (pthread_create(&imgenc1->encodeThread, &attr,
-            gst_tiimgenc1_encode_thread, (void*)imgenc1)) {
+    if (pthread_create(&imgenc1->encodeThread, imgenc1->rtCodecThread ?
+            &attr : NULL, gst_tiimgenc1_encode_thread, (void*)imgenc1)) {
         GST_ELEMENT_ERROR(imgenc1, RESOURCE, FAILED,
         ("failed to create encode thread\n"), (NULL));
         gst_tiimgenc1_exit_image(imgenc1);
@@ -1467,6 +1710,13 @@ static GstStateChangeReturn gst_tiimgenc1_change_state(GstElement *element,
  *****************************************************************************/
 static gboolean gst_tiimgenc1_codec_stop (GstTIImgenc1  *imgenc1)
 {
+    if (imgenc1->numFramesEncoded > 0) {
+        GST_INFO("%u frames encoded in %" GST_TIME_FORMAT " (batchSize %d)\n",
+            imgenc1->numFramesEncoded,
+            GST_TIME_ARGS(imgenc1->lastFrameTime - imgenc1->firstFrameTime),
+            imgenc1->batchSize);
+    }
+
     /* Shut down remaining items */
     if (imgenc1->circBuf) {
         GstTICircBuffer *circBuf;
@@ -1477,9 +1727,15 @@ static gboolean gst_tiimgenc1_codec_stop (GstTIImgenc1  *imgenc1)
         imgenc1->circBuf      = NULL;
         imgenc1->framerateNum = 0;
         imgenc1->framerateDen = 0;
+        gst_tiimgenc1_rebase_qvalues(imgenc1, circBuf->bytesQueued);
         gst_ticircbuffer_unref(circBuf);
     }
 
+    if (imgenc1->hInBuf) {
+        Buffer_delete(imgenc1->hInBuf);
+        imgenc1->hInBuf = NULL;
+    }
+
     if (imgenc1->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
         gst_tidmaibuftab_unref(imgenc1->hOutBufTab);
@@ -1528,6 +1784,9 @@ static gboolean gst_tiimgenc1_codec_start (GstTIImgenc1  *imgenc1)
         return FALSE;
     }
 
+    /* Frames without a qValue override of their own are encoded with this */
+    imgenc1->baseQValue = imgenc1->dynParams.qValue;
+
     GST_LOG("opening image encoder \"%s\"\n", imgenc1->codecName);
     imgenc1->hIe = Ienc1_create(imgenc1->hEngine, (Char*)imgenc1->codecName,
                       &imgenc1->params, &imgenc1->dynParams);
@@ -1544,9 +1803,16 @@ static gboolean gst_tiimgenc1_codec_start (GstTIImgenc1  *imgenc1)
                 gst_tiimgenc1_convert_attrs(VAR_ICOLORSPACE, imgenc1))
                 * imgenc1->height;
 
-    /* Create a circular input buffer */
+    /* Create a circular input buffer with room for a batch of frames on top
+     * of the one being encoded.
+     */
+    if (imgenc1->batchSize < 1) {
+        imgenc1->batchSize = DEFAULT_BATCH_SIZE;
+    }
+
     imgenc1->circBuf = gst_ticircbuffer_new(
-                           Ienc1_getInBufSize(imgenc1->hIe), 2, TRUE);
+                           Ienc1_getInBufSize(imgenc1->hIe),
+                           imgenc1->batchSize + 1, TRUE);
 
     if (imgenc1->circBuf == NULL) {
         GST_ELEMENT_ERROR(imgenc1, RESOURCE, NO_SPACE_LEFT,
@@ -1563,13 +1829,18 @@ static gboolean gst_tiimgenc1_codec_start (GstTIImgenc1  *imgenc1)
     /* Display buffer contents if displayBuffer=TRUE was specified */
     gst_ticircbuffer_set_display(imgenc1->circBuf, imgenc1->displayBuffer);
 
+    /* A contiguous input buffer holding exactly one frame can be encoded
+     * where it is.
+     */
+    gst_ticircbuffer_set_zero_copy(imgenc1->circBuf, TRUE);
+
     /* Define the number of display buffers to allocate.  This number must be
      * at least 1, but should be more if codecs don't return a display buffer
      * after every process call.  If this has not been set via set_property(),
      * default to the value set above based on device type.
      */
     if (imgenc1->numOutputBufs == 0) {
-        imgenc1->numOutputBufs = 1;
+        imgenc1->numOutputBufs = imgenc1->batchSize;
     }
     /* Create codec output buffers */
     GST_LOG("creating output buffer table\n");
@@ -1594,6 +1865,32 @@ static gboolean gst_tiimgenc1_codec_start (GstTIImgenc1  *imgenc1)
         return FALSE;
     }
 
+    /* The encoder requires its input in a BufferGfx object.  Create one
+     * reference buffer to point at each frame in the circular buffer in
+     * turn.
+     */
+    gfxAttrs                = BufferGfx_Attrs_DEFAULT;
+    gfxAttrs.colorSpace     = gst_tiimgenc1_codec_color_space_to_dmai(
+                                  imgenc1->dynParams.inputChromaFormat);
+    gfxAttrs.dim.width      = imgenc1->dynParams.inputWidth;
+    gfxAttrs.dim.height     = imgenc1->dynParams.inputHeight;
+    gfxAttrs.dim.lineLength = BufferGfx_calcLineLength(
+                                  gfxAttrs.dim.width, gfxAttrs.colorSpace);
+    gfxAttrs.bAttrs.reference = TRUE;
+
+    imgenc1->hInBuf = Buffer_create(Ienc1_getInBufSize(imgenc1->hIe),
+                          BufferGfx_getBufferAttrs(&gfxAttrs));
+
+    if (imgenc1->hInBuf == NULL) {
+        GST_ELEMENT_ERROR(imgenc1, RESOURCE, NO_SPACE_LEFT,
+        ("failed to create input reference buffer\n"), (NULL));
+        return FALSE;
+    }
+
+    imgenc1->numFramesEncoded = 0;
+    imgenc1->firstFrameTime   = GST_CLOCK_TIME_NONE;
+    imgenc1->lastFrameTime    = GST_CLOCK_TIME_NONE;
+
     return TRUE;
 
 }
@@ -1609,13 +1906,11 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
     GstBuffer              *encDataWindow  = NULL;
     gboolean               codecFlushed    = FALSE;
     void                   *threadRet      = GstTIThreadSuccess;
-    BufferGfx_Attrs        gfxAttrs        = BufferGfx_Attrs_DEFAULT;
     Buffer_Handle          hDstBuf;
     Int32                  encDataConsumed;
     GstClockTime           encDataTime;
     GstClockTime           frameDuration;
     Buffer_Handle          hEncDataWindow;
-    BufferGfx_Dimensions   dim;
     GstBuffer              *outBuf;
     Int                    bufIdx;
     Int                    ret;
@@ -1671,24 +1966,22 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
         /* Make sure the whole buffer is used for output */
         BufferGfx_resetDimensions(hDstBuf);
 
-        /* Create a BufferGfx object that will point to a reference buffer from
-         * The circular buffer.  This is needed for the encoder which requires
-         * that the input buffer be a BufferGfx object.
-         */
-        BufferGfx_getBufferAttrs(&gfxAttrs)->reference = TRUE;
-        imgenc1->hInBuf = Buffer_create(Buffer_getSize(hEncDataWindow),
-                                BufferGfx_getBufferAttrs(&gfxAttrs));
+        /* Point the input reference buffer at the frame */
         Buffer_setUserPtr(imgenc1->hInBuf, Buffer_getUserPtr(hEncDataWindow));
-        Buffer_setNumBytesUsed(imgenc1->hInBuf, 
-                               Buffer_getSize(imgenc1->hInBuf));
+        Buffer_setNumBytesUsed(imgenc1->hInBuf,
+                               Buffer_getSize(hEncDataWindow));
 
-        /* Set the dimensions of the buffer to the resolution */
-        BufferGfx_getDimensions(hDstBuf, &dim);
-        dim.width = imgenc1->dynParams.inputWidth;
-        dim.height = imgenc1->dynParams.inputHeight;
-        BufferGfx_setDimensions(imgenc1->hInBuf, &dim);
-        BufferGfx_setColorSpace(imgenc1->hInBuf,
-                     imgenc1->dynParams.inputChromaFormat); 
+        /* Apply the qValue requested for this frame, if it differs */
+        if (!gst_tiimgenc1_set_qvalue(imgenc1,
+                 gst_tiimgenc1_frame_qvalue(imgenc1))) {
+            GST_ELEMENT_ERROR(imgenc1, STREAM, ENCODE,
+            ("failed to set the qValue of the image encoder\n"), (NULL));
+            goto thread_failure;
+        }
+
+        if (!GST_CLOCK_TIME_IS_VALID(imgenc1->firstFrameTime)) {
+            imgenc1->firstFrameTime = gst_util_get_timestamp();
+        }
 
         /* Invoke the image encoder */
         GST_LOG("invoking the image encoder\n");
@@ -1696,9 +1989,6 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
         encDataConsumed = (codecFlushed) ? 0 :
                           Buffer_getNumBytesUsed(hEncDataWindow);
 
-        /* Delete the temporary Graphics buffer used for the encode process */
-        Buffer_delete(imgenc1->hInBuf);
-
         if (ret < 0) {
             GST_ELEMENT_ERROR(imgenc1, STREAM, ENCODE, 
             ("failed to encode image buffer\n"), (NULL));
@@ -1767,6 +2057,9 @@ static void* gst_tiimgenc1_encode_thread(void *arg)
 
         /* Release buffers no longer in use by the codec */
         Buffer_freeUseMask(hDstBuf, gst_tidmaibuffer_CODEC_FREE);
+
+        imgenc1->numFramesEncoded++;
+        imgenc1->lastFrameTime = gst_util_get_timestamp();
     }
 
 thread_failure:
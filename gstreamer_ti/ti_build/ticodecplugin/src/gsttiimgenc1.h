@@ -57,6 +57,13 @@ G_BEGIN_DECLS
 typedef struct _GstTIImgenc1      GstTIImgenc1;
 typedef struct _GstTIImgenc1Class GstTIImgenc1Class;
 
+/* Name of the serialized custom downstream event that overrides the qValue
+ * of the next frame queued after it.  The event structure carries the new
+ * value in an int field named "qValue"; later frames go back to the qValue
+ * property.
+ */
+#define GST_TIIMGENC1_QVALUE_EVENT "GstTIImgenc1QValue"
+
 /* _GstTIImgenc1 object */
 struct _GstTIImgenc1
 {
@@ -73,6 +80,8 @@ struct _GstTIImgenc1
   gchar*                    iColor;
   gchar*                    oColor;
   gint                      qValue;
+  gint                      batchSize;
+  gboolean                  rtCodecThread;
   /* Resolution input */
   gint                      width;
   gint                      height;
@@ -106,6 +115,16 @@ struct _GstTIImgenc1
   GstTIDmaiBufTab          *hOutBufTab;
   GstTICircBuffer           *circBuf;
   Buffer_Handle             hInBuf;
+
+  /* Per-frame qValue overrides, in stream order */
+  GMutex                   *qValueLock;
+  GQueue                   *qValueQueue;
+  XDAS_Int32                baseQValue;
+
+  /* Throughput, from the first frame encoded to the last */
+  guint                     numFramesEncoded;
+  GstClockTime              firstFrameTime;
+  GstClockTime              lastFrameTime;
 };
 
 /* _GstTIImgenc1Class object */
@@ -0,0 +1,327 @@
+/*
+ * gsttiptsreorder.c
+ *
+ * The "GstTIPtsReorder" object carries input timestamps across a video
+ * decoder that returns frames in display order, which for streams with
+ * B-frames is not the order they were decoded in.
+ *
+ * The timestamp of every decoded frame is kept, along with the output buffer
+ * it was decoded into, until the codec hands a frame back for display.  The
+ * displayed frame then gets the smallest timestamp still outstanding.  This
+ * gives the right result both when upstream stamps buffers with presentation
+ * times (each frame ends up with its own timestamp) and when it stamps them
+ * in decode order (the timestamps get sorted into display order).  Frames
+ * the codec releases without displaying them give their timestamp up.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include "gsttiptsreorder.h"
+
+/* Declare variable used to categorize GST_LOG output */
+GST_DEBUG_CATEGORY_STATIC(gst_tiptsreorder_debug);
+#define GST_CAT_DEFAULT gst_tiptsreorder_debug
+
+/* Output buffer and the timestamp of the frame decoded into it */
+typedef struct {
+    gpointer      hBuf;
+    GstClockTime  timestamp;
+} GstTIPtsReorderFrame;
+
+/* Static Function Declarations */
+static void gst_tiptsreorder_remove_pending(GstTIPtsReorder *reorder,
+                GstClockTime timestamp);
+static gint gst_tiptsreorder_find_frame(GstTIPtsReorder *reorder,
+                gpointer hBuf);
+static void gst_tiptsreorder_trim(GstTIPtsReorder *reorder);
+static gboolean gst_tiptsreorder_remove_stale(GstTIPtsReorder *reorder,
+                    gpointer hBuf);
+
+
+/******************************************************************************
+ * gst_tiptsreorder_new
+ *    Create an empty timestamp reorder queue.
+ ******************************************************************************/
+GstTIPtsReorder* gst_tiptsreorder_new(void)
+{
+    GstTIPtsReorder *reorder;
+
+    if (!gst_tiptsreorder_debug) {
+        GST_DEBUG_CATEGORY_INIT(gst_tiptsreorder_debug, "TIPtsReorder", 0,
+            "TI video timestamp reordering");
+    }
+
+    reorder                = g_new0(GstTIPtsReorder, 1);
+    reorder->pending       = g_array_new(FALSE, FALSE, sizeof(GstClockTime));
+    reorder->frames        = g_array_new(FALSE, FALSE,
+                                 sizeof(GstTIPtsReorderFrame));
+    reorder->stale         = g_array_new(FALSE, FALSE, sizeof(gpointer));
+    reorder->lastTimeStamp = GST_CLOCK_TIME_NONE;
+
+    return reorder;
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_free
+ ******************************************************************************/
+void gst_tiptsreorder_free(GstTIPtsReorder *reorder)
+{
+    if (reorder == NULL) {
+        return;
+    }
+
+    g_array_free(reorder->pending, TRUE);
+    g_array_free(reorder->frames, TRUE);
+    g_array_free(reorder->stale, TRUE);
+    g_free(reorder);
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_reset
+ *    Forget all outstanding frames, for example after a flush of the codec
+ *    or a discontinuity.  The buffers they were decoded into are remembered
+ *    as stale, see gst_tiptsreorder_take_stale.
+ ******************************************************************************/
+void gst_tiptsreorder_reset(GstTIPtsReorder *reorder)
+{
+    guint i;
+
+    for (i = 0; i < reorder->frames->len; i++) {
+        g_array_append_val(reorder->stale,
+            g_array_index(reorder->frames, GstTIPtsReorderFrame, i).hBuf);
+    }
+
+    g_array_set_size(reorder->pending, 0);
+    g_array_set_size(reorder->frames, 0);
+    reorder->lastTimeStamp = GST_CLOCK_TIME_NONE;
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_add
+ *    Record that the frame stamped with timestamp was decoded into hBuf.
+ ******************************************************************************/
+void gst_tiptsreorder_add(GstTIPtsReorder *reorder, gpointer hBuf,
+         GstClockTime timestamp)
+{
+    GstTIPtsReorderFrame frame;
+    guint                i;
+
+    /* The codec should not hand us a buffer it has not displayed or released
+     * yet, but if it does the old frame is gone.
+     */
+    gst_tiptsreorder_release(reorder, hBuf);
+    gst_tiptsreorder_remove_stale(reorder, hBuf);
+
+    frame.hBuf      = hBuf;
+    frame.timestamp = timestamp;
+    g_array_append_val(reorder->frames, frame);
+
+    if (!GST_CLOCK_TIME_IS_VALID(timestamp)) {
+        return;
+    }
+
+    /* Keep the pending timestamps sorted, there are only ever as many as
+     * the codec holds frames.
+     */
+    for (i = 0; i < reorder->pending->len; i++) {
+        if (timestamp < g_array_index(reorder->pending, GstClockTime, i)) {
+            break;
+        }
+    }
+    g_array_insert_val(reorder->pending, i, timestamp);
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_display
+ *    Return the timestamp of the frame in hBuf, which the codec returned for
+ *    display.  If no timestamp is known the last one is extrapolated by
+ *    duration.
+ ******************************************************************************/
+GstClockTime gst_tiptsreorder_display(GstTIPtsReorder *reorder,
+                 gpointer hBuf, GstClockTime duration)
+{
+    GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+    gint         idx;
+
+    idx = gst_tiptsreorder_find_frame(reorder, hBuf);
+    if (idx >= 0) {
+        g_array_remove_index(reorder->frames, idx);
+    }
+
+    if (reorder->pending->len > 0) {
+        timestamp = g_array_index(reorder->pending, GstClockTime, 0);
+        g_array_remove_index(reorder->pending, 0);
+    }
+    else if (GST_CLOCK_TIME_IS_VALID(reorder->lastTimeStamp) &&
+             GST_CLOCK_TIME_IS_VALID(duration)) {
+        timestamp = reorder->lastTimeStamp + duration;
+    }
+
+    if (GST_CLOCK_TIME_IS_VALID(timestamp) &&
+        GST_CLOCK_TIME_IS_VALID(reorder->lastTimeStamp) &&
+        timestamp < reorder->lastTimeStamp) {
+        GST_DEBUG("timestamp %" GST_TIME_FORMAT " goes backwards from %"
+            GST_TIME_FORMAT, GST_TIME_ARGS(timestamp),
+            GST_TIME_ARGS(reorder->lastTimeStamp));
+    }
+
+    reorder->lastTimeStamp = timestamp;
+
+    gst_tiptsreorder_trim(reorder);
+
+    return timestamp;
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_release
+ *    The codec no longer uses hBuf.  If the frame in it was never displayed,
+ *    its timestamp is dropped and returned; otherwise GST_CLOCK_TIME_NONE is.
+ ******************************************************************************/
+GstClockTime gst_tiptsreorder_release(GstTIPtsReorder *reorder, gpointer hBuf)
+{
+    GstTIPtsReorderFrame *frame;
+    GstClockTime          timestamp;
+    gint                  idx;
+
+    gst_tiptsreorder_remove_stale(reorder, hBuf);
+
+    idx = gst_tiptsreorder_find_frame(reorder, hBuf);
+    if (idx < 0) {
+        return GST_CLOCK_TIME_NONE;
+    }
+
+    frame     = &g_array_index(reorder->frames, GstTIPtsReorderFrame, idx);
+    timestamp = frame->timestamp;
+    GST_LOG("frame %" GST_TIME_FORMAT " released without display",
+        GST_TIME_ARGS(timestamp));
+
+    gst_tiptsreorder_remove_pending(reorder, timestamp);
+    g_array_remove_index(reorder->frames, idx);
+
+    gst_tiptsreorder_trim(reorder);
+
+    return timestamp;
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_take_stale
+ *    Return whether the frame in hBuf was decoded before the last reset, in
+ *    which case it is forgotten and the caller should not display it.
+ ******************************************************************************/
+gboolean gst_tiptsreorder_take_stale(GstTIPtsReorder *reorder, gpointer hBuf)
+{
+    return gst_tiptsreorder_remove_stale(reorder, hBuf);
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_remove_stale
+ ******************************************************************************/
+static gboolean gst_tiptsreorder_remove_stale(GstTIPtsReorder *reorder,
+                    gpointer hBuf)
+{
+    guint i;
+
+    for (i = 0; i < reorder->stale->len; i++) {
+        if (g_array_index(reorder->stale, gpointer, i) == hBuf) {
+            g_array_remove_index(reorder->stale, i);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_remove_pending
+ ******************************************************************************/
+static void gst_tiptsreorder_remove_pending(GstTIPtsReorder *reorder,
+                GstClockTime timestamp)
+{
+    guint i;
+
+    if (!GST_CLOCK_TIME_IS_VALID(timestamp)) {
+        return;
+    }
+
+    for (i = 0; i < reorder->pending->len; i++) {
+        if (g_array_index(reorder->pending, GstClockTime, i) == timestamp) {
+            g_array_remove_index(reorder->pending, i);
+            return;
+        }
+    }
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_find_frame
+ ******************************************************************************/
+static gint gst_tiptsreorder_find_frame(GstTIPtsReorder *reorder,
+                gpointer hBuf)
+{
+    guint i;
+
+    for (i = 0; i < reorder->frames->len; i++) {
+        if (g_array_index(reorder->frames, GstTIPtsReorderFrame, i).hBuf ==
+                hBuf) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+/******************************************************************************
+ * gst_tiptsreorder_trim
+ *    There can never be more pending timestamps than frames the codec still
+ *    holds.  If a dropped frame's timestamp was already handed out to another
+ *    frame, the stale one left over is the smallest: drop it so that we don't
+ *    stay a frame behind from then on.
+ ******************************************************************************/
+static void gst_tiptsreorder_trim(GstTIPtsReorder *reorder)
+{
+    guint valid = 0;
+    guint i;
+
+    for (i = 0; i < reorder->frames->len; i++) {
+        if (GST_CLOCK_TIME_IS_VALID(g_array_index(reorder->frames,
+                GstTIPtsReorderFrame, i).timestamp)) {
+            valid++;
+        }
+    }
+
+    while (reorder->pending->len > valid) {
+        GST_DEBUG("dropping stale timestamp %" GST_TIME_FORMAT,
+            GST_TIME_ARGS(g_array_index(reorder->pending, GstClockTime, 0)));
+        g_array_remove_index(reorder->pending, 0);
+    }
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
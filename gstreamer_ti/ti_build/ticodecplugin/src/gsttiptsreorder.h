@@ -0,0 +1,74 @@
+/*
+ * gsttiptsreorder.h
+ *
+ * The "GstTIPtsReorder" object carries input timestamps across a video
+ * decoder that returns frames in display order, which for streams with
+ * B-frames is not the order they were decoded in.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef __GST_TIPTSREORDER_H__
+#define __GST_TIPTSREORDER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstTIPtsReorder GstTIPtsReorder;
+
+/* _GstTIPtsReorder object */
+struct _GstTIPtsReorder {
+
+    /* Timestamps of decoded frames not yet displayed, smallest first */
+    GArray       *pending;
+
+    /* Output buffer -> timestamp of the frame decoded into it, for frames
+     * not yet displayed.
+     */
+    GArray       *frames;
+
+    /* Output buffers holding frames decoded before the last reset */
+    GArray       *stale;
+
+    /* Last timestamp handed out, to interpolate from */
+    GstClockTime  lastTimeStamp;
+};
+
+/* External function declarations */
+GstTIPtsReorder* gst_tiptsreorder_new(void);
+void             gst_tiptsreorder_free(GstTIPtsReorder *reorder);
+void             gst_tiptsreorder_reset(GstTIPtsReorder *reorder);
+void             gst_tiptsreorder_add(GstTIPtsReorder *reorder,
+                     gpointer hBuf, GstClockTime timestamp);
+GstClockTime     gst_tiptsreorder_display(GstTIPtsReorder *reorder,
+                     gpointer hBuf, GstClockTime duration);
+GstClockTime     gst_tiptsreorder_release(GstTIPtsReorder *reorder,
+                     gpointer hBuf);
+gboolean         gst_tiptsreorder_take_stale(GstTIPtsReorder *reorder,
+                     gpointer hBuf);
+
+G_END_DECLS
+
+#endif /* __GST_TIPTSREORDER_H__ */
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
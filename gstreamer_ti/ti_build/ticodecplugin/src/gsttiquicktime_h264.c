@@ -30,8 +30,6 @@
 #include <stdlib.h>
 #include <gst/gst.h>
 
-#include <ti/sdo/dmai/Fifo.h>
-
 #include "gsttiquicktime_h264.h"
 #include "gstticodecs.h"
 
@@ -152,29 +150,9 @@ GstBuffer* gst_h264_get_sps_pps_data (GstBuffer *buf)
 }
 
 /******************************************************************************
- * gst_h264_get_nal_code_prefix - This function return the pre-define NAL 
- * prefix code.
- *****************************************************************************/
-GstBuffer* gst_h264_get_nal_prefix_code (void)
-{
-    GstBuffer *nal_code_prefix;
-
-    nal_code_prefix = gst_buffer_new_and_alloc(NAL_START_CODE_LENGTH);
-    if (nal_code_prefix == NULL) {
-        GST_ERROR("Failed to allocate memory\n");
-        return NULL;
-    }
-
-    memcpy(GST_BUFFER_DATA(nal_code_prefix), (unsigned char*) &NAL_START_CODE,
-                NAL_START_CODE_LENGTH);
-
-    return nal_code_prefix;
-
-}
-
-/******************************************************************************
- * gst_h264_parse_and_queue  - This function adds sps and pps header data
- * before pushing input buffer in queue.
+ * gst_h264_to_byte_stream - This function converts one packetized sample to
+ * byte-stream format in a single pass, optionally prefixed with the SPS and
+ * PPS data returned by gst_h264_get_sps_pps_data.
  *
  * H264 in quicktime is what we call in gstreamer 'packtized' h264.
  * A codec_data is exchanged in the caps that contains, among other things,
@@ -187,58 +165,133 @@ GstBuffer* gst_h264_get_nal_prefix_code (void)
  * exchanging the size header with nal prefix codes is a valid way to transform
  * a packetized stream into a byte stream.
  *****************************************************************************/
-int gst_h264_parse_and_queue (GstTICircBuffer *circBuf, GstBuffer *buf, 
-    GstBuffer *sps_pps_data, GstBuffer *nal_code_prefix, guint8 nal_length)
+GstBuffer* gst_h264_to_byte_stream (GstBuffer *buf, GstBuffer *sps_pps_data,
+    guint8 nal_length)
 {
-    int i, nal_size=0, avail = GST_BUFFER_SIZE(buf);
-    GstBuffer *subBuf;
+    guint i, nal_size, max_size, avail = GST_BUFFER_SIZE(buf);
+    guint header_size = sps_pps_data ? GST_BUFFER_SIZE(sps_pps_data) : 0;
     guint8 *inBuf = GST_BUFFER_DATA(buf);
-    int offset = 0;
+    guint8 *outData, *out;
+    GstBuffer *outBuf;
+
+    /* Every NAL unit takes at least nal_length bytes of input, so replacing
+     * the size headers with start codes grows the data by at most this much.
+     */
+    max_size = header_size + avail;
+    if (nal_length < NAL_START_CODE_LENGTH) {
+        max_size += (avail / nal_length) *
+                    (NAL_START_CODE_LENGTH - nal_length);
+    }
 
-    /* Put SPS and PPS data (prefixed with NAL code) in fifo */
-    if (!gst_ticircbuffer_queue_data(circBuf, sps_pps_data)) {
-        GST_ERROR("Failed to put SPS, PPS data in Fifo \n");
-        return FALSE;
+    outBuf = gst_buffer_new_and_alloc(max_size);
+    if (outBuf == NULL) {
+        GST_ERROR("Failed to allocate %u byte buffer\n", max_size);
+        return NULL;
     }
+    gst_buffer_copy_metadata(outBuf, buf, GST_BUFFER_COPY_TIMESTAMPS);
 
-    do {
+    outData = out = GST_BUFFER_DATA(outBuf);
+
+    /* Put SPS and PPS data (prefixed with NAL code) first */
+    if (header_size) {
+        memcpy(out, GST_BUFFER_DATA(sps_pps_data), header_size);
+        out += header_size;
+    }
+
+    while (avail >= nal_length) {
         nal_size = 0;
         for (i=0; i < nal_length; i++) {
             nal_size = (nal_size << 8) | inBuf[i];
         }
         inBuf += nal_length;
-        offset += nal_length;
-            
-        /* Put NAL prefix code in fifo */
-        if (!gst_ticircbuffer_queue_data(circBuf, nal_code_prefix)) {
-            GST_ERROR("Failed to put NAL code prefix\n");
-            return FALSE;
-        }
+        avail -= nal_length;
 
-        /* Get a child buffer starting with offset and end at nal_size */
-        subBuf = gst_buffer_create_sub(buf, offset, nal_size);
-        if (subBuf == NULL) {
-            GST_ERROR("Failed to get nal_size=%d buffer from adapater\n", 
-                    nal_size);
-            return FALSE;
+        if (nal_size > avail) {
+            GST_WARNING("NAL unit of %u bytes truncated to %u bytes\n",
+                nal_size, avail);
+            nal_size = avail;
         }
 
-        /* Put nal_size data from input buffer in fifo */
-        if (!gst_ticircbuffer_queue_data(circBuf, subBuf)) {
-            GST_ERROR("Failed to put NAL code prefix\n");
-            gst_buffer_unref(subBuf);
-            return FALSE;
-        }
+        /* Replace the size header with the NAL prefix code */
+        memcpy(out, (unsigned char*) &NAL_START_CODE, NAL_START_CODE_LENGTH);
+        out += NAL_START_CODE_LENGTH;
+
+        memcpy(out, inBuf, nal_size);
+        out += nal_size;
+        inBuf += nal_size;
+        avail -= nal_size;
+    }
+
+    GST_BUFFER_SIZE(outBuf) = out - outData;
+
+    return outBuf;
+}
+
+/******************************************************************************
+ * gst_h264_to_byte_stream_in_place - This function converts a sample with
+ * four byte size headers to byte-stream format without copying it, by
+ * overwriting each size header with a NAL prefix code.
+ *****************************************************************************/
+static void gst_h264_to_byte_stream_in_place (GstBuffer *buf)
+{
+    guint nal_size, avail = GST_BUFFER_SIZE(buf);
+    guint8 *inBuf = GST_BUFFER_DATA(buf);
+
+    while (avail >= NAL_START_CODE_LENGTH) {
+        nal_size = GST_READ_UINT32_BE(inBuf);
+        memcpy(inBuf, (unsigned char*) &NAL_START_CODE,
+            NAL_START_CODE_LENGTH);
+        inBuf += NAL_START_CODE_LENGTH;
+        avail -= NAL_START_CODE_LENGTH;
 
-        /* Unref the sub buffer */
-        gst_buffer_unref(subBuf);
+        if (nal_size > avail) {
+            GST_WARNING("NAL unit of %u bytes truncated to %u bytes\n",
+                nal_size, avail);
+            nal_size = avail;
+        }
 
-        offset += nal_size;
         inBuf += nal_size;
-        avail -= (nal_size + nal_length);
-    }while (avail > 0);
+        avail -= nal_size;
+    }
 
-    return TRUE;
+    /* Drop trailing bytes too short to hold a size header */
+    GST_BUFFER_SIZE(buf) -= avail;
+}
+
+/******************************************************************************
+ * gst_h264_parse_and_queue  - This function converts the input buffer to
+ * byte-stream format and puts it in the circular buffer with one queue
+ * operation.  sps_pps_data is put in front of the data when not NULL; it is
+ * only needed at the start of the stream and after a flush.
+ *
+ * When the sample has four byte size headers, no header data goes in front
+ * and the caller holds the only reference to buf, buf is converted in place.
+ *****************************************************************************/
+int gst_h264_parse_and_queue (GstTICircBuffer *circBuf, GstBuffer *buf, 
+    GstBuffer *sps_pps_data, guint8 nal_length)
+{
+    GstBuffer *outBuf;
+    int        ret;
+
+    if (sps_pps_data == NULL && nal_length == NAL_START_CODE_LENGTH &&
+            gst_buffer_is_writable(buf)) {
+        gst_h264_to_byte_stream_in_place(buf);
+        return gst_ticircbuffer_queue_data(circBuf, buf);
+    }
+
+    outBuf = gst_h264_to_byte_stream(buf, sps_pps_data, nal_length);
+    if (outBuf == NULL) {
+        return FALSE;
+    }
+
+    ret = gst_ticircbuffer_queue_data(circBuf, outBuf);
+    if (!ret) {
+        GST_ERROR("Failed to put byte-stream data in circular buffer\n");
+    }
+
+    gst_buffer_unref(outBuf);
+
+    return ret;
 }
 
 /******************************************************************************
@@ -73,12 +73,13 @@ GstBuffer* gst_h264_get_sps_pps_data (GstBuffer *buf);
 /* Function to read NAL length field from avcc header */
 guint8 gst_h264_get_nal_length (GstBuffer *buf);
 
-/* Function to get predefind NAL prefix code */
-GstBuffer* gst_h264_get_nal_prefix_code (void);
+/* Function to convert a packetized sample to byte-stream format */
+GstBuffer* gst_h264_to_byte_stream (GstBuffer *buf, GstBuffer *sps_pps_data,
+    guint8 nal_length);
 
 /* Function to parse input stream and put in circular buffer */
 int gst_h264_parse_and_queue (GstTICircBuffer *circBuf, GstBuffer *buf, 
-    GstBuffer *sps_pps_data, GstBuffer *nal_code_prefix, guint8 nal_length );
+    GstBuffer *sps_pps_data, guint8 nal_length);
 
 /* Function to check if we are using h264 decoder */
 gboolean gst_is_h264_decoder (const gchar *name);
@@ -66,6 +66,8 @@
 #define     DEFAULT_GENTIMESTAMP    TRUE
 #define     DEFAULT_RTCODECTHREAD   TRUE
 #define     DEFAULT_DISPLAY_BUFFER  FALSE
+#define     DEFAULT_ZERO_COPY_INPUT FALSE
+#define     DEFAULT_QOS             TRUE
 #define     DEFAULT_ENGINE_NAME     "unspecified"
 
 /* define platform specific defaults */
@@ -94,7 +96,9 @@ enum
   PROP_DISPLAY_BUFFER,  /* displayBuffer  (boolean) */
   PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
   PROP_RTCODECTHREAD,   /* rtCodecThread (boolean) */
-  PROP_PAD_ALLOC_OUTBUFS /* padAllocOutbufs (boolean) */
+  PROP_PAD_ALLOC_OUTBUFS, /* padAllocOutbufs (boolean) */
+  PROP_ZERO_COPY_INPUT, /* zeroCopyInput  (boolean) */
+  PROP_QOS              /* qos            (boolean) */
 };
 
 /* Define sink (input) pad capabilities.  Currently, MPEG and H264 are 
@@ -175,6 +179,8 @@ static gboolean
      Int32 height, ColorSpace_Type colorSpace);
 static gboolean
  gst_tividdec2_sink_event(GstPad *pad, GstEvent *event);
+static gboolean
+ gst_tividdec2_src_event(GstPad *pad, GstEvent *event);
 static GstFlowReturn
  gst_tividdec2_chain(GstPad *pad, GstBuffer *buf);
 static gboolean
@@ -191,6 +197,17 @@ static GstClockTime
  gst_tividdec2_frame_duration(GstTIViddec2 *viddec2);
 static gboolean
  gst_tividdec2_resizeBufTab(GstTIViddec2 *viddec2);
+static void
+ gst_tividdec2_reset_qos(GstTIViddec2 *viddec2);
+static gboolean
+ gst_tividdec2_frame_is_late(GstTIViddec2 *viddec2, GstClockTime timestamp);
+static gboolean
+ gst_tividdec2_frame_is_droppable(Buffer_Handle hBuf);
+static gboolean
+ gst_tividdec2_set_frame_skip(GstTIViddec2 *viddec2, XDAS_Int32 skipMode);
+static void
+ gst_tividdec2_post_qos(GstTIViddec2 *viddec2, GstClockTime timestamp,
+     GstClockTime duration);
 static gboolean
     gst_tividdec2_codec_start (GstTIViddec2  *viddec2, GstBuffer **padBuffer);
 static gboolean 
@@ -343,13 +360,25 @@ static void gst_tividdec2_class_init(GstTIViddec2Class *klass)
 
     g_object_class_install_property(gobject_class, PROP_GEN_TIMESTAMPS,
         g_param_spec_boolean("genTimeStamps", "Generate Time Stamps",
-            "Set timestamps on output buffers",
+            "Count frames for the timestamps of a stream without any",
             DEFAULT_GENTIMESTAMP, G_PARAM_READWRITE));
 
     g_object_class_install_property(gobject_class, PROP_PAD_ALLOC_OUTBUFS,
         g_param_spec_boolean("padAllocOutbufs", "Use pad allocation",
             "Try to allocate buffers with pad allocation",
             DEFAULT_PADALLOC, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_ZERO_COPY_INPUT,
+        g_param_spec_boolean("zeroCopyInput", "Zero-copy input",
+            "Decode contiguous input buffers in place instead of copying "
+            "them to the circular buffer (needs one frame per buffer)",
+            DEFAULT_ZERO_COPY_INPUT, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_QOS,
+        g_param_spec_boolean("qos", "Quality of service",
+            "Drop late B frames when downstream QoS events report that "
+            "we are behind, skipping their decode if the codec allows it",
+            DEFAULT_QOS, G_PARAM_READWRITE));
 }
 
 /******************************************************************************
@@ -420,6 +449,18 @@ static void gst_tividdec2_init_env(GstTIViddec2 *viddec2)
                     viddec2->padAllocOutbufs ? "TRUE" : "FALSE");
     }
 
+    if (gst_ti_env_is_defined("GST_TI_TIViddec2_zeroCopyInput")) {
+        viddec2->zeroCopyInput =
+                gst_ti_env_get_boolean("GST_TI_TIViddec2_zeroCopyInput");
+        GST_LOG("Setting zeroCopyInput =%s\n",
+                    viddec2->zeroCopyInput ? "TRUE" : "FALSE");
+    }
+
+    if (gst_ti_env_is_defined("GST_TI_TIViddec2_qos")) {
+        viddec2->qos = gst_ti_env_get_boolean("GST_TI_TIViddec2_qos");
+        GST_LOG("Setting qos =%s\n", viddec2->qos ? "TRUE" : "FALSE");
+    }
+
     GST_LOG("gst_tividdec2_init_env - end\n");
 }
 
@@ -459,6 +500,8 @@ static void gst_tividdec2_init(GstTIViddec2 *viddec2, GstTIViddec2Class *gclass)
             gst_caps_copy(gst_pad_get_pad_template_caps(viddec2->srcpad))));
     gst_pad_set_query_function(viddec2->srcpad,
             GST_DEBUG_FUNCPTR(gst_tividdec2_set_query_pad));
+    gst_pad_set_event_function(
+        viddec2->srcpad, GST_DEBUG_FUNCPTR(gst_tividdec2_src_event));
 
     /* Add pads to TIViddec2 element */
     gst_element_add_pad(GST_ELEMENT(viddec2), viddec2->sinkpad);
@@ -471,7 +514,9 @@ static void gst_tividdec2_init(GstTIViddec2 *viddec2, GstTIViddec2Class *gclass)
     viddec2->genTimeStamps      = DEFAULT_GENTIMESTAMP;
     viddec2->numOutputBufs      = DEFAULT_NUMOUTPUT_BUFS;
     viddec2->padAllocOutbufs    = DEFAULT_PADALLOC;
+    viddec2->zeroCopyInput      = DEFAULT_ZERO_COPY_INPUT;
     viddec2->rtCodecThread      = DEFAULT_RTCODECTHREAD;
+    viddec2->qos                = DEFAULT_QOS;
     
     viddec2->codecName          = NULL;
 
@@ -488,18 +533,24 @@ static void gst_tividdec2_init(GstTIViddec2 *viddec2, GstTIViddec2Class *gclass)
     viddec2->circBuf            = NULL;
 
     viddec2->sps_pps_data       = NULL;
-    viddec2->nal_code_prefix    = NULL;
+    viddec2->queue_sps_pps      = FALSE;
     viddec2->nal_length         = 0;
 
     viddec2->segment            = gst_segment_new();
     viddec2->totalDuration      = 0;
     viddec2->totalBytes         = 0;
+    viddec2->tsReorder          = NULL;
+    viddec2->tsReset            = FALSE;
 
     viddec2->mpeg4_quicktime_header = NULL;
 
     viddec2->width              = 0;
     viddec2->height             = 0;
 
+    viddec2->framesProcessed    = 0;
+    viddec2->framesDropped      = 0;
+    gst_tividdec2_reset_qos(viddec2);
+
     /* Initialize GValue members */
     memset(&viddec2->framerate, 0, sizeof(GValue));
     g_value_init(&viddec2->framerate, GST_TYPE_FRACTION);
@@ -592,6 +643,16 @@ static void gst_tividdec2_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"padAllocOutbufs\" to \"%s\"\n",
                 viddec2->padAllocOutbufs ? "TRUE" : "FALSE");
             break;
+        case PROP_ZERO_COPY_INPUT:
+            viddec2->zeroCopyInput = g_value_get_boolean(value);
+            GST_LOG("setting \"zeroCopyInput\" to \"%s\"\n",
+                viddec2->zeroCopyInput ? "TRUE" : "FALSE");
+            break;
+        case PROP_QOS:
+            viddec2->qos = g_value_get_boolean(value);
+            GST_LOG("setting \"qos\" to \"%s\"\n",
+                viddec2->qos ? "TRUE" : "FALSE");
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -624,6 +685,12 @@ static void gst_tividdec2_get_property(GObject *object, guint prop_id,
         case PROP_PAD_ALLOC_OUTBUFS:
             g_value_set_boolean(value, viddec2->padAllocOutbufs);
             break;
+        case PROP_ZERO_COPY_INPUT:
+            g_value_set_boolean(value, viddec2->zeroCopyInput);
+            break;
+        case PROP_QOS:
+            g_value_set_boolean(value, viddec2->qos);
+            break;
         case PROP_RTCODECTHREAD:
             g_value_set_boolean(value, viddec2->rtCodecThread);
             break;
@@ -871,9 +938,13 @@ static gboolean gst_tividdec2_sink_event(GstPad *pad, GstEvent *event)
     switch (GST_EVENT_TYPE(event)) {
 
         case GST_EVENT_NEWSEGMENT:
-            /* if event format is byte then convert in time format */
+            /* if event format is byte then convert in time format.  The
+             * decode thread reads the segment under the object lock.
+             */
+            GST_OBJECT_LOCK(viddec2);
             gst_ti_parse_newsegment(&event, viddec2->segment, 
                 &viddec2->totalDuration, viddec2->totalBytes);
+            GST_OBJECT_UNLOCK(viddec2);
 
             /* Propagate NEWSEGMENT to downstream elements */
             ret = gst_pad_push_event(viddec2->srcpad, event);
@@ -892,6 +963,20 @@ static gboolean gst_tividdec2_sink_event(GstPad *pad, GstEvent *event)
             break;
 
         case GST_EVENT_FLUSH_STOP:
+            /* The decoder needs the SPS and PPS again after a seek */
+            viddec2->queue_sps_pps = (viddec2->sps_pps_data != NULL);
+
+            /* Timestamps from before the seek must not be handed out to
+             * the frames after it.  The decode thread owns tsReorder, so it
+             * resets it itself before looking at the data queued from now
+             * on.
+             */
+            gst_ticircbuffer_reset_timestamps(viddec2->circBuf);
+            g_atomic_int_set(&viddec2->tsReset, TRUE);
+
+            /* Lateness reported before the seek no longer applies */
+            gst_tividdec2_reset_qos(viddec2);
+
             ret = gst_pad_push_event(viddec2->srcpad, event);
             break;
 
@@ -917,6 +1002,47 @@ static gboolean gst_tividdec2_sink_event(GstPad *pad, GstEvent *event)
 
 }
 
+
+/******************************************************************************
+ * gst_tividdec2_src_event
+ *     Track QoS events from downstream, and pass every event on upstream.
+ ******************************************************************************/
+static gboolean gst_tividdec2_src_event(GstPad *pad, GstEvent *event)
+{
+    GstTIViddec2     *viddec2;
+    GstClockTimeDiff  diff;
+    GstClockTime      timestamp;
+    gdouble           proportion;
+
+    viddec2 = GST_TIVIDDEC2(GST_OBJECT_PARENT(pad));
+
+    GST_DEBUG("pad \"%s\" received:  %s\n", GST_PAD_NAME(pad),
+        GST_EVENT_TYPE_NAME(event));
+
+    if (GST_EVENT_TYPE(event) == GST_EVENT_QOS) {
+        gst_event_parse_qos(event, &proportion, &diff, &timestamp);
+
+        /* While the sink is late, expect it to fall further behind before
+         * the frames we drop let it catch up: frames up to twice as late
+         * as the one it reported on are not worth decoding.
+         */
+        GST_OBJECT_LOCK(viddec2);
+        viddec2->proportion = proportion;
+        if (GST_CLOCK_TIME_IS_VALID(timestamp) && diff > 0) {
+            viddec2->earliestTime = timestamp + 2 * diff;
+        }
+        else {
+            viddec2->earliestTime = GST_CLOCK_TIME_NONE;
+        }
+        GST_OBJECT_UNLOCK(viddec2);
+
+        GST_LOG("QoS proportion %g, jitter %" G_GINT64_FORMAT " at %"
+            GST_TIME_FORMAT, proportion, diff, GST_TIME_ARGS(timestamp));
+    }
+
+    return gst_pad_event_default(pad, event);
+}
+
 /******************************************************************************
  * gst_tividdec2_populate_codec_header
  *  This function parses codec_data field to get addition H.264/MPEG-4 header 
@@ -937,7 +1063,7 @@ static gboolean gst_tividdec2_populate_codec_header (GstTIViddec2 *viddec2,
         GST_LOG("Parsing codec data to get SPS, PPS and NAL headers");
         viddec2->nal_length = gst_h264_get_nal_length(buf);
         viddec2->sps_pps_data = gst_h264_get_sps_pps_data(buf);
-        viddec2->nal_code_prefix = gst_h264_get_nal_prefix_code();
+        viddec2->queue_sps_pps = TRUE;
     }
 
     if (gst_is_mpeg4_decoder(viddec2->codecName) && 
@@ -960,15 +1086,17 @@ static gboolean gst_tividdec2_parse_and_queue_buffer(GstTIViddec2 *viddec2,
     if (viddec2->sps_pps_data) {
         /* If demuxer has passed SPS and PPS NAL unit dump in codec_data field,
          * then we have a packetized h264 stream. We need to transform this 
-         * stream into byte-stream.
+         * stream into byte-stream.  The SPS and PPS only go in front of the
+         * first buffer after the codec is opened or the stream is flushed.
          */
-        if (gst_h264_parse_and_queue(viddec2->circBuf, buf, 
-                viddec2->sps_pps_data, viddec2->nal_code_prefix,
-                viddec2->nal_length) < 0) {
+        if (!gst_h264_parse_and_queue(viddec2->circBuf, buf, 
+                viddec2->queue_sps_pps ? viddec2->sps_pps_data : NULL,
+                viddec2->nal_length)) {
             GST_ELEMENT_ERROR(viddec2, RESOURCE, WRITE,
             ("Failed to queue input buffer into circular buffer\n"), (NULL));
             return FALSE;
         }
+        viddec2->queue_sps_pps = FALSE;
     }
     else if (viddec2->mpeg4_quicktime_header) {
         /* If demuxer has passed codec_data field then we need to prefix this
@@ -1039,6 +1167,13 @@ static GstFlowReturn gst_tividdec2_chain(GstPad * pad, GstBuffer * buf)
             GST_BUFFER_TIMESTAMP(buf) : 0ULL;
     }
 
+    /* Remember where the data stamped with this buffer's timestamp starts,
+     * so the decode thread can pick it up again whatever the parser does
+     * to the data.
+     */
+    gst_ticircbuffer_mark_timestamp(viddec2->circBuf,
+        GST_BUFFER_TIMESTAMP(buf));
+
     /* Parse and queue the encoded data stream into a circular buffer */
     if (!gst_tividdec2_parse_and_queue_buffer(viddec2, buf)) {
         GST_ELEMENT_ERROR(viddec2, RESOURCE, WRITE,
@@ -1214,17 +1349,13 @@ static gboolean gst_tividdec2_exit_video(GstTIViddec2 *viddec2)
         viddec2->sps_pps_data = NULL;
     }
 
-    if (viddec2->nal_code_prefix) {
-        GST_LOG("freeing nal code prefix buffers\n");
-        gst_buffer_unref(viddec2->nal_code_prefix);
-        viddec2->nal_code_prefix = NULL;
-    }
-
     if (viddec2->nal_length) {
         GST_LOG("reseting nal length to zero\n");
         viddec2->nal_length = 0;
     }
 
+    viddec2->queue_sps_pps = FALSE;
+
     if (viddec2->mpeg4_quicktime_header) {
         GST_LOG("reseting quicktime mpeg4 header to NULL\n");
         viddec2->mpeg4_quicktime_header = NULL;
@@ -1274,7 +1405,12 @@ static GstStateChangeReturn gst_tividdec2_change_state(GstElement *element,
             break;
 
         case GST_STATE_CHANGE_READY_TO_PAUSED:
+            GST_OBJECT_LOCK(viddec2);
             gst_segment_init(viddec2->segment, GST_FORMAT_TIME);
+            GST_OBJECT_UNLOCK(viddec2);
+            gst_tividdec2_reset_qos(viddec2);
+            viddec2->framesProcessed  = 0;
+            viddec2->framesDropped    = 0;
             break;
 
         case GST_STATE_CHANGE_PAUSED_TO_READY:
@@ -1307,6 +1443,11 @@ static gboolean gst_tividdec2_codec_stop (GstTIViddec2  *viddec2)
         gst_ticircbuffer_unref(circBuf);
     }
 
+    if (viddec2->tsReorder) {
+        gst_tiptsreorder_free(viddec2->tsReorder);
+        viddec2->tsReorder = NULL;
+    }
+
     if (viddec2->hOutBufTab) {
         GST_LOG("freeing output buffers\n");
         gst_tidmaibuftab_unref(viddec2->hOutBufTab);
@@ -1454,6 +1595,13 @@ static gboolean gst_tividdec2_codec_start (GstTIViddec2  *viddec2,
     /* Display buffer contents if displayBuffer=TRUE was specified */
     gst_ticircbuffer_set_display(viddec2->circBuf, viddec2->displayBuffer);
 
+    /* Decode contiguous input in place if zeroCopyInput=TRUE was specified */
+    gst_ticircbuffer_set_zero_copy(viddec2->circBuf, viddec2->zeroCopyInput);
+
+    /* Track input timestamps until the frames they belong to are displayed */
+    viddec2->tsReorder = gst_tiptsreorder_new();
+    viddec2->tsReset   = FALSE;
+
     /* Define the number of display buffers to allocate.  This number must be
      * at least 2, but should be more if codecs don't return a display buffer
      * after every process call.  If this has not been set via set_property(),
@@ -1567,8 +1715,16 @@ static void* gst_tividdec2_decode_thread(void *arg)
     Buffer_Handle  hDstBuf;
     Buffer_Handle  hFreeBuf;
     Int32          encDataConsumed;
+    Int32          flushedBytes;
     GstClockTime   encDataTime;
+    GstClockTime   outTime;
+    GstClockTime   skippedTime;
     GstClockTime   frameDuration;
+    XDAS_Int32     skipMode       = IVIDEO_NO_SKIP;
+    XDAS_Int32     wantSkipMode;
+    gboolean       canSkip        = TRUE;
+    GHashTable    *skipBufs       = g_hash_table_new(NULL, NULL);
+    gboolean       tsResync       = FALSE;
     Buffer_Handle  hEncDataWindow;
     GstBuffer     *outBuf;
     Int            bufIdx;
@@ -1598,7 +1754,41 @@ static void* gst_tividdec2_decode_thread(void *arg)
 
         /* Obtain an encoded data frame */
         encDataWindow  = gst_ticircbuffer_get_data(viddec2->circBuf);
-        encDataTime    = GST_BUFFER_TIMESTAMP(encDataWindow);
+
+        if (g_atomic_int_compare_and_exchange(&viddec2->tsReset, TRUE,
+                FALSE)) {
+            GST_LOG("forgetting the timestamps from before the flush\n");
+            gst_tiptsreorder_reset(viddec2->tsReorder);
+            g_hash_table_remove_all(skipBufs);
+            tsResync = TRUE;
+        }
+
+        /* Data queued before a flush is thrown away without decoding it */
+        flushedBytes = gst_ticircbuffer_flushed_bytes(viddec2->circBuf);
+        if (flushedBytes > 0 && GST_BUFFER_SIZE(encDataWindow) > 0) {
+            GST_LOG("discarding %ld bytes queued before the flush\n",
+                flushedBytes);
+            ret = gst_ticircbuffer_data_consumed(viddec2->circBuf,
+                      encDataWindow, MIN(flushedBytes,
+                          (Int32) GST_BUFFER_SIZE(encDataWindow)));
+            encDataWindow = NULL;
+
+            if (!ret) {
+                goto thread_failure;
+            }
+            continue;
+        }
+
+        encDataTime    = gst_ticircbuffer_get_timestamp(viddec2->circBuf);
+
+        /* Frames counted without timestamps carry on from the first input
+         * timestamp after the flush.
+         */
+        if (tsResync && GST_CLOCK_TIME_IS_VALID(encDataTime)) {
+            viddec2->totalDuration = encDataTime;
+            tsResync               = FALSE;
+        }
+
         hEncDataWindow = GST_TIDMAIBUFFERTRANSPORT_DMAIBUF(encDataWindow);
 
         /* If we received a data frame of zero size, there is no more data to
@@ -1671,6 +1861,25 @@ static void* gst_tividdec2_decode_thread(void *arg)
         /* Make sure the whole buffer is used for output */
         BufferGfx_resetDimensions(hDstBuf);
 
+        /* While we are late, have the codec skip B frames instead of
+         * decoding them for nothing.  Codecs that can't do it refuse the
+         * parameter change, and late B frames are dropped after decoding.
+         */
+        if (canSkip && !codecFlushed) {
+            wantSkipMode =
+                gst_tividdec2_frame_is_late(viddec2, encDataTime) ?
+                IVIDEO_SKIP_B : IVIDEO_NO_SKIP;
+
+            if (wantSkipMode != skipMode) {
+                if (gst_tividdec2_set_frame_skip(viddec2, wantSkipMode)) {
+                    skipMode = wantSkipMode;
+                }
+                else {
+                    canSkip = FALSE;
+                }
+            }
+        }
+
         /* Invoke the video decoder */
         GST_LOG("invoking the video decoder\n");
         codecRet        = Vdec2_process(viddec2->hVd, hEncDataWindow, hDstBuf);
@@ -1725,6 +1934,23 @@ static void* gst_tividdec2_decode_thread(void *arg)
             continue;
         }
 
+        /* Remember the timestamp of the frame decoded into hDstBuf until the
+         * codec hands it back for display, which may be several calls later.
+         */
+        if (!codecFlushed) {
+            gst_tiptsreorder_add(viddec2->tsReorder, hDstBuf, encDataTime);
+
+            /* Remember which frames were decoded with B frames skipped, as
+             * the skip mode may have changed by the time they come back.
+             */
+            if (skipMode != IVIDEO_NO_SKIP) {
+                g_hash_table_insert(skipBufs, hDstBuf, hDstBuf);
+            }
+            else {
+                g_hash_table_remove(skipBufs, hDstBuf);
+            }
+        }
+
         /* Resize the BufTab after the first frame has been processed.  The
          * codec may not know it's buffer requirements before the first frame
          * has been decoded.
@@ -1747,6 +1973,9 @@ static void* gst_tividdec2_decode_thread(void *arg)
         /* If we were given back decoded frame, push it to the source pad */
         while (hDstBuf) {
 
+            /* A displayed frame was not skipped */
+            g_hash_table_remove(skipBufs, hDstBuf);
+
             /* Set the source pad capabilities based on the decoded frame
              * properties.
              */
@@ -1763,19 +1992,52 @@ static void* gst_tividdec2_decode_thread(void *arg)
                 gst_ti_correct_display_bufSize(hDstBuf));
             gst_buffer_set_caps(outBuf, GST_PAD_CAPS(viddec2->srcpad));
 
-            /* Set output buffer timestamp */ 
-            if (viddec2->genTimeStamps) {
-                GST_BUFFER_TIMESTAMP(outBuf) = viddec2->totalDuration;
-                GST_BUFFER_DURATION(outBuf)  = frameDuration; 
-                viddec2->totalDuration       += GST_BUFFER_DURATION(outBuf);
+            /* A frame decoded before a flush is from before the seek */
+            if (gst_tiptsreorder_take_stale(viddec2->tsReorder, hDstBuf)) {
+                GST_LOG("dropping frame decoded before the flush\n");
+                gst_buffer_unref(outBuf);
+
+                hDstBuf = Vdec2_getDisplayBuf(viddec2->hVd);
+                continue;
             }
-            else {
-                GST_BUFFER_TIMESTAMP(outBuf) = GST_CLOCK_TIME_NONE;
+
+            /* Set output buffer timestamp.  Frames come back in display
+             * order, so they get the input timestamps re-ordered.  If the
+             * stream carries no timestamps, fall back to counting frames
+             * when genTimeStamps is set.
+             */
+            outTime = gst_tiptsreorder_display(viddec2->tsReorder, hDstBuf,
+                          frameDuration);
+
+            if (!GST_CLOCK_TIME_IS_VALID(outTime) && viddec2->genTimeStamps) {
+                outTime = viddec2->totalDuration;
+            }
+
+            GST_BUFFER_TIMESTAMP(outBuf) = outTime;
+            if (GST_CLOCK_TIME_IS_VALID(outTime)) {
+                GST_BUFFER_DURATION(outBuf) = frameDuration;
+                viddec2->totalDuration      = outTime + frameDuration;
             }
 
             /* Tell circular buffer how much time we consumed */
             gst_ticircbuffer_time_consumed(viddec2->circBuf, frameDuration);
 
+            /* A late frame no other frame is predicted from would only be
+             * thrown away by the sink: drop it here instead.
+             */
+            if (gst_tividdec2_frame_is_late(viddec2,
+                    GST_BUFFER_TIMESTAMP(outBuf)) &&
+                gst_tividdec2_frame_is_droppable(hDstBuf)) {
+                GST_LOG("dropping late frame with timestamp %" GST_TIME_FORMAT,
+                    GST_TIME_ARGS(GST_BUFFER_TIMESTAMP(outBuf)));
+                gst_tividdec2_post_qos(viddec2, GST_BUFFER_TIMESTAMP(outBuf),
+                    GST_BUFFER_DURATION(outBuf));
+                gst_buffer_unref(outBuf);
+
+                hDstBuf = Vdec2_getDisplayBuf(viddec2->hVd);
+                continue;
+            }
+
             /* Push the transport buffer to the source pad */
             GST_LOG("pushing buffer to source pad with timestamp : %" 
                     GST_TIME_FORMAT ", duration: %" GST_TIME_FORMAT,
@@ -1786,6 +2048,7 @@ static void* gst_tividdec2_decode_thread(void *arg)
                 GST_DEBUG("push to source pad failed\n");
                 goto thread_failure;
             }
+            viddec2->framesProcessed++;
 
             hDstBuf = Vdec2_getDisplayBuf(viddec2->hVd);
         }
@@ -1793,6 +2056,19 @@ static void* gst_tividdec2_decode_thread(void *arg)
         /* Release buffers no longer in use by the codec */
         hFreeBuf = Vdec2_getFreeBuf(viddec2->hVd);
         while (hFreeBuf) {
+            skippedTime =
+                gst_tiptsreorder_release(viddec2->tsReorder, hFreeBuf);
+
+            /* A frame the codec skipped comes back without being displayed */
+            if (g_hash_table_remove(skipBufs, hFreeBuf) &&
+                GST_CLOCK_TIME_IS_VALID(skippedTime)) {
+                GST_LOG("codec skipped late frame with timestamp %"
+                    GST_TIME_FORMAT, GST_TIME_ARGS(skippedTime));
+                gst_ticircbuffer_time_consumed(viddec2->circBuf,
+                    frameDuration);
+                gst_tividdec2_post_qos(viddec2, skippedTime, frameDuration);
+            }
+
             Buffer_freeUseMask(hFreeBuf, gst_tidmaibuffer_CODEC_FREE);
             hFreeBuf = Vdec2_getFreeBuf(viddec2->hVd);
         }
@@ -1845,6 +2121,7 @@ thread_exit:
         GST_ERROR("failed to stop codec\n");
     }
 
+    g_hash_table_destroy(skipBufs);
     gst_object_unref(viddec2);
 
     GST_LOG("exit video decode_thread (%d)\n", (int)threadRet);
@@ -1976,6 +2253,125 @@ static gboolean gst_tividdec2_resizeBufTab(GstTIViddec2 *viddec2)
 }
 
 
+/******************************************************************************
+ * gst_tividdec2_reset_qos
+ *    Forget how late downstream said we were.
+ ******************************************************************************/
+static void gst_tividdec2_reset_qos(GstTIViddec2 *viddec2)
+{
+    GST_OBJECT_LOCK(viddec2);
+    viddec2->proportion   = 1.0;
+    viddec2->earliestTime = GST_CLOCK_TIME_NONE;
+    GST_OBJECT_UNLOCK(viddec2);
+}
+
+
+/******************************************************************************
+ * gst_tividdec2_frame_is_late
+ *    Return TRUE if the frame with this timestamp would reach the sink too
+ *    late, going by the last QoS event.
+ ******************************************************************************/
+static gboolean gst_tividdec2_frame_is_late(GstTIViddec2 *viddec2,
+                    GstClockTime timestamp)
+{
+    GstClockTime earliestTime;
+    GstClockTime runningTime;
+
+    if (!viddec2->qos || !GST_CLOCK_TIME_IS_VALID(timestamp)) {
+        return FALSE;
+    }
+
+    GST_OBJECT_LOCK(viddec2);
+    earliestTime = viddec2->earliestTime;
+    runningTime  = gst_segment_to_running_time(viddec2->segment,
+                       GST_FORMAT_TIME, timestamp);
+    GST_OBJECT_UNLOCK(viddec2);
+
+    if (!GST_CLOCK_TIME_IS_VALID(earliestTime)) {
+        return FALSE;
+    }
+
+    return GST_CLOCK_TIME_IS_VALID(runningTime) && runningTime <= earliestTime;
+}
+
+
+/******************************************************************************
+ * gst_tividdec2_frame_is_droppable
+ *    Return TRUE if no other frame is predicted from the one in hBuf.
+ ******************************************************************************/
+static gboolean gst_tividdec2_frame_is_droppable(Buffer_Handle hBuf)
+{
+    Int32 frameType = BufferGfx_getFrameType(hBuf);
+
+    return frameType == IVIDEO_B_FRAME || frameType == IVIDEO_BB_FRAME;
+}
+
+
+/******************************************************************************
+ * gst_tividdec2_set_frame_skip
+ *    Tell the codec which frame types not to decode.  Returns FALSE if the
+ *    codec doesn't support it.
+ ******************************************************************************/
+static gboolean gst_tividdec2_set_frame_skip(GstTIViddec2 *viddec2,
+                    XDAS_Int32 skipMode)
+{
+    VIDDEC2_DynamicParams dynParams = Vdec2_DynamicParams_DEFAULT;
+    VIDDEC2_Status        decStatus;
+
+    dynParams.frameSkipMode = skipMode;
+    decStatus.size          = sizeof(VIDDEC2_Status);
+
+    if (VIDDEC2_control(Vdec2_getVisaHandle(viddec2->hVd), XDM_SETPARAMS,
+            &dynParams, &decStatus) != VIDDEC2_EOK) {
+        GST_WARNING("codec can't skip frames; late B frames will be decoded "
+            "and dropped\n");
+        return FALSE;
+    }
+
+    GST_LOG("frame skip mode set to %d\n", (int)skipMode);
+    return TRUE;
+}
+
+
+/******************************************************************************
+ * gst_tividdec2_post_qos
+ *    Count a frame dropped for being late and tell the application about it.
+ ******************************************************************************/
+static void gst_tividdec2_post_qos(GstTIViddec2 *viddec2,
+                GstClockTime timestamp, GstClockTime duration)
+{
+    GstClockTime     runningTime;
+    GstClockTime     streamTime;
+    GstClockTime     earliestTime;
+    GstClockTimeDiff jitter = 0;
+    gdouble          proportion;
+    GstMessage      *msg;
+
+    viddec2->framesDropped++;
+
+    GST_OBJECT_LOCK(viddec2);
+    runningTime  = gst_segment_to_running_time(viddec2->segment,
+                       GST_FORMAT_TIME, timestamp);
+    streamTime   = gst_segment_to_stream_time(viddec2->segment,
+                       GST_FORMAT_TIME, timestamp);
+    proportion   = viddec2->proportion;
+    earliestTime = viddec2->earliestTime;
+    GST_OBJECT_UNLOCK(viddec2);
+
+    if (GST_CLOCK_TIME_IS_VALID(earliestTime) &&
+        GST_CLOCK_TIME_IS_VALID(runningTime)) {
+        jitter = GST_CLOCK_DIFF(runningTime, earliestTime);
+    }
+
+    msg = gst_message_new_qos(GST_OBJECT(viddec2), FALSE, runningTime,
+              streamTime, timestamp, duration);
+    gst_message_set_qos_values(msg, jitter, proportion, 1000000);
+    gst_message_set_qos_stats(msg, GST_FORMAT_BUFFERS,
+        viddec2->framesProcessed, viddec2->framesDropped);
+    gst_element_post_message(GST_ELEMENT(viddec2), msg);
+}
+
+
 /******************************************************************************
  * Custom ViM Settings for editing this file
  ******************************************************************************/
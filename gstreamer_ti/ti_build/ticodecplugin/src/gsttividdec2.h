@@ -28,6 +28,7 @@
 #include <gst/gst.h>
 #include "gstticircbuffer.h"
 #include "gsttidmaibuftab.h"
+#include "gsttiptsreorder.h"
 
 #include <xdc/std.h>
 #include <ti/sdo/ce/Engine.h>
@@ -70,6 +71,7 @@ struct _GstTIViddec2
   gboolean       displayBuffer;
   gboolean       genTimeStamps;
   gboolean       rtCodecThread;
+  gboolean       qos;
 
   /* Element state */
   Engine_Handle    hEngine;
@@ -93,21 +95,34 @@ struct _GstTIViddec2
   GstTIDmaiBufTab *hOutBufTab;
   GstTICircBuffer *circBuf;
   gboolean         padAllocOutbufs;
+  gboolean         zeroCopyInput;
 
   /* Quicktime h264 header  */
   GstBuffer       *sps_pps_data;
-  GstBuffer       *nal_code_prefix;
   guint           nal_length;
+  gboolean        queue_sps_pps;
 
-  /* Segment handling */
+  /* Segment handling, protected by the object lock */
   GstSegment      *segment;
 
   /* Buffer timestamp */
   gint64          totalDuration;
   guint64         totalBytes;
+  GstTIPtsReorder *tsReorder;
+
+  /* Set on a flush, for the decode thread to reset tsReorder */
+  gint            tsReset;
 
   /* Quicktime MPEG4 header */
   GstBuffer       *mpeg4_quicktime_header;
+
+  /* Quality of service, from QoS events on the source pad.  proportion and
+   * earliestTime are protected by the object lock.
+   */
+  gdouble          proportion;
+  GstClockTime     earliestTime;
+  guint64          framesProcessed;
+  guint64          framesDropped;
 };
 
 /* _GstTIViddec2Class object */
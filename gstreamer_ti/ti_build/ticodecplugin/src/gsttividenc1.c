@@ -69,6 +69,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_tividenc1_debug);
 #define     DEFAULT_CONTIG_INPUT_BUF    FALSE
 #define     DEFAULT_GENTIMESTAMP        TRUE
 #define     DEFAULT_ENGINE_NAME         "unspecified"
+#define     DEFAULT_QUEUE_SIZE          0
+#define     DEFAULT_RTCODECTHREAD       TRUE
 
 #if defined(Platform_dm365) || defined(Platform_dm368) || defined(Platform_dm6467) \
     || defined(Platform_dm6467t)
@@ -100,7 +102,11 @@ enum
   PROP_GEN_TIMESTAMPS,  /* genTimeStamps  (boolean) */
   PROP_RATE_CTRL_PRESET,/* rateControlPreset  (gint) */
   PROP_ENCODING_PRESET, /* encodingPreset  (gint) */
-  PROP_BYTE_STREAM      /* byteStream      (gboolean) */
+  PROP_BYTE_STREAM,     /* byteStream      (gboolean) */
+  PROP_QUEUE_SIZE,      /* queueSize       (int)      */
+  PROP_RTCODECTHREAD,   /* rtCodecThread   (boolean)  */
+  PROP_LATENCY,         /* latency         (guint64)  */
+  PROP_THROUGHPUT       /* throughput      (gdouble)  */
 
 };
 
@@ -182,6 +188,23 @@ static gboolean
  gst_tividenc1_codec_start (GstTIVidenc1 *videnc1);
 static gboolean
  gst_tividenc1_codec_stop (GstTIVidenc1 *videnc1);
+static Buffer_Handle
+ gst_tividenc1_get_out_buf (GstTIVidenc1 *videnc1);
+static void
+ gst_tividenc1_frame_done (GstTIVidenc1 *videnc1, GstClockTime queued);
+static gboolean
+ gst_tividenc1_start_encode_thread (GstTIVidenc1 *videnc1);
+static void
+ gst_tividenc1_stop_encode_thread (GstTIVidenc1 *videnc1);
+static void*
+ gst_tividenc1_encode_thread(void *arg);
+static GstFlowReturn
+ gst_tividenc1_queue_frame (GstTIVidenc1 *videnc1, GstBuffer *buf,
+     GstClockTime queued);
+static void
+ gst_tividenc1_drain_queue (GstTIVidenc1 *videnc1);
+static GstBuffer*
+ gst_tividenc1_copy_input (GstTIVidenc1 *videnc1, GstBuffer *inBuf);
 
 /******************************************************************************
  * gst_tividenc1_class_init_trampoline
@@ -313,6 +336,13 @@ static void gst_tividenc1_class_init(GstTIVidenc1Class *klass)
             "\n\t\t\t3 - High speed",
             1, G_MAXINT32, DEFAULT_ENCODING_PRESET, G_PARAM_READWRITE));
 
+    g_object_class_install_property(gobject_class, PROP_NUM_OUTPUT_BUFS,
+        g_param_spec_int("numOutputBufs",
+            "Number of Ouput Buffers",
+            "Number of output buffers to allocate for codec; encoded frames "
+            "are pushed in these, so this is how many can be downstream",
+            2, G_MAXINT32, DEFAULT_NUMOUTPUT_BUFS, G_PARAM_READWRITE));
+
     g_object_class_install_property(gobject_class, PROP_FRAMERATE,
         gst_param_spec_fraction("framerate", "frame rate of video",
             "Frame rate of the video expressed as a fraction.  A value "
@@ -333,6 +363,30 @@ static void gst_tividenc1_class_init(GstTIVidenc1Class *klass)
         g_param_spec_boolean("genTimeStamps", "Generate Time Stamps",
             "Set timestamps on output buffers",
             DEFAULT_GENTIMESTAMP, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_QUEUE_SIZE,
+        g_param_spec_int("queueSize",
+            "Input queue size",
+            "Number of input frames queued for a separate encode thread, so "
+            "capture and input copies overlap encoding; 0 encodes each frame "
+            "in the streaming thread",
+            0, G_MAXINT32, DEFAULT_QUEUE_SIZE, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_RTCODECTHREAD,
+        g_param_spec_boolean("RTCodecThread", "Real time codec thread",
+            "Run the encode thread (queueSize > 0) with real-time priority",
+            DEFAULT_RTCODECTHREAD, G_PARAM_READWRITE));
+
+    g_object_class_install_property(gobject_class, PROP_LATENCY,
+        g_param_spec_uint64("latency", "Average latency",
+            "Average time in nanoseconds from a complete input frame to its "
+            "encoded frame, over the current or last stream",
+            0, G_MAXUINT64, 0, G_PARAM_READABLE));
+
+    g_object_class_install_property(gobject_class, PROP_THROUGHPUT,
+        g_param_spec_double("throughput", "Encoded frames per second",
+            "Frames encoded per second over the current or last stream",
+            0, G_MAXDOUBLE, 0, G_PARAM_READABLE));
 }
 
 /******************************************************************************
@@ -391,7 +445,8 @@ static void gst_tividenc1_init(GstTIVidenc1 *videnc1, GstTIVidenc1Class *gclass)
 
     videnc1->sinkAdapter            = NULL;
     videnc1->inBufMetadata          = NULL;
-    videnc1->hEncOutBuf             = NULL;
+    videnc1->hOutBufTab             = NULL;
+    videnc1->numOutputBufs          = DEFAULT_NUMOUTPUT_BUFS;
     videnc1->hContigInBuf           = DEFAULT_CONTIG_INPUT_BUF;
     videnc1->hInBufRef              = NULL;
     videnc1->zeroCopyEncode         = FALSE;
@@ -410,6 +465,15 @@ static void gst_tividenc1_init(GstTIVidenc1 *videnc1, GstTIVidenc1Class *gclass)
     videnc1->encodingPreset         = DEFAULT_ENCODING_PRESET;
     videnc1->byteStream             = DEFAULT_BYTE_STREAM;
     videnc1->codec_data             = NULL;
+    videnc1->queueSize              = DEFAULT_QUEUE_SIZE;
+    videnc1->rtCodecThread          = DEFAULT_RTCODECTHREAD;
+    videnc1->queue                  = NULL;
+    videnc1->hInBufTab              = NULL;
+    videnc1->numFramesEncoded       = 0;
+    videnc1->latencyTotal           = 0;
+    videnc1->latencyMax             = 0;
+    videnc1->firstFrameTime         = GST_CLOCK_TIME_NONE;
+    videnc1->lastFrameTime          = GST_CLOCK_TIME_NONE;
 
     /* Initialize GValue members */
     memset(&videnc1->framerate, 0, sizeof(GValue));
@@ -499,6 +563,11 @@ static void gst_tividenc1_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"encodingPreset\" to \"%d\" \n",
                      videnc1->encodingPreset);
             break;
+        case PROP_NUM_OUTPUT_BUFS:
+            videnc1->numOutputBufs = g_value_get_int(value);
+            GST_LOG("setting \"numOutputBufs\" to \"%d\"\n",
+                videnc1->numOutputBufs);
+            break;
         case PROP_FRAMERATE:
         {
             g_value_copy(value, &videnc1->framerate);
@@ -522,6 +591,16 @@ static void gst_tividenc1_set_property(GObject *object, guint prop_id,
             GST_LOG("setting \"genTimeStamps\" to \"%s\"\n",
                 videnc1->genTimeStamps ? "TRUE" : "FALSE");
             break;
+        case PROP_QUEUE_SIZE:
+            videnc1->queueSize = g_value_get_int(value);
+            GST_LOG("setting \"queueSize\" to \"%d\"\n",
+                videnc1->queueSize);
+            break;
+        case PROP_RTCODECTHREAD:
+            videnc1->rtCodecThread = g_value_get_boolean(value);
+            GST_LOG("setting \"RTCodecThread\" to \"%s\"\n",
+                videnc1->rtCodecThread ? "TRUE" : "FALSE");
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -572,9 +651,38 @@ static void gst_tividenc1_get_property(GObject *object, guint prop_id,
         case PROP_RATE_CTRL_PRESET:
             g_value_set_int(value, videnc1->rateControlPreset);
             break;
+        case PROP_NUM_OUTPUT_BUFS:
+            g_value_set_int(value, videnc1->numOutputBufs);
+            break;
         case PROP_BITRATE:
             g_value_set_int(value, videnc1->bitRate);
             break;
+        case PROP_QUEUE_SIZE:
+            g_value_set_int(value, videnc1->queueSize);
+            break;
+        case PROP_RTCODECTHREAD:
+            g_value_set_boolean(value, videnc1->rtCodecThread);
+            break;
+        case PROP_LATENCY:
+            /* The encode thread updates the counters under the object lock */
+            GST_OBJECT_LOCK(videnc1);
+            g_value_set_uint64(value, videnc1->numFramesEncoded ?
+                videnc1->latencyTotal / videnc1->numFramesEncoded : 0);
+            GST_OBJECT_UNLOCK(videnc1);
+            break;
+        case PROP_THROUGHPUT:
+            GST_OBJECT_LOCK(videnc1);
+            if (videnc1->numFramesEncoded > 1 &&
+                videnc1->lastFrameTime > videnc1->firstFrameTime) {
+                g_value_set_double(value,
+                    (gdouble) videnc1->numFramesEncoded * GST_SECOND /
+                    (videnc1->lastFrameTime - videnc1->firstFrameTime));
+            }
+            else {
+                g_value_set_double(value, 0);
+            }
+            GST_OBJECT_UNLOCK(videnc1);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
             break;
@@ -791,7 +899,21 @@ static gboolean gst_tividenc1_sink_event(GstPad *pad, GstEvent *event)
             break;
 
         case GST_EVENT_EOS:
+            /* Let the encode thread push every queued frame first */
+            gst_tividenc1_drain_queue(videnc1);
+            ret = gst_pad_push_event(videnc1->srcpad, event);
+            break;
+
         case GST_EVENT_FLUSH_STOP:
+            /* Frames queued before the flush were dropped when their push
+             * failed; start encoding again from here.
+             */
+            if (videnc1->queue) {
+                gst_tividenc1_drain_queue(videnc1);
+                gst_tithread_lock_status(videnc1);
+                videnc1->encodeFlow = GST_FLOW_OK;
+                gst_tithread_unlock_status(videnc1);
+            }
             ret = gst_pad_push_event(videnc1->srcpad, event);
             break;
 
@@ -959,21 +1081,36 @@ static GstFlowReturn gst_tividenc1_chain(GstPad * pad, GstBuffer * buf)
            videnc1->upstreamBufSize) {
         GstBuffer     *qBuf;
         GstBuffer     *outBuf;
+        GstClockTime   queued;
+        GstFlowReturn  flowRet;
 
         qBuf = gst_adapter_take_buffer(videnc1->sinkAdapter,
                    videnc1->upstreamBufSize);
+        queued = gst_util_get_timestamp();
+
+        /* With an encode thread, hand the frame over and go back upstream
+         * for the next one while this one is encoded.
+         */
+        if (videnc1->queue) {
+            flowRet = gst_tividenc1_queue_frame(videnc1, qBuf, queued);
+            if (flowRet != GST_FLOW_OK) {
+                return flowRet;
+            }
+            continue;
+        }
 
+        /* gst_tividenc1_encode releases qBuf, whether it succeeds or not */
         if (gst_tividenc1_encode(videnc1, qBuf, &outBuf) != GST_FLOW_OK) {
             GST_ELEMENT_ERROR(videnc1, RESOURCE, WRITE,
             ("Failed to encode input buffer\n"), (NULL));
             return GST_FLOW_UNEXPECTED;
         }
+        gst_tividenc1_frame_done(videnc1, queued);
 
         /* Parse and Push the transport buffer to the source pad */
         GST_LOG("pushing display buffer to source pad\n");
         if (gst_tividenc1_parse_and_push(videnc1, outBuf) != GST_FLOW_OK) {
             GST_DEBUG("push to source pad failed\n");
-            gst_buffer_unref(qBuf);
             return GST_FLOW_UNEXPECTED;
         }
     }
@@ -1039,6 +1176,13 @@ static gboolean gst_tividenc1_init_video(GstTIVidenc1 *videnc1)
         return FALSE;
     }
 
+    /* Start the encode thread if frames are to be queued for it */
+    if (videnc1->queueSize > 0 &&
+        !gst_tividenc1_start_encode_thread(videnc1)) {
+        gst_tividenc1_exit_video(videnc1);
+        return FALSE;
+    }
+
     GST_LOG("end init_video\n");
     return TRUE;
 }
@@ -1052,6 +1196,9 @@ static gboolean gst_tividenc1_exit_video(GstTIVidenc1 *videnc1)
 {
     GST_LOG("begin exit_video\n");
 
+    /* Let the encode thread finish the frames it has, and stop it */
+    gst_tividenc1_stop_encode_thread(videnc1);
+
     if (videnc1->sinkAdapter) {
         g_object_unref(videnc1->sinkAdapter);
         videnc1->sinkAdapter = NULL;
@@ -1158,9 +1305,27 @@ static gboolean gst_tividenc1_codec_stop (GstTIVidenc1 *videnc1)
 
     videnc1->zeroCopyEncode = FALSE;
 
-    if (videnc1->hEncOutBuf) {
-        Buffer_delete(videnc1->hEncOutBuf);
-        videnc1->hEncOutBuf = NULL;
+    /* Buffers still downstream keep the BufTab alive until they are freed */
+    if (videnc1->hOutBufTab) {
+        GST_INFO("%u frames encoded, at most %u of %d output buffers "
+            "downstream, waited %u times for one\n",
+            videnc1->numFramesEncoded, videnc1->outBufsHeldPeak,
+            videnc1->numOutputBufs, videnc1->outBufWaits);
+
+        if (videnc1->numFramesEncoded > 0) {
+            GST_INFO("latency %" GST_TIME_FORMAT " average, %" GST_TIME_FORMAT
+                " max; %u frames in %" GST_TIME_FORMAT " (queueSize %d)\n",
+                GST_TIME_ARGS(videnc1->latencyTotal /
+                    videnc1->numFramesEncoded),
+                GST_TIME_ARGS(videnc1->latencyMax), videnc1->numFramesEncoded,
+                GST_TIME_ARGS(videnc1->lastFrameTime -
+                    videnc1->firstFrameTime),
+                videnc1->queueSize);
+        }
+
+        GST_LOG("freeing output buffers\n");
+        gst_tidmaibuftab_unref(videnc1->hOutBufTab);
+        videnc1->hOutBufTab = NULL;
     }
 
     if (videnc1->hVe1) {
@@ -1345,7 +1510,10 @@ static gboolean gst_tividenc1_codec_start (GstTIVidenc1 *videnc1)
         }
     }
 
-    /* Create codec output buffers */
+    /* Create codec output buffers.  Encoded frames are pushed downstream in
+     * them without a copy, and the encoder waits for one to come back when
+     * all of them are in use.
+     */
     GST_LOG("creating output buffer table\n");
     gfxAttrsOut.colorSpace     = videnc1->colorSpace;
     gfxAttrsOut.dim.width      = videnc1->width;
@@ -1355,12 +1523,413 @@ static gboolean gst_tividenc1_codec_start (GstTIVidenc1 *videnc1)
 
     gfxAttrsOut.bAttrs.memParams.align = 128;
 
-    videnc1->hEncOutBuf = Buffer_create(Venc1_getOutBufSize(videnc1->hVe1),
+    /* By default, new buffers are marked as in-use by the codec */
+    gfxAttrsOut.bAttrs.useMask = gst_tidmaibuffer_CODEC_FREE;
+
+    videnc1->hOutBufTab = gst_tidmaibuftab_new(videnc1->numOutputBufs,
+        Venc1_getOutBufSize(videnc1->hVe1),
         BufferGfx_getBufferAttrs(&gfxAttrsOut));
 
+    if (videnc1->hOutBufTab == NULL) {
+        gst_tividenc1_exit_video(videnc1);
+        GST_ELEMENT_ERROR(videnc1, RESOURCE, NO_SPACE_LEFT,
+        ("failed to allocate output buffers for encoder\n"), (NULL));
+        return FALSE;
+    }
+
+    videnc1->outBufsHeldPeak  = 0;
+    videnc1->outBufWaits      = 0;
+
+    GST_OBJECT_LOCK(videnc1);
+    videnc1->numFramesEncoded = 0;
+    videnc1->latencyTotal     = 0;
+    videnc1->latencyMax       = 0;
+    videnc1->firstFrameTime   = GST_CLOCK_TIME_NONE;
+    videnc1->lastFrameTime    = GST_CLOCK_TIME_NONE;
+    GST_OBJECT_UNLOCK(videnc1);
+
     return TRUE;
 }
 
+/******************************************************************************
+ * gst_tividenc1_get_out_buf
+ *   Get a free codec output buffer, waiting for one to be released
+ *   downstream if they are all in use, and keep count of how many are held
+ *   downstream and how often that made the encoder wait.
+ *****************************************************************************/
+static Buffer_Handle gst_tividenc1_get_out_buf(GstTIVidenc1 *videnc1)
+{
+    BufTab_Handle  hBufTab = GST_TIDMAIBUFTAB_BUFTAB(videnc1->hOutBufTab);
+    Buffer_Handle  hBuf;
+    guint          held    = 0;
+    Int            bufIdx;
+
+    for (bufIdx = 0; bufIdx < BufTab_getNumBufs(hBufTab); bufIdx++) {
+        if (Buffer_getUseMask(BufTab_getBuf(hBufTab, bufIdx)) &
+            gst_tidmaibuffer_GST_FREE) {
+            held++;
+        }
+    }
+
+    if (held > videnc1->outBufsHeldPeak) {
+        videnc1->outBufsHeldPeak = held;
+    }
+
+    /* Only this thread takes buffers from the BufTab, so it can switch
+     * blocking off for a first try.
+     */
+    gst_tidmaibuftab_set_blocking(videnc1->hOutBufTab, FALSE);
+    hBuf = gst_tidmaibuftab_get_buf(videnc1->hOutBufTab);
+    gst_tidmaibuftab_set_blocking(videnc1->hOutBufTab, TRUE);
+
+    if (hBuf == NULL) {
+        GST_DEBUG("all %d output buffers are downstream, waiting for one\n",
+            videnc1->numOutputBufs);
+        videnc1->outBufWaits++;
+        hBuf = gst_tidmaibuftab_get_buf(videnc1->hOutBufTab);
+    }
+
+    return hBuf;
+}
+
+/******************************************************************************
+ * gst_tividenc1_frame_done
+ *   Account for a frame taken in at time queued that has just been encoded.
+ *   The counters are read by get_property from other threads, so they are
+ *   only changed under the object lock.
+ *****************************************************************************/
+static void gst_tividenc1_frame_done(GstTIVidenc1 *videnc1, GstClockTime queued)
+{
+    GstClockTime now     = gst_util_get_timestamp();
+    GstClockTime latency = now - queued;
+
+    GST_OBJECT_LOCK(videnc1);
+    if (!GST_CLOCK_TIME_IS_VALID(videnc1->firstFrameTime)) {
+        videnc1->firstFrameTime = queued;
+    }
+    videnc1->lastFrameTime = now;
+
+    videnc1->numFramesEncoded++;
+    videnc1->latencyTotal += latency;
+    if (latency > videnc1->latencyMax) {
+        videnc1->latencyMax = latency;
+    }
+    GST_OBJECT_UNLOCK(videnc1);
+}
+
+/******************************************************************************
+ * gst_tividenc1_start_encode_thread
+ *   Create the input queue and the thread that encodes the frames in it.
+ *****************************************************************************/
+static gboolean gst_tividenc1_start_encode_thread(GstTIVidenc1 *videnc1)
+{
+    struct sched_param  schedParam;
+    pthread_attr_t      attr;
+
+    GST_LOG("starting encode thread, queueSize %d\n", videnc1->queueSize);
+
+    /* Initialize thread status management and the input queue */
+    videnc1->threadStatus = 0UL;
+    pthread_mutex_init(&videnc1->threadStatusMutex, NULL);
+    pthread_cond_init(&videnc1->queueCond, NULL);
+
+    videnc1->queueMax         = videnc1->queueSize;
+    videnc1->queue            = g_new0(GstTIVidenc1Frame, videnc1->queueMax);
+    videnc1->queueHead        = 0;
+    videnc1->queueCount       = 0;
+    videnc1->encoding         = FALSE;
+    videnc1->stopEncodeThread = FALSE;
+    videnc1->encodeFlow       = GST_FLOW_OK;
+
+    /* Initialize custom thread attributes */
+    if (pthread_attr_init(&attr)) {
+        GST_WARNING("failed to initialize thread attrs\n");
+        gst_tividenc1_stop_encode_thread(videnc1);
+        return FALSE;
+    }
+
+    /* Force the thread to use the system scope */
+    if (pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM)) {
+        GST_WARNING("failed to set scope attribute\n");
+        goto attr_fail;
+    }
+
+    /* Force the thread to use custom scheduling attributes */
+    if (pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED)) {
+        GST_WARNING("failed to set schedule inheritance attribute\n");
+        goto attr_fail;
+    }
+
+    /* Set the thread to be fifo real time scheduled */
+    if (pthread_attr_setschedpolicy(&attr, SCHED_FIFO)) {
+        GST_WARNING("failed to set FIFO scheduling policy\n");
+        goto attr_fail;
+    }
+
+    /* Set the encode thread priority */
+    schedParam.sched_priority = GstTIVideoThreadPriority;
+    if (pthread_attr_setschedparam(&attr, &schedParam)) {
+        GST_WARNING("failed to set scheduler parameters\n");
+        goto attr_fail;
+    }
+
+    /* Create encoder thread */
+    if (pthread_create(&videnc1->encodeThread, videnc1->rtCodecThread ?
+            &attr : NULL, gst_tividenc1_encode_thread, (void*)videnc1)) {
+        GST_ELEMENT_ERROR(videnc1, RESOURCE, FAILED,
+        ("failed to create encode thread\n"), (NULL));
+        goto attr_fail;
+    }
+    gst_tithread_set_status(videnc1, TIThread_CODEC_CREATED);
+
+    pthread_attr_destroy(&attr);
+    return TRUE;
+
+attr_fail:
+    pthread_attr_destroy(&attr);
+    gst_tividenc1_stop_encode_thread(videnc1);
+    return FALSE;
+}
+
+/******************************************************************************
+ * gst_tividenc1_stop_encode_thread
+ *   Let the encode thread empty its queue, then join it and free the queue
+ *   and the input buffers.
+ *****************************************************************************/
+static void gst_tividenc1_stop_encode_thread(GstTIVidenc1 *videnc1)
+{
+    gboolean  checkResult;
+    void     *threadRet;
+
+    if (!videnc1->queue) {
+        return;
+    }
+
+    if (gst_tithread_check_status(
+            videnc1, TIThread_CODEC_CREATED, checkResult)) {
+        GST_LOG("shutting down encode thread\n");
+
+        gst_tithread_lock_status(videnc1);
+        videnc1->stopEncodeThread = TRUE;
+        pthread_cond_broadcast(&videnc1->queueCond);
+        gst_tithread_unlock_status(videnc1);
+
+        if (pthread_join(videnc1->encodeThread, &threadRet) == 0) {
+            if (threadRet == GstTIThreadFailure) {
+                GST_DEBUG("encode thread exited with an error condition\n");
+            }
+        }
+    }
+
+    /* Drop anything the thread never got to */
+    while (videnc1->queueCount > 0) {
+        gst_buffer_unref(videnc1->queue[videnc1->queueHead].buf);
+        videnc1->queueHead = (videnc1->queueHead + 1) % videnc1->queueMax;
+        videnc1->queueCount--;
+    }
+
+    g_free(videnc1->queue);
+    videnc1->queue = NULL;
+
+    /* Shut down thread status management */
+    videnc1->threadStatus = 0UL;
+    pthread_cond_destroy(&videnc1->queueCond);
+    pthread_mutex_destroy(&videnc1->threadStatusMutex);
+
+    if (videnc1->hInBufTab) {
+        GST_LOG("freeing input buffers\n");
+        gst_tidmaibuftab_unref(videnc1->hInBufTab);
+        videnc1->hInBufTab = NULL;
+    }
+}
+
+/******************************************************************************
+ * gst_tividenc1_encode_thread
+ *   Encode queued frames in order and push them, until told to stop with the
+ *   queue empty.  After a frame fails to encode or push, the ones behind it
+ *   are dropped and the failure is returned to upstream by the chain
+ *   function, until a flush resets it.
+ *****************************************************************************/
+static void* gst_tividenc1_encode_thread(void *arg)
+{
+    GstTIVidenc1      *videnc1   = GST_TIVIDENC1(gst_object_ref(arg));
+    void              *threadRet = GstTIThreadSuccess;
+    GstTIVidenc1Frame  frame;
+    GstBuffer         *outBuf;
+    GstFlowReturn      flowRet;
+
+    GST_LOG("init video encode_thread\n");
+
+    while (TRUE) {
+
+        /* Wait for a frame, or to be stopped once the queue is empty */
+        gst_tithread_lock_status(videnc1);
+        while (videnc1->queueCount == 0 && !videnc1->stopEncodeThread) {
+            pthread_cond_wait(&videnc1->queueCond,
+                &videnc1->threadStatusMutex);
+        }
+
+        if (videnc1->queueCount == 0) {
+            gst_tithread_unlock_status(videnc1);
+            break;
+        }
+
+        frame = videnc1->queue[videnc1->queueHead];
+        videnc1->queueHead = (videnc1->queueHead + 1) % videnc1->queueMax;
+        videnc1->queueCount--;
+        videnc1->encoding = TRUE;
+        flowRet = videnc1->encodeFlow;
+
+        /* Wake the chain function if it waits for room in the queue */
+        pthread_cond_broadcast(&videnc1->queueCond);
+        gst_tithread_unlock_status(videnc1);
+
+        if (flowRet != GST_FLOW_OK) {
+            gst_buffer_unref(frame.buf);
+        }
+        else if (gst_tividenc1_encode(videnc1, frame.buf, &outBuf) !=
+                 GST_FLOW_OK) {
+            GST_ELEMENT_ERROR(videnc1, RESOURCE, WRITE,
+            ("Failed to encode input buffer\n"), (NULL));
+            flowRet   = GST_FLOW_UNEXPECTED;
+            threadRet = GstTIThreadFailure;
+        }
+        else {
+            gst_tividenc1_frame_done(videnc1, frame.queued);
+
+            GST_LOG("pushing encoded frame to source pad\n");
+            flowRet = gst_tividenc1_parse_and_push(videnc1, outBuf);
+            if (flowRet != GST_FLOW_OK) {
+                GST_DEBUG("push to source pad failed\n");
+            }
+        }
+
+        gst_tithread_lock_status(videnc1);
+        videnc1->encodeFlow = flowRet;
+        videnc1->encoding   = FALSE;
+        pthread_cond_broadcast(&videnc1->queueCond);
+        gst_tithread_unlock_status(videnc1);
+    }
+
+    GST_LOG("exit video encode_thread (%d)\n", (int)threadRet);
+    gst_object_unref(videnc1);
+    return threadRet;
+}
+
+/******************************************************************************
+ * gst_tividenc1_queue_frame
+ *   Queue a complete input frame for the encode thread, waiting while the
+ *   queue is full.  Frames the codec can't use in place are first copied to
+ *   a contiguous input buffer, which overlaps with encoding the frame before.
+ *****************************************************************************/
+static GstFlowReturn gst_tividenc1_queue_frame(GstTIVidenc1 *videnc1,
+    GstBuffer *buf, GstClockTime queued)
+{
+    GstTIVidenc1Frame *frame;
+    GstFlowReturn      flowRet;
+
+    if (!GST_IS_TIDMAIBUFFERTRANSPORT(buf) && !videnc1->zeroCopyEncode) {
+        if (!(buf = gst_tividenc1_copy_input(videnc1, buf))) {
+            GST_ELEMENT_ERROR(videnc1, RESOURCE, NO_SPACE_LEFT,
+            ("failed to get a contiguous input buffer\n"), (NULL));
+            return GST_FLOW_UNEXPECTED;
+        }
+    }
+
+    gst_tithread_lock_status(videnc1);
+    while (videnc1->queueCount == videnc1->queueMax &&
+           videnc1->encodeFlow == GST_FLOW_OK) {
+        pthread_cond_wait(&videnc1->queueCond, &videnc1->threadStatusMutex);
+    }
+
+    flowRet = videnc1->encodeFlow;
+    if (flowRet == GST_FLOW_OK) {
+        frame = &videnc1->queue[(videnc1->queueHead + videnc1->queueCount) %
+                    videnc1->queueMax];
+        frame->buf    = buf;
+        frame->queued = queued;
+        videnc1->queueCount++;
+        pthread_cond_broadcast(&videnc1->queueCond);
+    }
+    gst_tithread_unlock_status(videnc1);
+
+    if (flowRet != GST_FLOW_OK) {
+        gst_buffer_unref(buf);
+    }
+
+    return flowRet;
+}
+
+/******************************************************************************
+ * gst_tividenc1_drain_queue
+ *   Wait until the encode thread has encoded and pushed every queued frame.
+ *****************************************************************************/
+static void gst_tividenc1_drain_queue(GstTIVidenc1 *videnc1)
+{
+    if (!videnc1->queue) {
+        return;
+    }
+
+    gst_tithread_lock_status(videnc1);
+    while (videnc1->queueCount > 0 || videnc1->encoding) {
+        pthread_cond_wait(&videnc1->queueCond, &videnc1->threadStatusMutex);
+    }
+    gst_tithread_unlock_status(videnc1);
+}
+
+/******************************************************************************
+ * gst_tividenc1_copy_input
+ *   Copy a frame to a free contiguous input buffer and return it in a DMAI
+ *   transport buffer with the frame's metadata.  There is an input buffer
+ *   for every queued frame and one for the frame being encoded.
+ *****************************************************************************/
+static GstBuffer *gst_tividenc1_copy_input(GstTIVidenc1 *videnc1,
+    GstBuffer *inBuf)
+{
+    BufferGfx_Attrs  gfxAttrs = BufferGfx_Attrs_DEFAULT;
+    Buffer_Handle    hBuf;
+    GstBuffer       *outBuf;
+
+    if (!videnc1->hInBufTab) {
+        gfxAttrs.dim.width      = videnc1->width;
+        gfxAttrs.dim.height     = videnc1->height;
+        gfxAttrs.colorSpace     = videnc1->colorSpace;
+        gfxAttrs.dim.lineLength =
+            BufferGfx_calcLineLength(gfxAttrs.dim.width, gfxAttrs.colorSpace);
+
+        /* Buffers are in use until the transport buffer is freed */
+        gfxAttrs.bAttrs.useMask = gst_tidmaibuffer_GST_FREE;
+
+        GST_LOG("creating input buffer table\n");
+        videnc1->hInBufTab = gst_tidmaibuftab_new(videnc1->queueMax + 1,
+            videnc1->upstreamBufSize, BufferGfx_getBufferAttrs(&gfxAttrs));
+
+        if (videnc1->hInBufTab == NULL) {
+            GST_ERROR("failed to create input buffer table\n");
+            gst_buffer_unref(inBuf);
+            return NULL;
+        }
+    }
+
+    if (!(hBuf = gst_tidmaibuftab_get_buf(videnc1->hInBufTab))) {
+        GST_ERROR("failed to get a free input buffer\n");
+        gst_buffer_unref(inBuf);
+        return NULL;
+    }
+
+    memcpy(Buffer_getUserPtr(hBuf), GST_BUFFER_DATA(inBuf),
+        GST_BUFFER_SIZE(inBuf));
+    Buffer_setNumBytesUsed(hBuf, GST_BUFFER_SIZE(inBuf));
+
+    outBuf = gst_tidmaibuffertransport_new(hBuf, videnc1->hInBufTab);
+    gst_buffer_set_data(outBuf, GST_BUFFER_DATA(outBuf),
+        GST_BUFFER_SIZE(inBuf));
+    gst_buffer_copy_metadata(outBuf, inBuf, GST_BUFFER_COPY_ALL);
+    gst_buffer_unref(inBuf);
+
+    return outBuf;
+}
+
 /******************************************************************************
  * gst_tividenc1_populate_codec_header
  *  This function populates codec_data field for H.264.
@@ -1418,6 +1987,7 @@ gst_tividenc1_encode(GstTIVidenc1 *videnc1, GstBuffer *inBuf,
     GstBuffer **outBuf)
 {
     Buffer_Handle  hContigInBuf = NULL;
+    Buffer_Handle  hDstBuf      = NULL;
     GstFlowReturn  flowRet      = GST_FLOW_OK;
     Int            ret;
 
@@ -1443,16 +2013,24 @@ gst_tividenc1_encode(GstTIVidenc1 *videnc1, GstBuffer *inBuf,
         goto exit_fail;
     }
 
+    /* Obtain a free output buffer for the encoded frame */
+    if (!(hDstBuf = gst_tividenc1_get_out_buf(videnc1))) {
+        GST_ELEMENT_ERROR(videnc1, RESOURCE, READ,
+        ("failed to get a free contiguous buffer from BufTab\n"), (NULL));
+        goto exit_fail;
+    }
+
     /* Reset metadata for encoded output buffer */
-    BufferGfx_resetDimensions(videnc1->hEncOutBuf);
+    BufferGfx_resetDimensions(hDstBuf);
 
     /* Invoke the video encoder */
     GST_LOG("invoking the video encoder\n");
-    ret   = Venc1_process(videnc1->hVe1, hContigInBuf, videnc1->hEncOutBuf);
+    ret   = Venc1_process(videnc1->hVe1, hContigInBuf, hDstBuf);
 
     if (ret < 0) {
         GST_ELEMENT_ERROR(videnc1, STREAM, ENCODE,
         ("failed to encode video buffer\n"), (NULL));
+        Buffer_freeUseMask(hDstBuf, gst_tidmaibuffer_CODEC_FREE);
         goto exit_fail;
     }
     else if (ret > 0) {
@@ -1466,25 +2044,27 @@ gst_tividenc1_encode(GstTIVidenc1 *videnc1, GstBuffer *inBuf,
     }
 
     /* Populate codec header */
-    gst_tividenc1_populate_codec_header(videnc1, videnc1->hEncOutBuf);
+    gst_tividenc1_populate_codec_header(videnc1, hDstBuf);
 
     /* Set the source pad capabilities based on the encoded frame properties.
      */
-    gst_tividenc1_set_source_caps(videnc1, videnc1->hEncOutBuf);
+    gst_tividenc1_set_source_caps(videnc1, hDstBuf);
 
     /* Create a DMAI transport buffer object to carry a DMAI buffer to
      * the source pad.  The transport buffer knows how to release the
      * buffer for re-use in this element when the source pad calls
      * gst_buffer_unref().
      */
-    *outBuf =
-        gst_buffer_new_and_alloc(Buffer_getNumBytesUsed(videnc1->hEncOutBuf));
-
-    memcpy(GST_BUFFER_DATA(*outBuf), Buffer_getUserPtr(videnc1->hEncOutBuf),
-        Buffer_getNumBytesUsed(videnc1->hEncOutBuf));
-
+    *outBuf = gst_tidmaibuffertransport_new(hDstBuf, videnc1->hOutBufTab);
+    gst_buffer_set_data(*outBuf, GST_BUFFER_DATA(*outBuf),
+        Buffer_getNumBytesUsed(hDstBuf));
     gst_buffer_set_caps(*outBuf, GST_PAD_CAPS(videnc1->srcpad));
 
+    /* The codec keeps no reference to its output, so the buffer is free for
+     * re-use as soon as the transport buffer releases it.
+     */
+    Buffer_freeUseMask(hDstBuf, gst_tidmaibuffer_CODEC_FREE);
+
     /* Get the metadata from the input buffer */
     gst_buffer_copy_metadata(*outBuf, videnc1->inBufMetadata,
         GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS);
@@ -59,6 +59,13 @@ G_BEGIN_DECLS
 typedef struct _GstTIVidenc1      GstTIVidenc1;
 typedef struct _GstTIVidenc1Class GstTIVidenc1Class;
 
+/* A frame waiting in the input queue of the encode thread */
+typedef struct _GstTIVidenc1Frame
+{
+  GstBuffer     *buf;
+  GstClockTime   queued;       /* when the frame was taken from the adapter */
+} GstTIVidenc1Frame;
+
 /* _GstTIVidenc1 object */
 struct _GstTIVidenc1
 {
@@ -77,6 +84,9 @@ struct _GstTIVidenc1
   gint32         bitRate;
   gint           rateControlPreset;
   gint           encodingPreset;
+  gint           numOutputBufs;
+  gint           queueSize;
+  gboolean       rtCodecThread;
 
   /* Element state */
   Engine_Handle    hEngine;
@@ -100,11 +110,37 @@ struct _GstTIVidenc1
   /* Buffer management */
   GstAdapter      *sinkAdapter;
   GstBuffer       *inBufMetadata;
-  Buffer_Handle    hEncOutBuf;
+  GstTIDmaiBufTab *hOutBufTab;
   Buffer_Handle    hContigInBuf;
   Buffer_Handle    hInBufRef;
   gboolean         zeroCopyEncode;
 
+  /* Backpressure accounting for the output buffers pushed downstream */
+  guint            numFramesEncoded;
+  guint            outBufsHeldPeak;
+  guint            outBufWaits;
+
+  /* Encode thread and its input queue, used when queueSize > 0 */
+  pthread_t          encodeThread;
+  pthread_mutex_t    threadStatusMutex;
+  UInt32             threadStatus;
+  pthread_cond_t     queueCond;
+  GstTIVidenc1Frame *queue;
+  gint               queueMax;
+  gint               queueHead;
+  gint               queueCount;
+  gboolean           encoding;
+  gboolean           stopEncodeThread;
+  GstFlowReturn      encodeFlow;
+  GstTIDmaiBufTab   *hInBufTab;
+
+  /* Latency and throughput, from frames taken in to frames encoded; these
+   * and numFramesEncoded are only touched under the object lock */
+  GstClockTime       latencyTotal;
+  GstClockTime       latencyMax;
+  GstClockTime       firstFrameTime;
+  GstClockTime       lastFrameTime;
+
   /* H.264 header */
   GstBuffer  *codec_data;
   gboolean   byteStream;
@@ -0,0 +1,194 @@
+/*
+ * check_tiauddec1.c
+ *
+ * Runs the TIAuddec1 element on top of the host DMAI and Codec Engine mock
+ * in mock/, whose audio "decoder" copies its input to its output, and checks
+ * that the byte stream pushed in comes back out unchanged with contiguous
+ * timestamps.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <gst/check/gstcheck.h>
+
+#include "gsttiauddec1.h"
+#include "gstticodecs.h"
+
+GstTICodec gst_ticodec_codecs[] = {
+    { "MPEG1L2 Audio Decoder", "mp3dec", "decode" },
+    { NULL }
+};
+
+#define FRAME_SIZE      4608
+#define NUM_FRAMES      100
+
+#define CAPS_STRING \
+    "audio/mpeg, mpegversion=(int)1, layer=(int)2, rate=(int)44100, " \
+    "channels=(int)2"
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(CAPS_STRING));
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS("audio/x-raw-int"));
+
+static GstPad      *mysrcpad;
+static GstPad      *mysinkpad;
+
+/* Written by the decode thread through sink_chain, read once it is done */
+static guint64      bytesOut;
+static GstClockTime nextTimestamp;
+static gboolean     mismatch;
+
+
+/******************************************************************************
+ * stream_byte
+ *    The value of the byte at offset in the test stream.
+ ******************************************************************************/
+static inline guint8 stream_byte(guint64 offset)
+{
+    return (guint8)((offset * 7) ^ (offset >> 9));
+}
+
+
+/******************************************************************************
+ * sink_chain
+ *    Check that each decoded buffer continues the test stream where the
+ *    previous one stopped, both in bytes and in time.
+ ******************************************************************************/
+static GstFlowReturn sink_chain(GstPad *pad, GstBuffer *buf)
+{
+    guint i;
+
+    for (i = 0; i < GST_BUFFER_SIZE(buf); i++) {
+        if (GST_BUFFER_DATA(buf)[i] != stream_byte(bytesOut + i)) {
+            mismatch = TRUE;
+            break;
+        }
+    }
+    bytesOut += GST_BUFFER_SIZE(buf);
+
+    if (GST_BUFFER_TIMESTAMP(buf) != nextTimestamp) {
+        mismatch = TRUE;
+    }
+    nextTimestamp = GST_BUFFER_TIMESTAMP(buf) + GST_BUFFER_DURATION(buf);
+
+    gst_buffer_unref(buf);
+    return GST_FLOW_OK;
+}
+
+
+/******************************************************************************
+ * run_stream
+ ******************************************************************************/
+static void run_stream(void)
+{
+    GstElement *auddec1;
+    GstCaps    *caps;
+    gint        n;
+    guint       i;
+
+    bytesOut      = 0;
+    nextTimestamp = 0;
+    mismatch      = FALSE;
+
+    auddec1 = gst_check_setup_element("TIAuddec1");
+    g_object_set(auddec1, "RTCodecThread", FALSE, NULL);
+
+    mysrcpad  = gst_check_setup_src_pad(auddec1, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad(auddec1, &sinktemplate, NULL);
+    gst_pad_set_chain_function(mysinkpad, sink_chain);
+    gst_pad_set_active(mysrcpad, TRUE);
+    gst_pad_set_active(mysinkpad, TRUE);
+
+    fail_unless(gst_element_set_state(auddec1, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+    caps = gst_caps_from_string(CAPS_STRING);
+    for (n = 0; n < NUM_FRAMES; n++) {
+        GstBuffer *buf = gst_buffer_new_and_alloc(FRAME_SIZE);
+
+        for (i = 0; i < FRAME_SIZE; i++) {
+            GST_BUFFER_DATA(buf)[i] =
+                stream_byte((guint64)n * FRAME_SIZE + i);
+        }
+        gst_buffer_set_caps(buf, caps);
+
+        fail_unless_equals_int(gst_pad_push(mysrcpad, buf), GST_FLOW_OK);
+    }
+    gst_caps_unref(caps);
+
+    /* EOS returns once the decode thread has drained the codec */
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+
+    fail_unless(bytesOut == (guint64)NUM_FRAMES * FRAME_SIZE);
+    fail_if(mismatch);
+
+    fail_unless(gst_element_set_state(auddec1, GST_STATE_NULL) ==
+        GST_STATE_CHANGE_SUCCESS);
+    gst_pad_set_active(mysrcpad, FALSE);
+    gst_pad_set_active(mysinkpad, FALSE);
+    gst_check_teardown_src_pad(auddec1);
+    gst_check_teardown_sink_pad(auddec1);
+    gst_check_teardown_element(auddec1);
+}
+
+
+GST_START_TEST(test_decode_stream)
+{
+    run_stream();
+}
+GST_END_TEST;
+
+
+/* The circular buffer fills up while the codec is slow */
+GST_START_TEST(test_decode_slow_codec)
+{
+    setenv("DMAI_MOCK_DELAY_ADEC1", "2000", 1);
+    run_stream();
+}
+GST_END_TEST;
+
+
+static Suite *tiauddec1_suite(void)
+{
+    Suite *s        = suite_create("tiauddec1");
+    TCase *tc_chain = tcase_create("general");
+
+    gst_element_register(NULL, "TIAuddec1", GST_RANK_NONE,
+        GST_TYPE_TIAUDDEC1);
+
+    tcase_set_timeout(tc_chain, 60);
+    suite_add_tcase(s, tc_chain);
+    tcase_add_test(tc_chain, test_decode_stream);
+    tcase_add_test(tc_chain, test_decode_slow_codec);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tiauddec1);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
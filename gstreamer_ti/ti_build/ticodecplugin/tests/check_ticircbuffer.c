@@ -0,0 +1,320 @@
+/*
+ * check_ticircbuffer.c
+ *
+ * Runs a producer and a consumer thread against the GstTICircBuffer object,
+ * on top of the host DMAI mock in mock/, and checks that the consumer reads
+ * back exactly the byte stream that was queued, whatever the split of the
+ * input buffers and of the amounts consumed.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gstticircbuffer.h"
+#include "gsttidmaibuffertransport.h"
+
+#define WINDOW_SIZE    4096
+#define STREAM_SIZE    (8 * 1024 * 1024)
+
+/* How the producer and consumer thread behave in one run */
+typedef struct {
+    Int32     numWindows;
+    gboolean  fixedBlockSize;
+    gboolean  zeroCopy;
+    gboolean  dmaiInput;     /* queue GstTIDmaiBufferTransport buffers */
+    gint      maxInput;      /* largest input buffer                   */
+    gboolean  partial;       /* consumer may stop short of its window  */
+} StressParams;
+
+static GstTICircBuffer    *circBuf;
+static const StressParams *params;
+static guint64             bytesChecked;
+static gboolean            mismatch;
+
+
+/******************************************************************************
+ * stream_byte
+ *    The value of the byte at offset in the test stream.
+ ******************************************************************************/
+static inline guint8 stream_byte(guint64 offset)
+{
+    return (guint8)((offset * 7) ^ (offset >> 9));
+}
+
+
+/******************************************************************************
+ * new_input_buffer
+ *    Create an input buffer of size bytes, in contiguous memory if the run
+ *    asks for it.
+ ******************************************************************************/
+static GstBuffer *new_input_buffer(gint size)
+{
+    Buffer_Attrs   bAttrs = Buffer_Attrs_DEFAULT;
+    Buffer_Handle  hBuf;
+
+    if (!params->dmaiInput) {
+        return gst_buffer_new_and_alloc(size);
+    }
+
+    hBuf = Buffer_create(size, &bAttrs);
+    fail_if(hBuf == NULL);
+    return gst_tidmaibuffertransport_new(hBuf, NULL);
+}
+
+
+/******************************************************************************
+ * producer_thread
+ *    Queue STREAM_SIZE bytes in randomly sized buffers, then drain.
+ ******************************************************************************/
+static gpointer producer_thread(gpointer data)
+{
+    GRand    *rand   = g_rand_new_with_seed(1);
+    guint64   offset = 0;
+    gboolean  result = TRUE;
+
+    while (offset < STREAM_SIZE && result) {
+        GstBuffer *buf;
+        gint       size;
+        gint       i;
+
+        size = g_rand_int_range(rand, 1, params->maxInput + 1);
+        size = MIN(size, STREAM_SIZE - offset);
+
+        buf = new_input_buffer(size);
+        for (i = 0; i < size; i++) {
+            GST_BUFFER_DATA(buf)[i] = stream_byte(offset + i);
+        }
+
+        result  = gst_ticircbuffer_queue_data(circBuf, buf);
+        offset += size;
+        gst_buffer_unref(buf);
+    }
+
+    gst_ticircbuffer_drain(circBuf, TRUE);
+    g_rand_free(rand);
+
+    return GINT_TO_POINTER(result);
+}
+
+
+/******************************************************************************
+ * consumer_thread
+ *    Read the stream back, consuming a random part of each window the way a
+ *    codec consumes whole frames of varying size.
+ ******************************************************************************/
+static gpointer consumer_thread(gpointer data)
+{
+    GRand     *rand = g_rand_new_with_seed(2);
+    GstBuffer *window;
+    gint       size;
+    gint       consumed;
+    gint       i;
+
+    while (TRUE) {
+        window = gst_ticircbuffer_get_data(circBuf);
+        size   = GST_BUFFER_SIZE(window);
+
+        if (size == 0) {
+            gst_ticircbuffer_data_consumed(circBuf, window, 0);
+            break;
+        }
+
+        consumed = size;
+        if (params->partial) {
+            consumed = g_rand_int_range(rand, 1, size + 1);
+        }
+
+        for (i = 0; i < consumed; i++) {
+            if (GST_BUFFER_DATA(window)[i] != stream_byte(bytesChecked + i)) {
+                mismatch = TRUE;
+            }
+        }
+        bytesChecked += consumed;
+
+        if (!gst_ticircbuffer_data_consumed(circBuf, window, consumed)) {
+            mismatch = TRUE;
+            break;
+        }
+    }
+
+    g_rand_free(rand);
+
+    return NULL;
+}
+
+
+/******************************************************************************
+ * run_stress
+ *    Pass the test stream through a circular buffer set up as p describes.
+ ******************************************************************************/
+static void run_stress(const StressParams *p)
+{
+    GThread *producer;
+    GThread *consumer;
+    gboolean queued;
+
+    params       = p;
+    bytesChecked = 0;
+    mismatch     = FALSE;
+
+    circBuf = gst_ticircbuffer_new(WINDOW_SIZE, p->numWindows,
+                  p->fixedBlockSize);
+    fail_if(circBuf == NULL);
+    gst_ticircbuffer_set_zero_copy(circBuf, p->zeroCopy);
+
+    consumer = g_thread_create(consumer_thread, NULL, TRUE, NULL);
+    producer = g_thread_create(producer_thread, NULL, TRUE, NULL);
+
+    queued = GPOINTER_TO_INT(g_thread_join(producer));
+    g_thread_join(consumer);
+
+    fail_unless(queued);
+    fail_if(mismatch);
+    fail_unless_equals_uint64(bytesChecked, STREAM_SIZE);
+}
+
+
+/******************************************************************************
+ * teardown
+ ******************************************************************************/
+static void teardown(void)
+{
+    if (circBuf) {
+        gst_ticircbuffer_unref(circBuf);
+        circBuf = NULL;
+    }
+}
+
+
+/* Decoder set-up: input of any size, partial consumption */
+GST_START_TEST(test_stress_decode)
+{
+    static const StressParams p = { 3, FALSE, FALSE, FALSE, 3000, TRUE };
+
+    run_stress(&p);
+}
+GST_END_TEST;
+
+
+/* Input buffers larger than the space left get split */
+GST_START_TEST(test_stress_large_input)
+{
+    static const StressParams p = { 3, FALSE, FALSE, FALSE, 3 * WINDOW_SIZE,
+                                    TRUE };
+
+    run_stress(&p);
+}
+GST_END_TEST;
+
+
+/* Encoder set-up: whole windows consumed, no shifting of data */
+GST_START_TEST(test_stress_fixed_block)
+{
+    static const StressParams p = { 2, TRUE, FALSE, FALSE, 3000, FALSE };
+
+    run_stress(&p);
+}
+GST_END_TEST;
+
+
+/* Frames in contiguous memory consumed whole are never copied */
+GST_START_TEST(test_zero_copy)
+{
+    static const StressParams p = { 3, FALSE, TRUE, TRUE, WINDOW_SIZE,
+                                    FALSE };
+
+    run_stress(&p);
+    fail_unless_equals_uint64(circBuf->bytesCopied, 0);
+    fail_unless_equals_uint64(circBuf->bytesDirect, STREAM_SIZE);
+}
+GST_END_TEST;
+
+
+/* What the consumer leaves of a frame is read before the next one */
+GST_START_TEST(test_zero_copy_partial)
+{
+    static const StressParams p = { 3, FALSE, TRUE, TRUE, WINDOW_SIZE,
+                                    TRUE };
+
+    run_stress(&p);
+    fail_unless(circBuf->bytesDirect > 0);
+    fail_unless(circBuf->bytesCopied > 0);
+}
+GST_END_TEST;
+
+
+/* Only contiguous input is handed over without copying */
+GST_START_TEST(test_zero_copy_system_memory)
+{
+    static const StressParams p = { 3, FALSE, TRUE, FALSE, WINDOW_SIZE,
+                                    FALSE };
+
+    run_stress(&p);
+    fail_unless_equals_uint64(circBuf->bytesDirect, 0);
+}
+GST_END_TEST;
+
+
+/* A producer blocked on a full buffer returns when the consumer aborts */
+GST_START_TEST(test_consumer_aborted)
+{
+    static const StressParams p = { 3, FALSE, FALSE, FALSE, WINDOW_SIZE,
+                                    FALSE };
+    GThread *producer;
+
+    params  = &p;
+    circBuf = gst_ticircbuffer_new(WINDOW_SIZE, p.numWindows, FALSE);
+    fail_if(circBuf == NULL);
+
+    producer = g_thread_create(producer_thread, NULL, TRUE, NULL);
+
+    g_usleep(G_USEC_PER_SEC / 10);
+    gst_ticircbuffer_consumer_aborted(circBuf);
+
+    fail_if(GPOINTER_TO_INT(g_thread_join(producer)));
+}
+GST_END_TEST;
+
+
+static Suite *ticircbuffer_suite(void)
+{
+    Suite *s        = suite_create("ticircbuffer");
+    TCase *tc_chain = tcase_create("general");
+
+    tcase_set_timeout(tc_chain, 60);
+    tcase_add_checked_fixture(tc_chain, NULL, teardown);
+    tcase_add_test(tc_chain, test_stress_decode);
+    tcase_add_test(tc_chain, test_stress_large_input);
+    tcase_add_test(tc_chain, test_stress_fixed_block);
+    tcase_add_test(tc_chain, test_zero_copy);
+    tcase_add_test(tc_chain, test_zero_copy_partial);
+    tcase_add_test(tc_chain, test_zero_copy_system_memory);
+    tcase_add_test(tc_chain, test_consumer_aborted);
+    suite_add_tcase(s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN(ticircbuffer);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,382 @@
+/*
+ * check_tidmaiperf.c
+ *
+ * Runs the dmaiperf element on top of the host Codec Engine mock in mock/,
+ * whose DSP server reports the load and segment usage set through
+ * DMAI_MOCK_DSP_LOAD and DMAI_MOCK_DSP_USED, and checks the typed fields of
+ * the "dmaiperf" messages, the properties that mirror them, and the rolling
+ * min/max/percentile window.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <gst/check/gstcheck.h>
+
+#include "gsttidmaiperf.h"
+
+#define BUF_SIZE        1000
+
+/* Sampling interval in milliseconds, and how long to wait for one to end */
+#define INTERVAL        10
+#define INTERVAL_WAIT   ((INTERVAL + 5) * 1000)
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+static GstPad      *mysrcpad;
+static GstPad      *mysinkpad;
+static GstElement  *dmaiperf;
+static GstBus      *bus;
+
+
+/******************************************************************************
+ * setup_dmaiperf
+ *    Create the element and give it a bus to post its samples on.  The
+ *    caller sets the properties and then calls start_dmaiperf.
+ ******************************************************************************/
+static void setup_dmaiperf(void)
+{
+    dmaiperf = gst_check_setup_element("dmaiperf");
+    g_object_set(dmaiperf, "interval", INTERVAL, NULL);
+
+    bus = gst_bus_new();
+    gst_element_set_bus(dmaiperf, bus);
+
+    mysrcpad  = gst_check_setup_src_pad(dmaiperf, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad(dmaiperf, &sinktemplate, NULL);
+    gst_pad_set_active(mysrcpad, TRUE);
+    gst_pad_set_active(mysinkpad, TRUE);
+}
+
+
+/******************************************************************************
+ * start_dmaiperf
+ ******************************************************************************/
+static void start_dmaiperf(void)
+{
+    fail_unless(gst_element_set_state(dmaiperf, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+}
+
+
+/******************************************************************************
+ * cleanup_dmaiperf
+ ******************************************************************************/
+static void cleanup_dmaiperf(void)
+{
+    fail_unless(gst_element_set_state(dmaiperf, GST_STATE_NULL) ==
+        GST_STATE_CHANGE_SUCCESS);
+    gst_element_set_bus(dmaiperf, NULL);
+    gst_object_unref(bus);
+
+    gst_check_drop_buffers();
+    gst_pad_set_active(mysrcpad, FALSE);
+    gst_pad_set_active(mysinkpad, FALSE);
+    gst_check_teardown_src_pad(dmaiperf);
+    gst_check_teardown_sink_pad(dmaiperf);
+    gst_check_teardown_element(dmaiperf);
+
+    unsetenv("DMAI_MOCK_DSP_LOAD");
+    unsetenv("DMAI_MOCK_DSP_USED");
+}
+
+
+/******************************************************************************
+ * push_buffer
+ ******************************************************************************/
+static void push_buffer(void)
+{
+    GstBuffer *buf = gst_buffer_new_and_alloc(BUF_SIZE);
+
+    memset(GST_BUFFER_DATA(buf), 0, BUF_SIZE);
+    fail_unless_equals_int(gst_pad_push(mysrcpad, buf), GST_FLOW_OK);
+}
+
+
+/******************************************************************************
+ * pop_sample
+ *    Return a copy of the next "dmaiperf" message on the bus, or NULL if
+ *    there is none.  Samples are posted from gst_pad_push, so they are on
+ *    the bus as soon as the push that ended the interval returns.
+ ******************************************************************************/
+static GstStructure *pop_sample(void)
+{
+    GstStructure *s = NULL;
+    GstMessage   *msg;
+
+    while (s == NULL && (msg = gst_bus_pop(bus)) != NULL) {
+        if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ELEMENT &&
+            gst_structure_has_name(msg->structure, GST_DMAIPERF_MESSAGE)) {
+            s = gst_structure_copy(msg->structure);
+        }
+        gst_message_unref(msg);
+    }
+
+    return s;
+}
+
+
+/******************************************************************************
+ * next_sample
+ *    Wait for the interval to end, report dspLoad, push the buffer that
+ *    takes the sample and return it.
+ ******************************************************************************/
+static GstStructure *next_sample(gint dspLoad)
+{
+    GstStructure *s;
+    gchar         load[16];
+
+    g_usleep(INTERVAL_WAIT);
+    g_snprintf(load, sizeof(load), "%d", dspLoad);
+    setenv("DMAI_MOCK_DSP_LOAD", load, 1);
+
+    push_buffer();
+    s = pop_sample();
+    fail_if(s == NULL);
+
+    return s;
+}
+
+
+/******************************************************************************
+ * get_double
+ ******************************************************************************/
+static gdouble get_double(const GstStructure *s, const gchar *field)
+{
+    gdouble val = -1;
+
+    fail_unless(gst_structure_get_double(s, field, &val), field);
+    return val;
+}
+
+
+/******************************************************************************
+ * array_uint
+ ******************************************************************************/
+static guint array_uint(const GstStructure *s, const gchar *field, guint i)
+{
+    const GValue *array = gst_structure_get_value(s, field);
+
+    fail_if(array == NULL);
+    fail_unless(i < gst_value_array_get_size(array));
+    return g_value_get_uint(gst_value_array_get_value(array, i));
+}
+
+
+GST_START_TEST(test_sample_fields)
+{
+    const GValue *names;
+    GstStructure *s;
+    GstClockTime  interval;
+    gint          load;
+
+    setenv("DMAI_MOCK_DSP_USED", "4096", 1);
+    setup_dmaiperf();
+    g_object_set(dmaiperf, "engine-name", "decode", "print-arm-load", TRUE,
+        NULL);
+    start_dmaiperf();
+
+    /* The first buffer only starts the interval */
+    push_buffer();
+    push_buffer();
+    fail_unless(pop_sample() == NULL);
+
+    s = next_sample(42);
+
+    fail_unless(gst_structure_get_uint64(s, "interval", &interval));
+    fail_unless(interval >= INTERVAL * GST_MSECOND);
+    fail_unless(get_double(s, "fps") > 0);
+    fail_unless(gst_structure_has_field_typed(s, "bps", G_TYPE_UINT64));
+
+    fail_unless(gst_structure_get_int(s, "dsp-load", &load));
+    fail_unless_equals_int(load, 42);
+    fail_unless(gst_structure_get_int(s, "arm-load", &load));
+    fail_unless(load >= 0 && load <= 100);
+
+    names = gst_structure_get_value(s, "mem-seg-name");
+    fail_if(names == NULL);
+    fail_unless_equals_int(gst_value_array_get_size(names), 2);
+    fail_unless_equals_string(
+        g_value_get_string(gst_value_array_get_value(names, 0)), "DDR2");
+    fail_unless_equals_int(array_uint(s, "mem-seg-used", 1), 4096);
+    fail_unless_equals_int(array_uint(s, "mem-seg-maxblocklen", 1),
+        array_uint(s, "mem-seg-size", 1) - 4096);
+    fail_if(gst_structure_has_field(s, "fps-min"));
+
+    gst_structure_free(s);
+    cleanup_dmaiperf();
+}
+GST_END_TEST;
+
+
+GST_START_TEST(test_properties)
+{
+    GstStructure *s;
+    GstStructure *stats;
+    gdouble       fps;
+    guint64       bps;
+    guint64       msgBps;
+    gint          dspLoad;
+    gint          armLoad;
+
+    setup_dmaiperf();
+    g_object_set(dmaiperf, "engine-name", "decode", NULL);
+    start_dmaiperf();
+
+    g_object_get(dmaiperf, "dsp-load", &dspLoad, "stats", &stats, NULL);
+    fail_unless_equals_int(dspLoad, -1);
+    fail_unless(stats == NULL);
+
+    push_buffer();
+    s = next_sample(17);
+
+    g_object_get(dmaiperf, "fps", &fps, "bps", &bps, "dsp-load", &dspLoad,
+        "arm-load", &armLoad, "stats", &stats, NULL);
+    fail_unless(gst_structure_get_uint64(s, "bps", &msgBps));
+    fail_unless(fps == get_double(s, "fps"));
+    fail_unless(bps == msgBps);
+    fail_unless_equals_int(dspLoad, 17);
+    fail_unless_equals_int(armLoad, -1);
+
+    fail_if(stats == NULL);
+    fail_unless(gst_structure_has_name(stats, GST_DMAIPERF_MESSAGE));
+    fail_unless(gst_structure_get_int(stats, "dsp-load", &dspLoad));
+    fail_unless_equals_int(dspLoad, 17);
+
+    gst_structure_free(stats);
+    gst_structure_free(s);
+    cleanup_dmaiperf();
+}
+GST_END_TEST;
+
+
+/* Five samples through a window of four: the first one has rolled out */
+GST_START_TEST(test_window)
+{
+    GstStructure *s = NULL;
+    guint         windowSize;
+    gint          n;
+
+    setup_dmaiperf();
+    g_object_set(dmaiperf, "engine-name", "decode", "window-size", 4,
+        "percentile", 50, NULL);
+    start_dmaiperf();
+
+    push_buffer();
+    for (n = 1; n <= 5; n++) {
+        if (s) {
+            gst_structure_free(s);
+        }
+        s = next_sample(n * 10);
+    }
+
+    fail_unless(gst_structure_get_uint(s, "window-size", &windowSize));
+    fail_unless_equals_int(windowSize, 4);
+    fail_unless(get_double(s, "dsp-load-min") == 20);
+    fail_unless(get_double(s, "dsp-load-max") == 50);
+    fail_unless(get_double(s, "dsp-load-percentile") == 30);
+    fail_unless(get_double(s, "fps-min") <= get_double(s, "fps-percentile"));
+    fail_unless(get_double(s, "fps-percentile") <= get_double(s, "fps-max"));
+    fail_if(gst_structure_has_field(s, "arm-load-min"));
+
+    gst_structure_free(s);
+    cleanup_dmaiperf();
+}
+GST_END_TEST;
+
+
+/* A server handed in directly is used without an engine-name */
+GST_START_TEST(test_server_property)
+{
+    Engine_Handle hEngine;
+    GstStructure *s;
+    gint          load;
+
+    hEngine = Engine_open("decode", NULL, NULL);
+    fail_if(hEngine == NULL);
+
+    setup_dmaiperf();
+    g_object_set(dmaiperf, "server", Engine_getServer(hEngine), NULL);
+    start_dmaiperf();
+
+    push_buffer();
+    s = next_sample(63);
+    fail_unless(gst_structure_get_int(s, "dsp-load", &load));
+    fail_unless_equals_int(load, 63);
+    fail_unless(gst_structure_has_field(s, "mem-seg-name"));
+
+    gst_structure_free(s);
+    cleanup_dmaiperf();
+    Engine_close(hEngine);
+}
+GST_END_TEST;
+
+
+GST_START_TEST(test_no_dsp)
+{
+    GstStructure *s;
+    gint          load;
+
+    setup_dmaiperf();
+    start_dmaiperf();
+
+    push_buffer();
+    s = next_sample(50);
+    fail_if(gst_structure_has_field(s, "dsp-load"));
+    fail_if(gst_structure_has_field(s, "mem-seg-name"));
+
+    g_object_get(dmaiperf, "dsp-load", &load, NULL);
+    fail_unless_equals_int(load, -1);
+
+    gst_structure_free(s);
+    cleanup_dmaiperf();
+}
+GST_END_TEST;
+
+
+static Suite *tidmaiperf_suite(void)
+{
+    Suite *s        = suite_create("tidmaiperf");
+    TCase *tc_chain = tcase_create("general");
+
+    gst_element_register(NULL, "dmaiperf", GST_RANK_NONE,
+        GST_TYPE_DMAIPERF);
+
+    tcase_set_timeout(tc_chain, 60);
+    suite_add_tcase(s, tc_chain);
+    tcase_add_test(tc_chain, test_sample_fields);
+    tcase_add_test(tc_chain, test_properties);
+    tcase_add_test(tc_chain, test_window);
+    tcase_add_test(tc_chain, test_server_property);
+    tcase_add_test(tc_chain, test_no_dsp);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tidmaiperf);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
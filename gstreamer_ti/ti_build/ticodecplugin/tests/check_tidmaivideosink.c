@@ -0,0 +1,228 @@
+/*
+ * check_tidmaivideosink.c
+ *
+ * Runs the TIDmaiVideoSink element on top of the host DMAI mock in mock/,
+ * whose display only queues frames, and checks that system-memory and DMAI
+ * input frames end up where they belong in the NTSC display buffer.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gsttidmaivideosink.h"
+#include "gsttidmaibuffertransport.h"
+#include "dmaimock.h"
+
+#define WIDTH           64
+#define HEIGHT          48
+#define LINE_LENGTH     (WIDTH * 2)
+#define FRAME_SIZE      (LINE_LENGTH * HEIGHT)
+#define NUM_FRAMES      10
+
+/* The mock's default DM6446 display is D1 NTSC UYVY */
+#define DISP_WIDTH      720
+#define DISP_HEIGHT     480
+
+#define CAPS_STRING \
+    "video/x-raw-yuv, format=(fourcc)UYVY, width=(int)64, height=(int)48, " \
+    "framerate=(fraction)30/1"
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(CAPS_STRING));
+
+static GstPad     *mysrcpad;
+static GstElement *sink;
+
+
+/******************************************************************************
+ * row_byte
+ *    The value every byte of row r of input frame n is filled with.
+ ******************************************************************************/
+static inline guint8 row_byte(gint n, gint r)
+{
+    return (guint8)(n * 7 + r + 1);
+}
+
+
+/******************************************************************************
+ * setup_sink
+ ******************************************************************************/
+static void setup_sink(gboolean resizer)
+{
+    sink = gst_check_setup_element("TIDmaiVideoSink");
+    g_object_set(sink, "sync", FALSE, "resizer", resizer, NULL);
+
+    mysrcpad = gst_check_setup_src_pad(sink, &srctemplate, NULL);
+    gst_pad_set_active(mysrcpad, TRUE);
+
+    fail_if(gst_element_set_state(sink, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_FAILURE);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+}
+
+
+/******************************************************************************
+ * cleanup_sink
+ ******************************************************************************/
+static void cleanup_sink(void)
+{
+    fail_unless(gst_element_set_state(sink, GST_STATE_NULL) ==
+        GST_STATE_CHANGE_SUCCESS);
+
+    gst_pad_set_active(mysrcpad, FALSE);
+    gst_check_teardown_src_pad(sink);
+    gst_check_teardown_element(sink);
+}
+
+
+/******************************************************************************
+ * new_frame
+ *    Create input frame n, in system memory or in a DMAI buffer.
+ ******************************************************************************/
+static GstBuffer *new_frame(gint n, gboolean dmaiInput)
+{
+    BufferGfx_Attrs  gfxAttrs = BufferGfx_Attrs_DEFAULT;
+    Buffer_Handle    hBuf;
+    GstBuffer       *buf;
+    GstCaps         *caps;
+    gint             r;
+
+    if (dmaiInput) {
+        gfxAttrs.colorSpace     = ColorSpace_UYVY;
+        gfxAttrs.dim.width      = WIDTH;
+        gfxAttrs.dim.height     = HEIGHT;
+        gfxAttrs.dim.lineLength = LINE_LENGTH;
+
+        hBuf = Buffer_create(FRAME_SIZE, BufferGfx_getBufferAttrs(&gfxAttrs));
+        fail_if(hBuf == NULL);
+        buf = gst_tidmaibuffertransport_new(hBuf, NULL);
+    }
+    else {
+        buf = gst_buffer_new_and_alloc(FRAME_SIZE);
+    }
+
+    for (r = 0; r < HEIGHT; r++) {
+        memset(GST_BUFFER_DATA(buf) + r * LINE_LENGTH, row_byte(n, r),
+            LINE_LENGTH);
+    }
+
+    caps = gst_caps_from_string(CAPS_STRING);
+    gst_buffer_set_caps(buf, caps);
+    gst_caps_unref(caps);
+
+    return buf;
+}
+
+
+/******************************************************************************
+ * check_displayed
+ *    Check that the last displayed buffer holds frame n with its top-left
+ *    corner at (x, y).
+ ******************************************************************************/
+static void check_displayed(gint n, gint x, gint y)
+{
+    Buffer_Handle         hDispBuf = DmaiMock_getLastDisplayed();
+    BufferGfx_Dimensions  dim;
+    Int8                 *disp;
+    gint                  r;
+
+    fail_if(hDispBuf == NULL);
+    BufferGfx_getDimensions(hDispBuf, &dim);
+    fail_unless_equals_int(dim.width, DISP_WIDTH);
+    fail_unless_equals_int(dim.height, DISP_HEIGHT);
+
+    disp = Buffer_getUserPtr(hDispBuf);
+    for (r = 0; r < HEIGHT; r++) {
+        guint8 *row = (guint8 *)disp + (y + r) * dim.lineLength + x * 2;
+
+        fail_unless_equals_int(row[0], row_byte(n, r));
+        fail_unless_equals_int(row[LINE_LENGTH - 1], row_byte(n, r));
+    }
+}
+
+
+/******************************************************************************
+ * run_frames
+ ******************************************************************************/
+static void run_frames(gboolean resizer, gboolean dmaiInput, gint x, gint y)
+{
+    gint n;
+
+    setup_sink(resizer);
+
+    for (n = 0; n < NUM_FRAMES; n++) {
+        fail_unless_equals_int(gst_pad_push(mysrcpad,
+            new_frame(n, dmaiInput)), GST_FLOW_OK);
+        check_displayed(n, x, y);
+    }
+
+    cleanup_sink();
+}
+
+
+/* A frame smaller than the display is centred on it */
+GST_START_TEST(test_display_frames)
+{
+    run_frames(FALSE, FALSE, ((DISP_WIDTH - WIDTH) / 2) & ~1,
+        (DISP_HEIGHT - HEIGHT) / 2);
+}
+GST_END_TEST;
+
+
+GST_START_TEST(test_display_dmai_frames)
+{
+    run_frames(FALSE, TRUE, ((DISP_WIDTH - WIDTH) / 2) & ~1,
+        (DISP_HEIGHT - HEIGHT) / 2);
+}
+GST_END_TEST;
+
+
+/* The resizer fills the display; the mock copies without scaling */
+GST_START_TEST(test_display_resizer)
+{
+    run_frames(TRUE, FALSE, 0, 0);
+}
+GST_END_TEST;
+
+
+static Suite *tidmaivideosink_suite(void)
+{
+    Suite *s        = suite_create("tidmaivideosink");
+    TCase *tc_chain = tcase_create("general");
+
+    gst_element_register(NULL, "TIDmaiVideoSink", GST_RANK_NONE,
+        GST_TYPE_TIDMAIVIDEOSINK);
+
+    tcase_set_timeout(tc_chain, 60);
+    suite_add_tcase(s, tc_chain);
+    tcase_add_test(tc_chain, test_display_frames);
+    tcase_add_test(tc_chain, test_display_dmai_frames);
+    tcase_add_test(tc_chain, test_display_resizer);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tidmaivideosink);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,344 @@
+/*
+ * check_tiimgenc1.c
+ *
+ * Runs the TIImgenc1 element on top of the host DMAI and Codec Engine mock
+ * in mock/, whose JPEG "encoder" copies each raw frame to its output, and
+ * checks that every frame comes back out whole and in order, one at a time
+ * or in batches, and that a qValue requested for one frame is used for that
+ * frame only.  A benchmark compares the throughput of the two modes behind
+ * a sink that holds on to each image for a while before releasing it.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <gst/check/gstcheck.h>
+
+#include "gsttiimgenc1.h"
+#include "gstticodecs.h"
+#include "dmaimock.h"
+
+GstTICodec gst_ticodec_codecs[] = {
+    { "JPEG Image Encoder", "jpegenc", "encode" },
+    { NULL }
+};
+
+#define WIDTH           64
+#define HEIGHT          64
+#define FRAME_SIZE      (WIDTH * HEIGHT * 2)
+#define NUM_FRAMES      30
+#define BATCH_SIZE      4
+#define DEFAULT_QVALUE  60
+
+/* Microseconds the codec takes per image, and the sink holds on to one */
+#define ENCODE_DELAY    "5000"
+#define RELEASE_DELAY   5000
+
+#define CAPS_STRING \
+    "video/x-raw-yuv, format=(fourcc)UYVY, width=(int)64, height=(int)64, " \
+    "framerate=(fraction)30/1"
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(CAPS_STRING));
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS("video/x-jpeg"));
+
+static GstPad      *mysrcpad;
+static GstPad      *mysinkpad;
+static GstElement  *imgenc1;
+
+/* Written by the encode thread through sink_chain, read once it is done */
+static gint         framesOut;
+static gboolean     mismatch;
+static gint         qValues[NUM_FRAMES];
+
+/* Images waiting in the slow sink to be released */
+static GAsyncQueue *releaseQueue;
+static GThread     *releaseThread;
+static gint         releaseStop;
+
+
+/******************************************************************************
+ * sink_chain
+ *    Check that each image holds the next frame pushed in, and note the
+ *    qValue it was encoded with.  The slow sink hands the image over to
+ *    the release thread instead of freeing it.
+ ******************************************************************************/
+static GstFlowReturn sink_chain(GstPad *pad, GstBuffer *buf)
+{
+    guint i;
+
+    if (GST_BUFFER_SIZE(buf) != FRAME_SIZE) {
+        mismatch = TRUE;
+    }
+
+    for (i = 0; i < GST_BUFFER_SIZE(buf); i++) {
+        if (GST_BUFFER_DATA(buf)[i] != (guint8)framesOut) {
+            mismatch = TRUE;
+            break;
+        }
+    }
+
+    if (framesOut < NUM_FRAMES) {
+        qValues[framesOut] = DmaiMock_getLastQValue();
+    }
+    framesOut++;
+
+    if (releaseQueue) {
+        g_async_queue_push(releaseQueue, buf);
+    }
+    else {
+        gst_buffer_unref(buf);
+    }
+
+    return GST_FLOW_OK;
+}
+
+
+/******************************************************************************
+ * release_thread
+ *    Free each image RELEASE_DELAY microseconds after the previous one, the
+ *    way a sink writing them out one by one would.
+ ******************************************************************************/
+static gpointer release_thread(gpointer data)
+{
+    GstBuffer *buf;
+
+    while ((buf = g_async_queue_pop(releaseQueue)) !=
+           (GstBuffer *)&releaseStop) {
+        g_usleep(RELEASE_DELAY);
+        gst_buffer_unref(buf);
+    }
+
+    return NULL;
+}
+
+
+/******************************************************************************
+ * setup_imgenc1
+ ******************************************************************************/
+static void setup_imgenc1(gint batchSize, gboolean slowSink)
+{
+    framesOut = 0;
+    mismatch  = FALSE;
+    memset(qValues, 0, sizeof(qValues));
+
+    releaseQueue  = NULL;
+    releaseThread = NULL;
+    if (slowSink) {
+        releaseQueue  = g_async_queue_new();
+        releaseThread = g_thread_create(release_thread, NULL, TRUE, NULL);
+        fail_if(releaseThread == NULL);
+    }
+
+    imgenc1 = gst_check_setup_element("TIImgenc1");
+    g_object_set(imgenc1, "iColorSpace", "UYVY", "resolution", "64x64",
+        "qValue", DEFAULT_QVALUE, "batchSize", batchSize,
+        "RTCodecThread", FALSE, NULL);
+
+    mysrcpad  = gst_check_setup_src_pad(imgenc1, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad(imgenc1, &sinktemplate, NULL);
+    gst_pad_set_chain_function(mysinkpad, sink_chain);
+    gst_pad_set_active(mysrcpad, TRUE);
+    gst_pad_set_active(mysinkpad, TRUE);
+
+    fail_unless(gst_element_set_state(imgenc1, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+}
+
+
+/******************************************************************************
+ * cleanup_imgenc1
+ ******************************************************************************/
+static void cleanup_imgenc1(void)
+{
+    if (releaseThread) {
+        g_async_queue_push(releaseQueue, &releaseStop);
+        g_thread_join(releaseThread);
+        g_async_queue_unref(releaseQueue);
+        releaseQueue  = NULL;
+        releaseThread = NULL;
+    }
+
+    fail_unless(gst_element_set_state(imgenc1, GST_STATE_NULL) ==
+        GST_STATE_CHANGE_SUCCESS);
+    gst_pad_set_active(mysrcpad, FALSE);
+    gst_pad_set_active(mysinkpad, FALSE);
+    gst_check_teardown_src_pad(imgenc1);
+    gst_check_teardown_sink_pad(imgenc1);
+    gst_check_teardown_element(imgenc1);
+}
+
+
+/******************************************************************************
+ * push_frame
+ *    Push frame n, every byte of which is n.
+ ******************************************************************************/
+static void push_frame(gint n)
+{
+    GstBuffer *buf = gst_buffer_new_and_alloc(FRAME_SIZE);
+    GstCaps   *caps;
+
+    memset(GST_BUFFER_DATA(buf), (guint8)n, FRAME_SIZE);
+    GST_BUFFER_TIMESTAMP(buf) = n * GST_SECOND / 30;
+
+    caps = gst_caps_from_string(CAPS_STRING);
+    gst_buffer_set_caps(buf, caps);
+    gst_caps_unref(caps);
+
+    fail_unless_equals_int(gst_pad_push(mysrcpad, buf), GST_FLOW_OK);
+}
+
+
+/******************************************************************************
+ * push_qvalue
+ *    Ask for the next frame pushed to be encoded with qValue.
+ ******************************************************************************/
+static void push_qvalue(gint qValue)
+{
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_custom(GST_EVENT_CUSTOM_DOWNSTREAM,
+            gst_structure_new(GST_TIIMGENC1_QVALUE_EVENT,
+                "qValue", G_TYPE_INT, qValue, NULL))));
+}
+
+
+/******************************************************************************
+ * run_frames
+ *    Encode NUM_FRAMES frames and return the throughput the element saw.
+ ******************************************************************************/
+static gdouble run_frames(gint batchSize, gboolean slowSink)
+{
+    gdouble throughput;
+    gint    n;
+
+    setup_imgenc1(batchSize, slowSink);
+
+    for (n = 0; n < NUM_FRAMES; n++) {
+        push_frame(n);
+    }
+
+    /* EOS returns once the encode thread has drained the circular buffer */
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+    fail_unless_equals_int(framesOut, NUM_FRAMES);
+    fail_if(mismatch);
+
+    g_object_get(imgenc1, "throughput", &throughput, NULL);
+    fail_unless(throughput > 0);
+
+    cleanup_imgenc1();
+    return throughput;
+}
+
+
+GST_START_TEST(test_encode_frames)
+{
+    run_frames(1, FALSE);
+}
+GST_END_TEST;
+
+
+GST_START_TEST(test_encode_batch)
+{
+    run_frames(BATCH_SIZE, FALSE);
+}
+GST_END_TEST;
+
+
+/* An override applies to the next frame only, however far behind the
+ * codec is when the request comes in.
+ */
+GST_START_TEST(test_encode_qvalue)
+{
+    gint n;
+
+    setenv("DMAI_MOCK_DELAY_IENC1", "2000", 1);
+    setup_imgenc1(BATCH_SIZE, FALSE);
+
+    for (n = 0; n < NUM_FRAMES; n++) {
+        if (n == 0 || n % 5 == 2) {
+            push_qvalue(10 + n);
+        }
+        push_frame(n);
+    }
+
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+    fail_unless_equals_int(framesOut, NUM_FRAMES);
+    fail_if(mismatch);
+
+    for (n = 0; n < NUM_FRAMES; n++) {
+        fail_unless_equals_int(qValues[n],
+            (n == 0 || n % 5 == 2) ? 10 + n : DEFAULT_QVALUE);
+    }
+
+    cleanup_imgenc1();
+    unsetenv("DMAI_MOCK_DELAY_IENC1");
+}
+GST_END_TEST;
+
+
+/* With one output buffer the codec waits for the sink to release each
+ * image; a batch of them keeps both busy at once.
+ */
+GST_START_TEST(test_batch_throughput)
+{
+    gdouble single;
+    gdouble batch;
+
+    setenv("DMAI_MOCK_DELAY_IENC1", ENCODE_DELAY, 1);
+    single = run_frames(1, TRUE);
+    batch  = run_frames(BATCH_SIZE, TRUE);
+    unsetenv("DMAI_MOCK_DELAY_IENC1");
+
+    g_print("TIImgenc1 throughput: %.1f fps one at a time, %.1f fps with "
+        "batchSize %d\n", single, batch, BATCH_SIZE);
+
+    fail_unless(batch > single * 1.4);
+}
+GST_END_TEST;
+
+
+static Suite *tiimgenc1_suite(void)
+{
+    Suite *s        = suite_create("tiimgenc1");
+    TCase *tc_chain = tcase_create("general");
+
+    gst_element_register(NULL, "TIImgenc1", GST_RANK_NONE,
+        GST_TYPE_TIIMGENC1);
+
+    tcase_set_timeout(tc_chain, 60);
+    suite_add_tcase(s, tc_chain);
+    tcase_add_test(tc_chain, test_encode_frames);
+    tcase_add_test(tc_chain, test_encode_batch);
+    tcase_add_test(tc_chain, test_encode_qvalue);
+    tcase_add_test(tc_chain, test_batch_throughput);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tiimgenc1);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
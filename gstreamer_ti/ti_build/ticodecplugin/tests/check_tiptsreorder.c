@@ -0,0 +1,362 @@
+/*
+ * check_tiptsreorder.c
+ *
+ * Runs the GstTIPtsReorder object against a mock of the Vdec2 display and
+ * free buffer queues that, like a real H.264 or MPEG-4 decoder on B-frame
+ * content, returns frames in display order rather than decode order.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <gst/check/gstcheck.h>
+
+#include "gsttiptsreorder.h"
+
+#define FRAME_DURATION (GST_SECOND / 30)
+#define NUM_BUFS       8
+#define NUM_FRAMES     7
+
+/* Frame types, and where the frame is shown in display order */
+typedef struct {
+    gchar  type;
+    gint   displayIdx;
+} MockFrame;
+
+/* I0 B1 B2 P3 B4 B5 P6 in display order, sent to the codec in decode order */
+static const MockFrame stream[NUM_FRAMES] = {
+    { 'I', 0 }, { 'P', 3 }, { 'B', 1 }, { 'B', 2 },
+    { 'P', 6 }, { 'B', 4 }, { 'B', 5 }
+};
+
+/* Mock Vdec2: a B frame is displayed straight away and freed after display.
+ * A reference frame is held until the next one is decoded, then displayed,
+ * and freed once it is no longer referenced.
+ */
+typedef struct {
+    gint      bufs[NUM_BUFS];
+    gint      nextBuf;
+    gpointer  display[NUM_BUFS];
+    gint      numDisplay;
+    gpointer  free[NUM_BUFS];
+    gint      numFree;
+    gpointer  heldRef;
+    gpointer  prevRef;
+    gboolean  dropNextB;
+} MockVdec2;
+
+static MockVdec2        vd;
+static GstTIPtsReorder *reorder;
+static GstClockTime     output[NUM_FRAMES];
+static gint             numOutput;
+
+
+/******************************************************************************
+ * mock_vdec2_process
+ *    Decode a frame into a free output buffer and return that buffer.
+ ******************************************************************************/
+static gpointer mock_vdec2_process(const MockFrame *frame)
+{
+    gpointer hBuf = &vd.bufs[vd.nextBuf];
+
+    vd.nextBuf = (vd.nextBuf + 1) % NUM_BUFS;
+
+    if (frame->type == 'B') {
+        if (vd.dropNextB) {
+            vd.dropNextB            = FALSE;
+            vd.free[vd.numFree++]   = hBuf;
+        }
+        else {
+            vd.display[vd.numDisplay++] = hBuf;
+            vd.free[vd.numFree++]       = hBuf;
+        }
+        return hBuf;
+    }
+
+    if (vd.heldRef) {
+        vd.display[vd.numDisplay++] = vd.heldRef;
+    }
+    if (vd.prevRef) {
+        vd.free[vd.numFree++] = vd.prevRef;
+    }
+    vd.prevRef = vd.heldRef;
+    vd.heldRef = hBuf;
+
+    return hBuf;
+}
+
+
+/******************************************************************************
+ * mock_vdec2_flush
+ *    Hand back every frame the codec still holds.
+ ******************************************************************************/
+static void mock_vdec2_flush(void)
+{
+    if (vd.heldRef) {
+        vd.display[vd.numDisplay++] = vd.heldRef;
+        vd.free[vd.numFree++]       = vd.heldRef;
+    }
+    if (vd.prevRef) {
+        vd.free[vd.numFree++] = vd.prevRef;
+    }
+    vd.heldRef = vd.prevRef = NULL;
+}
+
+
+/******************************************************************************
+ * drain_codec
+ *    Same sequence of calls the TIViddec2 decode thread makes after each
+ *    Vdec2_process call.
+ ******************************************************************************/
+static void drain_codec(void)
+{
+    gint i;
+
+    for (i = 0; i < vd.numDisplay; i++) {
+        fail_unless(numOutput < NUM_FRAMES);
+        output[numOutput++] = gst_tiptsreorder_display(reorder,
+                                  vd.display[i], FRAME_DURATION);
+    }
+    vd.numDisplay = 0;
+
+    for (i = 0; i < vd.numFree; i++) {
+        gst_tiptsreorder_release(reorder, vd.free[i]);
+    }
+    vd.numFree = 0;
+}
+
+
+/******************************************************************************
+ * decode_stream
+ *    Decode the test stream, stamping each input frame with timestamps[i].
+ ******************************************************************************/
+static void decode_stream(const GstClockTime *timestamps)
+{
+    gpointer hBuf;
+    gint     i;
+
+    for (i = 0; i < NUM_FRAMES; i++) {
+        hBuf = mock_vdec2_process(&stream[i]);
+        gst_tiptsreorder_add(reorder, hBuf, timestamps[i]);
+        drain_codec();
+    }
+
+    mock_vdec2_flush();
+    drain_codec();
+}
+
+
+/******************************************************************************
+ * setup / teardown
+ ******************************************************************************/
+static void setup(void)
+{
+    memset(&vd, 0, sizeof(vd));
+    memset(output, 0, sizeof(output));
+    numOutput = 0;
+    reorder   = gst_tiptsreorder_new();
+}
+
+static void teardown(void)
+{
+    gst_tiptsreorder_free(reorder);
+    reorder = NULL;
+}
+
+
+/* Timestamps in presentation order, as qtdemux and matroskademux give */
+GST_START_TEST(test_pts_input)
+{
+    GstClockTime timestamps[NUM_FRAMES];
+    gint         i;
+
+    for (i = 0; i < NUM_FRAMES; i++) {
+        timestamps[i] = stream[i].displayIdx * FRAME_DURATION;
+    }
+
+    decode_stream(timestamps);
+
+    fail_unless_equals_int(numOutput, NUM_FRAMES);
+    for (i = 0; i < NUM_FRAMES; i++) {
+        fail_unless_equals_uint64(output[i], i * FRAME_DURATION);
+    }
+}
+GST_END_TEST;
+
+
+/* Timestamps in decode order, as avidemux gives */
+GST_START_TEST(test_dts_input)
+{
+    GstClockTime timestamps[NUM_FRAMES];
+    gint         i;
+
+    for (i = 0; i < NUM_FRAMES; i++) {
+        timestamps[i] = i * FRAME_DURATION;
+    }
+
+    decode_stream(timestamps);
+
+    fail_unless_equals_int(numOutput, NUM_FRAMES);
+    for (i = 0; i < NUM_FRAMES; i++) {
+        fail_unless_equals_uint64(output[i], i * FRAME_DURATION);
+    }
+}
+GST_END_TEST;
+
+
+/* A frame the codec frees without displaying it gives its timestamp up */
+GST_START_TEST(test_dropped_frame)
+{
+    GstClockTime timestamps[NUM_FRAMES];
+    gint         expected[] = { 0, 2, 3, 4, 5, 6 };
+    gint         i;
+
+    for (i = 0; i < NUM_FRAMES; i++) {
+        timestamps[i] = stream[i].displayIdx * FRAME_DURATION;
+    }
+
+    /* Drop B1 */
+    vd.dropNextB = TRUE;
+    decode_stream(timestamps);
+
+    fail_unless_equals_int(numOutput, NUM_FRAMES - 1);
+    for (i = 0; i < NUM_FRAMES - 1; i++) {
+        fail_unless_equals_uint64(output[i], expected[i] * FRAME_DURATION);
+    }
+}
+GST_END_TEST;
+
+
+/* Frames with no timestamp are extrapolated from the last one */
+GST_START_TEST(test_missing_timestamps)
+{
+    GstClockTime timestamps[NUM_FRAMES];
+    gint         i;
+
+    for (i = 0; i < NUM_FRAMES; i++) {
+        timestamps[i] = GST_CLOCK_TIME_NONE;
+    }
+    timestamps[0] = 10 * FRAME_DURATION;
+
+    decode_stream(timestamps);
+
+    fail_unless_equals_int(numOutput, NUM_FRAMES);
+    for (i = 0; i < NUM_FRAMES; i++) {
+        fail_unless_equals_uint64(output[i], (10 + i) * FRAME_DURATION);
+    }
+}
+GST_END_TEST;
+
+
+/* Nothing stamped at all: leave it to the caller */
+GST_START_TEST(test_no_timestamps)
+{
+    gpointer hBuf = &vd.bufs[0];
+
+    gst_tiptsreorder_add(reorder, hBuf, GST_CLOCK_TIME_NONE);
+    fail_if(GST_CLOCK_TIME_IS_VALID(
+        gst_tiptsreorder_display(reorder, hBuf, FRAME_DURATION)));
+}
+GST_END_TEST;
+
+
+/* After a reset, old timestamps are not handed out again */
+GST_START_TEST(test_reset)
+{
+    gst_tiptsreorder_add(reorder, &vd.bufs[0], 5 * FRAME_DURATION);
+    gst_tiptsreorder_add(reorder, &vd.bufs[1], 6 * FRAME_DURATION);
+    gst_tiptsreorder_reset(reorder);
+
+    gst_tiptsreorder_add(reorder, &vd.bufs[2], FRAME_DURATION);
+    fail_unless_equals_uint64(
+        gst_tiptsreorder_display(reorder, &vd.bufs[2], FRAME_DURATION),
+        FRAME_DURATION);
+    fail_unless_equals_uint64(
+        gst_tiptsreorder_display(reorder, &vd.bufs[0], FRAME_DURATION),
+        2 * FRAME_DURATION);
+}
+GST_END_TEST;
+
+
+/* Frames decoded before a reset are reported once, until their buffer is
+ * used again.
+ */
+GST_START_TEST(test_reset_stale)
+{
+    gst_tiptsreorder_add(reorder, &vd.bufs[0], 5 * FRAME_DURATION);
+    gst_tiptsreorder_add(reorder, &vd.bufs[1], 6 * FRAME_DURATION);
+    gst_tiptsreorder_add(reorder, &vd.bufs[2], 7 * FRAME_DURATION);
+    gst_tiptsreorder_reset(reorder);
+
+    gst_tiptsreorder_add(reorder, &vd.bufs[1], FRAME_DURATION);
+    gst_tiptsreorder_release(reorder, &vd.bufs[2]);
+
+    fail_unless(gst_tiptsreorder_take_stale(reorder, &vd.bufs[0]));
+    fail_if(gst_tiptsreorder_take_stale(reorder, &vd.bufs[0]));
+    fail_if(gst_tiptsreorder_take_stale(reorder, &vd.bufs[1]));
+    fail_if(gst_tiptsreorder_take_stale(reorder, &vd.bufs[2]));
+
+    fail_unless_equals_uint64(
+        gst_tiptsreorder_display(reorder, &vd.bufs[1], FRAME_DURATION),
+        FRAME_DURATION);
+}
+GST_END_TEST;
+
+
+/* Releasing a frame that was never displayed hands back its timestamp */
+GST_START_TEST(test_release_skipped)
+{
+    gst_tiptsreorder_add(reorder, &vd.bufs[0], FRAME_DURATION);
+    gst_tiptsreorder_add(reorder, &vd.bufs[1], 2 * FRAME_DURATION);
+
+    fail_unless_equals_uint64(
+        gst_tiptsreorder_display(reorder, &vd.bufs[0], FRAME_DURATION),
+        FRAME_DURATION);
+    fail_if(GST_CLOCK_TIME_IS_VALID(
+        gst_tiptsreorder_release(reorder, &vd.bufs[0])));
+    fail_unless_equals_uint64(
+        gst_tiptsreorder_release(reorder, &vd.bufs[1]), 2 * FRAME_DURATION);
+}
+GST_END_TEST;
+
+
+static Suite *tiptsreorder_suite(void)
+{
+    Suite *s        = suite_create("tiptsreorder");
+    TCase *tc_chain = tcase_create("general");
+
+    tcase_add_checked_fixture(tc_chain, setup, teardown);
+    tcase_add_test(tc_chain, test_pts_input);
+    tcase_add_test(tc_chain, test_dts_input);
+    tcase_add_test(tc_chain, test_dropped_frame);
+    tcase_add_test(tc_chain, test_missing_timestamps);
+    tcase_add_test(tc_chain, test_no_timestamps);
+    tcase_add_test(tc_chain, test_release_skipped);
+    tcase_add_test(tc_chain, test_reset);
+    tcase_add_test(tc_chain, test_reset_stale);
+    suite_add_tcase(s, tc_chain);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tiptsreorder);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,439 @@
+/*
+ * check_tiquicktime_h264.c
+ *
+ * Checks the conversion of packetized (quicktime) H.264 samples to the
+ * byte-stream format the decoders expect, and benchmarks queuing a demuxed
+ * stream into a GstTICircBuffer with the single pass conversion against the
+ * per NAL unit queuing it replaced.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <string.h>
+#include <gst/check/gstcheck.h>
+
+#include "gstticodecs.h"
+#include "gstticircbuffer.h"
+#include "gsttiquicktime_h264.h"
+
+/* Codec table normally provided by the platform's gstticodecs_<soc>.c */
+GstTICodec gst_ticodec_codecs[] = {
+    { "H.264 Video Decoder", "h264dec", "decode" },
+    { NULL }
+};
+
+static const guint8 start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+
+/* SPS and PPS as returned by gst_h264_get_sps_pps_data */
+static const guint8 sps_pps[] = {
+    0x00, 0x00, 0x00, 0x01, 0x67, 0x4d, 0x40, 0x1f, 0xe8, 0x80, 0x50,
+    0x00, 0x00, 0x00, 0x01, 0x68, 0xeb, 0xef, 0x20
+};
+
+
+/******************************************************************************
+ * new_buffer
+ *    Create a buffer holding a copy of size bytes of data.
+ ******************************************************************************/
+static GstBuffer *new_buffer(const guint8 *data, guint size)
+{
+    GstBuffer *buf = gst_buffer_new_and_alloc(size);
+
+    memcpy(GST_BUFFER_DATA(buf), data, size);
+    return buf;
+}
+
+
+/* Size headers are replaced by start codes, timestamps are kept */
+GST_START_TEST(test_byte_stream)
+{
+    static const guint8 sample[] = {
+        0x00, 0x00, 0x00, 0x05, 0x65, 0x88, 0x84, 0x00, 0x21,
+        0x00, 0x00, 0x00, 0x02, 0x41, 0x9a
+    };
+    static const guint8 expected[] = {
+        0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0x21,
+        0x00, 0x00, 0x00, 0x01, 0x41, 0x9a
+    };
+    GstBuffer *in  = new_buffer(sample, sizeof(sample));
+    GstBuffer *out;
+
+    GST_BUFFER_TIMESTAMP(in) = 40 * GST_MSECOND;
+    GST_BUFFER_DURATION(in)  = 33 * GST_MSECOND;
+
+    out = gst_h264_to_byte_stream(in, NULL, 4);
+    fail_if(out == NULL);
+    fail_unless_equals_int(GST_BUFFER_SIZE(out), sizeof(expected));
+    fail_unless(memcmp(GST_BUFFER_DATA(out), expected, sizeof(expected)) == 0);
+    fail_unless_equals_uint64(GST_BUFFER_TIMESTAMP(out), 40 * GST_MSECOND);
+    fail_unless_equals_uint64(GST_BUFFER_DURATION(out), 33 * GST_MSECOND);
+
+    gst_buffer_unref(out);
+    gst_buffer_unref(in);
+}
+GST_END_TEST;
+
+
+/* SPS and PPS go first; short size headers make the data grow */
+GST_START_TEST(test_byte_stream_sps_pps)
+{
+    static const guint8 sample[] = {
+        0x00, 0x03, 0x06, 0x05, 0x80,
+        0x00, 0x04, 0x65, 0x88, 0x84, 0x00
+    };
+    static const guint8 nals[] = {
+        0x00, 0x00, 0x00, 0x01, 0x06, 0x05, 0x80,
+        0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00
+    };
+    GstBuffer *in     = new_buffer(sample, sizeof(sample));
+    GstBuffer *header = new_buffer(sps_pps, sizeof(sps_pps));
+    GstBuffer *out;
+
+    out = gst_h264_to_byte_stream(in, header, 2);
+    fail_if(out == NULL);
+    fail_unless_equals_int(GST_BUFFER_SIZE(out),
+        sizeof(sps_pps) + sizeof(nals));
+    fail_unless(memcmp(GST_BUFFER_DATA(out), sps_pps, sizeof(sps_pps)) == 0);
+    fail_unless(memcmp(GST_BUFFER_DATA(out) + sizeof(sps_pps), nals,
+        sizeof(nals)) == 0);
+
+    gst_buffer_unref(out);
+    gst_buffer_unref(header);
+    gst_buffer_unref(in);
+}
+GST_END_TEST;
+
+
+/* A NAL unit running past the end of the sample is cut short */
+GST_START_TEST(test_byte_stream_truncated)
+{
+    static const guint8 sample[] = {
+        0x00, 0x00, 0x00, 0x02, 0x41, 0x9a,
+        0x00, 0x00, 0x10, 0x00, 0x41, 0x9b, 0x02
+    };
+    static const guint8 expected[] = {
+        0x00, 0x00, 0x00, 0x01, 0x41, 0x9a,
+        0x00, 0x00, 0x00, 0x01, 0x41, 0x9b, 0x02
+    };
+    GstBuffer *in = new_buffer(sample, sizeof(sample));
+    GstBuffer *out;
+
+    out = gst_h264_to_byte_stream(in, NULL, 4);
+    fail_if(out == NULL);
+    fail_unless_equals_int(GST_BUFFER_SIZE(out), sizeof(expected));
+    fail_unless(memcmp(GST_BUFFER_DATA(out), expected, sizeof(expected)) == 0);
+
+    gst_buffer_unref(out);
+    gst_buffer_unref(in);
+}
+GST_END_TEST;
+
+
+/* A sample nobody else holds is converted without a copy */
+GST_START_TEST(test_parse_and_queue_in_place)
+{
+    static const guint8 sample[] = {
+        0x00, 0x00, 0x00, 0x02, 0x41, 0x9a, 0x00, 0x00
+    };
+    static const guint8 expected[] = {
+        0x00, 0x00, 0x00, 0x01, 0x41, 0x9a
+    };
+    GstTICircBuffer *circBuf = gst_ticircbuffer_new(64, 3, FALSE);
+    GstBuffer       *in      = new_buffer(sample, sizeof(sample));
+    GstBuffer       *window;
+
+    /* Another reference keeps the sample intact */
+    gst_buffer_ref(in);
+    fail_unless(gst_h264_parse_and_queue(circBuf, in, NULL, 4));
+    fail_unless(memcmp(GST_BUFFER_DATA(in), sample, sizeof(sample)) == 0);
+    gst_buffer_unref(in);
+
+    fail_unless(gst_h264_parse_and_queue(circBuf, in, NULL, 4));
+    fail_unless_equals_int(GST_BUFFER_SIZE(in), sizeof(expected));
+    fail_unless(memcmp(GST_BUFFER_DATA(in), expected, sizeof(expected)) == 0);
+    gst_buffer_unref(in);
+
+    gst_ticircbuffer_drain(circBuf, TRUE);
+    window = gst_ticircbuffer_get_data(circBuf);
+    fail_unless_equals_int(GST_BUFFER_SIZE(window), 2 * sizeof(expected));
+    fail_unless(memcmp(GST_BUFFER_DATA(window), expected,
+        sizeof(expected)) == 0);
+    fail_unless(memcmp(GST_BUFFER_DATA(window) + sizeof(expected), expected,
+        sizeof(expected)) == 0);
+    gst_ticircbuffer_data_consumed(circBuf, window, GST_BUFFER_SIZE(window));
+
+    gst_ticircbuffer_unref(circBuf);
+}
+GST_END_TEST;
+
+
+GST_START_TEST(test_is_h264_decoder)
+{
+    fail_unless(gst_is_h264_decoder("h264dec"));
+    fail_if(gst_is_h264_decoder("mpeg4dec"));
+}
+GST_END_TEST;
+
+
+/******************************************************************************
+ * Benchmark
+ ******************************************************************************/
+
+/* Sample sizes for one GOP of a 720p30 stream as qtdemux hands it over: an
+ * IDR picture preceded by an SEI NAL unit, followed by P pictures of one
+ * slice each.  The benchmark loops over the GOP.
+ */
+static const guint gop_sample_sizes[] = {
+    61440, 9216, 7680, 8448, 10752, 6912, 8192, 9984, 7424, 8704,
+    11264, 7168, 8960, 9472, 6656, 8192, 10240, 7936, 8448, 9728,
+    7680, 8960, 11008, 6912, 8192, 9216, 7424, 8704, 10496, 7936
+};
+
+#define SEI_SIZE        24
+#define NUM_GOPS        100
+#define WINDOW_SIZE     (256 * 1024)
+
+typedef gboolean (*QueueFunc)(GstTICircBuffer *circBuf, GstBuffer *buf,
+                      GstBuffer *sps_pps_data, guint8 nal_length);
+
+static GstTICircBuffer *benchBuf;
+
+
+/******************************************************************************
+ * per_nal_parse_and_queue
+ *    Reference implementation, as gst_h264_parse_and_queue was before the
+ *    single pass conversion: the SPS and PPS, then a start code and a
+ *    sub-buffer for each NAL unit, all queued separately for every sample.
+ ******************************************************************************/
+static gboolean per_nal_parse_and_queue(GstTICircBuffer *circBuf,
+                    GstBuffer *buf, GstBuffer *sps_pps_data,
+                    guint8 nal_length)
+{
+    static GstBuffer *nal_code_prefix;
+    guint8    *inBuf  = GST_BUFFER_DATA(buf);
+    gint       avail  = GST_BUFFER_SIZE(buf);
+    gint       offset = 0;
+    gint       nal_size;
+    gint       i;
+    GstBuffer *subBuf;
+
+    if (nal_code_prefix == NULL) {
+        nal_code_prefix = new_buffer(start_code, sizeof(start_code));
+    }
+
+    if (!gst_ticircbuffer_queue_data(circBuf, sps_pps_data)) {
+        return FALSE;
+    }
+
+    do {
+        nal_size = 0;
+        for (i = 0; i < nal_length; i++) {
+            nal_size = (nal_size << 8) | inBuf[i];
+        }
+        inBuf  += nal_length;
+        offset += nal_length;
+
+        if (!gst_ticircbuffer_queue_data(circBuf, nal_code_prefix)) {
+            return FALSE;
+        }
+
+        subBuf = gst_buffer_create_sub(buf, offset, nal_size);
+        if (!gst_ticircbuffer_queue_data(circBuf, subBuf)) {
+            gst_buffer_unref(subBuf);
+            return FALSE;
+        }
+        gst_buffer_unref(subBuf);
+
+        offset += nal_size;
+        inBuf  += nal_size;
+        avail  -= (nal_size + nal_length);
+    } while (avail > 0);
+
+    return TRUE;
+}
+
+
+/******************************************************************************
+ * single_pass_parse_and_queue
+ *    The plugin's implementation, given the SPS and PPS for the first sample
+ *    only, as TIViddec2 does.
+ ******************************************************************************/
+static gboolean single_pass_parse_and_queue(GstTICircBuffer *circBuf,
+                    GstBuffer *buf, GstBuffer *sps_pps_data,
+                    guint8 nal_length)
+{
+    static GstTICircBuffer *lastBuf;
+    gboolean                first = (circBuf != lastBuf);
+
+    lastBuf = circBuf;
+    return gst_h264_parse_and_queue(circBuf, buf,
+               first ? sps_pps_data : NULL, nal_length);
+}
+
+
+/******************************************************************************
+ * new_sample
+ *    Create a packetized sample of size bytes with 4 byte size headers.  The
+ *    first sample of a GOP carries an SEI NAL unit before the picture.
+ ******************************************************************************/
+static GstBuffer *new_sample(guint size, gboolean idr)
+{
+    GstBuffer *buf  = gst_buffer_new_and_alloc(size);
+    guint8    *data = GST_BUFFER_DATA(buf);
+    guint      nal;
+
+    memset(data, 0x5a, size);
+
+    if (idr) {
+        GST_WRITE_UINT32_BE(data, SEI_SIZE);
+        data[4] = 0x06;
+        data += 4 + SEI_SIZE;
+        size -= 4 + SEI_SIZE;
+    }
+
+    nal = size - 4;
+    GST_WRITE_UINT32_BE(data, nal);
+    data[4] = idr ? 0x65 : 0x41;
+
+    return buf;
+}
+
+
+/******************************************************************************
+ * drain_thread
+ *    Read whole windows from the circular buffer until it is drained, the
+ *    way the decode thread does.  Returns the number of bytes read.
+ ******************************************************************************/
+static gpointer drain_thread(gpointer data)
+{
+    guint64   *bytesRead = data;
+    GstBuffer *window;
+    gint       size;
+
+    do {
+        window = gst_ticircbuffer_get_data(benchBuf);
+        size   = GST_BUFFER_SIZE(window);
+        *bytesRead += size;
+        gst_ticircbuffer_data_consumed(benchBuf, window, size);
+    } while (size > 0);
+
+    return NULL;
+}
+
+
+/******************************************************************************
+ * run_benchmark
+ *    Queue NUM_GOPS GOPs with queue_fxn and report the throughput.
+ ******************************************************************************/
+static guint64 run_benchmark(const gchar *name, QueueFunc queue_fxn)
+{
+    GstBuffer  *samples[G_N_ELEMENTS(gop_sample_sizes)];
+    GstBuffer  *header = new_buffer(sps_pps, sizeof(sps_pps));
+    guint64     bytesIn = 0, bytesRead = 0;
+    GThread    *consumer;
+    GTimer     *timer;
+    gdouble     seconds;
+    guint       i, gop;
+
+    for (i = 0; i < G_N_ELEMENTS(gop_sample_sizes); i++) {
+        samples[i] = new_sample(gop_sample_sizes[i], i == 0);
+    }
+
+    benchBuf = gst_ticircbuffer_new(WINDOW_SIZE, 3, FALSE);
+    fail_if(benchBuf == NULL);
+
+    timer    = g_timer_new();
+    consumer = g_thread_create(drain_thread, &bytesRead, TRUE, NULL);
+
+    /* Each sample arrives in a buffer of its own, as from the demuxer */
+    for (gop = 0; gop < NUM_GOPS; gop++) {
+        for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+            GstBuffer *buf = new_buffer(GST_BUFFER_DATA(samples[i]),
+                                 GST_BUFFER_SIZE(samples[i]));
+
+            fail_unless(queue_fxn(benchBuf, buf, header, 4));
+            bytesIn += GST_BUFFER_SIZE(samples[i]);
+            gst_buffer_unref(buf);
+        }
+    }
+
+    gst_ticircbuffer_drain(benchBuf, TRUE);
+    g_thread_join(consumer);
+
+    seconds = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    g_print("%s: %u samples, %.1f MB in %.3f s, %.0f samples/s, %.1f MB/s, "
+            "%" G_GUINT64_FORMAT " bytes decoded\n", name,
+            NUM_GOPS * (guint) G_N_ELEMENTS(samples), bytesIn / 1e6, seconds,
+            NUM_GOPS * G_N_ELEMENTS(samples) / seconds,
+            bytesIn / 1e6 / seconds, bytesRead);
+
+    gst_ticircbuffer_unref(benchBuf);
+    benchBuf = NULL;
+    gst_buffer_unref(header);
+    for (i = 0; i < G_N_ELEMENTS(samples); i++) {
+        gst_buffer_unref(samples[i]);
+    }
+
+    return bytesRead;
+}
+
+
+GST_START_TEST(test_parse_and_queue_perf)
+{
+    guint64 perNal, singlePass;
+    guint64 numSamples = NUM_GOPS * G_N_ELEMENTS(gop_sample_sizes);
+
+    perNal     = run_benchmark("per NAL unit", per_nal_parse_and_queue);
+    singlePass = run_benchmark("single pass", single_pass_parse_and_queue);
+
+    /* The only difference in the output is the SPS and PPS, now sent once */
+    fail_unless_equals_uint64(perNal - singlePass,
+        (numSamples - 1) * sizeof(sps_pps));
+}
+GST_END_TEST;
+
+
+static Suite *tiquicktime_h264_suite(void)
+{
+    Suite *s        = suite_create("tiquicktime_h264");
+    TCase *tc_chain = tcase_create("general");
+    TCase *tc_perf  = tcase_create("perf");
+
+    tcase_add_test(tc_chain, test_byte_stream);
+    tcase_add_test(tc_chain, test_byte_stream_sps_pps);
+    tcase_add_test(tc_chain, test_byte_stream_truncated);
+    tcase_add_test(tc_chain, test_parse_and_queue_in_place);
+    tcase_add_test(tc_chain, test_is_h264_decoder);
+    suite_add_tcase(s, tc_chain);
+
+    tcase_set_timeout(tc_perf, 60);
+    tcase_add_test(tc_perf, test_parse_and_queue_perf);
+    suite_add_tcase(s, tc_perf);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tiquicktime_h264);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,572 @@
+/*
+ * check_tividdec2.c
+ *
+ * Runs the TIViddec2 element on top of the host DMAI and Codec Engine mock
+ * in mock/, whose MPEG-2 "decoder" copies each input frame to its output.
+ * The stress tests push a stream of numbered frames through the decode
+ * thread with the codec, the sink and the decoder's reference hold-back
+ * slowed down or sped up, and check that every frame comes out once, in
+ * order, with its own timestamp.  A seek flushes the element mid-stream,
+ * after which only frames from the new position may come out, with their
+ * own timestamps.  The QoS tests decode an IBBP stream into
+ * a sink too slow to keep up, which tells the decoder how late it is, and
+ * check that only B frames are dropped and that each drop is reported,
+ * whether or not the element would generate timestamps of its own.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <gst/check/gstcheck.h>
+
+#include "gsttividdec2.h"
+#include "gstticodecs.h"
+#include "dmaimock.h"
+
+GstTICodec gst_ticodec_codecs[] = {
+    { "MPEG2 Video Decoder", "mpeg2dec", "decode" },
+    { NULL }
+};
+
+#define WIDTH           64
+#define HEIGHT          48
+#define FRAME_SIZE      (WIDTH * HEIGHT * 2)     /* UYVY out of the mock */
+#define FRAME_DURATION  (GST_SECOND / 30)
+#define NUM_FRAMES      200
+
+/* Frames decoded before the seek, and the first one after it */
+#define SEEK_FRAMES     20
+#define SEEK_TARGET     100
+
+/* Frame types in decode order, and how long the QoS sink takes per frame */
+#define QOS_GOP         "IBBP"
+#define QOS_FRAMES      60
+#define QOS_SINK_DELAY  50000
+
+#define CAPS_STRING \
+    "video/mpeg, mpegversion=(int)2, systemstream=(boolean)false, " \
+    "width=(int)64, height=(int)48, framerate=(fraction)30/1"
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(CAPS_STRING));
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS("video/x-raw-yuv, format=(fourcc)UYVY"));
+
+static GstPad     *mysrcpad;
+static GstPad     *mysinkpad;
+
+/* Written by the decode thread through sink_chain, read once it is done */
+static gint        framesOut;
+static gint        badFrames;
+static gint        sinkDelay;          /* microseconds per output frame */
+static gint        sinkHold;           /* frames kept before unref      */
+static GQueue      heldFrames = G_QUEUE_INIT;
+
+/* Written by the decode thread through seek_sink_chain */
+static gint         lastFrame;
+static gint         framesAfterSeek;
+static gint         seekDone;
+
+/* Written by the decode thread through qos_sink_chain */
+static GstClockTime qosBaseTime;
+static gboolean     framesSeen[QOS_FRAMES];
+
+
+/******************************************************************************
+ * frame_byte
+ *    The value every byte of input frame n is filled with.
+ ******************************************************************************/
+static inline guint8 frame_byte(gint n)
+{
+    return (guint8)(n * 7 + 1);
+}
+
+
+/******************************************************************************
+ * sink_chain
+ *    Check each decoded frame against the next frame number, then let go of
+ *    it, after sinkHold more frames if the test wants the sink to keep some
+ *    buffers the way a display does.
+ ******************************************************************************/
+static GstFlowReturn sink_chain(GstPad *pad, GstBuffer *buf)
+{
+    if (GST_BUFFER_SIZE(buf) != FRAME_SIZE ||
+        GST_BUFFER_DATA(buf)[0] != frame_byte(framesOut) ||
+        GST_BUFFER_DATA(buf)[FRAME_SIZE - 1] != frame_byte(framesOut) ||
+        GST_BUFFER_TIMESTAMP(buf) != framesOut * FRAME_DURATION) {
+        badFrames++;
+    }
+    framesOut++;
+
+    if (sinkDelay) {
+        g_usleep(sinkDelay);
+    }
+
+    g_queue_push_tail(&heldFrames, buf);
+    while (g_queue_get_length(&heldFrames) > sinkHold) {
+        gst_buffer_unref(GST_BUFFER(g_queue_pop_head(&heldFrames)));
+    }
+
+    return GST_FLOW_OK;
+}
+
+
+/******************************************************************************
+ * seek_sink_chain
+ *    Check that each frame has the timestamp of its data and comes after
+ *    the one before it, and that none from before the seek comes out after
+ *    the flush.
+ ******************************************************************************/
+static GstFlowReturn seek_sink_chain(GstPad *pad, GstBuffer *buf)
+{
+    GstClockTime timestamp = GST_BUFFER_TIMESTAMP(buf);
+    gint         n         = timestamp / FRAME_DURATION;
+
+    if (!GST_CLOCK_TIME_IS_VALID(timestamp) ||
+        timestamp != n * FRAME_DURATION || n <= lastFrame ||
+        GST_BUFFER_DATA(buf)[0] != frame_byte(n) ||
+        (g_atomic_int_get(&seekDone) && n < SEEK_TARGET)) {
+        badFrames++;
+    }
+
+    if (n >= SEEK_TARGET) {
+        framesAfterSeek++;
+    }
+    lastFrame = n;
+    g_atomic_int_inc(&framesOut);
+
+    gst_buffer_unref(buf);
+
+    return GST_FLOW_OK;
+}
+
+
+/******************************************************************************
+ * qos_sink_chain
+ *    Note which frame this is, take QOS_SINK_DELAY microseconds to "render"
+ *    it, and send upstream how late it arrived compared to the wall clock
+ *    started by the first frame.
+ ******************************************************************************/
+static GstFlowReturn qos_sink_chain(GstPad *pad, GstBuffer *buf)
+{
+    GstClockTime     now       = gst_util_get_timestamp();
+    GstClockTime     timestamp = GST_BUFFER_TIMESTAMP(buf);
+    GstClockTimeDiff jitter;
+    gint             n;
+
+    if (!GST_CLOCK_TIME_IS_VALID(qosBaseTime)) {
+        qosBaseTime = now - timestamp;
+    }
+    jitter = GST_CLOCK_DIFF(timestamp, now - qosBaseTime);
+
+    n = timestamp / FRAME_DURATION;
+    if (n < 0 || n >= QOS_FRAMES || framesSeen[n] ||
+        timestamp != n * FRAME_DURATION ||
+        GST_BUFFER_DATA(buf)[0] != frame_byte(n)) {
+        badFrames++;
+    }
+    else {
+        framesSeen[n] = TRUE;
+    }
+    framesOut++;
+
+    g_usleep(QOS_SINK_DELAY);
+    gst_buffer_unref(buf);
+
+    gst_pad_push_event(pad, gst_event_new_qos(
+        (gdouble) QOS_SINK_DELAY * GST_USECOND / FRAME_DURATION,
+        jitter, timestamp));
+
+    return GST_FLOW_OK;
+}
+
+
+/******************************************************************************
+ * setup_viddec2
+ *    Create the element with the decode thread at normal priority, so the
+ *    tests run without real-time scheduling rights.
+ ******************************************************************************/
+static GstElement *setup_viddec2(void)
+{
+    GstElement *viddec2;
+
+    framesOut = badFrames = sinkDelay = sinkHold = 0;
+
+    viddec2 = gst_check_setup_element("TIViddec2");
+    g_object_set(viddec2, "RTCodecThread", FALSE, NULL);
+
+    mysrcpad  = gst_check_setup_src_pad(viddec2, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad(viddec2, &sinktemplate, NULL);
+    gst_pad_set_chain_function(mysinkpad, sink_chain);
+    gst_pad_set_active(mysrcpad, TRUE);
+    gst_pad_set_active(mysinkpad, TRUE);
+
+    return viddec2;
+}
+
+
+/******************************************************************************
+ * cleanup_viddec2
+ ******************************************************************************/
+static void cleanup_viddec2(GstElement *viddec2)
+{
+    fail_unless(gst_element_set_state(viddec2, GST_STATE_NULL) ==
+        GST_STATE_CHANGE_SUCCESS);
+
+    while (!g_queue_is_empty(&heldFrames)) {
+        gst_buffer_unref(GST_BUFFER(g_queue_pop_head(&heldFrames)));
+    }
+
+    gst_pad_set_active(mysrcpad, FALSE);
+    gst_pad_set_active(mysinkpad, FALSE);
+    gst_check_teardown_src_pad(viddec2);
+    gst_check_teardown_sink_pad(viddec2);
+    gst_check_teardown_element(viddec2);
+}
+
+
+/******************************************************************************
+ * push_frames
+ *    Push frames first .. first + count - 1 of the test stream.
+ ******************************************************************************/
+static void push_frames(gint first, gint count)
+{
+    GstCaps *caps = gst_caps_from_string(CAPS_STRING);
+    gint     n;
+
+    for (n = first; n < first + count; n++) {
+        GstBuffer *buf = gst_buffer_new_and_alloc(FRAME_SIZE);
+
+        memset(GST_BUFFER_DATA(buf), frame_byte(n), FRAME_SIZE);
+        GST_BUFFER_TIMESTAMP(buf) = n * FRAME_DURATION;
+        GST_BUFFER_DURATION(buf)  = FRAME_DURATION;
+        gst_buffer_set_caps(buf, caps);
+
+        fail_unless_equals_int(gst_pad_push(mysrcpad, buf), GST_FLOW_OK);
+    }
+
+    gst_caps_unref(caps);
+}
+
+
+/******************************************************************************
+ * run_stream
+ *    Decode the whole test stream and check what came out.
+ ******************************************************************************/
+static void run_stream(gint holdFrames, gint codecDelay, gint sinkDelayUs,
+                gint sinkHoldFrames)
+{
+    GstElement *viddec2;
+    gchar       value[16];
+
+    g_snprintf(value, sizeof(value), "%d", holdFrames);
+    setenv("DMAI_MOCK_HOLD_VDEC2", value, 1);
+    g_snprintf(value, sizeof(value), "%d", codecDelay);
+    setenv("DMAI_MOCK_DELAY_VDEC2", value, 1);
+
+    viddec2 = setup_viddec2();
+    sinkDelay = sinkDelayUs;
+    sinkHold  = sinkHoldFrames;
+
+    fail_unless(gst_element_set_state(viddec2, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+    push_frames(0, NUM_FRAMES);
+
+    /* EOS returns once the decode thread has drained the codec */
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+
+    fail_unless_equals_int(framesOut, NUM_FRAMES);
+    fail_unless_equals_int(badFrames, 0);
+
+    cleanup_viddec2(viddec2);
+}
+
+
+/******************************************************************************
+ * run_qos_stream
+ *    Decode an IBBP stream into the slow QoS sink, check that what was
+ *    dropped was B frames only, and return how many frames the codec
+ *    skipped instead of decoding.
+ ******************************************************************************/
+static gint run_qos_stream(gboolean qos, gboolean genTimeStamps)
+{
+    GstElement *viddec2;
+    GstBus     *bus;
+    GstMessage *msg;
+    GstFormat   format;
+    guint64     processed;
+    guint64     dropped;
+    guint64     lastDropped = 0;
+    gint        numSkipped  = DmaiMock_getNumSkippedFrames();
+    gint        n;
+
+    setenv("DMAI_MOCK_GOP_VDEC2", QOS_GOP, 1);
+    setenv("DMAI_MOCK_HOLD_VDEC2", "0", 1);
+    setenv("DMAI_MOCK_DELAY_VDEC2", "0", 1);
+
+    viddec2 = setup_viddec2();
+    g_object_set(viddec2, "qos", qos, "genTimeStamps", genTimeStamps, NULL);
+    gst_pad_set_chain_function(mysinkpad, qos_sink_chain);
+    qosBaseTime = GST_CLOCK_TIME_NONE;
+    memset(framesSeen, 0, sizeof(framesSeen));
+
+    bus = gst_bus_new();
+    gst_element_set_bus(viddec2, bus);
+
+    fail_unless(gst_element_set_state(viddec2, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+    push_frames(0, QOS_FRAMES);
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+
+    fail_unless_equals_int(badFrames, 0);
+
+    /* Every I and P frame is displayed, whatever happens to the B frames */
+    for (n = 0; n < QOS_FRAMES; n++) {
+        if (QOS_GOP[n % strlen(QOS_GOP)] != 'B') {
+            fail_unless(framesSeen[n], "reference frame %d was dropped", n);
+        }
+    }
+
+    /* Each drop is posted with the running count */
+    while ((msg = gst_bus_pop_filtered(bus, GST_MESSAGE_QOS))) {
+        gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+        fail_unless_equals_int(format, GST_FORMAT_BUFFERS);
+        fail_unless_equals_uint64(dropped, lastDropped + 1);
+        lastDropped = dropped;
+        gst_message_unref(msg);
+    }
+    fail_unless_equals_uint64(lastDropped, QOS_FRAMES - framesOut);
+
+    if (qos) {
+        fail_unless(framesOut < QOS_FRAMES);
+    }
+    else {
+        fail_unless_equals_int(framesOut, QOS_FRAMES);
+    }
+
+    gst_element_set_bus(viddec2, NULL);
+    gst_object_unref(bus);
+    cleanup_viddec2(viddec2);
+    unsetenv("DMAI_MOCK_GOP_VDEC2");
+
+    return DmaiMock_getNumSkippedFrames() - numSkipped;
+}
+
+
+GST_START_TEST(test_decode_stream)
+{
+    run_stream(0, 0, 0, 0);
+}
+GST_END_TEST;
+
+
+/* Frames the codec holds back come out in order, and all of them at EOS */
+GST_START_TEST(test_decode_held_frames)
+{
+    run_stream(3, 0, 0, 0);
+}
+GST_END_TEST;
+
+
+/* The circular buffer fills up while the codec is slow */
+GST_START_TEST(test_decode_slow_codec)
+{
+    run_stream(2, 2000, 0, 0);
+}
+GST_END_TEST;
+
+
+/* The decode thread waits on output buffers the sink still holds */
+GST_START_TEST(test_decode_slow_sink)
+{
+    run_stream(2, 0, 2000, 2);
+}
+GST_END_TEST;
+
+
+/* Stopping mid-stream, with the decode thread busy, must not hang and must
+ * leave the element ready to decode again.
+ */
+GST_START_TEST(test_decode_restart)
+{
+    GstElement *viddec2;
+    gint        i;
+
+    setenv("DMAI_MOCK_HOLD_VDEC2", "2", 1);
+    setenv("DMAI_MOCK_DELAY_VDEC2", "500", 1);
+
+    viddec2 = setup_viddec2();
+
+    for (i = 0; i < 5; i++) {
+        framesOut = badFrames = 0;
+
+        fail_unless(gst_element_set_state(viddec2, GST_STATE_PLAYING) ==
+            GST_STATE_CHANGE_SUCCESS);
+        fail_unless(gst_pad_push_event(mysrcpad,
+            gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+        push_frames(0, 20);
+
+        fail_unless(gst_element_set_state(viddec2, GST_STATE_NULL) ==
+            GST_STATE_CHANGE_SUCCESS);
+        fail_unless(framesOut <= 20);
+        fail_unless_equals_int(badFrames, 0);
+    }
+
+    /* A full stream still decodes after all that */
+    framesOut = badFrames = 0;
+    fail_unless(gst_element_set_state(viddec2, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+    push_frames(0, NUM_FRAMES);
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+    fail_unless_equals_int(framesOut, NUM_FRAMES);
+    fail_unless_equals_int(badFrames, 0);
+
+    cleanup_viddec2(viddec2);
+}
+GST_END_TEST;
+
+
+/* After a seek, the frames the codec still held from before and the
+ * timestamps of those frames are gone.
+ */
+GST_START_TEST(test_decode_seek)
+{
+    GstElement *viddec2;
+    gint        i;
+
+    setenv("DMAI_MOCK_HOLD_VDEC2", "2", 1);
+    setenv("DMAI_MOCK_DELAY_VDEC2", "0", 1);
+
+    viddec2 = setup_viddec2();
+    gst_pad_set_chain_function(mysinkpad, seek_sink_chain);
+    lastFrame       = -1;
+    framesAfterSeek = 0;
+    seekDone        = FALSE;
+
+    fail_unless(gst_element_set_state(viddec2, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+    push_frames(0, SEEK_FRAMES);
+
+    /* Wait for all but the frames the codec holds back */
+    for (i = 0; i < 500 && g_atomic_int_get(&framesOut) < SEEK_FRAMES - 2;
+         i++) {
+        g_usleep(10000);
+    }
+    fail_unless_equals_int(g_atomic_int_get(&framesOut), SEEK_FRAMES - 2);
+
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_flush_start()));
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_flush_stop()));
+    g_atomic_int_set(&seekDone, TRUE);
+    fail_unless(gst_pad_push_event(mysrcpad,
+        gst_event_new_new_segment(FALSE, 1.0, GST_FORMAT_TIME,
+            SEEK_TARGET * FRAME_DURATION, -1, SEEK_TARGET * FRAME_DURATION)));
+
+    push_frames(SEEK_TARGET, SEEK_FRAMES);
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+
+    fail_unless_equals_int(badFrames, 0);
+    fail_unless_equals_int(framesAfterSeek, SEEK_FRAMES);
+    fail_unless_equals_int(framesOut, 2 * SEEK_FRAMES - 2);
+
+    cleanup_viddec2(viddec2);
+}
+GST_END_TEST;
+
+
+/* Late B frames are not even decoded when the codec can skip them */
+GST_START_TEST(test_qos_skip_decode)
+{
+    fail_unless(run_qos_stream(TRUE, TRUE) > 0);
+}
+GST_END_TEST;
+
+
+/* The input timestamps are used all the same without genTimeStamps */
+GST_START_TEST(test_qos_input_timestamps)
+{
+    fail_unless(run_qos_stream(TRUE, FALSE) > 0);
+}
+GST_END_TEST;
+
+
+/* A codec that can't skip frames still has late B frames dropped after
+ * decoding, before they go any further.
+ */
+GST_START_TEST(test_qos_drop_output)
+{
+    setenv("DMAI_MOCK_NOSKIP_VDEC2", "1", 1);
+    fail_unless_equals_int(run_qos_stream(TRUE, TRUE), 0);
+    unsetenv("DMAI_MOCK_NOSKIP_VDEC2");
+}
+GST_END_TEST;
+
+
+/* With QoS turned off, every frame reaches the sink however late */
+GST_START_TEST(test_qos_disabled)
+{
+    fail_unless_equals_int(run_qos_stream(FALSE, TRUE), 0);
+}
+GST_END_TEST;
+
+
+static Suite *tividdec2_suite(void)
+{
+    Suite *s        = suite_create("tividdec2");
+    TCase *tc_chain = tcase_create("general");
+
+    gst_element_register(NULL, "TIViddec2", GST_RANK_NONE,
+        GST_TYPE_TIVIDDEC2);
+
+    tcase_set_timeout(tc_chain, 120);
+    suite_add_tcase(s, tc_chain);
+    tcase_add_test(tc_chain, test_decode_stream);
+    tcase_add_test(tc_chain, test_decode_held_frames);
+    tcase_add_test(tc_chain, test_decode_slow_codec);
+    tcase_add_test(tc_chain, test_decode_slow_sink);
+    tcase_add_test(tc_chain, test_decode_restart);
+    tcase_add_test(tc_chain, test_decode_seek);
+    tcase_add_test(tc_chain, test_qos_skip_decode);
+    tcase_add_test(tc_chain, test_qos_input_timestamps);
+    tcase_add_test(tc_chain, test_qos_drop_output);
+    tcase_add_test(tc_chain, test_qos_disabled);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tividdec2);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,392 @@
+/*
+ * check_tividenc1.c
+ *
+ * Runs the TIVidenc1 element on top of the host DMAI and Codec Engine mock
+ * in mock/, whose MPEG-4 "encoder" copies each raw frame to its output, and
+ * checks that every frame comes back out whole, in order and with its
+ * timestamp, however the frames are split across input buffers.  Encoded
+ * frames must come out in the codec's own output buffers, with neither a
+ * copy nor an allocation per frame, and no more of them downstream at once
+ * than the element has.  With an input queue, frames are encoded in a
+ * separate thread while the next ones are pushed in.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+
+#include <gst/check/gstcheck.h>
+
+#include "gsttividenc1.h"
+#include "gsttidmaibuffertransport.h"
+#include "gstticodecs.h"
+#include "dmaimock.h"
+
+GstTICodec gst_ticodec_codecs[] = {
+    { "MPEG4 Video Encoder", "mpeg4enc", "encode" },
+    { NULL }
+};
+
+#define WIDTH           64
+#define HEIGHT          48
+#define FRAME_SIZE      (WIDTH * HEIGHT * 2)
+#define FRAME_DURATION  (GST_SECOND / 30)
+#define NUM_FRAMES      60
+#define NUM_OUTPUT_BUFS 3
+
+#define CAPS_STRING \
+    "video/x-raw-yuv, format=(fourcc)UYVY, width=(int)64, height=(int)48, " \
+    "framerate=(fraction)30/1"
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(CAPS_STRING));
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS("video/mpeg, mpegversion=(int)4"));
+
+static GstPad     *mysrcpad;
+static GstPad     *mysinkpad;
+static GstElement *videnc1;
+
+/* Written by sink_chain in the streaming thread */
+static gint        copies;             /* frames not in a codec buffer  */
+static gint        allocs;             /* frames with malloc'd data     */
+static Int32       buffersCreated;     /* DMAI buffers at first frame   */
+static gint        held;               /* frames not released yet       */
+static gint        heldPeak;
+
+/* If set, frames are released by release_thread after releaseDelay */
+static GAsyncQueue *releaseQueue;
+static gint         releaseDelay;      /* microseconds per frame        */
+
+
+/******************************************************************************
+ * frame_byte
+ *    The value every byte of input frame n is filled with.
+ ******************************************************************************/
+static inline guint8 frame_byte(gint n)
+{
+    return (guint8)(n * 7 + 1);
+}
+
+
+/******************************************************************************
+ * release_frame
+ ******************************************************************************/
+static void release_frame(GstBuffer *buf)
+{
+    g_atomic_int_add(&held, -1);
+    gst_buffer_unref(buf);
+}
+
+
+/******************************************************************************
+ * release_thread
+ *    Release frames the way a slow downstream element would, until the
+ *    queue itself is pushed.
+ ******************************************************************************/
+static gpointer release_thread(gpointer data)
+{
+    gpointer buf;
+
+    while ((buf = g_async_queue_pop(releaseQueue)) != releaseQueue) {
+        g_usleep(releaseDelay);
+        release_frame(GST_BUFFER(buf));
+    }
+
+    return NULL;
+}
+
+
+/******************************************************************************
+ * sink_chain
+ *    Check that the encoded frame is the codec's output buffer itself, keep
+ *    a copy of it for check_output and release it, now or in release_thread.
+ ******************************************************************************/
+static GstFlowReturn sink_chain(GstPad *pad, GstBuffer *buf)
+{
+    Buffer_Handle hEncBuf = DmaiMock_getLastEncoded();
+    gint          nowHeld;
+
+    if (!GST_IS_TIDMAIBUFFERTRANSPORT(buf) || hEncBuf == NULL ||
+        GST_BUFFER_DATA(buf) != (guint8 *) Buffer_getUserPtr(hEncBuf)) {
+        copies++;
+    }
+    if (GST_BUFFER_MALLOCDATA(buf)) {
+        allocs++;
+    }
+    if (buffers == NULL) {
+        buffersCreated = DmaiMock_getNumBuffersCreated();
+    }
+
+    buffers = g_list_append(buffers, gst_buffer_copy(buf));
+
+    nowHeld = g_atomic_int_exchange_and_add(&held, 1) + 1;
+    heldPeak = MAX(heldPeak, nowHeld);
+
+    if (releaseQueue) {
+        g_async_queue_push(releaseQueue, buf);
+    }
+    else {
+        release_frame(buf);
+    }
+
+    return GST_FLOW_OK;
+}
+
+
+/******************************************************************************
+ * setup_videnc1
+ *    Create the element with queueSize frames queued for the encode thread,
+ *    if any, run at normal priority so the tests need no real-time rights.
+ ******************************************************************************/
+static void setup_videnc1(gint queueSize)
+{
+    copies = allocs = held = heldPeak = 0;
+
+    videnc1 = gst_check_setup_element("TIVidenc1");
+    g_object_set(videnc1, "engineName", "encode", "codecName", "mpeg4enc",
+        "numOutputBufs", NUM_OUTPUT_BUFS, "queueSize", queueSize,
+        "RTCodecThread", FALSE, NULL);
+
+    mysrcpad  = gst_check_setup_src_pad(videnc1, &srctemplate, NULL);
+    mysinkpad = gst_check_setup_sink_pad(videnc1, &sinktemplate, NULL);
+    gst_pad_set_chain_function(mysinkpad, sink_chain);
+    gst_pad_set_active(mysrcpad, TRUE);
+    gst_pad_set_active(mysinkpad, TRUE);
+
+    fail_unless(gst_element_set_state(videnc1, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+}
+
+
+/******************************************************************************
+ * cleanup_videnc1
+ ******************************************************************************/
+static void cleanup_videnc1(void)
+{
+    fail_unless(gst_element_set_state(videnc1, GST_STATE_NULL) ==
+        GST_STATE_CHANGE_SUCCESS);
+
+    gst_check_drop_buffers();
+    gst_pad_set_active(mysrcpad, FALSE);
+    gst_pad_set_active(mysinkpad, FALSE);
+    gst_check_teardown_src_pad(videnc1);
+    gst_check_teardown_sink_pad(videnc1);
+    gst_check_teardown_element(videnc1);
+}
+
+
+/******************************************************************************
+ * check_output
+ *    Check the encoded frames collected by the check sink pad.
+ ******************************************************************************/
+static void check_output(gboolean checkTimestamps)
+{
+    GList *l;
+    gint   n = 0;
+
+    fail_unless_equals_int(g_list_length(buffers), NUM_FRAMES);
+
+    for (l = buffers; l; l = l->next, n++) {
+        GstBuffer *buf = GST_BUFFER(l->data);
+
+        fail_unless_equals_int(GST_BUFFER_SIZE(buf), FRAME_SIZE);
+        fail_unless_equals_int(GST_BUFFER_DATA(buf)[0], frame_byte(n));
+        fail_unless_equals_int(GST_BUFFER_DATA(buf)[FRAME_SIZE - 1],
+            frame_byte(n));
+
+        if (checkTimestamps) {
+            fail_unless(GST_BUFFER_TIMESTAMP(buf) == n * FRAME_DURATION);
+        }
+    }
+
+    /* Zero-copy, and nothing allocated once the first frame is out */
+    fail_unless_equals_int(copies, 0);
+    fail_unless_equals_int(allocs, 0);
+    fail_unless_equals_int(DmaiMock_getNumBuffersCreated(), buffersCreated);
+    fail_unless(heldPeak <= NUM_OUTPUT_BUFS);
+}
+
+
+/******************************************************************************
+ * push_frames
+ *    Push frames first .. first + count - 1 of the test stream.
+ ******************************************************************************/
+static void push_frames(gint first, gint count)
+{
+    GstCaps *caps = gst_caps_from_string(CAPS_STRING);
+    gint     n;
+
+    for (n = first; n < first + count; n++) {
+        GstBuffer *buf = gst_buffer_new_and_alloc(FRAME_SIZE);
+
+        memset(GST_BUFFER_DATA(buf), frame_byte(n), FRAME_SIZE);
+        GST_BUFFER_TIMESTAMP(buf) = n * FRAME_DURATION;
+        GST_BUFFER_DURATION(buf)  = FRAME_DURATION;
+        gst_buffer_set_caps(buf, caps);
+
+        fail_unless_equals_int(gst_pad_push(mysrcpad, buf), GST_FLOW_OK);
+    }
+
+    gst_caps_unref(caps);
+}
+
+
+GST_START_TEST(test_encode_frames)
+{
+    setup_videnc1(0);
+    push_frames(0, NUM_FRAMES);
+    check_output(TRUE);
+    cleanup_videnc1();
+}
+GST_END_TEST;
+
+
+/* Downstream holds on to the frames for a while, so the encoder runs out of
+ * output buffers and has to wait for them to come back.
+ */
+GST_START_TEST(test_encode_slow_release)
+{
+    GThread *thread;
+
+    releaseQueue = g_async_queue_new();
+    releaseDelay = 2000;
+    thread = g_thread_create(release_thread, NULL, TRUE, NULL);
+    fail_if(thread == NULL);
+
+    setup_videnc1(0);
+    push_frames(0, NUM_FRAMES);
+
+    g_async_queue_push(releaseQueue, releaseQueue);
+    g_thread_join(thread);
+    g_async_queue_unref(releaseQueue);
+    releaseQueue = NULL;
+
+    fail_unless_equals_int(held, 0);
+    check_output(TRUE);
+    cleanup_videnc1();
+}
+GST_END_TEST;
+
+
+/* Frames queued for a slow encode thread all come out, in order, by EOS */
+GST_START_TEST(test_encode_pipelined)
+{
+    guint64 latency;
+    gdouble throughput;
+
+    setenv("DMAI_MOCK_DELAY_VENC1", "2000", 1);
+
+    setup_videnc1(4);
+    push_frames(0, NUM_FRAMES);
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+
+    check_output(TRUE);
+
+    g_object_get(videnc1, "latency", &latency, "throughput", &throughput,
+        NULL);
+    fail_unless(latency >= 2000 * GST_USECOND);
+    fail_unless(throughput > 0);
+
+    cleanup_videnc1();
+    unsetenv("DMAI_MOCK_DELAY_VENC1");
+}
+GST_END_TEST;
+
+
+/* A frame is queued and the chain function returns while it is encoded */
+GST_START_TEST(test_encode_pipelined_overlap)
+{
+    setenv("DMAI_MOCK_DELAY_VENC1", "50000", 1);
+
+    setup_videnc1(2);
+    push_frames(0, 1);
+    fail_unless(buffers == NULL);
+
+    setenv("DMAI_MOCK_DELAY_VENC1", "0", 1);
+    push_frames(1, NUM_FRAMES - 1);
+    fail_unless(gst_pad_push_event(mysrcpad, gst_event_new_eos()));
+
+    check_output(TRUE);
+    cleanup_videnc1();
+    unsetenv("DMAI_MOCK_DELAY_VENC1");
+}
+GST_END_TEST;
+
+
+/* The sink adapter puts frames back together from arbitrary pieces */
+GST_START_TEST(test_encode_split_frames)
+{
+    GstCaps *caps  = gst_caps_from_string(CAPS_STRING);
+    guint8  *data  = g_malloc(NUM_FRAMES * FRAME_SIZE);
+    gint     piece = FRAME_SIZE / 3 + 5;
+    gint     offset;
+    gint     n;
+
+    for (n = 0; n < NUM_FRAMES; n++) {
+        memset(data + n * FRAME_SIZE, frame_byte(n), FRAME_SIZE);
+    }
+
+    setup_videnc1(0);
+
+    for (offset = 0; offset < NUM_FRAMES * FRAME_SIZE; offset += piece) {
+        gint       size = MIN(piece, NUM_FRAMES * FRAME_SIZE - offset);
+        GstBuffer *buf  = gst_buffer_new_and_alloc(size);
+
+        memcpy(GST_BUFFER_DATA(buf), data + offset, size);
+        gst_buffer_set_caps(buf, caps);
+
+        fail_unless_equals_int(gst_pad_push(mysrcpad, buf), GST_FLOW_OK);
+    }
+    gst_caps_unref(caps);
+    g_free(data);
+
+    check_output(FALSE);
+    cleanup_videnc1();
+}
+GST_END_TEST;
+
+
+static Suite *tividenc1_suite(void)
+{
+    Suite *s        = suite_create("tividenc1");
+    TCase *tc_chain = tcase_create("general");
+
+    gst_element_register(NULL, "TIVidenc1", GST_RANK_NONE,
+        GST_TYPE_TIVIDENC1);
+
+    tcase_set_timeout(tc_chain, 60);
+    suite_add_tcase(s, tc_chain);
+    tcase_add_test(tc_chain, test_encode_frames);
+    tcase_add_test(tc_chain, test_encode_split_frames);
+    tcase_add_test(tc_chain, test_encode_slow_release);
+    tcase_add_test(tc_chain, test_encode_pipelined);
+    tcase_add_test(tc_chain, test_encode_pipelined_overlap);
+
+    return s;
+}
+
+GST_CHECK_MAIN(tividenc1);
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
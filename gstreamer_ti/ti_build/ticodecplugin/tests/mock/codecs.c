@@ -0,0 +1,700 @@
+/*
+ * codecs.c
+ *
+ * Host implementation of Codec Engine and the DMAI codec modules declared
+ * in mock/ti/sdo/dmai/ce, and of the DSP server behind the engines.  The
+ * codecs are pass-through copies with configurable latency; see the module
+ * headers for the environment variables that control them.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ti/sdo/ce/Engine.h>
+#include <ti/sdo/ce/CERuntime.h>
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufferGfx.h>
+#include <ti/sdo/dmai/BufTab.h>
+#include <ti/sdo/dmai/ce/Vdec2.h>
+#include <ti/sdo/dmai/ce/Venc1.h>
+#include <ti/sdo/dmai/ce/Adec1.h>
+#include <ti/sdo/dmai/ce/Ienc1.h>
+
+#include "dmaimock.h"
+
+/* Most frames a decoder will hold back, whatever DMAI_MOCK_HOLD_VDEC2 says */
+#define Vdec2_MAXHOLD       16
+
+/* Longest frame type pattern DMAI_MOCK_GOP_VDEC2 can set */
+#define Vdec2_MAXGOP        64
+
+/* Bytes in one MPEG-1 layer II frame of 16-bit stereo samples */
+#define Adec1_FRAMESIZE     (1152 * 2 * 2)
+
+struct Engine_Obj {
+    Char *name;
+};
+
+struct Server_Obj {
+    Server_MemStat  segs[2];
+};
+
+static struct Server_Obj server = {
+    {
+        { "DDR2",       0x8fb80000, 0x00080000, 0, 0 },
+        { "DDRALGHEAP", 0x88000000, 0x07a00000, 0, 0 }
+    }
+};
+
+struct Vdec2_Object {
+    VIDDEC2_Params         params;
+    VIDDEC2_DynamicParams  dynParams;
+    Int32           frameSize;
+    BufTab_Handle   hBufTab;
+    Int             hold;
+    Bool            flushed;
+    Bool            noSkip;
+
+    /* Frame types in decode order, and how many frames were decoded */
+    Char            gop[Vdec2_MAXGOP + 1];
+    Int             numFrames;
+
+    /* Frames decoded but not displayed yet, oldest first */
+    Buffer_Handle   held[Vdec2_MAXHOLD + 1];
+    Int             numHeld;
+
+    /* Frames to hand back through getDisplayBuf and getFreeBuf */
+    Buffer_Handle   display[Vdec2_MAXHOLD + 2];
+    Int             numDisplay;
+    Buffer_Handle   free[Vdec2_MAXHOLD + 2];
+    Int             numFree;
+};
+
+struct Venc1_Object {
+    VIDENC1_Params  params;
+    Int32           frameSize;
+};
+
+struct Adec1_Object {
+    AUDDEC1_Params  params;
+};
+
+struct Ienc1_Object {
+    IMGENC1_Params         params;
+    IMGENC1_DynamicParams  dynParams;
+    Int32                  frameSize;
+};
+
+static Buffer_Handle lastEncoded = NULL;
+static Int32         lastQValue  = -1;
+static Int32         numSkipped  = 0;
+
+const VIDDEC2_Params Vdec2_Params_DEFAULT = {
+    sizeof(VIDDEC2_Params),
+    576,
+    720,
+    30000,
+    6000000,
+    XDM_BYTE,
+    XDM_YUV_422ILE
+};
+
+const VIDDEC2_DynamicParams Vdec2_DynamicParams_DEFAULT = {
+    sizeof(VIDDEC2_DynamicParams),
+    0, 0, 0, 0, 0, 0
+};
+
+const VIDENC1_Params Venc1_Params_DEFAULT = {
+    sizeof(VIDENC1_Params),
+    XDM_DEFAULT,
+    IVIDEO_LOW_DELAY,
+    576,
+    720,
+    30000,
+    6000000,
+    XDM_BYTE,
+    0,
+    XDM_YUV_422ILE,
+    IVIDEO_PROGRESSIVE,
+    XDM_CHROMA_NA
+};
+
+const VIDENC1_DynamicParams Venc1_DynamicParams_DEFAULT = {
+    sizeof(VIDENC1_DynamicParams),
+    576,
+    720,
+    30000,
+    30000,
+    6000000,
+    30,
+    0,
+    0,
+    0,
+    1,
+    0
+};
+
+const AUDDEC1_Params Adec1_Params_DEFAULT = {
+    sizeof(AUDDEC1_Params),
+    16,
+    0,
+    XDM_LE_16
+};
+
+const AUDDEC1_DynamicParams Adec1_DynamicParams_DEFAULT = {
+    sizeof(AUDDEC1_DynamicParams),
+    0
+};
+
+const IMGENC1_Params Ienc1_Params_DEFAULT = {
+    sizeof(IMGENC1_Params),
+    576,
+    720,
+    1,
+    XDM_BYTE,
+    XDM_YUV_422P
+};
+
+const IMGENC1_DynamicParams Ienc1_DynamicParams_DEFAULT = {
+    sizeof(IMGENC1_DynamicParams),
+    XDM_DEFAULT,
+    XDM_YUV_422ILE,
+    576,
+    720,
+    0,
+    0,
+    75
+};
+
+
+/******************************************************************************
+ * mock_frame_size
+ *    Size of a maxWidth x maxHeight frame in the given XDM chroma format.
+ ******************************************************************************/
+static Int32 mock_frame_size(Int32 width, Int32 height, XDAS_Int32 format)
+{
+    switch (format) {
+        case XDM_YUV_420P:
+        case XDM_YUV_420SP:
+            return width * height * 3 / 2;
+        default:
+            return width * height * 2;
+    }
+}
+
+
+/******************************************************************************
+ * mock_copy
+ *    Copy as much of the input as fits into the output and record how much
+ *    was used on both sides.
+ ******************************************************************************/
+static Int32 mock_copy(Buffer_Handle hInBuf, Buffer_Handle hOutBuf,
+                 Int32 maxBytes)
+{
+    Int32 numBytes = Buffer_getNumBytesUsed(hInBuf);
+
+    if (numBytes <= 0) {
+        numBytes = Buffer_getSize(hInBuf);
+    }
+    if (numBytes > maxBytes) {
+        numBytes = maxBytes;
+    }
+    if (numBytes > Buffer_getSize(hOutBuf)) {
+        numBytes = Buffer_getSize(hOutBuf);
+    }
+
+    memcpy(Buffer_getUserPtr(hOutBuf), Buffer_getUserPtr(hInBuf), numBytes);
+    Buffer_setNumBytesUsed(hInBuf, numBytes);
+    Buffer_setNumBytesUsed(hOutBuf, numBytes);
+
+    return numBytes;
+}
+
+
+/******************************************************************************
+ * Engine
+ ******************************************************************************/
+Void CERuntime_init(Void)
+{
+}
+
+Engine_Handle Engine_open(Char *name, Engine_Attrs *attrs, Engine_Error *ec)
+{
+    Engine_Handle hEngine;
+
+    if (name == NULL || (hEngine = calloc(1, sizeof(*hEngine))) == NULL) {
+        if (ec) {
+            *ec = name ? Engine_ENOMEM : Engine_EEXIST;
+        }
+        return NULL;
+    }
+
+    hEngine->name = name;
+    if (ec) {
+        *ec = Engine_EOK;
+    }
+
+    return hEngine;
+}
+
+Void Engine_close(Engine_Handle hEngine)
+{
+    free(hEngine);
+}
+
+Server_Handle Engine_getServer(Engine_Handle hEngine)
+{
+    if (hEngine == NULL || DmaiMock_getEnv("DSP_SERVER", 1) == 0) {
+        return NULL;
+    }
+
+    return &server;
+}
+
+
+/******************************************************************************
+ * Server
+ ******************************************************************************/
+Int Server_getCpuLoad(Server_Handle hServer)
+{
+    return hServer ? DmaiMock_getEnv("DSP_LOAD", 0) : -1;
+}
+
+Server_Status Server_getNumMemSegs(Server_Handle hServer, Int *numSegs)
+{
+    if (hServer == NULL) {
+        return Server_ENOSERVER;
+    }
+
+    *numSegs = sizeof(hServer->segs) / sizeof(hServer->segs[0]);
+    return Server_EOK;
+}
+
+Server_Status Server_getMemStat(Server_Handle hServer, Int segNum,
+                  Server_MemStat *memStat)
+{
+    UInt32 used = DmaiMock_getEnv("DSP_USED", 0);
+
+    if (hServer == NULL) {
+        return Server_ENOSERVER;
+    }
+
+    if (segNum < 0 || segNum >= sizeof(hServer->segs) /
+                                sizeof(hServer->segs[0])) {
+        return Server_EINVAL;
+    }
+
+    *memStat = hServer->segs[segNum];
+    memStat->used        = used < memStat->size ? used : memStat->size;
+    memStat->maxBlockLen = memStat->size - memStat->used;
+
+    return Server_EOK;
+}
+
+
+/******************************************************************************
+ * Vdec2
+ ******************************************************************************/
+Vdec2_Handle Vdec2_create(Engine_Handle hEngine, Char *codecName,
+                 VIDDEC2_Params *params, VIDDEC2_DynamicParams *dynParams)
+{
+    Vdec2_Handle  hVd;
+    Char         *gop;
+
+    if (hEngine == NULL || codecName == NULL) {
+        return NULL;
+    }
+
+    if ((hVd = calloc(1, sizeof(*hVd))) == NULL) {
+        return NULL;
+    }
+
+    hVd->params    = *params;
+    hVd->dynParams = *dynParams;
+    hVd->frameSize = mock_frame_size(params->maxWidth, params->maxHeight,
+                         params->forceChromaFormat);
+    hVd->hold      = DmaiMock_getEnv("HOLD_VDEC2", 0);
+    hVd->noSkip    = DmaiMock_getEnv("NOSKIP_VDEC2", 0) != 0;
+
+    if ((gop = getenv("DMAI_MOCK_GOP_VDEC2")) != NULL) {
+        strncpy(hVd->gop, gop, Vdec2_MAXGOP);
+    }
+
+    if (hVd->hold < 0) {
+        hVd->hold = 0;
+    }
+    if (hVd->hold > Vdec2_MAXHOLD) {
+        hVd->hold = Vdec2_MAXHOLD;
+    }
+
+    return hVd;
+}
+
+Int Vdec2_delete(Vdec2_Handle hVd)
+{
+    free(hVd);
+    return Dmai_EOK;
+}
+
+Int Vdec2_process(Vdec2_Handle hVd, Buffer_Handle hInBuf,
+        Buffer_Handle hDstBuf)
+{
+    Int32 frameType = IVIDEO_I_FRAME;
+    Int   len;
+
+    DmaiMock_delay("VDEC2");
+
+    /* After a flush the input is ignored and every held frame comes out */
+    if (hVd->flushed) {
+        while (hVd->numHeld > 0) {
+            Buffer_Handle hBuf = hVd->held[0];
+
+            memmove(hVd->held, hVd->held + 1,
+                --hVd->numHeld * sizeof(Buffer_Handle));
+            hVd->display[hVd->numDisplay++] = hBuf;
+            hVd->free[hVd->numFree++]       = hBuf;
+        }
+        hVd->free[hVd->numFree++] = hDstBuf;
+        return Dmai_EOK;
+    }
+
+    if (Buffer_getNumBytesUsed(hInBuf) <= 0) {
+        return Dmai_EFAIL;
+    }
+
+    if ((len = strlen(hVd->gop)) > 0) {
+        switch (hVd->gop[hVd->numFrames % len]) {
+            case 'P':
+                frameType = IVIDEO_P_FRAME;
+                break;
+            case 'B':
+                frameType = IVIDEO_B_FRAME;
+                break;
+        }
+    }
+    hVd->numFrames++;
+
+    mock_copy(hInBuf, hDstBuf, hVd->frameSize);
+    BufferGfx_setFrameType(hDstBuf, frameType);
+
+    /* A skipped frame uses up its input but is never displayed */
+    if (frameType == IVIDEO_B_FRAME &&
+        hVd->dynParams.frameSkipMode == IVIDEO_SKIP_B) {
+        hVd->free[hVd->numFree++] = hDstBuf;
+        numSkipped++;
+        return Dmai_EOK;
+    }
+
+    hVd->held[hVd->numHeld++] = hDstBuf;
+
+    if (hVd->numHeld > hVd->hold) {
+        Buffer_Handle hBuf = hVd->held[0];
+
+        memmove(hVd->held, hVd->held + 1,
+            --hVd->numHeld * sizeof(Buffer_Handle));
+        hVd->display[hVd->numDisplay++] = hBuf;
+        hVd->free[hVd->numFree++]       = hBuf;
+    }
+
+    return Dmai_EOK;
+}
+
+Int Vdec2_flush(Vdec2_Handle hVd)
+{
+    hVd->flushed = TRUE;
+    return Dmai_EOK;
+}
+
+Void Vdec2_setBufTab(Vdec2_Handle hVd, BufTab_Handle hBufTab)
+{
+    hVd->hBufTab = hBufTab;
+}
+
+BufTab_Handle Vdec2_getBufTab(Vdec2_Handle hVd)
+{
+    return hVd->hBufTab;
+}
+
+Buffer_Handle Vdec2_getDisplayBuf(Vdec2_Handle hVd)
+{
+    Buffer_Handle hBuf;
+
+    if (hVd->numDisplay == 0) {
+        return NULL;
+    }
+
+    hBuf = hVd->display[0];
+    memmove(hVd->display, hVd->display + 1,
+        --hVd->numDisplay * sizeof(Buffer_Handle));
+
+    return hBuf;
+}
+
+Buffer_Handle Vdec2_getFreeBuf(Vdec2_Handle hVd)
+{
+    if (hVd->numFree == 0) {
+        return NULL;
+    }
+
+    return hVd->free[--hVd->numFree];
+}
+
+Int32 Vdec2_getInBufSize(Vdec2_Handle hVd)
+{
+    return hVd->frameSize;
+}
+
+Int32 Vdec2_getOutBufSize(Vdec2_Handle hVd)
+{
+    return hVd->frameSize;
+}
+
+Int32 Vdec2_getMinOutBufs(Vdec2_Handle hVd)
+{
+    return hVd->hold + 1;
+}
+
+VIDDEC2_Handle Vdec2_getVisaHandle(Vdec2_Handle hVd)
+{
+    return hVd;
+}
+
+XDAS_Int32 VIDDEC2_control(VIDDEC2_Handle handle, XDAS_Int32 id,
+               VIDDEC2_DynamicParams *dynParams, VIDDEC2_Status *status)
+{
+    switch (id) {
+        case XDM_SETPARAMS:
+            if (handle->noSkip &&
+                dynParams->frameSkipMode != IVIDEO_NO_SKIP) {
+                status->extendedError = 0;
+                return VIDDEC2_EFAIL;
+            }
+            handle->dynParams = *dynParams;
+            return VIDDEC2_EOK;
+        case XDM_GETSTATUS:
+            status->extendedError = 0;
+            return VIDDEC2_EOK;
+        default:
+            return VIDDEC2_EFAIL;
+    }
+}
+
+
+/******************************************************************************
+ * Venc1
+ ******************************************************************************/
+Venc1_Handle Venc1_create(Engine_Handle hEngine, Char *codecName,
+                 VIDENC1_Params *params, VIDENC1_DynamicParams *dynParams)
+{
+    Venc1_Handle hVe;
+
+    if (hEngine == NULL || codecName == NULL) {
+        return NULL;
+    }
+
+    if ((hVe = calloc(1, sizeof(*hVe))) == NULL) {
+        return NULL;
+    }
+
+    hVe->params    = *params;
+    hVe->frameSize = mock_frame_size(params->maxWidth, params->maxHeight,
+                         params->inputChromaFormat);
+
+    return hVe;
+}
+
+Int Venc1_delete(Venc1_Handle hVe)
+{
+    free(hVe);
+    lastEncoded = NULL;
+    return Dmai_EOK;
+}
+
+Int Venc1_process(Venc1_Handle hVe, Buffer_Handle hInBuf,
+        Buffer_Handle hOutBuf)
+{
+    DmaiMock_delay("VENC1");
+
+    mock_copy(hInBuf, hOutBuf, hVe->frameSize);
+    lastEncoded = hOutBuf;
+
+    return Dmai_EOK;
+}
+
+Buffer_Handle DmaiMock_getLastEncoded(void)
+{
+    return lastEncoded;
+}
+
+Int32 Venc1_getInBufSize(Venc1_Handle hVe)
+{
+    return hVe->frameSize;
+}
+
+Int32 Venc1_getOutBufSize(Venc1_Handle hVe)
+{
+    return hVe->frameSize;
+}
+
+
+/******************************************************************************
+ * Adec1
+ ******************************************************************************/
+Adec1_Handle Adec1_create(Engine_Handle hEngine, Char *codecName,
+                 AUDDEC1_Params *params, AUDDEC1_DynamicParams *dynParams)
+{
+    Adec1_Handle hAd;
+
+    if (hEngine == NULL || codecName == NULL) {
+        return NULL;
+    }
+
+    if ((hAd = calloc(1, sizeof(*hAd))) == NULL) {
+        return NULL;
+    }
+
+    hAd->params = *params;
+
+    return hAd;
+}
+
+Int Adec1_delete(Adec1_Handle hAd)
+{
+    free(hAd);
+    return Dmai_EOK;
+}
+
+Int Adec1_process(Adec1_Handle hAd, Buffer_Handle hInBuf,
+        Buffer_Handle hOutBuf)
+{
+    DmaiMock_delay("ADEC1");
+
+    if (mock_copy(hInBuf, hOutBuf, Adec1_FRAMESIZE) <= 0) {
+        return Dmai_EFAIL;
+    }
+
+    return Dmai_EOK;
+}
+
+Int32 Adec1_getInBufSize(Adec1_Handle hAd)
+{
+    return Adec1_FRAMESIZE;
+}
+
+Int32 Adec1_getOutBufSize(Adec1_Handle hAd)
+{
+    return Adec1_FRAMESIZE;
+}
+
+Int Adec1_getSampleRate(Adec1_Handle hAd)
+{
+    return 0;
+}
+
+
+/******************************************************************************
+ * Ienc1
+ ******************************************************************************/
+Ienc1_Handle Ienc1_create(Engine_Handle hEngine, Char *codecName,
+                 IMGENC1_Params *params, IMGENC1_DynamicParams *dynParams)
+{
+    Ienc1_Handle hIe;
+
+    if (hEngine == NULL || codecName == NULL) {
+        return NULL;
+    }
+
+    if ((hIe = calloc(1, sizeof(*hIe))) == NULL) {
+        return NULL;
+    }
+
+    hIe->params    = *params;
+    hIe->dynParams = *dynParams;
+    hIe->frameSize = mock_frame_size(params->maxWidth, params->maxHeight,
+                         dynParams->inputChromaFormat);
+
+    return hIe;
+}
+
+Int Ienc1_delete(Ienc1_Handle hIe)
+{
+    free(hIe);
+    lastQValue = -1;
+    return Dmai_EOK;
+}
+
+Int Ienc1_process(Ienc1_Handle hIe, Buffer_Handle hInBuf,
+        Buffer_Handle hOutBuf)
+{
+    DmaiMock_delay("IENC1");
+
+    mock_copy(hInBuf, hOutBuf, hIe->frameSize);
+    lastQValue = hIe->dynParams.qValue;
+
+    return Dmai_EOK;
+}
+
+Int32 Ienc1_getInBufSize(Ienc1_Handle hIe)
+{
+    return hIe->frameSize;
+}
+
+Int32 Ienc1_getOutBufSize(Ienc1_Handle hIe)
+{
+    return hIe->frameSize;
+}
+
+IMGENC1_Handle Ienc1_getVisaHandle(Ienc1_Handle hIe)
+{
+    return hIe;
+}
+
+XDAS_Int32 IMGENC1_control(IMGENC1_Handle handle, XDAS_Int32 id,
+               IMGENC1_DynamicParams *dynParams, IMGENC1_Status *status)
+{
+    switch (id) {
+        case XDM_SETPARAMS:
+            handle->dynParams = *dynParams;
+            return IMGENC1_EOK;
+        case XDM_GETSTATUS:
+            status->extendedError = 0;
+            return IMGENC1_EOK;
+        default:
+            return IMGENC1_EFAIL;
+    }
+}
+
+Int32 DmaiMock_getLastQValue(void)
+{
+    return lastQValue;
+}
+
+Int32 DmaiMock_getNumSkippedFrames(void)
+{
+    return numSkipped;
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
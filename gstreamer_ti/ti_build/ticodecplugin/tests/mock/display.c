@@ -0,0 +1,419 @@
+/*
+ * display.c
+ *
+ * Host implementation of the DMAI Display, Framecopy, Resize and Ccv
+ * modules declared in mock/ti/sdo/dmai.  Frames are copied with memcpy and
+ * never scaled; the display only queues them.  DMAI_MOCK_DELAY_<MODULE>
+ * (DISPLAY, FRAMECOPY, RESIZE or CCV) adds that many microseconds to each
+ * Display_get or execute call.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufferGfx.h>
+#include <ti/sdo/dmai/BufTab.h>
+#include <ti/sdo/dmai/Ccv.h>
+#include <ti/sdo/dmai/ColorSpace.h>
+#include <ti/sdo/dmai/Display.h>
+#include <ti/sdo/dmai/Framecopy.h>
+#include <ti/sdo/dmai/Resize.h>
+#include <ti/sdo/dmai/VideoStd.h>
+
+#include "dmaimock.h"
+
+struct Display_Object {
+    Display_Attrs   attrs;
+    BufTab_Handle   hBufTab;
+    Bool            ownBufTab;
+
+    /* Buffers not handed out yet, then the ones queued with Display_put */
+    Int             numUnused;
+    Buffer_Handle  *queue;
+    Int             numQueued;
+};
+
+struct Framecopy_Object {
+    Framecopy_Attrs attrs;
+};
+
+struct Resize_Object {
+    Resize_Attrs    attrs;
+};
+
+struct Ccv_Object {
+    Ccv_Attrs       attrs;
+};
+
+#define MOCK_VID_DEFAULT(std, output, device, colorSpace) \
+    { 3, Display_Std_V4L2, std, output, device, 0, colorSpace, -1, -1, \
+      FALSE, 0, 0 }
+
+const Display_Attrs Display_Attrs_DM6446_DM355_VID_DEFAULT =
+    MOCK_VID_DEFAULT(VideoStd_D1_NTSC, Display_Output_COMPOSITE,
+        "/dev/video2", ColorSpace_UYVY);
+const Display_Attrs Display_Attrs_DM6446_DM355_OSD_DEFAULT =
+    { 1, Display_Std_FBDEV, VideoStd_D1_NTSC, Display_Output_COMPOSITE,
+      "/dev/fb0", 0, ColorSpace_RGB565, -1, -1, FALSE, 0, 0 };
+const Display_Attrs Display_Attrs_DM6446_DM355_ATTR_DEFAULT =
+    { 1, Display_Std_FBDEV, VideoStd_D1_NTSC, Display_Output_COMPOSITE,
+      "/dev/fb2", 0, ColorSpace_2BIT, -1, -1, FALSE, 0, 0 };
+const Display_Attrs Display_Attrs_DM6467_VID_DEFAULT =
+    MOCK_VID_DEFAULT(VideoStd_1080I_30, Display_Output_COMPONENT,
+        "/dev/video2", ColorSpace_YUV422PSEMI);
+const Display_Attrs Display_Attrs_DM365_VID_DEFAULT =
+    MOCK_VID_DEFAULT(VideoStd_D1_NTSC, Display_Output_COMPOSITE,
+        "/dev/video2", ColorSpace_UYVY);
+const Display_Attrs Display_Attrs_DM365_OSD_DEFAULT =
+    { 1, Display_Std_FBDEV, VideoStd_D1_NTSC, Display_Output_COMPOSITE,
+      "/dev/fb0", 0, ColorSpace_RGB565, -1, -1, FALSE, 0, 0 };
+const Display_Attrs Display_Attrs_DM365_ATTR_DEFAULT =
+    { 1, Display_Std_FBDEV, VideoStd_D1_NTSC, Display_Output_COMPOSITE,
+      "/dev/fb2", 0, ColorSpace_2BIT, -1, -1, FALSE, 0, 0 };
+const Display_Attrs Display_Attrs_O3530_VID_DEFAULT =
+    MOCK_VID_DEFAULT(VideoStd_VGA, Display_Output_LCD, "/dev/video1",
+        ColorSpace_UYVY);
+
+const Framecopy_Attrs Framecopy_Attrs_DEFAULT = { FALSE, FALSE };
+const Resize_Attrs    Resize_Attrs_DEFAULT    = { 0, 0, 0, 0 };
+const Ccv_Attrs       Ccv_Attrs_DEFAULT       = { FALSE };
+
+static Buffer_Handle  lastDisplayed = NULL;
+
+
+/******************************************************************************
+ * mock_luma_rows
+ *    Number of luma rows a semi-planar buffer has room for, which is where
+ *    its chroma plane starts.
+ ******************************************************************************/
+static Int32 mock_luma_rows(Buffer_Handle hBuf, Int32 lineLength,
+                 ColorSpace_Type colorSpace)
+{
+    Int32 size = Buffer_getSize(hBuf);
+
+    if (colorSpace == ColorSpace_YUV420PSEMI) {
+        return size * 2 / 3 / lineLength;
+    }
+    return size / 2 / lineLength;
+}
+
+
+/******************************************************************************
+ * mock_copy_frame
+ *    Copy the source frame into the destination window, cropped to the
+ *    smaller of the two.  Both buffers must be UYVY or semi-planar; a 420
+ *    source into a 422 destination repeats each chroma row.
+ ******************************************************************************/
+static Int mock_copy_frame(Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf)
+{
+    BufferGfx_Dimensions  srcDim;
+    BufferGfx_Dimensions  dstDim;
+    ColorSpace_Type       srcCs = BufferGfx_getColorSpace(hSrcBuf);
+    ColorSpace_Type       dstCs = BufferGfx_getColorSpace(hDstBuf);
+    Int8                 *src   = Buffer_getUserPtr(hSrcBuf);
+    Int8                 *dst   = Buffer_getUserPtr(hDstBuf);
+    Int32                 width;
+    Int32                 height;
+    Int32                 bpp;
+    Int32                 srcRows;
+    Int32                 dstRows;
+    Int32                 row;
+
+    BufferGfx_getDimensions(hSrcBuf, &srcDim);
+    BufferGfx_getDimensions(hDstBuf, &dstDim);
+
+    width  = srcDim.width  < dstDim.width  ? srcDim.width  : dstDim.width;
+    height = srcDim.height < dstDim.height ? srcDim.height : dstDim.height;
+
+    if (srcCs == ColorSpace_UYVY && dstCs == ColorSpace_UYVY) {
+        bpp = 2;
+    }
+    else if ((srcCs == ColorSpace_YUV420PSEMI ||
+              srcCs == ColorSpace_YUV422PSEMI) &&
+             (dstCs == ColorSpace_YUV420PSEMI ||
+              dstCs == ColorSpace_YUV422PSEMI)) {
+        bpp = 1;
+    }
+    else {
+        return Dmai_EINVAL;
+    }
+
+    for (row = 0; row < height; row++) {
+        memcpy(dst + (dstDim.y + row) * dstDim.lineLength + dstDim.x * bpp,
+               src + (srcDim.y + row) * srcDim.lineLength + srcDim.x * bpp,
+               width * bpp);
+    }
+
+    if (bpp == 2) {
+        return Dmai_EOK;
+    }
+
+    /* Interleaved CbCr plane; 420 has a chroma row for every two luma rows */
+    srcRows = mock_luma_rows(hSrcBuf, srcDim.lineLength, srcCs);
+    dstRows = mock_luma_rows(hDstBuf, dstDim.lineLength, dstCs);
+    src    += srcRows * srcDim.lineLength;
+    dst    += dstRows * dstDim.lineLength;
+
+    if (dstCs == ColorSpace_YUV420PSEMI) {
+        height /= 2;
+    }
+
+    for (row = 0; row < height; row++) {
+        Int32 dstRow = dstDim.y + row;
+        Int32 srcRow = srcDim.y + row;
+
+        if (dstCs == ColorSpace_YUV420PSEMI) {
+            dstRow = dstDim.y / 2 + row;
+        }
+        if (srcCs == ColorSpace_YUV420PSEMI) {
+            srcRow = dstCs == ColorSpace_YUV420PSEMI ?
+                         srcDim.y / 2 + row : (srcDim.y + row) / 2;
+        }
+
+        memcpy(dst + dstRow * dstDim.lineLength + dstDim.x,
+               src + srcRow * srcDim.lineLength + srcDim.x, width);
+    }
+
+    return Dmai_EOK;
+}
+
+
+/******************************************************************************
+ * Display
+ ******************************************************************************/
+Display_Handle Display_create(BufTab_Handle hBufTab, Display_Attrs *attrs)
+{
+    BufferGfx_Attrs gfxAttrs = BufferGfx_Attrs_DEFAULT;
+    Display_Handle  hDisplay;
+    Int32           bufSize;
+
+    if (attrs->numBufs <= 0 ||
+        VideoStd_getResolution(attrs->videoStd, &gfxAttrs.dim.width,
+            &gfxAttrs.dim.height) < 0) {
+        return NULL;
+    }
+
+    if ((hDisplay = calloc(1, sizeof(*hDisplay))) == NULL) {
+        return NULL;
+    }
+
+    hDisplay->attrs = *attrs;
+
+    /* Without a BufTab from the caller the "driver" allocates the frames */
+    if (hBufTab == NULL) {
+        gfxAttrs.colorSpace     = attrs->colorSpace;
+        gfxAttrs.dim.lineLength = BufferGfx_calcLineLength(gfxAttrs.dim.width,
+                                      gfxAttrs.colorSpace);
+        gfxAttrs.bAttrs.useMask = 0;
+
+        if (gfxAttrs.dim.lineLength <= 0) {
+            gfxAttrs.dim.lineLength = gfxAttrs.dim.width * 2;
+        }
+
+        bufSize = gfxAttrs.dim.lineLength * gfxAttrs.dim.height;
+        if (gfxAttrs.colorSpace == ColorSpace_YUV420PSEMI) {
+            bufSize = bufSize * 3 / 2;
+        }
+        else if (gfxAttrs.colorSpace == ColorSpace_YUV422PSEMI) {
+            bufSize = bufSize * 2;
+        }
+
+        hBufTab = BufTab_create(attrs->numBufs, bufSize,
+                      BufferGfx_getBufferAttrs(&gfxAttrs));
+        hDisplay->ownBufTab = TRUE;
+
+        if (hBufTab == NULL) {
+            free(hDisplay);
+            return NULL;
+        }
+    }
+
+    hDisplay->hBufTab   = hBufTab;
+    hDisplay->numUnused = BufTab_getNumBufs(hBufTab);
+    hDisplay->queue     = calloc(hDisplay->numUnused, sizeof(Buffer_Handle));
+
+    if (hDisplay->queue == NULL) {
+        Display_delete(hDisplay);
+        return NULL;
+    }
+
+    return hDisplay;
+}
+
+Int Display_delete(Display_Handle hDisplay)
+{
+    if (hDisplay) {
+        if (hDisplay->ownBufTab && hDisplay->hBufTab) {
+            BufTab_delete(hDisplay->hBufTab);
+        }
+        free(hDisplay->queue);
+        free(hDisplay);
+        lastDisplayed = NULL;
+    }
+    return Dmai_EOK;
+}
+
+Int Display_get(Display_Handle hDisplay, Buffer_Handle *hBufPtr)
+{
+    Int numBufs = BufTab_getNumBufs(hDisplay->hBufTab);
+
+    /* Hand out every frame once before recycling the queued ones */
+    if (hDisplay->numUnused > 0) {
+        *hBufPtr = BufTab_getBuf(hDisplay->hBufTab,
+                       numBufs - hDisplay->numUnused--);
+        return Dmai_EOK;
+    }
+
+    if (hDisplay->numQueued == 0) {
+        return Dmai_EFAIL;
+    }
+
+    /* Stand in for waiting on the frame to be scanned out */
+    DmaiMock_delay("DISPLAY");
+
+    *hBufPtr = hDisplay->queue[0];
+    memmove(hDisplay->queue, hDisplay->queue + 1,
+        --hDisplay->numQueued * sizeof(Buffer_Handle));
+
+    return Dmai_EOK;
+}
+
+Int Display_put(Display_Handle hDisplay, Buffer_Handle hBuf)
+{
+    if (hDisplay->numQueued == BufTab_getNumBufs(hDisplay->hBufTab)) {
+        return Dmai_EFAIL;
+    }
+
+    hDisplay->queue[hDisplay->numQueued++] = hBuf;
+    lastDisplayed = hBuf;
+
+    return Dmai_EOK;
+}
+
+
+Buffer_Handle DmaiMock_getLastDisplayed(void)
+{
+    return lastDisplayed;
+}
+
+
+/******************************************************************************
+ * Framecopy
+ ******************************************************************************/
+Framecopy_Handle Framecopy_create(Framecopy_Attrs *attrs)
+{
+    Framecopy_Handle hFc = calloc(1, sizeof(*hFc));
+
+    if (hFc) {
+        hFc->attrs = *attrs;
+    }
+    return hFc;
+}
+
+Int Framecopy_delete(Framecopy_Handle hFc)
+{
+    free(hFc);
+    return Dmai_EOK;
+}
+
+Int Framecopy_config(Framecopy_Handle hFc, Buffer_Handle hSrcBuf,
+        Buffer_Handle hDstBuf)
+{
+    return Dmai_EOK;
+}
+
+Int Framecopy_execute(Framecopy_Handle hFc, Buffer_Handle hSrcBuf,
+        Buffer_Handle hDstBuf)
+{
+    DmaiMock_delay("FRAMECOPY");
+    return mock_copy_frame(hSrcBuf, hDstBuf);
+}
+
+
+/******************************************************************************
+ * Resize
+ ******************************************************************************/
+Resize_Handle Resize_create(Resize_Attrs *attrs)
+{
+    Resize_Handle hResize = calloc(1, sizeof(*hResize));
+
+    if (hResize) {
+        hResize->attrs = *attrs;
+    }
+    return hResize;
+}
+
+Int Resize_delete(Resize_Handle hResize)
+{
+    free(hResize);
+    return Dmai_EOK;
+}
+
+Int Resize_config(Resize_Handle hResize, Buffer_Handle hSrcBuf,
+        Buffer_Handle hDstBuf)
+{
+    return Dmai_EOK;
+}
+
+Int Resize_execute(Resize_Handle hResize, Buffer_Handle hSrcBuf,
+        Buffer_Handle hDstBuf)
+{
+    DmaiMock_delay("RESIZE");
+    return mock_copy_frame(hSrcBuf, hDstBuf);
+}
+
+
+/******************************************************************************
+ * Ccv
+ ******************************************************************************/
+Ccv_Handle Ccv_create(Ccv_Attrs *attrs)
+{
+    Ccv_Handle hCcv = calloc(1, sizeof(*hCcv));
+
+    if (hCcv) {
+        hCcv->attrs = *attrs;
+    }
+    return hCcv;
+}
+
+Int Ccv_delete(Ccv_Handle hCcv)
+{
+    free(hCcv);
+    return Dmai_EOK;
+}
+
+Int Ccv_config(Ccv_Handle hCcv, Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf)
+{
+    return Dmai_EOK;
+}
+
+Int Ccv_execute(Ccv_Handle hCcv, Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf)
+{
+    DmaiMock_delay("CCV");
+    return mock_copy_frame(hSrcBuf, hDstBuf);
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
@@ -0,0 +1,569 @@
+/*
+ * dmai.c
+ *
+ * Host implementation of the DMAI buffer, BufTab, Rendezvous and platform
+ * modules declared in mock/ti/sdo/dmai, so the plugin can be unit tested
+ * without Codec Engine.  Contiguous memory is plain heap memory here, and
+ * the platform always reports a DM6446.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufferGfx.h>
+#include <ti/sdo/dmai/BufTab.h>
+#include <ti/sdo/dmai/Cpu.h>
+#include <ti/sdo/dmai/Rendezvous.h>
+#include <ti/sdo/dmai/VideoStd.h>
+
+#include "dmaimock.h"
+
+/* Every buffer keeps graphics attributes; basic buffers just ignore them */
+struct Buffer_Object {
+    BufferGfx_Attrs       attrs;
+    BufferGfx_Dimensions  dim;
+    Int8                 *userPtr;
+    Int32          size;
+    Int32          numBytesUsed;
+    UInt16         useMask;
+    Int32          frameType;
+    BufTab_Handle  hBufTab;
+};
+
+struct _BufTab_Object {
+    Int              numBufs;
+    Int32            bufSize;
+    BufferGfx_Attrs  attrs;
+    Buffer_Handle   *bufs;
+};
+
+struct Rendezvous_Object {
+    pthread_mutex_t  mutex;
+    pthread_cond_t   cond;
+    Int              orig;
+    Int              count;
+};
+
+Memory_AllocParams Memory_DEFAULTPARAMS = {
+    Memory_CONTIGPOOL,
+    Memory_NONCACHED,
+    Memory_DEFAULTALIGNMENT,
+    0
+};
+
+const Buffer_Attrs Buffer_Attrs_DEFAULT = {
+    { Memory_CONTIGPOOL, Memory_NONCACHED, Memory_DEFAULTALIGNMENT, 0 },
+    Buffer_Type_BASIC,
+    1,
+    FALSE
+};
+
+const BufferGfx_Attrs BufferGfx_Attrs_DEFAULT = {
+    {
+        { Memory_CONTIGPOOL, Memory_NONCACHED, Memory_DEFAULTALIGNMENT, 0 },
+        Buffer_Type_GRAPHICS,
+        1,
+        FALSE
+    },
+    ColorSpace_NOTSET,
+    { 0, 0, 0, 0, 0 }
+};
+
+const Rendezvous_Attrs Rendezvous_Attrs_DEFAULT = { 0 };
+
+const Cpu_Attrs Cpu_Attrs_DEFAULT = { 0 };
+
+static Int32 numBuffersCreated = 0;
+
+
+/******************************************************************************
+ * Buffer
+ ******************************************************************************/
+Buffer_Handle Buffer_create(Int32 size, Buffer_Attrs *attrs)
+{
+    Buffer_Handle hBuf = calloc(1, sizeof(struct Buffer_Object));
+
+    if (hBuf == NULL) {
+        return NULL;
+    }
+
+    /* Graphics attrs are the leading member of a BufferGfx_Attrs */
+    if (attrs->type == Buffer_Type_GRAPHICS) {
+        hBuf->attrs = *(BufferGfx_Attrs *) attrs;
+    }
+    else {
+        hBuf->attrs        = BufferGfx_Attrs_DEFAULT;
+        hBuf->attrs.bAttrs = *attrs;
+    }
+
+    hBuf->dim     = hBuf->attrs.dim;
+    hBuf->size    = size;
+    hBuf->useMask = attrs->useMask;
+
+    if (!attrs->reference) {
+        hBuf->userPtr = malloc(size > 0 ? size : 1);
+        if (hBuf->userPtr == NULL) {
+            free(hBuf);
+            return NULL;
+        }
+    }
+
+    numBuffersCreated++;
+
+    return hBuf;
+}
+
+Int Buffer_delete(Buffer_Handle hBuf)
+{
+    if (hBuf) {
+        if (!hBuf->attrs.bAttrs.reference) {
+            free(hBuf->userPtr);
+        }
+        free(hBuf);
+    }
+    return Dmai_EOK;
+}
+
+Void Buffer_getAttrs(Buffer_Handle hBuf, Buffer_Attrs *attrs)
+{
+    BufferGfx_Attrs *gfxAttrs = (BufferGfx_Attrs *) attrs;
+
+    if (hBuf->attrs.bAttrs.type == Buffer_Type_GRAPHICS) {
+        *gfxAttrs     = hBuf->attrs;
+        gfxAttrs->dim = hBuf->dim;
+    }
+    else {
+        *attrs = hBuf->attrs.bAttrs;
+    }
+}
+
+Int8 *Buffer_getUserPtr(Buffer_Handle hBuf)
+{
+    return hBuf->userPtr;
+}
+
+Int Buffer_setUserPtr(Buffer_Handle hBuf, Int8 *ptr)
+{
+    if (!hBuf->attrs.bAttrs.reference) {
+        return Dmai_EINVAL;
+    }
+    hBuf->userPtr = ptr;
+    return Dmai_EOK;
+}
+
+Int32 Buffer_getSize(Buffer_Handle hBuf)
+{
+    return hBuf->size;
+}
+
+Int32 Buffer_getNumBytesUsed(Buffer_Handle hBuf)
+{
+    return hBuf->numBytesUsed;
+}
+
+Void Buffer_setNumBytesUsed(Buffer_Handle hBuf, Int32 numBytes)
+{
+    hBuf->numBytesUsed = numBytes;
+}
+
+UInt16 Buffer_getUseMask(Buffer_Handle hBuf)
+{
+    return hBuf->useMask;
+}
+
+Void Buffer_setUseMask(Buffer_Handle hBuf, UInt16 useMask)
+{
+    hBuf->useMask = useMask;
+}
+
+Void Buffer_freeUseMask(Buffer_Handle hBuf, UInt16 useMask)
+{
+    hBuf->useMask &= ~useMask;
+}
+
+BufTab_Handle Buffer_getBufTab(Buffer_Handle hBuf)
+{
+    return hBuf->hBufTab;
+}
+
+
+/******************************************************************************
+ * BufferGfx
+ ******************************************************************************/
+Int32 BufferGfx_calcLineLength(Int32 width, ColorSpace_Type colorSpace)
+{
+    switch (colorSpace) {
+        case ColorSpace_UYVY:
+        case ColorSpace_RGB565:
+            return width * 2;
+        case ColorSpace_RGB888:
+            return width * 3;
+        case ColorSpace_YUV420PSEMI:
+        case ColorSpace_YUV422PSEMI:
+        case ColorSpace_YUV420P:
+        case ColorSpace_YUV422P:
+        case ColorSpace_YUV444P:
+        case ColorSpace_GRAY:
+            return width;
+        default:
+            return Dmai_EINVAL;
+    }
+}
+
+Int BufferGfx_getDimensions(Buffer_Handle hBuf, BufferGfx_Dimensions *dim)
+{
+    *dim = hBuf->dim;
+    return Dmai_EOK;
+}
+
+Int BufferGfx_setDimensions(Buffer_Handle hBuf, BufferGfx_Dimensions *dim)
+{
+    hBuf->dim = *dim;
+    return Dmai_EOK;
+}
+
+Int BufferGfx_resetDimensions(Buffer_Handle hBuf)
+{
+    hBuf->dim = hBuf->attrs.dim;
+    return Dmai_EOK;
+}
+
+ColorSpace_Type BufferGfx_getColorSpace(Buffer_Handle hBuf)
+{
+    return hBuf->attrs.colorSpace;
+}
+
+Int32 BufferGfx_getFrameType(Buffer_Handle hBuf)
+{
+    return hBuf->frameType;
+}
+
+Void BufferGfx_setFrameType(Buffer_Handle hBuf, Int32 frameType)
+{
+    hBuf->frameType = frameType;
+}
+
+
+/******************************************************************************
+ * BufTab
+ ******************************************************************************/
+BufTab_Handle BufTab_create(Int numBufs, Int32 size, Buffer_Attrs *attrs)
+{
+    BufTab_Handle hBufTab = calloc(1, sizeof(struct _BufTab_Object));
+
+    if (hBufTab == NULL) {
+        return NULL;
+    }
+
+    /* Keep the attrs so BufTab_expand can create matching buffers */
+    if (attrs->type == Buffer_Type_GRAPHICS) {
+        hBufTab->attrs = *(BufferGfx_Attrs *) attrs;
+    }
+    else {
+        hBufTab->attrs        = BufferGfx_Attrs_DEFAULT;
+        hBufTab->attrs.bAttrs = *attrs;
+    }
+    hBufTab->bufSize = size;
+
+    if (BufTab_expand(hBufTab, numBufs) < 0) {
+        BufTab_delete(hBufTab);
+        return NULL;
+    }
+
+    return hBufTab;
+}
+
+Int BufTab_delete(BufTab_Handle hBufTab)
+{
+    Int i;
+
+    for (i = 0; i < hBufTab->numBufs; i++) {
+        Buffer_delete(hBufTab->bufs[i]);
+    }
+    free(hBufTab->bufs);
+    free(hBufTab);
+
+    return Dmai_EOK;
+}
+
+Buffer_Handle BufTab_getFreeBuf(BufTab_Handle hBufTab)
+{
+    Int i;
+
+    for (i = 0; i < hBufTab->numBufs; i++) {
+        if (hBufTab->bufs[i]->useMask == 0) {
+            hBufTab->bufs[i]->useMask =
+                hBufTab->bufs[i]->attrs.bAttrs.useMask;
+            return hBufTab->bufs[i];
+        }
+    }
+
+    return NULL;
+}
+
+Void BufTab_freeBuf(Buffer_Handle hBuf)
+{
+    hBuf->useMask = 0;
+}
+
+Int BufTab_getNumBufs(BufTab_Handle hBufTab)
+{
+    return hBufTab->numBufs;
+}
+
+Buffer_Handle BufTab_getBuf(BufTab_Handle hBufTab, Int bufIdx)
+{
+    return hBufTab->bufs[bufIdx];
+}
+
+Int BufTab_chunk(BufTab_Handle hBufTab, Int numBufs, Int32 bufSize)
+{
+    Int i;
+
+    if (bufSize > hBufTab->bufSize) {
+        return Dmai_EINVAL;
+    }
+
+    for (i = 0; i < hBufTab->numBufs; i++) {
+        hBufTab->bufs[i]->size = bufSize;
+    }
+    hBufTab->bufSize = bufSize;
+
+    return numBufs > hBufTab->numBufs ? numBufs - hBufTab->numBufs : 0;
+}
+
+Int BufTab_expand(BufTab_Handle hBufTab, Int numBufs)
+{
+    Buffer_Handle *bufs;
+    Int            i;
+
+    bufs = realloc(hBufTab->bufs,
+               (hBufTab->numBufs + numBufs) * sizeof(Buffer_Handle));
+    if (bufs == NULL && hBufTab->numBufs + numBufs > 0) {
+        return Dmai_ENOMEM;
+    }
+    hBufTab->bufs = bufs;
+
+    for (i = 0; i < numBufs; i++) {
+        Buffer_Handle hBuf = Buffer_create(hBufTab->bufSize,
+                                 BufferGfx_getBufferAttrs(&hBufTab->attrs));
+        if (hBuf == NULL) {
+            return Dmai_ENOMEM;
+        }
+        hBuf->hBufTab = hBufTab;
+        hBuf->useMask = 0;
+        hBufTab->bufs[hBufTab->numBufs++] = hBuf;
+    }
+
+    return Dmai_EOK;
+}
+
+
+/******************************************************************************
+ * Rendezvous
+ ******************************************************************************/
+Rendezvous_Handle Rendezvous_create(Int count, Rendezvous_Attrs *attrs)
+{
+    Rendezvous_Handle hRv = calloc(1, sizeof(struct Rendezvous_Object));
+
+    if (hRv == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_init(&hRv->mutex, NULL);
+    pthread_cond_init(&hRv->cond, NULL);
+    hRv->orig  = count;
+    hRv->count = count;
+
+    return hRv;
+}
+
+Int Rendezvous_delete(Rendezvous_Handle hRv)
+{
+    if (hRv) {
+        pthread_mutex_destroy(&hRv->mutex);
+        pthread_cond_destroy(&hRv->cond);
+        free(hRv);
+    }
+    return Dmai_EOK;
+}
+
+Void Rendezvous_meet(Rendezvous_Handle hRv)
+{
+    pthread_mutex_lock(&hRv->mutex);
+    if (hRv->count > 0) {
+        if (--hRv->count == 0) {
+            pthread_cond_broadcast(&hRv->cond);
+        }
+    }
+    while (hRv->count != 0) {
+        pthread_cond_wait(&hRv->cond, &hRv->mutex);
+    }
+    pthread_mutex_unlock(&hRv->mutex);
+}
+
+Void Rendezvous_force(Rendezvous_Handle hRv)
+{
+    pthread_mutex_lock(&hRv->mutex);
+    hRv->count = 0;
+    pthread_cond_broadcast(&hRv->cond);
+    pthread_mutex_unlock(&hRv->mutex);
+}
+
+Void Rendezvous_reset(Rendezvous_Handle hRv)
+{
+    pthread_mutex_lock(&hRv->mutex);
+    hRv->count = hRv->orig;
+    pthread_mutex_unlock(&hRv->mutex);
+}
+
+
+/******************************************************************************
+ * Cpu
+ ******************************************************************************/
+struct Cpu_Object {
+    Cpu_Device device;
+};
+
+Cpu_Handle Cpu_create(Cpu_Attrs *attrs)
+{
+    Cpu_Handle hCpu = calloc(1, sizeof(struct Cpu_Object));
+
+    if (hCpu != NULL) {
+        hCpu->device = Cpu_Device_DM6446;
+    }
+
+    return hCpu;
+}
+
+Int Cpu_delete(Cpu_Handle hCpu)
+{
+    free(hCpu);
+    return Dmai_EOK;
+}
+
+Int Cpu_getDevice(Cpu_Handle hCpu, Cpu_Device *device)
+{
+    *device = Cpu_Device_DM6446;
+    return Dmai_EOK;
+}
+
+
+/******************************************************************************
+ * VideoStd
+ ******************************************************************************/
+Int VideoStd_getResolution(VideoStd_Type videoStd, Int32 *width,
+        Int32 *height)
+{
+    switch (videoStd) {
+        case VideoStd_CIF:
+            *width  = VideoStd_CIF_WIDTH;
+            *height = VideoStd_CIF_HEIGHT;
+            break;
+        case VideoStd_SIF_NTSC:
+            *width  = VideoStd_SIF_WIDTH;
+            *height = VideoStd_SIF_NTSC_HEIGHT;
+            break;
+        case VideoStd_SIF_PAL:
+            *width  = VideoStd_SIF_WIDTH;
+            *height = VideoStd_SIF_PAL_HEIGHT;
+            break;
+        case VideoStd_VGA:
+            *width  = VideoStd_VGA_WIDTH;
+            *height = VideoStd_VGA_HEIGHT;
+            break;
+        case VideoStd_D1_NTSC:
+            *width  = VideoStd_D1_WIDTH;
+            *height = VideoStd_D1_NTSC_HEIGHT;
+            break;
+        case VideoStd_D1_PAL:
+            *width  = VideoStd_D1_WIDTH;
+            *height = VideoStd_D1_PAL_HEIGHT;
+            break;
+        case VideoStd_480P:
+            *width  = VideoStd_480P_WIDTH;
+            *height = VideoStd_480P_HEIGHT;
+            break;
+        case VideoStd_576P:
+            *width  = VideoStd_576P_WIDTH;
+            *height = VideoStd_576P_HEIGHT;
+            break;
+        case VideoStd_720P_60:
+        case VideoStd_720P_50:
+            *width  = VideoStd_720P_WIDTH;
+            *height = VideoStd_720P_HEIGHT;
+            break;
+        case VideoStd_1080I_30:
+        case VideoStd_1080I_25:
+        case VideoStd_1080P_30:
+        case VideoStd_1080P_25:
+        case VideoStd_1080P_24:
+            *width  = VideoStd_1080I_WIDTH;
+            *height = VideoStd_1080I_HEIGHT;
+            break;
+        default:
+            return Dmai_EINVAL;
+    }
+
+    return Dmai_EOK;
+}
+
+
+/******************************************************************************
+ * Mock configuration
+ ******************************************************************************/
+Int32 DmaiMock_getEnv(const Char *name, Int32 def)
+{
+    Char  var[64];
+    Char *value;
+
+    snprintf(var, sizeof(var), "DMAI_MOCK_%s", name);
+    value = getenv(var);
+
+    return (value && *value) ? strtol(value, NULL, 0) : def;
+}
+
+Int32 DmaiMock_getNumBuffersCreated(void)
+{
+    return numBuffersCreated;
+}
+
+Void DmaiMock_delay(const Char *module)
+{
+    Char  name[64];
+    Int32 usecs;
+
+    snprintf(name, sizeof(name), "DELAY_%s", module);
+    usecs = DmaiMock_getEnv(name, 0);
+
+    if (usecs > 0) {
+        usleep(usecs);
+    }
+}
+
+
+/******************************************************************************
+ * Custom ViM Settings for editing this file
+ ******************************************************************************/
+#if 0
+ Tabs (use 4 spaces for indentation)
+ vim:set tabstop=4:      /* Use 4 spaces for tabs          */
+ vim:set shiftwidth=4:   /* Use 4 spaces for >> operations */
+ vim:set expandtab:      /* Expand tabs into white spaces  */
+#endif
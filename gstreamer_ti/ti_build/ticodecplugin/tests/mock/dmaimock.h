@@ -0,0 +1,49 @@
+/*
+ * dmaimock.h
+ *
+ * Helpers shared by the host DMAI and Codec Engine stand-ins in mock/.
+ * They are not part of the DMAI API and the plugin sources never see them.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef dmaimock_h_
+#define dmaimock_h_
+
+#include <xdc/std.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+/* Sleep for DMAI_MOCK_DELAY_<module> microseconds, if that is set.  The
+ * variable is read on every call so a test can change it mid-stream.
+ */
+extern Void  DmaiMock_delay(const Char *module);
+
+/* Return the integer value of DMAI_MOCK_<name>, or def if it is not set */
+extern Int32 DmaiMock_getEnv(const Char *name, Int32 def);
+
+/* Return the buffer most recently queued with Display_put, or NULL */
+extern Buffer_Handle DmaiMock_getLastDisplayed(void);
+
+/* Return the output buffer of the most recent Venc1_process, or NULL */
+extern Buffer_Handle DmaiMock_getLastEncoded(void);
+
+/* Return the qValue of the most recent Ienc1_process, or -1 */
+extern Int32 DmaiMock_getLastQValue(void);
+
+/* Return how many frames Vdec2_process has skipped since the process began */
+extern Int32 DmaiMock_getNumSkippedFrames(void);
+
+/* Return how many buffers Buffer_create has made, BufTab ones included */
+extern Int32 DmaiMock_getNumBuffersCreated(void);
+
+#endif /* dmaimock_h_ */
@@ -0,0 +1,26 @@
+/*
+ * CERuntime.h
+ *
+ * Host stand-in for the Codec Engine runtime initialization.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_ce_CERuntime_h_
+#define ti_sdo_ce_CERuntime_h_
+
+#include <xdc/std.h>
+
+extern Void CERuntime_init(Void);
+
+#endif /* ti_sdo_ce_CERuntime_h_ */
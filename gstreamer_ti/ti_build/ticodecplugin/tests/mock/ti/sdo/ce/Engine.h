@@ -0,0 +1,45 @@
+/*
+ * Engine.h
+ *
+ * Host stand-in for the Codec Engine Engine module.  Any engine name can be
+ * opened; the codecs behind it are the pass-through codecs of mock/codecs.c.
+ * Every engine has the mock DSP server of Server.h behind it, unless
+ * DMAI_MOCK_DSP_SERVER is set to 0.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_ce_Engine_h_
+#define ti_sdo_ce_Engine_h_
+
+#include <xdc/std.h>
+#include <ti/sdo/ce/Server.h>
+
+typedef struct Engine_Obj *Engine_Handle;
+
+typedef struct Engine_Attrs {
+    Char *procId;
+} Engine_Attrs;
+
+typedef enum {
+    Engine_EOK = 0,
+    Engine_EEXIST,
+    Engine_ENOMEM
+} Engine_Error;
+
+extern Engine_Handle Engine_open(Char *name, Engine_Attrs *attrs,
+                         Engine_Error *ec);
+extern Void          Engine_close(Engine_Handle hEngine);
+extern Server_Handle Engine_getServer(Engine_Handle hEngine);
+
+#endif /* ti_sdo_ce_Engine_h_ */
@@ -0,0 +1,58 @@
+/*
+ * Server.h
+ *
+ * Host stand-in for the Codec Engine Server module, which reports on the
+ * DSP server behind a remote engine.  The mock server has two memory
+ * segments.  DMAI_MOCK_DSP_LOAD sets the CPU load it reports and
+ * DMAI_MOCK_DSP_USED the number of bytes used in each segment; both are
+ * read on every call.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_ce_Server_h_
+#define ti_sdo_ce_Server_h_
+
+#include <xdc/std.h>
+
+#define Server_MAXSEGNAMELENGTH 32
+
+typedef struct Server_Obj *Server_Handle;
+
+typedef enum {
+    Server_EOK = 0,
+    Server_ENOSERVER,
+    Server_ENOMEM,
+    Server_ERUNTIME,
+    Server_EINVAL,
+    Server_EWRONGSTATE,
+    Server_EINUSE,
+    Server_ENOTFOUND,
+    Server_EFAIL
+} Server_Status;
+
+typedef struct Server_MemStat {
+    Char   name[Server_MAXSEGNAMELENGTH + 1];
+    UInt32 base;
+    UInt32 size;
+    UInt32 used;
+    UInt32 maxBlockLen;
+} Server_MemStat;
+
+extern Int           Server_getCpuLoad(Server_Handle server);
+extern Server_Status Server_getNumMemSegs(Server_Handle server,
+                         Int *numSegs);
+extern Server_Status Server_getMemStat(Server_Handle server, Int segNum,
+                         Server_MemStat *memStat);
+
+#endif /* ti_sdo_ce_Server_h_ */
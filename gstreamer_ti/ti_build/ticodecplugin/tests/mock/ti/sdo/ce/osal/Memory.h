@@ -0,0 +1,47 @@
+/*
+ * Memory.h
+ *
+ * Host stand-in for the Codec Engine OSAL Memory module.  Only the
+ * allocation parameters embedded in Buffer_Attrs are defined; the mock
+ * allocates everything from the heap.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_ce_osal_Memory_h_
+#define ti_sdo_ce_osal_Memory_h_
+
+#include <xdc/std.h>
+
+typedef enum {
+    Memory_MALLOC = 0,
+    Memory_SEG,
+    Memory_CONTIGPOOL,
+    Memory_CONTIGHEAP
+} Memory_type;
+
+#define Memory_NONCACHED  0x0000
+#define Memory_CACHED     0x0001
+
+#define Memory_DEFAULTALIGNMENT ((UInt)(-1))
+
+typedef struct Memory_AllocParams {
+    Memory_type  type;
+    UInt         flags;
+    UInt         align;
+    UInt         seg;
+} Memory_AllocParams;
+
+extern Memory_AllocParams Memory_DEFAULTPARAMS;
+
+#endif /* ti_sdo_ce_osal_Memory_h_ */
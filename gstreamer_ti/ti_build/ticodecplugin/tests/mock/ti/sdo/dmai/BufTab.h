@@ -0,0 +1,39 @@
+/*
+ * BufTab.h
+ *
+ * Host stand-in for the DMAI BufTab module: a table of equally sized
+ * buffers, each free while its use mask is zero.  BufTab_chunk only shrinks
+ * the buffers; it does not split them, so every missing buffer is left for
+ * BufTab_expand to add.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_BufTab_h_
+#define ti_sdo_dmai_BufTab_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+extern BufTab_Handle BufTab_create(Int numBufs, Int32 size,
+                         Buffer_Attrs *attrs);
+extern Int           BufTab_delete(BufTab_Handle hBufTab);
+extern Buffer_Handle BufTab_getFreeBuf(BufTab_Handle hBufTab);
+extern Void          BufTab_freeBuf(Buffer_Handle hBuf);
+extern Int           BufTab_getNumBufs(BufTab_Handle hBufTab);
+extern Buffer_Handle BufTab_getBuf(BufTab_Handle hBufTab, Int bufIdx);
+extern Int           BufTab_chunk(BufTab_Handle hBufTab, Int numBufs,
+                         Int32 bufSize);
+extern Int           BufTab_expand(BufTab_Handle hBufTab, Int numBufs);
+
+#endif /* ti_sdo_dmai_BufTab_h_ */
@@ -0,0 +1,57 @@
+/*
+ * Buffer.h
+ *
+ * Host stand-in for the DMAI Buffer module.  Buffers are plain heap memory;
+ * reference buffers point at memory owned by someone else.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Buffer_h_
+#define ti_sdo_dmai_Buffer_h_
+
+#include <ti/sdo/ce/osal/Memory.h>
+#include <ti/sdo/dmai/Dmai.h>
+
+typedef struct Buffer_Object *Buffer_Handle;
+typedef struct _BufTab_Object *BufTab_Handle;
+
+typedef enum {
+    Buffer_Type_BASIC = 0,
+    Buffer_Type_GRAPHICS
+} Buffer_Type;
+
+typedef struct Buffer_Attrs {
+    Memory_AllocParams  memParams;
+    Buffer_Type         type;
+    UInt16              useMask;
+    Bool                reference;
+} Buffer_Attrs;
+
+extern const Buffer_Attrs Buffer_Attrs_DEFAULT;
+
+extern Buffer_Handle Buffer_create(Int32 size, Buffer_Attrs *attrs);
+extern Int           Buffer_delete(Buffer_Handle hBuf);
+extern Void          Buffer_getAttrs(Buffer_Handle hBuf, Buffer_Attrs *attrs);
+extern Int8         *Buffer_getUserPtr(Buffer_Handle hBuf);
+extern Int           Buffer_setUserPtr(Buffer_Handle hBuf, Int8 *ptr);
+extern Int32         Buffer_getSize(Buffer_Handle hBuf);
+extern Int32         Buffer_getNumBytesUsed(Buffer_Handle hBuf);
+extern Void          Buffer_setNumBytesUsed(Buffer_Handle hBuf,
+                         Int32 numBytes);
+extern UInt16        Buffer_getUseMask(Buffer_Handle hBuf);
+extern Void          Buffer_setUseMask(Buffer_Handle hBuf, UInt16 useMask);
+extern Void          Buffer_freeUseMask(Buffer_Handle hBuf, UInt16 useMask);
+extern BufTab_Handle Buffer_getBufTab(Buffer_Handle hBuf);
+
+#endif /* ti_sdo_dmai_Buffer_h_ */
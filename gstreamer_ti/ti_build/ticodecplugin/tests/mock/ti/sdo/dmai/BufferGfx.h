@@ -0,0 +1,60 @@
+/*
+ * BufferGfx.h
+ *
+ * Host stand-in for the DMAI BufferGfx module.  A graphics buffer is a
+ * Buffer_Type_GRAPHICS buffer that also carries a colorspace and the
+ * dimensions of the frame it holds.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_BufferGfx_h_
+#define ti_sdo_dmai_BufferGfx_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/ColorSpace.h>
+
+typedef struct BufferGfx_Dimensions {
+    Int32 x;
+    Int32 y;
+    Int32 width;
+    Int32 height;
+    Int32 lineLength;
+} BufferGfx_Dimensions;
+
+/* bAttrs must stay first: the plugin passes &gfxAttrs.bAttrs as the attrs */
+typedef struct BufferGfx_Attrs {
+    Buffer_Attrs          bAttrs;
+    ColorSpace_Type       colorSpace;
+    BufferGfx_Dimensions  dim;
+} BufferGfx_Attrs;
+
+extern const BufferGfx_Attrs BufferGfx_Attrs_DEFAULT;
+
+#define BufferGfx_getBufferAttrs(gfxAttrs) (&(gfxAttrs)->bAttrs)
+
+extern Int32 BufferGfx_calcLineLength(Int32 width,
+                 ColorSpace_Type colorSpace);
+extern Int   BufferGfx_getDimensions(Buffer_Handle hBuf,
+                 BufferGfx_Dimensions *dim);
+extern Int   BufferGfx_setDimensions(Buffer_Handle hBuf,
+                 BufferGfx_Dimensions *dim);
+extern Int   BufferGfx_resetDimensions(Buffer_Handle hBuf);
+extern ColorSpace_Type BufferGfx_getColorSpace(Buffer_Handle hBuf);
+
+/* IVIDEO_FrameType of the picture in hBuf, as set by the codec */
+extern Int32 BufferGfx_getFrameType(Buffer_Handle hBuf);
+extern Void  BufferGfx_setFrameType(Buffer_Handle hBuf, Int32 frameType);
+
+#endif /* ti_sdo_dmai_BufferGfx_h_ */
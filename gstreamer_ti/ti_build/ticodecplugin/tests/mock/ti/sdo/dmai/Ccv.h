@@ -0,0 +1,42 @@
+/*
+ * Ccv.h
+ *
+ * Host stand-in for the DMAI Ccv (color conversion) module.  Converts
+ * YUV420PSEMI to YUV422PSEMI by repeating each chroma row; any other pair
+ * of colorspaces is copied as Framecopy would.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Ccv_h_
+#define ti_sdo_dmai_Ccv_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+typedef struct Ccv_Object *Ccv_Handle;
+
+typedef struct Ccv_Attrs {
+    Bool accel;
+} Ccv_Attrs;
+
+extern const Ccv_Attrs Ccv_Attrs_DEFAULT;
+
+extern Ccv_Handle Ccv_create(Ccv_Attrs *attrs);
+extern Int        Ccv_delete(Ccv_Handle hCcv);
+extern Int        Ccv_config(Ccv_Handle hCcv,
+                      Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf);
+extern Int        Ccv_execute(Ccv_Handle hCcv,
+                      Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf);
+
+#endif /* ti_sdo_dmai_Ccv_h_ */
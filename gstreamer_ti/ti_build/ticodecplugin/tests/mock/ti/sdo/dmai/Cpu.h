@@ -0,0 +1,49 @@
+/*
+ * Cpu.h
+ *
+ * Host stand-in for the DMAI Cpu module.  The host reports itself as a
+ * DM6446, the device the plugin's default code paths are written for.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Cpu_h_
+#define ti_sdo_dmai_Cpu_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+
+typedef struct Cpu_Object *Cpu_Handle;
+
+typedef struct Cpu_Attrs {
+    Int dummy;
+} Cpu_Attrs;
+
+extern const Cpu_Attrs Cpu_Attrs_DEFAULT;
+
+typedef enum {
+    Cpu_Device_DM6446 = 0,
+    Cpu_Device_DM6467,
+    Cpu_Device_OMAP3530,
+    Cpu_Device_DM355,
+    Cpu_Device_DM365,
+    Cpu_Device_OMAPL138,
+    Cpu_Device_DM3730,
+    Cpu_Device_DM368,
+    Cpu_Device_COUNT
+} Cpu_Device;
+
+extern Cpu_Handle Cpu_create(Cpu_Attrs *attrs);
+extern Int        Cpu_delete(Cpu_Handle hCpu);
+extern Int        Cpu_getDevice(Cpu_Handle hCpu, Cpu_Device *device);
+
+#endif /* ti_sdo_dmai_Cpu_h_ */
@@ -0,0 +1,82 @@
+/*
+ * Display.h
+ *
+ * Host stand-in for the DMAI Display module.  A display is a queue of
+ * buffers with nothing behind it: Display_get hands out each buffer once,
+ * then the oldest one queued with Display_put.  Setting
+ * DMAI_MOCK_DELAY_DISPLAY (microseconds) makes recycling a buffer that much
+ * slower, to stand in for waiting on the vertical sync.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Display_h_
+#define ti_sdo_dmai_Display_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufTab.h>
+#include <ti/sdo/dmai/ColorSpace.h>
+#include <ti/sdo/dmai/VideoStd.h>
+
+typedef struct Display_Object *Display_Handle;
+
+typedef enum {
+    Display_Std_V4L2 = 0,
+    Display_Std_FBDEV,
+    Display_Std_COUNT
+} Display_Std;
+
+typedef enum {
+    Display_Output_SVIDEO = 0,
+    Display_Output_COMPOSITE,
+    Display_Output_COMPONENT,
+    Display_Output_LCD,
+    Display_Output_DVI,
+    Display_Output_SYSTEM,
+    Display_Output_COUNT
+} Display_Output;
+
+typedef struct Display_Attrs {
+    Int              numBufs;
+    Display_Std      displayStd;
+    VideoStd_Type    videoStd;
+    Display_Output   videoOutput;
+    Char            *displayDevice;
+    Int              rotation;
+    ColorSpace_Type  colorSpace;
+    Int32            width;
+    Int32            height;
+    Bool             delayStreamon;
+    Int              forceFrameRateNum;
+    Int              forceFrameRateDen;
+} Display_Attrs;
+
+extern const Display_Attrs Display_Attrs_DM6446_DM355_VID_DEFAULT;
+extern const Display_Attrs Display_Attrs_DM6446_DM355_OSD_DEFAULT;
+extern const Display_Attrs Display_Attrs_DM6446_DM355_ATTR_DEFAULT;
+extern const Display_Attrs Display_Attrs_DM6467_VID_DEFAULT;
+extern const Display_Attrs Display_Attrs_DM365_VID_DEFAULT;
+extern const Display_Attrs Display_Attrs_DM365_OSD_DEFAULT;
+extern const Display_Attrs Display_Attrs_DM365_ATTR_DEFAULT;
+extern const Display_Attrs Display_Attrs_O3530_VID_DEFAULT;
+
+extern Display_Handle Display_create(BufTab_Handle hBufTab,
+                          Display_Attrs *attrs);
+extern Int            Display_delete(Display_Handle hDisplay);
+extern Int            Display_get(Display_Handle hDisplay,
+                          Buffer_Handle *hBufPtr);
+extern Int            Display_put(Display_Handle hDisplay,
+                          Buffer_Handle hBuf);
+
+#endif /* ti_sdo_dmai_Display_h_ */
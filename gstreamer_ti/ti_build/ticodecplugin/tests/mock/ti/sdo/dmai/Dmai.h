@@ -0,0 +1,36 @@
+/*
+ * Dmai.h
+ *
+ * Host stand-in for the DMAI base header, for unit tests that run the
+ * plugin's buffer handling without Codec Engine.  Only the types and status
+ * codes the tested sources use are defined.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Dmai_h_
+#define ti_sdo_dmai_Dmai_h_
+
+#include <xdc/std.h>
+
+#define Dmai_EOK        0
+#define Dmai_EFAIL     -1
+#define Dmai_ENOMEM    -2
+#define Dmai_EIO       -3
+#define Dmai_EINVAL    -5
+#define Dmai_EBITERROR  8
+
+#define Dmai_roundUp(value, align) \
+    (((value) + ((align) - 1)) & ~((align) - 1))
+
+#endif /* ti_sdo_dmai_Dmai_h_ */
@@ -0,0 +1,27 @@
+/*
+ * Fifo.h
+ *
+ * Host stand-in for the DMAI Fifo module.  The plugin headers name the
+ * handle type but the plugin never creates a Fifo.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Fifo_h_
+#define ti_sdo_dmai_Fifo_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+
+typedef struct Fifo_Object *Fifo_Handle;
+
+#endif /* ti_sdo_dmai_Fifo_h_ */
@@ -0,0 +1,43 @@
+/*
+ * Framecopy.h
+ *
+ * Host stand-in for the DMAI Framecopy module.  Every copy is a CPU copy of
+ * the part of the source frame that fits in the destination frame; the
+ * accel attribute is accepted and ignored.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Framecopy_h_
+#define ti_sdo_dmai_Framecopy_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+typedef struct Framecopy_Object *Framecopy_Handle;
+
+typedef struct Framecopy_Attrs {
+    Bool accel;
+    Bool sdma;
+} Framecopy_Attrs;
+
+extern const Framecopy_Attrs Framecopy_Attrs_DEFAULT;
+
+extern Framecopy_Handle Framecopy_create(Framecopy_Attrs *attrs);
+extern Int              Framecopy_delete(Framecopy_Handle hFc);
+extern Int              Framecopy_config(Framecopy_Handle hFc,
+                            Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf);
+extern Int              Framecopy_execute(Framecopy_Handle hFc,
+                            Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf);
+
+#endif /* ti_sdo_dmai_Framecopy_h_ */
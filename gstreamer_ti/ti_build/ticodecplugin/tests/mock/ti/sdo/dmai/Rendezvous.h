@@ -0,0 +1,41 @@
+/*
+ * Rendezvous.h
+ *
+ * Host stand-in for the DMAI Rendezvous module, built on pthreads.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Rendezvous_h_
+#define ti_sdo_dmai_Rendezvous_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+
+#define Rendezvous_INFINITE -1
+
+typedef struct Rendezvous_Object *Rendezvous_Handle;
+
+typedef struct Rendezvous_Attrs {
+    Int dummy;
+} Rendezvous_Attrs;
+
+extern const Rendezvous_Attrs Rendezvous_Attrs_DEFAULT;
+
+extern Rendezvous_Handle Rendezvous_create(Int count,
+                             Rendezvous_Attrs *attrs);
+extern Int               Rendezvous_delete(Rendezvous_Handle hRv);
+extern Void              Rendezvous_meet(Rendezvous_Handle hRv);
+extern Void              Rendezvous_force(Rendezvous_Handle hRv);
+extern Void              Rendezvous_reset(Rendezvous_Handle hRv);
+
+#endif /* ti_sdo_dmai_Rendezvous_h_ */
@@ -0,0 +1,44 @@
+/*
+ * Resize.h
+ *
+ * Host stand-in for the DMAI Resize module.  The host has no scaler: the
+ * frame is copied unscaled into the destination window, cropped to fit.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_Resize_h_
+#define ti_sdo_dmai_Resize_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+typedef struct Resize_Object *Resize_Handle;
+
+typedef struct Resize_Attrs {
+    Int32 hWindowType;
+    Int32 vWindowType;
+    Int32 hFilterType;
+    Int32 vFilterType;
+} Resize_Attrs;
+
+extern const Resize_Attrs Resize_Attrs_DEFAULT;
+
+extern Resize_Handle Resize_create(Resize_Attrs *attrs);
+extern Int           Resize_delete(Resize_Handle hResize);
+extern Int           Resize_config(Resize_Handle hResize,
+                         Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf);
+extern Int           Resize_execute(Resize_Handle hResize,
+                         Buffer_Handle hSrcBuf, Buffer_Handle hDstBuf);
+
+#endif /* ti_sdo_dmai_Resize_h_ */
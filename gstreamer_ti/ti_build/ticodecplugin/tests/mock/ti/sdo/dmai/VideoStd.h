@@ -0,0 +1,67 @@
+/*
+ * VideoStd.h
+ *
+ * Host stand-in for the DMAI VideoStd module.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_VideoStd_h_
+#define ti_sdo_dmai_VideoStd_h_
+
+#include <ti/sdo/dmai/Dmai.h>
+
+#define VideoStd_CIF_WIDTH       352
+#define VideoStd_CIF_HEIGHT      288
+#define VideoStd_SIF_WIDTH       352
+#define VideoStd_SIF_NTSC_HEIGHT 240
+#define VideoStd_SIF_PAL_HEIGHT  288
+#define VideoStd_VGA_WIDTH       640
+#define VideoStd_VGA_HEIGHT      480
+#define VideoStd_D1_WIDTH        720
+#define VideoStd_D1_NTSC_HEIGHT  480
+#define VideoStd_D1_PAL_HEIGHT   576
+#define VideoStd_480P_WIDTH      720
+#define VideoStd_480P_HEIGHT     480
+#define VideoStd_576P_WIDTH      720
+#define VideoStd_576P_HEIGHT     576
+#define VideoStd_720P_WIDTH      1280
+#define VideoStd_720P_HEIGHT     720
+#define VideoStd_1080I_WIDTH     1920
+#define VideoStd_1080I_HEIGHT    1080
+
+/* The standards the display sink can autoselect from, in DMAI's order */
+typedef enum {
+    VideoStd_AUTO = 0,
+    VideoStd_CIF,
+    VideoStd_SIF_NTSC,
+    VideoStd_SIF_PAL,
+    VideoStd_VGA,
+    VideoStd_D1_NTSC,
+    VideoStd_D1_PAL,
+    VideoStd_480P,
+    VideoStd_576P,
+    VideoStd_720P_60,
+    VideoStd_720P_50,
+    VideoStd_1080I_30,
+    VideoStd_1080I_25,
+    VideoStd_1080P_30,
+    VideoStd_1080P_25,
+    VideoStd_1080P_24,
+    VideoStd_COUNT
+} VideoStd_Type;
+
+extern Int VideoStd_getResolution(VideoStd_Type videoStd, Int32 *width,
+               Int32 *height);
+
+#endif /* ti_sdo_dmai_VideoStd_h_ */
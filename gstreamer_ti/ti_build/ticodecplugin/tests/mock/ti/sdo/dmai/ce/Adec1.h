@@ -0,0 +1,59 @@
+/*
+ * Adec1.h
+ *
+ * Host stand-in for the DMAI Adec1 module.  The "decoder" copies one
+ * fixed-size frame of input to the output per process call and reports no
+ * sample rate, so the element falls back on the one in its caps.
+ * DMAI_MOCK_DELAY_ADEC1 sets how many microseconds each Adec1_process call
+ * takes.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_ce_Adec1_h_
+#define ti_sdo_dmai_ce_Adec1_h_
+
+#include <ti/sdo/ce/Engine.h>
+#include <ti/xdais/dm/xdm.h>
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+typedef struct Adec1_Object *Adec1_Handle;
+
+typedef struct IAUDDEC1_Params {
+    XDAS_Int32 size;
+    XDAS_Int32 outputPCMWidth;
+    XDAS_Int32 pcmFormat;
+    XDAS_Int32 dataEndianness;
+} AUDDEC1_Params;
+
+typedef struct IAUDDEC1_DynamicParams {
+    XDAS_Int32 size;
+    XDAS_Int32 downSampleSbrFlag;
+} AUDDEC1_DynamicParams;
+
+extern const AUDDEC1_Params        Adec1_Params_DEFAULT;
+extern const AUDDEC1_DynamicParams Adec1_DynamicParams_DEFAULT;
+
+extern Adec1_Handle Adec1_create(Engine_Handle hEngine, Char *codecName,
+                        AUDDEC1_Params *params,
+                        AUDDEC1_DynamicParams *dynParams);
+extern Int          Adec1_delete(Adec1_Handle hAd);
+extern Int          Adec1_process(Adec1_Handle hAd, Buffer_Handle hInBuf,
+                        Buffer_Handle hOutBuf);
+extern Int32        Adec1_getInBufSize(Adec1_Handle hAd);
+extern Int32        Adec1_getOutBufSize(Adec1_Handle hAd);
+extern Int          Adec1_getSampleRate(Adec1_Handle hAd);
+
+#endif /* ti_sdo_dmai_ce_Adec1_h_ */
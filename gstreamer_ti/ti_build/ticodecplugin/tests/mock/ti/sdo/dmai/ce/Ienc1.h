@@ -0,0 +1,83 @@
+/*
+ * Ienc1.h
+ *
+ * Host stand-in for the DMAI Ienc1 module and the IMGENC1 control call the
+ * plugin makes on it.  The "encoder" copies the raw frame into the output
+ * buffer unchanged and remembers the qValue it was last run with.
+ * DMAI_MOCK_DELAY_IENC1 sets how many microseconds each Ienc1_process call
+ * takes.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_ce_Ienc1_h_
+#define ti_sdo_dmai_ce_Ienc1_h_
+
+#include <ti/sdo/ce/Engine.h>
+#include <ti/xdais/dm/xdm.h>
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+typedef struct Ienc1_Object *Ienc1_Handle;
+
+/* The VISA handle is the Ienc1 object itself */
+typedef struct Ienc1_Object *IMGENC1_Handle;
+
+#define IMGENC1_EOK         0
+#define IMGENC1_EFAIL      -1
+
+typedef struct IIMGENC1_Params {
+    XDAS_Int32 size;
+    XDAS_Int32 maxHeight;
+    XDAS_Int32 maxWidth;
+    XDAS_Int32 maxScans;
+    XDAS_Int32 dataEndianness;
+    XDAS_Int32 forceChromaFormat;
+} IMGENC1_Params;
+
+typedef struct IIMGENC1_DynamicParams {
+    XDAS_Int32 size;
+    XDAS_Int32 numAU;
+    XDAS_Int32 inputChromaFormat;
+    XDAS_Int32 inputHeight;
+    XDAS_Int32 inputWidth;
+    XDAS_Int32 captureWidth;
+    XDAS_Int32 generateHeader;
+    XDAS_Int32 qValue;
+} IMGENC1_DynamicParams;
+
+typedef struct IIMGENC1_Status {
+    XDAS_Int32 size;
+    XDAS_Int32 extendedError;
+} IMGENC1_Status;
+
+extern const IMGENC1_Params        Ienc1_Params_DEFAULT;
+extern const IMGENC1_DynamicParams Ienc1_DynamicParams_DEFAULT;
+
+extern Ienc1_Handle Ienc1_create(Engine_Handle hEngine, Char *codecName,
+                        IMGENC1_Params *params,
+                        IMGENC1_DynamicParams *dynParams);
+extern Int          Ienc1_delete(Ienc1_Handle hIe);
+extern Int          Ienc1_process(Ienc1_Handle hIe, Buffer_Handle hInBuf,
+                        Buffer_Handle hOutBuf);
+extern Int32        Ienc1_getInBufSize(Ienc1_Handle hIe);
+extern Int32        Ienc1_getOutBufSize(Ienc1_Handle hIe);
+extern IMGENC1_Handle Ienc1_getVisaHandle(Ienc1_Handle hIe);
+
+/* Only XDM_SETPARAMS and XDM_GETSTATUS are supported */
+extern XDAS_Int32   IMGENC1_control(IMGENC1_Handle handle, XDAS_Int32 id,
+                        IMGENC1_DynamicParams *dynParams,
+                        IMGENC1_Status *status);
+
+#endif /* ti_sdo_dmai_ce_Ienc1_h_ */
@@ -0,0 +1,102 @@
+/*
+ * Vdec2.h
+ *
+ * Host stand-in for the DMAI Vdec2 module and the VIDDEC2 control call the
+ * plugin makes on it.  The "decoder" copies its input into the output
+ * buffer: each process call consumes at most one output frame's worth of
+ * input and produces one frame.  Environment variables shape it for stress
+ * tests:
+ *
+ *   DMAI_MOCK_DELAY_VDEC2   microseconds each Vdec2_process call takes
+ *   DMAI_MOCK_HOLD_VDEC2    frames held back before display, as a decoder
+ *                           holding B-frame references would (default 0)
+ *   DMAI_MOCK_GOP_VDEC2     frame types of the stream in decode order, one
+ *                           letter (I, P or B) per frame, repeated; all
+ *                           frames are I frames if unset
+ *   DMAI_MOCK_NOSKIP_VDEC2  if non-zero, XDM_SETPARAMS fails the way it does
+ *                           on codecs that can't skip frames
+ *
+ * With frameSkipMode set to IVIDEO_SKIP_B, B frames consume their input but
+ * are returned through Vdec2_getFreeBuf without ever being displayed.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_ce_Vdec2_h_
+#define ti_sdo_dmai_ce_Vdec2_h_
+
+#include <ti/sdo/ce/Engine.h>
+#include <ti/xdais/dm/ivideo.h>
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+#include <ti/sdo/dmai/BufTab.h>
+
+typedef struct Vdec2_Object *Vdec2_Handle;
+
+/* The VISA handle is the Vdec2 object itself */
+typedef struct Vdec2_Object *VIDDEC2_Handle;
+
+#define VIDDEC2_EOK         0
+#define VIDDEC2_EFAIL      -1
+
+typedef struct IVIDDEC2_Params {
+    XDAS_Int32 size;
+    XDAS_Int32 maxHeight;
+    XDAS_Int32 maxWidth;
+    XDAS_Int32 maxFrameRate;
+    XDAS_Int32 maxBitRate;
+    XDAS_Int32 dataEndianness;
+    XDAS_Int32 forceChromaFormat;
+} VIDDEC2_Params;
+
+typedef struct IVIDDEC2_DynamicParams {
+    XDAS_Int32 size;
+    XDAS_Int32 decodeHeader;
+    XDAS_Int32 displayWidth;
+    XDAS_Int32 frameSkipMode;
+    XDAS_Int32 frameOrder;
+    XDAS_Int32 newFrameFlag;
+    XDAS_Int32 mbDataFlag;
+} VIDDEC2_DynamicParams;
+
+typedef struct IVIDDEC2_Status {
+    XDAS_Int32 size;
+    XDAS_Int32 extendedError;
+} VIDDEC2_Status;
+
+extern const VIDDEC2_Params        Vdec2_Params_DEFAULT;
+extern const VIDDEC2_DynamicParams Vdec2_DynamicParams_DEFAULT;
+
+extern Vdec2_Handle  Vdec2_create(Engine_Handle hEngine, Char *codecName,
+                         VIDDEC2_Params *params,
+                         VIDDEC2_DynamicParams *dynParams);
+extern Int           Vdec2_delete(Vdec2_Handle hVd);
+extern Int           Vdec2_process(Vdec2_Handle hVd, Buffer_Handle hInBuf,
+                         Buffer_Handle hDstBuf);
+extern Int           Vdec2_flush(Vdec2_Handle hVd);
+extern Void          Vdec2_setBufTab(Vdec2_Handle hVd, BufTab_Handle hBufTab);
+extern BufTab_Handle Vdec2_getBufTab(Vdec2_Handle hVd);
+extern Buffer_Handle Vdec2_getDisplayBuf(Vdec2_Handle hVd);
+extern Buffer_Handle Vdec2_getFreeBuf(Vdec2_Handle hVd);
+extern Int32         Vdec2_getInBufSize(Vdec2_Handle hVd);
+extern Int32         Vdec2_getOutBufSize(Vdec2_Handle hVd);
+extern Int32         Vdec2_getMinOutBufs(Vdec2_Handle hVd);
+extern VIDDEC2_Handle Vdec2_getVisaHandle(Vdec2_Handle hVd);
+
+/* Only XDM_SETPARAMS and XDM_GETSTATUS are supported */
+extern XDAS_Int32    VIDDEC2_control(VIDDEC2_Handle handle, XDAS_Int32 id,
+                         VIDDEC2_DynamicParams *dynParams,
+                         VIDDEC2_Status *status);
+
+#endif /* ti_sdo_dmai_ce_Vdec2_h_ */
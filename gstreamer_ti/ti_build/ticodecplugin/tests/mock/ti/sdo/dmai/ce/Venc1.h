@@ -0,0 +1,74 @@
+/*
+ * Venc1.h
+ *
+ * Host stand-in for the DMAI Venc1 module.  The "encoder" copies the raw
+ * frame into the output buffer unchanged.  DMAI_MOCK_DELAY_VENC1 sets how
+ * many microseconds each Venc1_process call takes.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_sdo_dmai_ce_Venc1_h_
+#define ti_sdo_dmai_ce_Venc1_h_
+
+#include <ti/sdo/ce/Engine.h>
+#include <ti/xdais/dm/ivideo.h>
+
+#include <ti/sdo/dmai/Dmai.h>
+#include <ti/sdo/dmai/Buffer.h>
+
+typedef struct Venc1_Object *Venc1_Handle;
+
+typedef struct IVIDENC1_Params {
+    XDAS_Int32 size;
+    XDAS_Int32 encodingPreset;
+    XDAS_Int32 rateControlPreset;
+    XDAS_Int32 maxHeight;
+    XDAS_Int32 maxWidth;
+    XDAS_Int32 maxFrameRate;
+    XDAS_Int32 maxBitRate;
+    XDAS_Int32 dataEndianness;
+    XDAS_Int32 maxInterFrameInterval;
+    XDAS_Int32 inputChromaFormat;
+    XDAS_Int32 inputContentType;
+    XDAS_Int32 reconChromaFormat;
+} VIDENC1_Params;
+
+typedef struct IVIDENC1_DynamicParams {
+    XDAS_Int32 size;
+    XDAS_Int32 inputHeight;
+    XDAS_Int32 inputWidth;
+    XDAS_Int32 refFrameRate;
+    XDAS_Int32 targetFrameRate;
+    XDAS_Int32 targetBitRate;
+    XDAS_Int32 intraFrameInterval;
+    XDAS_Int32 generateHeader;
+    XDAS_Int32 captureWidth;
+    XDAS_Int32 forceFrame;
+    XDAS_Int32 interFrameInterval;
+    XDAS_Int32 mbDataFlag;
+} VIDENC1_DynamicParams;
+
+extern const VIDENC1_Params        Venc1_Params_DEFAULT;
+extern const VIDENC1_DynamicParams Venc1_DynamicParams_DEFAULT;
+
+extern Venc1_Handle Venc1_create(Engine_Handle hEngine, Char *codecName,
+                        VIDENC1_Params *params,
+                        VIDENC1_DynamicParams *dynParams);
+extern Int          Venc1_delete(Venc1_Handle hVe);
+extern Int          Venc1_process(Venc1_Handle hVe, Buffer_Handle hInBuf,
+                        Buffer_Handle hOutBuf);
+extern Int32        Venc1_getInBufSize(Venc1_Handle hVe);
+extern Int32        Venc1_getOutBufSize(Venc1_Handle hVe);
+
+#endif /* ti_sdo_dmai_ce_Venc1_h_ */
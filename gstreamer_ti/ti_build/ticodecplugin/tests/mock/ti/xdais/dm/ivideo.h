@@ -0,0 +1,57 @@
+/*
+ * ivideo.h
+ *
+ * Host stand-in for the XDM video definitions the plugin uses.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_xdais_dm_ivideo_h_
+#define ti_xdais_dm_ivideo_h_
+
+#include <ti/xdais/dm/xdm.h>
+
+/* IVIDEO_RateControlPreset */
+#define IVIDEO_LOW_DELAY     1
+#define IVIDEO_STORAGE       2
+#define IVIDEO_TWOPASS       3
+#define IVIDEO_NONE          4
+#define IVIDEO_USER_DEFINED  5
+
+/* IVIDEO_ContentType */
+#define IVIDEO_PROGRESSIVE   0
+#define IVIDEO_INTERLACED    1
+
+/* IVIDEO_FrameType */
+#define IVIDEO_NA_FRAME     -1
+#define IVIDEO_I_FRAME       0
+#define IVIDEO_P_FRAME       1
+#define IVIDEO_B_FRAME       2
+#define IVIDEO_IDR_FRAME     3
+#define IVIDEO_II_FRAME      4
+#define IVIDEO_IP_FRAME      5
+#define IVIDEO_IB_FRAME      6
+#define IVIDEO_PI_FRAME      7
+#define IVIDEO_PP_FRAME      8
+#define IVIDEO_PB_FRAME      9
+#define IVIDEO_BI_FRAME     10
+#define IVIDEO_BP_FRAME     11
+#define IVIDEO_BB_FRAME     12
+
+/* IVIDEO_FrameSkip */
+#define IVIDEO_NO_SKIP       0
+#define IVIDEO_SKIP_P        1
+#define IVIDEO_SKIP_B        2
+#define IVIDEO_SKIP_I        3
+
+#endif /* ti_xdais_dm_ivideo_h_ */
@@ -0,0 +1,62 @@
+/*
+ * xdm.h
+ *
+ * Host stand-in for the XDM base definitions: the types, the constants
+ * the plugin puts in codec creation parameters and the control commands.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef ti_xdais_dm_xdm_h_
+#define ti_xdais_dm_xdm_h_
+
+#include <xdc/std.h>
+
+typedef Int32  XDAS_Int32;
+typedef UInt32 XDAS_UInt32;
+typedef Int16  XDAS_Int16;
+typedef Int8   XDAS_Int8;
+
+/* XDM_DataFormat */
+#define XDM_BYTE            1
+#define XDM_LE_16           2
+#define XDM_LE_32           3
+
+/* XDM_ChromaFormat */
+#define XDM_CHROMA_NA      -1
+#define XDM_YUV_420P        1
+#define XDM_YUV_422P        2
+#define XDM_YUV_422IBE      3
+#define XDM_YUV_422ILE      4
+#define XDM_YUV_444P        5
+#define XDM_YUV_411P        6
+#define XDM_GRAY            7
+#define XDM_RGB             8
+#define XDM_YUV_420SP       9
+
+/* XDM_CmdId */
+#define XDM_GETSTATUS       0
+#define XDM_SETPARAMS       1
+#define XDM_RESET           2
+#define XDM_SETDEFAULT      3
+#define XDM_FLUSH           4
+#define XDM_GETBUFINFO      5
+#define XDM_GETVERSION      6
+
+/* XDM_EncodingPreset */
+#define XDM_DEFAULT         0
+#define XDM_HIGH_QUALITY    1
+#define XDM_HIGH_SPEED      2
+#define XDM_USER_DEFINED    3
+
+#endif /* ti_xdais_dm_xdm_h_ */
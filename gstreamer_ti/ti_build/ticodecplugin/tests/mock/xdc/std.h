@@ -0,0 +1,41 @@
+/*
+ * std.h
+ *
+ * Host stand-in for the XDC base types used by DMAI and the plugin sources
+ * built into the unit tests.
+ *
+ * Copyright (C) 2011 Texas Instruments Incorporated - http://www.ti.com/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation version 2.1 of the License.
+ *
+ * This program is distributed #as is# WITHOUT ANY WARRANTY of any kind,
+ * whether express or implied; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ */
+
+#ifndef xdc_std_h_
+#define xdc_std_h_
+
+typedef char               Char;
+typedef signed char        Int8;
+typedef short              Int16;
+typedef long               Int32;
+typedef unsigned char      UInt8;
+typedef unsigned short     UInt16;
+typedef unsigned long      UInt32;
+typedef int                Int;
+typedef unsigned int       UInt;
+typedef unsigned short     Bool;
+typedef void               Void;
+typedef void              *Ptr;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#endif /* xdc_std_h_ */